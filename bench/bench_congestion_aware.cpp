@@ -0,0 +1,157 @@
+/******************************************************************************
+This source code is licensed under the MIT license found in the
+LICENSE file in the root directory of this source tree.
+*******************************************************************************/
+
+#include "common/EventQueue.h"
+#include "common/NetworkParser.h"
+#include "common/Type.h"
+#include "congestion_aware/FatTree.h"
+#include "congestion_aware/FullyConnected.h"
+#include "congestion_aware/Helper.h"
+#include "congestion_aware/Ring.h"
+#include "congestion_aware/SimulationContext.h"
+#include "congestion_aware/Switch.h"
+#include <benchmark/benchmark.h>
+#include <memory>
+#include <string>
+
+using namespace NetworkAnalytical;
+using namespace NetworkAnalyticalCongestionAware;
+
+namespace {
+
+/// input directory, relative to bench/build
+const auto input_path = std::string("../../input/");
+
+/// chunk size of the simulation benchmarks
+constexpr ChunkSize chunk_size = 1'048'576;  // 1 MB
+
+/// event handler doing nothing
+void empty_event_handler(void* const /*arg*/) noexcept {}
+
+/**
+ * Count the pairs of NPUs routed by a route() benchmark.
+ */
+void route_all_pairs(benchmark::State& state, const Topology& topology) {
+    const auto npus_count = topology.get_npus_count();
+    for (auto _ : state) {
+        for (auto src = 0; src < npus_count; src++) {
+            for (auto dest = 0; dest < npus_count; dest++) {
+                if (src != dest) {
+                    benchmark::DoNotOptimize(topology.route(src, dest));
+                }
+            }
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * npus_count * (npus_count - 1));
+}
+
+}  // namespace
+
+/// schedule_event() and proceed() with a given number of pending event times
+void BM_EventQueueScheduleProceed(benchmark::State& state) {
+    const auto depth = static_cast<EventTime>(state.range(0));
+    auto event_queue = EventQueue();
+    for (auto time = static_cast<EventTime>(1); time <= depth; time++) {
+        event_queue.schedule_event(time, empty_event_handler, nullptr);
+    }
+
+    // keep the depth: each processed time is replaced by a later one
+    for (auto _ : state) {
+        event_queue.schedule_event(event_queue.get_current_time() + depth + 1, empty_event_handler, nullptr);
+        event_queue.proceed();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_EventQueueScheduleProceed)->RangeMultiplier(16)->Range(1, 1 << 16);
+
+/// route() of every NPU pair on each basic topology
+void BM_RouteRing(benchmark::State& state) {
+    route_all_pairs(state, Ring(static_cast<int>(state.range(0)), 50, 500));
+}
+BENCHMARK(BM_RouteRing)->Arg(16)->Arg(128);
+
+void BM_RouteFullyConnected(benchmark::State& state) {
+    route_all_pairs(state, FullyConnected(static_cast<int>(state.range(0)), 50, 500));
+}
+BENCHMARK(BM_RouteFullyConnected)->Arg(16)->Arg(128);
+
+void BM_RouteSwitch(benchmark::State& state) {
+    route_all_pairs(state, Switch(static_cast<int>(state.range(0)), 50, 500));
+}
+BENCHMARK(BM_RouteSwitch)->Arg(16)->Arg(128);
+
+void BM_RouteFatTree(benchmark::State& state) {
+    route_all_pairs(state, FatTree(static_cast<int>(state.range(0)), 8, 50, 500));
+}
+BENCHMARK(BM_RouteFatTree)->Arg(128);
+
+/// route() of every NPU pair on a multi-dimensional topology
+void BM_RouteMultiDimTopology(benchmark::State& state) {
+    const auto topology = construct_topology(NetworkParser(input_path + "Ring_FullyConnected_Switch.yml"));
+    route_all_pairs(state, *topology);
+}
+BENCHMARK(BM_RouteMultiDimTopology);
+
+/// chunks sent over a single link, then drained
+void BM_LinkSendDrain(benchmark::State& state) {
+    const auto chunks_count = state.range(0);
+    const auto context = std::make_shared<SimulationContext>(std::make_shared<EventQueue>());
+    auto topology = Ring(2, 50, 500, false);
+    topology.set_simulation_context(context);
+
+    for (auto _ : state) {
+        for (auto i = 0; i < chunks_count; i++) {
+            topology.send(0, 1, chunk_size, empty_event_handler, nullptr);
+        }
+        context->get_event_queue()->run();
+    }
+    state.SetItemsProcessed(state.iterations() * chunks_count);
+}
+BENCHMARK(BM_LinkSendDrain)->Arg(1)->Arg(64)->Arg(4096);
+
+/// topology construction from each input config whose inputs live in the repository
+/// (ExpanderGraph configs refer to graph files outside of it)
+void BM_ConstructTopology(benchmark::State& state, const std::string& config) {
+    const auto network_parser = NetworkParser(input_path + config);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(construct_topology(network_parser));
+    }
+}
+BENCHMARK_CAPTURE(BM_ConstructTopology, Ring, std::string("Ring.yml"));
+BENCHMARK_CAPTURE(BM_ConstructTopology, FullyConnected, std::string("FullyConnected.yml"));
+BENCHMARK_CAPTURE(BM_ConstructTopology, Switch, std::string("Switch.yml"));
+BENCHMARK_CAPTURE(BM_ConstructTopology, Ring_FullyConnected_Switch, std::string("Ring_FullyConnected_Switch.yml"));
+BENCHMARK_CAPTURE(BM_ConstructTopology, 3D_with_MoE, std::string("3D_with_MoE.yml"));
+BENCHMARK_CAPTURE(BM_ConstructTopology, FatTree, std::string("FatTree.yml"));
+BENCHMARK_CAPTURE(BM_ConstructTopology, FatTree_ECMP, std::string("FatTree-ECMP.yml"));
+BENCHMARK_CAPTURE(BM_ConstructTopology, FatTree_Adaptive, std::string("FatTree-Adaptive.yml"));
+BENCHMARK_CAPTURE(BM_ConstructTopology, FatTree_Random, std::string("FatTree-Random.yml"));
+BENCHMARK_CAPTURE(BM_ConstructTopology, FatTree_Spray, std::string("FatTree-Spray.yml"));
+
+/// the example's All-Gather (every NPU sends a chunk to every other NPU), end to end
+void BM_ExampleAllGather(benchmark::State& state) {
+    const auto network_parser = NetworkParser(input_path + "Ring.yml");
+    const auto context = std::make_shared<SimulationContext>(std::make_shared<EventQueue>());
+    const auto topology = construct_topology(network_parser, context);
+    auto* const event_queue = context->get_event_queue();
+    const auto npus_count = topology->get_npus_count();
+
+    auto events_count = static_cast<size_t>(0);
+    for (auto _ : state) {
+        for (auto src = 0; src < npus_count; src++) {
+            for (auto dest = 0; dest < npus_count; dest++) {
+                if (src != dest) {
+                    topology->send(src, dest, chunk_size, empty_event_handler, nullptr);
+                }
+            }
+        }
+        while (!event_queue->finished()) {
+            events_count += event_queue->run_for(1 << 16);
+        }
+    }
+    state.counters["events_per_second"] = benchmark::Counter(static_cast<double>(events_count),
+                                                              benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_ExampleAllGather);
@@ -0,0 +1,328 @@
+/******************************************************************************
+This source code is licensed under the MIT license found in the
+LICENSE file in the root directory of this source tree.
+*******************************************************************************/
+
+#include "common/EventQueue.h"
+#include "common/NetworkParser.h"
+#include "common/Type.h"
+#include "congestion_aware/Collective.h"
+#include "congestion_aware/Helper.h"
+#include "congestion_aware/SimulationContext.h"
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#ifdef __APPLE__
+#include <malloc/malloc.h>
+#else
+#include <malloc.h>
+#endif
+#include <new>
+#include <string>
+#include <sys/resource.h>
+#include <unistd.h>
+#include <vector>
+#include <yaml-cpp/yaml.h>
+
+using namespace NetworkAnalytical;
+using namespace NetworkAnalyticalCongestionAware;
+
+namespace {
+
+/// bytes allocated by operator new since the start of the process
+std::atomic<size_t> allocated_bytes(0);
+
+/// heap bytes held by live operator new allocations
+std::atomic<size_t> live_bytes(0);
+
+/// peak of live_bytes since the last measure() started
+std::atomic<size_t> peak_live_bytes(0);
+
+/// per-NPU buffer of the AllReduce run on every network
+constexpr ChunkSize collective_size = 1'048'576;  // 1 MB
+
+/// NPU counts are multiplied by this factor from one network to the next
+constexpr int npus_count_growth = 4;
+
+/// metrics of a phase (construction or simulation)
+struct PhaseMetrics {
+    /// wall time in s
+    double wall_time;
+
+    /// events processed
+    size_t events_count;
+
+    /// bytes allocated
+    size_t allocated_bytes;
+
+    /// peak heap bytes held by live allocations
+    size_t peak_heap_bytes;
+
+    /// peak resident set size in bytes
+    size_t peak_rss;
+
+};
+
+/**
+ * Restart the peak RSS measurement from the current RSS, where supported (Linux).
+ */
+void reset_peak_rss() noexcept {
+#ifdef __linux__
+    auto clear_refs = std::ofstream("/proc/self/clear_refs");
+    clear_refs << "5";
+#endif
+}
+
+/**
+ * Get the peak RSS since the last reset_peak_rss() (since the start of the process where unsupported).
+ */
+size_t get_peak_rss() noexcept {
+#ifdef __linux__
+    auto status = std::ifstream("/proc/self/status");
+    for (auto line = std::string(); std::getline(status, line);) {
+        if (line.rfind("VmHWM:", 0) == 0) {
+            return std::stoull(line.substr(6)) * 1024;
+        }
+    }
+#endif
+    auto usage = rusage();
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return static_cast<size_t>(usage.ru_maxrss);
+#else
+    return static_cast<size_t>(usage.ru_maxrss) * 1024;
+#endif
+}
+
+/**
+ * Get the heap size of an allocation.
+ */
+size_t get_allocation_size(void* const ptr) noexcept {
+#ifdef __APPLE__
+    return malloc_size(ptr);
+#else
+    return malloc_usable_size(ptr);
+#endif
+}
+
+/**
+ * Measure a phase.
+ */
+template <typename Phase>
+PhaseMetrics measure(Phase&& phase) {
+    reset_peak_rss();
+    peak_live_bytes = live_bytes.load();
+    const auto start_bytes = allocated_bytes.load();
+    const auto start_time = std::chrono::steady_clock::now();
+    const auto events_count = phase();
+    const auto end_time = std::chrono::steady_clock::now();
+    return PhaseMetrics{std::chrono::duration<double>(end_time - start_time).count(), events_count,
+                        allocated_bytes.load() - start_bytes, peak_live_bytes.load(), get_peak_rss()};
+}
+
+/**
+ * Write a circulant expander graph (offsets 1, b, b², b³ in both directions) as an ExpanderGraph input file.
+ */
+void write_expander_graph(const std::string& path, const int npus_count) {
+    const auto base = static_cast<int>(std::ceil(std::pow(npus_count, 0.25)));
+    auto offsets = std::vector<int>();
+    for (auto offset = 1; offsets.size() < 4; offset *= base) {
+        offsets.push_back(offset % npus_count);
+    }
+
+    auto file = std::ofstream(path);
+    file << R"({"node_count": )" << npus_count << R"(, "degree": )" << (2 * offsets.size())
+         << R"(, "connected_graph_adjacency": [)";
+    for (auto npu = 0; npu < npus_count; npu++) {
+        file << (npu > 0 ? ", [" : "[");
+        for (auto i = static_cast<size_t>(0); i < offsets.size(); i++) {
+            file << (i > 0 ? ", " : "") << (npu + offsets[i]) % npus_count << ", "
+                 << (npu + npus_count - offsets[i]) % npus_count;
+        }
+        file << "]";
+    }
+    file << "]}";
+}
+
+/**
+ * Generate the network config of a topology with the given number of NPUs.
+ */
+YAML::Node generate_network_config(const std::string& topology_name, const int npus_count,
+                                   const std::string& work_directory) {
+    auto config = YAML::Node();
+    if (topology_name == "MultiDim") {
+        config["topology"] = std::vector<std::string>{"Ring", "FullyConnected", "Switch"};
+        config["npus_count"] = std::vector<int>{4, 4, npus_count / 16};
+        config["bandwidth"] = std::vector<double>{200.0, 100.0, 50.0};
+        config["latency"] = std::vector<double>{50.0, 500.0, 2000.0};
+        return config;
+    }
+
+    config["topology"] = std::vector<std::string>{topology_name};
+    config["npus_count"] = std::vector<int>{npus_count};
+    config["bandwidth"] = std::vector<double>{50.0};
+    config["latency"] = std::vector<double>{500.0};
+    if (topology_name == "FatTree") {
+        // smallest even radix hosting every NPU (k^3 / 4 hosts)
+        auto radix = 2;
+        while (radix * radix * radix / 4 < npus_count) {
+            radix += 2;
+        }
+        config["fattree_radix"] = std::vector<int>{radix};
+    }
+    if (topology_name == "Torus") {
+        // 3D torus as close to a cube as the factors of 2 of npus_count allow
+        auto shape = std::vector<int>{1, 1, 1};
+        auto remaining = npus_count;
+        for (auto dim = 0; remaining % 2 == 0; dim = (dim + 1) % 3) {
+            shape[dim] *= 2;
+            remaining /= 2;
+        }
+        shape[0] *= remaining;
+        config["torus_shape"].push_back(shape);
+    }
+    if (topology_name == "Dragonfly") {
+        // smallest balanced dragonfly (2p routers per group, p NPUs and p global links per router) hosting every NPU
+        auto hosts_per_router = 1;
+        while (npus_count % (2 * hosts_per_router * hosts_per_router) != 0 ||
+               npus_count / (2 * hosts_per_router * hosts_per_router) > (2 * hosts_per_router * hosts_per_router) + 1) {
+            hosts_per_router++;
+        }
+        config["dragonfly_routers_per_group"] = std::vector<int>{2 * hosts_per_router};
+        config["dragonfly_hosts_per_router"] = std::vector<int>{hosts_per_router};
+        config["dragonfly_global_links_per_router"] = std::vector<int>{hosts_per_router};
+    }
+    if (topology_name == "ExpanderGraph") {
+        const auto inputfile = work_directory + "/scaling_expander_" + std::to_string(npus_count) + ".json";
+        write_expander_graph(inputfile, npus_count);
+        config["inputfile"] = std::vector<std::string>{inputfile};
+    }
+    return config;
+}
+
+/**
+ * Write a row of the report.
+ */
+void write_row(std::ostream& report, const std::string& topology_name, const int npus_count,
+               const std::string& phase, const PhaseMetrics& metrics, const EventTime simulated_time) {
+    const auto events_per_second =
+        (metrics.wall_time > 0) ? static_cast<double>(metrics.events_count) / metrics.wall_time : 0.0;
+    report << topology_name << "," << npus_count << "," << phase << "," << metrics.wall_time << ","
+           << metrics.events_count << "," << events_per_second << "," << metrics.allocated_bytes << ","
+           << metrics.peak_heap_bytes << "," << metrics.peak_rss << "," << simulated_time << std::endl;
+}
+
+}  // namespace
+
+void* operator new(const size_t size) {
+    auto* const ptr = std::malloc(size == 0 ? 1 : size);
+    if (ptr == nullptr) {
+        throw std::bad_alloc();
+    }
+
+    allocated_bytes += size;
+    const auto live = (live_bytes += get_allocation_size(ptr));
+    for (auto peak = peak_live_bytes.load(); live > peak && !peak_live_bytes.compare_exchange_weak(peak, live);) {
+    }
+    return ptr;
+}
+
+void operator delete(void* const ptr) noexcept {
+    if (ptr != nullptr) {
+        live_bytes -= get_allocation_size(ptr);
+        std::free(ptr);
+    }
+}
+
+void operator delete(void* const ptr, size_t /*size*/) noexcept {
+    operator delete(ptr);
+}
+
+int main(int argc, char* argv[]) {
+    // arguments
+    auto report_path = std::string();
+    auto min_npus_count = 64;
+    auto max_npus_count = 65536;
+    auto budget = 600.0;
+    auto work_directory = std::string(std::getenv("TMPDIR") != nullptr ? std::getenv("TMPDIR") : "/tmp");
+    for (auto i = 1; i < argc; i++) {
+        const auto argument = std::string(argv[i]);
+        if (argument == "--min-npus" && i + 1 < argc) {
+            min_npus_count = std::stoi(argv[++i]);
+        } else if (argument == "--max-npus" && i + 1 < argc) {
+            max_npus_count = std::stoi(argv[++i]);
+        } else if (argument == "--budget" && i + 1 < argc) {
+            budget = std::stod(argv[++i]);
+        } else if (argument == "--workdir" && i + 1 < argc) {
+            work_directory = argv[++i];
+        } else if (report_path.empty() && argument.front() != '-') {
+            report_path = argument;
+        } else {
+            std::cerr << "Usage: " << argv[0]
+                      << " [report.csv] [--min-npus N] [--max-npus N] [--budget seconds] [--workdir path]" << std::endl;
+            return -1;
+        }
+    }
+
+    auto report_file = std::ofstream();
+    if (!report_path.empty()) {
+        report_file.open(report_path);
+    }
+    auto& report = report_path.empty() ? std::cout : report_file;
+    report << "topology,npus_count,phase,wall_time_s,events,events_per_second,bytes_allocated,peak_heap_bytes,peak_rss_bytes,"
+              "simulated_time_ns"
+           << std::endl;
+
+    const auto physical_memory = static_cast<double>(sysconf(_SC_PHYS_PAGES)) * sysconf(_SC_PAGESIZE);
+    const auto topology_names =
+        std::vector<std::string>{"Ring", "Switch", "FullyConnected", "FatTree", "Torus", "Dragonfly", "ExpanderGraph",
+                                 "MultiDim"};
+    for (const auto& topology_name : topology_names) {
+        for (auto npus_count = min_npus_count; npus_count <= max_npus_count; npus_count *= npus_count_growth) {
+            const auto network_config = generate_network_config(topology_name, npus_count, work_directory);
+            const auto baseline_heap_bytes = live_bytes.load();
+            const auto context = std::make_shared<SimulationContext>(std::make_shared<EventQueue>());
+
+            // construction
+            auto topology = std::shared_ptr<Topology>();
+            const auto construction = measure([&]() {
+                topology = construct_topology(NetworkParser(network_config, work_directory + "/scaling.yml"), context);
+                return static_cast<size_t>(0);
+            });
+            write_row(report, topology_name, npus_count, "construction", construction, 0);
+
+            // simulation of a halving-doubling AllReduce
+            auto* const event_queue = context->get_event_queue();
+            const auto simulation = measure([&]() {
+                auto all_reduce = Collective(topology, Collective::Type::AllReduce,
+                                             Collective::Algorithm::HalvingDoubling, collective_size, collective_size);
+                all_reduce.start([]() {});
+                auto events_count = static_cast<size_t>(0);
+                while (!event_queue->finished()) {
+                    events_count += event_queue->run_for(1 << 20);
+                }
+                return events_count;
+            });
+            write_row(report, topology_name, npus_count, "simulation", simulation, event_queue->get_current_time());
+            topology.reset();
+
+            // the next network costs at least growth times as much, and up to growth^2 times for quadratic costs
+            const auto growth = static_cast<double>(npus_count_growth * npus_count_growth);
+            const auto wall_time = construction.wall_time + simulation.wall_time;
+            const auto heap_bytes =
+                static_cast<double>(std::max(construction.peak_heap_bytes, simulation.peak_heap_bytes)) -
+                static_cast<double>(baseline_heap_bytes);
+            if (npus_count * npus_count_growth <= max_npus_count &&
+                (wall_time * growth > budget || heap_bytes * growth > physical_memory)) {
+                std::cerr << "[Scaling] " << topology_name << " stops at " << npus_count << " NPUs: " << wall_time
+                          << " s, " << heap_bytes / (1 << 20) << " MiB of heap" << std::endl;
+                break;
+            }
+        }
+    }
+    return 0;
+}
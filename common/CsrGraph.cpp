@@ -0,0 +1,86 @@
+/******************************************************************************
+This source code is licensed under the MIT license found in the
+LICENSE file in the root directory of this source tree.
+*******************************************************************************/
+
+#include "common/CsrGraph.h"
+#include <algorithm>
+#include <cassert>
+
+using namespace NetworkAnalytical;
+
+CsrGraph::CsrGraph() noexcept : offsets(1, 0) {}
+
+CsrGraph::CsrGraph(const std::map<DeviceId, std::vector<DeviceId>>& adjacency_list) noexcept {
+    const auto nodes_count = static_cast<int>(adjacency_list.size());
+
+    // count the neighbors of each node, then accumulate
+    offsets.assign(nodes_count + 1, 0);
+    for (const auto& [node, neighbors] : adjacency_list) {
+        assert(0 <= node && node < nodes_count);
+        offsets[node + 1] = static_cast<int>(neighbors.size());
+    }
+    for (auto node = 0; node < nodes_count; node++) {
+        offsets[node + 1] += offsets[node];
+    }
+
+    // copy the neighbors in place
+    edge_targets.resize(offsets[nodes_count]);
+    for (const auto& [node, neighbors] : adjacency_list) {
+        assert(std::all_of(neighbors.begin(), neighbors.end(),
+                           [nodes_count](const DeviceId neighbor) { return 0 <= neighbor && neighbor < nodes_count; }));
+        std::copy(neighbors.begin(), neighbors.end(), edge_targets.begin() + offsets[node]);
+    }
+}
+
+CsrGraph::CsrGraph(const int nodes_count, const std::vector<std::pair<DeviceId, DeviceId>>& edges) noexcept {
+    assert(nodes_count >= 0);
+
+    // count the neighbors of each node, then accumulate
+    offsets.assign(nodes_count + 1, 0);
+    for (const auto& [src, dest] : edges) {
+        assert(0 <= src && src < nodes_count);
+        assert(0 <= dest && dest < nodes_count);
+        offsets[src + 1]++;
+        offsets[dest + 1]++;
+    }
+    for (auto node = 0; node < nodes_count; node++) {
+        offsets[node + 1] += offsets[node];
+    }
+
+    // place the neighbors in edge order
+    edge_targets.resize(offsets[nodes_count]);
+    auto next_edge = std::vector<int>(offsets.begin(), offsets.end() - 1);
+    for (const auto& [src, dest] : edges) {
+        edge_targets[next_edge[src]++] = dest;
+        edge_targets[next_edge[dest]++] = src;
+    }
+}
+
+int CsrGraph::get_nodes_count() const noexcept {
+    return static_cast<int>(offsets.size()) - 1;
+}
+
+int CsrGraph::get_edges_count() const noexcept {
+    return static_cast<int>(edge_targets.size());
+}
+
+int CsrGraph::get_degree(const DeviceId node) const noexcept {
+    assert(0 <= node && node < get_nodes_count());
+
+    return offsets[node + 1] - offsets[node];
+}
+
+CsrGraph::NeighborRange CsrGraph::get_neighbors(const DeviceId node) const noexcept {
+    assert(0 <= node && node < get_nodes_count());
+
+    return {edge_targets.data() + offsets[node], edge_targets.data() + offsets[node + 1]};
+}
+
+const std::vector<int>& CsrGraph::get_offsets() const noexcept {
+    return offsets;
+}
+
+const std::vector<DeviceId>& CsrGraph::get_edge_targets() const noexcept {
+    return edge_targets;
+}
@@ -0,0 +1,226 @@
+/******************************************************************************
+This source code is licensed under the MIT license found in the
+LICENSE file in the root directory of this source tree.
+*******************************************************************************/
+
+#include "common/DistanceMatrix.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+using namespace NetworkAnalytical;
+
+namespace {
+
+/// identifies a DistanceMatrix file
+constexpr char file_magic[8] = {'A', 'N', 'A', 'D', 'I', 'S', '0', '1'};
+
+/// file header: magic, key, nodes count; the distances follow
+constexpr size_t file_header_size = sizeof(file_magic) + (2 * sizeof(uint64_t));
+
+}  // namespace
+
+DistanceMatrix::DistanceMatrix() noexcept : nodes_count(0), mapped(false) {}
+
+DistanceMatrix::DistanceMatrix(const CsrGraph& graph,
+                               int threads_count,
+                               std::shared_ptr<MemoryCounter> memory_counter) noexcept
+    : nodes_count(graph.get_nodes_count()),
+      mapped(false) {
+    assert(threads_count >= 0);
+
+    const auto& neighbor_offsets = graph.get_offsets();
+    const auto& neighbors = graph.get_edge_targets();
+
+    const auto matrix_size = static_cast<size_t>(nodes_count) * static_cast<size_t>(nodes_count);
+    auto matrix = std::make_shared<TrackedVector<uint8_t>>(matrix_size, unreachable_distance,
+                                                           TrackingAllocator<uint8_t>(std::move(memory_counter)));
+    auto* const matrix_data = matrix->data();
+
+    // bit (64 * w + b) of a node's lanes stands for source (first_source + 64 * w + b)
+    using Lanes = std::array<uint64_t, words_per_pass>;
+    constexpr auto sources_per_pass = 64 * words_per_pass;
+    const auto passes_count = (nodes_count + sources_per_pass - 1) / sources_per_pass;
+
+    // passes write disjoint rows, so each thread takes the next pass
+    auto next_pass = std::atomic<int>(0);
+    auto too_long = std::atomic<bool>(false);
+    const auto worker = [&]() {
+        auto visited = std::vector<Lanes>(nodes_count);
+        auto frontier = std::vector<Lanes>(nodes_count);
+        auto next_frontier = std::vector<Lanes>(nodes_count);
+
+        for (auto pass = next_pass++; pass < passes_count; pass = next_pass++) {
+            const auto first_source = pass * sources_per_pass;
+            const auto sources_count = std::min(sources_per_pass, nodes_count - first_source);
+
+            // each source starts from itself
+            std::fill(visited.begin(), visited.end(), Lanes{});
+            std::fill(frontier.begin(), frontier.end(), Lanes{});
+            for (auto i = 0; i < sources_count; i++) {
+                const auto src = first_source + i;
+                frontier[src][i / 64] |= static_cast<uint64_t>(1) << (i % 64);
+                visited[src][i / 64] |= static_cast<uint64_t>(1) << (i % 64);
+                matrix_data[(static_cast<size_t>(src) * nodes_count) + src] = 0;
+            }
+
+            // advance every BFS of the pass by one level at once
+            for (auto level = 1;; level++) {
+                auto reached_any = false;
+                for (auto node = 0; node < nodes_count; node++) {
+                    auto reached = Lanes{};
+                    for (auto i = neighbor_offsets[node]; i < neighbor_offsets[node + 1]; i++) {
+                        const auto& neighbor_frontier = frontier[neighbors[i]];
+                        for (auto w = 0; w < words_per_pass; w++) {
+                            reached[w] |= neighbor_frontier[w];
+                        }
+                    }
+                    for (auto w = 0; w < words_per_pass; w++) {
+                        reached[w] &= ~visited[node][w];
+                        visited[node][w] |= reached[w];
+                    }
+                    next_frontier[node] = reached;
+
+                    // record the distance of the newly reached sources
+                    for (auto w = 0; w < words_per_pass; w++) {
+                        for (auto bits = reached[w]; bits != 0; bits &= bits - 1) {
+                            if (level >= unreachable_distance) {
+                                too_long = true;
+                                break;
+                            }
+                            const auto src = first_source + (64 * w) + __builtin_ctzll(bits);
+                            matrix_data[(static_cast<size_t>(src) * nodes_count) + node] =
+                                static_cast<uint8_t>(level);
+                            reached_any = true;
+                        }
+                    }
+                }
+
+                if (!reached_any) {
+                    break;
+                }
+                std::swap(frontier, next_frontier);
+            }
+        }
+    };
+
+    if (threads_count == 0) {
+        threads_count = static_cast<int>(std::max(1U, std::thread::hardware_concurrency()));
+    }
+    threads_count = std::max(1, std::min(threads_count, passes_count));
+
+    auto threads = std::vector<std::thread>();
+    for (auto i = 1; i < threads_count; i++) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    if (too_long) {
+        std::cerr << "[Error] (network/analytical) " << "graph has paths too long for DistanceMatrix" << std::endl;
+        std::exit(-1);
+    }
+
+    distances = std::shared_ptr<const uint8_t>(std::move(matrix), matrix_data);
+}
+
+bool DistanceMatrix::empty() const noexcept {
+    return nodes_count == 0;
+}
+
+int DistanceMatrix::get_nodes_count() const noexcept {
+    return nodes_count;
+}
+
+uint8_t DistanceMatrix::get_distance(const DeviceId src, const DeviceId dest) const noexcept {
+    assert(0 <= src && src < nodes_count);
+    assert(0 <= dest && dest < nodes_count);
+
+    return distances.get()[(static_cast<size_t>(src) * static_cast<size_t>(nodes_count)) + static_cast<size_t>(dest)];
+}
+
+bool DistanceMatrix::save(const std::string& path, const uint64_t key) const noexcept {
+    assert(!empty());
+
+    // write to a temporary file first, so concurrent loaders never map a partial file
+    const auto temporary_path = path + ".tmp." + std::to_string(getpid());
+    {
+        auto file = std::ofstream(temporary_path, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            return false;
+        }
+
+        const auto header = std::array<uint64_t, 2>{key, static_cast<uint64_t>(nodes_count)};
+        file.write(file_magic, sizeof(file_magic));
+        file.write(reinterpret_cast<const char*>(header.data()), sizeof(header));
+        const auto matrix_size = static_cast<size_t>(nodes_count) * static_cast<size_t>(nodes_count);
+        file.write(reinterpret_cast<const char*>(distances.get()), static_cast<std::streamsize>(matrix_size));
+        if (!file) {
+            std::remove(temporary_path.c_str());
+            return false;
+        }
+    }
+
+    if (std::rename(temporary_path.c_str(), path.c_str()) != 0) {
+        std::remove(temporary_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool DistanceMatrix::load(const std::string& path, const uint64_t key, DistanceMatrix& distance_matrix) noexcept {
+    const auto fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    // map the whole file, read-only and shared, so every process loading it shares the pages
+    struct stat file_stat = {};
+    const auto file_size = (fstat(fd, &file_stat) == 0) ? static_cast<size_t>(file_stat.st_size) : 0;
+    if (file_size < file_header_size) {
+        close(fd);
+        return false;
+    }
+    auto* const mapping = mmap(nullptr, file_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        return false;
+    }
+    auto file_mapping = std::shared_ptr<const uint8_t>(static_cast<const uint8_t*>(mapping),
+                                                       [file_size](const uint8_t* const address) {
+                                                           munmap(const_cast<uint8_t*>(address), file_size);
+                                                       });
+
+    // check the file is for this graph
+    auto header = std::array<uint64_t, 2>();
+    std::memcpy(header.data(), file_mapping.get() + sizeof(file_magic), sizeof(header));
+    if (std::memcmp(file_mapping.get(), file_magic, sizeof(file_magic)) != 0 || header[0] != key || header[1] == 0 ||
+        header[1] > INT32_MAX || file_size != file_header_size + (header[1] * header[1])) {
+        return false;
+    }
+
+    auto loaded = DistanceMatrix();
+    loaded.nodes_count = static_cast<int>(header[1]);
+    loaded.mapped = true;
+    auto* const matrix_data = file_mapping.get() + file_header_size;
+    loaded.distances = std::shared_ptr<const uint8_t>(std::move(file_mapping), matrix_data);
+    distance_matrix = std::move(loaded);
+    return true;
+}
+
+bool DistanceMatrix::is_mapped() const noexcept {
+    return mapped;
+}
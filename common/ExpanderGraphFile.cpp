@@ -0,0 +1,383 @@
+/******************************************************************************
+This source code is licensed under the MIT license found in the
+LICENSE file in the root directory of this source tree.
+*******************************************************************************/
+
+#include "common/ExpanderGraphFile.h"
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include "../../helper/json/json.hpp"
+
+using namespace NetworkAnalytical;
+
+namespace {
+
+/// identifies a binary ExpanderGraphFile, and its version
+constexpr char file_magic[8] = {'A', 'N', 'A', 'E', 'G', 'B', '0', '1'};
+
+/// file header fields, following the magic; the arrays follow in the same order
+enum HeaderField {
+    NodeCount = 0,
+    Degree,
+    GroupACount,
+    ConnectedRowsCount,
+    ConnectedNeighborsCount,
+    SplitRowsCount,
+    SplitNeighborsCount,
+    HeaderFieldsCount
+};
+
+/**
+ * Streaming handler of an ExpanderGraph JSON file:
+ * keeps node_count, degree, groups.A, and the adjacency rows as they're parsed,
+ * and skips every other value.
+ */
+class JsonGraphHandler final : public nlohmann::json_sax<nlohmann::json> {
+  public:
+    /// field of the top-level object being parsed
+    enum class Field { Other, NodeCount, Degree, Groups, ConnectedAdjacency, SplitAdjacency };
+
+    JsonGraphHandler(int64_t& node_count,
+                     int64_t& degree,
+                     std::vector<DeviceId>& group_a,
+                     std::vector<int>& connected_offsets,
+                     std::vector<DeviceId>& connected_neighbors,
+                     std::vector<int>& split_offsets,
+                     std::vector<DeviceId>& split_neighbors) noexcept
+        : node_count(node_count),
+          degree(degree),
+          group_a(group_a),
+          connected_offsets(connected_offsets),
+          connected_neighbors(connected_neighbors),
+          split_offsets(split_offsets),
+          split_neighbors(split_neighbors),
+          depth(0),
+          field(Field::Other),
+          in_group_a(false),
+          valid(true) {}
+
+    bool null() override {
+        return true;
+    }
+
+    bool boolean(bool /* value */) override {
+        return true;
+    }
+
+    bool number_integer(const number_integer_t value) override {
+        return number(value);
+    }
+
+    bool number_unsigned(const number_unsigned_t value) override {
+        return number(value > static_cast<number_unsigned_t>(INT64_MAX) ? -1 : static_cast<int64_t>(value));
+    }
+
+    bool number_float(const number_float_t value, const string_t& /* string */) override {
+        // ids and counts are integers
+        if (depth == 1 && (field == Field::NodeCount || field == Field::Degree)) {
+            valid = false;
+        }
+        return valid;
+    }
+
+    bool string(string_t& /* value */) override {
+        return true;
+    }
+
+    bool binary(binary_t& /* value */) override {
+        return true;
+    }
+
+    bool start_object(std::size_t /* elements */) override {
+        depth++;
+        return true;
+    }
+
+    bool key(string_t& name) override {
+        if (depth == 1) {
+            field = Field::Other;
+            if (name == "node_count") {
+                field = Field::NodeCount;
+            } else if (name == "degree") {
+                field = Field::Degree;
+            } else if (name == "groups") {
+                field = Field::Groups;
+            } else if (name == "connected_graph_adjacency") {
+                field = Field::ConnectedAdjacency;
+            } else if (name == "split_graph_adjacency") {
+                field = Field::SplitAdjacency;
+            }
+        } else if (depth == 2 && field == Field::Groups) {
+            in_group_a = (name == "A");
+        }
+        return true;
+    }
+
+    bool end_object() override {
+        depth--;
+        return true;
+    }
+
+    bool start_array(std::size_t /* elements */) override {
+        depth++;
+        return true;
+    }
+
+    bool end_array() override {
+        // a row of an adjacency list ends
+        if (depth == 3 && field == Field::ConnectedAdjacency) {
+            connected_offsets.push_back(static_cast<int>(connected_neighbors.size()));
+        } else if (depth == 3 && field == Field::SplitAdjacency) {
+            split_offsets.push_back(static_cast<int>(split_neighbors.size()));
+        }
+        depth--;
+        return true;
+    }
+
+    bool parse_error(std::size_t /* position */,
+                     const std::string& /* last_token */,
+                     const nlohmann::detail::exception& /* exception */) override {
+        valid = false;
+        return false;
+    }
+
+    /**
+     * Check whether the parsed values are well-formed.
+     *
+     * @return true if well-formed, false otherwise
+     */
+    [[nodiscard]] bool is_valid() const noexcept {
+        return valid;
+    }
+
+  private:
+    int64_t& node_count;
+    int64_t& degree;
+    std::vector<DeviceId>& group_a;
+    std::vector<int>& connected_offsets;
+    std::vector<DeviceId>& connected_neighbors;
+    std::vector<int>& split_offsets;
+    std::vector<DeviceId>& split_neighbors;
+
+    /// number of open objects and arrays
+    int depth;
+
+    /// field of the top-level object being parsed
+    Field field;
+
+    /// whether groups.A is being parsed
+    bool in_group_a;
+
+    /// whether the parsed values are well-formed
+    bool valid;
+
+    /**
+     * Keep an integer, depending on where it appears.
+     */
+    bool number(const int64_t value) noexcept {
+        const auto id_value = (0 <= value && value <= std::numeric_limits<DeviceId>::max());
+        if (depth == 1 && field == Field::NodeCount) {
+            node_count = value;
+        } else if (depth == 1 && field == Field::Degree) {
+            degree = value;
+        } else if (depth == 3 && field == Field::Groups && in_group_a) {
+            group_a.push_back(static_cast<DeviceId>(value));
+            valid = valid && id_value;
+        } else if (depth == 3 && field == Field::ConnectedAdjacency) {
+            connected_neighbors.push_back(static_cast<DeviceId>(value));
+            valid = valid && id_value;
+        } else if (depth == 3 && field == Field::SplitAdjacency) {
+            split_neighbors.push_back(static_cast<DeviceId>(value));
+            valid = valid && id_value;
+        }
+        return valid;
+    }
+};
+
+/**
+ * Read an array of int32 values from a binary stream.
+ */
+template <typename T>
+void read_vector(std::ifstream& file, std::vector<T>& values, const uint64_t count) noexcept {
+    static_assert(sizeof(T) == sizeof(int32_t));
+    values.resize(count);
+    file.read(reinterpret_cast<char*>(values.data()), static_cast<std::streamsize>(count * sizeof(T)));
+}
+
+/**
+ * Write an array of int32 values to a binary stream.
+ */
+template <typename T>
+void write_vector(std::ofstream& file, const std::vector<T>& values) noexcept {
+    static_assert(sizeof(T) == sizeof(int32_t));
+    file.write(reinterpret_cast<const char*>(values.data()), static_cast<std::streamsize>(values.size() * sizeof(T)));
+}
+
+}  // namespace
+
+ExpanderGraphFile::ExpanderGraphFile() noexcept
+    : node_count(0),
+      degree(0),
+      connected_offsets(1, 0),
+      split_offsets(1, 0) {}
+
+bool ExpanderGraphFile::load(const std::string& path, ExpanderGraphFile& graph_file) noexcept {
+    auto file = std::ifstream(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    auto loaded = ExpanderGraphFile();
+    auto magic = std::array<char, sizeof(file_magic)>();
+    file.read(magic.data(), magic.size());
+    if (file && std::memcmp(magic.data(), file_magic, sizeof(file_magic)) == 0) {
+        // binary: the header, then every array
+        auto header = std::array<uint64_t, HeaderFieldsCount>();
+        file.read(reinterpret_cast<char*>(header.data()), sizeof(header));
+        file.seekg(0, std::ios::end);
+        const auto file_size = static_cast<uint64_t>(file.tellg());
+        auto arrays_size = static_cast<uint64_t>(0);
+        for (auto i = static_cast<int>(GroupACount); i < HeaderFieldsCount; i++) {
+            arrays_size += header[i] + ((i == ConnectedRowsCount || i == SplitRowsCount) ? 1 : 0);
+        }
+        if (!file || header[NodeCount] > INT32_MAX || header[Degree] > INT32_MAX ||
+            file_size != sizeof(file_magic) + sizeof(header) + (arrays_size * sizeof(int32_t))) {
+            return false;
+        }
+        file.seekg(sizeof(file_magic) + sizeof(header));
+
+        loaded.node_count = static_cast<int>(header[NodeCount]);
+        loaded.degree = static_cast<int>(header[Degree]);
+        read_vector(file, loaded.group_a, header[GroupACount]);
+        read_vector(file, loaded.connected_offsets, header[ConnectedRowsCount] + 1);
+        read_vector(file, loaded.connected_neighbors, header[ConnectedNeighborsCount]);
+        read_vector(file, loaded.split_offsets, header[SplitRowsCount] + 1);
+        read_vector(file, loaded.split_neighbors, header[SplitNeighborsCount]);
+        if (!file) {
+            return false;
+        }
+    } else {
+        // JSON: a single streaming pass
+        file.clear();
+        file.seekg(0);
+        auto parsed_node_count = static_cast<int64_t>(-1);
+        auto parsed_degree = static_cast<int64_t>(-1);
+        auto handler = JsonGraphHandler(parsed_node_count, parsed_degree, loaded.group_a, loaded.connected_offsets,
+                                        loaded.connected_neighbors, loaded.split_offsets, loaded.split_neighbors);
+        nlohmann::json::sax_parse(file, &handler);
+        if (!handler.is_valid() || parsed_node_count < 0 || parsed_node_count > INT32_MAX || parsed_degree < 0 ||
+            parsed_degree > INT32_MAX) {
+            return false;
+        }
+        loaded.node_count = static_cast<int>(parsed_node_count);
+        loaded.degree = static_cast<int>(parsed_degree);
+    }
+
+    if (!loaded.valid()) {
+        return false;
+    }
+    graph_file = std::move(loaded);
+    return true;
+}
+
+bool ExpanderGraphFile::save(const std::string& path) const noexcept {
+    auto file = std::ofstream(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    auto header = std::array<uint64_t, HeaderFieldsCount>();
+    header[NodeCount] = static_cast<uint64_t>(node_count);
+    header[Degree] = static_cast<uint64_t>(degree);
+    header[GroupACount] = group_a.size();
+    header[ConnectedRowsCount] = connected_offsets.size() - 1;
+    header[ConnectedNeighborsCount] = connected_neighbors.size();
+    header[SplitRowsCount] = split_offsets.size() - 1;
+    header[SplitNeighborsCount] = split_neighbors.size();
+
+    file.write(file_magic, sizeof(file_magic));
+    file.write(reinterpret_cast<const char*>(header.data()), sizeof(header));
+    write_vector(file, group_a);
+    write_vector(file, connected_offsets);
+    write_vector(file, connected_neighbors);
+    write_vector(file, split_offsets);
+    write_vector(file, split_neighbors);
+    return static_cast<bool>(file);
+}
+
+int ExpanderGraphFile::get_node_count() const noexcept {
+    return node_count;
+}
+
+int ExpanderGraphFile::get_degree() const noexcept {
+    return degree;
+}
+
+std::vector<ExpanderGraphFile::Edge> ExpanderGraphFile::get_connected_graph_edges() const noexcept {
+    // every node keeps its id
+    auto remap = std::vector<DeviceId>(node_count);
+    for (auto node = 0; node < node_count; node++) {
+        remap[node] = node;
+    }
+    return collect_edges(connected_offsets, connected_neighbors, remap);
+}
+
+std::vector<ExpanderGraphFile::Edge> ExpanderGraphFile::get_split_graph_edges() const noexcept {
+    // nodes of group A take their position in it, the others are dropped
+    auto remap = std::vector<DeviceId>(node_count, -1);
+    for (auto i = 0; i < static_cast<int>(group_a.size()); i++) {
+        remap[group_a[i]] = i;
+    }
+    return collect_edges(split_offsets, split_neighbors, remap);
+}
+
+std::vector<ExpanderGraphFile::Edge> ExpanderGraphFile::collect_edges(const std::vector<int>& offsets,
+                                                                      const std::vector<DeviceId>& neighbors,
+                                                                      const std::vector<DeviceId>& remap) noexcept {
+    // each edge is taken from the row of its lower end;
+    // last_row[v] is the last row v was taken from, so repeated neighbors are taken once
+    auto edges = std::vector<Edge>();
+    auto last_row = std::vector<int>(remap.size(), -1);
+    const auto rows_count = static_cast<int>(offsets.size()) - 1;
+    for (auto row = 0; row < rows_count; row++) {
+        const auto src = remap[row];
+        if (src < 0) {
+            continue;
+        }
+        for (auto i = offsets[row]; i < offsets[row + 1]; i++) {
+            const auto dest = remap[neighbors[i]];
+            if (src < dest && last_row[dest] != row) {
+                edges.emplace_back(src, dest);
+                last_row[dest] = row;
+            }
+        }
+    }
+    return edges;
+}
+
+bool ExpanderGraphFile::valid() const noexcept {
+    // rows and ids should be nodes of the graph
+    const auto valid_ids = [this](const std::vector<DeviceId>& ids) {
+        for (const auto id : ids) {
+            if (id < 0 || id >= node_count) {
+                return false;
+            }
+        }
+        return true;
+    };
+    const auto valid_offsets = [this](const std::vector<int>& offsets, const size_t neighbors_count) {
+        if (offsets.empty() || offsets.size() - 1 > static_cast<size_t>(node_count) || offsets.front() != 0 ||
+            offsets.back() != static_cast<int>(neighbors_count)) {
+            return false;
+        }
+        return std::is_sorted(offsets.begin(), offsets.end());
+    };
+    return valid_ids(group_a) && valid_ids(connected_neighbors) && valid_ids(split_neighbors) &&
+           valid_offsets(connected_offsets, connected_neighbors.size()) &&
+           valid_offsets(split_offsets, split_neighbors.size());
+}
@@ -0,0 +1,384 @@
+/******************************************************************************
+This source code is licensed under the MIT license found in the
+LICENSE file in the root directory of this source tree.
+*******************************************************************************/
+
+#include "common/KShortestPaths.h"
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <thread>
+
+using namespace NetworkAnalytical;
+
+namespace {
+
+/// identifies a KShortestPaths file
+constexpr char file_magic[8] = {'A', 'N', 'A', 'K', 'S', 'P', '0', '1'};
+
+/// node ids are stored in 16 bits
+constexpr int max_nodes_count = UINT16_MAX + 1;
+
+/// paths found from a single source, to every endpoint in order
+struct SourcePaths {
+    /// node ids of the paths, back-to-back
+    std::vector<uint16_t> nodes;
+
+    /// number of nodes of each path
+    std::vector<uint32_t> path_lengths;
+
+    /// number of paths to each endpoint
+    std::vector<uint32_t> paths_counts;
+};
+
+/**
+ * Yen's algorithm over a CSR graph.
+ * Banned nodes and edges are marked with the stamp of the current spur search,
+ * so nothing has to be cleared between searches.
+ * Each thread owns its own search.
+ */
+class PathSearch {
+  public:
+    PathSearch(const std::vector<int>& neighbor_offsets, const std::vector<uint16_t>& neighbors) noexcept
+        : neighbor_offsets(neighbor_offsets),
+          neighbors(neighbors),
+          node_ban_stamps(neighbor_offsets.size() - 1, 0),
+          edge_ban_stamps(neighbors.size(), 0),
+          visit_stamps(neighbor_offsets.size() - 1, 0),
+          parents(neighbor_offsets.size() - 1, 0),
+          queue(neighbor_offsets.size() - 1, 0),
+          ban_stamp(1),
+          visit_stamp(0) {}
+
+    /**
+     * Find up to k shortest paths from start to goal, sorted by length.
+     */
+    void find_paths(const uint16_t start,
+                    const uint16_t goal,
+                    const int k,
+                    std::vector<std::vector<uint16_t>>& shortest_paths) noexcept {
+        shortest_paths.clear();
+        candidates.clear();
+        known_paths.clear();
+
+        // no ban in effect
+        ban_stamp++;
+        auto first_path = std::vector<uint16_t>();
+        if (!find_path(start, goal, first_path)) {
+            return;
+        }
+        known_paths.insert(first_path);
+        shortest_paths.push_back(std::move(first_path));
+
+        auto spur_path = std::vector<uint16_t>();
+        for (auto path_index = 1; path_index < k; path_index++) {
+            const auto previous_path = shortest_paths.back();
+            for (auto i = static_cast<size_t>(0); i + 1 < previous_path.size(); i++) {
+                const auto spur_node = previous_path[i];
+
+                // ban the root path, and the edges leaving it along known paths
+                ban_stamp++;
+                for (auto j = static_cast<size_t>(0); j < i; j++) {
+                    node_ban_stamps[previous_path[j]] = ban_stamp;
+                }
+                for (const auto& path : shortest_paths) {
+                    if (path.size() > i + 1 && std::equal(previous_path.begin(), previous_path.begin() + i + 1, path.begin())) {
+                        ban_edge(path[i], path[i + 1]);
+                        ban_edge(path[i + 1], path[i]);
+                    }
+                }
+
+                if (!find_path(spur_node, goal, spur_path)) {
+                    continue;
+                }
+
+                auto total_path = std::vector<uint16_t>(previous_path.begin(), previous_path.begin() + i);
+                total_path.insert(total_path.end(), spur_path.begin(), spur_path.end());
+                if (known_paths.insert(total_path).second) {
+                    candidates.push_back(std::move(total_path));
+                }
+            }
+
+            if (candidates.empty()) {
+                break;
+            }
+
+            // the shortest candidate, the earliest found among ties
+            const auto best_it = std::min_element(
+                candidates.begin(), candidates.end(),
+                [](const std::vector<uint16_t>& a, const std::vector<uint16_t>& b) { return a.size() < b.size(); });
+            shortest_paths.push_back(std::move(*best_it));
+            candidates.erase(best_it);
+        }
+    }
+
+  private:
+    const std::vector<int>& neighbor_offsets;
+    const std::vector<uint16_t>& neighbors;
+
+    /// node is banned if its stamp equals ban_stamp
+    std::vector<uint32_t> node_ban_stamps;
+
+    /// edge (by index in neighbors) is banned if its stamp equals ban_stamp
+    std::vector<uint32_t> edge_ban_stamps;
+
+    /// node is discovered by the current BFS if its stamp equals visit_stamp
+    std::vector<uint32_t> visit_stamps;
+
+    /// BFS tree of the current search
+    std::vector<uint16_t> parents;
+
+    /// BFS queue
+    std::vector<uint16_t> queue;
+
+    uint32_t ban_stamp;
+    uint32_t visit_stamp;
+
+    /// candidate paths of Yen's algorithm, in discovery order
+    std::vector<std::vector<uint16_t>> candidates;
+
+    /// every path found so far (shortest or candidate)
+    std::set<std::vector<uint16_t>> known_paths;
+
+    void ban_edge(const uint16_t from, const uint16_t to) noexcept {
+        for (auto i = neighbor_offsets[from]; i < neighbor_offsets[from + 1]; i++) {
+            if (neighbors[i] == to) {
+                edge_ban_stamps[i] = ban_stamp;
+            }
+        }
+    }
+
+    /**
+     * BFS from start to goal, avoiding the banned nodes and edges.
+     */
+    bool find_path(const uint16_t start, const uint16_t goal, std::vector<uint16_t>& path) noexcept {
+        if (node_ban_stamps[start] == ban_stamp) {
+            return false;
+        }
+
+        visit_stamp++;
+        visit_stamps[start] = visit_stamp;
+        parents[start] = start;
+        auto head = 0;
+        auto tail = 0;
+        queue[tail++] = start;
+
+        while (head < tail) {
+            const auto current = queue[head++];
+            if (current == goal) {
+                break;
+            }
+
+            for (auto i = neighbor_offsets[current]; i < neighbor_offsets[current + 1]; i++) {
+                const auto neighbor = neighbors[i];
+                if (node_ban_stamps[neighbor] == ban_stamp || edge_ban_stamps[i] == ban_stamp) {
+                    continue;
+                }
+                if (visit_stamps[neighbor] != visit_stamp) {
+                    visit_stamps[neighbor] = visit_stamp;
+                    parents[neighbor] = current;
+                    queue[tail++] = neighbor;
+                }
+            }
+        }
+
+        if (visit_stamps[goal] != visit_stamp) {
+            return false;
+        }
+
+        path.clear();
+        for (auto current = goal; current != start; current = parents[current]) {
+            path.push_back(current);
+        }
+        path.push_back(start);
+        std::reverse(path.begin(), path.end());
+        return true;
+    }
+};
+
+template <typename T>
+void write_vector(std::ofstream& file, const std::vector<T>& values) noexcept {
+    const auto size = static_cast<uint64_t>(values.size());
+    file.write(reinterpret_cast<const char*>(&size), sizeof(size));
+    file.write(reinterpret_cast<const char*>(values.data()), static_cast<std::streamsize>(size * sizeof(T)));
+}
+
+template <typename T>
+bool read_vector(std::ifstream& file, std::vector<T>& values, const uint64_t max_size) noexcept {
+    auto size = static_cast<uint64_t>(0);
+    if (!file.read(reinterpret_cast<char*>(&size), sizeof(size)) || size > max_size) {
+        return false;
+    }
+    values.resize(size);
+    return static_cast<bool>(
+        file.read(reinterpret_cast<char*>(values.data()), static_cast<std::streamsize>(size * sizeof(T))));
+}
+
+}  // namespace
+
+KShortestPaths::KShortestPaths() noexcept : endpoints_count(0), k(0) {}
+
+KShortestPaths::KShortestPaths(const CsrGraph& graph,
+                               const int endpoints_count,
+                               const int k,
+                               int threads_count) noexcept
+    : endpoints_count(endpoints_count),
+      k(k) {
+    assert(endpoints_count > 0);
+    assert(k > 0);
+    assert(threads_count >= 0);
+
+    const auto nodes_count = graph.get_nodes_count();
+    assert(endpoints_count <= nodes_count);
+    if (nodes_count > max_nodes_count) {
+        std::cerr << "[Error] (network/analytical) "
+                  << "graph with " << nodes_count << " nodes is too large for KShortestPaths" << std::endl;
+        std::exit(-1);
+    }
+
+    // node ids fit in 16 bits, so do the neighbors
+    const auto& neighbor_offsets = graph.get_offsets();
+    auto neighbors = std::vector<uint16_t>(graph.get_edge_targets().begin(), graph.get_edge_targets().end());
+
+    // one source per task
+    auto source_paths = std::vector<SourcePaths>(endpoints_count);
+    auto next_source = std::atomic<int>(0);
+    const auto worker = [&]() noexcept {
+        auto search = PathSearch(neighbor_offsets, neighbors);
+        auto paths = std::vector<std::vector<uint16_t>>();
+        for (auto src = next_source++; src < endpoints_count; src = next_source++) {
+            auto& result = source_paths[src];
+            for (auto dest = 0; dest < endpoints_count; dest++) {
+                search.find_paths(static_cast<uint16_t>(src), static_cast<uint16_t>(dest), k, paths);
+                result.paths_counts.push_back(static_cast<uint32_t>(paths.size()));
+                for (const auto& path : paths) {
+                    result.path_lengths.push_back(static_cast<uint32_t>(path.size()));
+                    result.nodes.insert(result.nodes.end(), path.begin(), path.end());
+                }
+            }
+        }
+    };
+
+    if (threads_count == 0) {
+        threads_count = static_cast<int>(std::max(1U, std::thread::hardware_concurrency()));
+    }
+    threads_count = std::min(threads_count, endpoints_count);
+
+    auto threads = std::vector<std::thread>();
+    for (auto i = 1; i < threads_count; i++) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    // pack the results into the arena, in source order
+    pair_offsets.reserve((static_cast<size_t>(endpoints_count) * endpoints_count) + 1);
+    pair_offsets.push_back(0);
+    path_offsets.push_back(0);
+    for (auto& result : source_paths) {
+        for (const auto paths_count : result.paths_counts) {
+            pair_offsets.push_back(pair_offsets.back() + paths_count);
+        }
+        for (const auto path_length : result.path_lengths) {
+            path_offsets.push_back(path_offsets.back() + path_length);
+        }
+        path_nodes.insert(path_nodes.end(), result.nodes.begin(), result.nodes.end());
+
+        // release the per-source buffers as soon as they're packed
+        result = SourcePaths();
+    }
+}
+
+bool KShortestPaths::empty() const noexcept {
+    return endpoints_count == 0;
+}
+
+int KShortestPaths::get_endpoints_count() const noexcept {
+    return endpoints_count;
+}
+
+int KShortestPaths::get_k() const noexcept {
+    return k;
+}
+
+int KShortestPaths::get_paths_count(const DeviceId src, const DeviceId dest) const noexcept {
+    assert(0 <= src && src < endpoints_count);
+    assert(0 <= dest && dest < endpoints_count);
+
+    const auto pair = (static_cast<size_t>(src) * endpoints_count) + dest;
+    return static_cast<int>(pair_offsets[pair + 1] - pair_offsets[pair]);
+}
+
+KShortestPaths::PathRange KShortestPaths::get_path(const DeviceId src, const DeviceId dest, const int index) const noexcept {
+    assert(0 <= index && index < get_paths_count(src, dest));
+
+    const auto pair = (static_cast<size_t>(src) * endpoints_count) + dest;
+    const auto path = pair_offsets[pair] + static_cast<uint32_t>(index);
+    return {path_nodes.data() + path_offsets[path], path_nodes.data() + path_offsets[path + 1]};
+}
+
+bool KShortestPaths::save(const std::string& path, const uint64_t key) const noexcept {
+    assert(!empty());
+
+    auto file = std::ofstream(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    const auto header = std::vector<uint64_t>{key, static_cast<uint64_t>(endpoints_count), static_cast<uint64_t>(k)};
+    file.write(file_magic, sizeof(file_magic));
+    write_vector(file, header);
+    write_vector(file, pair_offsets);
+    write_vector(file, path_offsets);
+    write_vector(file, path_nodes);
+    return static_cast<bool>(file);
+}
+
+bool KShortestPaths::load(const std::string& path,
+                          const uint64_t key,
+                          const int k,
+                          KShortestPaths& k_shortest_paths) noexcept {
+    assert(k > 0);
+
+    auto file = std::ifstream(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    // check the file is for this graph and k
+    char magic[sizeof(file_magic)];
+    auto header = std::vector<uint64_t>();
+    if (!file.read(magic, sizeof(magic)) || std::memcmp(magic, file_magic, sizeof(magic)) != 0 ||
+        !read_vector(file, header, 3) || header.size() != 3) {
+        return false;
+    }
+    if (header[0] != key || header[2] != static_cast<uint64_t>(k) || header[1] == 0 || header[1] >= max_nodes_count) {
+        return false;
+    }
+
+    auto loaded = KShortestPaths();
+    loaded.endpoints_count = static_cast<int>(header[1]);
+    loaded.k = k;
+    const auto pairs_count = static_cast<uint64_t>(loaded.endpoints_count) * static_cast<uint64_t>(loaded.endpoints_count);
+    if (!read_vector(file, loaded.pair_offsets, pairs_count + 1) || loaded.pair_offsets.size() != pairs_count + 1) {
+        return false;
+    }
+    if (!read_vector(file, loaded.path_offsets, static_cast<uint64_t>(loaded.pair_offsets.back()) + 1) ||
+        loaded.path_offsets.size() != static_cast<uint64_t>(loaded.pair_offsets.back()) + 1) {
+        return false;
+    }
+    if (!read_vector(file, loaded.path_nodes, loaded.path_offsets.back()) ||
+        loaded.path_nodes.size() != loaded.path_offsets.back()) {
+        return false;
+    }
+
+    k_shortest_paths = std::move(loaded);
+    return true;
+}
@@ -0,0 +1,123 @@
+/******************************************************************************
+This source code is licensed under the MIT license found in the
+LICENSE file in the root directory of this source tree.
+*******************************************************************************/
+
+#include "common/TraceFile.h"
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+using namespace NetworkAnalytical;
+
+namespace {
+
+/// identifies a trace file
+constexpr char file_magic[8] = {'A', 'N', 'A', 'T', 'R', 'C', '0', '1'};
+
+/// size of the read buffer of TraceReader
+constexpr size_t read_buffer_size = 1 << 20;
+
+/**
+ * Read a plain value from a stream.
+ */
+template <typename T>
+bool read_value(std::ifstream& file, T& value) noexcept {
+    return static_cast<bool>(file.read(reinterpret_cast<char*>(&value), sizeof(T)));
+}
+
+/**
+ * Write a plain value to a stream.
+ */
+template <typename T>
+void write_value(std::ofstream& file, const T& value) noexcept {
+    file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+}  // namespace
+
+TraceReader::TraceReader(const std::string& path) noexcept
+    : buffer(read_buffer_size),
+      records_count(0),
+      read_records_count(0) {
+    file.rdbuf()->pubsetbuf(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    file.open(path, std::ios::binary);
+
+    char magic[sizeof(file_magic)] = {};
+    if (!file.is_open() || !file.read(magic, sizeof(magic)) || std::memcmp(magic, file_magic, sizeof(magic)) != 0 ||
+        !read_value(file, records_count)) {
+        std::cerr << "[Error] (network/analytical) " << "can't read trace file " << path << std::endl;
+        std::exit(-1);
+    }
+}
+
+uint64_t TraceReader::get_records_count() const noexcept {
+    return records_count;
+}
+
+bool TraceReader::next(TraceRecord& record) noexcept {
+    if (read_records_count == records_count) {
+        return false;
+    }
+
+    auto issue_time = static_cast<EventTime>(0);
+    auto src = static_cast<int32_t>(0);
+    auto dest = static_cast<int32_t>(0);
+    auto size = static_cast<uint64_t>(0);
+    auto dependencies_count = static_cast<uint32_t>(0);
+    auto valid = read_value(file, issue_time) && read_value(file, src) && read_value(file, dest) &&
+                 read_value(file, size) && read_value(file, dependencies_count);
+    record.dependencies.resize(valid ? dependencies_count : 0);
+    for (auto i = static_cast<uint32_t>(0); valid && i < dependencies_count; i++) {
+        valid = read_value(file, record.dependencies[i]);
+    }
+    if (!valid) {
+        std::cerr << "[Error] (network/analytical) " << "trace file ends in the middle of record "
+                  << read_records_count << std::endl;
+        std::exit(-1);
+    }
+
+    record.issue_time = issue_time;
+    record.src = src;
+    record.dest = dest;
+    record.size = size;
+    read_records_count++;
+    return true;
+}
+
+TraceWriter::TraceWriter(const std::string& path) noexcept : records_count(0) {
+    file.open(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        std::cerr << "[Error] (network/analytical) " << "can't create trace file " << path << std::endl;
+        std::exit(-1);
+    }
+
+    // the number of records is written on close()
+    file.write(file_magic, sizeof(file_magic));
+    write_value(file, records_count);
+}
+
+void TraceWriter::write(const TraceRecord& record) noexcept {
+    assert(file.is_open());
+
+    write_value(file, record.issue_time);
+    write_value(file, static_cast<int32_t>(record.src));
+    write_value(file, static_cast<int32_t>(record.dest));
+    write_value(file, static_cast<uint64_t>(record.size));
+    write_value(file, static_cast<uint32_t>(record.dependencies.size()));
+    for (const auto dependency : record.dependencies) {
+        assert(dependency < records_count);
+        write_value(file, dependency);
+    }
+    records_count++;
+}
+
+bool TraceWriter::close() noexcept {
+    assert(file.is_open());
+
+    file.seekp(sizeof(file_magic));
+    write_value(file, records_count);
+    file.close();
+    return !file.fail();
+}
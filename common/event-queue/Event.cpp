@@ -5,26 +5,45 @@ LICENSE file in the root directory of this source tree.
 
 #include "common/Event.h"
 #include <cassert>
+#include <utility>
 
 using namespace NetworkAnalytical;
 
-Event::Event(const Callback callback, const CallbackArg callback_arg) noexcept
-    : callback(callback),
-      callback_arg(callback_arg) {
+Event::Event(const Callback callback, const CallbackArg callback_arg) noexcept : callback(callback, callback_arg) {
     assert(callback != nullptr);
 }
 
+Event::Event(EventCallback callback) noexcept : callback(std::move(callback)) {
+    assert(this->callback);
+}
+
 void Event::invoke_event() noexcept {
     // check the validity of the event
-    assert(callback != nullptr);
+    assert(callback);
 
     // invoke the callback function
-    (*callback)(callback_arg);
+    callback();
 }
 
 std::pair<Callback, CallbackArg> Event::get_handler_arg() const noexcept {
     // check the validity of the event
-    assert(callback != nullptr);
+    assert(callback);
+
+    return callback.get_function_pointer();
+}
+
+const void* Event::get_type_id() const noexcept {
+    // check the validity of the event
+    assert(callback);
+
+    return callback.get_type_id();
+}
+
+void Event::cancel() noexcept {
+    // a cancelled event has no callback
+    callback.reset();
+}
 
-    return {callback, callback_arg};
+bool Event::is_cancelled() const noexcept {
+    return !callback;
 }
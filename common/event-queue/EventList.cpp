@@ -5,31 +5,122 @@ LICENSE file in the root directory of this source tree.
 
 #include "common/EventList.h"
 #include <cassert>
+#include <utility>
 
 using namespace NetworkAnalytical;
 
-EventList::EventList(const EventTime event_time) noexcept : event_time(event_time) {
+EventList::EventList(const EventTime event_time, std::shared_ptr<MemoryCounter> memory_counter) noexcept
+    : event_time(event_time),
+      events(TrackingAllocator<Event>(std::move(memory_counter))),
+      next_event_index(0),
+      pending_events_count(0),
+      generation(0) {
     assert(event_time >= 0);
 
-    // create an empty event list
-    events = std::list<Event>();
+#ifdef ASTRA_NET_STATS
+    stats = nullptr;
+#endif
 }
 
 EventTime EventList::get_event_time() const noexcept {
     return event_time;
 }
 
-void EventList::add_event(const Callback callback, const CallbackArg callback_arg) noexcept {
+uint64_t EventList::get_generation() const noexcept {
+    return generation;
+}
+
+size_t EventList::add_event(const Callback callback, const CallbackArg callback_arg) noexcept {
     assert(callback != nullptr);
 
     // add the event to the event list
     events.emplace_back(callback, callback_arg);
+    pending_events_count++;
+
+    return events.size() - 1;
+}
+
+size_t EventList::add_event(EventCallback callback) noexcept {
+    assert(callback);
+
+    // add the event to the event list
+    events.emplace_back(std::move(callback));
+    pending_events_count++;
+
+    return events.size() - 1;
 }
 
-void EventList::invoke_events() noexcept {
+void EventList::add_events(const std::vector<std::pair<Callback, CallbackArg>>& handlers) noexcept {
+    // grow the storage once for the whole batch
+    events.reserve(events.size() + handlers.size());
+
+    // add the events in the given order
+    for (const auto& [callback, callback_arg] : handlers) {
+        assert(callback != nullptr);
+        events.emplace_back(callback, callback_arg);
+    }
+    pending_events_count += handlers.size();
+}
+
+size_t EventList::invoke_events() noexcept {
+    auto invoked_events_count = static_cast<size_t>(0);
+
     // invoke all events in the event list
-    while (!events.empty()) {
-        events.front().invoke_event();
-        events.pop_front();
+    // the event is moved out first, as invoking it may append to (and reallocate) events
+    while (next_event_index < events.size()) {
+        auto event = std::move(events[next_event_index]);
+        next_event_index++;
+
+        // skip cancelled events
+        if (event.is_cancelled()) {
+            continue;
+        }
+
+        pending_events_count--;
+        invoked_events_count++;
+#ifdef ASTRA_NET_STATS
+        if (stats != nullptr) {
+            stats->callback_counts[event.get_type_id()]++;
+        }
+#endif
+        event.invoke_event();
     }
+
+    return invoked_events_count;
+}
+
+bool EventList::cancel_event(const size_t event_index) noexcept {
+    assert(event_index < events.size());
+
+    // already invoked, or already cancelled
+    if (event_index < next_event_index || events[event_index].is_cancelled()) {
+        return false;
+    }
+
+    events[event_index].cancel();
+    pending_events_count--;
+    return true;
+}
+
+bool EventList::has_pending_events() const noexcept {
+    return pending_events_count > 0;
+}
+
+#ifdef ASTRA_NET_STATS
+void EventList::set_stats(EventQueueStats* const stats) noexcept {
+    this->stats = stats;
+}
+#endif
+
+void EventList::reset(const EventTime new_event_time) noexcept {
+    assert(new_event_time >= 0);
+
+    // drop events but keep their storage
+    events.clear();
+    next_event_index = 0;
+    pending_events_count = 0;
+    event_time = new_event_time;
+
+    // invalidate handles to the dropped events
+    generation++;
 }
@@ -4,13 +4,49 @@ LICENSE file in the root directory of this source tree.
 *******************************************************************************/
 
 #include "common/EventQueue.h"
+#include <algorithm>
 #include <cassert>
+#include <utility>
 
 using namespace NetworkAnalytical;
 
-EventQueue::EventQueue() noexcept : current_time(0) {
-    // create empty event queue
-    event_queue = std::list<EventList>();
+EventQueue::EventQueue() noexcept
+    : current_time(0),
+      memory_counter(std::make_shared<MemoryCounter>()),
+      event_times(memory_counter),
+      event_lists(0,
+                  std::hash<EventTime>(),
+                  std::equal_to<EventTime>(),
+                  TrackingAllocator<std::pair<const EventTime, EventList*>>(memory_counter)),
+      event_list_slab(TrackingAllocator<EventList>(memory_counter)),
+      free_event_lists(TrackingAllocator<EventList*>(memory_counter)),
+      time_end_events(TrackingAllocator<EventCallback>(memory_counter)),
+      invoking_time_end_events(TrackingAllocator<EventCallback>(memory_counter)),
+      deferring(false),
+      deferred_events(TrackingAllocator<std::pair<EventTime, EventCallback>>(memory_counter)) {}
+
+void EventQueue::reset() noexcept {
+    // drop the events of every registered time, keeping the lists for reuse
+    for (const auto& [event_time, event_list] : event_lists) {
+        event_list->reset(0);
+        free_event_lists.push_back(event_list);
+    }
+    event_lists.clear();
+    time_end_events.clear();
+    event_times = EventTimeHeap(memory_counter);
+    current_time = 0;
+
+    // an abandoned batch is dropped as well
+    deferring = false;
+    deferred_events.clear();
+
+#ifdef ASTRA_NET_STATS
+    stats = EventQueueStats();
+#endif
+}
+
+const MemoryCounter& EventQueue::get_memory_counter() const noexcept {
+    return *memory_counter;
 }
 
 EventTime EventQueue::get_current_time() const noexcept {
@@ -19,53 +55,247 @@ EventTime EventQueue::get_current_time() const noexcept {
 
 bool EventQueue::finished() const noexcept {
     // check whether event queue is empty
-    return event_queue.empty();
+    return event_times.empty();
+}
+
+EventTime EventQueue::get_next_event_time() const noexcept {
+    // next event should exist
+    assert(!finished());
+
+    return event_times.top();
 }
 
 void EventQueue::proceed() noexcept {
     // to proceed, next event should exist
     assert(!finished());
 
+    process_next_event_list();
+}
+
+void EventQueue::run() noexcept {
+    while (!event_times.empty()) {
+        process_next_event_list();
+    }
+}
+
+void EventQueue::run_until(const EventTime end_time) noexcept {
+    while (!event_times.empty() && event_times.top() <= end_time) {
+        process_next_event_list();
+    }
+
+    // time passes even when no event is left before end_time
+    if (end_time > current_time) {
+        current_time = end_time;
+    }
+}
+
+size_t EventQueue::run_for(const size_t events_count) noexcept {
+    auto invoked_events_count = static_cast<size_t>(0);
+
+    while (!event_times.empty() && invoked_events_count < events_count) {
+        invoked_events_count += process_next_event_list();
+    }
+
+    return invoked_events_count;
+}
+
+size_t EventQueue::process_next_event_list() noexcept {
     // proceed to the next event time
-    auto& current_event_list = event_queue.front();
+    const auto next_event_time = event_times.top();
+    auto* const current_event_list = event_lists.at(next_event_time);
 
     // check the validity and update current time
-    assert(current_event_list.get_event_time() > current_time);
-    current_time = current_event_list.get_event_time();
+    // (an event scheduled at current_time while the queue is idle is processed now)
+    assert(next_event_time >= current_time);
+    current_time = next_event_time;
+
+    // the list is popped from the heap but kept in the map while invoking,
+    // so events scheduled at current_time meanwhile are appended to the same list
+    event_times.pop();
+    auto invoked_events_count = current_event_list->invoke_events();
+
+    // time-end events go last, and may schedule more events at current_time
+    while (!time_end_events.empty()) {
+        invoking_time_end_events.swap(time_end_events);
+        for (auto& time_end_event : invoking_time_end_events) {
+            time_end_event();
+        }
+        invoked_events_count += invoking_time_end_events.size();
+        invoking_time_end_events.clear();
+        invoked_events_count += current_event_list->invoke_events();
+    }
+#ifdef ASTRA_NET_STATS
+    stats.events_count += invoked_events_count;
+    stats.event_times_count++;
+    stats.max_event_list_length = std::max(stats.max_event_list_length, invoked_events_count);
+#endif
 
-    // invoke events
-    current_event_list.invoke_events();
+    // drop processed event list, and keep it for reuse
+    event_lists.erase(next_event_time);
+    free_event_lists.push_back(current_event_list);
 
-    // drop processed event list
-    event_queue.pop_front();
+    // keep an invocable event at the front
+    drop_cancelled_event_lists();
+
+    return invoked_events_count;
+}
+
+void EventQueue::drop_cancelled_event_lists() noexcept {
+    while (!event_times.empty()) {
+        const auto event_time = event_times.top();
+        auto* const event_list = event_lists.at(event_time);
+        if (event_list->has_pending_events()) {
+            return;
+        }
+
+        // every event at this time got cancelled
+        event_times.pop();
+        event_lists.erase(event_time);
+        free_event_lists.push_back(event_list);
+    }
 }
 
-void EventQueue::schedule_event(const EventTime event_time,
-                                const Callback callback,
-                                const CallbackArg callback_arg) noexcept {
+EventHandle EventQueue::schedule_event(const EventTime event_time,
+                                       const Callback callback,
+                                       const CallbackArg callback_arg) noexcept {
     // time should be at least larger than current time
     assert(event_time >= current_time);
 
+    if (deferring) {
+        deferred_events.emplace_back(event_time, EventCallback(callback, callback_arg));
+        return EventHandle();
+    }
+
+    // add event to the event list of event_time
+    auto* const event_list = find_or_create_event_list(event_time);
+    const auto event_index = event_list->add_event(callback, callback_arg);
+
+    return {event_list, event_list->get_generation(), event_index};
+}
+
+EventHandle EventQueue::schedule_event(const EventTime event_time, EventCallback callback) noexcept {
+    // time should be at least larger than current time
+    assert(event_time >= current_time);
+
+    if (deferring) {
+        deferred_events.emplace_back(event_time, std::move(callback));
+        return EventHandle();
+    }
+
+    // add event to the event list of event_time
+    auto* const event_list = find_or_create_event_list(event_time);
+    const auto event_index = event_list->add_event(std::move(callback));
+
+    return {event_list, event_list->get_generation(), event_index};
+}
+
+void EventQueue::schedule_time_end_event(EventCallback callback) noexcept {
+    assert(callback);
+
+    time_end_events.push_back(std::move(callback));
+}
+
+#ifdef ASTRA_NET_STATS
+const EventQueueStats& EventQueue::get_stats() const noexcept {
+    return stats;
+}
+#endif
+
+bool EventQueue::cancel_event(const EventHandle& event_handle) noexcept {
+    auto* const event_list = event_handle.event_list;
+
+    // a deferred event can't be cancelled
+    if (event_list == nullptr) {
+        return false;
+    }
+
+    // the list has been recycled since: the event was already invoked
+    if (event_list->get_generation() != event_handle.generation) {
+        return false;
+    }
+
+    if (!event_list->cancel_event(event_handle.event_index)) {
+        return false;
+    }
+
+    // the cancelled event may have been the only one left at the front
+    drop_cancelled_event_lists();
+    return true;
+}
+
+void EventQueue::schedule_events(const EventTime event_time,
+                                 const std::vector<std::pair<Callback, CallbackArg>>& handlers) noexcept {
+    // time should be at least larger than current time
+    assert(event_time >= current_time);
+
+    if (handlers.empty()) {
+        return;
+    }
+
+    if (deferring) {
+        for (const auto& [callback, callback_arg] : handlers) {
+            deferred_events.emplace_back(event_time, EventCallback(callback, callback_arg));
+        }
+        return;
+    }
+
+    // add all events to the event list of event_time at once
+    find_or_create_event_list(event_time)->add_events(handlers);
+}
+
+void EventQueue::defer_events() noexcept {
+    assert(!deferring);
+
+    deferring = true;
+}
+
+void EventQueue::flush_deferred_events() noexcept {
+    assert(deferring);
+
+    deferring = false;
+
+    // group the events by time, keeping their order within a time
+    std::stable_sort(deferred_events.begin(), deferred_events.end(),
+                     [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
+
+    // look up the event list of each distinct time once
+    for (auto it = deferred_events.begin(); it != deferred_events.end();) {
+        const auto event_time = it->first;
+        auto* const event_list = find_or_create_event_list(event_time);
+        for (; it != deferred_events.end() && it->first == event_time; ++it) {
+            event_list->add_event(std::move(it->second));
+        }
+    }
+    deferred_events.clear();
+}
+
+EventList* EventQueue::find_or_create_event_list(const EventTime event_time) noexcept {
     // find the entry to insert event
-    auto event_list_it = event_queue.begin();
-    while (event_list_it != event_queue.end() && event_list_it->get_event_time() < event_time) {
-        event_list_it++;
-    }
-
-    // There can be three scenarios:
-    // (1) event list matching with event_time is found
-    // (2) there's no event list matching with event_time
-    //   (2-1) the event_time requested is
-    //   larger than the largest event time scheduled
-    //   (2-2) the event_time requested is
-    //   smaller than the largest event time scheduled
-    // for both (2-1) or (2-2), a new event should be created
-    if (event_list_it == event_queue.end() || event_time < event_list_it->get_event_time()) {
-        // insert new event_list
-        event_list_it = event_queue.insert(event_list_it, EventList(event_time));
-    }
-
-    // now, whether (1) or (2), the entry to insert the event is found
-    // add event to event_list
-    event_list_it->add_event(callback, callback_arg);
+    auto event_list_it = event_lists.find(event_time);
+
+    // if there's no event list matching with event_time,
+    // a new event list should be created and its time registered
+    if (event_list_it == event_lists.end()) {
+        event_list_it = event_lists.emplace(event_time, acquire_event_list(event_time)).first;
+        event_times.push(event_time);
+    }
+
+    return event_list_it->second;
+}
+
+EventList* EventQueue::acquire_event_list(const EventTime event_time) noexcept {
+    // reuse a processed event list if one exists
+    if (!free_event_lists.empty()) {
+        auto* const event_list = free_event_lists.back();
+        free_event_lists.pop_back();
+        event_list->reset(event_time);
+        return event_list;
+    }
+
+    // otherwise, carve a new one out of the slab
+    event_list_slab.emplace_back(event_time, memory_counter);
+#ifdef ASTRA_NET_STATS
+    event_list_slab.back().set_stats(&stats);
+#endif
+    return &event_list_slab.back();
 }
@@ -0,0 +1,98 @@
+/******************************************************************************
+This source code is licensed under the MIT license found in the
+LICENSE file in the root directory of this source tree.
+*******************************************************************************/
+
+#include "common/EventTimeHeap.h"
+#include <cassert>
+
+using namespace NetworkAnalytical;
+
+EventTimeHeap::EventTimeHeap(std::shared_ptr<MemoryCounter> memory_counter) noexcept
+    : heap(TrackingAllocator<EventTime>(std::move(memory_counter))) {}
+
+bool EventTimeHeap::empty() const noexcept {
+    return heap.empty();
+}
+
+size_t EventTimeHeap::size() const noexcept {
+    return heap.size();
+}
+
+EventTime EventTimeHeap::top() const noexcept {
+    assert(!empty());
+
+    // root holds the earliest time
+    return heap.front();
+}
+
+void EventTimeHeap::push(const EventTime event_time) noexcept {
+    // append as a leaf, then restore the heap property
+    heap.push_back(event_time);
+    sift_up(heap.size() - 1);
+}
+
+void EventTimeHeap::pop() noexcept {
+    assert(!empty());
+
+    // move the last leaf to the root, then restore the heap property
+    heap.front() = heap.back();
+    heap.pop_back();
+
+    if (!heap.empty()) {
+        sift_down(0);
+    }
+}
+
+void EventTimeHeap::clear() noexcept {
+    heap.clear();
+}
+
+void EventTimeHeap::sift_up(size_t index) noexcept {
+    const auto event_time = heap[index];
+
+    // move parents down until the slot for event_time is found
+    while (index > 0) {
+        const auto parent = (index - 1) / arity;
+        if (heap[parent] <= event_time) {
+            break;
+        }
+
+        heap[index] = heap[parent];
+        index = parent;
+    }
+
+    heap[index] = event_time;
+}
+
+void EventTimeHeap::sift_down(size_t index) noexcept {
+    const auto heap_size = heap.size();
+    const auto event_time = heap[index];
+
+    while (true) {
+        // find the smallest child
+        const auto first_child = (index * arity) + 1;
+        if (first_child >= heap_size) {
+            break;
+        }
+
+        auto smallest_child = first_child;
+        const auto last_child = (first_child + arity < heap_size) ? (first_child + arity) : heap_size;
+        for (auto child = first_child + 1; child < last_child; child++) {
+            if (heap[child] < heap[smallest_child]) {
+                smallest_child = child;
+            }
+        }
+
+        // heap property holds
+        if (event_time <= heap[smallest_child]) {
+            break;
+        }
+
+        // move the smallest child up
+        heap[index] = heap[smallest_child];
+        index = smallest_child;
+    }
+
+    heap[index] = event_time;
+}
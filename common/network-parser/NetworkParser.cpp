@@ -4,28 +4,67 @@ LICENSE file in the root directory of this source tree.
 *******************************************************************************/
 
 #include "common/NetworkParser.h"
+#include "common/Hash.h"
 #include <cassert>
+#include <fstream>
 #include <iostream>
+#include <iterator>
 
 using namespace NetworkAnalytical;
 
-NetworkParser::NetworkParser(const std::string& path) noexcept : dims_count(-1) {
+NetworkParser::NetworkParser(const std::string& path) noexcept : dims_count(-1), config_hash(0) {
+    try {
+        // load network config file, and parse it
+        load_network_config(YAML::LoadFile(path), path);
+    } catch (const YAML::BadFile& e) {
+        // loading network config file failed
+        std::cerr << "[Error] (network/analytical) " << e.what() << std::endl;
+        std::exit(-1);
+    }
+
+    // key the config by its contents
+    auto config_file = std::ifstream(path, std::ios::binary);
+    const auto contents = std::string(std::istreambuf_iterator<char>(config_file), std::istreambuf_iterator<char>());
+    config_hash = hash_bytes(contents.data(), contents.size());
+}
+
+NetworkParser::NetworkParser(const YAML::Node& network_config, const std::string& path) noexcept
+    : dims_count(-1),
+      config_hash(0) {
+    load_network_config(network_config, path);
+
+    // key the config by its contents
+    const auto contents = YAML::Dump(network_config);
+    config_hash = hash_bytes(contents.data(), contents.size());
+}
+
+void NetworkParser::load_network_config(const YAML::Node& network_config, const std::string& path) noexcept {
     // initialize values
     npus_count_per_dim = {};
     bandwidth_per_dim = {};
     latency_per_dim = {};
     topology_per_dim = {};
 
-    try {
-        // load network config file
-        const auto network_config = YAML::LoadFile(path);
+    // parse network configs
+    parse_network_config_yml(network_config);
 
-        // parse network configs
-        parse_network_config_yml(network_config);
-    } catch (const YAML::BadFile& e) {
-        // loading network config file failed
-        std::cerr << "[Error] (network/analytical) " << e.what() << std::endl;
-        std::exit(-1);
+    // files named by the config are relative to it
+    const auto resolve_path = [&path](const std::string& named_path) {
+        const auto directory_end = path.find_last_of('/');
+        if (named_path.empty() || named_path.front() == '/' || directory_end == std::string::npos) {
+            return named_path;
+        }
+        return path.substr(0, directory_end + 1) + named_path;
+    };
+
+    // load the calibration overlay named by the config
+    if (network_config["calibration"]) {
+        load_calibration(resolve_path(network_config["calibration"].as<std::string>()));
+    }
+
+    // parse optional snapshot parameter
+    if (network_config["snapshot"]) {
+        snapshot_path = resolve_path(network_config["snapshot"].as<std::string>());
     }
 }
 
@@ -85,6 +124,108 @@ std::vector<int> NetworkParser::get_fattree_radix_per_dim() const noexcept {
     return fattree_radix_per_dim;
 }
 
+std::vector<std::vector<int>> NetworkParser::get_torus_shapes_per_dim() const noexcept {
+    assert(dims_count > 0);
+
+    return torus_shape_per_dim;
+}
+
+std::vector<int> NetworkParser::get_dragonfly_routers_per_group_per_dim() const noexcept {
+    assert(dims_count > 0);
+
+    return dragonfly_routers_per_group_per_dim;
+}
+
+std::vector<int> NetworkParser::get_dragonfly_hosts_per_router_per_dim() const noexcept {
+    assert(dims_count > 0);
+
+    return dragonfly_hosts_per_router_per_dim;
+}
+
+std::vector<int> NetworkParser::get_dragonfly_global_links_per_router_per_dim() const noexcept {
+    assert(dims_count > 0);
+
+    return dragonfly_global_links_per_router_per_dim;
+}
+
+std::vector<std::string> NetworkParser::get_dragonfly_arrangements_per_dim() const noexcept {
+    assert(dims_count > 0);
+
+    return dragonfly_arrangement_per_dim;
+}
+
+uint64_t NetworkParser::get_route_cache_capacity_mb() const noexcept {
+    return route_cache_capacity_mb;
+}
+
+std::string NetworkParser::get_dim_order() const noexcept {
+    return dim_order;
+}
+
+bool NetworkParser::get_precompute_routes() const noexcept {
+    return precompute_routes;
+}
+
+uint64_t NetworkParser::get_seed() const noexcept {
+    return seed;
+}
+
+std::string NetworkParser::get_snapshot_path() const noexcept {
+    return snapshot_path;
+}
+
+uint64_t NetworkParser::get_config_hash() const noexcept {
+    return config_hash;
+}
+
+void NetworkParser::load_calibration(const std::string& path) noexcept {
+    try {
+        parse_calibration_yml(YAML::LoadFile(path));
+    } catch (const YAML::BadFile& e) {
+        // loading calibration file failed
+        std::cerr << "[Error] (network/analytical) " << e.what() << std::endl;
+        std::exit(-1);
+    }
+}
+
+std::vector<double> NetworkParser::get_bandwidth_scales_per_dim() const noexcept {
+    assert(dims_count > 0);
+    assert(bandwidth_scale_per_dim.size() == dims_count);
+
+    return bandwidth_scale_per_dim;
+}
+
+std::vector<double> NetworkParser::get_latency_scales_per_dim() const noexcept {
+    assert(dims_count > 0);
+    assert(latency_scale_per_dim.size() == dims_count);
+
+    return latency_scale_per_dim;
+}
+
+void NetworkParser::parse_calibration_yml(const YAML::Node& calibration) noexcept {
+    if (calibration["bandwidth_scale"]) {
+        bandwidth_scale_per_dim = parse_vector<double>(calibration["bandwidth_scale"]);
+    }
+    if (calibration["latency_scale"]) {
+        latency_scale_per_dim = parse_vector<double>(calibration["latency_scale"]);
+    }
+
+    // scales should match the dimensions, and be positive
+    if (bandwidth_scale_per_dim.size() != dims_count || latency_scale_per_dim.size() != dims_count) {
+        std::cerr << "[Error] (network/analytical) " << "length of bandwidth_scale and latency_scale ("
+                  << bandwidth_scale_per_dim.size() << ", " << latency_scale_per_dim.size()
+                  << ") doesn't match with dims_count (" << dims_count << ")" << std::endl;
+        std::exit(-1);
+    }
+    for (auto dim = 0; dim < dims_count; dim++) {
+        if (bandwidth_scale_per_dim[dim] <= 0 || latency_scale_per_dim[dim] <= 0) {
+            std::cerr << "[Error] (network/analytical) " << "bandwidth_scale and latency_scale should be larger than 0"
+                      << std::endl;
+            std::exit(-1);
+        }
+    }
+}
+
 void NetworkParser::parse_network_config_yml(const YAML::Node& network_config) noexcept {
     // parse topology_per_dim
     const auto topology_names = parse_vector<std::string>(network_config["topology"]);
@@ -129,8 +270,88 @@ void NetworkParser::parse_network_config_yml(const YAML::Node& network_config) n
         fattree_radix_per_dim = std::vector<int>(dims_count, 4);
     }
 
+    // parse optional torus_shape parameter (for Torus topologies)
+    if (network_config["torus_shape"]) {
+        torus_shape_per_dim = parse_vector<std::vector<int>>(network_config["torus_shape"]);
+    } else {
+        // single ring of npus_count NPUs if not provided
+        for (const auto npus_count : npus_count_per_dim) {
+            torus_shape_per_dim.push_back({npus_count});
+        }
+    }
+
+    // parse optional dragonfly parameters (for Dragonfly topologies)
+    if (network_config["dragonfly_routers_per_group"]) {
+        dragonfly_routers_per_group_per_dim = parse_vector<int>(network_config["dragonfly_routers_per_group"]);
+    } else {
+        // default: balanced dragonfly of 4 routers per group, 2 hosts and 2 global links per router
+        dragonfly_routers_per_group_per_dim = std::vector<int>(dims_count, 4);
+    }
+    if (network_config["dragonfly_hosts_per_router"]) {
+        dragonfly_hosts_per_router_per_dim = parse_vector<int>(network_config["dragonfly_hosts_per_router"]);
+    } else {
+        dragonfly_hosts_per_router_per_dim = std::vector<int>(dims_count, 2);
+    }
+    if (network_config["dragonfly_global_links_per_router"]) {
+        dragonfly_global_links_per_router_per_dim =
+            parse_vector<int>(network_config["dragonfly_global_links_per_router"]);
+    } else {
+        dragonfly_global_links_per_router_per_dim = std::vector<int>(dims_count, 2);
+    }
+    if (network_config["dragonfly_arrangement"]) {
+        dragonfly_arrangement_per_dim = parse_vector<std::string>(network_config["dragonfly_arrangement"]);
+    } else {
+        dragonfly_arrangement_per_dim = std::vector<std::string>(dims_count, "");
+    }
+
+    // parse optional route_cache_capacity_mb parameter (shared by every dimension)
+    if (network_config["route_cache_capacity_mb"]) {
+        const auto route_cache_capacity = parse_vector<uint64_t>(network_config["route_cache_capacity_mb"]);
+        if (route_cache_capacity.size() != 1) {
+            std::cerr << "[Error] (network/analytical) " << "route_cache_capacity_mb should have a single value"
+                      << std::endl;
+            std::exit(-1);
+        }
+        route_cache_capacity_mb = route_cache_capacity[0];
+    }
+
+    // parse optional dim_order parameter (for multi-dimensional topologies)
+    if (network_config["dim_order"]) {
+        const auto dim_order_values = parse_vector<std::string>(network_config["dim_order"]);
+        if (dim_order_values.size() != 1) {
+            std::cerr << "[Error] (network/analytical) " << "dim_order should have a single value" << std::endl;
+            std::exit(-1);
+        }
+        dim_order = dim_order_values[0];
+    }
+
+    // parse optional precompute_routes parameter (shared by every dimension)
+    if (network_config["precompute_routes"]) {
+        try {
+            precompute_routes = network_config["precompute_routes"].as<bool>();
+        } catch (const YAML::BadConversion&) {
+            std::cerr << "[Error] (network/analytical) " << "precompute_routes should be true or false" << std::endl;
+            std::exit(-1);
+        }
+    }
+
+    // parse optional seed parameter (shared by every dimension)
+    if (network_config["seed"]) {
+        const auto seed_values = parse_vector<uint64_t>(network_config["seed"]);
+        if (seed_values.size() != 1) {
+            std::cerr << "[Error] (network/analytical) " << "seed should have a single value" << std::endl;
+            std::exit(-1);
+        }
+        seed = seed_values[0];
+    }
+
     // check the validity of the parsed network config
     check_validity();
+
+    // parse optional calibration values (uncalibrated by default)
+    bandwidth_scale_per_dim = std::vector<double>(dims_count, 1.0);
+    latency_scale_per_dim = std::vector<double>(dims_count, 1.0);
+    parse_calibration_yml(network_config);
 }
 
 TopologyBuildingBlock NetworkParser::parse_topology_name(const std::string& topology_name) noexcept {
@@ -160,6 +381,14 @@ TopologyBuildingBlock NetworkParser::parse_topology_name(const std::string& topo
         return TopologyBuildingBlock::FatTree;
     }
 
+    if (topology_name == "Torus") {
+        return TopologyBuildingBlock::Torus;
+    }
+
+    if (topology_name == "Dragonfly") {
+        return TopologyBuildingBlock::Dragonfly;
+    }
+
     // shouldn't reach here
     std::cerr << "[Error] (network/analytical) " << "Topology name " << topology_name << " not supported" << std::endl;
     std::exit(-1);
@@ -185,6 +414,66 @@ void NetworkParser::check_validity() const noexcept {
         std::exit(-1);
     }
 
+    // torus_shape should match the npus_count of each Torus dimension
+    if (dims_count != torus_shape_per_dim.size()) {
+        std::cerr << "[Error] (network/analytical) " << "length of torus_shape (" << torus_shape_per_dim.size()
+                  << ") doesn't match with dims_count (" << dims_count << ")" << std::endl;
+        std::exit(-1);
+    }
+    for (auto dim = 0; dim < dims_count; dim++) {
+        if (topology_per_dim[dim] != TopologyBuildingBlock::Torus) {
+            continue;
+        }
+        auto torus_npus_count = 1;
+        for (const auto extent : torus_shape_per_dim[dim]) {
+            if (extent <= 0) {
+                std::cerr << "[Error] (network/analytical) " << "torus_shape (" << extent
+                          << ") should be larger than 0" << std::endl;
+                std::exit(-1);
+            }
+            torus_npus_count *= extent;
+        }
+        if (torus_shape_per_dim[dim].empty() || torus_npus_count != npus_count_per_dim[dim]) {
+            std::cerr << "[Error] (network/analytical) " << "torus_shape of dim " << dim
+                      << " doesn't multiply to its npus_count (" << npus_count_per_dim[dim] << ")" << std::endl;
+            std::exit(-1);
+        }
+    }
+
+    // dragonfly parameters should match the dimensions,
+    // and the npus_count of each Dragonfly dimension should fill 2 to (global ports per group + 1) groups
+    if (dims_count != dragonfly_routers_per_group_per_dim.size() ||
+        dims_count != dragonfly_hosts_per_router_per_dim.size() ||
+        dims_count != dragonfly_global_links_per_router_per_dim.size() ||
+        dims_count != dragonfly_arrangement_per_dim.size()) {
+        std::cerr << "[Error] (network/analytical) " << "length of dragonfly parameters doesn't match with dims_count ("
+                  << dims_count << ")" << std::endl;
+        std::exit(-1);
+    }
+    for (auto dim = 0; dim < dims_count; dim++) {
+        if (topology_per_dim[dim] != TopologyBuildingBlock::Dragonfly) {
+            continue;
+        }
+        const auto routers_per_group = dragonfly_routers_per_group_per_dim[dim];
+        const auto hosts_per_router = dragonfly_hosts_per_router_per_dim[dim];
+        const auto global_links_per_router = dragonfly_global_links_per_router_per_dim[dim];
+        if (routers_per_group <= 0 || hosts_per_router <= 0 || global_links_per_router <= 0) {
+            std::cerr << "[Error] (network/analytical) " << "dragonfly parameters of dim " << dim
+                      << " should be larger than 0" << std::endl;
+            std::exit(-1);
+        }
+        const auto hosts_per_group = routers_per_group * hosts_per_router;
+        const auto groups_count = npus_count_per_dim[dim] / hosts_per_group;
+        if (npus_count_per_dim[dim] % hosts_per_group != 0 || groups_count < 2 ||
+            groups_count > (routers_per_group * global_links_per_router) + 1) {
+            std::cerr << "[Error] (network/analytical) " << "npus_count of dim " << dim << " ("
+                      << npus_count_per_dim[dim] << ") should fill 2 to "
+                      << (routers_per_group * global_links_per_router) + 1 << " dragonfly groups of "
+                      << hosts_per_group << " NPUs" << std::endl;
+            std::exit(-1);
+        }
+    }
+
     // npus_count should be all positive
     for (const auto& npus_count : npus_count_per_dim) {
         if (npus_count <= 1) {
@@ -29,6 +29,7 @@ BasicTopology::BasicTopology(const int npus_count,
     dims_count = 1;
     npus_count_per_dim.push_back(npus_count);
     bandwidth_per_dim.push_back(bandwidth);
+    flows_counts = std::make_unique<std::atomic<uint64_t>[]>(npus_count);
 
     // instantiate devices
     instantiate_devices();
@@ -37,6 +38,19 @@ BasicTopology::BasicTopology(const int npus_count,
 // default destructor
 BasicTopology::~BasicTopology() noexcept = default;
 
+void BasicTopology::reset() noexcept {
+    Topology::reset();
+    for (auto i = 0; i < npus_count; i++) {
+        flows_counts[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+uint64_t BasicTopology::next_flow_id(const DeviceId src) const noexcept {
+    assert(0 <= src && src < npus_count);
+
+    return flows_counts[src].fetch_add(1, std::memory_order_relaxed);
+}
+
 TopologyBuildingBlock BasicTopology::get_basic_topology_type() const noexcept {
     assert(basic_topology_type != TopologyBuildingBlock::Undefined);
 
@@ -0,0 +1,267 @@
+/******************************************************************************
+This source code is licensed under the MIT license found in the
+LICENSE file in the root directory of this source tree.
+*******************************************************************************/
+
+#include "congestion_aware/Dragonfly.h"
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <utility>
+
+using namespace NetworkAnalytical;
+using namespace NetworkAnalyticalCongestionAware;
+
+Dragonfly::Arrangement Dragonfly::str2Arrangement(const std::string& arrangement_str) noexcept {
+    if (arrangement_str == "Absolute" || arrangement_str.empty()) {
+        return Arrangement::Absolute;
+    } else if (arrangement_str == "Relative") {
+        return Arrangement::Relative;
+    } else if (arrangement_str == "Circulant") {
+        return Arrangement::Circulant;
+    } else {
+        std::cerr << "[Error] Unknown Dragonfly arrangement: " << arrangement_str << ". Defaulting to Absolute."
+                  << std::endl;
+        return Arrangement::Absolute;
+    }
+}
+
+Dragonfly::RoutingAlgorithm Dragonfly::str2RoutingAlgorithm(const std::string& algo_str) noexcept {
+    if (algo_str == "Minimal" || algo_str.empty()) {
+        return RoutingAlgorithm::Minimal;
+    } else if (algo_str == "Valiant") {
+        return RoutingAlgorithm::Valiant;
+    } else if (algo_str == "UGAL") {
+        return RoutingAlgorithm::Ugal;
+    } else {
+        std::cerr << "[Error] Unknown Dragonfly routing algorithm: " << algo_str << ". Defaulting to Minimal."
+                  << std::endl;
+        return RoutingAlgorithm::Minimal;
+    }
+}
+
+Dragonfly::Dragonfly(const int groups_count,
+                     const int routers_per_group,
+                     const int hosts_per_router,
+                     const int global_links_per_router,
+                     const Bandwidth bandwidth,
+                     const Latency latency,
+                     const std::string& arrangement_str,
+                     const std::string& routing_algorithm_str) noexcept
+    : BasicTopology(groups_count * routers_per_group * hosts_per_router,
+                    groups_count * routers_per_group * (hosts_per_router + 1),
+                    bandwidth,
+                    latency),
+      groups_count(groups_count),
+      routers_per_group(routers_per_group),
+      hosts_per_router(hosts_per_router),
+      global_links_per_router(global_links_per_router),
+      arrangement(str2Arrangement(arrangement_str)),
+      routing_algorithm(str2RoutingAlgorithm(routing_algorithm_str)),
+      arrangement_str(arrangement_str),
+      routing_algorithm_str(routing_algorithm_str) {
+    assert(routers_per_group > 0);
+    assert(hosts_per_router > 0);
+    assert(global_links_per_router > 0);
+    assert(2 <= groups_count && groups_count <= (routers_per_group * global_links_per_router) + 1);
+    assert(bandwidth > 0);
+    assert(latency >= 0);
+
+    basic_topology_type = TopologyBuildingBlock::Dragonfly;
+    static_routes = (routing_algorithm == RoutingAlgorithm::Minimal);
+
+    // connect hosts to their routers
+    for (auto host = 0; host < npus_count; host++) {
+        connect(host, get_router_id(host / hosts_per_router), bandwidth, latency);
+    }
+
+    // connect the routers of each group all-to-all by local links
+    for (auto group = 0; group < groups_count; group++) {
+        const auto first_router = group * routers_per_group;
+        for (auto i = 0; i < routers_per_group; i++) {
+            for (auto j = i + 1; j < routers_per_group; j++) {
+                connect(get_router_id(first_router + i), get_router_id(first_router + j), bandwidth, latency);
+            }
+        }
+    }
+
+    // connect each pair of groups by a global link, once from the lower group
+    const auto global_ports_count = routers_per_group * global_links_per_router;
+    for (auto group = 0; group < groups_count; group++) {
+        for (auto port = 0; port < global_ports_count; port++) {
+            const auto peer_group = get_peer_group(group, port);
+            if (peer_group <= group) {
+                continue;
+            }
+            const auto peer_port = get_gateway_port(peer_group, group);
+            const auto router = (group * routers_per_group) + (port / global_links_per_router);
+            const auto peer_router = (peer_group * routers_per_group) + (peer_port / global_links_per_router);
+            connect(get_router_id(router), get_router_id(peer_router), bandwidth, latency);
+        }
+    }
+}
+
+Route Dragonfly::route(const DeviceId src, const DeviceId dest) const noexcept {
+    // random routes are keyed by the next flow of src
+    const auto flow_id = (routing_algorithm == RoutingAlgorithm::Minimal) ? 0 : next_flow_id(src);
+    auto rng = CounterRng(routing_seed, src, dest, flow_id);
+    return route(src, dest, rng);
+}
+
+Route Dragonfly::route(const DeviceId src, const DeviceId dest, CounterRng& rng) const noexcept {
+    // assert npus are in valid range
+    assert(0 <= src && src < npus_count);
+    assert(0 <= dest && dest < npus_count);
+
+    // construct empty route
+    auto route = Route();
+    if (src == dest) {
+        route.push_back(devices[src]);
+        return route;
+    }
+
+    const auto src_router = src / hosts_per_router;
+    const auto dest_router = dest / hosts_per_router;
+    const auto same_group = (src_router / routers_per_group) == (dest_router / routers_per_group);
+
+    // pick the router path
+    auto path = RouterPath{src, get_router_id(src_router)};
+    if (routing_algorithm == RoutingAlgorithm::Minimal || same_group) {
+        append_minimal_path(src_router, dest_router, path);
+        path.push_back(dest);
+    } else if (routing_algorithm == RoutingAlgorithm::Valiant) {
+        append_valiant_path(src_router, dest_router, path, rng);
+        path.push_back(dest);
+    } else {
+        // UGAL: take the Valiant path only if it's less loaded, weighted by its length
+        auto valiant_path = path;
+        append_minimal_path(src_router, dest_router, path);
+        path.push_back(dest);
+        append_valiant_path(src_router, dest_router, valiant_path, rng);
+        valiant_path.push_back(dest);
+        if (compute_path_cost(valiant_path) < compute_path_cost(path)) {
+            path = std::move(valiant_path);
+        }
+    }
+
+    // construct the route
+    for (const auto device : path) {
+        route.push_back(devices[device]);
+    }
+    return route;
+}
+
+std::unique_ptr<BasicTopology> Dragonfly::clone() const noexcept {
+    return std::make_unique<Dragonfly>(groups_count, routers_per_group, hosts_per_router, global_links_per_router,
+                                       bandwidth, latency, arrangement_str, routing_algorithm_str);
+}
+
+int Dragonfly::get_peer_group(const int group, const int port) const noexcept {
+    assert(0 <= group && group < groups_count);
+    assert(0 <= port && port < routers_per_group * global_links_per_router);
+
+    // with fewer groups than global ports, the last ports are unused
+    if (port >= groups_count - 1) {
+        return -1;
+    }
+
+    switch (arrangement) {
+    case Arrangement::Relative:
+        return (group + port + 1) % groups_count;
+    case Arrangement::Circulant: {
+        // offset o on ports 2o - 2 (forward) and 2o - 1 (backward)
+        const auto offset = (port / 2) + 1;
+        return (port % 2 == 0) ? (group + offset) % groups_count : (group - offset + groups_count) % groups_count;
+    }
+    default:
+        return (port < group) ? port : port + 1;
+    }
+}
+
+int Dragonfly::get_gateway_port(const int group, const int peer_group) const noexcept {
+    assert(0 <= group && group < groups_count);
+    assert(0 <= peer_group && peer_group < groups_count);
+    assert(group != peer_group);
+
+    switch (arrangement) {
+    case Arrangement::Relative:
+        return (peer_group - group - 1 + groups_count) % groups_count;
+    case Arrangement::Circulant: {
+        // forward up to half the groups away, backward beyond
+        const auto offset = (peer_group - group + groups_count) % groups_count;
+        return (offset <= groups_count / 2) ? 2 * (offset - 1) : (2 * (groups_count - offset)) - 1;
+    }
+    default:
+        return (peer_group < group) ? peer_group : peer_group - 1;
+    }
+}
+
+DeviceId Dragonfly::get_router_id(const int router) const noexcept {
+    assert(0 <= router && router < groups_count * routers_per_group);
+
+    return npus_count + router;
+}
+
+void Dragonfly::append_minimal_path(const int from, const int to, RouterPath& path) const noexcept {
+    if (from == to) {
+        return;
+    }
+
+    // within a group: a local hop
+    const auto from_group = from / routers_per_group;
+    const auto to_group = to / routers_per_group;
+    if (from_group == to_group) {
+        path.push_back(get_router_id(to));
+        return;
+    }
+
+    // across groups: to the gateway, over its global link, then to the dest router
+    const auto gateway = (from_group * routers_per_group) +
+                         (get_gateway_port(from_group, to_group) / global_links_per_router);
+    const auto peer = (to_group * routers_per_group) + (get_gateway_port(to_group, from_group) / global_links_per_router);
+    if (gateway != from) {
+        path.push_back(get_router_id(gateway));
+    }
+    path.push_back(get_router_id(peer));
+    if (peer != to) {
+        path.push_back(get_router_id(to));
+    }
+}
+
+void Dragonfly::append_valiant_path(const int from,
+                                    const int to,
+                                    RouterPath& path,
+                                    CounterRng& rng) const noexcept {
+    const auto from_group = from / routers_per_group;
+    const auto to_group = to / routers_per_group;
+    assert(from_group != to_group);
+
+    // no group to go through
+    if (groups_count <= 2) {
+        append_minimal_path(from, to, path);
+        return;
+    }
+
+    // random group other than the src and dest ones, then a random router of it
+    auto group = static_cast<int>(rng.uniform(static_cast<uint32_t>(groups_count - 2)));
+    for (const auto skipped_group : {std::min(from_group, to_group), std::max(from_group, to_group)}) {
+        if (group >= skipped_group) {
+            group++;
+        }
+    }
+    const auto router = static_cast<int>(rng.uniform(static_cast<uint32_t>(routers_per_group)));
+    const auto intermediate = (group * routers_per_group) + router;
+
+    append_minimal_path(from, intermediate, path);
+    append_minimal_path(intermediate, to, path);
+}
+
+ChunkSize Dragonfly::compute_path_cost(const RouterPath& path) const noexcept {
+    assert(path.size() >= 2);
+
+    auto backlog = static_cast<ChunkSize>(0);
+    for (auto i = static_cast<size_t>(0); i + 1 < path.size(); i++) {
+        backlog += get_link_backlog(path[i], path[i + 1]);
+    }
+    return backlog * (path.size() - 1);
+}
@@ -4,6 +4,8 @@ LICENSE file in the root directory of this source tree.
 *******************************************************************************/
 
 #include "congestion_aware/ExpanderGraph.h"
+#include "common/ExpanderGraphFile.h"
+#include "common/Hash.h"
 #include <cassert>
 #include <ctime>
 #include <cstdlib>
@@ -12,41 +14,38 @@ LICENSE file in the root directory of this source tree.
 #include <fstream>
 #include <iostream>
 #include <stdexcept>
-#include <random>
 #include <functional>
 #include <set>
-#include "../../../helper/json/json.hpp"
+#include <atomic>
+#include <thread>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <string>
+#include <unordered_map>
 
 using namespace NetworkAnalytical;
 using namespace NetworkAnalyticalCongestionAware;
 
+namespace {
 
-void ExpanderGraph::connect(DeviceId src, DeviceId dest) {
-    assert(0 <= src && src < npus_count);
-    assert(0 <= dest && dest < npus_count);
-    if (src == dest) {
-        std::cout << "[Error] Cannot connect a node to itself: " << src << std::endl;
-        return;
-        // throw std::invalid_argument("Cannot connect a node to itself");
-    }
-    if (std::find(adjacency_list[src].begin(), adjacency_list[src].end(), dest) != adjacency_list[src].end()) {
-        std::cout << "[Error] Connection already exists between nodes " << src << " and " << dest << std::endl;
-        return;
-        // throw std::invalid_argument("Connection already exists between the specified nodes");
-    }
-    // create bidirectional connection between src and dest in adjacency list
-    adjacency_list[src].push_back(dest);
-    adjacency_list[dest].push_back(src);
-    
-    // create actual Device links (bidirectional)
-    Topology::connect(src, dest, bandwidth, latency, true);
-}
+/// guards shared_k_shortest_paths
+std::mutex shared_k_shortest_paths_mutex;
+
+/// map[key] -> k-shortest paths held by ExpanderGraphs of the process, so topologies of the same graph share them
+std::unordered_map<uint64_t, std::weak_ptr<const KShortestPaths>> shared_k_shortest_paths;
+
+}  // namespace
 
 ExpanderGraph::RoutingAlgorithm ExpanderGraph::str2RoutingAlgorithm(const std::string& algo_str) {
     if (algo_str == "ShortestPath" || algo_str.empty()) {
         return RoutingAlgorithm::ShortestPath;
     } else if (algo_str == "RandomTopK") {
         return RoutingAlgorithm::RandomTopK;
+    } else if (algo_str == "Adaptive") {
+        return RoutingAlgorithm::Adaptive;
     } else {
         std::cerr << "[Error] Unknown routing algorithm: " << algo_str << ". Defaulting to ShortestPath." << std::endl;
         return RoutingAlgorithm::ShortestPath;
@@ -62,6 +61,10 @@ ExpanderGraph::ExpanderGraph(const int npus_count, const Bandwidth bandwidth, co
     int degree = 0;
 
     this->routing_algorithm = str2RoutingAlgorithm(routing_algorithm);
+    this->inputfile_path = inputfile;
+    this->routing_algorithm_str = routing_algorithm;
+    this->use_resiliency = use_resiliency;
+    static_routes = (this->routing_algorithm == RoutingAlgorithm::ShortestPath);
 
     std::string inputfile_str = std::string(inputfile);
     // set the building block type
@@ -72,20 +75,16 @@ ExpanderGraph::ExpanderGraph(const int npus_count, const Bandwidth bandwidth, co
         adjacency_list[i] = std::vector<DeviceId>();
     }
 
-    // load graph from input json file
+    // load graph from input file, JSON or binary edge list
     if (!inputfile_str.empty()) {
-        std::ifstream file(inputfile_str);
-        if (!file.is_open()) {
-            std::cerr << "[Error] Failed to open expander graph JSON file: " << inputfile_str << std::endl;
+        auto graph_file = ExpanderGraphFile();
+        if (!ExpanderGraphFile::load(inputfile_str, graph_file)) {
+            std::cerr << "[Error] Failed to load expander graph file: " << inputfile_str << std::endl;
             std::exit(-1);
         }
 
-        nlohmann::json j;
-        file >> j;
-        file.close();
-
-        int node_count = j["node_count"];
-        degree = j["degree"];
+        int node_count = graph_file.get_node_count();
+        degree = graph_file.get_degree();
         
         // Check if we should use split graph (when npus_count is exactly half)
         std::cout << "Use Resiliency: " << use_resiliency
@@ -98,46 +97,13 @@ ExpanderGraph::ExpanderGraph(const int npus_count, const Bandwidth bandwidth, co
         } else {
             use_split = ((npus_count + (npus_count/8)) * 2 == node_count);
         }
+        auto edges = std::vector<ExpanderGraphFile::Edge>();
         if (use_split) {
             std::cout << "[ExpanderGraph] Using split graph: " << npus_count << " NPUs from " 
                       << node_count << " node graph" << std::endl;
             
-            // Determine which group to use (group A: first half)
-            auto group_a = j["groups"]["A"].get<std::vector<int>>();
-            
-            // Build node mapping: original node ID -> local NPU ID (0 to npus_count-1)
-            std::map<int, int> node_to_npu;
-            std::set<int> group_a_set;
-            for (size_t i = 0; i < group_a.size(); ++i) {
-                node_to_npu[group_a[i]] = i;
-                group_a_set.insert(group_a[i]);
-            }
-            
-            // Use connected_graph_adjacency to build the graph
-            // This is an adjacency list where index i contains neighbors of node i
-            auto adjacency = j["split_graph_adjacency"];
-            
-            for (size_t node_id = 0; node_id < adjacency.size(); ++node_id) {
-                // Only process nodes in group A
-                if (group_a_set.find(node_id) == group_a_set.end()) {
-                    continue;
-                }
-                
-                int npu_id = node_to_npu[node_id];
-                auto neighbors = adjacency[node_id].get<std::vector<int>>();
-                
-                for (int neighbor_node_id : neighbors) {
-                    // Only add edges between nodes in group A
-                    if (group_a_set.find(neighbor_node_id) != group_a_set.end()) {
-                        int neighbor_npu_id = node_to_npu[neighbor_node_id];
-                        // connect() adds bidirectional edges, so only connect if npu_id < neighbor_npu_id
-                        // to avoid adding each edge twice
-                        if (npu_id < neighbor_npu_id) {
-                            this->connect(npu_id, neighbor_npu_id);
-                        }
-                    }
-                }
-            }
+            // edges between the nodes of group A (first half), renumbered by their position in it
+            edges = graph_file.get_split_graph_edges();
         } else {
             // Use full graph
             if (!use_resiliency && npus_count != node_count) {
@@ -152,27 +118,30 @@ ExpanderGraph::ExpanderGraph(const int npus_count, const Bandwidth bandwidth, co
             }
             
             std::cout << "[ExpanderGraph] Using full graph: " << node_count << " nodes" << std::endl;
-            
-            // Use connected_graph_adjacency to build the full graph
-            auto adjacency = j["connected_graph_adjacency"];
-            
-            for (size_t node_id = 0; node_id < adjacency.size(); ++node_id) {
-                auto neighbors = adjacency[node_id].get<std::vector<int>>();
-                
-                for (int neighbor_id : neighbors) {
-                    // connect() adds bidirectional edges, so only connect if node_id < neighbor_id
-                    // to avoid adding each edge twice
-                    if ((int)node_id < neighbor_id) {
-                        this->connect(node_id, neighbor_id);
-                    }
-                }
+            edges = graph_file.get_connected_graph_edges();
+        }
+
+        // create the links (bidirectional) in file order, so ports follow the adjacency rows
+        for (const auto& [src, dest] : edges) {
+            if (dest >= devices_count) {
+                std::cerr << "[Error] Expander graph node " << dest << " exceeds the " << devices_count
+                          << " devices of the topology" << std::endl;
+                std::exit(-1);
             }
+            Topology::connect(src, dest, bandwidth, latency, true);
+        }
+
+        // searches run on the immutable CSR form of the graph
+        graph = CsrGraph(devices_count, edges);
+        for (DeviceId i = 0; i < devices_count; ++i) {
+            const auto [first_neighbor, last_neighbor] = graph.get_neighbors(i);
+            adjacency_list[i].assign(first_neighbor, last_neighbor);
         }
         
         // Verify the graph degree
         for (int i = 0; i < npus_count; ++i) {
-            if (adjacency_list[i].size() != degree) {
-                std::cerr << "[Warning] Node " << i << " has degree " << adjacency_list[i].size() 
+            if (graph.get_degree(i) != degree) {
+                std::cerr << "[Warning] Node " << i << " has degree " << graph.get_degree(i) 
                           << " but expected " << degree << std::endl;
             }
         }
@@ -183,57 +152,196 @@ ExpanderGraph::ExpanderGraph(const int npus_count, const Bandwidth bandwidth, co
 }
 
 std::unique_ptr<BasicTopology> ExpanderGraph::clone() const noexcept {
-    return std::make_unique<ExpanderGraph>(npus_count, bandwidth, latency, inputfile_path, routing_algorithm_str,
-                                           use_resiliency);
+    auto cloned = std::make_unique<ExpanderGraph>(npus_count, bandwidth, latency, inputfile_path, routing_algorithm_str,
+                                                  use_resiliency);
+
+    // the graph is the same (the clone has no failures), so are the tables
+    cloned->k_shortest_paths = k_shortest_paths;
+    if (failed_links.empty() && failed_devices.empty()) {
+        cloned->table_devices_count = table_devices_count;
+        cloned->next_hop_table = next_hop_table;
+        cloned->distance_table = distance_table;
+    }
+    return cloned;
 }
 
-unsigned int ExpanderGraph::get_distance(const DeviceId src, const DeviceId dest, std::set<DeviceId> visited, unsigned int current_distance) const noexcept {
-    // Use distance cache
-    std::pair<DeviceId, DeviceId> node_pair = std::make_pair(src, dest);
-    if (distance_cache.find(node_pair) != distance_cache.end()) {
-        return distance_cache[node_pair];
-    }
-    
-    if (src == dest) {
-        return 0;
+void ExpanderGraph::precompute_k_shortest_paths(const int threads_count) noexcept {
+    assert(threads_count >= 0);
+    assert(!inputfile_path.empty());
+
+    // the paths depend on the graph file, the resiliency mode (which selects the nodes) and the NPUs count
+    auto file = std::ifstream(inputfile_path, std::ios::binary);
+    const auto contents = std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    auto key = hash_bytes(contents.data(), contents.size());
+    const char mode[] = {static_cast<char>(use_resiliency ? 1 : 0)};
+    key = hash_bytes(mode, sizeof(mode), key);
+    key = hash_bytes(reinterpret_cast<const char*>(&npus_count), sizeof(npus_count), key);
+
+    // share the paths of another topology of the same graph, if any
+    const auto lock = std::lock_guard<std::mutex>(shared_k_shortest_paths_mutex);
+    auto& shared_paths = shared_k_shortest_paths[key];
+    k_shortest_paths = shared_paths.lock();
+    if (k_shortest_paths != nullptr) {
+        return;
     }
-    
-    // Dijkstra's algorithm using priority queue
-    std::vector<unsigned int> dist(npus_count, UINT32_MAX);
-    std::priority_queue<std::pair<unsigned int, DeviceId>, 
-                       std::vector<std::pair<unsigned int, DeviceId>>,
-                       std::greater<std::pair<unsigned int, DeviceId>>> pq;
-    
-    dist[src] = 0;
-    pq.push({0, src});
-    
-    while (!pq.empty()) {
-        auto [d, u] = pq.top();
-        pq.pop();
-        
-        if (u == dest) {
-            distance_cache[node_pair] = d;
-            return d;
-        }
-        
-        if (d > dist[u]) {
-            continue;
+
+    const auto sidecar_path = inputfile_path + ".ksp";
+    auto paths = std::make_shared<KShortestPaths>();
+    if (KShortestPaths::load(sidecar_path, key, k_max_paths, *paths) && paths->get_endpoints_count() == npus_count) {
+        std::cout << "[ExpanderGraph] Loaded k-shortest paths from " << sidecar_path << std::endl;
+    } else {
+        *paths = KShortestPaths(graph, npus_count, k_max_paths, threads_count);
+        if (!paths->save(sidecar_path, key)) {
+            std::cerr << "[Warning] Failed to save k-shortest paths to " << sidecar_path << std::endl;
         }
-        
-        for (const auto& neighbor : adjacency_list.at(u)) {
-            unsigned int new_dist = dist[u] + 1;
-            if (new_dist < dist[neighbor]) {
-                dist[neighbor] = new_dist;
-                pq.push({new_dist, neighbor});
+    }
+
+    k_shortest_paths = std::move(paths);
+    shared_paths = k_shortest_paths;
+}
+
+void ExpanderGraph::precompute_shortest_paths(int threads_count) noexcept {
+    assert(threads_count >= 0);
+
+    const auto nodes_count = graph.get_nodes_count();
+    if (nodes_count > UINT16_MAX) {
+        std::cerr << "[Error] (network/analytical/congestion_aware) "
+                  << "ExpanderGraph with " << nodes_count << " devices is too large for shortest-path tables" << std::endl;
+        std::exit(-1);
+    }
+
+    const auto table_size = static_cast<size_t>(nodes_count) * static_cast<size_t>(nodes_count);
+    // every row is reset by its BFS
+    next_hop_table.resize(table_size);
+    distance_table.resize(table_size);
+
+    auto sources = std::vector<DeviceId>(nodes_count);
+    std::iota(sources.begin(), sources.end(), 0);
+    fill_shortest_path_rows(sources, threads_count);
+    table_devices_count = nodes_count;
+}
+
+void ExpanderGraph::fill_shortest_path_rows(const std::vector<DeviceId>& sources, int threads_count) noexcept {
+    assert(threads_count >= 0);
+
+    const auto nodes_count = graph.get_nodes_count();
+    const auto& neighbor_offsets = graph.get_offsets();
+    const auto& neighbors = graph.get_edge_targets();
+    const auto sources_count = static_cast<int>(sources.size());
+
+    // one BFS per source, each filling its own row
+    auto next_source = std::atomic<int>(0);
+    auto too_long_path_found = std::atomic<bool>(false);
+    const auto bfs_worker = [&]() noexcept {
+        auto queue = std::vector<uint16_t>(nodes_count);
+        for (auto index = next_source++; index < sources_count; index = next_source++) {
+            const auto src = sources[index];
+            auto* const next_hops = next_hop_table.data() + (static_cast<size_t>(src) * nodes_count);
+            auto* const distances = distance_table.data() + (static_cast<size_t>(src) * nodes_count);
+            std::fill(next_hops, next_hops + nodes_count, 0);
+            std::fill(distances, distances + nodes_count, unreachable_distance);
+
+            distances[src] = 0;
+            next_hops[src] = static_cast<uint16_t>(src);
+            auto head = 0;
+            auto tail = 0;
+            queue[tail++] = static_cast<uint16_t>(src);
+
+            while (head < tail) {
+                const auto current = queue[head++];
+                for (auto i = neighbor_offsets[current]; i < neighbor_offsets[current + 1]; i++) {
+                    const auto neighbor = static_cast<uint16_t>(neighbors[i]);
+                    if (distances[neighbor] != unreachable_distance) {
+                        continue;
+                    }
+                    if (distances[current] + 1 >= unreachable_distance) {
+                        too_long_path_found = true;
+                        continue;
+                    }
+
+                    // the first hop is inherited from the parent, except for src's own neighbors
+                    distances[neighbor] = static_cast<uint8_t>(distances[current] + 1);
+                    next_hops[neighbor] = (current == src) ? neighbor : next_hops[current];
+                    queue[tail++] = neighbor;
+                }
             }
         }
+    };
+
+    if (threads_count == 0) {
+        threads_count = static_cast<int>(std::max(1U, std::thread::hardware_concurrency()));
+    }
+    threads_count = std::min(threads_count, std::max(sources_count, 1));
+
+    std::vector<std::thread> threads;
+    for (auto i = 1; i < threads_count; i++) {
+        threads.emplace_back(bfs_worker);
+    }
+    bfs_worker();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    if (too_long_path_found) {
+        std::cerr << "[Error] (network/analytical/congestion_aware) "
+                  << "ExpanderGraph has paths too long for shortest-path tables" << std::endl;
+        std::exit(-1);
+    }
+}
+
+void ExpanderGraph::precompute_routes(const int threads_count) noexcept {
+    assert(threads_count >= 0);
+
+    if (!static_routes) {
+        return;
+    }
+
+    // every route is then a table walk
+    if (!shortest_paths_precomputed()) {
+        precompute_shortest_paths(threads_count);
+    }
+    Topology::precompute_routes(threads_count);
+}
+
+bool ExpanderGraph::shortest_paths_precomputed() const noexcept {
+    return table_devices_count > 0;
+}
+
+MemoryReport ExpanderGraph::memory_report() const noexcept {
+    auto report = Topology::memory_report();
+    report.distance_cache = MemoryUsage::of(*distance_cache_memory);
+    report.shortest_route_cache = MemoryUsage::of(*shortest_route_cache_memory);
+    report.topk_route_cache = MemoryUsage::of(*topk_route_cache_memory);
+    return report;
+}
+
+const CsrGraph& ExpanderGraph::get_graph() const noexcept {
+    return graph;
+}
+
+unsigned int ExpanderGraph::get_distance(const DeviceId src, const DeviceId dest, std::set<DeviceId> visited, unsigned int current_distance) const noexcept {
+    if (shortest_paths_precomputed()) {
+        assert(0 <= src && src < table_devices_count);
+        assert(0 <= dest && dest < table_devices_count);
+        const auto distance = distance_table[(static_cast<size_t>(src) * table_devices_count) + dest];
+        assert(distance != unreachable_distance);
+        return distance;
     }
-    
-    assert(dist[dest] != UINT32_MAX);
-    assert(dist[dest] > 0);
-    distance_cache[node_pair] = dist[dest];
-    return dist[dest];
-}   
+
+    // all pairs are computed at once on the first query
+    std::call_once(distance_matrix_computed, [this] {
+        if (distance_matrix.empty()) {
+            distance_matrix = DistanceMatrix(graph, 0, distance_cache_memory);
+        }
+    });
+
+    const auto distance = distance_matrix.get_distance(src, dest);
+    assert(distance != DistanceMatrix::unreachable_distance);
+    if (distance == DistanceMatrix::unreachable_distance) {
+        return UINT32_MAX;
+    }
+    return distance;
+}
 
 int ExpanderGraph::compute_hops_count(const DeviceId src, const DeviceId dest) const noexcept {
     assert(0 <= src && src < npus_count);
@@ -244,11 +352,23 @@ int ExpanderGraph::compute_hops_count(const DeviceId src, const DeviceId dest) c
 }
 
 Route ExpanderGraph::route(DeviceId src, DeviceId dest) const noexcept {
+    // random routes are keyed by the next flow of src
+    if (routing_algorithm == RoutingAlgorithm::RandomTopK) {
+        auto rng = CounterRng(routing_seed, src, dest, next_flow_id(src));
+        return route_random_topk(src, dest, rng);
+    }
+    auto rng = CounterRng(routing_seed, src, dest, 0);
+    return route(src, dest, rng);
+}
+
+Route ExpanderGraph::route(const DeviceId src, const DeviceId dest, CounterRng& rng) const noexcept {
     switch(routing_algorithm) {
         case RoutingAlgorithm::ShortestPath:
             return route_shortest_path(src, dest);
         case RoutingAlgorithm::RandomTopK:
-            return route_random_topk(src, dest);
+            return route_random_topk(src, dest, rng);
+        case RoutingAlgorithm::Adaptive:
+            return route_adaptive(src, dest);
         default:
             // default to shortest path
             return route_shortest_path(src, dest);
@@ -260,12 +380,15 @@ Route ExpanderGraph::route_shortest_path(DeviceId src, DeviceId dest) const noex
     assert(0 <= src && src < npus_count);
     assert(0 <= dest && dest < npus_count);
 
+    if (shortest_paths_precomputed()) {
+        return route_from_tables(src, dest);
+    }
     
-    std::pair<DeviceId, DeviceId> node_pair = std::make_pair(src, dest);
+    const auto node_pair = ShardedMap<CachedPath>::make_pair_key(src, dest);
     // Check route cache
-    if (shortest_route_cache.find(node_pair) != shortest_route_cache.end()) {
+    if (const auto* const cached_path = shortest_route_cache.find(node_pair)) {
         Route cached_route;
-        for (const auto& device_id : shortest_route_cache.at(node_pair)) {
+        for (const auto& device_id : *cached_path) {
             if (device_id >= static_cast<DeviceId>(devices.size())) {
                 std::cerr << "[ERROR] device_id " << device_id << " >= devices.size() " << devices.size() << std::endl;
                 std::exit(-1);
@@ -279,20 +402,22 @@ Route ExpanderGraph::route_shortest_path(DeviceId src, DeviceId dest) const noex
     auto route = Route();
 
     // route via shortest path (BFS)
-    std::map<DeviceId, DeviceId> parent; // to reconstruct path
-    std::set<DeviceId> visited;
+    std::vector<DeviceId> parent(graph.get_nodes_count(), -1); // to reconstruct path
+    std::vector<bool> visited(graph.get_nodes_count(), false);
     std::vector<DeviceId> queue;
+    size_t queue_head = 0;
     queue.push_back(src);
-    visited.insert(src);
+    visited[src] = true;
     parent[src] = src;
     bool found = false;
-    while (!queue.empty() && !found) {
-        DeviceId current = queue.front();
-        queue.erase(queue.begin());
-
-        for (const auto& neighbor : adjacency_list.at(current)) {
-            if (visited.find(neighbor) == visited.end()) {
-                visited.insert(neighbor);
+    while (queue_head < queue.size() && !found) {
+        DeviceId current = queue[queue_head++];
+
+        const auto [first_neighbor, last_neighbor] = graph.get_neighbors(current);
+        for (auto neighbor_it = first_neighbor; neighbor_it != last_neighbor; neighbor_it++) {
+            const auto neighbor = *neighbor_it;
+            if (!visited[neighbor]) {
+                visited[neighbor] = true;
                 parent[neighbor] = current;
                 queue.push_back(neighbor);
 
@@ -325,44 +450,252 @@ Route ExpanderGraph::route_shortest_path(DeviceId src, DeviceId dest) const noex
     }
 
     // Cache the computed route
-    std::vector<DeviceId> device_id_path;
+    auto device_id_path = CachedPath(TrackingAllocator<DeviceId>(shortest_route_cache_memory));
     for (const auto& device_ptr : route) {
         device_id_path.push_back(device_ptr->get_id());
     }
-    shortest_route_cache[node_pair] = device_id_path;
+    shortest_route_cache.emplace(node_pair, std::move(device_id_path));
+
+    return route;
+}
+
+Route ExpanderGraph::route_from_tables(const DeviceId src, const DeviceId dest) const noexcept {
+    assert(shortest_paths_precomputed());
+
+    // no path: same as the search, an empty route
+    const auto row = static_cast<size_t>(src) * table_devices_count;
+    const auto distance = distance_table[row + dest];
+    if (distance == unreachable_distance) {
+        return Route();
+    }
 
+    // follow the next hops towards dest
+    auto route = Route();
+    auto current = src;
+    route.push_back(devices[current]);
+    while (current != dest) {
+        current = next_hop_table[(static_cast<size_t>(current) * table_devices_count) + dest];
+        route.push_back(devices[current]);
+    }
+
+    assert(route.size() == static_cast<size_t>(distance) + 1);
     return route;
 }
 
+bool ExpanderGraph::uses_precomputed_paths() const noexcept {
+    return k_shortest_paths != nullptr && failed_links.empty() && failed_devices.empty();
+}
+
+void ExpanderGraph::rebuild_graph() noexcept {
+    auto active_adjacency_list = std::map<DeviceId, std::vector<DeviceId>>();
+    for (const auto& [device, neighbors] : adjacency_list) {
+        auto& active_neighbors = active_adjacency_list[device];
+        if (is_device_failed(device)) {
+            continue;
+        }
+        for (const auto neighbor : neighbors) {
+            if (!is_link_failed(device, neighbor)) {
+                active_neighbors.push_back(neighbor);
+            }
+        }
+    }
+    graph = CsrGraph(active_adjacency_list);
+}
 
-Route ExpanderGraph::route_random_topk(DeviceId src, DeviceId dest) const noexcept {
+std::vector<int> ExpanderGraph::compute_distances_from(const DeviceId src) const noexcept {
+    auto distances = std::vector<int>(graph.get_nodes_count(), -1);
+    auto queue = std::vector<DeviceId>{src};
+    distances[src] = 0;
+    for (auto head = static_cast<size_t>(0); head < queue.size(); head++) {
+        const auto current = queue[head];
+        const auto [first_neighbor, last_neighbor] = graph.get_neighbors(current);
+        for (auto neighbor = first_neighbor; neighbor != last_neighbor; neighbor++) {
+            if (distances[*neighbor] < 0) {
+                distances[*neighbor] = distances[current] + 1;
+                queue.push_back(*neighbor);
+            }
+        }
+    }
+    return distances;
+}
+
+bool ExpanderGraph::path_crosses_failure(const CachedPath& path) const noexcept {
+    if (!path.empty() && is_device_failed(path.front())) {
+        return true;
+    }
+    for (auto i = static_cast<size_t>(0); i + 1 < path.size(); i++) {
+        if (is_link_failed(path[i], path[i + 1])) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ExpanderGraph::update_failures(const DeviceId src, const DeviceId dest, const bool failed) noexcept {
+    // table rows a link can change: those where its ends are at different distances,
+    // as BFS never goes through a link between nodes at the same distance
+    auto affected_rows = std::vector<DeviceId>();
+    if (shortest_paths_precomputed()) {
+        for (DeviceId row = 0; row < table_devices_count; row++) {
+            const auto* const distances = distance_table.data() + (static_cast<size_t>(row) * table_devices_count);
+            if (dest < 0 || distances[src] != distances[dest]) {
+                affected_rows.push_back(row);
+            }
+        }
+    }
+
+    rebuild_graph();
+
+    // drop the cached paths the change invalidates
+    if (failed) {
+        shortest_route_cache.erase_if([this](const uint64_t, const CachedPath& path) {
+            return path_crosses_failure(path);
+        });
+        topk_route_cache.erase_if([this](const uint64_t, const CachedPaths& paths) {
+            return std::any_of(paths.begin(), paths.end(),
+                               [this](const CachedPath& path) { return path_crosses_failure(path); });
+        });
+    } else {
+        // a path got outdated if the detour through the restored element is shorter
+        const auto distances_from_src = compute_distances_from(src);
+        const auto distances_from_dest = (dest >= 0) ? compute_distances_from(dest) : distances_from_src;
+        const auto detour_length = [&](const uint64_t key) {
+            const auto from = static_cast<DeviceId>(key >> 32);
+            const auto to = static_cast<DeviceId>(key & 0xFFFFFFFF);
+            const auto through = [from, to](const std::vector<int>& first, const std::vector<int>& second,
+                                            const int hops) {
+                return (first[from] < 0 || second[to] < 0) ? std::numeric_limits<int>::max()
+                                                           : first[from] + hops + second[to];
+            };
+            if (dest < 0) {
+                return through(distances_from_src, distances_from_src, 0);
+            }
+            return std::min(through(distances_from_src, distances_from_dest, 1),
+                            through(distances_from_dest, distances_from_src, 1));
+        };
+        shortest_route_cache.erase_if([&](const uint64_t key, const CachedPath& path) {
+            return path.empty() || detour_length(key) < static_cast<int>(path.size()) - 1;
+        });
+        topk_route_cache.erase_if([&](const uint64_t key, const CachedPaths& paths) {
+            // paths are sorted by length, so a detour as short as the longest may join them
+            return paths.size() < k_max_paths || detour_length(key) <= static_cast<int>(paths.back().size()) - 1;
+        });
+    }
+
+    // refill what was computed from the previous graph
+    if (!affected_rows.empty()) {
+        fill_shortest_path_rows(affected_rows, 0);
+    }
+    if (!distance_matrix.empty()) {
+        distance_matrix = DistanceMatrix(graph, 0, distance_cache_memory);
+    }
+    return true;
+}
+
+Route ExpanderGraph::route_around_failures(const DeviceId src, const DeviceId dest) const noexcept {
+    assert(0 <= src && src < devices_count);
+    assert(0 <= dest && dest < npus_count);
+
+    if (shortest_paths_precomputed() && !is_device_failed(src)) {
+        return route_from_tables(src, dest);
+    }
+
+    // BFS on the graph; a failed device is left out of it, but still lets its chunks out
+    auto parents = std::vector<DeviceId>(graph.get_nodes_count(), -1);
+    auto queue = std::vector<DeviceId>{src};
+    parents[src] = src;
+    for (auto head = static_cast<size_t>(0); head < queue.size() && parents[dest] < 0; head++) {
+        const auto current = queue[head];
+        auto neighbors = std::vector<DeviceId>();
+        if (current == src && is_device_failed(src)) {
+            for (const auto neighbor : adjacency_list.at(src)) {
+                if (!is_link_failed(src, neighbor)) {
+                    neighbors.push_back(neighbor);
+                }
+            }
+        } else {
+            const auto [first_neighbor, last_neighbor] = graph.get_neighbors(current);
+            neighbors.assign(first_neighbor, last_neighbor);
+        }
+        for (const auto neighbor : neighbors) {
+            if (parents[neighbor] < 0) {
+                parents[neighbor] = current;
+                queue.push_back(neighbor);
+            }
+        }
+    }
+    if (parents[dest] < 0) {
+        return Route();
+    }
+
+    auto route = Route();
+    for (auto current = dest; current != src; current = parents[current]) {
+        route.push_front(devices[current]);
+    }
+    route.push_front(devices[src]);
+    return route;
+}
+
+Route ExpanderGraph::route_random_topk(DeviceId src, DeviceId dest, CounterRng& rng) const noexcept {
     // assert npus are in valid range
     assert(0 <= src && src < npus_count);
     assert(0 <= dest && dest < npus_count);
 
-    
-    std::pair<DeviceId, DeviceId> node_pair = std::make_pair(src, dest);
-    // Check route cache
-    if (topk_route_cache.find(node_pair) != topk_route_cache.end()) {
-        static thread_local std::mt19937 rng(std::random_device{}());
-        const auto& cached_paths = topk_route_cache.at(node_pair);
-        size_t start_index = cached_paths.size() > 4 ? 4 : 0;
-        std::uniform_int_distribution<size_t> dist(start_index, cached_paths.size() - 1);
-        const auto& chosen_path = cached_paths[dist(rng)];
-        Route cached_route;
-        for (const auto& device_id : chosen_path) {
-            if (device_id >= static_cast<DeviceId>(devices.size())) {
-                std::cerr << "[ERROR] device_id " << device_id << " >= devices.size() " << devices.size() << std::endl;
-                std::exit(-1);
-            }
-            cached_route.push_back(devices[device_id]);
+    if (uses_precomputed_paths()) {
+        const auto paths_count = k_shortest_paths->get_paths_count(src, dest);
+        if (paths_count == 0) {
+            std::cerr << "[ERROR] No route found from " << src << " to " << dest << std::endl;
+            std::exit(-1);
         }
-        return cached_route;
+
+        // pick a random path beyond the 4 shortest if possible
+        const auto start_index = (paths_count > 4) ? 4 : 0;
+        const auto pick = start_index + static_cast<int>(rng.uniform(static_cast<uint32_t>(paths_count - start_index)));
+        const auto [first, last] = k_shortest_paths->get_path(src, dest, pick);
+
+        Route route;
+        for (auto it = first; it != last; it++) {
+            route.push_back(devices[*it]);
+        }
+        return route;
     }
 
+    const auto& paths = find_topk_paths(src, dest);
+
     // construct empty route
     auto route = Route();
 
+    // Pick a random path beyond the 4 shortest if possible
+    size_t start_index = (paths.size() > 4) ? 4 : 0;
+    size_t end_index = paths.size() - 1;
+    
+    // Ensure start_index doesn't exceed available paths
+    if (start_index > end_index) {
+        start_index = 0;
+    }
+    
+    const auto pick = start_index + rng.uniform(static_cast<uint32_t>(end_index - start_index + 1));
+    const auto& chosen_path = paths[pick];
+
+    // convert device IDs to device pointers
+    for (const auto& device_id : chosen_path) {
+        if (device_id >= static_cast<DeviceId>(devices.size())) {
+            std::cerr << "[ERROR] device_id " << device_id << " >= devices.size() " << devices.size() << std::endl;
+            std::exit(-1);
+        }
+        route.push_back(devices[device_id]);
+    }
+
+    return route;
+}
+
+const ExpanderGraph::CachedPaths& ExpanderGraph::find_topk_paths(DeviceId src, DeviceId dest) const noexcept {
+    const auto node_pair = ShardedMap<CachedPaths>::make_pair_key(src, dest);
+    // Check route cache
+    if (const auto* const cached = topk_route_cache.find(node_pair)) {
+        return *cached;
+    }
+
     using Edge = std::pair<DeviceId, DeviceId>;
     auto normalize_edge = [](DeviceId a, DeviceId b) {
         return a < b ? std::make_pair(a, b) : std::make_pair(b, a);
@@ -392,7 +725,9 @@ Route ExpanderGraph::route_random_topk(DeviceId src, DeviceId dest) const noexce
                 break;
             }
 
-            for (const auto& neighbor : adjacency_list.at(current)) {
+            const auto [first_neighbor, last_neighbor] = graph.get_neighbors(current);
+            for (auto neighbor_it = first_neighbor; neighbor_it != last_neighbor; neighbor_it++) {
+                const auto neighbor = *neighbor_it;
                 if (banned_nodes.find(neighbor) != banned_nodes.end()) {
                     continue;
                 }
@@ -422,7 +757,7 @@ Route ExpanderGraph::route_random_topk(DeviceId src, DeviceId dest) const noexce
         return path;
     };
 
-    auto k_shortest_paths = [&](DeviceId start, DeviceId goal, size_t k_max) {
+    auto find_k_shortest_paths = [&](DeviceId start, DeviceId goal, size_t k_max) {
         std::vector<std::vector<DeviceId>> shortest_paths;
         std::vector<std::vector<DeviceId>> candidates;
 
@@ -493,37 +828,77 @@ Route ExpanderGraph::route_random_topk(DeviceId src, DeviceId dest) const noexce
         return shortest_paths;
     };
 
-    constexpr size_t k_max_paths = 16;
-    auto paths = k_shortest_paths(src, dest, k_max_paths);
+    auto paths = find_k_shortest_paths(src, dest, k_max_paths);
     if (paths.empty()) {
         std::cerr << "[ERROR] No route found from " << src << " to " << dest << std::endl;
         std::exit(-1);
     }
 
     // Cache k-shortest paths
-    topk_route_cache[node_pair] = paths;
-
-    // Pick a random path beyond the 4 shortest if possible
-    static thread_local std::mt19937 rng(std::random_device{}());
-    size_t start_index = (paths.size() > 4) ? 4 : 0;
-    size_t end_index = paths.size() - 1;
-    
-    // Ensure start_index doesn't exceed available paths
-    if (start_index > end_index) {
-        start_index = 0;
+    auto cached_paths = CachedPaths(TrackingAllocator<CachedPath>(topk_route_cache_memory));
+    cached_paths.reserve(paths.size());
+    for (const auto& path : paths) {
+        cached_paths.emplace_back(path.begin(), path.end(), cached_paths.get_allocator());
     }
-    
-    std::uniform_int_distribution<size_t> pick(start_index, end_index);
-    const auto& chosen_path = paths[pick(rng)];
+    return topk_route_cache.emplace(node_pair, std::move(cached_paths));
+}
 
-    // convert device IDs to device pointers
-    for (const auto& device_id : chosen_path) {
-        if (device_id >= static_cast<DeviceId>(devices.size())) {
-            std::cerr << "[ERROR] device_id " << device_id << " >= devices.size() " << devices.size() << std::endl;
+Route ExpanderGraph::route_adaptive(const DeviceId src, const DeviceId dest) const noexcept {
+    // assert npus are in valid range
+    assert(0 <= src && src < npus_count);
+    assert(0 <= dest && dest < npus_count);
+
+    // summed backlog of the links along a path
+    const auto path_backlog = [this](const auto first, const auto last) {
+        auto backlog = static_cast<ChunkSize>(0);
+        for (auto it = first; std::next(it) != last; it++) {
+            backlog += get_link_backlog(*it, *std::next(it));
+        }
+        return backlog;
+    };
+
+    // pick the least backlogged candidate; candidates are sorted by length,
+    // so ties (e.g., an idle network) go to the shortest path
+    auto route = Route();
+    if (uses_precomputed_paths()) {
+        const auto paths_count = k_shortest_paths->get_paths_count(src, dest);
+        if (paths_count == 0) {
+            std::cerr << "[ERROR] No route found from " << src << " to " << dest << std::endl;
             std::exit(-1);
         }
-        route.push_back(devices[device_id]);
+
+        auto best_index = 0;
+        auto best_backlog = std::numeric_limits<ChunkSize>::max();
+        for (auto i = 0; i < paths_count; i++) {
+            const auto [first, last] = k_shortest_paths->get_path(src, dest, i);
+            const auto backlog = path_backlog(first, last);
+            if (backlog < best_backlog) {
+                best_index = i;
+                best_backlog = backlog;
+            }
+        }
+
+        const auto [first, last] = k_shortest_paths->get_path(src, dest, best_index);
+        for (auto it = first; it != last; it++) {
+            route.push_back(devices[*it]);
+        }
+        return route;
+    }
+
+    const auto& paths = find_topk_paths(src, dest);
+    const CachedPath* best_path = nullptr;
+    auto best_backlog = std::numeric_limits<ChunkSize>::max();
+    for (const auto& path : paths) {
+        const auto backlog = path_backlog(path.begin(), path.end());
+        if (backlog < best_backlog) {
+            best_path = &path;
+            best_backlog = backlog;
+        }
     }
 
+    assert(best_path != nullptr);
+    for (const auto device_id : *best_path) {
+        route.push_back(devices[device_id]);
+    }
     return route;
-}
\ No newline at end of file
+}
@@ -1,4 +1,5 @@
 #include "congestion_aware/FatTree.h"
+#include "common/CounterRng.h"
 #include <cassert>
 #include <ctime>
 #include <cstdlib>
@@ -6,8 +7,8 @@
 #include <queue>
 #include <fstream>
 #include <iostream>
+#include <limits>
 #include <stdexcept>
-#include <random>
 #include "../../../helper/json/json.hpp"
 
 using namespace NetworkAnalytical;
@@ -18,6 +19,12 @@ FatTree::RoutingAlgorithm FatTree::str2RoutingAlgorithm(const std::string& algo_
         return RoutingAlgorithm::Deterministic;
     } else if (algo_str == "Random") {
         return RoutingAlgorithm::Random;
+    } else if (algo_str == "ECMP") {
+        return RoutingAlgorithm::Ecmp;
+    } else if (algo_str == "Spray") {
+        return RoutingAlgorithm::Spray;
+    } else if (algo_str == "Adaptive") {
+        return RoutingAlgorithm::Adaptive;
     } else {
         std::cerr << "[Error] Unknown FatTree routing algorithm: " << algo_str << ". Defaulting to Deterministic." << std::endl;
         return RoutingAlgorithm::Deterministic;
@@ -26,108 +33,75 @@ FatTree::RoutingAlgorithm FatTree::str2RoutingAlgorithm(const std::string& algo_
 
 FatTree::FatTree(int npus_count, int k, Bandwidth bandwidth, Latency latency, 
                  const std::string& routing_algorithm_str) noexcept
-    : BasicTopology(npus_count, npus_count + ((k * k) / 2) + ((k * k) / 4) + ((k / 2) * (k / 2)), 
+    : BasicTopology(npus_count, npus_count + ((k * k) / 2) + ((k * k) / 2) + ((k / 2) * (k / 2)), 
                     bandwidth, latency), k(k) {
     assert(npus_count > 0);
     assert(k > 0 && k % 2 == 0);  // k must be even and positive
+    assert(npus_count <= (k * k * k) / 4);  // at most k/2 NPUs per leaf
     assert(bandwidth > 0);
     assert(latency >= 0);
 
     basic_topology_type = TopologyBuildingBlock::FatTree;
     this->routing_algorithm = str2RoutingAlgorithm(routing_algorithm_str);
+    this->routing_algorithm_str = routing_algorithm_str;
+    static_routes = (this->routing_algorithm == RoutingAlgorithm::Deterministic ||
+                     this->routing_algorithm == RoutingAlgorithm::Ecmp);
+    spray_counters = std::make_unique<std::atomic<uint64_t>[]>(npus_count);
 
     const int pods = k;
-    const int num_leaf_switches = (k * k) / 2;
-    const int num_spine_switches = (k * k) / 4;
-    const int num_core_switches = (k / 2) * (k / 2);
-    const int npus_per_leaf_ideal = k / 2;
-
-    // Create leaf switches
-    for (int i = 0; i < num_leaf_switches; ++i) {
-        leaf_switches.emplace_back(Switch(k, bandwidth, latency));
-    }
-
-    // Create spine switches
-    for (int i = 0; i < num_spine_switches; ++i) {
-        spine_switches.emplace_back(Switch(k, bandwidth, latency));
-    }
-
-    // Create core switches
-    for (int i = 0; i < num_core_switches; ++i) {
-        core_switches.emplace_back(Switch(k, bandwidth, latency));
-    }
-
-    // Distribute NPUs across leaves
-    npus_per_leaf.resize(num_leaf_switches, 0);
-    npu_to_leaf.resize(npus_count);
-    
-    int npu_id = 0;
-    for (int leaf = 0; leaf < num_leaf_switches && npu_id < npus_count; ++leaf) {
-        int npus_for_this_leaf = std::min(npus_per_leaf_ideal, npus_count - npu_id);
-        npus_per_leaf[leaf] = npus_for_this_leaf;
-        
-        for (int i = 0; i < npus_for_this_leaf && npu_id < npus_count; ++i) {
-            npu_to_leaf[npu_id] = leaf;
-            npu_id++;
-        }
-    }
-
-    // Instantiate devices after setting devices_count via parent class
-    instantiate_devices();
+    const int half = k / 2;
 
     // Device ID layout:
     // [0, npus_count) = NPUs
     // [npus_count, npus_count + num_leaf_switches) = leaf switches
     // [npus_count + num_leaf_switches, npus_count + num_leaf_switches + num_spine_switches) = spine switches
     // [npus_count + num_leaf_switches + num_spine_switches, ...) = core switches
-    const int leaf_switch_offset = npus_count;
-    const int spine_switch_offset = npus_count + num_leaf_switches;
-    const int core_switch_offset = npus_count + num_leaf_switches + num_spine_switches;
-
-    // Connect leaf switches to NPUs
-    npu_id = 0;
-    for (int leaf = 0; leaf < num_leaf_switches; ++leaf) {
-        for (int i = 0; i < npus_per_leaf[leaf]; ++i) {
-            int leaf_switch_id = leaf_switch_offset + leaf;
-            Topology::connect(npu_id, leaf_switch_id, bandwidth, latency);
-            npu_id++;
-        }
+    // switches are plain devices, identified arithmetically from these offsets
+    instantiate_devices();
+
+    // Connect leaf switches to NPUs, k/2 NPUs per leaf
+    for (int npu_id = 0; npu_id < npus_count; ++npu_id) {
+        Topology::connect(npu_id, get_leaf_switch_id(get_leaf(npu_id)), bandwidth, latency);
     }
 
     // Connect leaf switches to spine switches
     // Each leaf switch in a pod connects to all spine switches in that pod
     for (int pod = 0; pod < pods; ++pod) {
-        for (int i = 0; i < k / 2; ++i) {  // leaf switches in pod
-            for (int j = 0; j < k / 2; ++j) {  // spine switches in pod
-                int leaf_index = pod * (k / 2) + i;
-                int spine_index = pod * (k / 2) + j;
-                int leaf_device_id = leaf_switch_offset + leaf_index;
-                int spine_device_id = spine_switch_offset + spine_index;
-                Topology::connect(leaf_device_id, spine_device_id, bandwidth, latency);
+        for (int i = 0; i < half; ++i) {  // leaf switches in pod
+            for (int j = 0; j < half; ++j) {  // spine switches in pod
+                Topology::connect(get_leaf_switch_id(pod * half + i), get_spine_switch_id(pod, j), bandwidth, latency);
             }
         }
-    }  
-    
+    }
+
     // Connect spine switches to core switches
     // Each spine switch i connects to all core switches in column i
-    for (int i = 0; i < k / 2; ++i) {
-        for (int j = 0; j < k / 2; ++j) {
+    for (int i = 0; i < half; ++i) {
+        for (int j = 0; j < half; ++j) {
             for (int pod = 0; pod < pods; ++pod) {
-                int spine_index = pod * (k / 2) + i;
-                int core_index = i * (k / 2) + j;
-                int spine_device_id = spine_switch_offset + spine_index;
-                int core_device_id = core_switch_offset + core_index;
-                Topology::connect(spine_device_id, core_device_id, bandwidth, latency);
+                Topology::connect(get_spine_switch_id(pod, i), get_core_switch_id(i * half + j), bandwidth, latency);
             }
         }
     }
-}   
+}
 
 std::unique_ptr<BasicTopology> FatTree::clone() const noexcept {
     return std::make_unique<FatTree>(npus_count, k, bandwidth, latency, routing_algorithm_str);
 }   
 
+void FatTree::reset() noexcept {
+    BasicTopology::reset();
+    for (int i = 0; i < npus_count; ++i) {
+        spray_counters[i].store(0, std::memory_order_relaxed);
+    }
+}
+
 Route FatTree::route(DeviceId src, DeviceId dest) const noexcept {
+    // random routes are keyed by the next flow of src
+    return route(src, dest, (routing_algorithm == RoutingAlgorithm::Random) ? next_flow_id(src) : 0);
+}
+
+Route FatTree::route(DeviceId src, DeviceId dest, uint64_t flow_id) const noexcept {
     // assert npus are in valid range
     assert(0 <= src && src < npus_count);
     assert(0 <= dest && dest < npus_count);
@@ -135,90 +109,145 @@ Route FatTree::route(DeviceId src, DeviceId dest) const noexcept {
     // construct empty route
     auto route = Route();
 
-    const int num_leaf_switches = (k * k) / 2;
-    const int num_spine_switches = (k * k) / 4;
-    const int leaf_switch_offset = npus_count;
-    const int spine_switch_offset = npus_count + num_leaf_switches;
-    const int core_switch_offset = npus_count + num_leaf_switches + num_spine_switches;
-
-    int src_leaf = npu_to_leaf[src];
-    int dest_leaf = npu_to_leaf[dest];
+    const int src_leaf = get_leaf(src);
+    const int dest_leaf = get_leaf(dest);
 
     // If src and dest are under the same leaf switch, route directly
     if (src_leaf == dest_leaf) {
         route.push_back(devices[src]);
-        route.push_back(devices[leaf_switch_offset + src_leaf]);
+        route.push_back(devices[get_leaf_switch_id(src_leaf)]);
         route.push_back(devices[dest]);
         return route;
     }
 
-    // Determine which pod each leaf belongs to
-    int src_pod = src_leaf / (k / 2);
-    int dest_pod = dest_leaf / (k / 2);
-    
-    // Get spine switch indices within each pod
-    int src_leaf_in_pod = src_leaf % (k / 2);
-    int dest_leaf_in_pod = dest_leaf % (k / 2);
-    
-    // If src and dest are in the same pod, route through a spine switch within the pod
-    if (src_pod == dest_pod) {
-        // In deterministic mode: pick first spine switch, in random mode: pick random spine
-        int spine_in_pod = src_leaf_in_pod;
-        
-        if (routing_algorithm == RoutingAlgorithm::Random) {
-            static thread_local std::mt19937 gen(std::random_device{}());
-            std::uniform_int_distribution<> dis(0, k / 2 - 1);
-            spine_in_pod = dis(gen);
-        }
-        
-        int spine_index = src_pod * (k / 2) + spine_in_pod;
-        
-        // Route: src -> src_leaf -> spine -> dest_leaf -> dest (5 hops)
-        route.push_back(devices[src]);
-        route.push_back(devices[leaf_switch_offset + src_leaf]);
-        route.push_back(devices[spine_switch_offset + spine_index]);
-        route.push_back(devices[leaf_switch_offset + dest_leaf]);
-        route.push_back(devices[dest]);
-        return route;
-    }
-    
-    // Otherwise, route up through spine and core switches
-    // Determine spine switches based on routing algorithm
-    int src_spine_in_pod = src_leaf_in_pod;
-    int dest_spine_in_pod = dest_leaf_in_pod;
-    
-    if (routing_algorithm == RoutingAlgorithm::Random) {
-        static thread_local std::mt19937 gen(std::random_device{}());
-        std::uniform_int_distribution<> dis(0, k / 2 - 1);
-        src_spine_in_pod = dis(gen);
-        dest_spine_in_pod = dis(gen);
-    }
-    
-    int src_spine_index = src_pod * (k / 2) + src_spine_in_pod;
-    int dest_spine_index = dest_pod * (k / 2) + dest_spine_in_pod;
-    
-    // In random mode, pick a random core switch that connects src_spine and dest_spine
-    // In deterministic mode, use the core switch based on spine indices
-    int core_row = src_spine_in_pod;
-    int core_col = dest_spine_in_pod;
-    
-    if (routing_algorithm == RoutingAlgorithm::Random) {
-        static thread_local std::mt19937 gen(std::random_device{}());
-        std::uniform_int_distribution<> dis(0, k / 2 - 1);
-        core_row = dis(gen);
-        core_col = dis(gen);
-    }
-    
-    int core_index = core_row * (k / 2) + core_col;
+    // Otherwise, go up through a spine (same pod) or a spine and a core (across pods)
+    // Route: src -> src_leaf -> spine -> dest_leaf -> dest (5 hops)
+    //    or: src -> src_leaf -> src_spine -> core -> dest_spine -> dest_leaf -> dest (7 hops)
+    auto switches = PathSwitches();
+    const auto path = select_path(src, dest, flow_id);
+    const auto switches_count = get_path_switches(src_leaf, dest_leaf, path, switches);
 
-    // Build the route: src -> src_leaf -> src_spine -> core -> dest_spine -> dest_leaf -> dest (7 hops)
     route.push_back(devices[src]);
-    route.push_back(devices[leaf_switch_offset + src_leaf]);
-    route.push_back(devices[spine_switch_offset + src_spine_index]);
-    route.push_back(devices[core_switch_offset + core_index]);
-    route.push_back(devices[spine_switch_offset + dest_spine_index]);
-    route.push_back(devices[leaf_switch_offset + dest_leaf]);
+    for (int i = 0; i < switches_count; ++i) {
+        route.push_back(devices[switches[i]]);
+    }
     route.push_back(devices[dest]);
 
     return route;
-}
\ No newline at end of file
+}
+
+int FatTree::get_paths_count(const int src_leaf, const int dest_leaf) const noexcept {
+    const int half = k / 2;
+
+    // a spine of the pod, or a (spine, core) pair across pods
+    return (src_leaf / half == dest_leaf / half) ? half : half * half;
+}
+
+int FatTree::get_path_switches(const int src_leaf,
+                               const int dest_leaf,
+                               const int path,
+                               PathSwitches& switches) const noexcept {
+    assert(src_leaf != dest_leaf);
+    assert(0 <= path && path < get_paths_count(src_leaf, dest_leaf));
+
+    const int half = k / 2;
+    const int src_pod = src_leaf / half;
+    const int dest_pod = dest_leaf / half;
+
+    // same pod: path is the spine within the pod
+    if (src_pod == dest_pod) {
+        switches[0] = get_leaf_switch_id(src_leaf);
+        switches[1] = get_spine_switch_id(src_pod, path);
+        switches[2] = get_leaf_switch_id(dest_leaf);
+        return 3;
+    }
+
+    // across pods: spine i of every pod reaches the cores of row i,
+    // so path (i * k/2 + j) goes through spine i of both pods and core (i, j)
+    const int spine_in_pod = path / half;
+    switches[0] = get_leaf_switch_id(src_leaf);
+    switches[1] = get_spine_switch_id(src_pod, spine_in_pod);
+    switches[2] = get_core_switch_id(path);
+    switches[3] = get_spine_switch_id(dest_pod, spine_in_pod);
+    switches[4] = get_leaf_switch_id(dest_leaf);
+    return 5;
+}
+
+int FatTree::select_path(const DeviceId src, const DeviceId dest, const uint64_t flow_id) const noexcept {
+    const int half = k / 2;
+    const int src_leaf = get_leaf(src);
+    const int dest_leaf = get_leaf(dest);
+    const int paths_count = get_paths_count(src_leaf, dest_leaf);
+
+    // deterministic path, based on the position of the leaves within their pods
+    const int deterministic_path =
+        (src_leaf / half == dest_leaf / half) ? src_leaf % half : (src_leaf % half) * half + dest_leaf % half;
+
+    switch (routing_algorithm) {
+        case RoutingAlgorithm::Random: {
+            auto rng = CounterRng(routing_seed, src, dest, flow_id);
+            return static_cast<int>(rng.uniform(static_cast<uint32_t>(paths_count)));
+        }
+        case RoutingAlgorithm::Ecmp:
+            return static_cast<int>(hash_flow(src, dest, flow_id) % static_cast<uint64_t>(paths_count));
+        case RoutingAlgorithm::Spray: {
+            // successive routes from src rotate over the paths, starting from the hashed one
+            const auto sequence = spray_counters[src].fetch_add(1, std::memory_order_relaxed);
+            return static_cast<int>((hash_flow(src, dest, 0) + sequence) % static_cast<uint64_t>(paths_count));
+        }
+        case RoutingAlgorithm::Adaptive: {
+            // least backlogged path, starting from the deterministic one so it wins ties
+            auto switches = PathSwitches();
+            auto best_path = deterministic_path;
+            auto least_backlog = std::numeric_limits<ChunkSize>::max();
+            for (int i = 0; i < paths_count; ++i) {
+                const int path = (deterministic_path + i) % paths_count;
+                const auto switches_count = get_path_switches(src_leaf, dest_leaf, path, switches);
+                auto backlog = static_cast<ChunkSize>(0);
+                for (int j = 0; j + 1 < switches_count; ++j) {
+                    backlog += get_link_backlog(switches[j], switches[j + 1]);
+                }
+                if (backlog < least_backlog) {
+                    least_backlog = backlog;
+                    best_path = path;
+                }
+            }
+            return best_path;
+        }
+        default:
+            return deterministic_path;
+    }
+}
+
+uint64_t FatTree::hash_flow(const DeviceId src, const DeviceId dest, const uint64_t flow_id) noexcept {
+    // splitmix64 finalizer over the flow key
+    auto hash = ((static_cast<uint64_t>(src) << 32) | static_cast<uint32_t>(dest)) ^ (flow_id * 0x9E3779B97F4A7C15ULL);
+    hash = (hash ^ (hash >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    hash = (hash ^ (hash >> 27)) * 0x94D049BB133111EBULL;
+    return hash ^ (hash >> 31);
+}
+
+int FatTree::get_leaf(const DeviceId npu) const noexcept {
+    assert(0 <= npu && npu < npus_count);
+
+    return npu / (k / 2);
+}
+
+DeviceId FatTree::get_leaf_switch_id(const int leaf) const noexcept {
+    assert(0 <= leaf && leaf < (k * k) / 2);
+
+    return npus_count + leaf;
+}
+
+DeviceId FatTree::get_spine_switch_id(const int pod, const int spine_in_pod) const noexcept {
+    assert(0 <= pod && pod < k);
+    assert(0 <= spine_in_pod && spine_in_pod < k / 2);
+
+    return npus_count + ((k * k) / 2) + (pod * (k / 2)) + spine_in_pod;
+}
+
+DeviceId FatTree::get_core_switch_id(const int core) const noexcept {
+    assert(0 <= core && core < (k / 2) * (k / 2));
+
+    return npus_count + (k * k) + core;
+}
@@ -17,6 +17,14 @@ FullyConnected::FullyConnected(const int npus_count, const Bandwidth bandwidth,
     // set topology type
     basic_topology_type = TopologyBuildingBlock::FullyConnected;
 
+    // large fully-connected topologies create each link on its first use
+    if (npus_count >= lazy_links_min_count) {
+        for (auto src = 0; src < npus_count; src++) {
+            devices[src]->connect_lazily(0, 1, npus_count, bandwidth, latency);
+        }
+        return;
+    }
+
     // fully-connect every src-dest pairs
     for (auto src = 0; src < npus_count; src++) {
         for (auto dest = 0; dest < npus_count; dest++) {
@@ -41,6 +49,26 @@ Route FullyConnected::route(const DeviceId src, const DeviceId dest) const noexc
     return route;
 }
 
+bool FullyConnected::describe_route(const DeviceId src,
+                                    const DeviceId dest,
+                                    RouteDescriptor& route_descriptor) const noexcept {
+    // assert npus are in valid range
+    assert(0 <= src && src < npus_count);
+    assert(0 <= dest && dest < npus_count);
+
+    // directly connected: a single step from src to dest
+    route_descriptor = {devices.data(), src, dest, -1, dest - src, npus_count, 2};
+    return true;
+}
+
+DeviceId FullyConnected::map_by_symmetry(const DeviceId device, const DeviceId npu) const noexcept {
+    assert(0 <= device && device < devices_count);
+    assert(0 <= npu && npu < npus_count);
+
+    // rotate the NPU ids
+    return (device + npu) % npus_count;
+}
+
 std::unique_ptr<BasicTopology> FullyConnected::clone() const noexcept {
     return std::make_unique<FullyConnected>(npus_count, bandwidth, latency);
 }
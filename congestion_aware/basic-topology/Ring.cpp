@@ -33,20 +33,11 @@ Route Ring::route(DeviceId src, DeviceId dest) const noexcept {
     // construct empty route
     auto route = Route();
 
-    auto step = 1;  // default direction: clockwise
-    if (bidirectional) {
-        // check whether going anticlockwise is shorter
-        auto clockwise_dist = dest - src;
-        if (clockwise_dist < 0) {
-            clockwise_dist += npus_count;
-        }
-        const auto anticlockwise_dist = npus_count - clockwise_dist;
-
-        if (anticlockwise_dist < clockwise_dist) {
-            // traverse the ring anticlockwise
-            step = -1;
-        }
-    }
+    // direction of the route
+    auto route_descriptor = RouteDescriptor();
+    [[maybe_unused]] const auto described = describe_route(src, dest, route_descriptor);
+    assert(described);
+    const auto step = route_descriptor.step;
 
     // construct the route
     auto current = src;
@@ -70,6 +61,41 @@ Route Ring::route(DeviceId src, DeviceId dest) const noexcept {
     return route;
 }
 
+bool Ring::describe_route(const DeviceId src, const DeviceId dest, RouteDescriptor& route_descriptor) const noexcept {
+    // assert npus are in valid range
+    assert(0 <= src && src < npus_count);
+    assert(0 <= dest && dest < npus_count);
+
+    auto clockwise_dist = dest - src;
+    if (clockwise_dist < 0) {
+        clockwise_dist += npus_count;
+    }
+
+    auto step = 1;  // default direction: clockwise
+    auto dist = clockwise_dist;
+    if (bidirectional) {
+        // check whether going anticlockwise is shorter
+        const auto anticlockwise_dist = (clockwise_dist == 0) ? 0 : npus_count - clockwise_dist;
+
+        if (anticlockwise_dist < clockwise_dist) {
+            // traverse the ring anticlockwise
+            step = -1;
+            dist = anticlockwise_dist;
+        }
+    }
+
+    route_descriptor = {devices.data(), src, dest, -1, step, npus_count, dist + 1};
+    return true;
+}
+
+DeviceId Ring::map_by_symmetry(const DeviceId device, const DeviceId npu) const noexcept {
+    assert(0 <= device && device < devices_count);
+    assert(0 <= npu && npu < npus_count);
+
+    // rotate the NPU ids
+    return (device + npu) % npus_count;
+}
+
 std::unique_ptr<BasicTopology> Ring::clone() const noexcept {
     return std::make_unique<Ring>(npus_count, bandwidth, latency, bidirectional);
 }
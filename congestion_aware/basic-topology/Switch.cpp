@@ -31,6 +31,9 @@ Switch::Switch(const int npus_count, const Bandwidth bandwidth, const Latency la
         adjacency_list[i].push_back(switch_id);
         adjacency_list[switch_id].push_back(i);
     }
+
+    // build the CSR form once
+    graph = CsrGraph(adjacency_list);
 }
 
 Route Switch::route(DeviceId src, DeviceId dest) const noexcept {
@@ -48,6 +51,33 @@ Route Switch::route(DeviceId src, DeviceId dest) const noexcept {
     return route;
 }
 
+const CsrGraph& Switch::get_graph() const noexcept {
+    return graph;
+}
+
+bool Switch::describe_route(const DeviceId src, const DeviceId dest, RouteDescriptor& route_descriptor) const noexcept {
+    // assert npus are in valid range
+    assert(0 <= src && src < npus_count);
+    assert(0 <= dest && dest < npus_count);
+
+    // start at source, and go to switch, then go to destination
+    route_descriptor = {devices.data(), src, dest, switch_id, 0, 0, 3};
+    return true;
+}
+
+DeviceId Switch::map_by_symmetry(const DeviceId device, const DeviceId npu) const noexcept {
+    assert(0 <= device && device < devices_count);
+    assert(0 <= npu && npu < npus_count);
+
+    // the switch is shared by every NPU
+    if (device == switch_id) {
+        return device;
+    }
+
+    // rotate the NPU ids
+    return (device + npu) % npus_count;
+}
+
 std::unique_ptr<BasicTopology> Switch::clone() const noexcept {
     return std::make_unique<Switch>(npus_count, bandwidth, latency);
 }
@@ -3,10 +3,6 @@
 #include <cassert>
 #include <iostream>
 
-// avoid depending on top-level include paths in this external tree; declare
-// the global flag here instead of including the simulator header.
-std::shared_ptr<std::map<DeviceId, bool>> use_moe_routing;
-
 using namespace NetworkAnalytical;
 using namespace NetworkAnalyticalCongestionAware;
 
@@ -18,10 +14,14 @@ SwitchOrExpander::SwitchOrExpander(int npus_count, Bandwidth bandwidth, Latency
     assert(latency >= 0);
 
     basic_topology_type = TopologyBuildingBlock::SwitchOrExpander;
-    use_moe_routing = std::make_shared<std::map<DeviceId, bool>>();
+    inputfile_path = inputfile;
+    routing_algorithm_str = routing_algorithm;
+    this->use_resiliency = use_resiliency;
+
+    // routes follow the per-device routing mode, which may be switched at any time
+    static_routes = false;
   
-    // create switch topology
-    switch_topology = Switch(npus_count, bandwidth, latency);
+    // the switch topology is created by the initializer list
     std::cout << "[SwitchOrExpander] Switch topology created with " << npus_count << " NPUs." << std::endl;
     
     // build expander graph from file (if provided)
@@ -30,14 +30,34 @@ SwitchOrExpander::SwitchOrExpander(int npus_count, Bandwidth bandwidth, Latency
         std::cout << "[SwitchOrExpander] Expander graph loaded from file: " << inputfile << std::endl;
     }
 
-    for (DeviceId id : expander_topology->get_all_device_ids()) {
-        (*use_moe_routing)[id] = false;  // default to switch routing
-    }
+    // every device defaults to switch routing
+    routing_phases.emplace_back();
+    routing_phases[0].moe_mask.assign((devices_count + 63) / 64, 0);
+    active_phase = &routing_phases[0];
 }
 
 std::unique_ptr<BasicTopology> SwitchOrExpander::clone() const noexcept {
-    return std::make_unique<SwitchOrExpander>(npus_count, bandwidth, latency, inputfile_path, routing_algorithm_str,
-                                              use_resiliency);
+    auto clone = std::make_unique<SwitchOrExpander>(npus_count, bandwidth, latency, inputfile_path,
+                                                    routing_algorithm_str, use_resiliency);
+
+    // carry the routing phases over
+    clone->routing_phases = routing_phases;
+    clone->active_phase = &clone->routing_phases[get_routing_phase()];
+    return clone;
+}
+
+void SwitchOrExpander::set_routing_seed(const uint64_t seed) noexcept {
+    BasicTopology::set_routing_seed(seed);
+    if (expander_topology) {
+        expander_topology->set_routing_seed(seed);
+    }
+}
+
+void SwitchOrExpander::reset() noexcept {
+    BasicTopology::reset();
+    if (expander_topology) {
+        expander_topology->reset();
+    }
 }
 
 unsigned int SwitchOrExpander::get_distance(const DeviceId src, const DeviceId dest) const noexcept {
@@ -45,8 +65,8 @@ unsigned int SwitchOrExpander::get_distance(const DeviceId src, const DeviceId d
         return 0;
     }
 
-    assert(use_moe_routing->at(src) == use_moe_routing->at(dest)); // both src and dest should use the same mode
-    bool use_moe = use_moe_routing->at(src);
+    assert(is_moe_routing(src) == is_moe_routing(dest)); // both src and dest should use the same mode
+    bool use_moe = is_moe_routing(src);
     
     if (use_moe && expander_topology) {
         return expander_topology->get_distance(src, dest, std::set<DeviceId>(), 0);
@@ -59,8 +79,8 @@ unsigned int SwitchOrExpander::get_distance(const DeviceId src, const DeviceId d
 int SwitchOrExpander::compute_hops_count(const DeviceId src, const DeviceId dest) const noexcept {
     assert(src != dest);
 
-    assert(use_moe_routing->at(src) == use_moe_routing->at(dest)); // both src and dest should use the same mode
-    bool use_moe = use_moe_routing->at(src);
+    assert(is_moe_routing(src) == is_moe_routing(dest)); // both src and dest should use the same mode
+    bool use_moe = is_moe_routing(src);
     
     if (use_moe && expander_topology) {
         return expander_topology->route(src, dest).size() - 1;
@@ -74,13 +94,13 @@ Route SwitchOrExpander::route(DeviceId src, DeviceId dest) const noexcept {
     assert(0 <= src && src < npus_count);
     assert(0 <= dest && dest < npus_count);
 
-    assert(use_moe_routing->at(src) == use_moe_routing->at(dest)); // both src and dest should use the same mode
-    bool use_moe = use_moe_routing->at(src);
+    assert(is_moe_routing(src) == is_moe_routing(dest)); // both src and dest should use the same mode
+    bool use_moe = is_moe_routing(src);
 
     if (use_moe && expander_topology) {
         Route r = expander_topology->route(src, dest);
         for (const auto& device_id : r) {
-            assert(use_moe_routing->at(device_id->get_id()) == true); // all devices in the route should be in moe mode 
+            assert(is_moe_routing(device_id->get_id())); // all devices in the route should be in moe mode 
         }
         return r;
     }
@@ -88,18 +108,81 @@ Route SwitchOrExpander::route(DeviceId src, DeviceId dest) const noexcept {
     return switch_topology.route(src, dest);
 }
 
-std::map<DeviceId, std::vector<DeviceId>> SwitchOrExpander::get_adjacency_list() const noexcept {
-    //use moe result if moe mode is enabled for any device
-    bool use_moe = false;
-    for (const auto& [device_id, moe_flag] : *use_moe_routing) {
-        if (moe_flag) {
-            use_moe = true;
-            break;
-        }
-    }
+bool SwitchOrExpander::any_moe_routing() const noexcept {
+    return active_phase->moe_count > 0;
+}
 
-    if (use_moe && expander_topology) {
+const std::map<DeviceId, std::vector<DeviceId>>& SwitchOrExpander::get_adjacency_list() const noexcept {
+    //use moe result if moe mode is enabled for any device
+    if (any_moe_routing() && expander_topology) {
         return expander_topology->adjacency_list;
     }
     return switch_topology.adjacency_list;
-}
\ No newline at end of file
+}
+
+const CsrGraph& SwitchOrExpander::get_graph() const noexcept {
+    if (any_moe_routing() && expander_topology) {
+        return expander_topology->get_graph();
+    }
+    return switch_topology.get_graph();
+}
+
+void SwitchOrExpander::set_moe_routing(const DeviceId id, const bool enabled) noexcept {
+    set_phase_moe_routing(*active_phase, id, enabled);
+}
+
+void SwitchOrExpander::set_moe_routing(const bool enabled) noexcept {
+    for (DeviceId id = 0; id < devices_count; id++) {
+        set_phase_moe_routing(*active_phase, id, enabled);
+    }
+}
+
+void SwitchOrExpander::set_moe_routing(const std::vector<DeviceId>& ids, const bool enabled) noexcept {
+    for (const auto id : ids) {
+        set_phase_moe_routing(*active_phase, id, enabled);
+    }
+}
+
+bool SwitchOrExpander::is_moe_routing(const DeviceId id) const noexcept {
+    assert(0 <= id && id < devices_count);
+
+    return ((active_phase->moe_mask[id / 64] >> (id % 64)) & 1) != 0;
+}
+
+int SwitchOrExpander::add_routing_phase(const std::vector<DeviceId>& moe_ids) noexcept {
+    // active_phase may move along with the phases
+    const auto active_phase_id = get_routing_phase();
+
+    auto phase = RoutingPhase();
+    phase.moe_mask.assign((devices_count + 63) / 64, 0);
+    for (const auto id : moe_ids) {
+        set_phase_moe_routing(phase, id, true);
+    }
+    routing_phases.push_back(std::move(phase));
+
+    active_phase = &routing_phases[active_phase_id];
+    return static_cast<int>(routing_phases.size()) - 1;
+}
+
+void SwitchOrExpander::set_routing_phase(const int phase) noexcept {
+    assert(0 <= phase && phase < static_cast<int>(routing_phases.size()));
+
+    active_phase = &routing_phases[phase];
+}
+
+int SwitchOrExpander::get_routing_phase() const noexcept {
+    return static_cast<int>(active_phase - routing_phases.data());
+}
+
+void SwitchOrExpander::set_phase_moe_routing(RoutingPhase& phase, const DeviceId id, const bool enabled) const noexcept {
+    assert(0 <= id && id < devices_count);
+
+    auto& word = phase.moe_mask[id / 64];
+    const auto bit = static_cast<uint64_t>(1) << (id % 64);
+    if (((word & bit) != 0) == enabled) {
+        return;
+    }
+
+    word ^= bit;
+    phase.moe_count += enabled ? 1 : -1;
+}
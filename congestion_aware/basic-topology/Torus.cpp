@@ -0,0 +1,112 @@
+/******************************************************************************
+This source code is licensed under the MIT license found in the
+LICENSE file in the root directory of this source tree.
+*******************************************************************************/
+
+#include "congestion_aware/Torus.h"
+#include <cassert>
+
+using namespace NetworkAnalytical;
+using namespace NetworkAnalyticalCongestionAware;
+
+Torus::Torus(const std::vector<int>& shape,
+             const Bandwidth bandwidth,
+             const Latency latency,
+             const bool bidirectional) noexcept
+    : BasicTopology(compute_npus_count(shape), compute_npus_count(shape), bandwidth, latency),
+      shape(shape),
+      bidirectional(bidirectional) {
+    assert(!shape.empty());
+    assert(bandwidth > 0);
+    assert(latency >= 0);
+
+    basic_topology_type = TopologyBuildingBlock::Torus;
+
+    // expose every ring as a dimension (e.g., for hierarchical collectives)
+    const auto dims = static_cast<int>(shape.size());
+    dims_count = dims;
+    npus_count_per_dim = shape;
+    bandwidth_per_dim = std::vector<Bandwidth>(dims, bandwidth);
+
+    // dimension 0 varies fastest
+    auto stride = 1;
+    for (const auto extent : shape) {
+        strides.push_back(stride);
+        stride *= extent;
+    }
+
+    // connect every NPU to its next neighbor of each dimension, device by device
+    for (auto id = 0; id < npus_count; id++) {
+        for (auto dim = 0; dim < dims; dim++) {
+            const auto extent = shape[dim];
+            const auto address = (id / strides[dim]) % extent;
+            if (address < extent - 1) {
+                connect(id, id + strides[dim], bandwidth, latency, bidirectional);
+            } else if (extent > 2 || (extent == 2 && !bidirectional)) {
+                // wrap around connection - only connect once if a bidirectional ring has 2 NPUs
+                connect(id, id - ((extent - 1) * strides[dim]), bandwidth, latency, bidirectional);
+            }
+        }
+    }
+}
+
+Route Torus::route(const DeviceId src, const DeviceId dest) const noexcept {
+    // assert npus are in valid range
+    assert(0 <= src && src < npus_count);
+    assert(0 <= dest && dest < npus_count);
+
+    // construct empty route
+    auto route = Route();
+    route.push_back(devices[src]);
+
+    // traverse the dimensions in order
+    auto current = src;
+    for (auto dim = 0; dim < static_cast<int>(shape.size()); dim++) {
+        const auto extent = shape[dim];
+        const auto stride = strides[dim];
+        auto address = (current / stride) % extent;
+        const auto dest_address = (dest / stride) % extent;
+
+        // take the shorter direction around the ring (clockwise on ties)
+        auto clockwise_dist = dest_address - address;
+        if (clockwise_dist < 0) {
+            clockwise_dist += extent;
+        }
+        const auto anticlockwise_dist = (clockwise_dist == 0) ? 0 : extent - clockwise_dist;
+        const auto clockwise = !bidirectional || clockwise_dist <= anticlockwise_dist;
+        const auto dist = clockwise ? clockwise_dist : anticlockwise_dist;
+
+        for (auto i = 0; i < dist; i++) {
+            // step a stride, wrapping around within the ring
+            if (clockwise) {
+                current += (address == extent - 1) ? -((extent - 1) * stride) : stride;
+                address = (address == extent - 1) ? 0 : address + 1;
+            } else {
+                current -= (address == 0) ? -((extent - 1) * stride) : stride;
+                address = (address == 0) ? extent - 1 : address - 1;
+            }
+            route.push_back(devices[current]);
+        }
+    }
+    assert(current == dest);
+
+    // return the constructed route
+    return route;
+}
+
+std::unique_ptr<BasicTopology> Torus::clone() const noexcept {
+    return std::make_unique<Torus>(shape, bandwidth, latency, bidirectional);
+}
+
+const std::vector<int>& Torus::get_shape() const noexcept {
+    return shape;
+}
+
+int Torus::compute_npus_count(const std::vector<int>& shape) noexcept {
+    auto npus_count = 1;
+    for (const auto extent : shape) {
+        assert(extent > 0);
+        npus_count *= extent;
+    }
+    return npus_count;
+}
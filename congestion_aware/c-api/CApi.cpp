@@ -0,0 +1,138 @@
+/******************************************************************************
+This source code is licensed under the MIT license found in the
+LICENSE file in the root directory of this source tree.
+*******************************************************************************/
+
+#include "common/CApi.h"
+#include "common/EventQueue.h"
+#include "common/NetworkParser.h"
+#include "congestion_aware/Helper.h"
+#include "congestion_aware/SimulationContext.h"
+#include <algorithm>
+#include <cassert>
+#include <memory>
+#include <vector>
+
+using namespace NetworkAnalytical;
+using namespace NetworkAnalyticalCongestionAware;
+
+/**
+ * Simulation driven through the C interface:
+ * a topology on its own context, and the completions not polled yet.
+ */
+struct ana_sim {
+    /// context of the simulation, owning its event queue
+    std::shared_ptr<SimulationContext> context;
+
+    /// topology being simulated
+    std::shared_ptr<Topology> topology;
+
+    /// completed transfers, oldest first
+    std::vector<ana_completion> completions;
+
+    /// number of leading completions already polled
+    size_t polled_count;
+
+    /**
+     * Record the completion of a transfer at the current time.
+     */
+    void complete(const uint64_t tag) noexcept {
+        completions.push_back({tag, context->get_event_queue()->get_current_time()});
+    }
+};
+
+ana_sim* ana_sim_create(const char* const config_path) {
+    if (config_path == nullptr) {
+        return nullptr;
+    }
+
+    const auto network_parser = NetworkParser(config_path);
+    auto* const sim = new ana_sim();
+    sim->context = std::make_shared<SimulationContext>(std::make_shared<EventQueue>());
+    sim->topology = construct_topology(network_parser, sim->context);
+    sim->polled_count = 0;
+    return sim;
+}
+
+void ana_sim_destroy(ana_sim* const sim) {
+    delete sim;
+}
+
+int32_t ana_get_npus_count(const ana_sim* const sim) {
+    assert(sim != nullptr);
+
+    return sim->topology->get_npus_count();
+}
+
+uint64_t ana_get_current_time(const ana_sim* const sim) {
+    assert(sim != nullptr);
+
+    return sim->context->get_event_queue()->get_current_time();
+}
+
+int ana_send_batch(ana_sim* const sim, const ana_transfer* const transfers, const size_t count) {
+    assert(sim != nullptr);
+
+    // check every transfer first, so that a batch is either injected or not
+    if (count > 0 && transfers == nullptr) {
+        return ANA_ERROR_INVALID_ARGUMENT;
+    }
+    const auto npus_count = sim->topology->get_npus_count();
+    for (auto i = static_cast<size_t>(0); i < count; i++) {
+        const auto& transfer = transfers[i];
+        if (transfer.src < 0 || transfer.src >= npus_count || transfer.dest < 0 || transfer.dest >= npus_count ||
+            transfer.size == 0) {
+            return ANA_ERROR_INVALID_ARGUMENT;
+        }
+    }
+
+    for (auto i = static_cast<size_t>(0); i < count; i++) {
+        const auto& transfer = transfers[i];
+        if (transfer.src == transfer.dest) {
+            sim->complete(transfer.tag);
+            continue;
+        }
+
+        // the callback holds the tag inline, so a transfer allocates nothing besides its pooled chunk
+        sim->topology->send(transfer.src, transfer.dest, transfer.size,
+                            [sim, tag = transfer.tag]() { sim->complete(tag); });
+    }
+    return ANA_OK;
+}
+
+uint64_t ana_advance_until(ana_sim* const sim, const uint64_t end_time) {
+    assert(sim != nullptr);
+
+    auto* const event_queue = sim->context->get_event_queue();
+    event_queue->run_until(end_time);
+    return event_queue->get_current_time();
+}
+
+int ana_get_next_event_time(const ana_sim* const sim, uint64_t* const next_time) {
+    assert(sim != nullptr);
+    assert(next_time != nullptr);
+
+    const auto* const event_queue = sim->context->get_event_queue();
+    if (event_queue->finished()) {
+        return 0;
+    }
+    *next_time = event_queue->get_next_event_time();
+    return 1;
+}
+
+size_t ana_poll_completions(ana_sim* const sim, ana_completion* const completions, const size_t capacity) {
+    assert(sim != nullptr);
+    assert(capacity == 0 || completions != nullptr);
+
+    auto& pending = sim->completions;
+    const auto count = std::min(capacity, pending.size() - sim->polled_count);
+    std::copy_n(pending.begin() + static_cast<std::ptrdiff_t>(sim->polled_count), count, completions);
+    sim->polled_count += count;
+
+    // drop the polled completions once they're the majority, keeping the storage
+    if (sim->polled_count * 2 >= pending.size()) {
+        pending.erase(pending.begin(), pending.begin() + static_cast<std::ptrdiff_t>(sim->polled_count));
+        sim->polled_count = 0;
+    }
+    return count;
+}
@@ -0,0 +1,198 @@
+/******************************************************************************
+This source code is licensed under the MIT license found in the
+LICENSE file in the root directory of this source tree.
+*******************************************************************************/
+
+#include "congestion_aware/Calibration.h"
+#include "common/EventQueue.h"
+#include "common/NetworkFunction.h"
+#include "congestion_aware/Helper.h"
+#include <cassert>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <memory>
+
+using namespace NetworkAnalytical;
+using namespace NetworkAnalyticalCongestionAware;
+
+namespace {
+
+/**
+ * A transfer measured on the congestion-aware backend,
+ * split into the two terms of the closed form.
+ */
+struct Sample {
+    /// hops * latency
+    double latency_term;
+
+    /// size / bandwidth
+    double bandwidth_term;
+
+    /// measured delay
+    double delay;
+
+    /// weight of the sample, so every pattern weighs the same
+    double weight;
+};
+
+/**
+ * A transfer of a pattern.
+ */
+struct Transfer {
+    DeviceId src;
+    DeviceId dest;
+    ChunkSize size;
+};
+
+/**
+ * Run the transfers of a pattern at once, and record a sample per transfer.
+ */
+void run_pattern(Topology& topology,
+                 const std::vector<Transfer>& transfers,
+                 const Latency latency,
+                 const Bandwidth bandwidth_Bpns,
+                 std::vector<Sample>& samples) noexcept {
+    auto* const event_queue = topology.get_simulation_context()->get_event_queue();
+    const auto start_time = event_queue->get_current_time();
+    [[maybe_unused]] const auto first_sample = samples.size();
+    const auto weight = 1.0 / static_cast<double>(transfers.size());
+
+    for (const auto& transfer : transfers) {
+        const auto hops_count = topology.route(transfer.src, transfer.dest).size() - 1;
+        const auto index = samples.size();
+        samples.push_back({static_cast<double>(hops_count) * latency,
+                           static_cast<double>(transfer.size) / bandwidth_Bpns, 0.0, weight});
+        topology.send(transfer.src, transfer.dest, transfer.size, [&samples, index, event_queue, start_time]() {
+            samples[index].delay = static_cast<double>(event_queue->get_current_time() - start_time);
+        });
+    }
+    event_queue->run();
+
+    assert(samples.size() == first_sample + transfers.size());
+}
+
+}  // namespace
+
+Calibration NetworkAnalyticalCongestionAware::calibrate_congestion_unaware(const NetworkParser& network_parser,
+                                                                           const ChunkSize chunk_size) noexcept {
+    assert(chunk_size > 0);
+
+    // simulate on a private context
+    const auto context = std::make_shared<SimulationContext>(std::make_shared<EventQueue>());
+    const auto topology = construct_topology(network_parser, context);
+
+    const auto dims_count = network_parser.get_dims_count();
+    const auto npus_counts_per_dim = network_parser.get_npus_counts_per_dim();
+    const auto bandwidths_per_dim = network_parser.get_bandwidths_per_dim();
+    const auto latencies_per_dim = network_parser.get_latencies_per_dim();
+
+    auto calibration = Calibration();
+    auto stride = 1;
+    for (auto dim = 0; dim < dims_count; dim++) {
+        // NPUs of the dimension's line through NPU 0
+        const auto npus_count = npus_counts_per_dim[dim];
+        const auto npu = [stride](const int local_id) { return local_id * stride; };
+        const auto latency = latencies_per_dim[dim];
+        const auto bandwidth_Bpns = bw_GBps_to_Bpns(bandwidths_per_dim[dim]);
+        stride *= npus_count;
+
+        auto samples = std::vector<Sample>();
+
+        // single transfers of varying sizes
+        for (auto dest = 1; dest < npus_count; dest++) {
+            for (const auto size : {chunk_size / 4, chunk_size, chunk_size * 4}) {
+                run_pattern(*topology, {{npu(0), npu(dest), std::max<ChunkSize>(size, 1)}}, latency, bandwidth_Bpns,
+                            samples);
+            }
+        }
+
+        // shifts to the next and the opposite NPUs
+        for (const auto distance : {1, npus_count / 2}) {
+            auto transfers = std::vector<Transfer>();
+            for (auto src = 0; src < npus_count; src++) {
+                transfers.push_back({npu(src), npu((src + distance) % npus_count), chunk_size});
+            }
+            run_pattern(*topology, transfers, latency, bandwidth_Bpns, samples);
+        }
+
+        // all-to-all
+        auto transfers = std::vector<Transfer>();
+        for (auto src = 0; src < npus_count; src++) {
+            for (auto dest = 0; dest < npus_count; dest++) {
+                if (src != dest) {
+                    transfers.push_back({npu(src), npu(dest), chunk_size});
+                }
+            }
+        }
+        run_pattern(*topology, transfers, latency, bandwidth_Bpns, samples);
+
+        // fit delay ~ a * latency_term + b * bandwidth_term, dividing each sample by its delay
+        // so the relative error is minimized: normal equations of rows (x / delay) and target 1
+        auto total_weight = 0.0;
+        auto s11 = 0.0, s12 = 0.0, s22 = 0.0, t1 = 0.0, t2 = 0.0;
+        for (const auto& sample : samples) {
+            assert(sample.delay > 0);
+            const auto x1 = sample.latency_term / sample.delay;
+            const auto x2 = sample.bandwidth_term / sample.delay;
+            s11 += sample.weight * x1 * x1;
+            s12 += sample.weight * x1 * x2;
+            s22 += sample.weight * x2 * x2;
+            t1 += sample.weight * x1;
+            t2 += sample.weight * x2;
+            total_weight += sample.weight;
+        }
+        auto latency_factor = 1.0;
+        auto bandwidth_factor = 1.0;
+        const auto determinant = (s11 * s22) - (s12 * s12);
+        if (std::abs(determinant) > std::numeric_limits<double>::epsilon() * s11 * s22) {
+            latency_factor = ((t1 * s22) - (t2 * s12)) / determinant;
+            bandwidth_factor = ((s11 * t2) - (s12 * t1)) / determinant;
+        }
+        if (latency_factor <= 0 || bandwidth_factor <= 0) {
+            // degenerate (e.g., zero latency): keep the latency, fit the bandwidth alone
+            latency_factor = 1.0;
+            bandwidth_factor = (s22 > 0) ? ((t2 - s12) / s22) : 1.0;
+            bandwidth_factor = (bandwidth_factor > 0) ? bandwidth_factor : 1.0;
+        }
+
+        // error of the calibrated closed form
+        auto error = 0.0;
+        for (const auto& sample : samples) {
+            const auto predicted = (latency_factor * sample.latency_term) + (bandwidth_factor * sample.bandwidth_term);
+            error += sample.weight * std::abs(predicted - sample.delay) / sample.delay;
+        }
+
+        // a larger bandwidth term is a smaller effective bandwidth
+        calibration.bandwidth_scale_per_dim.push_back(1.0 / bandwidth_factor);
+        calibration.latency_scale_per_dim.push_back(latency_factor);
+        calibration.error_per_dim.push_back(error / total_weight);
+    }
+
+    return calibration;
+}
+
+bool NetworkAnalyticalCongestionAware::save_calibration(const Calibration& calibration,
+                                                        const std::string& path) noexcept {
+    assert(calibration.bandwidth_scale_per_dim.size() == calibration.latency_scale_per_dim.size());
+
+    auto file = std::ofstream(path, std::ios::trunc);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    const auto write_list = [&file](const char* const key, const std::vector<double>& values) {
+        file << key << ": [ ";
+        for (auto i = static_cast<size_t>(0); i < values.size(); i++) {
+            file << ((i > 0) ? ", " : "") << values[i];
+        }
+        file << " ]\n";
+    };
+
+    file.precision(std::numeric_limits<double>::max_digits10);
+    file << "# Calibration of the congestion-unaware backend against the congestion-aware one\n";
+    write_list("bandwidth_scale", calibration.bandwidth_scale_per_dim);
+    write_list("latency_scale", calibration.latency_scale_per_dim);
+    write_list("# mean relative error", calibration.error_per_dim);
+    return static_cast<bool>(file);
+}
@@ -0,0 +1,387 @@
+/******************************************************************************
+This source code is licensed under the MIT license found in the
+LICENSE file in the root directory of this source tree.
+*******************************************************************************/
+
+#include "congestion_aware/Collective.h"
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <iostream>
+
+using namespace NetworkAnalytical;
+using namespace NetworkAnalyticalCongestionAware;
+
+Collective::Collective(std::shared_ptr<Topology> topology,
+                       const Type type,
+                       const Algorithm algorithm,
+                       const ChunkSize size,
+                       const ChunkSize chunk_size) noexcept
+    : topology(std::move(topology)),
+      chunk_size(chunk_size),
+      arrived_steps_count(0),
+      live_steps_count(0) {
+    assert(this->topology != nullptr);
+    assert(size > 0);
+    assert(chunk_size > 0);
+
+    const auto npus_count = this->topology->get_npus_count();
+    ready_steps.resize(npus_count);
+
+    if (algorithm != Algorithm::Hierarchical) {
+        auto group = std::vector<DeviceId>(npus_count);
+        for (auto npu = 0; npu < npus_count; npu++) {
+            group[npu] = npu;
+        }
+        add_collective(group, type, algorithm, size);
+        build_dependents();
+        return;
+    }
+
+    // hierarchical: reduce-scatter up the dimensions, all-gather back down
+    const auto dims_count = this->topology->get_dims_count();
+    const auto npus_count_per_dim = this->topology->get_npus_count_per_dim();
+    auto size_per_dim = std::vector<ChunkSize>(dims_count);
+    auto dim_size = size;
+    for (auto dim = 0; dim < dims_count; dim++) {
+        size_per_dim[dim] = dim_size;
+        dim_size = std::max<ChunkSize>(dim_size / npus_count_per_dim[dim], 1);
+    }
+
+    if (type == Type::AllToAll) {
+        for (auto dim = 0; dim < dims_count; dim++) {
+            for (const auto& group : get_dim_groups(dim)) {
+                add_collective(group, Type::AllToAll, Algorithm::Direct, size);
+            }
+        }
+    }
+    if (type == Type::ReduceScatter || type == Type::AllReduce) {
+        for (auto dim = 0; dim < dims_count; dim++) {
+            for (const auto& group : get_dim_groups(dim)) {
+                add_collective(group, Type::ReduceScatter, Algorithm::Ring, size_per_dim[dim]);
+            }
+        }
+    }
+    if (type == Type::AllGather || type == Type::AllReduce) {
+        for (auto dim = dims_count - 1; dim >= 0; dim--) {
+            for (const auto& group : get_dim_groups(dim)) {
+                add_collective(group, Type::AllGather, Algorithm::Ring, size_per_dim[dim]);
+            }
+        }
+    }
+    build_dependents();
+}
+
+void Collective::start(const Callback callback, const CallbackArg callback_arg) noexcept {
+    assert(callback != nullptr);
+
+    start(EventCallback(callback, callback_arg));
+}
+
+void Collective::start(EventCallback callback) noexcept {
+    assert(callback);
+    assert(live_steps_count == 0);
+
+    this->callback = std::move(callback);
+    remaining_dependencies = dependencies_counts;
+    arrived_steps_count = 0;
+
+    const auto steps_count = get_steps_count();
+    if (steps_count == 0) {
+        auto done = std::move(this->callback);
+        done();
+        return;
+    }
+
+    // only steps with no dependencies are live at first
+    for (auto step = 0; step < steps_count; step++) {
+        if (dependencies_counts[step] == 0) {
+            send_step(step);
+        }
+    }
+}
+
+int Collective::get_steps_count() const noexcept {
+    return static_cast<int>(step_srcs.size());
+}
+
+int Collective::get_live_steps_count() const noexcept {
+    return live_steps_count;
+}
+
+bool Collective::finished() const noexcept {
+    return live_steps_count == 0 && arrived_steps_count == get_steps_count();
+}
+
+int Collective::add_step(const DeviceId src,
+                         const DeviceId dest,
+                         const ChunkSize size,
+                         const std::vector<int>& dependencies) noexcept {
+    assert(src != dest);
+
+    const auto step = get_steps_count();
+    step_srcs.push_back(src);
+    step_dests.push_back(dest);
+    step_sizes.push_back(std::max<ChunkSize>(size, 1));
+    dependencies_counts.push_back(static_cast<int>(dependencies.size()));
+    for (const auto dependency : dependencies) {
+        dependency_edges.emplace_back(dependency, step);
+    }
+    return step;
+}
+
+void Collective::add_ring(const std::vector<DeviceId>& group, const std::vector<ChunkSize>& block_sizes) noexcept {
+    const auto members_count = static_cast<int>(group.size());
+    if (block_sizes.empty()) {
+        return;
+    }
+
+    // received[i] -> step that delivered the last block to member i
+    auto received = std::vector<int>(members_count);
+    for (auto s = static_cast<size_t>(0); s < block_sizes.size(); s++) {
+        auto sent = std::vector<int>(members_count);
+        for (auto i = 0; i < members_count; i++) {
+            const auto next = (i + 1) % members_count;
+            const auto& dependencies = (s == 0) ? ready_steps[group[i]] : std::vector<int>{received[i]};
+            sent[next] = add_step(group[i], group[next], block_sizes[s], dependencies);
+        }
+        received = std::move(sent);
+    }
+
+    for (auto i = 0; i < members_count; i++) {
+        ready_steps[group[i]] = {received[i]};
+    }
+}
+
+void Collective::add_direct(const std::vector<DeviceId>& group, const ChunkSize block_size) noexcept {
+    const auto members_count = static_cast<int>(group.size());
+
+    auto received = std::vector<std::vector<int>>(members_count);
+    for (auto i = 0; i < members_count; i++) {
+        for (auto j = 0; j < members_count; j++) {
+            if (i != j) {
+                received[j].push_back(add_step(group[i], group[j], block_size, ready_steps[group[i]]));
+            }
+        }
+    }
+
+    for (auto i = 0; i < members_count; i++) {
+        ready_steps[group[i]] = std::move(received[i]);
+    }
+}
+
+void Collective::add_pairwise_exchange(const std::vector<DeviceId>& group,
+                                       const std::vector<int>& distances,
+                                       const std::vector<ChunkSize>& block_sizes) noexcept {
+    assert(distances.size() == block_sizes.size());
+
+    const auto members_count = static_cast<int>(group.size());
+    if (distances.empty()) {
+        return;
+    }
+
+    auto received = std::vector<int>(members_count);
+    for (auto s = static_cast<size_t>(0); s < distances.size(); s++) {
+        auto sent = std::vector<int>(members_count);
+        for (auto i = 0; i < members_count; i++) {
+            const auto partner = i ^ distances[s];
+            assert(partner < members_count);
+            const auto& dependencies = (s == 0) ? ready_steps[group[i]] : std::vector<int>{received[i]};
+            sent[partner] = add_step(group[i], group[partner], block_sizes[s], dependencies);
+        }
+        received = std::move(sent);
+    }
+
+    for (auto i = 0; i < members_count; i++) {
+        ready_steps[group[i]] = {received[i]};
+    }
+}
+
+void Collective::add_tree_reduce(const std::vector<DeviceId>& group, const ChunkSize size) noexcept {
+    // children have larger indices, so they're sent before their parent
+    for (auto i = static_cast<int>(group.size()) - 1; i > 0; i--) {
+        const auto parent = (i - 1) / 2;
+        const auto step = add_step(group[i], group[parent], size, ready_steps[group[i]]);
+        ready_steps[group[parent]].push_back(step);
+    }
+}
+
+void Collective::add_tree_broadcast(const std::vector<DeviceId>& group, const ChunkSize size) noexcept {
+    // parents have smaller indices, so they received the buffer before their children
+    for (auto i = 1; i < static_cast<int>(group.size()); i++) {
+        const auto parent = (i - 1) / 2;
+        const auto step = add_step(group[parent], group[i], size, ready_steps[group[parent]]);
+        ready_steps[group[i]] = {step};
+    }
+}
+
+void Collective::add_collective(const std::vector<DeviceId>& group,
+                                const Type type,
+                                const Algorithm algorithm,
+                                const ChunkSize size) noexcept {
+    const auto members_count = static_cast<int>(group.size());
+    if (members_count <= 1) {
+        return;
+    }
+    const auto block_size = std::max<ChunkSize>(size / members_count, 1);
+    const auto reduce_scatter = (type == Type::ReduceScatter || type == Type::AllReduce);
+    const auto all_gather = (type == Type::AllGather || type == Type::AllReduce);
+
+    switch (algorithm) {
+    case Algorithm::Ring: {
+        if (type == Type::AllToAll) {
+            // every member relays the blocks of the members further down the ring
+            auto block_sizes = std::vector<ChunkSize>();
+            for (auto s = 0; s < members_count - 1; s++) {
+                block_sizes.push_back(block_size * (members_count - 1 - s));
+            }
+            add_ring(group, block_sizes);
+            return;
+        }
+        const auto block_sizes = std::vector<ChunkSize>(members_count - 1, block_size);
+        if (reduce_scatter) {
+            add_ring(group, block_sizes);
+        }
+        if (all_gather) {
+            add_ring(group, block_sizes);
+        }
+        return;
+    }
+    case Algorithm::Direct:
+        if (type == Type::AllToAll || reduce_scatter) {
+            add_direct(group, block_size);
+        }
+        if (all_gather) {
+            add_direct(group, block_size);
+        }
+        return;
+    case Algorithm::HalvingDoubling: {
+        if ((members_count & (members_count - 1)) != 0) {
+            std::cerr << "[Error] (network/analytical/congestion_aware) "
+                      << "HalvingDoubling needs a power-of-2 number of NPUs" << std::endl;
+            std::exit(-1);
+        }
+        auto doubling_distances = std::vector<int>();
+        for (auto distance = 1; distance < members_count; distance *= 2) {
+            doubling_distances.push_back(distance);
+        }
+        const auto halving_distances = std::vector<int>(doubling_distances.rbegin(), doubling_distances.rend());
+
+        if (type == Type::AllToAll) {
+            // every exchange swaps half of the buffer
+            add_pairwise_exchange(group, doubling_distances,
+                                  std::vector<ChunkSize>(doubling_distances.size(), std::max<ChunkSize>(size / 2, 1)));
+            return;
+        }
+        if (reduce_scatter) {
+            // the exchanged half shrinks with the distance
+            auto block_sizes = std::vector<ChunkSize>();
+            for (const auto distance : halving_distances) {
+                block_sizes.push_back(block_size * distance);
+            }
+            add_pairwise_exchange(group, halving_distances, block_sizes);
+        }
+        if (all_gather) {
+            // the exchanged block grows with the distance
+            auto block_sizes = std::vector<ChunkSize>();
+            for (const auto distance : doubling_distances) {
+                block_sizes.push_back(block_size * distance);
+            }
+            add_pairwise_exchange(group, doubling_distances, block_sizes);
+        }
+        return;
+    }
+    case Algorithm::Tree:
+        if (type != Type::AllReduce) {
+            std::cerr << "[Error] (network/analytical/congestion_aware) " << "Tree only supports AllReduce"
+                      << std::endl;
+            std::exit(-1);
+        }
+        add_tree_reduce(group, size);
+        add_tree_broadcast(group, size);
+        return;
+    default:
+        // shouldn't reach here
+        std::cerr << "[Error] (network/analytical/congestion_aware) " << "Not supported collective algorithm"
+                  << std::endl;
+        std::exit(-1);
+    }
+}
+
+std::vector<std::vector<DeviceId>> Collective::get_dim_groups(const int dim) const noexcept {
+    const auto npus_count = topology->get_npus_count();
+    const auto npus_count_per_dim = topology->get_npus_count_per_dim();
+    assert(0 <= dim && dim < static_cast<int>(npus_count_per_dim.size()));
+
+    // NPU ids follow their address, the first dimension varying fastest
+    auto stride = 1;
+    for (auto d = 0; d < dim; d++) {
+        stride *= npus_count_per_dim[d];
+    }
+    const auto dim_npus_count = npus_count_per_dim[dim];
+
+    auto groups = std::vector<std::vector<DeviceId>>();
+    for (auto npu = 0; npu < npus_count; npu++) {
+        if ((npu / stride) % dim_npus_count != 0) {
+            continue;
+        }
+        auto group = std::vector<DeviceId>(dim_npus_count);
+        for (auto i = 0; i < dim_npus_count; i++) {
+            group[i] = npu + (i * stride);
+        }
+        groups.push_back(std::move(group));
+    }
+    return groups;
+}
+
+void Collective::build_dependents() noexcept {
+    const auto steps_count = get_steps_count();
+
+    // counting sort of the edges by the step waited for
+    dependent_offsets.assign(steps_count + 1, 0);
+    for (const auto& [dependency, step] : dependency_edges) {
+        dependent_offsets[dependency + 1]++;
+    }
+    for (auto s = 0; s < steps_count; s++) {
+        dependent_offsets[s + 1] += dependent_offsets[s];
+    }
+    dependents.resize(dependency_edges.size());
+    auto next_offsets = std::vector<int>(dependent_offsets.begin(), dependent_offsets.end() - 1);
+    for (const auto& [dependency, step] : dependency_edges) {
+        dependents[next_offsets[dependency]++] = step;
+    }
+
+    // unrolling state isn't needed anymore
+    ready_steps = {};
+    dependency_edges = {};
+}
+
+void Collective::send_step(const int step) noexcept {
+    assert(0 <= step && step < get_steps_count());
+
+    live_steps_count++;
+    const auto size = step_sizes[step];
+    topology->send_message(step_srcs[step], step_dests[step], size, std::min(chunk_size, size),
+                           [this, step]() { step_arrived(step); });
+}
+
+void Collective::step_arrived(const int step) noexcept {
+    assert(0 <= step && step < get_steps_count());
+    assert(live_steps_count > 0);
+
+    live_steps_count--;
+    arrived_steps_count++;
+
+    // release the dependents whose last dependency this was
+    for (auto i = dependent_offsets[step]; i < dependent_offsets[step + 1]; i++) {
+        const auto dependent = dependents[i];
+        if (--remaining_dependencies[dependent] == 0) {
+            send_step(dependent);
+        }
+    }
+
+    if (arrived_steps_count == get_steps_count()) {
+        auto done = std::move(callback);
+        done();
+    }
+}
@@ -5,9 +5,11 @@ LICENSE file in the root directory of this source tree.
 
 #include "common/EventQueue.h"
 #include "common/NetworkParser.h"
-#include "congestion_aware/Chunk.h"
+#include "congestion_aware/Collective.h"
 #include "congestion_aware/Helper.h"
+#include "congestion_aware/SymmetricSimulation.h"
 #include <iostream>
+#include <vector>
 
 using namespace NetworkAnalytical;
 using namespace NetworkAnalyticalCongestionAware;
@@ -36,26 +38,21 @@ int main() {
     const auto chunk_size = 1'048'576;  // 1 MB
 
     // Run All-Gather
+    // chunks are sent straight from (src, dest), using the routes cached by the topology
+    auto* const event_queue_ptr = static_cast<void*>(event_queue.get());
     for (int i = 0; i < npus_count; i++) {
         for (int j = 0; j < npus_count; j++) {
             if (i == j) {
                 continue;
             }
 
-            // crate a chunk
-            auto route = topology->route(i, j);
-            auto* event_queue_ptr = static_cast<void*>(event_queue.get());
-            auto chunk = std::make_unique<Chunk>(chunk_size, route, chunk_arrived_callback, event_queue_ptr);
-
             // send a chunk
-            topology->send(std::move(chunk));
+            topology->send(i, j, chunk_size, chunk_arrived_callback, event_queue_ptr);
         }
     }
 
     // Run simulation
-    while (!event_queue->finished()) {
-        event_queue->proceed();
-    }
+    event_queue->run();
 
     // Print simulation result
     const auto finish_time = event_queue->get_current_time();
@@ -63,5 +60,26 @@ int main() {
     std::cout << "Total devices Count: " << devices_count << std::endl;
     std::cout << "Simulation finished at time: " << finish_time << " ns" << std::endl;
 
+    // Run the same All-Gather as a ring collective
+    // each ring step is released once the previous step arrived
+    auto all_gather = Collective(topology, Collective::Type::AllGather, Collective::Algorithm::Ring,
+                                 chunk_size * npus_count, chunk_size);
+    all_gather.start([]() {});
+    event_queue->run();
+    std::cout << "Ring All-Gather took: " << event_queue->get_current_time() - finish_time << " ns" << std::endl;
+
+    // Run the All-Gather pattern again with symmetry reduction
+    // every NPU sends to the images of NPU 0's dests in the same order, so only NPU 0's chunks are simulated
+    const auto start_time = event_queue->get_current_time();
+    auto transfers = std::vector<SymmetricSimulation::Transfer>();
+    for (int i = 0; i < npus_count; i++) {
+        for (int j = 1; j < npus_count; j++) {
+            transfers.push_back({i, topology->map_by_symmetry(j, i), chunk_size});
+        }
+    }
+    const auto result = SymmetricSimulation(topology).run(transfers);
+    std::cout << "Symmetric All-Gather simulated " << result.simulated_transfers_count << " of " << transfers.size()
+              << " chunks, and took: " << event_queue->get_current_time() - start_time << " ns" << std::endl;
+
     return 0;
 }
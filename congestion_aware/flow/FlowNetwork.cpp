@@ -0,0 +1,224 @@
+/******************************************************************************
+This source code is licensed under the MIT license found in the
+LICENSE file in the root directory of this source tree.
+*******************************************************************************/
+
+#include "congestion_aware/FlowNetwork.h"
+#include "common/NetworkFunction.h"
+#include "congestion_aware/Device.h"
+#include "congestion_aware/Link.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <iterator>
+#include <limits>
+#include <utility>
+
+using namespace NetworkAnalyticalCongestionAware;
+
+void FlowNetwork::on_update(void* const flow_network_ptr) noexcept {
+    assert(flow_network_ptr != nullptr);
+
+    // cast to FlowNetwork*
+    auto* const flow_network = static_cast<FlowNetwork*>(flow_network_ptr);
+    flow_network->next_update_scheduled = false;
+
+    // settle the progress at the old rates, then re-share the bandwidth
+    flow_network->update_progress();
+    flow_network->complete_transmitted_flows();
+    flow_network->compute_rates();
+
+    // next update happens when the first remaining flow finishes transmitting
+    auto next_completion_time = std::numeric_limits<EventTime>::max();
+    const auto current_time = flow_network->event_queue->get_current_time();
+    for (const auto& flow : flow_network->active_flows) {
+        assert(flow.rate > 0);
+        const auto transmission_time = static_cast<EventTime>(std::ceil(flow.remaining_bytes / flow.rate));
+        next_completion_time = std::min(next_completion_time, current_time + transmission_time);
+    }
+
+    if (!flow_network->active_flows.empty()) {
+        flow_network->schedule_update(next_completion_time);
+    }
+}
+
+FlowNetwork::FlowNetwork(std::shared_ptr<Topology> topology, std::shared_ptr<EventQueue> event_queue) noexcept
+    : topology(std::move(topology)),
+      event_queue(std::move(event_queue)),
+      last_update_time(0),
+      next_update_time(0),
+      next_update_scheduled(false) {
+    assert(this->topology != nullptr);
+    assert(this->event_queue != nullptr);
+
+    last_update_time = this->event_queue->get_current_time();
+}
+
+void FlowNetwork::start_flow(const DeviceId src,
+                             const DeviceId dest,
+                             const ChunkSize size,
+                             const Callback callback,
+                             const CallbackArg callback_arg) noexcept {
+    assert(callback != nullptr);
+
+    start_flow(src, dest, size, EventCallback(callback, callback_arg));
+}
+
+void FlowNetwork::start_flow(const DeviceId src,
+                             const DeviceId dest,
+                             const ChunkSize size,
+                             EventCallback callback) noexcept {
+    assert(src != dest);
+    assert(size > 0);
+    assert(callback);
+
+    // resolve the links along the route
+    auto flow = Flow{{}, static_cast<double>(size), 0, 0, std::move(callback)};
+    const auto route = topology->route(src, dest);
+    for (auto it = route.begin(), next = std::next(route.begin()); next != route.end(); it++, next++) {
+        auto& device = **it;
+        const auto port = device.get_port((*next)->get_id());
+        assert(port >= 0);
+
+        flow.links.push_back(get_flow_link(device, port));
+        flow.route_latency += device.get_link(port).get_latency();
+    }
+
+    // account the running flows up to now, as rates change from now on
+    update_progress();
+    active_flows.push_back(std::move(flow));
+
+    // flows started at the same time share a single rate computation
+    schedule_update(event_queue->get_current_time());
+}
+
+int FlowNetwork::get_active_flows_count() const noexcept {
+    return static_cast<int>(active_flows.size());
+}
+
+Bandwidth FlowNetwork::get_active_flow_rate(const int flow_index) const noexcept {
+    assert(0 <= flow_index && flow_index < get_active_flows_count());
+
+    return active_flows[flow_index].rate;
+}
+
+int FlowNetwork::get_flow_link(Device& device, const PortId port) noexcept {
+    assert(port >= 0);
+
+    const auto key = (static_cast<uint64_t>(device.get_id()) << 32) | static_cast<uint32_t>(port);
+    const auto it = flow_link_indices.find(key);
+    if (it != flow_link_indices.end()) {
+        return it->second;
+    }
+
+    // register the link
+    const auto index = static_cast<int>(flow_links.size());
+    flow_links.push_back({bw_GBps_to_Bpns(device.get_link(port).get_bandwidth())});
+    flow_link_indices.emplace(key, index);
+    return index;
+}
+
+void FlowNetwork::update_progress() noexcept {
+    const auto current_time = event_queue->get_current_time();
+    assert(current_time >= last_update_time);
+
+    // every flow progressed at its current rate since the last update
+    const auto elapsed_time = static_cast<double>(current_time - last_update_time);
+    if (elapsed_time > 0) {
+        for (auto& flow : active_flows) {
+            flow.remaining_bytes -= flow.rate * elapsed_time;
+        }
+    }
+
+    last_update_time = current_time;
+}
+
+void FlowNetwork::complete_transmitted_flows() noexcept {
+    const auto current_time = event_queue->get_current_time();
+
+    // keep the start order of the remaining flows
+    auto remaining_flows_count = static_cast<size_t>(0);
+    for (auto& flow : active_flows) {
+        if (flow.remaining_bytes > remaining_bytes_epsilon) {
+            if (&active_flows[remaining_flows_count] != &flow) {
+                active_flows[remaining_flows_count] = std::move(flow);
+            }
+            remaining_flows_count++;
+            continue;
+        }
+
+        // the last byte reaches dest after the route latency
+        const auto arrival_time = current_time + static_cast<EventTime>(flow.route_latency);
+        event_queue->schedule_event(arrival_time, std::move(flow.callback));
+    }
+    active_flows.erase(active_flows.begin() + static_cast<std::ptrdiff_t>(remaining_flows_count), active_flows.end());
+}
+
+void FlowNetwork::compute_rates() noexcept {
+    // progressive filling: repeatedly saturate the link with the smallest fair share
+    const auto links_count = flow_links.size();
+    auto remaining_capacity = std::vector<Bandwidth>(links_count);
+    auto unfrozen_flows_count = std::vector<int>(links_count, 0);
+    for (auto i = static_cast<size_t>(0); i < links_count; i++) {
+        remaining_capacity[i] = flow_links[i].capacity;
+    }
+    for (const auto& flow : active_flows) {
+        for (const auto link : flow.links) {
+            unfrozen_flows_count[link]++;
+        }
+    }
+
+    auto frozen = std::vector<bool>(active_flows.size(), false);
+    auto frozen_count = static_cast<size_t>(0);
+    while (frozen_count < active_flows.size()) {
+        // find the bottleneck link
+        auto bottleneck = -1;
+        auto fair_share = std::numeric_limits<Bandwidth>::max();
+        for (auto i = static_cast<size_t>(0); i < links_count; i++) {
+            if (unfrozen_flows_count[i] == 0) {
+                continue;
+            }
+            const auto share = remaining_capacity[i] / unfrozen_flows_count[i];
+            if (share < fair_share) {
+                fair_share = share;
+                bottleneck = static_cast<int>(i);
+            }
+        }
+        assert(bottleneck >= 0);
+
+        // every flow crossing the bottleneck gets the fair share
+        for (auto f = static_cast<size_t>(0); f < active_flows.size(); f++) {
+            if (frozen[f]) {
+                continue;
+            }
+            auto& flow = active_flows[f];
+            if (std::find(flow.links.begin(), flow.links.end(), bottleneck) == flow.links.end()) {
+                continue;
+            }
+
+            flow.rate = fair_share;
+            frozen[f] = true;
+            frozen_count++;
+            for (const auto link : flow.links) {
+                remaining_capacity[link] -= fair_share;
+                unfrozen_flows_count[link]--;
+            }
+        }
+    }
+}
+
+void FlowNetwork::schedule_update(const EventTime update_time) noexcept {
+    // an earlier update recomputes everything anyway
+    if (next_update_scheduled && next_update_time <= update_time) {
+        return;
+    }
+
+    if (next_update_scheduled) {
+        event_queue->cancel_event(next_update_event);
+    }
+
+    next_update_event = event_queue->schedule_event(update_time, on_update, static_cast<void*>(this));
+    next_update_time = update_time;
+    next_update_scheduled = true;
+}
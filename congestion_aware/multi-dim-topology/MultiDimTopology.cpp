@@ -9,6 +9,7 @@ LICENSE file in the root directory of this source tree.
 #include <cstdlib>
 #include <iostream>
 #include <algorithm>
+#include <limits>
 
 using namespace NetworkAnalytical;
 using namespace NetworkAnalyticalCongestionAware;
@@ -17,9 +18,7 @@ MultiDimTopology::MultiDimTopology() noexcept : Topology() {
     // initialize values
     topology_per_dim.clear();
     npus_count_per_dim = {};
-    topology_slices_per_dim.clear();
     latency_per_dim.clear();
-    slices_initialized = false;
 
     // initialize topology shape
     npus_count = 1;
@@ -32,99 +31,190 @@ MultiDimTopology::MultiDimTopology() noexcept : Topology() {
     }
 }
 
+MultiDimTopology::DimOrder MultiDimTopology::parse_dim_order(const std::string& dim_order_str) noexcept {
+    if (dim_order_str == "static" || dim_order_str.empty()) {
+        return DimOrder::Static;
+    } else if (dim_order_str == "reverse") {
+        return DimOrder::Reverse;
+    } else if (dim_order_str == "adaptive") {
+        return DimOrder::Adaptive;
+    } else {
+        std::cerr << "[Error] Unknown dimension order: " << dim_order_str << ". Defaulting to static." << std::endl;
+        return DimOrder::Static;
+    }
+}
+
+void MultiDimTopology::set_dim_order(const DimOrder dim_order) noexcept {
+    // cached routes would follow the previous order
+    assert(route_hops_cache.empty());
+
+    this->dim_order = dim_order;
+    update_static_routes();
+}
+
+MultiDimTopology::DimOrder MultiDimTopology::get_dim_order() const noexcept {
+    return dim_order;
+}
+
 Route MultiDimTopology::route(const DeviceId src, const DeviceId dest) const noexcept {
-    // translate src and dest to multi-dim address
-    auto current_address = translate_address(src);
-    const auto dest_address = translate_address(dest);
-
-    // helper: convert multi-dim address to global id
-    const auto address_to_global = [this](const MultiDimAddress& address) -> DeviceId {
-        DeviceId global_id = 0;
-        for (int d = dims_count - 1; d >= 0; --d) {
-            global_id = global_id * npus_count_per_dim[d] + address[d];
-        }
-        return global_id;
-    };
+    assert(0 <= src && src < npus_count);
+    assert(0 <= dest && dest < npus_count);
 
     Route route;
     route.push_back(get_device_from_global_id(src));
 
-    // Dimension-ordered routing: traverse each dimension independently
-    for (int dim = 0; dim < dims_count; ++dim) {
-        if (current_address[dim] == dest_address[dim]) {
-            continue;
+    // appends the global device of a local NPU of dim, on the line through current
+    auto current = src;
+    const auto append_hop = [&](const int dim, const DeviceId line_base, const DeviceId local_id) {
+        assert(0 <= local_id && local_id < npus_count_per_dim[dim]);
+        const auto global_id = line_base + (local_id * stride_per_dim[dim]);
+        if (global_id != current) {
+            assert(devices[current]->connected(global_id) && "Consecutive devices in route are not connected");
+            route.push_back(get_device_from_global_id(global_id));
+            current = global_id;
         }
+    };
 
-        auto* const topology = topology_per_dim[dim].get();
-        const auto src_local_id = current_address[dim];
-        const auto dest_local_id = dest_address[dim];
-        auto local_route = topology->route(src_local_id, dest_local_id);
-
-        std::vector<DeviceId> local_ids;
-        local_ids.reserve(local_route.size() + 2);
-        for (const auto& local_dev : local_route) {
-            DeviceId local_id = local_dev->get_id();
-            if (local_id >= npus_count_per_dim[dim]) {
-                // Treat as a global id and extract this dimension's coordinate
-                const auto addr = translate_address(local_id);
-                local_id = addr[dim];
-            }
-            local_ids.push_back(local_id);
+    // dimensions where src and dest differ
+    auto pending_dims = PendingDims();
+    auto pending_dims_count = 0;
+    for (int dim = 0; dim < dims_count; ++dim) {
+        pending_dims[dim] = (get_local_id(src, dim) != get_local_id(dest, dim));
+        pending_dims_count += pending_dims[dim] ? 1 : 0;
+    }
+
+    // traverse each dimension independently, in the configured order
+    auto buffer = std::vector<DeviceId>();
+    for (; pending_dims_count > 0; pending_dims_count--) {
+        const auto dim = select_dim(current, dest, pending_dims, buffer);
+        pending_dims[dim] = false;
+
+        const auto src_local_id = get_local_id(current, dim);
+        const auto dest_local_id = get_local_id(dest, dim);
+
+        // global id of local NPU 0 on the line of dim through current
+        const auto line_base = current - (src_local_id * stride_per_dim[dim]);
+
+        const auto [first, last] = get_local_route(dim, src_local_id, dest_local_id, buffer);
+        for (auto it = first; it != last; it++) {
+            append_hop(dim, line_base, *it);
         }
-        if (local_ids.empty()) {
-            local_ids.push_back(src_local_id);
+        append_hop(dim, line_base, dest_local_id);
+    }
+
+    assert(route.front()->get_id() == src);
+    assert(route.back()->get_id() == dest);
+
+    return route;
+}
+
+DeviceId MultiDimTopology::map_by_symmetry(const DeviceId device, const DeviceId npu) const noexcept {
+    assert(0 <= device && device < npus_count);
+    assert(0 <= npu && npu < npus_count);
+
+    // map the address of each dimension on its own
+    auto mapped = 0;
+    for (auto dim = 0; dim < dims_count; dim++) {
+        const auto local_id =
+            topology_per_dim[dim]->map_by_symmetry(get_local_id(device, dim), get_local_id(npu, dim));
+        if (local_id < 0 || local_id >= npus_count_per_dim[dim]) {
+            return -1;
         }
-        if (local_ids.back() != dest_local_id) {
-            local_ids.push_back(dest_local_id);
+        mapped += local_id * stride_per_dim[dim];
+    }
+    return mapped;
+}
+
+void MultiDimTopology::set_routing_seed(const uint64_t seed) noexcept {
+    Topology::set_routing_seed(seed);
+    for (auto dim = 0; dim < dims_count; dim++) {
+        topology_per_dim[dim]->set_routing_seed(seed ^ (static_cast<uint64_t>(dim + 1) * 0x9E3779B97F4A7C15ULL));
+    }
+}
+
+void MultiDimTopology::reset() noexcept {
+    Topology::reset();
+    for (const auto& topology : topology_per_dim) {
+        topology->reset();
+    }
+}
+
+DeviceId MultiDimTopology::get_local_id(const DeviceId npu_id, const int dim) const noexcept {
+    return (npu_id / stride_per_dim[dim]) % npus_count_per_dim[dim];
+}
+
+MultiDimTopology::LocalRoute MultiDimTopology::get_local_route(const int dim,
+                                                               const DeviceId src_local_id,
+                                                               const DeviceId dest_local_id,
+                                                               std::vector<DeviceId>& buffer) const noexcept {
+    assert(src_local_id != dest_local_id);
+
+    // static routes: the recorded local route
+    const auto& local_route_offsets = local_route_offsets_per_dim[dim];
+    if (!local_route_offsets.empty()) {
+        const auto* const local_route_nodes = local_route_nodes_per_dim[dim].data();
+        const auto pair = (static_cast<size_t>(src_local_id) * npus_count_per_dim[dim]) + dest_local_id;
+        return {local_route_nodes + local_route_offsets[pair], local_route_nodes + local_route_offsets[pair + 1]};
+    }
+
+    // otherwise, route through the dimension's topology and fold the route into buffer
+    buffer.clear();
+    for (const auto& local_device : topology_per_dim[dim]->route(src_local_id, dest_local_id)) {
+        const auto local_id = fold_local_id(dim, local_device->get_id());
+        if (buffer.empty() || buffer.back() != local_id) {
+            buffer.push_back(local_id);
         }
+    }
+    return {buffer.data(), buffer.data() + buffer.size()};
+}
 
-        bool first = true;
-        for (const auto local_id : local_ids) {
-            assert(local_id >= 0 && local_id < npus_count_per_dim[dim]);
-            if (first && local_id == current_address[dim]) {
-                first = false;
-                continue;  // skip duplicate current node
-            }
-            first = false;
-
-            current_address[dim] = local_id;
-            const auto global_id = address_to_global(current_address);
-
-            if (route.empty() || route.back()->get_id() != global_id) {
-                // lazily connect consecutive nodes along this dimension
-                if (!route.empty()) {
-                    const auto prev_id = route.back()->get_id();
-                    if (!devices[prev_id]->connected(global_id)) {
-                        const_cast<MultiDimTopology*>(this)->connect(
-                            prev_id,
-                            global_id,
-                            bandwidth_per_dim[dim],
-                            latency_per_dim[dim],
-                            true);
-                    }
-                }
-                route.push_back(get_device_from_global_id(global_id));
+int MultiDimTopology::select_dim(const DeviceId current,
+                                 const DeviceId dest,
+                                 const PendingDims& pending_dims,
+                                 std::vector<DeviceId>& buffer) const noexcept {
+    if (dim_order == DimOrder::Reverse) {
+        for (int dim = dims_count - 1; dim >= 0; --dim) {
+            if (pending_dims[dim]) {
+                return dim;
             }
         }
     }
 
-    assert(route.front()->get_id() == src);
-    assert(route.back()->get_id() == dest);
+    auto selected_dim = -1;
+    auto least_drain_time = std::numeric_limits<double>::max();
+    for (int dim = 0; dim < dims_count; ++dim) {
+        if (!pending_dims[dim]) {
+            continue;
+        }
+        if (dim_order != DimOrder::Adaptive) {
+            return dim;
+        }
 
-    // Assert all devices in the route are non-null
-    for (const auto& dev : route) {
-        assert(dev != nullptr && "Null device in route");
+        // time to drain the backlog of the first link of the dimension's route
+        const auto src_local_id = get_local_id(current, dim);
+        const auto dest_local_id = get_local_id(dest, dim);
+        const auto [first, last] = get_local_route(dim, src_local_id, dest_local_id, buffer);
+        const auto next_local_id = (last - first >= 2) ? *(first + 1) : dest_local_id;
+        const auto next = current + ((next_local_id - src_local_id) * stride_per_dim[dim]);
+        const auto drain_time = static_cast<double>(get_link_backlog(current, next)) / bandwidth_per_dim[dim];
+
+        // ties go to the lower dimension, so an idle network routes in static order
+        if (drain_time < least_drain_time) {
+            selected_dim = dim;
+            least_drain_time = drain_time;
+        }
     }
 
-    // Assert each consecutive pair is connected
-    for (auto it = route.begin(); it != route.end();) {
-        auto curr = it++;
-        if (it == route.end()) break;
-        auto next = it;
-        assert((*curr)->connected((*next)->get_id()) && "Consecutive devices in route are not connected");
-    }
+    assert(selected_dim >= 0);
+    return selected_dim;
+}
 
-    return route;
+void MultiDimTopology::update_static_routes() noexcept {
+    // routes are static only if they're static in every dimension
+    static_routes = (dim_order != DimOrder::Adaptive);
+    for (const auto& topology : topology_per_dim) {
+        static_routes = static_routes && topology->has_static_routes();
+    }
 }
 
 // Helper: get the Device pointer for a global DeviceId
@@ -141,10 +231,42 @@ void MultiDimTopology::send(std::unique_ptr<Chunk> chunk) noexcept {
     // We simply delegate to the current device from the chunk's route.
     auto current_device = chunk->current_device();
     assert(current_device != nullptr);
+
+    // uncontended chunks skip the per-hop events
+    if (bind_simulation_context(*chunk).get_hybrid_fidelity() && send_uncontended(chunk)) {
+        return;
+    }
     current_device->send(std::move(chunk));
 }
 
 void MultiDimTopology::append_dimension(std::unique_ptr<BasicTopology> topology) noexcept {
+    auto topologies = std::vector<std::unique_ptr<BasicTopology>>();
+    topologies.push_back(std::move(topology));
+    append_dimensions(std::move(topologies));
+}
+
+void MultiDimTopology::append_dimensions(std::vector<std::unique_ptr<BasicTopology>> topologies) noexcept {
+    for (auto& topology : topologies) {
+        assert(topology != nullptr);
+        add_dimension(std::move(topology));
+    }
+
+    // rebuild global devices for the updated NPU count, with all their links
+    devices.clear();
+    instantiate_devices();
+    materialize_links();
+}
+
+void MultiDimTopology::add_dimension(std::unique_ptr<BasicTopology> topology) noexcept {
+    if (dims_count >= max_dims_count) {
+        std::cerr << "[Error] (network/analytical/congestion_aware) "
+                  << "MultiDimTopology supports at most " << max_dims_count << " dimensions" << std::endl;
+        std::exit(-1);
+    }
+
+    // NPUs one step apart in the new dimension are (NPUs of the previous dimensions) apart
+    stride_per_dim.push_back(npus_count);
+
     // increment dims_count
     dims_count++;
 
@@ -163,107 +285,177 @@ void MultiDimTopology::append_dimension(std::unique_ptr<BasicTopology> topology)
     // push back topology and npus_count
     topology_per_dim.push_back(std::move(topology));
     npus_count_per_dim.push_back(topology_size);
+    update_static_routes();
 
-    // reset per-slice initialization (dimensions changed)
-    slices_initialized = false;
-
-    // rebuild global devices for the updated NPU count
-    devices.clear();
-    instantiate_devices();
-
-    // eagerly build per-slice topologies for all dimensions
-    build_slices_and_validate();
+    // record the links and routes of the new dimension
+    build_local_routes();
 }
 
-void MultiDimTopology::ensure_slices_initialized() const noexcept {
-    if (slices_initialized) {
-        return;
+DeviceId MultiDimTopology::fold_local_id(const int dim, const DeviceId local_id) const noexcept {
+    assert(0 <= dim && dim < dims_count);
+    assert(local_id >= 0);
+
+    const auto npus = npus_count_per_dim[dim];
+    if (local_id < npus) {
+        return local_id;
     }
 
-    build_slices_and_validate();
+    // a non-NPU device stands for the coordinate its id would have in dim
+    return (local_id / stride_per_dim[dim]) % npus;
 }
 
-void MultiDimTopology::build_slices_and_validate() const noexcept {
-    topology_slices_per_dim.clear();
-    topology_slices_per_dim.resize(dims_count);
+void MultiDimTopology::build_local_routes() noexcept {
+    const auto dim = dims_count - 1;
+    const auto& topology = topology_per_dim[dim];
+    const auto npus = npus_count_per_dim[dim];
+
+    // fold every link of the topology onto the NPUs of the dimension
+    auto local_neighbors =
+        std::vector<TrackedVector<DeviceId>>(npus, TrackedVector<DeviceId>(TrackingAllocator<DeviceId>(dims_memory)));
+    for (DeviceId id = 0; id < topology->get_devices_count(); id++) {
+        const auto device = topology->get_device(id);
+        const auto src = fold_local_id(dim, id);
+        for (auto port = 0; port < device->get_ports_count(); port++) {
+            const auto dest = fold_local_id(dim, device->get_port_dest(port));
+            if (src != dest) {
+                local_neighbors[src].push_back(dest);
+                local_neighbors[dest].push_back(src);
+            }
+        }
+    }
+    for (auto& neighbors : local_neighbors) {
+        std::sort(neighbors.begin(), neighbors.end());
+        neighbors.erase(std::unique(neighbors.begin(), neighbors.end()), neighbors.end());
+    }
+    local_neighbors_per_dim.push_back(std::move(local_neighbors));
+
+    // routes that never change are recorded once in local ids
+    auto local_route_nodes = TrackedVector<DeviceId>(TrackingAllocator<DeviceId>(dims_memory));
+    auto local_route_offsets = TrackedVector<uint32_t>(TrackingAllocator<uint32_t>(dims_memory));
+    if (topology->has_static_routes()) {
+        local_route_offsets.reserve((static_cast<size_t>(npus) * npus) + 1);
+        local_route_offsets.push_back(0);
+        for (DeviceId src = 0; src < npus; src++) {
+            for (DeviceId dest = 0; dest < npus; dest++) {
+                if (src != dest) {
+                    auto previous_id = DeviceId(-1);
+                    for (const auto& local_device : topology->route(src, dest)) {
+                        const auto local_id = fold_local_id(dim, local_device->get_id());
+                        if (local_id != previous_id) {
+                            local_route_nodes.push_back(local_id);
+                            previous_id = local_id;
+                        }
+                    }
+                }
+                local_route_offsets.push_back(static_cast<uint32_t>(local_route_nodes.size()));
+            }
+        }
+    }
+    local_route_nodes_per_dim.push_back(std::move(local_route_nodes));
+    local_route_offsets_per_dim.push_back(std::move(local_route_offsets));
+}
 
+void MultiDimTopology::materialize_links() noexcept {
+    // large fully-connected dimensions create each link on its first use
+    auto lazy_dims = std::vector<bool>(dims_count, false);
     for (auto dim = 0; dim < dims_count; dim++) {
-        size_t slices_count = 1;
-        for (auto d = 0; d < dims_count; d++) {
-            if (d == dim) {
+        const auto npus = npus_count_per_dim[dim];
+        const auto& local_neighbors = local_neighbors_per_dim[dim];
+        lazy_dims[dim] = (npus >= lazy_links_min_count) &&
+                         std::all_of(local_neighbors.begin(), local_neighbors.end(),
+                                     [npus](const auto& neighbors) { return static_cast<int>(neighbors.size()) == npus - 1; });
+    }
+
+    for (DeviceId npu = 0; npu < npus_count; npu++) {
+        // lazy ports come after the connected ones
+        for (auto dim = 0; dim < dims_count; dim++) {
+            if (lazy_dims[dim]) {
                 continue;
             }
-            slices_count *= static_cast<size_t>(npus_count_per_dim[d]);
+            const auto stride = stride_per_dim[dim];
+            const auto local_id = (npu / stride) % npus_count_per_dim[dim];
+            for (const auto neighbor : local_neighbors_per_dim[dim][local_id]) {
+                // each direction is connected from its own src
+                const auto dest = npu + ((neighbor - local_id) * stride);
+                if (!devices[npu]->connected(dest)) {
+                    connect(npu, dest, bandwidth_per_dim[dim], latency_per_dim[dim], false);
+                }
+            }
         }
-
-        topology_slices_per_dim[dim].reserve(slices_count);
-        for (size_t i = 0; i < slices_count; i++) {
-            topology_slices_per_dim[dim].push_back(topology_per_dim[dim]->clone());
+        for (auto dim = 0; dim < dims_count; dim++) {
+            if (lazy_dims[dim]) {
+                // every NPU of the line through npu
+                const auto stride = stride_per_dim[dim];
+                const auto line_base = npu - (((npu / stride) % npus_count_per_dim[dim]) * stride);
+                devices[npu]->connect_lazily(line_base, stride, npus_count_per_dim[dim], bandwidth_per_dim[dim],
+                                             latency_per_dim[dim]);
+            }
         }
     }
+}
 
-    // validate reachability in each slice
+MemoryReport MultiDimTopology::memory_report() const noexcept {
+    auto report = Topology::memory_report();
+    report.dims = MemoryUsage::of(*dims_memory);
+    for (const auto& topology : topology_per_dim) {
+        // the event queue and chunk pool are counted once, by this topology
+        auto dim_report = topology->memory_report();
+        dim_report.event_queue = MemoryUsage();
+        dim_report.chunk_pool = MemoryUsage();
+        const auto dim_total = dim_report.get_total();
+        report.dims.bytes += dim_total.bytes;
+        report.dims.peak_bytes += dim_total.peak_bytes;
+    }
+    return report;
+}
+
+void MultiDimTopology::validate() const noexcept {
     for (auto dim = 0; dim < dims_count; dim++) {
         const auto npus = npus_count_per_dim[dim];
-        for (const auto& slice : topology_slices_per_dim[dim]) {
-            for (DeviceId src = 0; src < npus; src++) {
-                for (DeviceId dest = 0; dest < npus; dest++) {
-                    const auto route = slice->route(src, dest);
-                    assert(!route.empty());
-                    assert(route.front()->get_id() == src);
-                    assert(route.back()->get_id() == dest);
+        auto buffer = std::vector<DeviceId>();
+        for (DeviceId src = 0; src < npus; src++) {
+            for (DeviceId dest = 0; dest < npus; dest++) {
+                if (src == dest) {
+                    continue;
                 }
+
+                const auto [first, last] = get_local_route(dim, src, dest, buffer);
+                validate_local_route(dim, src, dest, first, last);
             }
         }
     }
-
-    slices_initialized = true;
 }
 
-size_t MultiDimTopology::get_slice_index(const int dim, const MultiDimAddress& address) const noexcept {
-    size_t index = 0;
-    for (auto d = 0; d < dims_count; d++) {
-        if (d == dim) {
-            continue;
-        }
-        index = index * static_cast<size_t>(npus_count_per_dim[d]) + static_cast<size_t>(address[d]);
+void MultiDimTopology::validate_local_route(const int dim,
+                                            const DeviceId src,
+                                            const DeviceId dest,
+                                            const DeviceId* const first,
+                                            const DeviceId* const last) const noexcept {
+    const auto& local_neighbors = local_neighbors_per_dim[dim];
+    auto valid = (first != last) && (*first == src) && (*(last - 1) == dest);
+    for (auto it = first; valid && (it + 1) != last; it++) {
+        const auto& neighbors = local_neighbors[*it];
+        valid = std::binary_search(neighbors.begin(), neighbors.end(), *(it + 1));
     }
 
-    return index;
+    if (!valid) {
+        std::cerr << "[Error] (network/analytical/congestion_aware) "
+                  << "broken route from " << src << " to " << dest << " in dimension " << dim << std::endl;
+        std::exit(-1);
+    }
 }
 
 MultiDimTopology::MultiDimAddress MultiDimTopology::translate_address(const DeviceId npu_id) const noexcept {
-    // If units-count if [2, 8, 4], and the given id is 47, then the id should be
-    // 47 // 16 = 2, leftover = 47 % 16 = 15
-    // 15 // 2 = 7, leftover = 15 % 2 = 1
-    // 1 // 1 = 1, leftover = 0
-    // therefore the address is [1, 7, 2]
+    assert(0 <= npu_id && npu_id < npus_count);
 
-    // create empty address
+    // If units-count if [2, 8, 4], and the given id is 47, then the strides are [1, 2, 16], and
+    // 47 // 1 % 2 = 1
+    // 47 // 2 % 8 = 7
+    // 47 // 16 % 4 = 2
+    // therefore the address is [1, 7, 2]
     auto multi_dim_address = MultiDimAddress();
-    for (auto i = 0; i < dims_count; i++) {
-        multi_dim_address.push_back(-1);
-    }
-
-    auto leftover = npu_id;
-    auto denominator = npus_count;
-
-    for (auto dim = dims_count - 1; dim >= 0; dim--) {
-        // change denominator
-        denominator /= npus_count_per_dim[dim];
-
-        // get and update address
-        const auto quotient = leftover / denominator;
-        leftover %= denominator;
-
-        // update address
-        multi_dim_address[dim] = quotient;
-    }
-
-    // check address translation
-    for (auto i = 0; i < dims_count; i++) {
-        assert(0 <= multi_dim_address[i]);
-        assert(multi_dim_address[i] < npus_count_per_dim[i]);
+    for (auto dim = 0; dim < dims_count; dim++) {
+        multi_dim_address[dim] = (npu_id / stride_per_dim[dim]) % npus_count_per_dim[dim];
     }
 
     // return retrieved address
@@ -4,9 +4,14 @@ LICENSE file in the root directory of this source tree.
 *******************************************************************************/
 
 #include "congestion_aware/Chunk.h"
+#include "congestion_aware/ChunkPool.h"
+#include "congestion_aware/CompletionBatcher.h"
 #include "congestion_aware/Device.h"
 #include "congestion_aware/Link.h"
+#include "congestion_aware/SimulationContext.h"
+#include <algorithm>
 #include <cassert>
+#include <iterator>
 
 using namespace NetworkAnalyticalCongestionAware;
 
@@ -14,15 +19,18 @@ void Chunk::chunk_arrived_next_device(void* const chunk_ptr) noexcept {
     assert(chunk_ptr != nullptr);
 
     // cast to unique_ptr<Chunk>
-    auto chunk = std::unique_ptr<Chunk>(static_cast<Chunk*>(chunk_ptr));
+    arrived_next_device(std::unique_ptr<Chunk>(static_cast<Chunk*>(chunk_ptr)));
+}
+
+void Chunk::arrived_next_device(std::unique_ptr<Chunk> chunk) noexcept {
+    assert(chunk != nullptr);
 
     // mark chunk arrived next node
     chunk->mark_arrived_next_device();
 
     if (chunk->arrived_dest()) {
-        // chunk arrived dest, invoke callback
-        // as chunk is unique_ptr, will be destroyed automatically
-        chunk->invoke_callback();
+        // chunk arrived dest, complete it
+        complete(std::move(chunk));
     } else {
         // send this chunk to next dest
         const auto current_node = chunk->current_device();
@@ -30,31 +38,235 @@ void Chunk::chunk_arrived_next_device(void* const chunk_ptr) noexcept {
     }
 }
 
+void Chunk::complete(std::unique_ptr<Chunk> chunk) noexcept {
+    assert(chunk != nullptr);
+
+    // as chunk is unique_ptr, will be destroyed automatically
+    auto* const context = chunk->get_simulation_context();
+    assert(context != nullptr);
+    if (chunk->is_per_hop()) {
+        context->remove_per_hop_chunk();
+    }
+    auto* const completion_batcher = context->get_completion_batcher();
+    if (completion_batcher == nullptr || !completion_batcher->gather(*chunk, context->get_event_queue())) {
+        chunk->invoke_callback();
+    }
+}
+
 Chunk::Chunk(const ChunkSize chunk_size, Route route, const Callback callback, const CallbackArg callback_arg) noexcept
     : chunk_size(chunk_size),
-      route(std::move(route)),
-      callback(callback),
-      callback_arg(callback_arg) {
+      inline_hops(),
+      implicit(false),
+      representative(false),
+      per_hop(false),
+      long_hops(nullptr),
+      hops_count(0),
+      cursor(0),
+      callback(callback, callback_arg),
+      trace_id(0),
+      tail_arrival_time(0),
+      traffic_class(0),
+      buffer_room(false),
+      context(nullptr) {
     assert(chunk_size > 0);
-    assert(!this->route.empty());
+    assert(!route.empty());
     assert(callback != nullptr);
+
+    set_route(route);
 }
 
-std::shared_ptr<Device> Chunk::current_device() const noexcept {
-    // assert the route is not empty
+Chunk::Chunk(const ChunkSize chunk_size, Route route, EventCallback callback) noexcept
+    : chunk_size(chunk_size),
+      inline_hops(),
+      implicit(false),
+      representative(false),
+      per_hop(false),
+      long_hops(nullptr),
+      hops_count(0),
+      cursor(0),
+      callback(std::move(callback)),
+      trace_id(0),
+      tail_arrival_time(0),
+      traffic_class(0),
+      buffer_room(false),
+      context(nullptr) {
+    assert(chunk_size > 0);
     assert(!route.empty());
+    assert(this->callback);
+
+    set_route(route);
+}
+
+Chunk::Chunk(const ChunkSize chunk_size, const RouteHops& route_hops, EventCallback callback) noexcept
+    : chunk_size(chunk_size),
+      inline_hops(),
+      implicit(false),
+      representative(false),
+      per_hop(false),
+      long_hops(nullptr),
+      hops_count(route_hops.size()),
+      cursor(0),
+      callback(std::move(callback)),
+      trace_id(0),
+      tail_arrival_time(0),
+      traffic_class(0),
+      buffer_room(false),
+      context(nullptr) {
+    assert(chunk_size > 0);
+    assert(!route_hops.empty());
+    assert(this->callback);
+
+    // short routes are copied inline, long ones are shared
+    if (hops_count > inline_hops_count) {
+        long_hops = route_hops.data();
+    } else {
+        std::copy(route_hops.begin(), route_hops.end(), inline_hops.begin());
+    }
+}
+
+Chunk::Chunk(const ChunkSize chunk_size, const RouteDescriptor& route_descriptor, EventCallback callback) noexcept
+    : chunk_size(chunk_size),
+      route_descriptor(route_descriptor),
+      implicit(true),
+      representative(false),
+      per_hop(false),
+      long_hops(nullptr),
+      hops_count(route_descriptor.hops_count),
+      cursor(0),
+      callback(std::move(callback)),
+      trace_id(0),
+      tail_arrival_time(0),
+      traffic_class(0),
+      buffer_room(false),
+      context(nullptr) {
+    assert(chunk_size > 0);
+    assert(route_descriptor.devices != nullptr);
+    assert(route_descriptor.hops_count >= 2);
+    assert(route_descriptor.via >= 0 ? route_descriptor.hops_count == 3 : route_descriptor.modulus > 0);
+    assert(this->callback);
+}
+
+void* Chunk::operator new(const size_t size) noexcept {
+    return ChunkPool::allocate(size);
+}
+
+void Chunk::operator delete(void* const ptr, const size_t size) noexcept {
+    ChunkPool::deallocate(ptr, size);
+}
+
+void Chunk::set_route(const Route& route) noexcept {
+    hops_count = route.size();
+
+    // long routes don't fit inline
+    if (hops_count > inline_hops_count) {
+        spilled_hops.resize(hops_count);
+        long_hops = spilled_hops.data();
+    }
+    auto* const hops = (hops_count > inline_hops_count) ? spilled_hops.data() : inline_hops.data();
+
+    // resolve the outgoing port of each hop once, instead of at every forwarding step
+    auto index = static_cast<size_t>(0);
+    for (auto it = route.begin(); it != route.end(); it++, index++) {
+        auto* const device = it->get();
+        assert(device != nullptr);
+
+        const auto next = std::next(it);
+        const auto port = (next == route.end()) ? -1 : device->get_port((*next)->get_id());
+        hops[index] = {device, port};
+    }
+}
+
+size_t Chunk::get_hops_count() const noexcept {
+    return hops_count;
+}
+
+RouteHop Chunk::get_hop(const size_t index) const noexcept {
+    assert(index < hops_count);
+
+    if (implicit) {
+        // resolve the device, and its port towards the next hop
+        auto* const device = route_descriptor.devices[get_described_device_id(index)].get();
+        const auto port = (index + 1 == hops_count) ? -1 : device->get_port(get_described_device_id(index + 1));
+        return {device, port};
+    }
+
+    return (hops_count > inline_hops_count) ? long_hops[index] : inline_hops[index];
+}
+
+DeviceId Chunk::get_described_device_id(const size_t index) const noexcept {
+    assert(implicit);
+    assert(index < hops_count);
+
+    if (route_descriptor.via >= 0) {
+        // [src, via, dest]
+        return (index == 0) ? route_descriptor.src : ((index == 1) ? route_descriptor.via : route_descriptor.dest);
+    }
+
+    // step from src, wrapping around at modulus
+    const auto modulus = static_cast<int64_t>(route_descriptor.modulus);
+    const auto offset = (static_cast<int64_t>(index) * route_descriptor.step) % modulus;
+    return static_cast<DeviceId>((route_descriptor.src + offset + modulus) % modulus);
+}
 
-    // return the first npu in route
-    return route.front();
+void Chunk::set_trace_id(const uint64_t trace_id) noexcept {
+    this->trace_id = trace_id;
 }
 
-std::shared_ptr<Device> Chunk::next_device() const noexcept {
+uint64_t Chunk::get_trace_id() const noexcept {
+    return trace_id;
+}
+
+void Chunk::set_tail_arrival_time(const EventTime tail_arrival_time) noexcept {
+    this->tail_arrival_time = tail_arrival_time;
+}
+
+EventTime Chunk::get_tail_arrival_time() const noexcept {
+    return tail_arrival_time;
+}
+
+void Chunk::set_traffic_class(const int traffic_class) noexcept {
+    assert(0 <= traffic_class && traffic_class < LinkStates::traffic_classes_count);
+
+    this->traffic_class = traffic_class;
+}
+
+int Chunk::get_traffic_class() const noexcept {
+    return traffic_class;
+}
+
+void Chunk::set_holds_buffer_room(const bool holds_buffer_room) noexcept {
+    buffer_room = holds_buffer_room;
+}
+
+bool Chunk::holds_buffer_room() const noexcept {
+    return buffer_room;
+}
+
+Device* Chunk::current_device() const noexcept {
+    // return the device at the cursor
+    return get_hop(cursor).device;
+}
+
+Device* Chunk::next_device() const noexcept {
     // assert the chunk has next dest
     assert(!arrived_dest());
 
     // return next dest
-    const auto next_dest = std::next(route.begin(), 1);
-    return *next_dest;
+    return get_hop(cursor + 1).device;
+}
+
+PortId Chunk::next_port() const noexcept {
+    // assert the chunk has next dest
+    assert(!arrived_dest());
+
+    return get_hop(cursor).port;
+}
+
+PortId Chunk::next_device_port() const noexcept {
+    // assert the chunk has next dest
+    assert(!arrived_dest());
+
+    return get_hop(cursor + 1).port;
 }
 
 void Chunk::mark_arrived_next_device() noexcept {
@@ -62,15 +274,50 @@ void Chunk::mark_arrived_next_device() noexcept {
     // it means the chunk hasn't arrived its final dest yet
     assert(!arrived_dest());
 
-    // pop previous node from the route
+    // advance the cursor
     // marking the current node has been changed
-    route.pop_front();
+    cursor++;
+}
+
+void Chunk::set_representative(const bool representative) noexcept {
+    this->representative = representative;
+}
+
+bool Chunk::is_representative() const noexcept {
+    return representative;
+}
+
+void Chunk::set_per_hop(const bool per_hop) noexcept {
+    this->per_hop = per_hop;
+}
+
+bool Chunk::is_per_hop() const noexcept {
+    return per_hop;
+}
+
+void Chunk::reroute(const Route& route) noexcept {
+    assert(route.size() >= 2);
+    assert(route.front().get() == current_device());
+    assert(route.back().get() == get_hop(hops_count - 1).device);
+
+    // the new route is stored explicitly, from the current device
+    if (implicit) {
+        implicit = false;
+        inline_hops = {};
+    }
+    set_route(route);
+    cursor = 0;
 }
 
 bool Chunk::arrived_dest() const noexcept {
-    // if a chunk arrived dest, route length should be 1
-    // i.e., only containing the dest node
-    return route.size() == 1;
+    // if a chunk arrived dest, the cursor is at the last hop
+    // i.e., only the dest node is left
+    return cursor + 1 == hops_count;
+}
+
+bool Chunk::next_device_is_dest() const noexcept {
+    // only the next device and the dest are left, and they're the same
+    return cursor + 2 == hops_count;
 }
 
 ChunkSize Chunk::get_size() const noexcept {
@@ -82,5 +329,19 @@ ChunkSize Chunk::get_size() const noexcept {
 
 void Chunk::invoke_callback() noexcept {
     // invoke callback
-    (*callback)(callback_arg);
+    callback();
+}
+
+const EventCallback& Chunk::get_callback() const noexcept {
+    return callback;
+}
+
+void Chunk::set_simulation_context(SimulationContext* const context) noexcept {
+    assert(context != nullptr);
+
+    this->context = context;
+}
+
+SimulationContext* Chunk::get_simulation_context() const noexcept {
+    return context;
 }
@@ -0,0 +1,188 @@
+/******************************************************************************
+This source code is licensed under the MIT license found in the
+LICENSE file in the root directory of this source tree.
+*******************************************************************************/
+
+#include "congestion_aware/ChunkPool.h"
+#include "congestion_aware/Chunk.h"
+#include <cassert>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+using namespace NetworkAnalyticalCongestionAware;
+
+namespace {
+
+/// a free block, linked through its own storage
+struct FreeBlock {
+    FreeBlock* next;
+};
+
+/// block size: a Chunk, rounded up to the maximum alignment
+constexpr size_t block_alignment = alignof(std::max_align_t);
+constexpr size_t block_size = ((sizeof(Chunk) + block_alignment - 1) / block_alignment) * block_alignment;
+
+/// number of blocks per slab
+constexpr size_t slab_blocks_count = 256;
+
+/// number of blocks moved at once between a thread and the shared list
+constexpr size_t refill_blocks_count = 64;
+
+/// slabs and blocks shared by every thread
+struct Arena {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<unsigned char[]>> slabs;
+    FreeBlock* free_head = nullptr;
+    size_t blocks_count = 0;
+
+    /// memory of the slabs, and of the chunks too large for a block
+    NetworkAnalytical::MemoryCounter memory;
+};
+
+/**
+ * Get the shared arena.
+ * It is never destroyed, so chunks freed during static destruction are still safe.
+ */
+Arena& get_arena() noexcept {
+    static auto* const arena = new Arena();
+    return *arena;
+}
+
+/// free list of the calling thread (trivially destructible, so usable while the thread exits)
+thread_local FreeBlock* local_free_head = nullptr;
+
+/// set once the calling thread handed its free list back
+thread_local bool local_free_list_closed = false;
+
+/// hands the free list of an exiting thread back to the arena
+struct LocalFreeListGuard {
+    ~LocalFreeListGuard() noexcept {
+        auto& arena = get_arena();
+        const auto lock = std::lock_guard<std::mutex>(arena.mutex);
+        while (local_free_head != nullptr) {
+            auto* const block = local_free_head;
+            local_free_head = block->next;
+            block->next = arena.free_head;
+            arena.free_head = block;
+        }
+        local_free_list_closed = true;
+    }
+};
+
+thread_local LocalFreeListGuard local_free_list_guard;
+
+/**
+ * Move up to blocks_count blocks from the arena to the calling thread,
+ * carving a new slab if the arena has none.
+ */
+void refill_local_free_list(const size_t blocks_count) noexcept {
+    auto& arena = get_arena();
+    const auto lock = std::lock_guard<std::mutex>(arena.mutex);
+
+    for (auto i = static_cast<size_t>(0); i < blocks_count; i++) {
+        if (arena.free_head == nullptr) {
+            // carve a new slab
+            auto slab = std::unique_ptr<unsigned char[]>(new (std::nothrow) unsigned char[block_size * slab_blocks_count]);
+            if (slab == nullptr) {
+                std::cerr << "[Error] (network/analytical/congestion_aware) "
+                          << "failed to allocate chunk pool slab" << std::endl;
+                std::exit(-1);
+            }
+            for (auto j = static_cast<size_t>(0); j < slab_blocks_count; j++) {
+                auto* const block = reinterpret_cast<FreeBlock*>(slab.get() + (j * block_size));
+                block->next = arena.free_head;
+                arena.free_head = block;
+            }
+            arena.slabs.push_back(std::move(slab));
+            arena.blocks_count += slab_blocks_count;
+            arena.memory.allocate(block_size * slab_blocks_count);
+        }
+
+        auto* const block = arena.free_head;
+        arena.free_head = block->next;
+        block->next = local_free_head;
+        local_free_head = block;
+    }
+}
+
+}  // namespace
+
+void* ChunkPool::allocate(const size_t size) noexcept {
+    // only Chunk itself is pooled
+    if (size > block_size) {
+        auto* const ptr = ::operator new(size, std::nothrow);
+        if (ptr == nullptr) {
+            std::cerr << "[Error] (network/analytical/congestion_aware) failed to allocate chunk" << std::endl;
+            std::exit(-1);
+        }
+        get_arena().memory.allocate(size);
+        return ptr;
+    }
+
+    // touch the guard so the thread returns its blocks when it exits
+    static_cast<void>(&local_free_list_guard);
+
+    if (local_free_head == nullptr) {
+        refill_local_free_list(refill_blocks_count);
+    }
+
+    auto* const block = local_free_head;
+    local_free_head = block->next;
+    return block;
+}
+
+void ChunkPool::deallocate(void* const ptr, const size_t size) noexcept {
+    if (ptr == nullptr) {
+        return;
+    }
+
+    if (size > block_size) {
+        ::operator delete(ptr);
+        get_arena().memory.deallocate(size);
+        return;
+    }
+
+    auto* const block = static_cast<FreeBlock*>(ptr);
+
+    // the thread is exiting: give the block straight back to the arena
+    if (local_free_list_closed) {
+        auto& arena = get_arena();
+        const auto lock = std::lock_guard<std::mutex>(arena.mutex);
+        block->next = arena.free_head;
+        arena.free_head = block;
+        return;
+    }
+
+    static_cast<void>(&local_free_list_guard);
+    block->next = local_free_head;
+    local_free_head = block;
+}
+
+void ChunkPool::reserve(const size_t chunks_count) noexcept {
+    static_cast<void>(&local_free_list_guard);
+
+    // count what the thread already holds
+    auto available_count = static_cast<size_t>(0);
+    for (auto* block = local_free_head; block != nullptr && available_count < chunks_count; block = block->next) {
+        available_count++;
+    }
+
+    if (available_count < chunks_count) {
+        refill_local_free_list(chunks_count - available_count);
+    }
+}
+
+size_t ChunkPool::get_blocks_count() noexcept {
+    auto& arena = get_arena();
+    const auto lock = std::lock_guard<std::mutex>(arena.mutex);
+
+    return arena.blocks_count;
+}
+
+const NetworkAnalytical::MemoryCounter& ChunkPool::get_memory_counter() noexcept {
+    return get_arena().memory;
+}
@@ -0,0 +1,90 @@
+/******************************************************************************
+This source code is licensed under the MIT license found in the
+LICENSE file in the root directory of this source tree.
+*******************************************************************************/
+
+#include "congestion_aware/CompletionBatcher.h"
+#include "congestion_aware/Chunk.h"
+#include <cassert>
+#include <cstdlib>
+#include <iostream>
+
+using namespace NetworkAnalyticalCongestionAware;
+
+void CompletionBatcher::add_sink(const Callback callback,
+                                 const BatchedCallback batched_callback,
+                                 void* const sink_arg) noexcept {
+    assert(callback != nullptr);
+    assert(batched_callback != nullptr);
+
+    for (const auto& sink : sinks) {
+        if (sink.callback == callback) {
+            std::cerr << "[Error] (network/analytical/congestion_aware) "
+                      << "a completion sink already exists for this callback" << std::endl;
+            std::exit(-1);
+        }
+    }
+
+    sinks.push_back({callback, batched_callback, sink_arg, {}, {}});
+}
+
+bool CompletionBatcher::gather(const Chunk& chunk, EventQueue* const event_queue) noexcept {
+    assert(event_queue != nullptr);
+
+    // only chunks sent with a function pointer can belong to a sink
+    const auto [callback, callback_arg] = chunk.get_callback().get_function_pointer();
+    if (callback == nullptr) {
+        return false;
+    }
+
+    for (auto& sink : sinks) {
+        if (sink.callback != callback) {
+            continue;
+        }
+
+        sink.callback_args.push_back(callback_arg);
+        if (!flush_scheduled) {
+            flush_scheduled = true;
+            event_queue->schedule_time_end_event([this]() { flush(); });
+        }
+        return true;
+    }
+
+    return false;
+}
+
+void CompletionBatcher::flush() noexcept {
+    // chunks gathered by the batched callbacks go into the next flush
+    flush_scheduled = false;
+
+    for (auto i = static_cast<size_t>(0); i < sinks.size(); i++) {
+        auto& sink = sinks[i];
+        if (sink.callback_args.empty()) {
+            continue;
+        }
+
+        sink.flushing_callback_args.swap(sink.callback_args);
+        const auto count = sink.flushing_callback_args.size();
+        batches_count++;
+        batched_chunks_count += count;
+        sink.batched_callback(sink.flushing_callback_args.data(), count, sink.sink_arg);
+        sink.flushing_callback_args.clear();
+    }
+}
+
+void CompletionBatcher::reset() noexcept {
+    for (auto& sink : sinks) {
+        sink.callback_args.clear();
+    }
+    flush_scheduled = false;
+    batches_count = 0;
+    batched_chunks_count = 0;
+}
+
+uint64_t CompletionBatcher::get_batches_count() const noexcept {
+    return batches_count;
+}
+
+uint64_t CompletionBatcher::get_batched_chunks_count() const noexcept {
+    return batched_chunks_count;
+}
@@ -6,11 +6,28 @@ LICENSE file in the root directory of this source tree.
 #include "congestion_aware/Device.h"
 #include "congestion_aware/Chunk.h"
 #include "congestion_aware/Link.h"
+#include <algorithm>
 #include <cassert>
 
 using namespace NetworkAnalyticalCongestionAware;
 
-Device::Device(const DeviceId id) noexcept : device_id(id) {
+Device::Device(const DeviceId id,
+               std::shared_ptr<MemoryCounter> devices_memory,
+               std::shared_ptr<MemoryCounter> links_memory,
+               std::shared_ptr<MemoryCounter> pending_chunks_memory,
+               std::shared_ptr<LinkStates::LinkIds> link_ids) noexcept
+    : device_id(id),
+      links(TrackingAllocator<Link>(links_memory)),
+      port_dests(TrackingAllocator<DeviceId>(devices_memory)),
+      ports(TrackingAllocator<std::pair<DeviceId, PortId>>(devices_memory)),
+      lazy_ports(TrackingAllocator<LazyPorts>(links_memory)),
+      lazy_links(0,
+                 std::hash<PortId>(),
+                 std::equal_to<PortId>(),
+                 TrackingAllocator<std::pair<const PortId, Link>>(std::move(links_memory))),
+      pending_chunks_memory(std::move(pending_chunks_memory)),
+      link_ids((link_ids != nullptr) ? std::move(link_ids) : std::make_shared<LinkStates::LinkIds>()),
+      buffer_size(0) {
     assert(id >= 0);
 }
 
@@ -30,16 +47,17 @@ void Device::send(std::unique_ptr<Chunk> chunk) noexcept {
     // assert the chunk hasn't arrived its final destination yet
     assert(!chunk->arrived_dest());
 
-    // get next dest
-    const auto next_dest = chunk->next_device();
-    const auto next_dest_id = next_dest->get_id();
+    // the chunk resolved the port towards next dest already
+    const auto port = chunk->next_port();
 
-    // assert the next dest is connected to this node
-    assert(connected(next_dest_id));
+    // assert the next dest is connected to this node through that port,
+    // unless the chunk hops over representatives of its links, which needn't be adjacent
+    assert(0 <= port && port < get_ports_count());
+    assert(chunk->is_representative() || get_port_dest(port) == chunk->next_device()->get_id());
 
     // send the chunk to the next dest
     // delegate this task to the link
-    links[next_dest_id]->send(std::move(chunk));
+    get_link(port).send(std::move(chunk));
 }
 
 void Device::connect(const DeviceId id, const Bandwidth bandwidth, const Latency latency) noexcept {
@@ -50,13 +68,187 @@ void Device::connect(const DeviceId id, const Bandwidth bandwidth, const Latency
     // assert there's no existing connection
     assert(!connected(id));
 
-    // create link
-    links[id] = std::make_shared<Link>(bandwidth, latency);
+    // lazy ports are numbered after the ports of links
+    assert(lazy_ports.empty());
+
+    // create link at the next port
+    const auto port = static_cast<PortId>(links.size());
+    links.emplace_back(bandwidth, latency, pending_chunks_memory, link_ids);
+    links.back().set_buffer_size(buffer_size);
+    port_dests.push_back(id);
+
+    // keep the port table sorted by dest id
+    const auto entry = std::make_pair(id, port);
+    ports.insert(std::lower_bound(ports.begin(), ports.end(), entry), entry);
+}
+
+void Device::connect_lazily(const DeviceId first_dest,
+                            const int stride,
+                            const int count,
+                            const Bandwidth bandwidth,
+                            const Latency latency) noexcept {
+    assert(first_dest >= 0);
+    assert(stride > 0);
+    assert(count > 0);
+    assert(bandwidth > 0);
+    assert(latency >= 0);
+
+    // this device belongs to the group if it's one of its devices
+    const auto offset = device_id - first_dest;
+    const auto self_index = (offset >= 0 && offset % stride == 0 && offset / stride < count) ? offset / stride : -1;
+    const auto ports_count = (self_index >= 0) ? count - 1 : count;
+    if (ports_count == 0) {
+        return;
+    }
+
+    // the group takes the ports after the existing ones
+    lazy_ports.push_back(
+        {get_ports_count(), ports_count, first_dest, stride, count, self_index,
+         Link(bandwidth, latency, pending_chunks_memory, link_ids)});
+    lazy_ports.back().idle_link.set_buffer_size(buffer_size);
+}
+
+int Device::release_idle_links(SimulationContext& context, const EventTime current_time) noexcept {
+    auto released_links_count = 0;
+    for (auto it = lazy_links.begin(); it != lazy_links.end();) {
+        if (it->second.is_idle(context, current_time)) {
+            it = lazy_links.erase(it);
+            released_links_count++;
+        } else {
+            it++;
+        }
+    }
+    return released_links_count;
+}
+
+int Device::get_materialized_links_count() const noexcept {
+    return static_cast<int>(links.size() + lazy_links.size());
+}
+
+void Device::reset(SimulationContext& context) noexcept {
+    for (auto& link : links) {
+        link.reset(context);
+    }
+    for (auto& [port, link] : lazy_links) {
+        link.reset(context);
+    }
+}
+
+void Device::set_buffer_size(const ChunkSize buffer_size) noexcept {
+    this->buffer_size = buffer_size;
+    for (auto& link : links) {
+        link.set_buffer_size(buffer_size);
+    }
+    for (auto& group : lazy_ports) {
+        group.idle_link.set_buffer_size(buffer_size);
+    }
+    for (auto& [port, link] : lazy_links) {
+        link.set_buffer_size(buffer_size);
+    }
+}
+
+ChunkSize Device::get_buffer_size() const noexcept {
+    return buffer_size;
 }
 
 bool Device::connected(const DeviceId dest) const noexcept {
     assert(dest >= 0);
 
     // check whether the connection exists
-    return links.find(dest) != links.end();
+    return get_port(dest) >= 0;
+}
+
+PortId Device::get_port(const DeviceId dest) const noexcept {
+    assert(dest >= 0);
+
+    // binary search over the contiguous port table
+    const auto it = std::lower_bound(ports.begin(), ports.end(), dest,
+                                     [](const auto& entry, const DeviceId id) { return entry.first < id; });
+    if (it != ports.end() && it->first == dest) {
+        return it->second;
+    }
+
+    // otherwise, find the lazy group dest belongs to
+    for (const auto& group : lazy_ports) {
+        const auto offset = dest - group.first_dest;
+        if (offset < 0 || offset % group.stride != 0 || offset / group.stride >= group.count) {
+            continue;
+        }
+        const auto index = offset / group.stride;
+        if (index == group.self_index) {
+            return -1;
+        }
+        return group.first_port + ((group.self_index >= 0 && index > group.self_index) ? index - 1 : index);
+    }
+    return -1;
+}
+
+int Device::get_ports_count() const noexcept {
+    if (lazy_ports.empty()) {
+        return static_cast<int>(links.size());
+    }
+
+    const auto& last_group = lazy_ports.back();
+    return last_group.first_port + last_group.ports_count;
+}
+
+Link& Device::get_link(const PortId port) noexcept {
+    assert(0 <= port && port < get_ports_count());
+
+    if (port < static_cast<PortId>(links.size())) {
+        return links[port];
+    }
+
+    // create the lazy link on its first use
+    const auto it = lazy_links.find(port);
+    if (it != lazy_links.end()) {
+        return it->second;
+    }
+    const auto& idle_link = get_lazy_ports(port).idle_link;
+    auto& link = lazy_links
+                     .try_emplace(port, idle_link.get_bandwidth(), idle_link.get_latency(), pending_chunks_memory,
+                                  link_ids)
+                     .first->second;
+    link.set_buffer_size(buffer_size);
+    return link;
+}
+
+const Link& Device::get_link(const PortId port) const noexcept {
+    assert(0 <= port && port < get_ports_count());
+
+    if (port < static_cast<PortId>(links.size())) {
+        return links[port];
+    }
+
+    // a lazy link not created yet is idle
+    const auto it = lazy_links.find(port);
+    return (it != lazy_links.end()) ? it->second : get_lazy_ports(port).idle_link;
+}
+
+DeviceId Device::get_port_dest(const PortId port) const noexcept {
+    assert(0 <= port && port < get_ports_count());
+
+    if (port < static_cast<PortId>(port_dests.size())) {
+        return port_dests[port];
+    }
+
+    // the device itself is skipped in its group
+    const auto& group = get_lazy_ports(port);
+    const auto index = port - group.first_port;
+    const auto dest_index = (group.self_index >= 0 && index >= group.self_index) ? index + 1 : index;
+    return group.first_dest + (dest_index * group.stride);
+}
+
+const Device::LazyPorts& Device::get_lazy_ports(const PortId port) const noexcept {
+    assert(port >= static_cast<PortId>(links.size()));
+
+    // groups are few (at most one per dimension), so a linear scan is enough
+    for (const auto& group : lazy_ports) {
+        if (port < group.first_port + group.ports_count) {
+            return group;
+        }
+    }
+
+    assert(false && "port out of range");
+    return lazy_ports.back();
 }
@@ -6,42 +6,53 @@ LICENSE file in the root directory of this source tree.
 #include "congestion_aware/Link.h"
 #include "common/NetworkFunction.h"
 #include "congestion_aware/Chunk.h"
+#include "congestion_aware/ChunkTracer.h"
 #include "congestion_aware/Device.h"
+#include "congestion_aware/Topology.h"
+#include <algorithm>
 #include <cassert>
 
 using namespace NetworkAnalytical;
 using namespace NetworkAnalyticalCongestionAware;
 
-// declaring static event_queue
-std::shared_ptr<EventQueue> Link::event_queue;
-
-void Link::link_become_free(void* const link_ptr) noexcept {
-    assert(link_ptr != nullptr);
-
-    // cast to Link*
-    auto* const link = static_cast<Link*>(link_ptr);
+void Link::link_become_free(SimulationContext& context, Link& link) noexcept {
+    auto& state = link.get_state(context);
+    const auto slot = link.slot;
 
     // set link free
-    link->set_free();
+    state.busy[slot] = false;
 
     // process pending chunks if one exist
-    if (link->pending_chunk_exists()) {
-        link->process_pending_transmission();
+    if (state.pending_classes[slot] != 0) {
+        link.preempt_reservation(context, state, link.peek_pending_chunk(context, state).get_size());
+        if (link.overlaps_reservation(context, state, link.peek_pending_chunk(context, state).get_size())) {
+            link.wait_for_reservation(context, state);
+        } else if (state.reserved_until[slot] > link.get_link_event_queue(context)->get_current_time()) {
+            // a burst could run into the upcoming reservation
+            link.process_pending_transmission(context);
+        } else if (context.get_link_coalescing()) {
+            link.schedule_pending_burst(context, state);
+        } else {
+            link.process_pending_transmission(context);
+        }
     }
 }
 
-void Link::set_event_queue(std::shared_ptr<EventQueue> event_queue_ptr) noexcept {
-    assert(event_queue_ptr != nullptr);
-
-    // set the event queue
-    Link::event_queue = std::move(event_queue_ptr);
-}
-
-Link::Link(const Bandwidth bandwidth, const Latency latency) noexcept
+Link::Link(const Bandwidth bandwidth,
+           const Latency latency,
+           std::shared_ptr<MemoryCounter> pending_chunks_memory,
+           std::shared_ptr<LinkStates::LinkIds> link_ids) noexcept
     : bandwidth(bandwidth),
       latency(latency),
-      pending_chunks(),
-      busy(false) {
+      link_ids((link_ids != nullptr) ? std::move(link_ids) : std::make_shared<LinkStates::LinkIds>()),
+      key(this->link_ids->allocate()),
+      slot(key.id % LinkStates::block_size),
+      pending_chunks_memory(std::move(pending_chunks_memory)),
+      failure_topology(nullptr),
+      buffer_size(0),
+      local_event_queue(nullptr),
+      remote_arrivals(nullptr),
+      dest_partition(-1) {
     assert(bandwidth > 0);
     assert(latency >= 0);
 
@@ -49,43 +60,415 @@ Link::Link(const Bandwidth bandwidth, const Latency latency) noexcept
     bandwidth_Bpns = bw_GBps_to_Bpns(bandwidth);
 }
 
+Link::Link(Link&& other) noexcept
+    : bandwidth(other.bandwidth),
+      bandwidth_Bpns(other.bandwidth_Bpns),
+      latency(other.latency),
+      link_ids(std::move(other.link_ids)),
+      key(other.key),
+      slot(other.slot),
+      pending_chunks_memory(std::move(other.pending_chunks_memory)),
+      failure_topology(other.failure_topology),
+      buffer_size(other.buffer_size),
+      local_event_queue(other.local_event_queue),
+      remote_arrivals(other.remote_arrivals),
+      dest_partition(other.dest_partition) {
+    // the state now belongs to this link
+    other.key.id = -1;
+}
+
+Link::~Link() noexcept {
+    // the slots of the link are reset by the next link taking its id,
+    // as the contexts it was simulated in may be gone already
+    if (key.id >= 0) {
+        link_ids->release(key.id);
+    }
+}
+
 void Link::send(std::unique_ptr<Chunk> chunk) noexcept {
     assert(chunk != nullptr);
+    assert(chunk->get_simulation_context() != nullptr);
+
+    // the chunk is simulated in the context it was sent under
+    auto& context = *chunk->get_simulation_context();
+    auto& state = get_state(context);
 
-    if (busy) {
+    // a failed link hands the chunk back to be rerouted
+    if (failure_topology != nullptr) {
+        release_buffer(context, state, *chunk);
+        failure_topology->reroute(std::move(chunk));
+        return;
+    }
+
+    auto* const chunk_tracer = get_chunk_tracer(context, *chunk);
+    if (chunk_tracer != nullptr) {
+        chunk_tracer->record(ChunkTracer::EventType::Enqueue, chunk->get_trace_id(),
+                             get_link_event_queue(context)->get_current_time(), chunk->current_device()->get_id(),
+                             chunk->next_device()->get_id(), chunk->get_size());
+    }
+
+    if (!state.busy[slot]) {
+        preempt_reservation(context, state, chunk->get_size());
+    }
+
+    if (state.busy[slot]) {
         // link is busy, add to pending chunks
-        pending_chunks.push_back(std::move(chunk));
+        enqueue_pending_chunk(context, state, std::move(chunk));
+    } else if (overlaps_reservation(context, state, chunk->get_size())) {
+        // link is reserved, wait for the reservation like for a busy link
+        enqueue_pending_chunk(context, state, std::move(chunk));
+        wait_for_reservation(context, state);
+    } else if (!claim_next_buffer(context, state, *chunk)) {
+        // the buffer the chunk heads to is full, stall until it has room
+        enqueue_pending_chunk(context, state, std::move(chunk));
+        state.busy[slot] = true;
     } else {
         // service this chunk immediately
-        schedule_chunk_transmission(std::move(chunk));
+#ifdef ASTRA_NET_STATS
+        record_transmission(state, chunk->get_size(), 0);
+#endif
+        schedule_chunk_transmission(context, state, std::move(chunk));
     }
 }
 
-void Link::process_pending_transmission() noexcept {
+void Link::process_pending_transmission(SimulationContext& context) noexcept {
+    auto& state = get_state(context);
+
     // pending chunk should exist
-    assert(pending_chunk_exists());
+    assert(state.pending_classes[slot] != 0);
+
+    // the buffer the chunk heads to is full, stall until it has room
+    if (!claim_next_buffer(context, state, peek_pending_chunk(context, state))) {
+        state.busy[slot] = true;
+        return;
+    }
 
     // get chunk to process
-    auto chunk = std::move(pending_chunks.front());
-    pending_chunks.pop_front();
+    auto chunk = dequeue_pending_chunk(context, state);
+#ifdef ASTRA_NET_STATS
+    const auto departure_time = get_link_event_queue(context)->get_current_time();
+    record_transmission(state, chunk->get_size(),
+                        pop_queueing_delay(state, departure_time, chunk->get_traffic_class()));
+#endif
 
     // service this chunk
-    schedule_chunk_transmission(std::move(chunk));
+    schedule_chunk_transmission(context, state, std::move(chunk));
+}
+
+bool Link::pending_chunk_exists(SimulationContext& context) const noexcept {
+    // check some class has pending chunks
+    return get_state(context).pending_classes[slot] != 0;
+}
+
+ChunkSize Link::get_pending_bytes(SimulationContext& context) const noexcept {
+    return get_state(context).pending_bytes[slot];
+}
+
+bool Link::can_reserve(SimulationContext& context, const EventTime current_time) const noexcept {
+    // a failed link hands its chunks back to be rerouted, so it's never reserved
+    const auto& state = get_state(context);
+    return !state.busy[slot] && state.pending_classes[slot] == 0 && state.reserved_until[slot] <= current_time &&
+           local_event_queue == nullptr && failure_topology == nullptr;
+}
+
+bool Link::is_idle(SimulationContext& context, const EventTime current_time) const noexcept {
+    // same conditions as a reservation, and no fast-path chunk left to let go of it
+    return can_reserve(context, current_time) && get_state(context).reservation_owners[slot] == nullptr;
+}
+
+Link::Transmission Link::reserve(SimulationContext& context,
+                                 const EventTime departure_time,
+                                 const ChunkSize chunk_size,
+                                 const EventTime tail_arrival_time,
+                                 ReservedChunk* const owner) noexcept {
+    assert(chunk_size > 0);
+    assert(owner != nullptr);
+
+    auto& state = get_state(context);
+    assert(departure_time >= state.reserved_until[slot]);
+
+    const auto transmission = plan_transmission(context, departure_time, chunk_size, tail_arrival_time);
+    state.reserved_from[slot] = departure_time;
+    state.reserved_until[slot] = transmission.free_time;
+    state.reservation_owners[slot] = owner;
+    return transmission;
+}
+
+void Link::release_reservation(SimulationContext& context,
+                               const ReservedChunk* const owner,
+                               const ChunkSize chunk_size,
+                               const bool served) noexcept {
+    assert(owner != nullptr);
+    assert(chunk_size > 0);
+
+    auto& state = get_state(context);
+#ifdef ASTRA_NET_STATS
+    // the fast path only reserves idle links, so the chunk never queued
+    if (served) {
+        record_transmission(state, chunk_size, 0);
+    }
+#endif
+
+    // the link may have been reserved again once the chunk crossed it
+    if (state.reservation_owners[slot] != owner) {
+        assert(served);
+        return;
+    }
+    state.reservation_owners[slot] = nullptr;
+
+    // the chunk will cross the link on the per-hop path
+    if (!served) {
+        state.reserved_from[slot] = 0;
+        state.reserved_until[slot] = 0;
+    }
+}
+
+Link::Transmission Link::plan_transmission(const SimulationContext& context,
+                                           const EventTime departure_time,
+                                           const ChunkSize chunk_size,
+                                           const EventTime tail_arrival_time) const noexcept {
+    assert(chunk_size > 0);
+
+    // store-and-forward: the chunk arrives as a whole
+    const auto flit_size = context.get_cut_through_flit_size();
+    if (flit_size == 0 || flit_size >= chunk_size) {
+        const auto arrival_time = departure_time + communication_delay(chunk_size);
+        return {departure_time + serialization_delay(chunk_size), arrival_time, arrival_time};
+    }
+
+    // cut-through: the tail is sent once it arrived, at the earliest
+    const auto flit_serialization_time = serialization_delay(flit_size);
+    const auto free_time =
+        std::max(departure_time + serialization_delay(chunk_size), tail_arrival_time + flit_serialization_time);
+    const auto latency_time = static_cast<EventTime>(latency);
+    return {free_time, departure_time + latency_time + flit_serialization_time, free_time + latency_time};
 }
 
-bool Link::pending_chunk_exists() const noexcept {
-    // check pending chunks is not empty
-    return !pending_chunks.empty();
+void Link::reset(SimulationContext& context) noexcept {
+    auto& state = get_state(context);
+
+    // drop the pending chunks
+    for (auto& queue : state.pending_chunks[slot]) {
+        queue.clear();
+    }
+    state.pending_classes[slot] = 0;
+    state.pending_bytes[slot] = 0;
+    state.scheduled_classes[slot] = LinkStates::traffic_classes_count - 1;
+    state.deficits[slot] = {};
+
+    // free, and never reserved
+    state.busy[slot] = false;
+    state.reserved_from[slot] = 0;
+    state.reserved_until[slot] = 0;
+    state.reservation_owners[slot] = nullptr;
+
+    // with an empty buffer, and nothing stalled for it
+    state.buffered_bytes[slot] = 0;
+    state.stalled_links[slot].clear();
+
+#ifdef ASTRA_NET_STATS
+    state.stats[slot] = LinkStats();
+    for (auto& send_times : state.pending_send_times[slot]) {
+        send_times.clear();
+    }
+#endif
 }
 
-void Link::set_busy() noexcept {
+void Link::set_busy(SimulationContext& context) noexcept {
     // set busy to true
-    busy = true;
+    get_state(context).busy[slot] = true;
 }
 
-void Link::set_free() noexcept {
+void Link::set_free(SimulationContext& context) noexcept {
     // set busy to false
-    busy = false;
+    get_state(context).busy[slot] = false;
+}
+
+void Link::set_failed(Topology* const topology) noexcept {
+    failure_topology = topology;
+}
+
+bool Link::is_failed() const noexcept {
+    return failure_topology != nullptr;
+}
+
+Link::PendingChunks Link::take_pending_chunks(SimulationContext& context) noexcept {
+    auto& state = get_state(context);
+
+    // classes are taken in priority order
+    auto& queues = state.pending_chunks[slot];
+    auto chunks = PendingChunks(queues[0].get_allocator());
+    for (auto& queue : queues) {
+        chunks.splice(chunks.end(), queue);
+    }
+    state.pending_classes[slot] = 0;
+    state.pending_bytes[slot] = 0;
+    state.deficits[slot] = {};
+#ifdef ASTRA_NET_STATS
+    for (auto& send_times : state.pending_send_times[slot]) {
+        send_times.clear();
+    }
+#endif
+
+    // the chunks leave the buffer
+    for (auto& chunk : chunks) {
+        release_buffer(context, state, *chunk);
+    }
+    return chunks;
+}
+
+void Link::set_buffer_size(const ChunkSize buffer_size) noexcept {
+    this->buffer_size = buffer_size;
+}
+
+ChunkSize Link::get_buffer_size() const noexcept {
+    return buffer_size;
+}
+
+ChunkSize Link::get_buffered_bytes(SimulationContext& context) const noexcept {
+    return get_state(context).buffered_bytes[slot];
+}
+
+Bandwidth Link::get_bandwidth() const noexcept {
+    assert(bandwidth > 0);
+
+    return bandwidth;
+}
+
+Latency Link::get_latency() const noexcept {
+    assert(latency >= 0);
+
+    return latency;
+}
+
+void Link::bind_partition(EventQueue* const local_event_queue,
+                          std::vector<RemoteArrival>* const remote_arrivals,
+                          const int dest_partition) noexcept {
+    assert(local_event_queue != nullptr);
+    assert(dest_partition >= 0);
+
+    this->local_event_queue = local_event_queue;
+    this->remote_arrivals = remote_arrivals;
+    this->dest_partition = dest_partition;
+}
+
+void Link::unbind_partition() noexcept {
+    local_event_queue = nullptr;
+    remote_arrivals = nullptr;
+    dest_partition = -1;
+}
+
+LinkStates::Block& Link::get_state(SimulationContext& context) const noexcept {
+    assert(key.id >= 0);
+
+    return context.get_link_states().get(link_ids, key, pending_chunks_memory);
+}
+
+#ifdef ASTRA_NET_STATS
+const LinkStats& Link::get_stats(SimulationContext& context) const noexcept {
+    return get_state(context).stats[slot];
+}
+
+void Link::record_transmission(LinkStates::Block& state,
+                               const ChunkSize chunk_size,
+                               const EventTime queueing_delay) noexcept {
+    auto& stats = state.stats[slot];
+    stats.bytes += chunk_size;
+    stats.chunks_count++;
+    stats.busy_time += serialization_delay(chunk_size);
+
+    // bucket b > 0 holds delays in [2^(b-1), 2^b)
+    auto bucket = 0;
+    for (auto delay = queueing_delay; delay > 0 && bucket < LinkStats::histogram_buckets_count - 1; delay >>= 1) {
+        bucket++;
+    }
+    stats.queueing_delay_histogram[bucket]++;
+}
+
+void Link::record_pending_chunk(SimulationContext& context,
+                                LinkStates::Block& state,
+                                const int traffic_class) noexcept {
+    state.pending_send_times[slot][traffic_class].push_back(get_link_event_queue(context)->get_current_time());
+
+    auto queue_depth = static_cast<size_t>(0);
+    for (const auto& queue : state.pending_chunks[slot]) {
+        queue_depth += queue.size();
+    }
+    auto& stats = state.stats[slot];
+    stats.max_queue_depth = std::max(stats.max_queue_depth, queue_depth);
+}
+
+EventTime Link::pop_queueing_delay(LinkStates::Block& state,
+                                   const EventTime departure_time,
+                                   const int traffic_class) noexcept {
+    auto& send_times = state.pending_send_times[slot][traffic_class];
+    assert(!send_times.empty());
+
+    const auto send_time = send_times.front();
+    send_times.pop_front();
+    return departure_time - send_time;
+}
+#endif
+
+bool Link::can_coalesce(const SimulationContext& context, const Chunk& chunk) noexcept {
+    // under strict priority, nothing overtakes class 0, while any chunk may get its turn under deficit round-robin
+    return context.get_link_scheduling() == SimulationContext::LinkScheduling::StrictPriority &&
+           chunk.get_traffic_class() == 0;
+}
+
+Link* Link::get_next_buffer_link(const Chunk& chunk) const noexcept {
+    // the dest takes the chunk whole
+    if (chunk.next_device_is_dest()) {
+        return nullptr;
+    }
+
+    // a failed link holds nothing
+    auto* const next_link = &chunk.next_device()->get_link(chunk.next_device_port());
+    return (next_link->buffer_size > 0 && !next_link->is_failed()) ? next_link : nullptr;
+}
+
+bool Link::claim_next_buffer(SimulationContext& context, LinkStates::Block& state, Chunk& chunk) noexcept {
+    // a chunk larger than the buffer only enters it empty
+    auto* const next_link = get_next_buffer_link(chunk);
+    const auto chunk_size = chunk.get_size();
+    auto* const next_state = (next_link != nullptr) ? &next_link->get_state(context) : nullptr;
+    if (next_link != nullptr) {
+        const auto buffered_bytes = next_state->buffered_bytes[next_link->slot];
+        if (buffered_bytes > 0 && buffered_bytes + chunk_size > next_link->buffer_size) {
+            next_state->stalled_links[next_link->slot].push_back(this);
+            return false;
+        }
+    }
+
+    // the chunk leaves the buffer of this link for the next one
+    release_buffer(context, state, chunk);
+    if (next_link != nullptr) {
+        next_state->buffered_bytes[next_link->slot] += chunk_size;
+        chunk.set_holds_buffer_room(true);
+    }
+    return true;
+}
+
+void Link::release_buffer(SimulationContext& context, LinkStates::Block& state, Chunk& chunk) noexcept {
+    if (!chunk.holds_buffer_room()) {
+        return;
+    }
+
+    auto& buffered_bytes = state.buffered_bytes[slot];
+    assert(buffered_bytes >= chunk.get_size());
+    buffered_bytes -= chunk.get_size();
+    chunk.set_holds_buffer_room(false);
+
+    // stalled links try again once their events at this time ran, each taking the room it finds
+    auto& stalled_links = state.stalled_links[slot];
+    if (stalled_links.empty()) {
+        return;
+    }
+    const auto current_time = get_link_event_queue(context)->get_current_time();
+    for (auto* const stalled_link : stalled_links) {
+        stalled_link->schedule_link_free(context, current_time);
+    }
+    stalled_links.clear();
 }
 
 EventTime Link::serialization_delay(const ChunkSize chunk_size) const noexcept {
@@ -108,28 +491,261 @@ EventTime Link::communication_delay(const ChunkSize chunk_size) const noexcept {
     return static_cast<EventTime>(delay);
 }
 
-void Link::schedule_chunk_transmission(std::unique_ptr<Chunk> chunk) noexcept {
+EventQueue* Link::get_link_event_queue(const SimulationContext& context) const noexcept {
+    // use the partition's event queue in a parallel simulation
+    return (local_event_queue != nullptr) ? local_event_queue : context.get_event_queue();
+}
+
+void Link::schedule_chunk_arrival(const SimulationContext& context,
+                                  std::unique_ptr<Chunk> chunk,
+                                  const Transmission& transmission) noexcept {
+    assert(chunk != nullptr);
+
+    // a device forwards the chunk as soon as its head arrived, while the dest receives it whole
+    const auto chunk_arrival_time =
+        chunk->next_device_is_dest() ? transmission.tail_arrival_time : transmission.head_arrival_time;
+    chunk->set_tail_arrival_time(transmission.tail_arrival_time);
+
+    if (remote_arrivals != nullptr) {
+        // next device belongs to another partition: hand the arrival over at the window boundary
+        remote_arrivals->push_back({chunk_arrival_time, dest_partition, std::move(chunk)});
+        return;
+    }
+
+    // the event owns the chunk until it arrives
+    get_link_event_queue(context)->schedule_event(chunk_arrival_time, [chunk = std::move(chunk)]() mutable {
+        Chunk::arrived_next_device(std::move(chunk));
+    });
+}
+
+void Link::schedule_chunk_transmission(SimulationContext& context,
+                                       LinkStates::Block& state,
+                                       std::unique_ptr<Chunk> chunk) noexcept {
     assert(chunk != nullptr);
 
     // link should be free
-    assert(!busy);
+    assert(!state.busy[slot]);
 
     // set link busy
-    set_busy();
+    state.busy[slot] = true;
 
     // get metadata
     const auto chunk_size = chunk->get_size();
-    const auto current_time = Link::event_queue->get_current_time();
+    const auto current_time = get_link_event_queue(context)->get_current_time();
+
+    const auto transmission = plan_transmission(context, current_time, chunk_size, chunk->get_tail_arrival_time());
+
+    auto* const chunk_tracer = get_chunk_tracer(context, *chunk);
+    if (chunk_tracer != nullptr) {
+        trace_transmission(*chunk_tracer, *chunk, current_time, transmission);
+    }
 
     // schedule chunk arrival event
-    const auto communication_time = communication_delay(chunk_size);
-    const auto chunk_arrival_time = current_time + communication_time;
-    auto* const chunk_ptr = static_cast<void*>(chunk.release());
-    Link::event_queue->schedule_event(chunk_arrival_time, Chunk::chunk_arrived_next_device, chunk_ptr);
+    schedule_chunk_arrival(context, std::move(chunk), transmission);
 
     // schedule link free time
-    const auto serialization_time = serialization_delay(chunk_size);
-    const auto link_free_time = current_time + serialization_time;
-    auto* const link_ptr = static_cast<void*>(this);
-    Link::event_queue->schedule_event(link_free_time, link_become_free, link_ptr);
+    schedule_link_free(context, transmission.free_time);
+}
+
+void Link::schedule_pending_burst(SimulationContext& context, LinkStates::Block& state) noexcept {
+    // pending chunk should exist, and link should be free
+    assert(state.pending_classes[slot] != 0);
+    assert(!state.busy[slot]);
+
+    // set link busy for the whole burst
+    state.busy[slot] = true;
+
+    // the buffer the first chunk heads to is full, stall until it has room
+    if (!claim_next_buffer(context, state, peek_pending_chunk(context, state))) {
+        return;
+    }
+
+    // chunks depart back-to-back, each right after the previous one is serialized
+    auto departure_time = get_link_event_queue(context)->get_current_time();
+    auto first_chunk = true;
+    while (state.pending_classes[slot] != 0) {
+        // the burst ends before a chunk that could be overtaken by a chunk queued later,
+        // or leaving or entering a bounded buffer, whose room changes hands when the chunk starts being serialized:
+        // it's sent once the link is free
+        const auto& next_chunk = peek_pending_chunk(context, state);
+        if (!first_chunk && (!can_coalesce(context, next_chunk) || next_chunk.holds_buffer_room() ||
+                             get_next_buffer_link(next_chunk) != nullptr)) {
+            break;
+        }
+        first_chunk = false;
+
+        auto chunk = dequeue_pending_chunk(context, state);
+
+        const auto chunk_size = chunk->get_size();
+#ifdef ASTRA_NET_STATS
+        record_transmission(state, chunk_size, pop_queueing_delay(state, departure_time, chunk->get_traffic_class()));
+#endif
+        const auto transmission =
+            plan_transmission(context, departure_time, chunk_size, chunk->get_tail_arrival_time());
+        auto* const chunk_tracer = get_chunk_tracer(context, *chunk);
+        if (chunk_tracer != nullptr) {
+            trace_transmission(*chunk_tracer, *chunk, departure_time, transmission);
+        }
+        schedule_chunk_arrival(context, std::move(chunk), transmission);
+        departure_time = transmission.free_time;
+    }
+
+    // single link free event at the end of the busy period
+    schedule_link_free(context, departure_time);
+}
+
+void Link::schedule_link_free(SimulationContext& context, const EventTime free_time) noexcept {
+    // the event carries the context, so the link frees its state there
+    get_link_event_queue(context)->schedule_event(free_time,
+                                                  [&context, this]() { link_become_free(context, *this); });
+}
+
+ChunkTracer* Link::get_chunk_tracer(const SimulationContext& context, const Chunk& chunk) const noexcept {
+    // partitions run on their own threads, which can't share the tracer
+    if (chunk.get_trace_id() == 0 || local_event_queue != nullptr) {
+        return nullptr;
+    }
+    return context.get_chunk_tracer();
+}
+
+void Link::trace_transmission(ChunkTracer& chunk_tracer,
+                              const Chunk& chunk,
+                              const EventTime departure_time,
+                              const Transmission& transmission) const noexcept {
+    const auto chunk_size = chunk.get_size();
+    const auto arrival_time = transmission.tail_arrival_time;
+    auto* const next_device = chunk.next_device();
+    chunk_tracer.record_hop(chunk.get_trace_id(), chunk.current_device()->get_id(), next_device->get_id(), chunk_size,
+                            departure_time, transmission.free_time - departure_time, arrival_time);
+
+    // the link leads to the dest of the chunk
+    const auto* const dest_device = chunk.get_hop(chunk.get_hops_count() - 1).device;
+    if (next_device == dest_device) {
+        chunk_tracer.record(ChunkTracer::EventType::Completion, chunk.get_trace_id(), arrival_time,
+                            chunk.get_hop(0).device->get_id(), dest_device->get_id(), chunk_size);
+    }
+}
+
+bool Link::overlaps_reservation(const SimulationContext& context,
+                                const LinkStates::Block& state,
+                                const ChunkSize chunk_size) const noexcept {
+    const auto current_time = get_link_event_queue(context)->get_current_time();
+    return current_time < state.reserved_until[slot] &&
+           state.reserved_from[slot] < current_time + serialization_delay(chunk_size);
+}
+
+void Link::wait_for_reservation(SimulationContext& context, LinkStates::Block& state) noexcept {
+    assert(!state.busy[slot]);
+
+    state.busy[slot] = true;
+    schedule_link_free(context, state.reserved_until[slot]);
+}
+
+void Link::preempt_reservation(const SimulationContext& context,
+                               LinkStates::Block& state,
+                               const ChunkSize chunk_size) noexcept {
+    const auto current_time = get_link_event_queue(context)->get_current_time();
+    if (current_time >= state.reserved_from[slot] || !overlaps_reservation(context, state, chunk_size)) {
+        return;
+    }
+
+    // the owner hasn't reached the link yet, and releases it as it resumes the per-hop path
+    auto* const owner = state.reservation_owners[slot];
+    assert(owner != nullptr);
+    Topology::resume_per_hop(*owner);
+    assert(state.reservation_owners[slot] == nullptr);
+}
+
+void Link::enqueue_pending_chunk(SimulationContext& context,
+                                 LinkStates::Block& state,
+                                 std::unique_ptr<Chunk> chunk) noexcept {
+    assert(chunk != nullptr);
+
+    const auto traffic_class = chunk->get_traffic_class();
+    state.pending_bytes[slot] += chunk->get_size();
+    state.pending_chunks[slot][traffic_class].push_back(std::move(chunk));
+    state.pending_classes[slot] |= static_cast<uint8_t>(1U << traffic_class);
+#ifdef ASTRA_NET_STATS
+    record_pending_chunk(context, state, traffic_class);
+#else
+    (void)context;
+#endif
+}
+
+std::unique_ptr<Chunk> Link::dequeue_pending_chunk(const SimulationContext& context,
+                                                   LinkStates::Block& state) noexcept {
+    const auto traffic_class = pick_pending_class(context, state, true);
+    auto& queue = state.pending_chunks[slot][traffic_class];
+    auto chunk = std::move(queue.front());
+    queue.pop_front();
+    state.pending_bytes[slot] -= chunk->get_size();
+
+    // an emptied class loses what it had left of its turns
+    if (queue.empty()) {
+        state.pending_classes[slot] &= static_cast<uint8_t>(~(1U << traffic_class));
+        state.deficits[slot][traffic_class] = 0;
+    }
+    return chunk;
+}
+
+Chunk& Link::peek_pending_chunk(const SimulationContext& context, LinkStates::Block& state) noexcept {
+    return *state.pending_chunks[slot][pick_pending_class(context, state, false)].front();
+}
+
+int Link::pick_pending_class(const SimulationContext& context, LinkStates::Block& state, const bool commit) noexcept {
+    const auto pending_classes = state.pending_classes[slot];
+    assert(pending_classes != 0);
+
+    // strict priority: the lowest class goes first
+    if (context.get_link_scheduling() == SimulationContext::LinkScheduling::StrictPriority) {
+        return __builtin_ctz(pending_classes);
+    }
+
+    // deficit round-robin: the class in turn goes on while its deficit covers its next chunk
+    constexpr auto classes_count = LinkStates::traffic_classes_count;
+    const auto& queues = state.pending_chunks[slot];
+    auto& deficits = state.deficits[slot];
+    const auto scheduled_class = static_cast<int>(state.scheduled_classes[slot]);
+    if (((pending_classes >> scheduled_class) & 1U) != 0 &&
+        deficits[scheduled_class] >= queues[scheduled_class].front()->get_size()) {
+        if (commit) {
+            deficits[scheduled_class] -= queues[scheduled_class].front()->get_size();
+        }
+        return scheduled_class;
+    }
+
+    // otherwise the next classes earn their quantum in turn, round after round,
+    // and the first one whose deficit covers its next chunk goes
+    auto picked_offset = 0;
+    auto picked_rounds = static_cast<ChunkSize>(0);
+    for (auto offset = 1; offset <= classes_count; offset++) {
+        const auto traffic_class = (scheduled_class + offset) % classes_count;
+        if (((pending_classes >> traffic_class) & 1U) == 0) {
+            continue;
+        }
+        const auto chunk_size = queues[traffic_class].front()->get_size();
+        const auto missing_bytes = chunk_size - std::min(chunk_size, deficits[traffic_class]);
+        const auto quantum = context.get_quantum(traffic_class);
+        const auto rounds = std::max(static_cast<ChunkSize>(1), (missing_bytes + quantum - 1) / quantum);
+        if (picked_offset == 0 || rounds < picked_rounds) {
+            picked_offset = offset;
+            picked_rounds = rounds;
+        }
+    }
+    const auto picked_class = (scheduled_class + picked_offset) % classes_count;
+    if (!commit) {
+        return picked_class;
+    }
+
+    // classes before the picked one in its last round earned one more quantum than the ones after it
+    for (auto offset = 1; offset <= classes_count; offset++) {
+        const auto traffic_class = (scheduled_class + offset) % classes_count;
+        if (((pending_classes >> traffic_class) & 1U) != 0) {
+            const auto rounds = (offset <= picked_offset) ? picked_rounds : picked_rounds - 1;
+            deficits[traffic_class] += rounds * context.get_quantum(traffic_class);
+        }
+    }
+    deficits[picked_class] -= queues[picked_class].front()->get_size();
+    state.scheduled_classes[slot] = static_cast<uint8_t>(picked_class);
+    return picked_class;
 }
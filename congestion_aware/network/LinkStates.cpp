@@ -0,0 +1,195 @@
+/******************************************************************************
+This source code is licensed under the MIT license found in the
+LICENSE file in the root directory of this source tree.
+*******************************************************************************/
+
+#include "congestion_aware/LinkStates.h"
+#include "congestion_aware/Chunk.h"
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+
+using namespace NetworkAnalytical;
+using namespace NetworkAnalyticalCongestionAware;
+
+namespace {
+
+/// serial of the next link ids
+std::atomic<uint64_t> next_link_ids_serial(1);
+
+}  // namespace
+
+LinkStates::LinkIds::LinkIds() noexcept : serial(next_link_ids_serial.fetch_add(1, std::memory_order_relaxed)) {}
+
+uint64_t LinkStates::LinkIds::get_serial() const noexcept {
+    return serial;
+}
+
+LinkStates::LinkKey LinkStates::LinkIds::allocate() noexcept {
+    const auto lock = std::lock_guard<std::mutex>(mutex);
+
+    auto id = next_id;
+    if (released_ids.empty()) {
+        next_id++;
+    } else {
+        id = released_ids.top();
+        released_ids.pop();
+    }
+    return {id, next_serial++};
+}
+
+void LinkStates::LinkIds::release(const int id) noexcept {
+    assert(id >= 0);
+
+    const auto lock = std::lock_guard<std::mutex>(mutex);
+
+    released_ids.push(id);
+}
+
+LinkStates::LinkStates() noexcept : directory(nullptr) {
+    // lookups always find a directory
+    const auto lock = std::lock_guard<std::mutex>(mutex);
+    publish_directory();
+}
+
+LinkStates::~LinkStates() noexcept = default;
+
+LinkStates::Block& LinkStates::get(const std::shared_ptr<LinkIds>& link_ids,
+                                   const LinkKey& key,
+                                   const std::shared_ptr<MemoryCounter>& pending_chunks_memory) noexcept {
+    assert(link_ids != nullptr);
+    assert(key.id >= 0);
+
+    // the serial of the ids tells their table apart from the one of expired ids at the same address
+    const auto* const current_directory = directory.load(std::memory_order_acquire);
+    const auto serial = link_ids->get_serial();
+    const auto block_index = static_cast<size_t>(key.id / block_size);
+    for (const auto& [table_serial, index] : current_directory->tables) {
+        if (table_serial != serial) {
+            continue;
+        }
+        if (block_index < index->capacity) {
+            auto* const block = index->entries[block_index].load(std::memory_order_acquire);
+            if (block != nullptr && block->owners[key.id % block_size] == key.serial) {
+                return *block;
+            }
+        }
+        break;
+    }
+
+    // first use of the link in this context, or its slot is left by a destroyed link
+    return attach(link_ids, key, pending_chunks_memory);
+}
+
+LinkStates::Block& LinkStates::attach(const std::shared_ptr<LinkIds>& link_ids,
+                                      const LinkKey& key,
+                                      const std::shared_ptr<MemoryCounter>& pending_chunks_memory) noexcept {
+    assert(link_ids != nullptr);
+    assert(key.id >= 0);
+    assert(key.serial > 0);
+
+    const auto lock = std::lock_guard<std::mutex>(mutex);
+
+    // find the table of the ids, comparing ownership so an expired table is never mistaken for a new one
+    auto directory_changed = false;
+    const auto same_ids = [&link_ids](const Table& table) {
+        return !table.link_ids.owner_before(link_ids) && !link_ids.owner_before(table.link_ids);
+    };
+    auto table = std::find_if(tables.begin(), tables.end(), same_ids);
+    if (table == tables.end()) {
+        // the links of expired tables are all destroyed, so no lookup reaches their blocks
+        tables.erase(std::remove_if(tables.begin(), tables.end(),
+                                    [](const Table& expired) { return expired.link_ids.expired(); }),
+                     tables.end());
+        tables.push_back({link_ids, link_ids->get_serial(), {}, nullptr});
+        table = std::prev(tables.end());
+        directory_changed = true;
+    }
+    auto& blocks = table->blocks;
+
+    const auto block_index = static_cast<size_t>(key.id / block_size);
+    if (block_index >= blocks.size()) {
+        blocks.resize(block_index + 1);
+    }
+    if (blocks[block_index] == nullptr) {
+        blocks[block_index] = std::make_unique<Block>();
+    }
+    auto* const block = blocks[block_index].get();
+
+    // a full index is replaced by one twice as large, leaving the previous one to the lookups reading it
+    if (table->index == nullptr || block_index >= table->index->capacity) {
+        const auto capacity =
+            std::max(block_index + 1, (table->index == nullptr) ? static_cast<size_t>(1) : 2 * table->index->capacity);
+        auto index = std::make_unique<BlockIndex>();
+        index->entries = std::make_unique<std::atomic<Block*>[]>(capacity);
+        index->capacity = capacity;
+        for (auto b = static_cast<size_t>(0); b < capacity; b++) {
+            index->entries[b].store((b < blocks.size()) ? blocks[b].get() : nullptr, std::memory_order_relaxed);
+        }
+        table->index = index.get();
+        block_indexes.push_back(std::move(index));
+        directory_changed = true;
+    }
+
+    // a slot left by a destroyed link (or never used) starts over
+    const auto slot = key.id % block_size;
+    if (block->owners[slot] != key.serial) {
+        block->owners[slot] = key.serial;
+        block->busy[slot] = 0;
+        block->pending_bytes[slot] = 0;
+        block->reserved_from[slot] = 0;
+        block->reserved_until[slot] = 0;
+        block->reservation_owners[slot] = nullptr;
+        for (auto& queue : block->pending_chunks[slot]) {
+            queue = PendingChunks(TrackingAllocator<std::unique_ptr<Chunk>>(pending_chunks_memory));
+        }
+        block->pending_classes[slot] = 0;
+
+        // the first turn goes to class 0
+        block->scheduled_classes[slot] = traffic_classes_count - 1;
+        block->deficits[slot] = {};
+        block->buffered_bytes[slot] = 0;
+        block->stalled_links[slot].clear();
+#ifdef ASTRA_NET_STATS
+        for (auto& send_times : block->pending_send_times[slot]) {
+            send_times.clear();
+        }
+        block->stats[slot] = LinkStats();
+#endif
+    }
+
+    // lookups find the block once it's published
+    table->index->entries[block_index].store(block, std::memory_order_release);
+    if (directory_changed) {
+        publish_directory();
+    }
+    return *block;
+}
+
+void LinkStates::publish_directory() noexcept {
+    auto published = std::make_unique<Directory>();
+    for (const auto& table : tables) {
+        published->tables.emplace_back(table.serial, table.index);
+    }
+    directory.store(published.get(), std::memory_order_release);
+    directories.push_back(std::move(published));
+}
+
+int LinkStates::get_attached_links_count() const noexcept {
+    const auto lock = std::lock_guard<std::mutex>(mutex);
+
+    auto attached_links_count = 0;
+    for (const auto& table : tables) {
+        for (const auto& block : table.blocks) {
+            if (block == nullptr) {
+                continue;
+            }
+            for (const auto owner : block->owners) {
+                if (owner != 0) {
+                    attached_links_count++;
+                }
+            }
+        }
+    }
+    return attached_links_count;
+}
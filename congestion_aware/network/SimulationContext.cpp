@@ -0,0 +1,134 @@
+/******************************************************************************
+This source code is licensed under the MIT license found in the
+LICENSE file in the root directory of this source tree.
+*******************************************************************************/
+
+#include "congestion_aware/SimulationContext.h"
+#include "congestion_aware/ChunkTracer.h"
+#include "congestion_aware/CompletionBatcher.h"
+#include <cassert>
+#include <cstdlib>
+#include <iostream>
+#include <utility>
+
+using namespace NetworkAnalytical;
+using namespace NetworkAnalyticalCongestionAware;
+
+std::shared_ptr<SimulationContext> SimulationContext::get_default() noexcept {
+    static const auto default_context = std::make_shared<SimulationContext>();
+    return default_context;
+}
+
+SimulationContext::SimulationContext(std::shared_ptr<EventQueue> event_queue) noexcept
+    : event_queue(std::move(event_queue)),
+      link_coalescing(false),
+      hybrid_fidelity(false),
+      per_hop_chunks_count(0),
+      cut_through_flit_size(0),
+      link_scheduling(LinkScheduling::StrictPriority),
+      quanta(default_quanta()),
+      chunk_tracer(nullptr),
+      completion_batcher(nullptr) {}
+
+void SimulationContext::set_event_queue(std::shared_ptr<EventQueue> event_queue) noexcept {
+    assert(event_queue != nullptr);
+
+    this->event_queue = std::move(event_queue);
+}
+
+EventQueue* SimulationContext::get_event_queue() const noexcept {
+    assert(event_queue != nullptr);
+
+    return event_queue.get();
+}
+
+void SimulationContext::set_link_coalescing(const bool enabled) noexcept {
+    link_coalescing = enabled;
+}
+
+bool SimulationContext::get_link_coalescing() const noexcept {
+    return link_coalescing;
+}
+
+void SimulationContext::set_hybrid_fidelity(const bool enabled) noexcept {
+    hybrid_fidelity = enabled;
+}
+
+bool SimulationContext::get_hybrid_fidelity() const noexcept {
+    return hybrid_fidelity;
+}
+
+void SimulationContext::add_per_hop_chunk() noexcept {
+    per_hop_chunks_count++;
+}
+
+void SimulationContext::remove_per_hop_chunk() noexcept {
+    assert(per_hop_chunks_count > 0);
+
+    per_hop_chunks_count--;
+}
+
+void SimulationContext::clear_per_hop_chunks() noexcept {
+    per_hop_chunks_count = 0;
+}
+
+uint64_t SimulationContext::get_per_hop_chunks_count() const noexcept {
+    return per_hop_chunks_count;
+}
+
+void SimulationContext::set_cut_through(const ChunkSize flit_size) noexcept {
+    cut_through_flit_size = flit_size;
+}
+
+ChunkSize SimulationContext::get_cut_through_flit_size() const noexcept {
+    return cut_through_flit_size;
+}
+
+void SimulationContext::set_link_scheduling(const LinkScheduling link_scheduling, const Quanta& quanta) noexcept {
+    for (const auto quantum : quanta) {
+        if (quantum == 0) {
+            std::cerr << "[Error] (network/analytical/congestion_aware) "
+                      << "traffic classes should have a positive quantum" << std::endl;
+            std::exit(-1);
+        }
+    }
+
+    this->link_scheduling = link_scheduling;
+    this->quanta = quanta;
+}
+
+SimulationContext::LinkScheduling SimulationContext::get_link_scheduling() const noexcept {
+    return link_scheduling;
+}
+
+ChunkSize SimulationContext::get_quantum(const int traffic_class) const noexcept {
+    assert(0 <= traffic_class && traffic_class < LinkStates::traffic_classes_count);
+
+    return quanta[traffic_class];
+}
+
+SimulationContext::Quanta SimulationContext::default_quanta() noexcept {
+    auto quanta = Quanta();
+    quanta.fill(default_quantum);
+    return quanta;
+}
+
+void SimulationContext::set_chunk_tracer(std::shared_ptr<ChunkTracer> chunk_tracer) noexcept {
+    this->chunk_tracer = std::move(chunk_tracer);
+}
+
+ChunkTracer* SimulationContext::get_chunk_tracer() const noexcept {
+    return chunk_tracer.get();
+}
+
+void SimulationContext::set_completion_batcher(std::shared_ptr<CompletionBatcher> completion_batcher) noexcept {
+    this->completion_batcher = std::move(completion_batcher);
+}
+
+CompletionBatcher* SimulationContext::get_completion_batcher() const noexcept {
+    return completion_batcher.get();
+}
+
+LinkStates& SimulationContext::get_link_states() noexcept {
+    return link_states;
+}
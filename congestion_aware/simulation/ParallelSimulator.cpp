@@ -0,0 +1,262 @@
+/******************************************************************************
+This source code is licensed under the MIT license found in the
+LICENSE file in the root directory of this source tree.
+*******************************************************************************/
+
+#include "congestion_aware/ParallelSimulator.h"
+#include "congestion_aware/Chunk.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <condition_variable>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <thread>
+
+using namespace NetworkAnalyticalCongestionAware;
+
+namespace {
+
+/**
+ * Reusable barrier for a fixed number of threads (std::barrier is C++20).
+ */
+class WindowBarrier {
+  public:
+    explicit WindowBarrier(const int threads_count) noexcept
+        : threads_count(threads_count),
+          waiting_count(0),
+          generation(0) {
+        assert(threads_count > 0);
+    }
+
+    void arrive_and_wait() noexcept {
+        auto lock = std::unique_lock<std::mutex>(mutex);
+        const auto arrived_generation = generation;
+
+        // last thread releases the others
+        waiting_count++;
+        if (waiting_count == threads_count) {
+            waiting_count = 0;
+            generation++;
+            condition.notify_all();
+            return;
+        }
+
+        condition.wait(lock, [&] { return generation != arrived_generation; });
+    }
+
+  private:
+    int threads_count;
+    int waiting_count;
+    uint64_t generation;
+    std::mutex mutex;
+    std::condition_variable condition;
+};
+
+}  // namespace
+
+ParallelSimulator::ParallelSimulator(std::shared_ptr<Topology> topology, const int threads_count) noexcept
+    : topology(std::move(topology)),
+      partitions_count(1),
+      lookahead(std::numeric_limits<EventTime>::max()) {
+    assert(this->topology != nullptr);
+    assert(threads_count > 0);
+
+    // a batcher gathers completions on the event queue of the context, which partitions don't run
+    if (this->topology->get_simulation_context()->get_completion_batcher() != nullptr) {
+        std::cerr << "[Error] (network/analytical/congestion_aware) "
+                  << "a simulation batching completions can't be partitioned" << std::endl;
+        std::exit(-1);
+    }
+
+    // stalled links are resumed by links of other partitions
+    if (this->topology->get_switch_buffer_size() > 0) {
+        std::cerr << "[Error] (network/analytical/congestion_aware) "
+                  << "a simulation with bounded switch buffers can't be partitioned" << std::endl;
+        std::exit(-1);
+    }
+
+    // can't have more partitions than devices
+    partitions_count = std::min(threads_count, this->topology->get_devices_count());
+
+    // cross-partition links without latency leave no room for parallelism
+    lookahead = compute_lookahead();
+    if (partitions_count > 1 && lookahead == 0) {
+        std::cerr << "[Warning] (network/analytical/congestion_aware) "
+                  << "some cross-partition link has zero latency; running on a single partition" << std::endl;
+        partitions_count = 1;
+        lookahead = compute_lookahead();
+    }
+
+    // create per-partition event queues and outboxes
+    for (auto i = 0; i < partitions_count; i++) {
+        event_queues.push_back(std::make_unique<EventQueue>());
+    }
+    remote_arrivals.resize(partitions_count);
+
+    bind_links();
+}
+
+ParallelSimulator::~ParallelSimulator() noexcept {
+    // give every link back to the shared event queue
+    const auto devices_count = topology->get_devices_count();
+    for (auto i = 0; i < devices_count; i++) {
+        const auto device = topology->get_device(i);
+        for (auto port = 0; port < device->get_ports_count(); port++) {
+            device->get_link(port).unbind_partition();
+        }
+    }
+}
+
+int ParallelSimulator::get_partition(const DeviceId device_id) const noexcept {
+    const auto devices_count = topology->get_devices_count();
+    assert(0 <= device_id && device_id < devices_count);
+
+    // contiguous id blocks
+    const auto partition = static_cast<int64_t>(device_id) * partitions_count / devices_count;
+    return static_cast<int>(partition);
+}
+
+int ParallelSimulator::get_partitions_count() const noexcept {
+    assert(partitions_count > 0);
+
+    return partitions_count;
+}
+
+EventTime ParallelSimulator::get_lookahead() const noexcept {
+    return lookahead;
+}
+
+EventTime ParallelSimulator::get_current_time() const noexcept {
+    // partitions advance independently, report the furthest one
+    auto current_time = static_cast<EventTime>(0);
+    for (const auto& event_queue : event_queues) {
+        current_time = std::max(current_time, event_queue->get_current_time());
+    }
+    return current_time;
+}
+
+EventTime ParallelSimulator::compute_lookahead() const noexcept {
+    auto min_latency = std::numeric_limits<EventTime>::max();
+
+    // find the smallest latency over links crossing partitions
+    const auto devices_count = topology->get_devices_count();
+    for (auto i = 0; i < devices_count; i++) {
+        const auto src_partition = get_partition(i);
+        const auto device = topology->get_device(i);
+        for (auto port = 0; port < device->get_ports_count(); port++) {
+            if (get_partition(device->get_port_dest(port)) == src_partition) {
+                continue;
+            }
+
+            // arrival times are truncated to EventTime, so round down
+            const auto latency = static_cast<EventTime>(std::floor(device->get_link(port).get_latency()));
+            min_latency = std::min(min_latency, latency);
+        }
+    }
+
+    return min_latency;
+}
+
+void ParallelSimulator::bind_links() noexcept {
+    const auto devices_count = topology->get_devices_count();
+    for (auto i = 0; i < devices_count; i++) {
+        const auto src_partition = get_partition(i);
+        auto* const local_event_queue = event_queues[src_partition].get();
+
+        const auto device = topology->get_device(i);
+        for (auto port = 0; port < device->get_ports_count(); port++) {
+            const auto dest_partition = get_partition(device->get_port_dest(port));
+            auto* const outbox = (dest_partition == src_partition) ? nullptr : &remote_arrivals[src_partition];
+            device->get_link(port).bind_partition(local_event_queue, outbox, dest_partition);
+        }
+    }
+}
+
+void ParallelSimulator::process_window(const int partition, const EventTime window_end) noexcept {
+    auto& event_queue = *event_queues[partition];
+
+    // every event before window_end is safe: no remote arrival can precede it
+    while (!event_queue.finished() && event_queue.get_next_event_time() < window_end) {
+        event_queue.proceed();
+    }
+}
+
+void ParallelSimulator::exchange_remote_arrivals() noexcept {
+    for (auto& outbox : remote_arrivals) {
+        for (auto& arrival : outbox) {
+            event_queues[arrival.dest_partition]->schedule_event(
+                arrival.arrival_time, [chunk = std::move(arrival.chunk)]() mutable {
+                    Chunk::arrived_next_device(std::move(chunk));
+                });
+        }
+        outbox.clear();
+    }
+}
+
+bool ParallelSimulator::finished() const noexcept {
+    for (auto i = 0; i < partitions_count; i++) {
+        if (!event_queues[i]->finished() || !remote_arrivals[i].empty()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void ParallelSimulator::run() noexcept {
+    // a single partition is a plain serial run
+    if (partitions_count == 1) {
+        event_queues[0]->run();
+        return;
+    }
+
+    auto barrier = WindowBarrier(partitions_count);
+    auto window_end = static_cast<EventTime>(0);
+    auto stop = false;
+
+    // partition 0 runs on the calling thread, which also coordinates windows
+    auto workers = std::vector<std::thread>();
+    for (auto partition = 1; partition < partitions_count; partition++) {
+        workers.emplace_back([&, partition] {
+            while (true) {
+                barrier.arrive_and_wait();
+                if (stop) {
+                    break;
+                }
+                process_window(partition, window_end);
+                barrier.arrive_and_wait();
+            }
+        });
+    }
+
+    while (true) {
+        exchange_remote_arrivals();
+
+        if (finished()) {
+            stop = true;
+            barrier.arrive_and_wait();
+            break;
+        }
+
+        // next window starts at the earliest pending event
+        auto window_start = std::numeric_limits<EventTime>::max();
+        for (const auto& event_queue : event_queues) {
+            if (!event_queue->finished()) {
+                window_start = std::min(window_start, event_queue->get_next_event_time());
+            }
+        }
+        window_end = (lookahead > std::numeric_limits<EventTime>::max() - window_start)
+                         ? std::numeric_limits<EventTime>::max()
+                         : window_start + lookahead;
+
+        barrier.arrive_and_wait();
+        process_window(0, window_end);
+        barrier.arrive_and_wait();
+    }
+
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
@@ -0,0 +1,179 @@
+/******************************************************************************
+This source code is licensed under the MIT license found in the
+LICENSE file in the root directory of this source tree.
+*******************************************************************************/
+
+#include "congestion_aware/SimulationFork.h"
+#include "congestion_aware/SimulationContext.h"
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+
+using namespace NetworkAnalyticalCongestionAware;
+
+namespace {
+
+/**
+ * Write the whole buffer to a file descriptor.
+ */
+bool write_fully(const int fd, const void* const data, const size_t size) noexcept {
+    const auto* bytes = static_cast<const char*>(data);
+    auto remaining = size;
+    while (remaining > 0) {
+        const auto written = write(fd, bytes, remaining);
+        if (written <= 0) {
+            return false;
+        }
+        bytes += written;
+        remaining -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+/**
+ * Read exactly size bytes from a file descriptor.
+ */
+bool read_fully(const int fd, void* const data, const size_t size) noexcept {
+    auto* bytes = static_cast<char*>(data);
+    auto remaining = size;
+    while (remaining > 0) {
+        const auto read_count = read(fd, bytes, remaining);
+        if (read_count <= 0) {
+            return false;
+        }
+        bytes += read_count;
+        remaining -= static_cast<size_t>(read_count);
+    }
+    return true;
+}
+
+}  // namespace
+
+SimulationFork::SimulationFork(std::shared_ptr<Topology> topology) noexcept : topology(std::move(topology)) {
+    assert(this->topology != nullptr);
+}
+
+EventTime SimulationFork::checkpoint(const EventTime checkpoint_time) noexcept {
+    auto* const event_queue = topology->get_simulation_context()->get_event_queue();
+    assert(event_queue != nullptr);
+
+    event_queue->run_until(checkpoint_time);
+    return event_queue->get_current_time();
+}
+
+std::vector<SimulationFork::VariantResult> SimulationFork::fork(const int variants_count,
+                                                                const VariantSetup setup,
+                                                                void* const arg,
+                                                                const VariantReport report,
+                                                                int processes_count) const noexcept {
+    assert(variants_count >= 0);
+    assert(setup != nullptr);
+    assert(processes_count >= 0);
+
+    // the writer thread of a tracer wouldn't exist in the variants
+    if (topology->get_simulation_context()->get_chunk_tracer() != nullptr) {
+        std::cerr << "[Error] (network/analytical/congestion_aware) "
+                  << "a simulation being traced can't be forked" << std::endl;
+        std::exit(-1);
+    }
+
+    if (processes_count == 0) {
+        processes_count = static_cast<int>(std::max(1U, std::thread::hardware_concurrency()));
+    }
+
+    // buffered output would otherwise be written once per process
+    std::cout.flush();
+    std::cerr.flush();
+    std::fflush(nullptr);
+
+    auto results = std::vector<VariantResult>(variants_count);
+    auto running = std::deque<std::pair<int, std::pair<int, int>>>();  // (variant, (pid, fd))
+    for (auto variant = 0; variant < variants_count; variant++) {
+        // keep at most processes_count variants running, collecting the oldest first
+        if (static_cast<int>(running.size()) >= processes_count) {
+            const auto& [oldest, process] = running.front();
+            results[oldest] = collect_variant(process.first, process.second);
+            running.pop_front();
+        }
+
+        int fds[2];
+        if (pipe(fds) != 0) {
+            std::cerr << "[Error] (network/analytical/congestion_aware) "
+                      << "couldn't create a pipe for simulation variant " << variant << std::endl;
+            std::exit(-1);
+        }
+        const auto pid = ::fork();
+        if (pid < 0) {
+            std::cerr << "[Error] (network/analytical/congestion_aware) "
+                      << "couldn't fork simulation variant " << variant << std::endl;
+            std::exit(-1);
+        }
+        if (pid == 0) {
+            close(fds[0]);
+            run_variant(variant, setup, arg, report, fds[1]);
+        }
+        close(fds[1]);
+        running.push_back({variant, {pid, fds[0]}});
+    }
+
+    // collect the remaining variants
+    for (const auto& [variant, process] : running) {
+        results[variant] = collect_variant(process.first, process.second);
+    }
+    return results;
+}
+
+void SimulationFork::run_variant(const int variant,
+                                 const VariantSetup setup,
+                                 void* const arg,
+                                 const VariantReport report,
+                                 const int fd) const noexcept {
+    // set up the variant, and run it to completion
+    setup(variant, arg);
+    auto* const event_queue = topology->get_simulation_context()->get_event_queue();
+    event_queue->run();
+    const auto finish_time = event_queue->get_current_time();
+    const auto report_str = (report == nullptr) ? std::string() : report(variant, arg);
+
+    // outcome: finish time, report length, report
+    const auto report_length = static_cast<uint64_t>(report_str.size());
+    const auto written = write_fully(fd, &finish_time, sizeof(finish_time)) &&
+                         write_fully(fd, &report_length, sizeof(report_length)) &&
+                         write_fully(fd, report_str.data(), report_str.size());
+    close(fd);
+
+    // skip the destructors: the image of the simulation belongs to the parent
+    std::cout.flush();
+    std::cerr.flush();
+    _exit(written ? 0 : 1);
+}
+
+SimulationFork::VariantResult SimulationFork::collect_variant(const int pid, const int fd) noexcept {
+    auto result = VariantResult{false, 0, std::string()};
+
+    // read the outcome until the variant closes the pipe
+    auto report_length = static_cast<uint64_t>(0);
+    auto reported = read_fully(fd, &result.finish_time, sizeof(result.finish_time)) &&
+                    read_fully(fd, &report_length, sizeof(report_length));
+    if (reported) {
+        result.report.resize(report_length);
+        reported = read_fully(fd, result.report.data(), report_length);
+    }
+    close(fd);
+
+    auto status = 0;
+    const auto exited = (waitpid(pid, &status, 0) == pid) && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    result.completed = reported && exited;
+    if (!result.completed) {
+        result.finish_time = 0;
+        result.report.clear();
+    }
+    return result;
+}
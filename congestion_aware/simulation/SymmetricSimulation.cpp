@@ -0,0 +1,203 @@
+/******************************************************************************
+This source code is licensed under the MIT license found in the
+LICENSE file in the root directory of this source tree.
+*******************************************************************************/
+
+#include "congestion_aware/SymmetricSimulation.h"
+#include "congestion_aware/Chunk.h"
+#include "congestion_aware/Device.h"
+#include "congestion_aware/Link.h"
+#include "congestion_aware/SimulationContext.h"
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+
+using namespace NetworkAnalyticalCongestionAware;
+
+SymmetricSimulation::SymmetricSimulation(std::shared_ptr<Topology> topology) noexcept : topology(std::move(topology)) {
+    assert(this->topology != nullptr);
+}
+
+SymmetricSimulation::Result SymmetricSimulation::run(const std::vector<Transfer>& transfers) noexcept {
+    auto* const event_queue = topology->get_simulation_context()->get_event_queue();
+    auto result = Result{false, 0, std::vector<EventTime>(transfers.size(), 0)};
+
+    auto orbits = Orbits();
+    if (!reduce(transfers, orbits)) {
+        // simulate every transfer
+        auto* const completion_times = result.completion_times.data();
+        for (auto i = static_cast<size_t>(0); i < transfers.size(); i++) {
+            const auto& transfer = transfers[i];
+            topology->send(transfer.src, transfer.dest, transfer.size, [completion_times, i, event_queue]() {
+                completion_times[i] = event_queue->get_current_time();
+            });
+        }
+        event_queue->run();
+
+        result.simulated_transfers_count = transfers.size();
+        return result;
+    }
+
+    // simulate the representatives only
+    auto representative_times = std::vector<EventTime>(orbits.representatives.size(), 0);
+    auto* const completion_times = representative_times.data();
+    for (auto r = static_cast<size_t>(0); r < orbits.representatives.size(); r++) {
+        const auto& transfer = transfers[orbits.representatives[r]];
+        auto chunk = std::make_unique<Chunk>(transfer.size, orbits.representative_hops[r],
+                                             [completion_times, r, event_queue]() {
+                                                 completion_times[r] = event_queue->get_current_time();
+                                             });
+        chunk->set_representative(true);
+        topology->send(std::move(chunk));
+    }
+    event_queue->run();
+
+    // replicate the results to every transfer
+    for (auto i = static_cast<size_t>(0); i < transfers.size(); i++) {
+        result.completion_times[i] = representative_times[orbits.representative_of[i]];
+    }
+    result.reduced = true;
+    result.simulated_transfers_count = orbits.representatives.size();
+    return result;
+}
+
+bool SymmetricSimulation::reduce(const std::vector<Transfer>& transfers, Orbits& orbits) const noexcept {
+    const auto npus_count = topology->get_npus_count();
+
+    // the topology should have symmetries, and routes that don't change afterwards
+    if (!topology->has_static_routes() || topology->map_by_symmetry(0, 0) != 0 ||
+        topology->get_simulation_context()->get_chunk_tracer() != nullptr) {
+        return false;
+    }
+
+    // transfers of each NPU, in the order given
+    auto transfers_per_npu = std::vector<std::vector<size_t>>(npus_count);
+    for (auto i = static_cast<size_t>(0); i < transfers.size(); i++) {
+        const auto& transfer = transfers[i];
+        assert(0 <= transfer.src && transfer.src < npus_count);
+        assert(0 <= transfer.dest && transfer.dest < npus_count);
+        assert(transfer.src != transfer.dest);
+        assert(transfer.size > 0);
+
+        transfers_per_npu[transfer.src].push_back(i);
+    }
+
+    // the n-th transfer of each NPU should be the image of the n-th transfer of NPU 0,
+    // so that every NPU queues the same chunks in the same order
+    orbits.representatives = transfers_per_npu[0];
+    orbits.representative_of.resize(transfers.size());
+    for (auto npu = 0; npu < npus_count; npu++) {
+        const auto& npu_transfers = transfers_per_npu[npu];
+        if (npu_transfers.size() != orbits.representatives.size()) {
+            return false;
+        }
+        for (auto n = static_cast<size_t>(0); n < npu_transfers.size(); n++) {
+            const auto& representative = transfers[orbits.representatives[n]];
+            const auto& transfer = transfers[npu_transfers[n]];
+            if (transfer.size != representative.size ||
+                transfer.dest != topology->map_by_symmetry(representative.dest, npu)) {
+                return false;
+            }
+            orbits.representative_of[npu_transfers[n]] = n;
+        }
+    }
+
+    // every image of a route should be the route of the image
+    auto checked_dests = std::vector<bool>(npus_count, false);
+    for (const auto transfer_index : orbits.representatives) {
+        const auto dest = transfers[transfer_index].dest;
+        if (checked_dests[dest]) {
+            continue;
+        }
+        checked_dests[dest] = true;
+
+        const auto& route_hops = topology->get_route_hops(0, dest);
+        for (auto npu = 1; npu < npus_count; npu++) {
+            if (topology->map_by_symmetry(0, npu) != npu) {
+                return false;
+            }
+            const auto& image_route_hops = topology->get_route_hops(npu, topology->map_by_symmetry(dest, npu));
+            if (image_route_hops.size() != route_hops.size()) {
+                return false;
+            }
+            for (auto hop = static_cast<size_t>(0); hop < route_hops.size(); hop++) {
+                const auto image_device = topology->map_by_symmetry(route_hops[hop].device->get_id(), npu);
+                if (image_route_hops[hop].device->get_id() != image_device) {
+                    return false;
+                }
+            }
+        }
+    }
+
+    // route the representatives over the representatives of their links
+    auto link_representatives = std::unordered_map<uint64_t, RouteHop>();
+    orbits.representative_hops.reserve(orbits.representatives.size());
+    for (const auto transfer_index : orbits.representatives) {
+        const auto& transfer = transfers[transfer_index];
+        const auto& route_hops = topology->get_route_hops(transfer.src, transfer.dest);
+
+        auto representative_hops = RouteHops();
+        for (auto hop = static_cast<size_t>(0); hop + 1 < route_hops.size(); hop++) {
+            const auto device = route_hops[hop].device->get_id();
+            const auto next_device = route_hops[hop + 1].device->get_id();
+            const auto link_key = (static_cast<uint64_t>(device) << 32) | static_cast<uint32_t>(next_device);
+
+            auto link_representative = link_representatives.find(link_key);
+            if (link_representative == link_representatives.end()) {
+                auto representative = RouteHop();
+                if (!find_link_representative(device, next_device, representative)) {
+                    return false;
+                }
+                link_representative = link_representatives.emplace(link_key, representative).first;
+            }
+            representative_hops.push_back(link_representative->second);
+        }
+        representative_hops.push_back({route_hops.back().device, -1});
+        orbits.representative_hops.push_back(std::move(representative_hops));
+    }
+
+    return true;
+}
+
+bool SymmetricSimulation::find_link_representative(const DeviceId device,
+                                                   const DeviceId next_device,
+                                                   RouteHop& representative) const noexcept {
+    // links are only read, so lazy links aren't created
+    const Device& link_device = *topology->get_device(device);
+    const auto& link = link_device.get_link(link_device.get_port(next_device));
+
+    // the image with the smallest ids represents the orbit
+    auto representative_ids = std::make_pair(device, next_device);
+    for (auto npu = 0; npu < topology->get_npus_count(); npu++) {
+        const auto image = std::make_pair(topology->map_by_symmetry(device, npu),
+                                          topology->map_by_symmetry(next_device, npu));
+
+        // the link would stand for itself more than once
+        if (npu != 0 && image.first == device && image.second == next_device) {
+            return false;
+        }
+
+        // images should be alike
+        if (image.first < 0 || image.second < 0) {
+            return false;
+        }
+        const Device& image_device = *topology->get_device(image.first);
+        const auto image_port = image_device.get_port(image.second);
+        if (image_port < 0) {
+            return false;
+        }
+        const auto& image_link = image_device.get_link(image_port);
+        if (image_link.is_failed() || image_link.get_bandwidth() != link.get_bandwidth() ||
+            image_link.get_latency() != link.get_latency()) {
+            return false;
+        }
+
+        representative_ids = std::min(representative_ids, image);
+    }
+
+    const auto representative_device = topology->get_device(representative_ids.first);
+    representative = {representative_device.get(), representative_device->get_port(representative_ids.second)};
+    return true;
+}
@@ -0,0 +1,35 @@
+/******************************************************************************
+This source code is licensed under the MIT license found in the
+LICENSE file in the root directory of this source tree.
+*******************************************************************************/
+
+#include "congestion_aware/Sweep.h"
+#include <fstream>
+#include <iostream>
+
+using namespace NetworkAnalyticalCongestionAware;
+
+int main(int argc, char* argv[]) {
+    if (argc < 2 || argc > 3) {
+        std::cerr << "Usage: " << argv[0] << " <sweep.yml> [output.csv]" << std::endl;
+        return -1;
+    }
+
+    // parse the sweep spec
+    const auto sweep = Sweep(argv[1]);
+    std::cerr << "Sweeping " << sweep.get_points_count() << " points, " << sweep.get_workloads().size()
+              << " workloads each" << std::endl;
+
+    // write the results to stdout unless an output file is given
+    if (argc == 2) {
+        sweep.run(std::cout);
+        return 0;
+    }
+    auto output = std::ofstream(argv[2]);
+    if (!output.is_open()) {
+        std::cerr << "[Error] (network/analytical/congestion_aware) " << "can't open " << argv[2] << std::endl;
+        return -1;
+    }
+    sweep.run(output);
+    return 0;
+}
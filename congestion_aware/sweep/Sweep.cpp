@@ -0,0 +1,344 @@
+/******************************************************************************
+This source code is licensed under the MIT license found in the
+LICENSE file in the root directory of this source tree.
+*******************************************************************************/
+
+#include "congestion_aware/Sweep.h"
+#include "common/EventQueue.h"
+#include "common/NetworkParser.h"
+#include "congestion_aware/ExpanderGraph.h"
+#include "congestion_aware/Helper.h"
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+using namespace NetworkAnalytical;
+using namespace NetworkAnalyticalCongestionAware;
+
+namespace {
+
+/// network config keys a sweep can vary, in the order their values are combined
+const auto sweepable_keys = std::vector<std::string>{"npus_count", "bandwidth", "latency", "routing_algorithm"};
+
+/**
+ * Progress of a ring All-Gather: every NPU forwards a step to the next NPU,
+ * and the next step starts once every NPU received the current one.
+ */
+struct AllGatherState {
+    Topology* topology;
+    ChunkSize step_size;
+    ChunkSize chunk_size;
+    int steps_left;
+    int arrivals_count;
+};
+
+/**
+ * Send the next step of a ring All-Gather.
+ */
+void send_all_gather_step(AllGatherState* const state) noexcept {
+    const auto npus_count = state->topology->get_npus_count();
+    for (auto src = 0; src < npus_count; src++) {
+        state->topology->send_message(src, (src + 1) % npus_count, state->step_size, state->chunk_size, [state]() {
+            // the step is over when every NPU received it
+            if (++state->arrivals_count < state->topology->get_npus_count()) {
+                return;
+            }
+            state->arrivals_count = 0;
+            if (--state->steps_left > 0) {
+                send_all_gather_step(state);
+            }
+        });
+    }
+}
+
+/**
+ * Simulate a workload on an idle topology.
+ *
+ * @return time when the workload finished
+ */
+EventTime run_workload(Topology& topology, const Sweep::Workload& workload) noexcept {
+    auto* const event_queue = topology.get_simulation_context()->get_event_queue();
+    const auto npus_count = topology.get_npus_count();
+    const auto chunk_size = std::min(workload.chunk_size, workload.size);
+    const auto arrived = []() {};
+
+    switch (workload.pattern) {
+    case Sweep::Pattern::AllToAll:
+        for (auto src = 0; src < npus_count; src++) {
+            for (auto dest = 0; dest < npus_count; dest++) {
+                if (src != dest) {
+                    topology.send_message(src, dest, workload.size, chunk_size, arrived);
+                }
+            }
+        }
+        event_queue->run();
+        break;
+    case Sweep::Pattern::Shift:
+        for (auto src = 0; src < npus_count; src++) {
+            topology.send_message(src, (src + 1) % npus_count, workload.size, chunk_size, arrived);
+        }
+        event_queue->run();
+        break;
+    case Sweep::Pattern::AllGather: {
+        const auto step_size = std::max<ChunkSize>(workload.size / npus_count, 1);
+        auto state = AllGatherState{&topology, step_size, std::min(chunk_size, step_size), npus_count - 1, 0};
+        send_all_gather_step(&state);
+        event_queue->run();
+        break;
+    }
+    default:
+        // shouldn't reach here
+        std::cerr << "[Error] (network/analytical/congestion_aware) " << "Not supported workload pattern" << std::endl;
+        std::exit(-1);
+    }
+
+    return event_queue->get_current_time();
+}
+
+/**
+ * Get the name of a workload pattern, as written in the sweep spec.
+ */
+std::string get_pattern_name(const Sweep::Pattern pattern) noexcept {
+    switch (pattern) {
+    case Sweep::Pattern::AllToAll:
+        return "AllToAll";
+    case Sweep::Pattern::Shift:
+        return "Shift";
+    case Sweep::Pattern::AllGather:
+        return "AllGather";
+    default:
+        // shouldn't reach here
+        std::cerr << "[Error] (network/analytical/congestion_aware) " << "Not supported workload pattern" << std::endl;
+        std::exit(-1);
+    }
+}
+
+/**
+ * Format a swept value for a CSV field: per-dimension values separated by spaces.
+ */
+std::string format_value(const YAML::Node& value) noexcept {
+    auto formatted = std::string();
+    for (const auto& element : value) {
+        formatted += (formatted.empty() ? "" : " ") + element.as<std::string>();
+    }
+    return formatted;
+}
+
+}  // namespace
+
+Sweep::Sweep(const std::string& path) noexcept : spec_threads_count(0) {
+    auto spec = YAML::Node();
+    try {
+        spec = YAML::LoadFile(path);
+    } catch (const YAML::BadFile& e) {
+        // loading sweep spec failed
+        std::cerr << "[Error] (network/analytical/congestion_aware) " << e.what() << std::endl;
+        std::exit(-1);
+    }
+
+    try {
+        // base network config, relative to the spec
+        if (!spec["network"]) {
+            std::cerr << "[Error] (network/analytical/congestion_aware) " << "sweep spec should name a network"
+                      << std::endl;
+            std::exit(-1);
+        }
+        network_path = spec["network"].as<std::string>();
+        const auto directory_end = path.find_last_of('/');
+        if (network_path.front() != '/' && directory_end != std::string::npos) {
+            network_path = path.substr(0, directory_end + 1) + network_path;
+        }
+        base_network_config = YAML::LoadFile(network_path);
+        const auto dims_count = base_network_config["topology"].size();
+
+        // swept values, a single value standing for every dimension
+        const auto sweep = spec["sweep"];
+        for (const auto& entry : sweep) {
+            const auto key = entry.first.as<std::string>();
+            if (std::find(sweepable_keys.begin(), sweepable_keys.end(), key) == sweepable_keys.end()) {
+                std::cerr << "[Error] (network/analytical/congestion_aware) " << "can't sweep " << key << std::endl;
+                std::exit(-1);
+            }
+        }
+        for (const auto& key : sweepable_keys) {
+            if (!sweep[key]) {
+                continue;
+            }
+            auto values = std::vector<YAML::Node>();
+            for (const auto& value : sweep[key]) {
+                if (value.IsSequence()) {
+                    values.push_back(value);
+                    continue;
+                }
+                auto per_dim_value = YAML::Node(YAML::NodeType::Sequence);
+                for (auto dim = static_cast<size_t>(0); dim < dims_count; dim++) {
+                    per_dim_value.push_back(value);
+                }
+                values.push_back(per_dim_value);
+            }
+            if (values.empty()) {
+                std::cerr << "[Error] (network/analytical/congestion_aware) " << "no value to sweep " << key << std::endl;
+                std::exit(-1);
+            }
+            swept_keys.push_back(key);
+            swept_values.push_back(std::move(values));
+        }
+
+        // workloads
+        for (const auto& entry : spec["workloads"]) {
+            const auto pattern_name = entry["pattern"].as<std::string>();
+            auto workload = Workload();
+            workload.pattern = parse_pattern(pattern_name);
+            workload.size = entry["size"].as<ChunkSize>();
+            workload.chunk_size = entry["chunk_size"] ? entry["chunk_size"].as<ChunkSize>() : workload.size;
+            workload.name = entry["name"] ? entry["name"].as<std::string>()
+                                          : pattern_name + "_" + std::to_string(workload.size);
+            if (workload.size <= 0 || workload.chunk_size <= 0) {
+                std::cerr << "[Error] (network/analytical/congestion_aware) "
+                          << "workload size and chunk_size should be larger than 0" << std::endl;
+                std::exit(-1);
+            }
+            workloads.push_back(std::move(workload));
+        }
+        if (workloads.empty()) {
+            std::cerr << "[Error] (network/analytical/congestion_aware) " << "sweep spec should list workloads"
+                      << std::endl;
+            std::exit(-1);
+        }
+
+        if (spec["threads"]) {
+            spec_threads_count = spec["threads"].as<int>();
+        }
+    } catch (const YAML::Exception& e) {
+        // malformed sweep spec
+        std::cerr << "[Error] (network/analytical/congestion_aware) " << e.what() << std::endl;
+        std::exit(-1);
+    }
+}
+
+int Sweep::get_points_count() const noexcept {
+    auto points_count = 1;
+    for (const auto& values : swept_values) {
+        points_count *= static_cast<int>(values.size());
+    }
+    return points_count;
+}
+
+const std::vector<Sweep::Workload>& Sweep::get_workloads() const noexcept {
+    return workloads;
+}
+
+void Sweep::run(std::ostream& output, int threads_count) const noexcept {
+    assert(threads_count >= 0);
+
+    // header
+    output << "point";
+    for (const auto& key : swept_keys) {
+        output << "," << key;
+    }
+    output << ",workload,pattern,size,finish_time_ns" << std::endl;
+
+    // each thread takes the next point, and writes its rows once it's done
+    const auto points_count = get_points_count();
+    auto next_point = std::atomic<int>(0);
+    auto output_mutex = std::mutex();
+    const auto worker = [&]() {
+        for (auto point = next_point++; point < points_count; point = next_point++) {
+            const auto rows = run_point(point);
+            const auto lock = std::lock_guard<std::mutex>(output_mutex);
+            output << rows << std::flush;
+        }
+    };
+
+    if (threads_count == 0) {
+        threads_count = spec_threads_count;
+    }
+    if (threads_count <= 0) {
+        threads_count = static_cast<int>(std::max(1U, std::thread::hardware_concurrency()));
+    }
+    threads_count = std::max(1, std::min(threads_count, points_count));
+
+    auto threads = std::vector<std::thread>();
+    for (auto i = 1; i < threads_count; i++) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+Sweep::Pattern Sweep::parse_pattern(const std::string& name) noexcept {
+    if (name == "AllToAll") {
+        return Pattern::AllToAll;
+    }
+    if (name == "Shift") {
+        return Pattern::Shift;
+    }
+    if (name == "AllGather") {
+        return Pattern::AllGather;
+    }
+
+    // shouldn't reach here
+    std::cerr << "[Error] (network/analytical/congestion_aware) " << "Workload pattern " << name << " not supported"
+              << std::endl;
+    std::exit(-1);
+}
+
+std::vector<int> Sweep::get_value_indices(int point) const noexcept {
+    assert(0 <= point && point < get_points_count());
+
+    // the first swept key varies fastest
+    auto value_indices = std::vector<int>();
+    for (const auto& values : swept_values) {
+        const auto values_count = static_cast<int>(values.size());
+        value_indices.push_back(point % values_count);
+        point /= values_count;
+    }
+    return value_indices;
+}
+
+std::string Sweep::run_point(const int point) const noexcept {
+    // network config of the point
+    const auto value_indices = get_value_indices(point);
+    auto network_config = YAML::Clone(base_network_config);
+    for (auto i = static_cast<size_t>(0); i < swept_keys.size(); i++) {
+        network_config[swept_keys[i]] = swept_values[i][value_indices[i]];
+    }
+
+    // the point's own context, so points simulate concurrently
+    const auto network_parser = NetworkParser(network_config, network_path);
+    const auto context = std::make_shared<SimulationContext>(std::make_shared<EventQueue>());
+    const auto topology = construct_topology(network_parser, context);
+
+    // candidate paths are shared with the other points of the same graph
+    const auto expander_graph = std::dynamic_pointer_cast<ExpanderGraph>(topology);
+    if (expander_graph != nullptr && !expander_graph->has_static_routes()) {
+        expander_graph->precompute_k_shortest_paths(1);
+    }
+
+    auto rows = std::ostringstream();
+    for (auto w = static_cast<size_t>(0); w < workloads.size(); w++) {
+        // the topology is constructed once per point
+        if (w > 0) {
+            topology->reset();
+            context->get_event_queue()->reset();
+        }
+        const auto& workload = workloads[w];
+        const auto finish_time = run_workload(*topology, workload);
+
+        rows << point;
+        for (auto i = static_cast<size_t>(0); i < swept_keys.size(); i++) {
+            rows << "," << format_value(swept_values[i][value_indices[i]]);
+        }
+        rows << "," << workload.name << "," << get_pattern_name(workload.pattern) << "," << workload.size
+             << "," << finish_time << "\n";
+    }
+    return rows.str();
+}
@@ -0,0 +1,241 @@
+/******************************************************************************
+This source code is licensed under the MIT license found in the
+LICENSE file in the root directory of this source tree.
+*******************************************************************************/
+
+#include "congestion_aware/CompiledTopology.h"
+#include "congestion_aware/Link.h"
+#include <array>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace NetworkAnalytical;
+using namespace NetworkAnalyticalCongestionAware;
+
+namespace {
+
+/// identifies a CompiledTopology file, and its version
+constexpr char file_magic[8] = {'A', 'N', 'A', 'T', 'O', 'P', '0', '1'};
+
+/// file header fields, following the magic
+enum HeaderField { Key = 0, DevicesCount, NpusCount, DimsCount, LinksCount, RouteNodesCount, HeaderFieldsCount };
+
+/// file header: magic, then the header fields
+constexpr size_t file_header_size = sizeof(file_magic) + (HeaderFieldsCount * sizeof(uint64_t));
+
+/// a link of the file, listed per source device in port order
+struct FileLink {
+    Bandwidth bandwidth;
+    Latency latency;
+    int32_t src;
+    int32_t dest;
+};
+
+/**
+ * Offsets of the sections of a file, following the header, 8-byte aligned sections first:
+ * bandwidth per dim, links, route offsets, NPUs count per dim, route nodes.
+ */
+struct FileLayout {
+    size_t bandwidths_offset;
+    size_t links_offset;
+    size_t route_offsets_offset;
+    size_t npus_counts_offset;
+    size_t route_nodes_offset;
+    size_t file_size;
+
+    explicit FileLayout(const std::array<uint64_t, HeaderFieldsCount>& header) noexcept {
+        const auto pairs_count = header[NpusCount] * header[NpusCount];
+        bandwidths_offset = file_header_size;
+        links_offset = bandwidths_offset + (header[DimsCount] * sizeof(Bandwidth));
+        route_offsets_offset = links_offset + (header[LinksCount] * sizeof(FileLink));
+        npus_counts_offset = route_offsets_offset + ((pairs_count + 1) * sizeof(uint64_t));
+        route_nodes_offset = npus_counts_offset + (header[DimsCount] * sizeof(int32_t));
+        file_size = route_nodes_offset + (header[RouteNodesCount] * sizeof(int32_t));
+    }
+};
+
+/**
+ * Write a vector to a binary stream.
+ */
+template <typename T>
+void write_vector(std::ofstream& file, const std::vector<T>& values) noexcept {
+    file.write(reinterpret_cast<const char*>(values.data()), static_cast<std::streamsize>(values.size() * sizeof(T)));
+}
+
+}  // namespace
+
+CompiledTopology::CompiledTopology() noexcept : route_offsets(nullptr), route_nodes(nullptr) {}
+
+bool CompiledTopology::save(const Topology& topology, const std::string& path, const uint64_t key) noexcept {
+    // only static routes can be recorded
+    if (!topology.has_static_routes()) {
+        return false;
+    }
+
+    const auto devices_count = topology.get_devices_count();
+    const auto npus_count = topology.get_npus_count();
+
+    // links of every device, in port order so ports are preserved
+    auto links = std::vector<FileLink>();
+    for (auto src = 0; src < devices_count; src++) {
+        // read-only, so lazy links aren't created
+        const auto device = std::shared_ptr<const Device>(topology.get_device(src));
+        for (auto port = 0; port < device->get_ports_count(); port++) {
+            const auto& link = device->get_link(port);
+            links.push_back({link.get_bandwidth(), link.get_latency(), src, device->get_port_dest(port)});
+        }
+    }
+
+    // route of every pair
+    auto route_offsets = std::vector<uint64_t>(1, 0);
+    auto route_nodes = std::vector<int32_t>();
+    for (auto src = 0; src < npus_count; src++) {
+        for (auto dest = 0; dest < npus_count; dest++) {
+            if (src != dest) {
+                for (const auto& device : topology.route(src, dest)) {
+                    route_nodes.push_back(device->get_id());
+                }
+            }
+            route_offsets.push_back(route_nodes.size());
+        }
+    }
+
+    const auto bandwidths_per_dim = topology.get_bandwidth_per_dim();
+    const auto npus_counts_per_dim = topology.get_npus_count_per_dim();
+    auto npus_counts = std::vector<int32_t>(npus_counts_per_dim.begin(), npus_counts_per_dim.end());
+
+    auto header = std::array<uint64_t, HeaderFieldsCount>();
+    header[Key] = key;
+    header[DevicesCount] = static_cast<uint64_t>(devices_count);
+    header[NpusCount] = static_cast<uint64_t>(npus_count);
+    header[DimsCount] = bandwidths_per_dim.size();
+    header[LinksCount] = links.size();
+    header[RouteNodesCount] = route_nodes.size();
+
+    // write to a temporary file first, so concurrent loaders never map a partial file
+    const auto temporary_path = path + ".tmp." + std::to_string(getpid());
+    {
+        auto file = std::ofstream(temporary_path, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            return false;
+        }
+
+        file.write(file_magic, sizeof(file_magic));
+        file.write(reinterpret_cast<const char*>(header.data()), sizeof(header));
+        write_vector(file, bandwidths_per_dim);
+        write_vector(file, links);
+        write_vector(file, route_offsets);
+        write_vector(file, npus_counts);
+        write_vector(file, route_nodes);
+        if (!file) {
+            std::remove(temporary_path.c_str());
+            return false;
+        }
+    }
+
+    if (std::rename(temporary_path.c_str(), path.c_str()) != 0) {
+        std::remove(temporary_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+std::shared_ptr<CompiledTopology> CompiledTopology::load(const std::string& path, const uint64_t key) noexcept {
+    const auto fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return nullptr;
+    }
+
+    // map the whole file, read-only and shared, so every process loading it shares the pages
+    struct stat file_stat = {};
+    const auto file_size = (fstat(fd, &file_stat) == 0) ? static_cast<size_t>(file_stat.st_size) : 0;
+    if (file_size < file_header_size) {
+        close(fd);
+        return nullptr;
+    }
+    auto* const address = mmap(nullptr, file_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (address == MAP_FAILED) {
+        return nullptr;
+    }
+    auto mapping = std::shared_ptr<const uint8_t>(static_cast<const uint8_t*>(address),
+                                                  [file_size](const uint8_t* const address) {
+                                                      munmap(const_cast<uint8_t*>(address), file_size);
+                                                  });
+
+    // check the file is of this version and this network
+    auto header = std::array<uint64_t, HeaderFieldsCount>();
+    std::memcpy(header.data(), mapping.get() + sizeof(file_magic), sizeof(header));
+    if (std::memcmp(mapping.get(), file_magic, sizeof(file_magic)) != 0 || header[Key] != key ||
+        header[NpusCount] == 0 || header[NpusCount] > header[DevicesCount] || header[DevicesCount] > INT32_MAX ||
+        header[DimsCount] == 0 || header[DimsCount] > INT32_MAX || header[LinksCount] > (file_size / sizeof(FileLink)) ||
+        header[RouteNodesCount] > file_size) {
+        return nullptr;
+    }
+    const auto layout = FileLayout(header);
+    if (layout.file_size != file_size) {
+        return nullptr;
+    }
+
+    const auto* const bandwidths = reinterpret_cast<const Bandwidth*>(mapping.get() + layout.bandwidths_offset);
+    const auto* const links = reinterpret_cast<const FileLink*>(mapping.get() + layout.links_offset);
+    const auto* const route_offsets = reinterpret_cast<const uint64_t*>(mapping.get() + layout.route_offsets_offset);
+    const auto* const npus_counts = reinterpret_cast<const int32_t*>(mapping.get() + layout.npus_counts_offset);
+    const auto pairs_count = header[NpusCount] * header[NpusCount];
+    if (route_offsets[pairs_count] != header[RouteNodesCount]) {
+        return nullptr;
+    }
+    for (auto i = static_cast<uint64_t>(0); i < header[LinksCount]; i++) {
+        const auto& link = links[i];
+        if (link.src < 0 || link.src >= static_cast<int64_t>(header[DevicesCount]) || link.dest < 0 ||
+            link.dest >= static_cast<int64_t>(header[DevicesCount]) || !(link.bandwidth > 0) || !(link.latency >= 0)) {
+            return nullptr;
+        }
+    }
+
+    // instantiate the devices and links
+    auto topology = std::shared_ptr<CompiledTopology>(new CompiledTopology());
+    topology->devices_count = static_cast<int>(header[DevicesCount]);
+    topology->npus_count = static_cast<int>(header[NpusCount]);
+    topology->dims_count = static_cast<int>(header[DimsCount]);
+    topology->npus_count_per_dim.assign(npus_counts, npus_counts + header[DimsCount]);
+    topology->bandwidth_per_dim.assign(bandwidths, bandwidths + header[DimsCount]);
+    topology->instantiate_devices();
+    for (auto i = static_cast<uint64_t>(0); i < header[LinksCount]; i++) {
+        const auto& link = links[i];
+        if (topology->devices[link.src]->connected(link.dest)) {
+            return nullptr;
+        }
+        topology->connect(link.src, link.dest, link.bandwidth, link.latency, false);
+    }
+
+    // routes stay in the mapping
+    topology->route_offsets = route_offsets;
+    topology->route_nodes = reinterpret_cast<const int32_t*>(mapping.get() + layout.route_nodes_offset);
+    topology->mapping = std::move(mapping);
+    return topology;
+}
+
+Route CompiledTopology::route(const DeviceId src, const DeviceId dest) const noexcept {
+    assert(0 <= src && src < npus_count);
+    assert(0 <= dest && dest < npus_count);
+
+    const auto pair = (static_cast<size_t>(src) * static_cast<size_t>(npus_count)) + static_cast<size_t>(dest);
+
+    auto route = Route();
+    for (auto i = route_offsets[pair]; i < route_offsets[pair + 1]; i++) {
+        assert(0 <= route_nodes[i] && route_nodes[i] < devices_count);
+        route.push_back(devices[route_nodes[i]]);
+    }
+
+    assert(route.front()->get_id() == src);
+    assert(route.back()->get_id() == dest);
+    return route;
+}
@@ -4,21 +4,34 @@ LICENSE file in the root directory of this source tree.
 *******************************************************************************/
 
 #include "congestion_aware/Helper.h"
+#include "common/Hash.h"
+#include "congestion_aware/Dragonfly.h"
 #include "congestion_aware/FatTree.h"
 #include "congestion_aware/FullyConnected.h"
 #include "congestion_aware/Ring.h"
 #include "congestion_aware/Switch.h"
+#include "congestion_aware/Torus.h"
 #include "congestion_aware/ExpanderGraph.h"
 #include "congestion_aware/SwitchOrExpander.h"
 #include "congestion_aware/MultiDimTopology.h"
+#include <cassert>
 #include <cstdlib>
+#include <fstream>
 #include <iostream>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
 
 using namespace NetworkAnalytical;
 using namespace NetworkAnalyticalCongestionAware;
 
-std::shared_ptr<Topology> NetworkAnalyticalCongestionAware::construct_topology(
-    const NetworkParser& network_parser) noexcept {
+namespace {
+
+/**
+ * Construct the topology described by the network parser.
+ */
+std::shared_ptr<Topology> build_topology(const NetworkParser& network_parser) noexcept {
     // get network_parser info
     const auto dims_count = network_parser.get_dims_count();
     const auto topologies_per_dim = network_parser.get_topologies_per_dim();
@@ -28,6 +41,23 @@ std::shared_ptr<Topology> NetworkAnalyticalCongestionAware::construct_topology(
     const auto inputfiles_per_dim = network_parser.get_inputfiles_per_dim();
     const auto routing_algorithm_per_dim = network_parser.get_routing_algorithms_per_dim();
     const auto fattree_radix_per_dim = network_parser.get_fattree_radix_per_dim();
+    const auto torus_shapes_per_dim = network_parser.get_torus_shapes_per_dim();
+    const auto dragonfly_routers_per_group_per_dim = network_parser.get_dragonfly_routers_per_group_per_dim();
+    const auto dragonfly_hosts_per_router_per_dim = network_parser.get_dragonfly_hosts_per_router_per_dim();
+    const auto dragonfly_global_links_per_router_per_dim =
+        network_parser.get_dragonfly_global_links_per_router_per_dim();
+    const auto dragonfly_arrangements_per_dim = network_parser.get_dragonfly_arrangements_per_dim();
+
+    // create a Dragonfly dim, filling its groups with the NPUs
+    const auto make_dragonfly = [&](const int dim, const int npus_count, const Bandwidth bandwidth,
+                                    const Latency latency) {
+        const auto routers_per_group = dragonfly_routers_per_group_per_dim[dim];
+        const auto hosts_per_router = dragonfly_hosts_per_router_per_dim[dim];
+        return std::make_unique<Dragonfly>(npus_count / (routers_per_group * hosts_per_router), routers_per_group,
+                                           hosts_per_router, dragonfly_global_links_per_router_per_dim[dim],
+                                           bandwidth, latency, dragonfly_arrangements_per_dim[dim],
+                                           dim < routing_algorithm_per_dim.size() ? routing_algorithm_per_dim[dim] : "");
+    };
     const auto use_resiliency = network_parser.get_use_resiliency();
     
     // if dims_count is 1, just create basic topology
@@ -55,7 +85,11 @@ std::shared_ptr<Topology> NetworkAnalyticalCongestionAware::construct_topology(
         case TopologyBuildingBlock::FatTree:
             return std::make_shared<FatTree>(npus_count, fattree_radix_per_dim[0], bandwidth, latency,
                                             routing_algorithm_per_dim.empty() ? "" : routing_algorithm_per_dim[0]);
-    
+        case TopologyBuildingBlock::Torus:
+            return std::make_shared<Torus>(torus_shapes_per_dim[0], bandwidth, latency);
+        case TopologyBuildingBlock::Dragonfly:
+            return make_dragonfly(0, npus_count, bandwidth, latency);
+
         default:
             // shouldn't reach here
             std::cerr << "[Error] (network/analytical/congestion_aware)" << "Not supported topology" << std::endl;
@@ -66,7 +100,8 @@ std::shared_ptr<Topology> NetworkAnalyticalCongestionAware::construct_topology(
     // otherwise, create multi-dim basic-topology
     const auto multi_dim_topology = std::make_shared<MultiDimTopology>();
 
-    // create and append dims
+    // create dims, and append them at once
+    auto dim_topologies = std::vector<std::unique_ptr<BasicTopology>>();
     for (auto dim = 0; dim < dims_count; dim++) {
         // retrieve info
         const auto topology_type = topologies_per_dim[dim];
@@ -86,11 +121,17 @@ std::shared_ptr<Topology> NetworkAnalyticalCongestionAware::construct_topology(
         case TopologyBuildingBlock::FullyConnected:
             dim_topology = std::make_unique<FullyConnected>(npus_count, bandwidth, latency);
             break;
-        case TopologyBuildingBlock::ExpanderGraph:
-            dim_topology = std::make_unique<ExpanderGraph>(npus_count, bandwidth, latency,
+        case TopologyBuildingBlock::ExpanderGraph: {
+            auto expander_graph = std::make_unique<ExpanderGraph>(npus_count, bandwidth, latency,
                                                         dim < inputfiles_per_dim.size() ? inputfiles_per_dim[dim] : "",
                                                         dim < routing_algorithm_per_dim.size() ? routing_algorithm_per_dim[dim] : "", use_resiliency);
+            // the local routes of the dim are then recorded from the tables
+            if (network_parser.get_precompute_routes() && expander_graph->has_static_routes()) {
+                expander_graph->precompute_shortest_paths();
+            }
+            dim_topology = std::move(expander_graph);
             break;
+        }
         case TopologyBuildingBlock::SwitchOrExpander:
             dim_topology =  std::make_unique<SwitchOrExpander>(npus_count, bandwidth, latency,
                                                         dim < inputfiles_per_dim.size() ? inputfiles_per_dim[dim] : "",
@@ -102,6 +143,12 @@ std::shared_ptr<Topology> NetworkAnalyticalCongestionAware::construct_topology(
                                                     bandwidth, latency,
                                                     dim < routing_algorithm_per_dim.size() ? routing_algorithm_per_dim[dim] : "");
             break;
+        case TopologyBuildingBlock::Torus:
+            dim_topology = std::make_unique<Torus>(torus_shapes_per_dim[dim], bandwidth, latency);
+            break;
+        case TopologyBuildingBlock::Dragonfly:
+            dim_topology = make_dragonfly(dim, npus_count, bandwidth, latency);
+            break;
         default:
             // shouldn't reach here
             std::cerr << "[Error] (network/analytical/congestion_aware)" << "Not supported basic-topology"
@@ -109,10 +156,74 @@ std::shared_ptr<Topology> NetworkAnalyticalCongestionAware::construct_topology(
             std::exit(-1);
         }
 
-        // append network dimension
-        multi_dim_topology->append_dimension(std::move(dim_topology));
+        dim_topologies.push_back(std::move(dim_topology));
     }
+    multi_dim_topology->append_dimensions(std::move(dim_topologies));
+    multi_dim_topology->set_dim_order(MultiDimTopology::parse_dim_order(network_parser.get_dim_order()));
 
     // return created multi-dimensional topology
     return multi_dim_topology;
 }
+
+/**
+ * Key the snapshot of the topology described by the network parser:
+ * the hash of the network config and of the input files it names.
+ */
+uint64_t compute_snapshot_key(const NetworkParser& network_parser) noexcept {
+    auto key = network_parser.get_config_hash();
+    for (const auto& inputfile : network_parser.get_inputfiles_per_dim()) {
+        if (inputfile.empty()) {
+            continue;
+        }
+        auto file = std::ifstream(inputfile, std::ios::binary);
+        const auto contents = std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        key = hash_bytes(contents.data(), contents.size(), key);
+    }
+    return key;
+}
+
+}  // namespace
+
+std::shared_ptr<Topology> NetworkAnalyticalCongestionAware::construct_topology(
+    const NetworkParser& network_parser) noexcept {
+    // load the snapshot if it's of this network, otherwise construct the topology and save it
+    const auto snapshot_path = network_parser.get_snapshot_path();
+    auto topology = std::shared_ptr<Topology>();
+    if (!snapshot_path.empty()) {
+        const auto key = compute_snapshot_key(network_parser);
+        topology = Topology::load_snapshot(snapshot_path, key);
+        if (topology == nullptr) {
+            topology = build_topology(network_parser);
+            // only static routes can be compiled
+            if (topology->has_static_routes() && !topology->save_snapshot(snapshot_path, key)) {
+                std::cerr << "[Warning] (network/analytical/congestion_aware) "
+                          << "couldn't save topology snapshot to " << snapshot_path << std::endl;
+            }
+        }
+    } else {
+        topology = build_topology(network_parser);
+    }
+
+    // seed the random routes
+    topology->set_routing_seed(network_parser.get_seed());
+
+    // cap the route cache if requested
+    topology->set_route_cache_capacity(network_parser.get_route_cache_capacity_mb() * 1024 * 1024);
+
+    // route every pair up front if requested
+    if (network_parser.get_precompute_routes()) {
+        topology->precompute_routes();
+    }
+    return topology;
+}
+
+std::shared_ptr<Topology> NetworkAnalyticalCongestionAware::construct_topology(
+    const NetworkParser& network_parser,
+    std::shared_ptr<SimulationContext> context) noexcept {
+    assert(context != nullptr);
+
+    // construct the topology, then move its links to the given context
+    auto topology = construct_topology(network_parser);
+    topology->set_simulation_context(std::move(context));
+    return topology;
+}
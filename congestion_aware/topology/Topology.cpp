@@ -4,22 +4,209 @@ LICENSE file in the root directory of this source tree.
 *******************************************************************************/
 
 #include "congestion_aware/Topology.h"
+#include "congestion_aware/ChunkPool.h"
+#include "congestion_aware/ChunkTracer.h"
+#include "congestion_aware/CompiledTopology.h"
+#include "congestion_aware/CompletionBatcher.h"
 #include "congestion_aware/Link.h"
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <cstdlib>
+#include <iostream>
+#include <iterator>
+#include <list>
+#include <thread>
+#include <vector>
 
 using namespace NetworkAnalyticalCongestionAware;
 
+namespace {
+
+/// a message being segmented into chunks
+struct Message {
+    /// topology the message is sent on
+    Topology* topology;
+
+    /// route shared by every chunk of the message (cached by the topology, or owned_route_hops),
+    /// nullptr to route each chunk afresh
+    const RouteHops* route_hops;
+
+    /// route of the message if the route cache is full
+    RouteHops owned_route_hops;
+
+    /// src NPU id
+    DeviceId src;
+
+    /// dest NPU id
+    DeviceId dest;
+
+    /// bytes not handed to a chunk yet
+    ChunkSize unsent_bytes;
+
+    /// size of each chunk
+    ChunkSize chunk_size;
+
+    /// chunks in the network
+    int in_flight_chunks;
+
+    /// callback invoked when the last chunk arrives
+    EventCallback callback;
+
+    /// whether the chunks compute their hops from route_descriptor instead
+    bool described;
+
+    /// described route of the message, if described
+    RouteDescriptor route_descriptor;
+
+    /// traffic class of the chunks of the message
+    int traffic_class;
+};
+
+void inject_message_chunk(Message* message) noexcept;
+
+/**
+ * Flatten a route into hops, resolving the port of each hop.
+ * Cached routes are given the allocator of the route cache, so they count in its memory.
+ */
+RouteHops flatten_route(const Route& route, const TrackingAllocator<RouteHop>& allocator = {}) noexcept {
+    auto route_hops = RouteHops(allocator);
+    route_hops.reserve(route.size());
+    for (auto hop = route.begin(); hop != route.end(); hop++) {
+        auto* const device = hop->get();
+        const auto next = std::next(hop);
+        const auto port = (next == route.end()) ? -1 : device->get_port((*next)->get_id());
+        route_hops.push_back({device, port});
+    }
+    return route_hops;
+}
+
+/**
+ * Get the approximate memory a cached route takes, including the hash map node.
+ */
+uint64_t route_hops_cache_entry_bytes(const RouteHops& route_hops) noexcept {
+    constexpr auto node_bytes = sizeof(std::pair<const uint64_t, RouteHops>) + (2 * sizeof(void*));
+    return node_bytes + (route_hops.capacity() * sizeof(RouteHop));
+}
+
+/**
+ * Handle the arrival of a chunk of a message at dest.
+ */
+void message_chunk_arrived(Message* const message) noexcept {
+    assert(message != nullptr);
+    assert(message->in_flight_chunks > 0);
+
+    message->in_flight_chunks--;
+
+    // keep the window full
+    if (message->unsent_bytes > 0) {
+        inject_message_chunk(message);
+        return;
+    }
+
+    // the whole message has arrived
+    if (message->in_flight_chunks == 0) {
+        auto callback = std::move(message->callback);
+        delete message;
+        callback();
+    }
+}
+
+/**
+ * Create the next chunk of a message and send it.
+ */
+void inject_message_chunk(Message* const message) noexcept {
+    assert(message != nullptr);
+    assert(message->unsent_bytes > 0);
+
+    const auto chunk_size = std::min(message->chunk_size, message->unsent_bytes);
+    message->unsent_bytes -= chunk_size;
+    message->in_flight_chunks++;
+
+    auto callback = EventCallback([message] { message_chunk_arrived(message); });
+    auto chunk = message->described ? std::make_unique<Chunk>(chunk_size, message->route_descriptor, std::move(callback))
+                 : (message->route_hops != nullptr)
+                     ? std::make_unique<Chunk>(chunk_size, *message->route_hops, std::move(callback))
+                     : std::make_unique<Chunk>(chunk_size, message->topology->route(message->src, message->dest),
+                                               std::move(callback));
+    chunk->set_traffic_class(message->traffic_class);
+    message->topology->send(std::move(chunk));
+}
+
+}  // namespace
+
 void Topology::set_event_queue(std::shared_ptr<EventQueue> event_queue) noexcept {
     assert(event_queue != nullptr);
 
-    // pass the given event_queue to Link
-    Link::set_event_queue(std::move(event_queue));
+    // configure the default context
+    SimulationContext::get_default()->set_event_queue(std::move(event_queue));
+}
+
+void Topology::set_link_coalescing(const bool enabled) noexcept {
+    // configure the default context
+    SimulationContext::get_default()->set_link_coalescing(enabled);
 }
 
-Topology::Topology() noexcept : npus_count(-1), devices_count(-1), dims_count(-1) {
+Topology::Topology() noexcept
+    : npus_count(-1),
+      devices_count(-1),
+      dims_count(-1),
+      routing_seed(0),
+      devices_memory(std::make_shared<MemoryCounter>()),
+      links_memory(std::make_shared<MemoryCounter>()),
+      pending_chunks_memory(std::make_shared<MemoryCounter>()),
+      link_ids(std::make_shared<LinkStates::LinkIds>()),
+      route_cache_memory(std::make_shared<MemoryCounter>()),
+      context(SimulationContext::get_default()),
+      route_hops_cache(0,
+                       std::hash<uint64_t>(),
+                       std::equal_to<uint64_t>(),
+                       TrackingAllocator<std::pair<const uint64_t, RouteHops>>(route_cache_memory)),
+      static_routes(true),
+      retired_route_hops(TrackingAllocator<RouteHops>(route_cache_memory)),
+      route_hops_cache_capacity(0),
+      route_hops_cache_bytes(0),
+      traffic_class(0),
+      switch_buffer_size(0) {
     npus_count_per_dim = {};
 }
 
+void Topology::set_simulation_context(std::shared_ptr<SimulationContext> context) noexcept {
+    assert(context != nullptr);
+
+    // links find their state in the context of each chunk, so there's nothing to rebind
+    this->context = std::move(context);
+}
+
+void Topology::reset() noexcept {
+    for (const auto& device : devices) {
+        device->reset(*context);
+    }
+
+    // the dropped chunks won't complete, nor follow the retired routes
+    context->clear_per_hop_chunks();
+    retired_route_hops.clear();
+    retired_route_hops.shrink_to_fit();
+
+    // gathered completions would be flushed by the dropped events
+    auto* const completion_batcher = context->get_completion_batcher();
+    if (completion_batcher != nullptr) {
+        completion_batcher->reset();
+    }
+}
+
+std::shared_ptr<SimulationContext> Topology::get_simulation_context() const noexcept {
+    return context;
+}
+
+bool Topology::save_snapshot(const std::string& path, const uint64_t key) const noexcept {
+    return CompiledTopology::save(*this, path, key);
+}
+
+std::shared_ptr<Topology> Topology::load_snapshot(const std::string& path, const uint64_t key) noexcept {
+    return CompiledTopology::load(path, key);
+}
+
 int Topology::get_devices_count() const noexcept {
     assert(devices_count > 0);
     assert(npus_count > 0);
@@ -28,6 +215,89 @@ int Topology::get_devices_count() const noexcept {
     return devices_count;
 }
 
+int Topology::release_idle_links() noexcept {
+    const auto current_time = context->get_event_queue()->get_current_time();
+
+    auto released_links_count = 0;
+    for (const auto& device : devices) {
+        released_links_count += device->release_idle_links(*context, current_time);
+    }
+    return released_links_count;
+}
+
+uint64_t Topology::get_materialized_links_count() const noexcept {
+    auto links_count = static_cast<uint64_t>(0);
+    for (const auto& device : devices) {
+        links_count += device->get_materialized_links_count();
+    }
+    return links_count;
+}
+
+MemoryReport Topology::memory_report() const noexcept {
+    auto report = MemoryReport();
+    report.devices = MemoryUsage::of(*devices_memory);
+    report.links = MemoryUsage::of(*links_memory);
+    report.pending_chunks = MemoryUsage::of(*pending_chunks_memory);
+    report.route_cache = MemoryUsage::of(*route_cache_memory);
+    report.event_queue = MemoryUsage::of(context->get_event_queue()->get_memory_counter());
+    report.chunk_pool = MemoryUsage::of(ChunkPool::get_memory_counter());
+    return report;
+}
+
+bool Topology::dump_stats(std::ostream& out) const noexcept {
+    const auto report = memory_report();
+    const auto memory_parts = {std::make_pair("devices", report.devices),
+                               std::make_pair("links", report.links),
+                               std::make_pair("pending_chunks", report.pending_chunks),
+                               std::make_pair("route_cache", report.route_cache),
+                               std::make_pair("distance_cache", report.distance_cache),
+                               std::make_pair("shortest_route_cache", report.shortest_route_cache),
+                               std::make_pair("topk_route_cache", report.topk_route_cache),
+                               std::make_pair("dims", report.dims),
+                               std::make_pair("event_queue", report.event_queue),
+                               std::make_pair("chunk_pool", report.chunk_pool),
+                               std::make_pair("total", report.get_total())};
+    for (const auto& [part, usage] : memory_parts) {
+        out << "memory," << part << "," << usage.bytes << "," << usage.peak_bytes << "\n";
+    }
+
+#ifdef ASTRA_NET_STATS
+    const auto* const event_queue = context->get_event_queue();
+    const auto& queue_stats = event_queue->get_stats();
+    out << "event_queue," << queue_stats.events_count << "," << queue_stats.event_times_count << ","
+        << queue_stats.max_event_list_length << "\n";
+    for (const auto& [type_id, count] : queue_stats.callback_counts) {
+        out << "callback," << type_id << "," << count << "\n";
+    }
+
+    // utilization is relative to the current simulation time
+    const auto current_time = event_queue->get_current_time();
+    for (const auto& device : devices) {
+        const auto& const_device = *device;
+        for (auto port = 0; port < const_device.get_ports_count(); port++) {
+            // links that never transmitted (e.g., lazy links not created yet) are skipped
+            const auto& link_stats = const_device.get_link(port).get_stats(*context);
+            if (link_stats.chunks_count == 0) {
+                continue;
+            }
+            const auto utilization = (current_time > 0) ? (static_cast<double>(link_stats.busy_time) /
+                                                           static_cast<double>(current_time))
+                                                        : 0.0;
+            out << "link," << device->get_id() << "," << device->get_port_dest(port) << "," << link_stats.bytes << ","
+                << link_stats.chunks_count << "," << link_stats.busy_time << "," << utilization << ","
+                << link_stats.max_queue_depth << ",";
+            for (auto bucket = 0; bucket < LinkStats::histogram_buckets_count; bucket++) {
+                out << ((bucket > 0) ? " " : "") << link_stats.queueing_delay_histogram[bucket];
+            }
+            out << "\n";
+        }
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
 int Topology::get_npus_count() const noexcept {
     assert(devices_count > 0);
     assert(npus_count > 0);
@@ -63,10 +333,492 @@ void Topology::send(std::unique_ptr<Chunk> chunk) noexcept {
     // assert src is valid
     assert(0 <= src && src < devices_count);
 
+    // sample the chunk for tracing
+    auto& chunk_context = bind_simulation_context(*chunk);
+    auto* const chunk_tracer = chunk_context.get_chunk_tracer();
+    if (chunk_tracer != nullptr) {
+        chunk->set_trace_id(chunk_tracer->sample());
+        if (chunk->get_trace_id() != 0) {
+            const auto dest = chunk->get_hop(chunk->get_hops_count() - 1).device->get_id();
+            chunk_tracer->record(ChunkTracer::EventType::Inject, chunk->get_trace_id(),
+                                 chunk_context.get_event_queue()->get_current_time(), src, dest, chunk->get_size());
+        }
+    }
+
+    // uncontended chunks skip the per-hop events
+    if (chunk_context.get_hybrid_fidelity() && send_uncontended(chunk)) {
+        return;
+    }
+
     // initiate transmission from src
     devices[src]->send(std::move(chunk));
 }
 
+void Topology::send(const DeviceId src,
+                    const DeviceId dest,
+                    const ChunkSize chunk_size,
+                    const Callback callback,
+                    const CallbackArg callback_arg) noexcept {
+    assert(callback != nullptr);
+
+    send(src, dest, chunk_size, EventCallback(callback, callback_arg));
+}
+
+void Topology::send(const DeviceId src, const DeviceId dest, const ChunkSize chunk_size, EventCallback callback) noexcept {
+    send(*context, src, dest, chunk_size, std::move(callback));
+}
+
+void Topology::send(SimulationContext& context,
+                    const DeviceId src,
+                    const DeviceId dest,
+                    const ChunkSize chunk_size,
+                    EventCallback callback) noexcept {
+    assert(chunk_size > 0);
+    assert(callback);
+
+    auto chunk = make_chunk(src, dest, chunk_size, std::move(callback));
+    chunk->set_traffic_class(traffic_class);
+    chunk->set_simulation_context(&context);
+    send(std::move(chunk));
+}
+
+void Topology::set_traffic_class(const int traffic_class) noexcept {
+    if (traffic_class < 0 || traffic_class >= LinkStates::traffic_classes_count) {
+        std::cerr << "[Error] (network/analytical/congestion_aware) "
+                  << "traffic class " << traffic_class << " is out of [0, " << LinkStates::traffic_classes_count
+                  << ")" << std::endl;
+        std::exit(-1);
+    }
+
+    this->traffic_class = traffic_class;
+}
+
+int Topology::get_traffic_class() const noexcept {
+    return traffic_class;
+}
+
+void Topology::set_switch_buffer_size(const ChunkSize buffer_size) noexcept {
+    switch_buffer_size = buffer_size;
+
+    // switches come after the NPUs
+    for (auto id = npus_count; id < devices_count; id++) {
+        devices[id]->set_buffer_size(buffer_size);
+    }
+}
+
+ChunkSize Topology::get_switch_buffer_size() const noexcept {
+    return switch_buffer_size;
+}
+
+std::unique_ptr<Chunk> Topology::make_chunk(const DeviceId src,
+                                            const DeviceId dest,
+                                            const ChunkSize chunk_size,
+                                            EventCallback callback) noexcept {
+    if (!static_routes) {
+        // the route may change from chunk to chunk
+        return std::make_unique<Chunk>(chunk_size, route(src, dest), std::move(callback));
+    }
+
+    // short routes are cached, and copied into the chunk
+    auto route_descriptor = RouteDescriptor();
+    const auto described = describe_route(src, dest, route_descriptor);
+    if (!described || route_descriptor.hops_count <= static_cast<int>(Chunk::inline_hops_count)) {
+        // build the chunk straight from the cached route
+        const auto* const route_hops = find_route_hops(src, dest);
+        if (route_hops != nullptr) {
+            return std::make_unique<Chunk>(chunk_size, *route_hops, std::move(callback));
+        }
+    }
+
+    // long described routes, and described routes past the cache capacity, are computed hop by hop
+    if (described) {
+        return std::make_unique<Chunk>(chunk_size, route_descriptor, std::move(callback));
+    }
+
+    // the cache is full
+    return std::make_unique<Chunk>(chunk_size, route(src, dest), std::move(callback));
+}
+
+SimulationContext& Topology::bind_simulation_context(Chunk& chunk) const noexcept {
+    if (chunk.get_simulation_context() == nullptr) {
+        chunk.set_simulation_context(context.get());
+    }
+    return *chunk.get_simulation_context();
+}
+
+bool Topology::describe_route(const DeviceId src, const DeviceId dest, RouteDescriptor& route_descriptor) const noexcept {
+    (void)src;
+    (void)dest;
+    (void)route_descriptor;
+
+    // routes are computed by route() only
+    return false;
+}
+
+bool Topology::has_static_routes() const noexcept {
+    return static_routes;
+}
+
+DeviceId Topology::map_by_symmetry([[maybe_unused]] const DeviceId device,
+                                   [[maybe_unused]] const DeviceId npu) const noexcept {
+    // no symmetries unless the topology knows them
+    return -1;
+}
+
+void Topology::set_routing_seed(const uint64_t seed) noexcept {
+    routing_seed = seed;
+}
+
+uint64_t Topology::get_routing_seed() const noexcept {
+    return routing_seed;
+}
+
+const RouteHops& Topology::get_route_hops(const DeviceId src, const DeviceId dest) const noexcept {
+    assert(0 <= src && src < npus_count);
+    assert(0 <= dest && dest < npus_count);
+    assert(src != dest);
+
+    // look up the cache
+    const auto key = (static_cast<uint64_t>(src) << 32) | static_cast<uint32_t>(dest);
+    const auto it = route_hops_cache.find(key);
+    if (it != route_hops_cache.end()) {
+        return it->second;
+    }
+
+    // flatten the route, resolving the port of each hop
+    auto route_hops = flatten_route(route(src, dest), route_hops_cache.get_allocator());
+    if (!failed_links.empty() || !failed_devices.empty()) {
+        if (route_hops.empty()) {
+            std::cerr << "[Error] (network/analytical/congestion_aware) "
+                      << "no route from " << src << " to " << dest << " around the failures" << std::endl;
+            std::exit(-1);
+        }
+        failure_route_keys.insert(key);
+    }
+    route_hops_cache_bytes += route_hops_cache_entry_bytes(route_hops);
+    return route_hops_cache.emplace(key, std::move(route_hops)).first->second;
+}
+
+void Topology::precompute_routes(int threads_count) noexcept {
+    assert(threads_count >= 0);
+
+    if (!static_routes) {
+        return;
+    }
+
+    // route one source at a time, each into its own row
+    auto rows = std::vector<std::vector<RouteHops>>(npus_count);
+    auto next_source = std::atomic<int>(0);
+    const auto route_worker = [&]() noexcept {
+        for (auto src = next_source++; src < npus_count; src = next_source++) {
+            auto& row = rows[src];
+            row.resize(npus_count);
+            for (auto dest = 0; dest < npus_count; dest++) {
+                if (src != dest) {
+                    row[dest] = flatten_route(route(src, dest), route_hops_cache.get_allocator());
+                }
+            }
+        }
+    };
+
+    if (threads_count == 0) {
+        threads_count = static_cast<int>(std::max(1U, std::thread::hardware_concurrency()));
+    }
+    threads_count = std::min(threads_count, std::max(npus_count, 1));
+
+    std::vector<std::thread> threads;
+    for (auto i = 1; i < threads_count; i++) {
+        threads.emplace_back(route_worker);
+    }
+    route_worker();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    // merge the rows into the cache, keeping the routes cached so far
+    route_hops_cache.reserve(route_hops_cache.size() + (static_cast<size_t>(npus_count) * (npus_count - 1)));
+    for (auto src = 0; src < npus_count; src++) {
+        for (auto dest = 0; dest < npus_count; dest++) {
+            if (src == dest) {
+                continue;
+            }
+            const auto key = (static_cast<uint64_t>(src) << 32) | static_cast<uint32_t>(dest);
+            auto& route_hops = rows[src][dest];
+            const auto route_hops_bytes = route_hops_cache_entry_bytes(route_hops);
+            if (route_hops_cache.emplace(key, std::move(route_hops)).second) {
+                route_hops_cache_bytes += route_hops_bytes;
+            }
+        }
+        rows[src] = std::vector<RouteHops>();
+    }
+}
+
+const RouteHops* Topology::find_route_hops(const DeviceId src, const DeviceId dest) const noexcept {
+    assert(0 <= src && src < npus_count);
+    assert(0 <= dest && dest < npus_count);
+    assert(src != dest);
+
+    // cached routes are never evicted, so past the capacity new pairs aren't cached
+    if (route_hops_cache_capacity > 0 && route_hops_cache_bytes >= route_hops_cache_capacity) {
+        const auto key = (static_cast<uint64_t>(src) << 32) | static_cast<uint32_t>(dest);
+        const auto it = route_hops_cache.find(key);
+        return (it != route_hops_cache.end()) ? &it->second : nullptr;
+    }
+
+    return &get_route_hops(src, dest);
+}
+
+void Topology::set_route_cache_capacity(const uint64_t capacity_bytes) noexcept {
+    route_hops_cache_capacity = capacity_bytes;
+}
+
+uint64_t Topology::get_route_cache_bytes() const noexcept {
+    return route_hops_cache_bytes;
+}
+
+void Topology::fail_link(const DeviceId src, const DeviceId dest) noexcept {
+    assert(0 <= src && src < devices_count);
+    assert(0 <= dest && dest < devices_count);
+    assert(devices[src]->connected(dest) || devices[dest]->connected(src));
+
+    const auto inserted = failed_links.insert((static_cast<uint64_t>(src) << 32) | static_cast<uint32_t>(dest)).second;
+    failed_links.insert((static_cast<uint64_t>(dest) << 32) | static_cast<uint32_t>(src));
+    if (inserted) {
+        apply_failure_change(src, dest, true);
+    }
+}
+
+void Topology::restore_link(const DeviceId src, const DeviceId dest) noexcept {
+    assert(0 <= src && src < devices_count);
+    assert(0 <= dest && dest < devices_count);
+
+    const auto erased = failed_links.erase((static_cast<uint64_t>(src) << 32) | static_cast<uint32_t>(dest)) > 0;
+    failed_links.erase((static_cast<uint64_t>(dest) << 32) | static_cast<uint32_t>(src));
+    if (erased) {
+        apply_failure_change(src, dest, false);
+    }
+}
+
+void Topology::fail_device(const DeviceId id) noexcept {
+    assert(0 <= id && id < devices_count);
+
+    if (failed_devices.insert(id).second) {
+        apply_failure_change(id, -1, true);
+    }
+}
+
+void Topology::restore_device(const DeviceId id) noexcept {
+    assert(0 <= id && id < devices_count);
+
+    if (failed_devices.erase(id) > 0) {
+        apply_failure_change(id, -1, false);
+    }
+}
+
+bool Topology::is_link_failed(const DeviceId src, const DeviceId dest) const noexcept {
+    if (failed_links.empty() && failed_devices.empty()) {
+        return false;
+    }
+    return failed_devices.count(dest) > 0 ||
+           failed_links.count((static_cast<uint64_t>(src) << 32) | static_cast<uint32_t>(dest)) > 0;
+}
+
+bool Topology::is_device_failed(const DeviceId id) const noexcept {
+    return failed_devices.count(id) > 0;
+}
+
+void Topology::reroute(std::unique_ptr<Chunk> chunk) noexcept {
+    assert(chunk != nullptr);
+
+    const auto current = chunk->current_device()->get_id();
+    const auto dest = chunk->get_hop(chunk->get_hops_count() - 1).device->get_id();
+    const auto route = route_around_failures(current, dest);
+    if (route.empty()) {
+        std::cerr << "[Error] (network/analytical/congestion_aware) "
+                  << "no route from " << current << " to " << dest << " around the failures" << std::endl;
+        std::exit(-1);
+    }
+
+    chunk->reroute(route);
+    devices[current]->send(std::move(chunk));
+}
+
+bool Topology::update_failures(const DeviceId src, const DeviceId dest, const bool failed) noexcept {
+    (void)src;
+    (void)dest;
+    (void)failed;
+
+    // routes don't avoid failures by default
+    return false;
+}
+
+Route Topology::route_around_failures(const DeviceId src, const DeviceId dest) const noexcept {
+    (void)src;
+    (void)dest;
+
+    // only reached by topologies overriding update_failures()
+    return Route();
+}
+
+void Topology::apply_failure_change(const DeviceId src, const DeviceId dest, const bool failed) noexcept {
+    // update the routing first, so rerouted chunks avoid the failure
+    if (!update_failures(src, dest, failed)) {
+        std::cerr << "[Error] (network/analytical/congestion_aware) "
+                  << "this topology can't route around failed links or devices" << std::endl;
+        std::exit(-1);
+    }
+
+    // the directed links whose state may have changed: src <-> dest, or every link into the device
+    auto links = std::vector<std::pair<DeviceId, DeviceId>>();
+    if (dest >= 0) {
+        links.emplace_back(src, dest);
+        links.emplace_back(dest, src);
+    } else {
+        const auto& device = devices[src];
+        for (auto port = 0; port < device->get_ports_count(); port++) {
+            links.emplace_back(device->get_port_dest(port), src);
+        }
+    }
+
+    // flag the links, taking the chunks waiting for the newly failed ones
+    auto stranded_chunks = Link::PendingChunks(TrackingAllocator<std::unique_ptr<Chunk>>(pending_chunks_memory));
+    for (const auto& [from, to] : links) {
+        const auto& device = devices[from];
+        if (!device->connected(to)) {
+            continue;
+        }
+        auto& link = device->get_link(device->get_port(to));
+        const auto link_failed = is_link_failed(from, to);
+        if (link_failed && !link.is_failed()) {
+            stranded_chunks.splice(stranded_chunks.end(), link.take_pending_chunks(*context));
+        }
+        link.set_failed(link_failed ? this : nullptr);
+    }
+
+    // whether a cached route crosses a failed element
+    const auto crosses_failure = [this](const RouteHops& route_hops) {
+        for (auto i = static_cast<size_t>(0); i + 1 < route_hops.size(); i++) {
+            if (is_link_failed(route_hops[i].device->get_id(), route_hops[i + 1].device->get_id())) {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    // once the queue drained, no chunk is in flight to follow the retired routes
+    const auto chunks_in_flight = !context->get_event_queue()->finished() || !stranded_chunks.empty();
+    if (!chunks_in_flight) {
+        retired_route_hops.clear();
+        retired_route_hops.shrink_to_fit();
+    }
+
+    // recompute the cached routes in place: crossing a failure, or possibly detoured if it got restored
+    const auto failures_left = !failed_links.empty() || !failed_devices.empty();
+    for (auto& [key, route_hops] : route_hops_cache) {
+        if (failed ? !crosses_failure(route_hops) : failure_route_keys.count(key) == 0) {
+            continue;
+        }
+        auto new_route_hops = flatten_route(route(static_cast<DeviceId>(key >> 32), static_cast<DeviceId>(key & 0xFFFFFFFF)),
+                                            route_hops_cache.get_allocator());
+        if (new_route_hops.empty()) {
+            // no route left (e.g., to a failed NPU): chunks sent there can't be delivered
+            continue;
+        }
+        if (failures_left) {
+            failure_route_keys.insert(key);
+        }
+        const auto same_route = std::equal(route_hops.begin(), route_hops.end(), new_route_hops.begin(),
+                                           new_route_hops.end(), [](const RouteHop& a, const RouteHop& b) {
+                                               return a.device == b.device && a.port == b.port;
+                                           });
+        if (same_route) {
+            continue;
+        }
+
+        // chunks in flight may still follow the old route
+        route_hops_cache_bytes -= route_hops_cache_entry_bytes(route_hops);
+        if (chunks_in_flight) {
+            retired_route_hops.push_back(std::move(route_hops));
+        }
+        route_hops = std::move(new_route_hops);
+        route_hops_cache_bytes += route_hops_cache_entry_bytes(route_hops);
+    }
+    if (!failures_left) {
+        failure_route_keys.clear();
+    }
+
+    // reroute the chunks that were waiting for a failed link
+    for (auto& chunk : stranded_chunks) {
+        reroute(std::move(chunk));
+    }
+}
+
+void Topology::send_batch(std::vector<std::unique_ptr<Chunk>> chunks) noexcept {
+    // group chunks by their source device, preserving the order within each device
+    std::stable_sort(chunks.begin(), chunks.end(),
+                     [](const std::unique_ptr<Chunk>& lhs, const std::unique_ptr<Chunk>& rhs) {
+                         return lhs->current_device()->get_id() < rhs->current_device()->get_id();
+                     });
+
+    // initiate transmissions, inserting their events once per distinct time
+    auto* const event_queue = context->get_event_queue();
+    event_queue->defer_events();
+    for (auto& chunk : chunks) {
+        assert(chunk != nullptr);
+        send(std::move(chunk));
+    }
+    event_queue->flush_deferred_events();
+}
+
+void Topology::send_message(const DeviceId src,
+                            const DeviceId dest,
+                            const ChunkSize message_size,
+                            const ChunkSize chunk_size,
+                            const Callback callback,
+                            const CallbackArg callback_arg,
+                            const int max_in_flight_chunks) noexcept {
+    assert(callback != nullptr);
+
+    send_message(src, dest, message_size, chunk_size, EventCallback(callback, callback_arg), max_in_flight_chunks);
+}
+
+void Topology::send_message(const DeviceId src,
+                            const DeviceId dest,
+                            const ChunkSize message_size,
+                            const ChunkSize chunk_size,
+                            EventCallback callback,
+                            const int max_in_flight_chunks) noexcept {
+    assert(0 <= src && src < npus_count);
+    assert(0 <= dest && dest < npus_count);
+    assert(message_size > 0);
+    assert(chunk_size > 0);
+    assert(max_in_flight_chunks > 0);
+    assert(callback);
+
+    // the message owns itself until its last chunk arrives
+    auto* const message = new Message{
+        this, nullptr, {}, src, dest, message_size, chunk_size, 0, std::move(callback), false, RouteDescriptor(),
+        traffic_class};
+    if (static_routes) {
+        // same policy as send(): short routes are cached, the others computed hop by hop if described
+        message->described = describe_route(src, dest, message->route_descriptor);
+        if (!message->described || message->route_descriptor.hops_count <= static_cast<int>(Chunk::inline_hops_count)) {
+            message->route_hops = find_route_hops(src, dest);
+            message->described = message->described && message->route_hops == nullptr;
+        }
+        if (message->route_hops == nullptr && !message->described) {
+            // the cache is full: route the message once for all its chunks
+            message->owned_route_hops = flatten_route(route(src, dest));
+            message->route_hops = &message->owned_route_hops;
+        }
+    }
+
+    // fill the injection window
+    for (auto i = 0; i < max_in_flight_chunks && message->unsent_bytes > 0; i++) {
+        inject_message_chunk(message);
+    }
+}
+
 void Topology::connect(const DeviceId src,
                        const DeviceId dest,
                        const Bandwidth bandwidth,
@@ -89,10 +841,154 @@ void Topology::connect(const DeviceId src,
     }
 }
 
+ChunkSize Topology::get_link_backlog(const DeviceId src, const DeviceId dest) const noexcept {
+    assert(0 <= src && src < devices_count);
+    assert(0 <= dest && dest < devices_count);
+
+    // a lazy link not created yet has no backlog, so don't create it
+    const auto& device = *devices[src];
+    return device.get_link(device.get_port(dest)).get_pending_bytes(*context);
+}
+
+bool Topology::send_uncontended(std::unique_ptr<Chunk>& chunk) noexcept {
+    assert(chunk != nullptr);
+    assert(chunk->current_device() == chunk->get_hop(0).device);
+    assert(chunk->get_simulation_context() != nullptr);
+
+    auto& chunk_context = *chunk->get_simulation_context();
+    auto* const event_queue = chunk_context.get_event_queue();
+    const auto current_time = event_queue->get_current_time();
+    const auto links_count = chunk->get_hops_count() - 1;
+
+    // every link of the route should be idle, and no chunk on the per-hop path in flight,
+    // as it could reach a link before its reservation and would go first in a full simulation
+    auto uncontended = chunk_context.get_per_hop_chunks_count() == 0;
+    for (auto i = static_cast<size_t>(0); uncontended && i < links_count; i++) {
+        const auto& hop = chunk->get_hop(i);
+        uncontended = hop.device->get_link(hop.port).can_reserve(chunk_context, current_time);
+    }
+    if (!uncontended) {
+        // counted until it completes
+        chunk->set_per_hop(true);
+        chunk_context.add_per_hop_chunk();
+        return false;
+    }
+
+    // the chunk departs each link as soon as it arrives, as a free link would send it
+    auto reserved_chunk = std::make_unique<ReservedChunk>();
+    auto* const reserved_chunk_ptr = reserved_chunk.get();
+    reserved_chunk->departure_time = current_time;
+    reserved_chunk->tail_arrival_time = chunk->get_tail_arrival_time();
+    const auto chunk_size = chunk->get_size();
+    auto arrival_time = current_time;
+    auto tail_arrival_time = chunk->get_tail_arrival_time();
+    for (auto i = static_cast<size_t>(0); i < links_count; i++) {
+        const auto& hop = chunk->get_hop(i);
+        const auto transmission = hop.device->get_link(hop.port).reserve(chunk_context, arrival_time, chunk_size,
+                                                                         tail_arrival_time, reserved_chunk_ptr);
+        arrival_time = transmission.head_arrival_time;
+        tail_arrival_time = transmission.tail_arrival_time;
+    }
+    reserved_chunk->chunk = std::move(chunk);
+
+    // the chunk is complete once its tail arrived, and the event owns it until then
+    reserved_chunk_ptr->completion =
+        event_queue->schedule_event(tail_arrival_time, [reserved_chunk = std::move(reserved_chunk)]() mutable {
+            // resumed the per-hop path meanwhile (when the event couldn't be cancelled, e.g., deferred)
+            if (reserved_chunk->chunk == nullptr) {
+                return;
+            }
+            release_reservations(*reserved_chunk, reserved_chunk->chunk->get_hops_count() - 1);
+            Chunk::complete(std::move(reserved_chunk->chunk));
+        });
+    return true;
+}
+
+Link::Transmission Topology::release_reservations(const ReservedChunk& reserved_chunk,
+                                                  const size_t served_links_count) noexcept {
+    const auto& chunk = *reserved_chunk.chunk;
+    const auto links_count = chunk.get_hops_count() - 1;
+    assert(0 < served_links_count && served_links_count <= links_count);
+
+    auto& context = *chunk.get_simulation_context();
+    auto* const chunk_tracer = (chunk.get_trace_id() != 0) ? context.get_chunk_tracer() : nullptr;
+    const auto chunk_size = chunk.get_size();
+    auto transmission = Link::Transmission{0, reserved_chunk.departure_time, reserved_chunk.tail_arrival_time};
+    for (auto i = static_cast<size_t>(0); i < links_count; i++) {
+        const auto& hop = chunk.get_hop(i);
+        auto& link = hop.device->get_link(hop.port);
+        const auto served = i < served_links_count;
+        link.release_reservation(context, &reserved_chunk, chunk_size, served);
+        if (!served) {
+            continue;
+        }
+
+        // the same timing as reserved
+        const auto departure_time = transmission.head_arrival_time;
+        transmission = link.plan_transmission(context, departure_time, chunk_size, transmission.tail_arrival_time);
+        if (chunk_tracer != nullptr) {
+            const auto device = hop.device->get_id();
+            const auto next_device = chunk.get_hop(i + 1).device->get_id();
+            chunk_tracer->record(ChunkTracer::EventType::Enqueue, chunk.get_trace_id(), departure_time, device,
+                                 next_device, chunk_size);
+            chunk_tracer->record_hop(chunk.get_trace_id(), device, next_device, chunk_size, departure_time,
+                                     transmission.free_time - departure_time, transmission.tail_arrival_time);
+        }
+    }
+
+    if (chunk_tracer != nullptr && served_links_count == links_count) {
+        chunk_tracer->record(ChunkTracer::EventType::Completion, chunk.get_trace_id(), transmission.tail_arrival_time,
+                             chunk.get_hop(0).device->get_id(), chunk.get_hop(links_count).device->get_id(),
+                             chunk_size);
+    }
+    return transmission;
+}
+
+void Topology::resume_per_hop(ReservedChunk& reserved_chunk) noexcept {
+    assert(reserved_chunk.chunk != nullptr);
+
+    auto& context = *reserved_chunk.chunk->get_simulation_context();
+    auto* const event_queue = context.get_event_queue();
+    const auto current_time = event_queue->get_current_time();
+
+    // the first link the chunk departs over after now, following the reserved timing
+    const auto& chunk = *reserved_chunk.chunk;
+    const auto chunk_size = chunk.get_size();
+    auto departure_time = reserved_chunk.departure_time;
+    auto tail_arrival_time = reserved_chunk.tail_arrival_time;
+    auto served_links_count = static_cast<size_t>(0);
+    while (departure_time <= current_time) {
+        const auto& hop = chunk.get_hop(served_links_count);
+        const auto transmission =
+            hop.device->get_link(hop.port).plan_transmission(context, departure_time, chunk_size, tail_arrival_time);
+        departure_time = transmission.head_arrival_time;
+        tail_arrival_time = transmission.tail_arrival_time;
+        served_links_count++;
+    }
+    assert(served_links_count < chunk.get_hops_count() - 1);
+
+    // the chunk is on its way to the source of that link, as if sent hop by hop
+    const auto transmission = release_reservations(reserved_chunk, served_links_count);
+    auto resumed_chunk = std::move(reserved_chunk.chunk);
+    event_queue->cancel_event(reserved_chunk.completion);
+    for (auto i = static_cast<size_t>(1); i < served_links_count; i++) {
+        resumed_chunk->mark_arrived_next_device();
+    }
+    resumed_chunk->set_tail_arrival_time(transmission.tail_arrival_time);
+
+    // counted until it completes
+    resumed_chunk->set_per_hop(true);
+    context.add_per_hop_chunk();
+    event_queue->schedule_event(transmission.head_arrival_time, [chunk = std::move(resumed_chunk)]() mutable {
+        Chunk::arrived_next_device(std::move(chunk));
+    });
+}
+
 void Topology::instantiate_devices() noexcept {
     // instantiate all devices
     for (auto i = 0; i < devices_count; i++) {
-        devices.push_back(std::make_shared<Device>(i));
+        devices.push_back(std::allocate_shared<Device>(TrackingAllocator<Device>(devices_memory), i, devices_memory,
+                                                       links_memory, pending_chunks_memory, link_ids));
     }
 }
 
@@ -102,4 +998,10 @@ std::vector<DeviceId> Topology::get_all_device_ids() const noexcept {
         device_ids.push_back(device_ptr->get_id());
     }
     return device_ids;
-}
\ No newline at end of file
+}
+
+std::shared_ptr<Device> Topology::get_device(const DeviceId id) const noexcept {
+    assert(0 <= id && id < devices_count);
+
+    return devices[id];
+}
@@ -0,0 +1,210 @@
+/******************************************************************************
+This source code is licensed under the MIT license found in the
+LICENSE file in the root directory of this source tree.
+*******************************************************************************/
+
+#include "congestion_aware/ChunkTracer.h"
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <utility>
+
+using namespace NetworkAnalytical;
+using namespace NetworkAnalyticalCongestionAware;
+
+namespace {
+
+/**
+ * Format a time in ns as the microseconds of the trace event format.
+ */
+std::string format_timestamp(const EventTime time) noexcept {
+    char timestamp[32];
+    std::snprintf(timestamp, sizeof(timestamp), "%llu.%03llu", static_cast<unsigned long long>(time / 1000),
+                  static_cast<unsigned long long>(time % 1000));
+    return timestamp;
+}
+
+}  // namespace
+
+ChunkTracer::ChunkTracer(const std::string& path,
+                         const uint64_t sampling_period,
+                         const size_t buffer_records_count) noexcept
+    : sampling_period(sampling_period),
+      injected_chunks_count(0),
+      records_count(0),
+      buffer_records_count(buffer_records_count),
+      first_record(true),
+      writing(false),
+      stopping(false) {
+    assert(sampling_period > 0);
+    assert(buffer_records_count > 0);
+
+    file.open(path, std::ios::trunc);
+    if (!file.is_open()) {
+        std::cerr << "[Error] (network/analytical/congestion_aware) " << "cannot open trace file " << path
+                  << std::endl;
+        std::exit(-1);
+    }
+    file << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+
+    // preallocate every buffer, so recording never allocates
+    buffer.reserve(buffer_records_count);
+    for (auto i = 0; i < spare_buffers_count; i++) {
+        spare_buffers.emplace_back();
+        spare_buffers.back().reserve(buffer_records_count);
+    }
+
+    writer = std::thread([this] { write_buffers(); });
+}
+
+ChunkTracer::~ChunkTracer() noexcept {
+    // write the remaining records
+    if (!buffer.empty()) {
+        submit_buffer();
+    }
+    {
+        const auto lock = std::lock_guard<std::mutex>(mutex);
+        stopping = true;
+    }
+    condition.notify_all();
+    writer.join();
+
+    file << "\n]}\n";
+    file.close();
+}
+
+uint64_t ChunkTracer::sample() noexcept {
+    const auto chunk_index = injected_chunks_count++;
+    return (chunk_index % sampling_period == 0) ? chunk_index + 1 : 0;
+}
+
+void ChunkTracer::record(const EventType type,
+                         const uint64_t chunk_id,
+                         const EventTime time,
+                         const DeviceId device,
+                         const DeviceId next_device,
+                         const ChunkSize size,
+                         const EventTime duration) noexcept {
+    assert(chunk_id > 0);
+
+    buffer.push_back({time, duration, chunk_id, size, device, next_device, type});
+    records_count++;
+
+    if (buffer.size() == buffer_records_count) {
+        submit_buffer();
+    }
+}
+
+void ChunkTracer::record_hop(const uint64_t chunk_id,
+                             const DeviceId device,
+                             const DeviceId next_device,
+                             const ChunkSize size,
+                             const EventTime departure_time,
+                             const EventTime serialization_time,
+                             const EventTime arrival_time) noexcept {
+    record(EventType::TransmitStart, chunk_id, departure_time, device, next_device, size, serialization_time);
+    record(EventType::Arrival, chunk_id, arrival_time, device, next_device, size);
+}
+
+void ChunkTracer::flush() noexcept {
+    if (!buffer.empty()) {
+        submit_buffer();
+    }
+
+    // wait for the writer to catch up
+    auto lock = std::unique_lock<std::mutex>(mutex);
+    condition.wait(lock, [this] { return full_buffers.empty() && !writing; });
+    file.flush();
+}
+
+uint64_t ChunkTracer::get_records_count() const noexcept {
+    return records_count;
+}
+
+void ChunkTracer::submit_buffer() noexcept {
+    assert(!buffer.empty());
+
+    auto lock = std::unique_lock<std::mutex>(mutex);
+    full_buffers.push_back(std::move(buffer));
+    condition.notify_all();
+
+    // continue with a spare buffer, waiting for the writer if it's behind
+    condition.wait(lock, [this] { return !spare_buffers.empty(); });
+    buffer = std::move(spare_buffers.back());
+    spare_buffers.pop_back();
+}
+
+void ChunkTracer::write_buffers() noexcept {
+    auto lock = std::unique_lock<std::mutex>(mutex);
+    while (true) {
+        condition.wait(lock, [this] { return stopping || !full_buffers.empty(); });
+        if (full_buffers.empty()) {
+            // stopping, with every buffer written
+            return;
+        }
+
+        auto full_buffer = std::move(full_buffers.front());
+        full_buffers.pop_front();
+        writing = true;
+
+        // format outside the lock, so the simulation keeps recording meanwhile
+        lock.unlock();
+        for (const auto& record : full_buffer) {
+            write_record(record);
+        }
+        full_buffer.clear();
+        lock.lock();
+
+        spare_buffers.push_back(std::move(full_buffer));
+        writing = false;
+        condition.notify_all();
+    }
+}
+
+void ChunkTracer::write_record(const Record& record) noexcept {
+    const auto timestamp = format_timestamp(record.time);
+
+    switch (record.type) {
+    case EventType::Inject:
+    case EventType::Completion:
+        // async slice of the chunk, on its src NPU
+        begin_event();
+        file << "{\"name\":\"chunk " << record.chunk_id << "\",\"cat\":\"chunk\",\"ph\":\""
+             << ((record.type == EventType::Inject) ? "b" : "e") << "\",\"id\":" << record.chunk_id
+             << ",\"ts\":" << timestamp << ",\"pid\":" << record.device << ",\"tid\":" << record.device
+             << ",\"args\":{\"dest\":" << record.next_device << ",\"size\":" << record.size << "}}";
+        return;
+    case EventType::Enqueue:
+    case EventType::TransmitStart:
+    case EventType::Arrival:
+        break;
+    }
+
+    // name the track of the link the first time it's used
+    const auto track = (static_cast<uint64_t>(record.device) << 32) | static_cast<uint32_t>(record.next_device);
+    if (named_tracks.insert(track).second) {
+        begin_event();
+        file << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << record.device
+             << ",\"args\":{\"name\":\"device " << record.device << "\"}}";
+        begin_event();
+        file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << record.device << ",\"tid\":" << record.next_device
+             << ",\"args\":{\"name\":\"link " << record.device << " -> " << record.next_device << "\"}}";
+    }
+
+    begin_event();
+    if (record.type == EventType::TransmitStart) {
+        file << "{\"name\":\"chunk " << record.chunk_id << "\",\"cat\":\"link\",\"ph\":\"X\",\"ts\":" << timestamp
+             << ",\"dur\":" << format_timestamp(record.duration);
+    } else {
+        file << "{\"name\":\"" << ((record.type == EventType::Enqueue) ? "enqueue" : "arrival")
+             << "\",\"cat\":\"link\",\"ph\":\"i\",\"s\":\"t\",\"ts\":" << timestamp;
+    }
+    file << ",\"pid\":" << record.device << ",\"tid\":" << record.next_device << ",\"args\":{\"chunk\":"
+         << record.chunk_id << ",\"size\":" << record.size << "}}";
+}
+
+void ChunkTracer::begin_event() noexcept {
+    file << (first_record ? "\n" : ",\n");
+    first_record = false;
+}
@@ -0,0 +1,137 @@
+/******************************************************************************
+This source code is licensed under the MIT license found in the
+LICENSE file in the root directory of this source tree.
+*******************************************************************************/
+
+#include "congestion_aware/TraceReplay.h"
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <iostream>
+
+using namespace NetworkAnalytical;
+using namespace NetworkAnalyticalCongestionAware;
+
+TraceReplay::TraceReplay(std::shared_ptr<Topology> topology,
+                         const std::string& path,
+                         const ChunkSize chunk_size,
+                         const int window_size) noexcept
+    : topology(std::move(topology)),
+      reader(path),
+      chunk_size(chunk_size),
+      window(window_size),
+      window_begin(0),
+      window_end(0),
+      completed_count(0),
+      finish_time(0) {
+    assert(this->topology != nullptr);
+    assert(chunk_size > 0);
+    assert(window_size > 0);
+}
+
+EventTime TraceReplay::run() noexcept {
+    assert(window_end == 0);
+
+    fill_window();
+    topology->get_simulation_context()->get_event_queue()->run();
+
+    if (completed_count != reader.get_records_count()) {
+        // shouldn't reach here
+        std::cerr << "[Error] (network/analytical/congestion_aware) " << "trace replay stalled after "
+                  << completed_count << " transfers" << std::endl;
+        std::exit(-1);
+    }
+    return finish_time;
+}
+
+uint64_t TraceReplay::get_completed_count() const noexcept {
+    return completed_count;
+}
+
+TraceReplay::Entry& TraceReplay::get_entry(const uint64_t index) noexcept {
+    assert(window_begin <= index && index < window_end);
+
+    return window[index % window.size()];
+}
+
+void TraceReplay::fill_window() noexcept {
+    const auto npus_count = topology->get_npus_count();
+
+    while (window_end - window_begin < window.size()) {
+        auto& entry = window[window_end % window.size()];
+        if (!reader.next(entry.record)) {
+            return;
+        }
+        const auto index = window_end++;
+        const auto& record = entry.record;
+        if (record.src < 0 || record.src >= npus_count || record.dest < 0 || record.dest >= npus_count) {
+            std::cerr << "[Error] (network/analytical/congestion_aware) " << "trace record " << index
+                      << " has an invalid NPU id" << std::endl;
+            std::exit(-1);
+        }
+
+        // wait for the dependencies still in the window
+        entry.remaining_dependencies = 0;
+        entry.dependents.clear();
+        entry.completed = false;
+        for (const auto dependency : record.dependencies) {
+            if (dependency >= index) {
+                std::cerr << "[Error] (network/analytical/congestion_aware) " << "trace record " << index
+                          << " depends on a later record" << std::endl;
+                std::exit(-1);
+            }
+            if (dependency >= window_begin && !get_entry(dependency).completed) {
+                get_entry(dependency).dependents.push_back(index);
+                entry.remaining_dependencies++;
+            }
+        }
+        if (entry.remaining_dependencies == 0) {
+            release(index);
+        }
+    }
+}
+
+void TraceReplay::release(const uint64_t index) noexcept {
+    auto* const event_queue = topology->get_simulation_context()->get_event_queue();
+    const auto& record = get_entry(index).record;
+
+    // transfers don't complete within this call, even empty ones
+    const auto issue_time = std::max(record.issue_time, event_queue->get_current_time());
+    if (issue_time > event_queue->get_current_time() || record.src == record.dest || record.size == 0) {
+        event_queue->schedule_event(issue_time, [this, index]() { issue(index); });
+        return;
+    }
+    issue(index);
+}
+
+void TraceReplay::issue(const uint64_t index) noexcept {
+    const auto& record = get_entry(index).record;
+
+    if (record.src == record.dest || record.size == 0) {
+        complete(index);
+        return;
+    }
+    topology->send_message(record.src, record.dest, record.size, std::min(chunk_size, record.size),
+                           [this, index]() { complete(index); });
+}
+
+void TraceReplay::complete(const uint64_t index) noexcept {
+    auto& entry = get_entry(index);
+    entry.completed = true;
+    completed_count++;
+    finish_time = std::max(finish_time, topology->get_simulation_context()->get_event_queue()->get_current_time());
+
+    // release the dependents whose last dependency this was
+    for (const auto dependent : entry.dependents) {
+        if (--get_entry(dependent).remaining_dependencies == 0) {
+            release(dependent);
+        }
+    }
+    entry.dependents.clear();
+
+    // slide the window past the completed records
+    while (window_begin < window_end && get_entry(window_begin).completed) {
+        window_begin++;
+    }
+    fill_window();
+}
@@ -0,0 +1,180 @@
+/******************************************************************************
+This source code is licensed under the MIT license found in the
+LICENSE file in the root directory of this source tree.
+*******************************************************************************/
+
+#include "congestion_aware/TrafficGenerator.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <numeric>
+
+using namespace NetworkAnalytical;
+using namespace NetworkAnalyticalCongestionAware;
+
+TrafficGenerator::TrafficGenerator(std::shared_ptr<Topology> topology,
+                                   const Pattern pattern,
+                                   const ChunkSize chunk_size,
+                                   const uint64_t seed) noexcept
+    : topology(std::move(topology)),
+      pattern(pattern),
+      chunk_size(chunk_size),
+      generator(seed),
+      injection_rate(0),
+      hotspot_npu(0),
+      hotspot_fraction(0),
+      sent_chunks_count(0),
+      arrived_chunks_count(0),
+      finish_time(0) {
+    assert(this->topology != nullptr);
+    assert(chunk_size > 0);
+
+    npus_count = this->topology->get_npus_count();
+    assert(npus_count > 1);
+
+    // check the pattern fits the number of NPUs
+    const auto side = static_cast<int>(std::lround(std::sqrt(npus_count)));
+    if (pattern == Pattern::BitComplement && (npus_count & (npus_count - 1)) != 0) {
+        std::cerr << "[Error] (network/analytical/congestion_aware) "
+                  << "BitComplement needs a power-of-2 number of NPUs" << std::endl;
+        std::exit(-1);
+    }
+    if (pattern == Pattern::Transpose && side * side != npus_count) {
+        std::cerr << "[Error] (network/analytical/congestion_aware) " << "Transpose needs a square number of NPUs"
+                  << std::endl;
+        std::exit(-1);
+    }
+
+    // random permutation, with no NPU sending to itself
+    permutation.resize(npus_count);
+    std::iota(permutation.begin(), permutation.end(), 0);
+    std::shuffle(permutation.begin(), permutation.end(), generator);
+    for (auto npu = 0; npu < npus_count; npu++) {
+        if (permutation[npu] == npu) {
+            std::swap(permutation[npu], permutation[(npu + 1) % npus_count]);
+        }
+    }
+
+    // experts ranked at random, uniformly popular until a Zipf exponent is set
+    experts_by_rank.resize(npus_count);
+    std::iota(experts_by_rank.begin(), experts_by_rank.end(), 0);
+    std::shuffle(experts_by_rank.begin(), experts_by_rank.end(), generator);
+    set_zipf_exponent(0);
+}
+
+void TrafficGenerator::set_injection_rate(const Bandwidth injection_rate) noexcept {
+    assert(injection_rate >= 0);
+
+    this->injection_rate = injection_rate;
+}
+
+void TrafficGenerator::set_hotspot(const DeviceId hotspot_npu, const double hotspot_fraction) noexcept {
+    assert(0 <= hotspot_npu && hotspot_npu < npus_count);
+    assert(0 <= hotspot_fraction && hotspot_fraction <= 1);
+
+    this->hotspot_npu = hotspot_npu;
+    this->hotspot_fraction = hotspot_fraction;
+}
+
+void TrafficGenerator::set_zipf_exponent(const double zipf_exponent) noexcept {
+    assert(zipf_exponent >= 0);
+
+    expert_cdf.resize(npus_count);
+    auto total_weight = 0.0;
+    for (auto rank = 0; rank < npus_count; rank++) {
+        total_weight += 1.0 / std::pow(rank + 1, zipf_exponent);
+        expert_cdf[rank] = total_weight;
+    }
+    for (auto& probability : expert_cdf) {
+        probability /= total_weight;
+    }
+}
+
+DeviceId TrafficGenerator::get_destination(const DeviceId src) noexcept {
+    assert(0 <= src && src < npus_count);
+
+    switch (pattern) {
+    case Pattern::UniformRandom:
+        return get_uniform_destination(src);
+    case Pattern::RandomPermutation:
+        return permutation[src];
+    case Pattern::BitComplement:
+        return ~src & (npus_count - 1);
+    case Pattern::Transpose: {
+        const auto side = static_cast<int>(std::lround(std::sqrt(npus_count)));
+        return ((src % side) * side) + (src / side);
+    }
+    case Pattern::Hotspot:
+        if (src != hotspot_npu && std::uniform_real_distribution<double>(0, 1)(generator) < hotspot_fraction) {
+            return hotspot_npu;
+        }
+        return get_uniform_destination(src);
+    case Pattern::MoeAllToAll: {
+        const auto draw = std::uniform_real_distribution<double>(0, 1)(generator);
+        const auto rank = std::upper_bound(expert_cdf.begin(), expert_cdf.end() - 1, draw) - expert_cdf.begin();
+        return experts_by_rank[rank];
+    }
+    default:
+        // shouldn't reach here
+        std::cerr << "[Error] (network/analytical/congestion_aware) " << "Not supported traffic pattern" << std::endl;
+        std::exit(-1);
+    }
+}
+
+EventTime TrafficGenerator::run(const int chunks_per_npu) noexcept {
+    assert(chunks_per_npu >= 0);
+
+    auto* const event_queue = topology->get_simulation_context()->get_event_queue();
+    remaining_chunks.assign(npus_count, chunks_per_npu);
+    sent_chunks_count = 0;
+    arrived_chunks_count = 0;
+    finish_time = event_queue->get_current_time();
+
+    for (auto npu = 0; npu < npus_count; npu++) {
+        inject(npu);
+    }
+    event_queue->run();
+
+    assert(arrived_chunks_count == sent_chunks_count);
+    return finish_time;
+}
+
+uint64_t TrafficGenerator::get_sent_chunks_count() const noexcept {
+    return sent_chunks_count;
+}
+
+DeviceId TrafficGenerator::get_uniform_destination(const DeviceId src) noexcept {
+    // draw among the other NPUs, skipping src
+    const auto dest = std::uniform_int_distribution<DeviceId>(0, npus_count - 2)(generator);
+    return (dest >= src) ? dest + 1 : dest;
+}
+
+void TrafficGenerator::inject(const DeviceId npu) noexcept {
+    auto* const event_queue = topology->get_simulation_context()->get_event_queue();
+
+    // without a rate, every chunk goes at once
+    do {
+        if (remaining_chunks[npu] == 0) {
+            return;
+        }
+        remaining_chunks[npu]--;
+
+        const auto dest = get_destination(npu);
+        if (dest != npu) {
+            sent_chunks_count++;
+            topology->send(npu, dest, chunk_size, [this, event_queue]() {
+                arrived_chunks_count++;
+                finish_time = std::max(finish_time, event_queue->get_current_time());
+            });
+        }
+    } while (injection_rate <= 0);
+
+    // next chunk once this one is injected at the given rate
+    if (remaining_chunks[npu] > 0) {
+        const auto interval = static_cast<EventTime>(std::ceil(static_cast<double>(chunk_size) / injection_rate));
+        event_queue->schedule_event(event_queue->get_current_time() + std::max<EventTime>(interval, 1),
+                                    [this, npu]() { inject(npu); });
+    }
+}
@@ -5,7 +5,11 @@ LICENSE file in the root directory of this source tree.
 
 #include "congestion_unaware/BasicTopology.h"
 #include "common/NetworkFunction.h"
+#include <algorithm>
+#include <array>
 #include <cassert>
+#include <cstdlib>
+#include <iostream>
 
 using namespace NetworkAnalytical;
 using namespace NetworkAnalyticalCongestionUnaware;
@@ -45,6 +49,124 @@ EventTime BasicTopology::send(const DeviceId src, const DeviceId dest, const Chu
     return compute_communication_delay(hops_count, chunk_size);
 }
 
+void BasicTopology::send_batch(const DeviceId* const srcs,
+                               const DeviceId* const dests,
+                               const ChunkSize* const chunk_sizes,
+                               EventTime* const delays,
+                               const size_t count) const noexcept {
+    // hops of a block of chunks, then their delays, both as tight loops
+    auto hops_counts = std::array<int, batch_block_size>();
+    for (auto first = static_cast<size_t>(0); first < count; first += batch_block_size) {
+        const auto block_size = std::min(batch_block_size, count - first);
+        compute_hops_counts(srcs + first, dests + first, hops_counts.data(), block_size);
+
+        for (auto i = static_cast<size_t>(0); i < block_size; i++) {
+            assert(hops_counts[i] > 0);
+            assert(chunk_sizes[first + i] > 0);
+
+            // same as compute_communication_delay()
+            const auto link_delay = hops_counts[i] * latency;
+            const auto serialization_delay = static_cast<double>(chunk_sizes[first + i]) / bandwidth_Bpns;
+            delays[first + i] = static_cast<EventTime>(link_delay + serialization_delay);
+        }
+    }
+}
+
+void BasicTopology::compute_hops_counts(const DeviceId* const srcs,
+                                        const DeviceId* const dests,
+                                        int* const hops_counts,
+                                        const size_t count) const noexcept {
+    for (auto i = static_cast<size_t>(0); i < count; i++) {
+        hops_counts[i] = compute_hops_count(srcs[i], dests[i]);
+    }
+}
+
+EventTime BasicTopology::collective_time(const CollectiveType collective_type,
+                                         const ChunkSize bytes,
+                                         const CollectiveAlgorithm algorithm) const noexcept {
+    if (npus_count == 1) {
+        return 0;
+    }
+
+    const auto buffer_size = static_cast<double>(bytes);
+    const auto shard_size = buffer_size / npus_count;
+    auto srcs = std::vector<DeviceId>();
+    auto dests = std::vector<DeviceId>();
+    auto time = 0.0;
+
+    switch (algorithm) {
+    case CollectiveAlgorithm::Ring: {
+        // every step sends to the next NPU of the ring
+        for (DeviceId i = 0; i < npus_count; i++) {
+            srcs.push_back(i);
+            dests.push_back((i + 1) % npus_count);
+        }
+        const auto hops_count = compute_max_hops_count(srcs, dests);
+        const auto steps_count = npus_count - 1;
+
+        if (collective_type == CollectiveType::AllToAll) {
+            // step k forwards the shards of the (npus_count - k) NPUs still ahead
+            for (auto k = 1; k < npus_count; k++) {
+                time += compute_step_time(hops_count, (npus_count - k) * shard_size);
+            }
+        } else {
+            time = steps_count * compute_step_time(hops_count, shard_size);
+        }
+        break;
+    }
+
+    case CollectiveAlgorithm::Direct: {
+        // a single step sends a shard to every other NPU at once
+        for (DeviceId i = 0; i < npus_count; i++) {
+            for (DeviceId j = 0; j < npus_count; j++) {
+                if (i != j) {
+                    srcs.push_back(i);
+                    dests.push_back(j);
+                }
+            }
+        }
+        time = compute_step_time(compute_max_hops_count(srcs, dests), shard_size);
+        break;
+    }
+
+    case CollectiveAlgorithm::HalvingDoubling: {
+        if ((npus_count & (npus_count - 1)) != 0) {
+            std::cerr << "[Error] (network/analytical/congestion_unaware) "
+                      << "halving-doubling needs a power-of-two NPUs count, got " << npus_count << std::endl;
+            std::exit(-1);
+        }
+
+        // step k exchanges half of the remaining buffer (or, for AllToAll, half the buffer)
+        auto exchanged_size = buffer_size;
+        for (auto distance = npus_count / 2; distance > 0; distance /= 2) {
+            srcs.clear();
+            dests.clear();
+            for (DeviceId i = 0; i < npus_count; i++) {
+                srcs.push_back(i);
+                dests.push_back(i ^ distance);
+            }
+            exchanged_size /= 2;
+            const auto step_size = (collective_type == CollectiveType::AllToAll) ? (buffer_size / 2) : exchanged_size;
+            time += compute_step_time(compute_max_hops_count(srcs, dests), step_size);
+        }
+        break;
+    }
+
+    default:
+        // shouldn't reach here
+        std::cerr << "[Error] (network/analytical/congestion_unaware) " << "Not supported collective algorithm"
+                  << std::endl;
+        std::exit(-1);
+    }
+
+    // AllReduce is a ReduceScatter followed by an AllGather, of the same time
+    if (collective_type == CollectiveType::AllReduce) {
+        time *= 2;
+    }
+
+    return static_cast<EventTime>(time);
+}
+
 EventTime BasicTopology::compute_communication_delay(const int hops_count, const ChunkSize chunk_size) const noexcept {
     assert(hops_count > 0);
     assert(chunk_size > 0);
@@ -65,3 +187,34 @@ TopologyBuildingBlock BasicTopology::get_basic_topology_type() const noexcept {
 
     return basic_topology_type;
 }
+
+Latency BasicTopology::get_latency() const noexcept {
+    return latency;
+}
+
+int BasicTopology::get_links_count() const noexcept {
+    // no links unless the topology models them
+    return 0;
+}
+
+bool BasicTopology::append_route_links([[maybe_unused]] const DeviceId src,
+                                       [[maybe_unused]] const DeviceId dest,
+                                       [[maybe_unused]] std::vector<int>& links) const noexcept {
+    return false;
+}
+
+double BasicTopology::compute_step_time(const int hops_count, const double bytes) const noexcept {
+    assert(hops_count > 0);
+    assert(bytes >= 0);
+
+    return (hops_count * latency) + (bytes / bandwidth_Bpns);
+}
+
+int BasicTopology::compute_max_hops_count(const std::vector<DeviceId>& srcs,
+                                          const std::vector<DeviceId>& dests) const noexcept {
+    assert(srcs.size() == dests.size());
+
+    auto hops_counts = std::vector<int>(srcs.size());
+    compute_hops_counts(srcs.data(), dests.data(), hops_counts.data(), srcs.size());
+    return *std::max_element(hops_counts.begin(), hops_counts.end());
+}
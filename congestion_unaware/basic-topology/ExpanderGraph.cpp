@@ -4,6 +4,8 @@ LICENSE file in the root directory of this source tree.
 *******************************************************************************/
 
 #include "congestion_unaware/ExpanderGraph.h"
+#include "common/ExpanderGraphFile.h"
+#include "common/Hash.h"
 #include <cassert>
 #include <ctime>
 #include <cstdlib>
@@ -11,30 +13,12 @@ LICENSE file in the root directory of this source tree.
 #include <queue>
 #include <fstream>
 #include <iostream>
+#include <iterator>
 #include <stdexcept>
-#include "../../../helper/json/json.hpp"
 
 using namespace NetworkAnalytical;
 using namespace NetworkAnalyticalCongestionUnaware;
 
-void ExpanderGraph::connect(DeviceId src, DeviceId dest) {
-    assert(0 <= src && src < npus_count);
-    assert(0 <= dest && dest < npus_count);
-    if (src == dest) {
-        std::cout << "[Error] Cannot connect a node to itself: " << src << std::endl;
-        return;
-        // throw std::invalid_argument("Cannot connect a node to itself");
-    }
-    if (std::find(adjacency_list[src].begin(), adjacency_list[src].end(), dest) != adjacency_list[src].end()) {
-        std::cout << "[Error] Connection already exists between nodes " << src << " and " << dest << std::endl;
-        return;
-        // throw std::invalid_argument("Connection already exists between the specified nodes");
-    }
-    // create bidirectional connection between src and dest in adjacency list
-    adjacency_list[src].push_back(dest);
-    adjacency_list[dest].push_back(src);
-}
-
 ExpanderGraph::ExpanderGraph(const int npus_count, const unsigned int degree, const Bandwidth bandwidth, const Latency latency, const std::string& inputfile) noexcept
     : BasicTopology(npus_count, bandwidth, latency) {
     assert(npus_count > 0);
@@ -42,6 +26,7 @@ ExpanderGraph::ExpanderGraph(const int npus_count, const unsigned int degree, co
     assert(latency >= 0);
     
     std::string inputfile_str = std::string(inputfile);
+    auto inputfile_contents = std::string();
     // set the building block type
     basic_topology_type = TopologyBuildingBlock::ExpanderGraph;
 
@@ -50,64 +35,36 @@ ExpanderGraph::ExpanderGraph(const int npus_count, const unsigned int degree, co
         adjacency_list[i] = std::vector<DeviceId>();
     }
 
-    // load graph from input json file
+    // load graph from input file, JSON or binary edge list
     if (!inputfile_str.empty()) {
-        std::ifstream file(inputfile_str);
+        std::ifstream file(inputfile_str, std::ios::binary);
         if (!file.is_open()) {
-            std::cerr << "[Error] Failed to open expander graph JSON file: " << inputfile_str << std::endl;
+            std::cerr << "[Error] Failed to open expander graph file: " << inputfile_str << std::endl;
             std::exit(-1);
         }
 
-        nlohmann::json j;
-        file >> j;
+        // keep the contents, which key the hop matrix file
+        inputfile_contents = std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
         file.close();
+        auto graph_file = ExpanderGraphFile();
+        if (!ExpanderGraphFile::load(inputfile_str, graph_file)) {
+            std::cerr << "[Error] Failed to load expander graph file: " << inputfile_str << std::endl;
+            std::exit(-1);
+        }
 
-        int node_count = j["node_count"];
-        int graph_degree = j["degree"];
+        int node_count = graph_file.get_node_count();
+        int graph_degree = graph_file.get_degree();
         
         // Check if we should use split graph (when npus_count is exactly half)
         bool use_split = (npus_count * 2 == node_count);
         
+        auto edges = std::vector<ExpanderGraphFile::Edge>();
         if (use_split) {
             std::cout << "[ExpanderGraph] Using split graph: " << npus_count << " NPUs from " 
                       << node_count << " node graph" << std::endl;
             
-            // Determine which group to use (group A: first half)
-            auto group_a = j["groups"]["A"].get<std::vector<int>>();
-            
-            // Build node mapping: original node ID -> local NPU ID (0 to npus_count-1)
-            std::map<int, int> node_to_npu;
-            std::set<int> group_a_set;
-            for (size_t i = 0; i < group_a.size(); ++i) {
-                node_to_npu[group_a[i]] = i;
-                group_a_set.insert(group_a[i]);
-            }
-            
-            // Use connected_graph_adjacency to build the graph
-            // This is an adjacency list where index i contains neighbors of node i
-            auto adjacency = j["split_graph_adjacency"];
-            
-            for (size_t node_id = 0; node_id < adjacency.size(); ++node_id) {
-                // Only process nodes in group A
-                if (group_a_set.find(node_id) == group_a_set.end()) {
-                    continue;
-                }
-                
-                int npu_id = node_to_npu[node_id];
-                auto neighbors = adjacency[node_id].get<std::vector<int>>();
-                
-                for (int neighbor_node_id : neighbors) {
-                    // Only add edges between nodes in group A
-                    if (group_a_set.find(neighbor_node_id) != group_a_set.end()) {
-                        int neighbor_npu_id = node_to_npu[neighbor_node_id];
-                        // connect() adds bidirectional edges, so only connect if npu_id < neighbor_npu_id
-                        // to avoid adding each edge twice
-                        if (npu_id < neighbor_npu_id) {
-                            this->connect(npu_id, neighbor_npu_id);
-                        }
-                    }
-                }
-            }
+            // edges between the nodes of group A (first half), renumbered by their position in it
+            edges = graph_file.get_split_graph_edges();
         } else {
             // Use full graph
             if (npus_count != node_count) {
@@ -117,27 +74,27 @@ ExpanderGraph::ExpanderGraph(const int npus_count, const unsigned int degree, co
             }
             
             std::cout << "[ExpanderGraph] Using full graph: " << node_count << " nodes" << std::endl;
-            
-            // Use connected_graph_adjacency to build the full graph
-            auto adjacency = j["connected_graph_adjacency"];
-            
-            for (size_t node_id = 0; node_id < adjacency.size(); ++node_id) {
-                auto neighbors = adjacency[node_id].get<std::vector<int>>();
-                
-                for (int neighbor_id : neighbors) {
-                    // connect() adds bidirectional edges, so only connect if node_id < neighbor_id
-                    // to avoid adding each edge twice
-                    if ((int)node_id < neighbor_id) {
-                        this->connect(node_id, neighbor_id);
-                    }
-                }
+            edges = graph_file.get_connected_graph_edges();
+        }
+        for (const auto& [src, dest] : edges) {
+            if (dest >= npus_count) {
+                std::cerr << "[Error] Expander graph node " << dest << " exceeds the " << npus_count
+                          << " NPUs of the topology" << std::endl;
+                std::exit(-1);
             }
         }
+
+        // searches run on the immutable CSR form of the graph
+        graph = CsrGraph(npus_count, edges);
+        for (DeviceId i = 0; i < npus_count; ++i) {
+            const auto [first_neighbor, last_neighbor] = graph.get_neighbors(i);
+            adjacency_list[i].assign(first_neighbor, last_neighbor);
+        }
         
         // Verify the graph degree
         for (int i = 0; i < npus_count; ++i) {
-            if (adjacency_list[i].size() != graph_degree) {
-                std::cerr << "[Warning] Node " << i << " has degree " << adjacency_list[i].size() 
+            if (graph.get_degree(i) != graph_degree) {
+                std::cerr << "[Warning] Node " << i << " has degree " << graph.get_degree(i) 
                           << " but expected " << graph_degree << std::endl;
             }
         }
@@ -145,55 +102,39 @@ ExpanderGraph::ExpanderGraph(const int npus_count, const unsigned int degree, co
         std::cerr << "[Error] ExpanderGraph requires an input JSON file" << std::endl;
         std::exit(-1);
     }
+
+    // hop counts of every pair, shared with other runs through a file aside the graph
+    load_distance_matrix(inputfile_str + ".hops", inputfile_contents);
 }
 
-unsigned int ExpanderGraph::get_distance(const DeviceId src, const DeviceId dest, std::set<DeviceId> visited, unsigned int current_distance) const noexcept {
-    // Use distance cache
-    std::pair<DeviceId, DeviceId> node_pair = std::make_pair(src, dest);
-    if (distance_cache.find(node_pair) != distance_cache.end()) {
-        return distance_cache[node_pair];
+void ExpanderGraph::load_distance_matrix(const std::string& path, const std::string& inputfile_contents) noexcept {
+    // the distances depend on the graph file and the NPUs count (which selects the split graph)
+    auto key = hash_bytes(inputfile_contents.data(), inputfile_contents.size());
+    key = hash_bytes(reinterpret_cast<const char*>(&npus_count), sizeof(npus_count), key);
+
+    if (DistanceMatrix::load(path, key, distance_matrix) && distance_matrix.get_nodes_count() == graph.get_nodes_count()) {
+        std::cout << "[ExpanderGraph] Mapped hop counts from " << path << std::endl;
+        return;
     }
-    
-    if (src == dest) {
-        return 0;
+
+    distance_matrix = DistanceMatrix(graph);
+    if (!distance_matrix.save(path, key)) {
+        std::cerr << "[Warning] Failed to save hop counts to " << path << std::endl;
     }
-    
-    // Dijkstra's algorithm using priority queue
-    std::vector<unsigned int> dist(npus_count, UINT32_MAX);
-    std::priority_queue<std::pair<unsigned int, DeviceId>, 
-                       std::vector<std::pair<unsigned int, DeviceId>>,
-                       std::greater<std::pair<unsigned int, DeviceId>>> pq;
-    
-    dist[src] = 0;
-    pq.push({0, src});
-    
-    while (!pq.empty()) {
-        auto [d, u] = pq.top();
-        pq.pop();
-        
-        if (u == dest) {
-            distance_cache[node_pair] = d;
-            return d;
-        }
-        
-        if (d > dist[u]) {
-            continue;
-        }
-        
-        for (const auto& neighbor : adjacency_list.at(u)) {
-            unsigned int new_dist = dist[u] + 1;
-            if (new_dist < dist[neighbor]) {
-                dist[neighbor] = new_dist;
-                pq.push({new_dist, neighbor});
-            }
-        }
+}
+
+const CsrGraph& ExpanderGraph::get_graph() const noexcept {
+    return graph;
+}
+
+unsigned int ExpanderGraph::get_distance(const DeviceId src, const DeviceId dest, std::set<DeviceId> visited, unsigned int current_distance) const noexcept {
+    const auto distance = distance_matrix.get_distance(src, dest);
+    assert(distance != DistanceMatrix::unreachable_distance);
+    if (distance == DistanceMatrix::unreachable_distance) {
+        return UINT32_MAX;
     }
-    
-    assert(dist[dest] != UINT32_MAX);
-    assert(dist[dest] > 0);
-    distance_cache[node_pair] = dist[dest];
-    return dist[dest];
-}   
+    return distance;
+}
 
 int ExpanderGraph::compute_hops_count(const DeviceId src, const DeviceId dest) const noexcept {
     assert(0 <= src && src < npus_count);
@@ -202,3 +143,49 @@ int ExpanderGraph::compute_hops_count(const DeviceId src, const DeviceId dest) c
 
     return this->get_distance(src, dest, std::set<DeviceId>(), 0);
 }
+
+void ExpanderGraph::compute_hops_counts(const DeviceId* const srcs,
+                                       const DeviceId* const dests,
+                                       int* const hops_counts,
+                                       const size_t count) const noexcept {
+    for (auto i = static_cast<size_t>(0); i < count; i++) {
+        assert(srcs[i] != dests[i]);
+        const auto distance = distance_matrix.get_distance(srcs[i], dests[i]);
+        assert(distance != DistanceMatrix::unreachable_distance);
+        hops_counts[i] = distance;
+    }
+}
+
+int ExpanderGraph::get_links_count() const noexcept {
+    return graph.get_edges_count();
+}
+
+bool ExpanderGraph::append_route_links(const DeviceId src,
+                                       const DeviceId dest,
+                                       std::vector<int>& links) const noexcept {
+    assert(0 <= src && src < npus_count);
+    assert(0 <= dest && dest < npus_count);
+    assert(src != dest);
+
+    // step to the first neighbor one hop closer to dest
+    const auto& offsets = graph.get_offsets();
+    const auto& edge_targets = graph.get_edge_targets();
+    auto current = src;
+    while (current != dest) {
+        const auto distance = distance_matrix.get_distance(current, dest);
+        auto next_edge = -1;
+        for (auto edge = offsets[current]; edge < offsets[current + 1]; edge++) {
+            if (distance_matrix.get_distance(edge_targets[edge], dest) + 1 == distance) {
+                next_edge = edge;
+                break;
+            }
+        }
+        if (next_edge < 0) {
+            // dest is unreachable
+            return false;
+        }
+        links.push_back(next_edge);
+        current = edge_targets[next_edge];
+    }
+    return true;
+}
@@ -4,6 +4,7 @@ LICENSE file in the root directory of this source tree.
 *******************************************************************************/
 
 #include "congestion_unaware/FullyConnected.h"
+#include <algorithm>
 #include <cassert>
 
 using namespace NetworkAnalytical;
@@ -27,3 +28,26 @@ int FullyConnected::compute_hops_count(const DeviceId src, const DeviceId dest)
     // for FullyConnected, hops_count is always 1 (src -> dest)
     return 1;
 }
+
+void FullyConnected::compute_hops_counts(const DeviceId* const srcs,
+                                        const DeviceId* const dests,
+                                        int* const hops_counts,
+                                        const size_t count) const noexcept {
+    // every pair is 1 hop away
+    std::fill(hops_counts, hops_counts + count, 1);
+}
+
+int FullyConnected::get_links_count() const noexcept {
+    return npus_count * npus_count;
+}
+
+bool FullyConnected::append_route_links(const DeviceId src,
+                                        const DeviceId dest,
+                                        std::vector<int>& links) const noexcept {
+    assert(0 <= src && src < npus_count);
+    assert(0 <= dest && dest < npus_count);
+    assert(src != dest);
+
+    links.push_back((src * npus_count) + dest);
+    return true;
+}
@@ -4,6 +4,7 @@ LICENSE file in the root directory of this source tree.
 *******************************************************************************/
 
 #include "congestion_unaware/Ring.h"
+#include <algorithm>
 #include <cassert>
 
 using namespace NetworkAnalytical;
@@ -47,3 +48,56 @@ int Ring::compute_hops_count(const DeviceId src, const DeviceId dest) const noex
     // bidirectional: return shorter distance
     return (clockwise_distance < anticlockwise_distance) ? clockwise_distance : anticlockwise_distance;
 }
+
+void Ring::compute_hops_counts(const DeviceId* const srcs,
+                              const DeviceId* const dests,
+                              int* const hops_counts,
+                              const size_t count) const noexcept {
+    // branchless form of compute_hops_count, so the loop vectorizes
+    if (!bidirectional) {
+        for (auto i = static_cast<size_t>(0); i < count; i++) {
+            assert(srcs[i] != dests[i]);
+            const auto distance = dests[i] - srcs[i];
+            hops_counts[i] = distance + ((distance < 0) ? npus_count : 0);
+        }
+        return;
+    }
+
+    for (auto i = static_cast<size_t>(0); i < count; i++) {
+        assert(srcs[i] != dests[i]);
+        const auto distance = dests[i] - srcs[i];
+        const auto clockwise_distance = distance + ((distance < 0) ? npus_count : 0);
+        const auto anticlockwise_distance = npus_count - clockwise_distance;
+        hops_counts[i] = std::min(clockwise_distance, anticlockwise_distance);
+    }
+}
+
+int Ring::get_links_count() const noexcept {
+    return 2 * npus_count;
+}
+
+bool Ring::append_route_links(const DeviceId src, const DeviceId dest, std::vector<int>& links) const noexcept {
+    assert(0 <= src && src < npus_count);
+    assert(0 <= dest && dest < npus_count);
+    assert(src != dest);
+
+    // same direction as compute_hops_count
+    auto clockwise_distance = dest - src;
+    if (clockwise_distance < 0) {
+        clockwise_distance += npus_count;
+    }
+    const auto clockwise = !bidirectional || clockwise_distance < npus_count - clockwise_distance;
+    const auto hops_count = clockwise ? clockwise_distance : npus_count - clockwise_distance;
+
+    auto current = src;
+    for (auto hop = 0; hop < hops_count; hop++) {
+        if (clockwise) {
+            links.push_back(current);
+            current = (current + 1) % npus_count;
+        } else {
+            links.push_back(npus_count + current);
+            current = (current + npus_count - 1) % npus_count;
+        }
+    }
+    return true;
+}
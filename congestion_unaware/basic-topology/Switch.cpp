@@ -4,6 +4,7 @@ LICENSE file in the root directory of this source tree.
 *******************************************************************************/
 
 #include "congestion_unaware/Switch.h"
+#include <algorithm>
 #include <cassert>
 
 using namespace NetworkAnalytical;
@@ -27,3 +28,26 @@ int Switch::compute_hops_count(const DeviceId src, const DeviceId dest) const no
     // for switch, hops_count is always 2 (src -> switch -> dest)
     return 2;
 }
+
+void Switch::compute_hops_counts(const DeviceId* const srcs,
+                                const DeviceId* const dests,
+                                int* const hops_counts,
+                                const size_t count) const noexcept {
+    // every pair is 2 hops away
+    std::fill(hops_counts, hops_counts + count, 2);
+}
+
+int Switch::get_links_count() const noexcept {
+    return 2 * npus_count;
+}
+
+bool Switch::append_route_links(const DeviceId src, const DeviceId dest, std::vector<int>& links) const noexcept {
+    assert(0 <= src && src < npus_count);
+    assert(0 <= dest && dest < npus_count);
+    assert(src != dest);
+
+    // up from src, then down to dest
+    links.push_back(src);
+    links.push_back(npus_count + dest);
+    return true;
+}
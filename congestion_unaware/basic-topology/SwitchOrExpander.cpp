@@ -57,9 +57,20 @@ int SwitchOrExpander::compute_hops_count(DeviceId src, DeviceId dest) const noex
     return 2;
 }
 
-std::map<DeviceId, std::vector<DeviceId>> SwitchOrExpander::get_adjacency_list() const noexcept {
+const std::map<DeviceId, std::vector<DeviceId>>& SwitchOrExpander::get_adjacency_list() const noexcept {
+    static const auto empty_adjacency_list = std::map<DeviceId, std::vector<DeviceId>>();
+
     if (use_moe_routing && expander_topology) {
         return expander_topology->adjacency_list;
     }
-    return {};
+    return empty_adjacency_list;
+}
+
+const CsrGraph& SwitchOrExpander::get_graph() const noexcept {
+    static const auto empty_graph = CsrGraph();
+
+    if (use_moe_routing && expander_topology) {
+        return expander_topology->get_graph();
+    }
+    return empty_graph;
 }
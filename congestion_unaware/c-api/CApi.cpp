@@ -0,0 +1,163 @@
+/******************************************************************************
+This source code is licensed under the MIT license found in the
+LICENSE file in the root directory of this source tree.
+*******************************************************************************/
+
+#include "common/CApi.h"
+#include "common/NetworkParser.h"
+#include "congestion_unaware/Helper.h"
+#include <algorithm>
+#include <cassert>
+#include <functional>
+#include <memory>
+#include <queue>
+#include <tuple>
+#include <vector>
+
+using namespace NetworkAnalytical;
+using namespace NetworkAnalyticalCongestionUnaware;
+
+/**
+ * Simulation driven through the C interface:
+ * transfers in flight complete after the delay the topology estimates for them.
+ */
+struct ana_sim {
+    /// transfer in flight: (completion time, injection order, tag)
+    using InFlight = std::tuple<EventTime, uint64_t, uint64_t>;
+
+    /// topology being simulated
+    std::shared_ptr<Topology> topology;
+
+    /// current time of the simulation
+    EventTime current_time;
+
+    /// transfers in flight, earliest completion first (ties in injection order)
+    std::priority_queue<InFlight, std::vector<InFlight>, std::greater<>> in_flight;
+
+    /// number of transfers injected so far
+    uint64_t sent_count;
+
+    /// completed transfers, oldest first
+    std::vector<ana_completion> completions;
+
+    /// number of leading completions already polled
+    size_t polled_count;
+
+    /// batch arrays given to Topology::send_batch(), kept to reuse their storage
+    std::vector<DeviceId> srcs;
+    std::vector<DeviceId> dests;
+    std::vector<ChunkSize> chunk_sizes;
+    std::vector<EventTime> delays;
+};
+
+ana_sim* ana_sim_create(const char* const config_path) {
+    if (config_path == nullptr) {
+        return nullptr;
+    }
+
+    const auto network_parser = NetworkParser(config_path);
+    auto* const sim = new ana_sim();
+    sim->topology = construct_topology(network_parser);
+    sim->current_time = 0;
+    sim->sent_count = 0;
+    sim->polled_count = 0;
+    return sim;
+}
+
+void ana_sim_destroy(ana_sim* const sim) {
+    delete sim;
+}
+
+int32_t ana_get_npus_count(const ana_sim* const sim) {
+    assert(sim != nullptr);
+
+    return sim->topology->get_npus_count();
+}
+
+uint64_t ana_get_current_time(const ana_sim* const sim) {
+    assert(sim != nullptr);
+
+    return sim->current_time;
+}
+
+int ana_send_batch(ana_sim* const sim, const ana_transfer* const transfers, const size_t count) {
+    assert(sim != nullptr);
+
+    // check every transfer first, so that a batch is either injected or not
+    if (count > 0 && transfers == nullptr) {
+        return ANA_ERROR_INVALID_ARGUMENT;
+    }
+    const auto npus_count = sim->topology->get_npus_count();
+    for (auto i = static_cast<size_t>(0); i < count; i++) {
+        const auto& transfer = transfers[i];
+        if (transfer.src < 0 || transfer.src >= npus_count || transfer.dest < 0 || transfer.dest >= npus_count ||
+            transfer.size == 0) {
+            return ANA_ERROR_INVALID_ARGUMENT;
+        }
+    }
+
+    // estimate the delays of the whole batch at once
+    sim->srcs.clear();
+    sim->dests.clear();
+    sim->chunk_sizes.clear();
+    for (auto i = static_cast<size_t>(0); i < count; i++) {
+        if (transfers[i].src != transfers[i].dest) {
+            sim->srcs.push_back(transfers[i].src);
+            sim->dests.push_back(transfers[i].dest);
+            sim->chunk_sizes.push_back(transfers[i].size);
+        }
+    }
+    sim->delays.resize(sim->srcs.size());
+    sim->topology->send_batch(sim->srcs.data(), sim->dests.data(), sim->chunk_sizes.data(), sim->delays.data(),
+                              sim->srcs.size());
+
+    auto next_delay = sim->delays.begin();
+    for (auto i = static_cast<size_t>(0); i < count; i++) {
+        const auto delay = (transfers[i].src == transfers[i].dest) ? 0 : *(next_delay++);
+        sim->in_flight.emplace(sim->current_time + delay, sim->sent_count++, transfers[i].tag);
+    }
+    return ANA_OK;
+}
+
+uint64_t ana_advance_until(ana_sim* const sim, const uint64_t end_time) {
+    assert(sim != nullptr);
+
+    // complete the transfers in flight up to end_time, in completion order
+    auto& in_flight = sim->in_flight;
+    while (!in_flight.empty() && std::get<0>(in_flight.top()) <= end_time) {
+        const auto [completion_time, sent_index, tag] = in_flight.top();
+        in_flight.pop();
+        sim->completions.push_back({tag, completion_time});
+    }
+
+    sim->current_time = std::max(sim->current_time, end_time);
+    return sim->current_time;
+}
+
+int ana_get_next_event_time(const ana_sim* const sim, uint64_t* const next_time) {
+    assert(sim != nullptr);
+    assert(next_time != nullptr);
+
+    if (sim->in_flight.empty()) {
+        return 0;
+    }
+    *next_time = std::get<0>(sim->in_flight.top());
+    return 1;
+}
+
+size_t ana_poll_completions(ana_sim* const sim, ana_completion* const completions, const size_t capacity) {
+    assert(sim != nullptr);
+    assert(capacity == 0 || completions != nullptr);
+
+    auto& pending = sim->completions;
+    const auto count = std::min(capacity, pending.size() - sim->polled_count);
+    std::copy_n(pending.begin() + static_cast<std::ptrdiff_t>(sim->polled_count), count, completions);
+    sim->polled_count += count;
+
+    // drop the polled completions once they're the majority, keeping the storage
+    if (sim->polled_count * 2 >= pending.size()) {
+        pending.erase(pending.begin(), pending.begin() + static_cast<std::ptrdiff_t>(sim->polled_count));
+        sim->polled_count = 0;
+    }
+    return count;
+}
@@ -0,0 +1,142 @@
+/******************************************************************************
+This source code is licensed under the MIT license found in the
+LICENSE file in the root directory of this source tree.
+*******************************************************************************/
+
+#include "congestion_unaware/ContentionEstimator.h"
+#include "common/NetworkFunction.h"
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <iostream>
+
+using namespace NetworkAnalytical;
+using namespace NetworkAnalyticalCongestionUnaware;
+
+ContentionEstimator::ContentionEstimator(std::shared_ptr<BasicTopology> topology,
+                                         const EventTime window,
+                                         const QueueModel queue_model) noexcept
+    : topology(std::move(topology)),
+      window(window),
+      queue_model(queue_model) {
+    assert(this->topology != nullptr);
+    assert(window > 0);
+
+    if (this->topology->get_links_count() <= 0) {
+        std::cerr << "[Error] (network/analytical/congestion_unaware) "
+                  << "contention can't be estimated on a topology that doesn't model its links" << std::endl;
+        std::exit(-1);
+    }
+
+    const auto npus_count = this->topology->get_npus_count();
+    bandwidth_Bpns = bw_GBps_to_Bpns(this->topology->get_bandwidth_per_dim()[0]);
+    link_bytes.assign(this->topology->get_links_count(), 0.0);
+    declared_traffic.assign(static_cast<size_t>(npus_count) * npus_count, 0);
+}
+
+void ContentionEstimator::set_traffic(const DeviceId src, const DeviceId dest, const ChunkSize bytes) noexcept {
+    const auto npus_count = topology->get_npus_count();
+    assert(0 <= src && src < npus_count);
+    assert(0 <= dest && dest < npus_count);
+    assert(src != dest || bytes == 0);
+
+    // only the links of the pair change
+    auto& declared_bytes = declared_traffic[(static_cast<size_t>(src) * npus_count) + dest];
+    if (declared_bytes == bytes) {
+        return;
+    }
+    add_route_bytes(src, dest, static_cast<double>(bytes) - static_cast<double>(declared_bytes));
+    declared_bytes = bytes;
+}
+
+void ContentionEstimator::set_traffic_matrix(const std::vector<ChunkSize>& traffic_matrix) noexcept {
+    const auto npus_count = topology->get_npus_count();
+    assert(traffic_matrix.size() == declared_traffic.size());
+
+    for (DeviceId src = 0; src < npus_count; src++) {
+        for (DeviceId dest = 0; dest < npus_count; dest++) {
+            set_traffic(src, dest, traffic_matrix[(static_cast<size_t>(src) * npus_count) + dest]);
+        }
+    }
+}
+
+void ContentionEstimator::clear_traffic() noexcept {
+    std::fill(link_bytes.begin(), link_bytes.end(), 0.0);
+    std::fill(declared_traffic.begin(), declared_traffic.end(), 0);
+    recorded_sends.clear();
+}
+
+EventTime ContentionEstimator::send(const DeviceId src, const DeviceId dest, const ChunkSize chunk_size) const noexcept {
+    const auto delay = topology->send(src, dest, chunk_size);
+
+    // queueing delay, in serializations of the chunk
+    collect_route_links(src, dest);
+    auto waited_serializations = 0.0;
+    if (queue_model == QueueModel::FairShare) {
+        auto max_load = 0.0;
+        for (const auto link : route_links) {
+            max_load = std::max(max_load, get_link_load(link));
+        }
+        waited_serializations = std::max(0.0, max_load - 1.0);
+    } else {
+        for (const auto link : route_links) {
+            const auto load = get_link_load(link);
+            const auto stable_load = std::min(load, saturated_load);
+            waited_serializations += (stable_load / (2.0 * (1.0 - stable_load))) + std::max(0.0, load - 1.0);
+        }
+    }
+
+    const auto serialization_delay = static_cast<double>(chunk_size) / bandwidth_Bpns;
+    return delay + static_cast<EventTime>(waited_serializations * serialization_delay);
+}
+
+EventTime ContentionEstimator::record_send(const DeviceId src,
+                                           const DeviceId dest,
+                                           const ChunkSize chunk_size,
+                                           const EventTime current_time) noexcept {
+    assert(recorded_sends.empty() || recorded_sends.back().time <= current_time);
+
+    // drop the chunks sent before the window
+    while (!recorded_sends.empty() && recorded_sends.front().time + window <= current_time) {
+        const auto& recorded = recorded_sends.front();
+        add_route_bytes(recorded.src, recorded.dest, -static_cast<double>(recorded.chunk_size));
+        recorded_sends.pop_front();
+    }
+
+    // the chunk contends with the ones before it, and itself
+    recorded_sends.push_back({current_time, src, dest, chunk_size});
+    add_route_bytes(src, dest, static_cast<double>(chunk_size));
+    return send(src, dest, chunk_size);
+}
+
+double ContentionEstimator::get_link_load(const int link) const noexcept {
+    assert(0 <= link && link < static_cast<int>(link_bytes.size()));
+
+    // removed bytes may leave rounding errors behind
+    return std::max(0.0, link_bytes[link]) / (bandwidth_Bpns * static_cast<double>(window));
+}
+
+double ContentionEstimator::get_route_load(const DeviceId src, const DeviceId dest) const noexcept {
+    collect_route_links(src, dest);
+    auto max_load = 0.0;
+    for (const auto link : route_links) {
+        max_load = std::max(max_load, get_link_load(link));
+    }
+    return max_load;
+}
+
+void ContentionEstimator::add_route_bytes(const DeviceId src, const DeviceId dest, const double bytes) noexcept {
+    collect_route_links(src, dest);
+    for (const auto link : route_links) {
+        link_bytes[link] += bytes;
+    }
+}
+
+void ContentionEstimator::collect_route_links(const DeviceId src, const DeviceId dest) const noexcept {
+    route_links.clear();
+    if (!topology->append_route_links(src, dest, route_links)) {
+        std::cerr << "[Error] (network/analytical/congestion_unaware) "
+                  << "no route from " << src << " to " << dest << std::endl;
+        std::exit(-1);
+    }
+}
@@ -41,6 +41,95 @@ EventTime MultiDimTopology::send(const DeviceId src, const DeviceId dest, const
     return comms_delay;
 }
 
+void MultiDimTopology::send_batch(const DeviceId* const srcs,
+                                  const DeviceId* const dests,
+                                  const ChunkSize* const chunk_sizes,
+                                  EventTime* const delays,
+                                  const size_t count) const noexcept {
+    // chunks of a dimension, in local address
+    struct DimBatch {
+        std::vector<DeviceId> srcs;
+        std::vector<DeviceId> dests;
+        std::vector<ChunkSize> chunk_sizes;
+        std::vector<EventTime> delays;
+        std::vector<size_t> indices;
+    };
+    auto batch_per_dim = std::vector<DimBatch>(dims_count);
+
+    // group chunks by the first dimension where src and dest differ
+    for (auto i = static_cast<size_t>(0); i < count; i++) {
+        assert(0 <= srcs[i] && srcs[i] < npus_count);
+        assert(0 <= dests[i] && dests[i] < npus_count);
+
+        auto src = srcs[i];
+        auto dest = dests[i];
+        auto dim = 0;
+        for (; dim < dims_count; dim++) {
+            const auto dim_size = npus_count_per_dim[dim];
+            if (src % dim_size != dest % dim_size) {
+                break;
+            }
+            src /= dim_size;
+            dest /= dim_size;
+        }
+        if (dim == dims_count) {
+            std::cerr << "[Error] (network/analytical/congestion_unaware): " << "src and dest have the same address"
+                      << std::endl;
+            std::exit(-1);
+        }
+
+        auto& batch = batch_per_dim[dim];
+        batch.srcs.push_back(src % npus_count_per_dim[dim]);
+        batch.dests.push_back(dest % npus_count_per_dim[dim]);
+        batch.chunk_sizes.push_back(chunk_sizes[i]);
+        batch.indices.push_back(i);
+    }
+
+    // run localized communication, one batch per dimension
+    for (auto dim = 0; dim < dims_count; dim++) {
+        auto& batch = batch_per_dim[dim];
+        const auto batch_size = batch.indices.size();
+        if (batch_size == 0) {
+            continue;
+        }
+
+        batch.delays.resize(batch_size);
+        topology_per_dim[dim]->send_batch(batch.srcs.data(), batch.dests.data(), batch.chunk_sizes.data(),
+                                          batch.delays.data(), batch_size);
+        for (auto i = static_cast<size_t>(0); i < batch_size; i++) {
+            delays[batch.indices[i]] = batch.delays[i];
+        }
+    }
+}
+
+EventTime MultiDimTopology::collective_time(const CollectiveType collective_type,
+                                            const ChunkSize bytes,
+                                            const CollectiveAlgorithm algorithm) const noexcept {
+    auto time = static_cast<EventTime>(0);
+
+    // AllToAll exchanges the full buffer within every dimension
+    if (collective_type == CollectiveType::AllToAll) {
+        for (const auto& topology : topology_per_dim) {
+            time += topology->collective_time(collective_type, bytes, algorithm);
+        }
+        return time;
+    }
+
+    // each dimension works on the shard left by the lower ones
+    auto shard_size = bytes;
+    for (auto dim = 0; dim < dims_count; dim++) {
+        if (collective_type == CollectiveType::AllReduce) {
+            time += topology_per_dim[dim]->collective_time(CollectiveType::ReduceScatter, shard_size, algorithm);
+            time += topology_per_dim[dim]->collective_time(CollectiveType::AllGather, shard_size, algorithm);
+        } else {
+            time += topology_per_dim[dim]->collective_time(collective_type, shard_size, algorithm);
+        }
+        shard_size /= npus_count_per_dim[dim];
+    }
+
+    return time;
+}
+
 void MultiDimTopology::append_dimension(std::unique_ptr<BasicTopology> topology) noexcept {
     // increment dims_count
     dims_count++;
@@ -23,10 +23,18 @@ std::shared_ptr<Topology> NetworkAnalyticalCongestionUnaware::construct_topology
     const auto dims_count = network_parser.get_dims_count();
     const auto topologies_per_dim = network_parser.get_topologies_per_dim();
     const auto npus_counts_per_dim = network_parser.get_npus_counts_per_dim();
-    const auto bandwidths_per_dim = network_parser.get_bandwidths_per_dim();
-    const auto latencies_per_dim = network_parser.get_latencies_per_dim();
+    auto bandwidths_per_dim = network_parser.get_bandwidths_per_dim();
+    auto latencies_per_dim = network_parser.get_latencies_per_dim();
     const auto inputfiles_per_dim = network_parser.get_inputfiles_per_dim();
 
+    // apply the calibrated correction factors, if any
+    const auto bandwidth_scales_per_dim = network_parser.get_bandwidth_scales_per_dim();
+    const auto latency_scales_per_dim = network_parser.get_latency_scales_per_dim();
+    for (auto dim = 0; dim < dims_count; dim++) {
+        bandwidths_per_dim[dim] *= bandwidth_scales_per_dim[dim];
+        latencies_per_dim[dim] *= latency_scales_per_dim[dim];
+    }
+
     // if dims_count is 1, just create basic topology
     if (dims_count == 1) {
         // retrieve basic topology info
@@ -0,0 +1,55 @@
+/******************************************************************************
+This source code is licensed under the MIT license found in the
+LICENSE file in the root directory of this source tree.
+*******************************************************************************/
+
+#include "congestion_unaware/TraceReplay.h"
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <iostream>
+
+using namespace NetworkAnalytical;
+using namespace NetworkAnalyticalCongestionUnaware;
+
+TraceReplay::TraceReplay(std::shared_ptr<Topology> topology, const std::string& path, const int window_size) noexcept
+    : topology(std::move(topology)),
+      reader(path),
+      completion_times(window_size) {
+    assert(this->topology != nullptr);
+    assert(window_size > 0);
+}
+
+EventTime TraceReplay::run() noexcept {
+    const auto npus_count = topology->get_npus_count();
+    const auto window_size = static_cast<uint64_t>(completion_times.size());
+
+    auto record = TraceRecord();
+    auto finish_time = static_cast<EventTime>(0);
+    for (auto index = static_cast<uint64_t>(0); reader.next(record); index++) {
+        if (record.src < 0 || record.src >= npus_count || record.dest < 0 || record.dest >= npus_count) {
+            std::cerr << "[Error] (network/analytical/congestion_unaware) " << "trace record " << index
+                      << " has an invalid NPU id" << std::endl;
+            std::exit(-1);
+        }
+
+        // issued once its issue time has come and its dependencies completed
+        auto issue_time = record.issue_time;
+        for (const auto dependency : record.dependencies) {
+            if (dependency >= index || index - dependency > window_size) {
+                std::cerr << "[Error] (network/analytical/congestion_unaware) " << "trace record " << index
+                          << " depends on a record outside the window" << std::endl;
+                std::exit(-1);
+            }
+            issue_time = std::max(issue_time, completion_times[dependency % window_size]);
+        }
+
+        const auto delay =
+            (record.src == record.dest || record.size == 0) ? 0 : topology->send(record.src, record.dest, record.size);
+        const auto completion_time = issue_time + delay;
+        completion_times[index % window_size] = completion_time;
+        finish_time = std::max(finish_time, completion_time);
+    }
+
+    return finish_time;
+}
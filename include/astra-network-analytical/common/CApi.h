@@ -0,0 +1,139 @@
+/******************************************************************************
+This source code is licensed under the MIT license found in the
+LICENSE file in the root directory of this source tree.
+*******************************************************************************/
+
+#pragma once
+
+/*
+ * C interface for embedding either backend into another simulator, from any language with a C FFI.
+ *
+ * Transfers are submitted and their completions drained in flat arrays owned by the caller,
+ * one call per batch, so the caller neither compiles against the C++ headers nor allocates per transfer.
+ * A simulation is driven by:
+ *   - ana_send_batch(), injecting transfers at the current time,
+ *   - ana_advance_until(), simulating up to a given time,
+ *   - ana_poll_completions(), draining the transfers completed so far, in completion time order.
+ *
+ * Each backend library (Analytical_Congestion_Aware, Analytical_Congestion_Unaware) implements the interface,
+ * so a program links against one of them. The congestion-aware backend simulates contention between transfers,
+ * while the congestion-unaware one completes each transfer after its closed-form delay.
+ * A simulation is used by one thread at a time.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** opaque simulation */
+typedef struct ana_sim ana_sim;
+
+/** transfer to simulate */
+typedef struct ana_transfer {
+    /** src NPU id */
+    int32_t src;
+
+    /** dest NPU id */
+    int32_t dest;
+
+    /** size of the transfer in bytes */
+    uint64_t size;
+
+    /** id given back on completion */
+    uint64_t tag;
+} ana_transfer;
+
+/** completed transfer */
+typedef struct ana_completion {
+    /** tag of the transfer */
+    uint64_t tag;
+
+    /** time when the transfer arrived at its dest, in ns */
+    uint64_t time;
+} ana_completion;
+
+/** success */
+#define ANA_OK 0
+
+/** invalid argument (e.g., an NPU out of range, or an empty transfer), nothing was done */
+#define ANA_ERROR_INVALID_ARGUMENT (-1)
+
+/**
+ * Create a simulation of a network described by the network config (YAML) at config_path, at time 0.
+ * Exits the program if the config is invalid, as the C++ interface does.
+ *
+ * @param config_path path to the network config
+ * @return simulation, NULL if config_path is NULL
+ */
+ana_sim* ana_sim_create(const char* config_path);
+
+/**
+ * Destroy a simulation. Transfers in flight are dropped.
+ *
+ * @param sim simulation, NULL for a no-op
+ */
+void ana_sim_destroy(ana_sim* sim);
+
+/**
+ * Get the number of NPUs of the network.
+ *
+ * @param sim simulation
+ * @return number of NPUs
+ */
+int32_t ana_get_npus_count(const ana_sim* sim);
+
+/**
+ * Get the current time of the simulation.
+ *
+ * @param sim simulation
+ * @return current time in ns
+ */
+uint64_t ana_get_current_time(const ana_sim* sim);
+
+/**
+ * Inject transfers at the current time. Transfers from an NPU to itself complete at once.
+ * Every transfer is checked first, so either all of them are injected or none.
+ *
+ * @param sim simulation
+ * @param transfers transfers to inject
+ * @param count number of transfers
+ * @return ANA_OK, or ANA_ERROR_INVALID_ARGUMENT if a transfer is invalid
+ */
+int ana_send_batch(ana_sim* sim, const ana_transfer* transfers, size_t count);
+
+/**
+ * Simulate every event at or before end_time, then advance the current time to end_time.
+ * The current time never goes back, so an end_time in the past is a no-op.
+ *
+ * @param sim simulation
+ * @param end_time time to advance to, in ns
+ * @return current time afterwards
+ */
+uint64_t ana_advance_until(ana_sim* sim, uint64_t end_time);
+
+/**
+ * Get the time of the next pending event, e.g., to advance an event-driven caller straight to it.
+ *
+ * @param sim simulation
+ * @param next_time time of the next event, written if one exists
+ * @return 1 if an event is pending, 0 otherwise
+ */
+int ana_get_next_event_time(const ana_sim* sim, uint64_t* next_time);
+
+/**
+ * Drain the transfers completed so far, oldest first.
+ * Completions that don't fit stay for the next call.
+ *
+ * @param sim simulation
+ * @param completions array the completions are written to
+ * @param capacity number of completions the array holds
+ * @return number of completions written
+ */
+size_t ana_poll_completions(ana_sim* sim, ana_completion* completions, size_t capacity);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,125 @@
+/******************************************************************************
+This source code is licensed under the MIT license found in the
+LICENSE file in the root directory of this source tree.
+*******************************************************************************/
+
+#pragma once
+
+#include <array>
+#include <cassert>
+#include <cstdint>
+
+namespace NetworkAnalytical {
+
+/**
+ * CounterRng is a counter-based random number generator (Philox4x32-10),
+ * used by topologies to draw random routes.
+ *
+ * A stream is keyed by (seed, src, dest, flow id), and each of its words is a pure function of the key and its index,
+ * so routes don't depend on which thread draws them or on what was drawn before,
+ * and a stream is recreated for each route at the cost of a few multiplications.
+ * Within a seed, distinct (src, dest, flow id) keys give distinct streams.
+ *
+ * It satisfies UniformRandomBitGenerator, but uniform() should be preferred to std::uniform_int_distribution,
+ * whose output differs across standard libraries.
+ */
+class CounterRng {
+  public:
+    using result_type = uint32_t;
+
+    /// 128-bit counter, or output block
+    using Block = std::array<uint32_t, 4>;
+
+    /// 64-bit key
+    using Key = std::array<uint32_t, 2>;
+
+    /**
+     * Constructor.
+     *
+     * @param seed seed of the run
+     * @param src src id of the stream
+     * @param dest dest id of the stream
+     * @param flow_id flow id of the stream
+     */
+    CounterRng(const uint64_t seed, const uint32_t src, const uint32_t dest, const uint64_t flow_id) noexcept
+        : key({static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32) ^ static_cast<uint32_t>(flow_id >> 32)}),
+          counter({0, src, dest, static_cast<uint32_t>(flow_id)}),
+          block(),
+          index(4) {}
+
+    /**
+     * Draw the next word of the stream.
+     *
+     * @return random word
+     */
+    result_type operator()() noexcept {
+        if (index == 4) {
+            block = philox(counter, key);
+            counter[0]++;
+            index = 0;
+        }
+        return block[index++];
+    }
+
+    /**
+     * Draw an integer uniformly from [0, bound), without bias.
+     *
+     * @param bound number of possible values
+     * @return random integer in [0, bound)
+     */
+    [[nodiscard]] uint32_t uniform(const uint32_t bound) noexcept {
+        assert(bound > 0);
+
+        // multiply-shift, rejecting the few products that would bias the low values
+        auto product = static_cast<uint64_t>((*this)()) * bound;
+        if (static_cast<uint32_t>(product) < bound) {
+            const auto threshold = static_cast<uint32_t>(-bound) % bound;
+            while (static_cast<uint32_t>(product) < threshold) {
+                product = static_cast<uint64_t>((*this)()) * bound;
+            }
+        }
+        return static_cast<uint32_t>(product >> 32);
+    }
+
+    [[nodiscard]] static constexpr result_type min() noexcept {
+        return 0;
+    }
+
+    [[nodiscard]] static constexpr result_type max() noexcept {
+        return UINT32_MAX;
+    }
+
+    /**
+     * Compute the Philox4x32-10 block of a counter.
+     *
+     * @param counter counter to encrypt
+     * @param key key to encrypt with
+     * @return random block
+     */
+    [[nodiscard]] static Block philox(Block counter, Key key) noexcept {
+        for (auto round = 0; round < 10; round++) {
+            const auto product_0 = static_cast<uint64_t>(0xD2511F53U) * counter[0];
+            const auto product_1 = static_cast<uint64_t>(0xCD9E8D57U) * counter[2];
+            counter = {static_cast<uint32_t>(product_1 >> 32) ^ counter[1] ^ key[0], static_cast<uint32_t>(product_1),
+                       static_cast<uint32_t>(product_0 >> 32) ^ counter[3] ^ key[1], static_cast<uint32_t>(product_0)};
+            key[0] += 0x9E3779B9U;
+            key[1] += 0xBB67AE85U;
+        }
+        return counter;
+    }
+
+  private:
+    /// key of the stream
+    Key key;
+
+    /// counter of the next block, the first word indexing the blocks of the stream
+    Block counter;
+
+    /// current block
+    Block block;
+
+    /// index of the next word of the current block, 4 once it's used up
+    int index;
+};
+
+}  // namespace NetworkAnalytical
@@ -0,0 +1,103 @@
+/******************************************************************************
+This source code is licensed under the MIT license found in the
+LICENSE file in the root directory of this source tree.
+*******************************************************************************/
+
+#pragma once
+
+#include "common/Type.h"
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace NetworkAnalytical {
+
+/**
+ * CsrGraph is an immutable graph in compressed sparse row form:
+ * the neighbors of every node are stored back-to-back in a single array,
+ * and node v's neighbors are neighbors[offsets[v], offsets[v + 1]).
+ *
+ * Graph topologies build it once and share it by const reference,
+ * so searches (BFS, k-shortest paths, all-pairs distances) scan contiguous memory.
+ * The position of a neighbor in the array identifies the directed edge towards it.
+ */
+class CsrGraph {
+  public:
+    /// range [first, last) of neighbor ids
+    using NeighborRange = std::pair<const DeviceId*, const DeviceId*>;
+
+    /**
+     * Construct an empty graph.
+     */
+    CsrGraph() noexcept;
+
+    /**
+     * Construct a graph from an adjacency list, keeping the neighbor order.
+     * Node ids should be 0, 1, ..., (number of keys - 1).
+     *
+     * @param adjacency_list map[node id] -> neighbor node ids
+     */
+    explicit CsrGraph(const std::map<DeviceId, std::vector<DeviceId>>& adjacency_list) noexcept;
+
+    /**
+     * Construct a graph from undirected edges, each listed once.
+     * Every edge is added in both directions, and each node lists its neighbors in edge order.
+     *
+     * @param nodes_count number of nodes
+     * @param edges undirected edges
+     */
+    CsrGraph(int nodes_count, const std::vector<std::pair<DeviceId, DeviceId>>& edges) noexcept;
+
+    /**
+     * Get the number of nodes.
+     *
+     * @return number of nodes
+     */
+    [[nodiscard]] int get_nodes_count() const noexcept;
+
+    /**
+     * Get the number of directed edges.
+     *
+     * @return number of directed edges
+     */
+    [[nodiscard]] int get_edges_count() const noexcept;
+
+    /**
+     * Get the number of neighbors of a node.
+     *
+     * @param node node id
+     * @return degree of the node
+     */
+    [[nodiscard]] int get_degree(DeviceId node) const noexcept;
+
+    /**
+     * Get the neighbors of a node.
+     *
+     * @param node node id
+     * @return neighbor ids of the node
+     */
+    [[nodiscard]] NeighborRange get_neighbors(DeviceId node) const noexcept;
+
+    /**
+     * Get the offsets array: node v's edges are [offsets[v], offsets[v + 1]).
+     *
+     * @return offsets of every node, plus the total number of edges
+     */
+    [[nodiscard]] const std::vector<int>& get_offsets() const noexcept;
+
+    /**
+     * Get the neighbors array, indexed by edge.
+     *
+     * @return neighbor id of every edge
+     */
+    [[nodiscard]] const std::vector<DeviceId>& get_edge_targets() const noexcept;
+
+  private:
+    /// node v's edges are [offsets[v], offsets[v + 1])
+    std::vector<int> offsets;
+
+    /// neighbor id of every edge
+    std::vector<DeviceId> edge_targets;
+};
+
+}  // namespace NetworkAnalytical
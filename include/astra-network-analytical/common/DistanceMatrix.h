@@ -0,0 +1,117 @@
+/******************************************************************************
+This source code is licensed under the MIT license found in the
+LICENSE file in the root directory of this source tree.
+*******************************************************************************/
+
+#pragma once
+
+#include "common/CsrGraph.h"
+#include "common/MemoryCounter.h"
+#include "common/Type.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace NetworkAnalytical {
+
+/**
+ * DistanceMatrix holds the hop count between every pair of nodes of an unweighted graph.
+ *
+ * All pairs are computed at once by a bit-parallel BFS:
+ * each node keeps one bit per source in a word-sized frontier,
+ * so a single pass over the edges advances the BFS of many sources by one level,
+ * with plain bitwise operations the compiler can vectorize.
+ * Passes of different sources run on a pool of threads.
+ *
+ * The matrix is immutable, so copies share it. It can be saved to a binary file
+ * and memory-mapped back, so later runs (and concurrent processes) share it through the page cache.
+ */
+class DistanceMatrix {
+  public:
+    /// distance of a pair with no path
+    static constexpr uint8_t unreachable_distance = UINT8_MAX;
+
+    /**
+     * Construct an empty matrix.
+     */
+    DistanceMatrix() noexcept;
+
+    /**
+     * Compute the distances of every pair of nodes.
+     *
+     * @param graph graph to compute the distances of
+     * @param threads_count number of threads, 0 to use the hardware concurrency
+     * @param memory_counter counter of the memory held by the matrix, nullptr for none
+     */
+    explicit DistanceMatrix(const CsrGraph& graph,
+                            int threads_count = 0,
+                            std::shared_ptr<MemoryCounter> memory_counter = nullptr) noexcept;
+
+    /**
+     * Check whether the matrix has been computed.
+     *
+     * @return true if the matrix holds no distances, false otherwise
+     */
+    [[nodiscard]] bool empty() const noexcept;
+
+    /**
+     * Get the number of nodes of the graph.
+     *
+     * @return number of nodes
+     */
+    [[nodiscard]] int get_nodes_count() const noexcept;
+
+    /**
+     * Get the distance between two nodes.
+     *
+     * @param src src node id
+     * @param dest dest node id
+     * @return number of hops from src to dest, unreachable_distance if there's no path
+     */
+    [[nodiscard]] uint8_t get_distance(DeviceId src, DeviceId dest) const noexcept;
+
+    /**
+     * Save the distances to a binary file.
+     * The file is written aside and renamed into place, so it's never seen partially written.
+     *
+     * @param path path of the file
+     * @param key key identifying the graph the distances were computed on
+     * @return true if the file has been written, false otherwise
+     */
+    [[nodiscard]] bool save(const std::string& path, uint64_t key) const noexcept;
+
+    /**
+     * Map distances saved by save() into memory, read-only.
+     * Nothing is loaded if the file is missing, corrupted, or saved with another key.
+     *
+     * @param path path of the file
+     * @param key key identifying the graph the distances should have been computed on
+     * @param distance_matrix loaded distances, left untouched on failure
+     * @return true if the distances have been loaded, false otherwise
+     */
+    [[nodiscard]] static bool load(const std::string& path, uint64_t key, DistanceMatrix& distance_matrix) noexcept;
+
+    /**
+     * Check whether the distances are mapped from a file.
+     *
+     * @return true if loaded by load(), false otherwise
+     */
+    [[nodiscard]] bool is_mapped() const noexcept;
+
+  private:
+    /// number of 64-bit words of sources processed per pass
+    static constexpr int words_per_pass = 4;
+
+    /// number of nodes of the graph
+    int nodes_count;
+
+    /// distances[src * nodes_count + dest] -> number of hops from src to dest
+    /// (owning either the computed matrix or the file mapping)
+    std::shared_ptr<const uint8_t> distances;
+
+    /// whether distances are mapped from a file
+    bool mapped;
+};
+
+}  // namespace NetworkAnalytical
@@ -5,13 +5,15 @@ LICENSE file in the root directory of this source tree.
 
 #pragma once
 
+#include "common/EventCallback.h"
 #include "common/Type.h"
 #include <tuple>
 
 namespace NetworkAnalytical {
 
 /**
- * Event is a wrapper for a callback function and its argument.
+ * Event is a wrapper for a callback function and its argument,
+ * or for any small callable (see EventCallback).
  */
 class Event {
   public:
@@ -23,6 +25,13 @@ class Event {
      */
     Event(Callback callback, CallbackArg callback_arg) noexcept;
 
+    /**
+     * Constructor.
+     *
+     * @param callback callable to invoke
+     */
+    explicit Event(EventCallback callback) noexcept;
+
     /**
      * Invoke the callback function.
      */
@@ -31,16 +40,33 @@ class Event {
     /**
      * Get the callback function and the argument.
      *
-     * @return callback function and its argument
+     * @return callback function and its argument,
+     *         {nullptr, nullptr} if the event wraps another callable
      */
     [[nodiscard]] std::pair<Callback, CallbackArg> get_handler_arg() const noexcept;
 
-  private:
-    /// pointer to the callback function
-    Callback callback;
+    /**
+     * Get an id of the kind of callback of the event (see EventCallback::get_type_id).
+     *
+     * @return id of the callback type
+     */
+    [[nodiscard]] const void* get_type_id() const noexcept;
 
-    /// argument of the callback function
-    CallbackArg callback_arg;
+    /**
+     * Cancel the event, so that it is skipped instead of invoked.
+     */
+    void cancel() noexcept;
+
+    /**
+     * Check whether the event has been cancelled.
+     *
+     * @return true if the event is cancelled, false otherwise
+     */
+    [[nodiscard]] bool is_cancelled() const noexcept;
+
+  private:
+    /// callback to invoke (empty once cancelled)
+    EventCallback callback;
 };
 
 }  // namespace NetworkAnalytical
@@ -0,0 +1,213 @@
+/******************************************************************************
+This source code is licensed under the MIT license found in the
+LICENSE file in the root directory of this source tree.
+*******************************************************************************/
+
+#pragma once
+
+#include "common/Type.h"
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace NetworkAnalytical {
+
+/**
+ * EventCallback is a move-only, type-erased "void()" callable
+ * stored inline in a fixed-size buffer, so creating one never allocates.
+ *
+ * Any callable whose size fits the buffer can be stored, e.g.,
+ * a lambda owning a std::unique_ptr or a few pointers of context.
+ * The "void func(void*)" + argument pair is still supported as a special case,
+ * which invokes the function pointer directly.
+ *
+ * Trivially copyable callables (including the function pointer case)
+ * are moved with a plain memcpy.
+ */
+class EventCallback {
+  public:
+    /// size of the inline storage in bytes
+    static constexpr size_t storage_size = 32;
+
+    /**
+     * Construct an empty callback.
+     */
+    EventCallback() noexcept : invoker(nullptr), manager(nullptr) {}
+
+    /**
+     * Construct a callback from a function pointer and its argument.
+     *
+     * @param callback callback function pointer
+     * @param callback_arg argument of the callback function
+     */
+    EventCallback(const Callback callback, const CallbackArg callback_arg) noexcept
+        : invoker(&invoke_function_pointer),
+          manager(nullptr) {
+        assert(callback != nullptr);
+
+        ::new (static_cast<void*>(storage)) FunctionPointer{callback, callback_arg};
+    }
+
+    /**
+     * Construct a callback from any callable object taking no arguments.
+     *
+     * @param callable callable to store
+     */
+    template <typename Callable,
+              typename Stored = std::decay_t<Callable>,
+              typename = std::enable_if_t<!std::is_same_v<Stored, EventCallback> && std::is_invocable_v<Stored&>>>
+    EventCallback(Callable&& callable) noexcept  // NOLINT(google-explicit-constructor)
+        : invoker(&invoke_callable<Stored>),
+          manager(std::is_trivially_copyable_v<Stored> ? nullptr : &manage_callable<Stored>) {
+        static_assert(sizeof(Stored) <= storage_size, "callable doesn't fit in EventCallback storage");
+        static_assert(alignof(Stored) <= alignof(std::max_align_t), "callable is over-aligned");
+        static_assert(std::is_nothrow_move_constructible_v<Stored>, "callable should be nothrow movable");
+
+        ::new (static_cast<void*>(storage)) Stored(std::forward<Callable>(callable));
+    }
+
+    /**
+     * Move constructor.
+     */
+    EventCallback(EventCallback&& other) noexcept : invoker(other.invoker), manager(other.manager) {
+        move_storage_from(other);
+    }
+
+    /**
+     * Move assignment.
+     */
+    EventCallback& operator=(EventCallback&& other) noexcept {
+        if (this != &other) {
+            reset();
+            invoker = other.invoker;
+            manager = other.manager;
+            move_storage_from(other);
+        }
+        return *this;
+    }
+
+    EventCallback(const EventCallback&) = delete;
+    EventCallback& operator=(const EventCallback&) = delete;
+
+    /**
+     * Destructor.
+     */
+    ~EventCallback() noexcept {
+        reset();
+    }
+
+    /**
+     * Invoke the stored callable.
+     * The callback should not be empty.
+     */
+    void operator()() noexcept {
+        assert(invoker != nullptr);
+
+        invoker(storage);
+    }
+
+    /**
+     * Check whether a callable is stored.
+     *
+     * @return true if a callable is stored, false otherwise
+     */
+    explicit operator bool() const noexcept {
+        return invoker != nullptr;
+    }
+
+    /**
+     * Destroy the stored callable, leaving the callback empty.
+     */
+    void reset() noexcept {
+        if (manager != nullptr) {
+            manager(Operation::Destroy, storage, nullptr);
+        }
+        invoker = nullptr;
+        manager = nullptr;
+    }
+
+    /**
+     * Get the function pointer and argument this callback was constructed from.
+     *
+     * @return function pointer and its argument, {nullptr, nullptr} if another callable is stored
+     */
+    [[nodiscard]] std::pair<Callback, CallbackArg> get_function_pointer() const noexcept {
+        if (invoker != &invoke_function_pointer) {
+            return {nullptr, nullptr};
+        }
+
+        const auto* const function_pointer = std::launder(reinterpret_cast<const FunctionPointer*>(storage));
+        return {function_pointer->callback, function_pointer->callback_arg};
+    }
+
+    /**
+     * Get an id of the kind of callback stored:
+     * the function pointer for callbacks constructed from one, an id of the callable's type otherwise.
+     *
+     * @return id of the callback type, nullptr if empty
+     */
+    [[nodiscard]] const void* get_type_id() const noexcept {
+        if (invoker == &invoke_function_pointer) {
+            return reinterpret_cast<const void*>(
+                std::launder(reinterpret_cast<const FunctionPointer*>(storage))->callback);
+        }
+        return reinterpret_cast<const void*>(invoker);
+    }
+
+  private:
+    /// "void func(void*)" and its argument
+    struct FunctionPointer {
+        Callback callback;
+        CallbackArg callback_arg;
+    };
+
+    /// operations of the manager
+    enum class Operation { Move, Destroy };
+
+    /// inline storage of the callable
+    alignas(std::max_align_t) unsigned char storage[storage_size];
+
+    /// invokes the stored callable
+    void (*invoker)(void*) noexcept;
+
+    /// moves or destroys the stored callable, nullptr if it is trivially copyable
+    void (*manager)(Operation, void*, void*) noexcept;
+
+    static void invoke_function_pointer(void* const storage) noexcept {
+        const auto* const function_pointer = std::launder(reinterpret_cast<FunctionPointer*>(storage));
+        (*function_pointer->callback)(function_pointer->callback_arg);
+    }
+
+    template <typename Stored>
+    static void invoke_callable(void* const storage) noexcept {
+        (*std::launder(reinterpret_cast<Stored*>(storage)))();
+    }
+
+    template <typename Stored>
+    static void manage_callable(const Operation operation, void* const dest, void* const src) noexcept {
+        auto* const src_callable = std::launder(reinterpret_cast<Stored*>(src != nullptr ? src : dest));
+        if (operation == Operation::Move) {
+            ::new (dest) Stored(std::move(*src_callable));
+            src_callable->~Stored();
+        } else {
+            src_callable->~Stored();
+        }
+    }
+
+    void move_storage_from(EventCallback& other) noexcept {
+        if (manager != nullptr) {
+            manager(Operation::Move, storage, other.storage);
+        } else if (invoker != nullptr) {
+            std::memcpy(storage, other.storage, storage_size);
+        }
+
+        // the source has been consumed
+        other.invoker = nullptr;
+        other.manager = nullptr;
+    }
+};
+
+}  // namespace NetworkAnalytical
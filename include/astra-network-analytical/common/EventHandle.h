@@ -0,0 +1,34 @@
+/******************************************************************************
+This source code is licensed under the MIT license found in the
+LICENSE file in the root directory of this source tree.
+*******************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace NetworkAnalytical {
+
+class EventList;
+
+/**
+ * EventHandle identifies a scheduled event so that it can be cancelled.
+ *
+ * A handle refers to a slot of a (recycled) EventList.
+ * The generation of the list is recorded as well,
+ * so a handle outliving its event is detected as stale rather than
+ * cancelling an unrelated event that reuses the slot.
+ */
+struct EventHandle {
+    /// EventList holding the event, nullptr for an empty handle
+    EventList* event_list = nullptr;
+
+    /// generation of the EventList when the event was scheduled
+    uint64_t generation = 0;
+
+    /// index of the event inside the EventList
+    size_t event_index = 0;
+};
+
+}  // namespace NetworkAnalytical
@@ -6,13 +6,22 @@ LICENSE file in the root directory of this source tree.
 #pragma once
 
 #include "common/Event.h"
+#include "common/EventQueueStats.h"
+#include "common/MemoryCounter.h"
 #include "common/Type.h"
-#include <list>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
 
 namespace NetworkAnalytical {
 
 /**
  * EventList encapsulates a number of Events along with its event time.
+ *
+ * Events are stored contiguously and invoked in insertion order.
+ * An EventList can be recycled through reset(),
+ * which keeps the event storage so that reused lists don't allocate.
+ * Each reset() bumps the generation of the list, which invalidates outstanding EventHandles.
  */
 class EventList {
   public:
@@ -20,8 +29,9 @@ class EventList {
      * Constructor.
      *
      * @param event_time event time of the event list
+     * @param memory_counter counter of the memory held by the events, nullptr for none
      */
-    explicit EventList(EventTime event_time) noexcept;
+    explicit EventList(EventTime event_time, std::shared_ptr<MemoryCounter> memory_counter = nullptr) noexcept;
 
     /**
      * Get the registered event time.
@@ -30,25 +40,96 @@ class EventList {
      */
     [[nodiscard]] EventTime get_event_time() const noexcept;
 
+    /**
+     * Get the generation of the event list.
+     *
+     * @return number of times the list has been reset
+     */
+    [[nodiscard]] uint64_t get_generation() const noexcept;
+
     /**
      * Register an event into the event list.
      *
      * @param callback callback function pointer
      * @param callback_arg argument of the callback function
+     * @return index of the registered event
+     */
+    size_t add_event(Callback callback, CallbackArg callback_arg) noexcept;
+
+    /**
+     * Register an event into the event list.
+     *
+     * @param callback callable to invoke
+     * @return index of the registered event
      */
-    void add_event(Callback callback, CallbackArg callback_arg) noexcept;
+    size_t add_event(EventCallback callback) noexcept;
 
     /**
-     * Invoke all events in the event list.
+     * Register a number of events into the event list, preserving their order.
+     *
+     * @param handlers callback functions and their arguments
+     */
+    void add_events(const std::vector<std::pair<Callback, CallbackArg>>& handlers) noexcept;
+
+    /**
+     * Invoke all events in the event list, skipping cancelled ones.
+     * Events added while invoking are invoked as well.
+     *
+     * @return number of invoked events
+     */
+    size_t invoke_events() noexcept;
+
+    /**
+     * Cancel a registered event that hasn't been invoked yet.
+     *
+     * @param event_index index of the event
+     * @return true if the event got cancelled, false if it was already invoked or cancelled
      */
-    void invoke_events() noexcept;
+    bool cancel_event(size_t event_index) noexcept;
+
+    /**
+     * Check whether the list still holds an event to invoke.
+     *
+     * @return true if some event is neither invoked nor cancelled, false otherwise
+     */
+    [[nodiscard]] bool has_pending_events() const noexcept;
+
+    /**
+     * Drop every registered event and re-target the list to a new event time.
+     * The storage of the dropped events is kept for reuse.
+     *
+     * @param new_event_time new event time of the event list
+     */
+    void reset(EventTime new_event_time) noexcept;
 
   private:
     /// event time of the event list
     EventTime event_time;
 
-    /// list of registered events
-    std::list<Event> events;
+    /// registered events, in insertion order
+    TrackedVector<Event> events;
+
+    /// index of the next event to invoke
+    size_t next_event_index;
+
+    /// number of events neither invoked nor cancelled
+    size_t pending_events_count;
+
+    /// number of times the list has been reset
+    uint64_t generation;
+
+#ifdef ASTRA_NET_STATS
+    /// statistics of the owning queue, nullptr if not counted
+    EventQueueStats* stats;
+
+  public:
+    /**
+     * Count the invoked events into the statistics of the owning queue.
+     *
+     * @param stats statistics of the owning queue
+     */
+    void set_stats(EventQueueStats* stats) noexcept;
+#endif
 };
 
 }  // namespace NetworkAnalytical
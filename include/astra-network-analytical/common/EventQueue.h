@@ -5,13 +5,33 @@ LICENSE file in the root directory of this source tree.
 
 #pragma once
 
+#include "common/EventHandle.h"
 #include "common/EventList.h"
+#include "common/EventQueueStats.h"
+#include "common/EventTimeHeap.h"
+#include "common/MemoryCounter.h"
 #include "common/Type.h"
+#include <deque>
+#include <memory>
+#include <unordered_map>
+#include <vector>
 
 namespace NetworkAnalytical {
 
 /**
  * EventQueue manages scheduled EventLists.
+ *
+ * Each distinct event time owns one EventList, so events sharing a timestamp
+ * are invoked in the order they were scheduled (FIFO).
+ * Pending event times are kept in a 4-ary heap,
+ * so scheduling an event costs O(1) for an already-pending time
+ * and O(log T) for a new one, where T is the number of pending timestamps.
+ *
+ * EventLists are carved out of a slab owned by the queue and recycled
+ * once processed, so a steady-state simulation doesn't allocate per event.
+ *
+ * Scheduled events can be cancelled in O(1) through their EventHandle.
+ * Timestamps left with only cancelled events are dropped without advancing the current time.
  */
 class EventQueue {
   public:
@@ -20,6 +40,13 @@ class EventQueue {
      */
     EventQueue() noexcept;
 
+    /**
+     * Drop every pending event and rewind the time to 0, to run another simulation on the queue.
+     * Event lists are kept for reuse, and handles to the dropped events are invalidated.
+     * Events held by defer_events() are dropped too, ending the deferral.
+     */
+    void reset() noexcept;
+
     /**
      * Get current event time of the event queue.
      *
@@ -35,6 +62,14 @@ class EventQueue {
      */
     [[nodiscard]] bool finished() const noexcept;
 
+    /**
+     * Get the earliest event time registered in the event queue.
+     * The event queue should not be empty.
+     *
+     * @return next event time
+     */
+    [[nodiscard]] EventTime get_next_event_time() const noexcept;
+
     /**
      * Proceed the event queue.
      * i.e., first update the current event time to the next registered event
@@ -43,21 +78,180 @@ class EventQueue {
      */
     void proceed() noexcept;
 
+    /**
+     * Run the event queue until no event is left.
+     */
+    void run() noexcept;
+
+    /**
+     * Run the event queue until every event registered at or before end_time is invoked.
+     * Afterwards, the current time is advanced to end_time (if it is not past it already).
+     *
+     * @param end_time time to run until (inclusive)
+     */
+    void run_until(EventTime end_time) noexcept;
+
+    /**
+     * Run the event queue until at least events_count events are invoked or no event is left.
+     * Event times are processed as a whole, so the run stops at the first time boundary
+     * after events_count events were invoked.
+     *
+     * @param events_count number of events to invoke
+     * @return number of events actually invoked
+     */
+    size_t run_for(size_t events_count) noexcept;
+
     /**
      * Schedule an event with a given event time.
      *
      * @param event_time time of event
      * @param callback callback function pointer
      * @param callback_arg argument of the callback function
+     * @return handle to cancel the event
+     */
+    EventHandle schedule_event(EventTime event_time, Callback callback, CallbackArg callback_arg) noexcept;
+
+    /**
+     * Schedule an event with a given event time.
+     *
+     * @param event_time time of event
+     * @param callback callable to invoke, e.g., a lambda with up to 32 bytes of captures
+     * @return handle to cancel the event
+     */
+    EventHandle schedule_event(EventTime event_time, EventCallback callback) noexcept;
+
+    /**
+     * Schedule an event invoked once every event of the current time is,
+     * e.g., to hand over at once what the events of the time gathered.
+     * Events scheduled at the current time meanwhile (including by time-end events) are invoked before it.
+     * Should be called from an event callback, i.e., while the queue processes the current time.
+     *
+     * @param callback callable to invoke
+     */
+    void schedule_time_end_event(EventCallback callback) noexcept;
+
+    /**
+     * Cancel a scheduled event, so that its callback is never invoked.
+     * Cancelling an event that was already invoked or cancelled, or through an empty handle, is a no-op.
+     *
+     * @param event_handle handle returned by schedule_event
+     * @return true if the event got cancelled, false otherwise
+     */
+    bool cancel_event(const EventHandle& event_handle) noexcept;
+
+    /**
+     * Schedule a number of events with the same event time.
+     * Equivalent to calling schedule_event for each handler in order,
+     * but the EventList is looked up only once.
+     *
+     * @param event_time time of events
+     * @param handlers callback functions and their arguments
+     */
+    void schedule_events(EventTime event_time,
+                         const std::vector<std::pair<Callback, CallbackArg>>& handlers) noexcept;
+
+    /**
+     * Hold the events scheduled from now on until flush_deferred_events(),
+     * e.g., while injecting a batch of chunks whose events fall on a few distinct times.
+     * Deferred events get an empty handle, so they can't be cancelled.
+     */
+    void defer_events() noexcept;
+
+    /**
+     * Schedule the deferred events grouped by their time (see schedule_events()):
+     * the EventList of each distinct time is looked up once, and events of a time keep their order.
      */
-    void schedule_event(EventTime event_time, Callback callback, CallbackArg callback_arg) noexcept;
+    void flush_deferred_events() noexcept;
+
+    /**
+     * Get the memory held by the queue: its event times, event lists and events.
+     *
+     * @return counter of the memory held by the queue
+     */
+    [[nodiscard]] const MemoryCounter& get_memory_counter() const noexcept;
+
+#ifdef ASTRA_NET_STATS
+    /**
+     * Get the statistics of the queue since its construction or last reset().
+     *
+     * @return statistics of the queue
+     */
+    [[nodiscard]] const EventQueueStats& get_stats() const noexcept;
+#endif
 
   private:
     /// current time of the event queue
     EventTime current_time;
 
-    /// list of EventLists
-    std::list<EventList> event_queue;
+    /// memory held by the containers of the queue
+    std::shared_ptr<MemoryCounter> memory_counter;
+
+#ifdef ASTRA_NET_STATS
+    /// statistics of the queue
+    EventQueueStats stats;
+#endif
+
+    /// pending event times, ordered by a min-heap
+    EventTimeHeap event_times;
+
+    /// map[event time] -> EventList registered at that time
+    std::unordered_map<EventTime,
+                       EventList*,
+                       std::hash<EventTime>,
+                       std::equal_to<EventTime>,
+                       TrackingAllocator<std::pair<const EventTime, EventList*>>>
+        event_lists;
+
+    /// slab holding every EventList ever created by this queue
+    /// (std::deque keeps the addresses stable while growing)
+    std::deque<EventList, TrackingAllocator<EventList>> event_list_slab;
+
+    /// processed EventLists ready to be reused
+    TrackedVector<EventList*> free_event_lists;
+
+    /// events to invoke once the current time has no event left
+    TrackedVector<EventCallback> time_end_events;
+
+    /// time-end events being invoked (kept to reuse its storage)
+    TrackedVector<EventCallback> invoking_time_end_events;
+
+    /// whether scheduled events are held until flush_deferred_events()
+    bool deferring;
+
+    /// events held by defer_events(), in scheduling order
+    TrackedVector<std::pair<EventTime, EventCallback>> deferred_events;
+
+    /**
+     * Get an EventList for the given event time,
+     * reusing a processed one when available.
+     *
+     * @param event_time event time of the list
+     * @return pointer to the EventList
+     */
+    [[nodiscard]] EventList* acquire_event_list(EventTime event_time) noexcept;
+
+    /**
+     * Invoke every event at the next event time.
+     * The next event should exist.
+     *
+     * @return number of invoked events
+     */
+    size_t process_next_event_list() noexcept;
+
+    /**
+     * Drop the leading event times which only hold cancelled events,
+     * so that the earliest registered time always has an event to invoke.
+     */
+    void drop_cancelled_event_lists() noexcept;
+
+    /**
+     * Get the EventList registered at the given time,
+     * registering a new one if none exists.
+     *
+     * @param event_time event time of the list
+     * @return pointer to the EventList
+     */
+    [[nodiscard]] EventList* find_or_create_event_list(EventTime event_time) noexcept;
 };
 
 }  // namespace NetworkAnalytical
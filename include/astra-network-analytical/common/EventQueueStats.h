@@ -0,0 +1,36 @@
+/******************************************************************************
+This source code is licensed under the MIT license found in the
+LICENSE file in the root directory of this source tree.
+*******************************************************************************/
+
+#pragma once
+
+#ifdef ASTRA_NET_STATS
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+
+namespace NetworkAnalytical {
+
+/**
+ * EventQueueStats counts the work of an event queue.
+ * Only compiled in with the ASTRA_NET_STATS CMake option.
+ */
+struct EventQueueStats {
+    /// number of invoked events
+    uint64_t events_count = 0;
+
+    /// number of processed event times
+    uint64_t event_times_count = 0;
+
+    /// largest number of events invoked at a single event time
+    size_t max_event_list_length = 0;
+
+    /// map[callback type (see EventCallback::get_type_id)] -> number of invoked events
+    std::unordered_map<const void*, uint64_t> callback_counts;
+};
+
+}  // namespace NetworkAnalytical
+
+#endif
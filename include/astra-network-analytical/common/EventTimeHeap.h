@@ -0,0 +1,95 @@
+/******************************************************************************
+This source code is licensed under the MIT license found in the
+LICENSE file in the root directory of this source tree.
+*******************************************************************************/
+
+#pragma once
+
+#include "common/MemoryCounter.h"
+#include "common/Type.h"
+#include <cstddef>
+#include <vector>
+
+namespace NetworkAnalytical {
+
+/**
+ * EventTimeHeap is a 4-ary min-heap of distinct event times.
+ * EventQueue uses it to find the earliest pending timestamp in O(1)
+ * and to register or drop a timestamp in O(log_4 N).
+ *
+ * A 4-ary layout keeps the children of a node in one cache line,
+ * which makes sift-down cheaper than in a binary heap.
+ */
+class EventTimeHeap {
+  public:
+    /**
+     * Constructor.
+     *
+     * @param memory_counter counter of the memory held by the heap, nullptr for none
+     */
+    explicit EventTimeHeap(std::shared_ptr<MemoryCounter> memory_counter = nullptr) noexcept;
+
+    /**
+     * Check whether the heap is empty.
+     *
+     * @return true if no event time is registered, false otherwise
+     */
+    [[nodiscard]] bool empty() const noexcept;
+
+    /**
+     * Get the number of registered event times.
+     *
+     * @return number of registered event times
+     */
+    [[nodiscard]] size_t size() const noexcept;
+
+    /**
+     * Get the earliest registered event time.
+     * The heap should not be empty.
+     *
+     * @return earliest event time
+     */
+    [[nodiscard]] EventTime top() const noexcept;
+
+    /**
+     * Register an event time.
+     * The caller is responsible for not registering the same time twice.
+     *
+     * @param event_time event time to register
+     */
+    void push(EventTime event_time) noexcept;
+
+    /**
+     * Drop the earliest registered event time.
+     * The heap should not be empty.
+     */
+    void pop() noexcept;
+
+    /**
+     * Drop every registered event time.
+     */
+    void clear() noexcept;
+
+  private:
+    /// number of children per heap node
+    static constexpr size_t arity = 4;
+
+    /// heap-ordered event times
+    TrackedVector<EventTime> heap;
+
+    /**
+     * Move the element at the given index up until the heap property holds.
+     *
+     * @param index index of the element to move
+     */
+    void sift_up(size_t index) noexcept;
+
+    /**
+     * Move the element at the given index down until the heap property holds.
+     *
+     * @param index index of the element to move
+     */
+    void sift_down(size_t index) noexcept;
+};
+
+}  // namespace NetworkAnalytical
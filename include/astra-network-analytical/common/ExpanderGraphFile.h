@@ -0,0 +1,122 @@
+/******************************************************************************
+This source code is licensed under the MIT license found in the
+LICENSE file in the root directory of this source tree.
+*******************************************************************************/
+
+#pragma once
+
+#include "common/Type.h"
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace NetworkAnalytical {
+
+/**
+ * ExpanderGraphFile holds the graph of an ExpanderGraph input file:
+ * its node count and degree, group A, and the rows of the connected and split adjacency lists,
+ * each packed back-to-back in a single array.
+ *
+ * JSON files are parsed in a single streaming pass, keeping only those fields,
+ * so no document is held in memory. The same fields can be saved to a compact binary edge-list file
+ * (".egbin"), which loads with plain reads; load() tells the formats apart by their content.
+ */
+class ExpanderGraphFile {
+  public:
+    /// undirected edge, lower node id first
+    using Edge = std::pair<DeviceId, DeviceId>;
+
+    /**
+     * Construct an empty graph.
+     */
+    ExpanderGraphFile() noexcept;
+
+    /**
+     * Load an ExpanderGraph input file, either JSON or saved by save().
+     *
+     * @param path path of the file
+     * @param graph_file loaded graph, left untouched on failure
+     * @return true if the file has been loaded, false if it's missing or malformed
+     */
+    [[nodiscard]] static bool load(const std::string& path, ExpanderGraphFile& graph_file) noexcept;
+
+    /**
+     * Save the graph as a binary edge-list file.
+     *
+     * @param path path of the file
+     * @return true if the file has been written, false otherwise
+     */
+    [[nodiscard]] bool save(const std::string& path) const noexcept;
+
+    /**
+     * Get the number of nodes of the file's graph.
+     *
+     * @return node count
+     */
+    [[nodiscard]] int get_node_count() const noexcept;
+
+    /**
+     * Get the degree of the file's graph.
+     *
+     * @return degree
+     */
+    [[nodiscard]] int get_degree() const noexcept;
+
+    /**
+     * Get the edges of the connected graph, each once, in file order.
+     *
+     * @return edges of the connected graph
+     */
+    [[nodiscard]] std::vector<Edge> get_connected_graph_edges() const noexcept;
+
+    /**
+     * Get the edges of the split graph between the nodes of group A, each once, in file order.
+     * Nodes are renumbered by their position in group A.
+     *
+     * @return edges of group A's split graph
+     */
+    [[nodiscard]] std::vector<Edge> get_split_graph_edges() const noexcept;
+
+  private:
+    /// number of nodes of the graph
+    int node_count;
+
+    /// degree of the graph
+    int degree;
+
+    /// nodes of group A
+    std::vector<DeviceId> group_a;
+
+    /// row v of connected_graph_adjacency is connected_neighbors[connected_offsets[v], connected_offsets[v + 1])
+    std::vector<int> connected_offsets;
+
+    /// neighbors of every row of connected_graph_adjacency
+    std::vector<DeviceId> connected_neighbors;
+
+    /// row v of split_graph_adjacency is split_neighbors[split_offsets[v], split_offsets[v + 1])
+    std::vector<int> split_offsets;
+
+    /// neighbors of every row of split_graph_adjacency
+    std::vector<DeviceId> split_neighbors;
+
+    /**
+     * Collect the edges of an adjacency list between the selected nodes, each once.
+     *
+     * @param offsets row offsets of the adjacency list
+     * @param neighbors neighbors of every row
+     * @param remap remap[node] -> id of the node in the graph, -1 to skip it
+     * @return edges between the selected nodes
+     */
+    [[nodiscard]] static std::vector<Edge> collect_edges(const std::vector<int>& offsets,
+                                                         const std::vector<DeviceId>& neighbors,
+                                                         const std::vector<DeviceId>& remap) noexcept;
+
+    /**
+     * Check the parsed fields are consistent.
+     *
+     * @return true if every field is consistent, false otherwise
+     */
+    [[nodiscard]] bool valid() const noexcept;
+};
+
+}  // namespace NetworkAnalytical
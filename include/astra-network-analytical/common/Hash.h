@@ -0,0 +1,33 @@
+/******************************************************************************
+This source code is licensed under the MIT license found in the
+LICENSE file in the root directory of this source tree.
+*******************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace NetworkAnalytical {
+
+/// FNV-1a offset basis, the hash of no bytes
+constexpr uint64_t hash_bytes_basis = 14695981039346656037ULL;
+
+/**
+ * FNV-1a hash of a byte range, continuing from the given hash.
+ * Used to key the files topologies cache their precomputed tables in.
+ *
+ * @param bytes first byte of the range
+ * @param size number of bytes of the range
+ * @param hash hash to continue from
+ * @return hash of the range
+ */
+inline uint64_t hash_bytes(const char* const bytes, const size_t size, uint64_t hash = hash_bytes_basis) noexcept {
+    for (auto i = static_cast<size_t>(0); i < size; i++) {
+        hash ^= static_cast<unsigned char>(bytes[i]);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+}  // namespace NetworkAnalytical
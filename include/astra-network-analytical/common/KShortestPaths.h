@@ -0,0 +1,133 @@
+/******************************************************************************
+This source code is licensed under the MIT license found in the
+LICENSE file in the root directory of this source tree.
+*******************************************************************************/
+
+#pragma once
+
+#include "common/CsrGraph.h"
+#include "common/Type.h"
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace NetworkAnalytical {
+
+/**
+ * KShortestPaths holds up to k loopless shortest paths between every pair of endpoints
+ * of an unweighted graph, found with Yen's algorithm.
+ *
+ * All pairs are computed at once, one source per task across a pool of threads,
+ * over the CSR graph, with banned nodes and edges marked in place.
+ * The paths are packed in a single arena of node ids,
+ * and can be saved to / loaded from a binary file so later runs skip the computation.
+ */
+class KShortestPaths {
+  public:
+    /// range [first, last) of the node ids of a path
+    using PathRange = std::pair<const uint16_t*, const uint16_t*>;
+
+    /**
+     * Construct an empty set of paths.
+     */
+    KShortestPaths() noexcept;
+
+    /**
+     * Compute the k shortest paths between every pair of endpoints.
+     * Edges should be listed in both directions.
+     * Endpoints are the nodes 0, 1, ..., (endpoints_count - 1).
+     *
+     * @param graph graph to find the paths in
+     * @param endpoints_count number of endpoints
+     * @param k maximum number of paths per pair
+     * @param threads_count number of threads, 0 to use the hardware concurrency
+     */
+    KShortestPaths(const CsrGraph& graph,
+                   int endpoints_count,
+                   int k,
+                   int threads_count = 0) noexcept;
+
+    /**
+     * Check whether paths have been computed or loaded.
+     *
+     * @return true if no paths are held, false otherwise
+     */
+    [[nodiscard]] bool empty() const noexcept;
+
+    /**
+     * Get the number of endpoints.
+     *
+     * @return number of endpoints
+     */
+    [[nodiscard]] int get_endpoints_count() const noexcept;
+
+    /**
+     * Get the maximum number of paths per pair.
+     *
+     * @return k
+     */
+    [[nodiscard]] int get_k() const noexcept;
+
+    /**
+     * Get the number of paths found from src to dest.
+     *
+     * @param src src endpoint
+     * @param dest dest endpoint
+     * @return number of paths, at most k (0 if dest is unreachable)
+     */
+    [[nodiscard]] int get_paths_count(DeviceId src, DeviceId dest) const noexcept;
+
+    /**
+     * Get a path from src to dest, including both ends.
+     * Paths of a pair are sorted by length.
+     *
+     * @param src src endpoint
+     * @param dest dest endpoint
+     * @param index index of the path among the paths of the pair
+     * @return node ids of the path
+     */
+    [[nodiscard]] PathRange get_path(DeviceId src, DeviceId dest, int index) const noexcept;
+
+    /**
+     * Save the paths to a binary file.
+     *
+     * @param path path of the file
+     * @param key key identifying the graph the paths were computed on
+     * @return true if the file has been written, false otherwise
+     */
+    [[nodiscard]] bool save(const std::string& path, uint64_t key) const noexcept;
+
+    /**
+     * Load paths saved by save().
+     * Nothing is loaded if the file is missing, corrupted, or saved with another key or k.
+     *
+     * @param path path of the file
+     * @param key key identifying the graph the paths should have been computed on
+     * @param k expected maximum number of paths per pair
+     * @param k_shortest_paths loaded paths, left untouched on failure
+     * @return true if the paths have been loaded, false otherwise
+     */
+    [[nodiscard]] static bool load(const std::string& path,
+                                   uint64_t key,
+                                   int k,
+                                   KShortestPaths& k_shortest_paths) noexcept;
+
+  private:
+    /// number of endpoints
+    int endpoints_count;
+
+    /// maximum number of paths per pair
+    int k;
+
+    /// node ids of every path, back-to-back
+    std::vector<uint16_t> path_nodes;
+
+    /// path i spans path_nodes[path_offsets[i], path_offsets[i + 1])
+    std::vector<uint64_t> path_offsets;
+
+    /// paths of pair (src, dest) are [pair_offsets[src * endpoints_count + dest], pair_offsets[... + 1])
+    std::vector<uint32_t> pair_offsets;
+};
+
+}  // namespace NetworkAnalytical
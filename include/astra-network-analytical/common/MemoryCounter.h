@@ -0,0 +1,165 @@
+/******************************************************************************
+This source code is licensed under the MIT license found in the
+LICENSE file in the root directory of this source tree.
+*******************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace NetworkAnalytical {
+
+/**
+ * MemoryCounter counts the bytes currently allocated through the TrackingAllocators sharing it,
+ * and the most bytes ever allocated at once.
+ * Counting is lock-free, so containers filled from several threads (e.g., a ShardedMap) can share a counter.
+ */
+class MemoryCounter {
+  public:
+    /**
+     * Count an allocation.
+     *
+     * @param bytes size of the allocation in bytes
+     */
+    void allocate(const size_t bytes) noexcept {
+        const auto allocated_bytes = bytes_count.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+        auto peak = peak_bytes_count.load(std::memory_order_relaxed);
+        while (allocated_bytes > peak &&
+               !peak_bytes_count.compare_exchange_weak(peak, allocated_bytes, std::memory_order_relaxed)) {
+        }
+    }
+
+    /**
+     * Count a deallocation.
+     *
+     * @param bytes size of the allocation in bytes
+     */
+    void deallocate(const size_t bytes) noexcept {
+        bytes_count.fetch_sub(bytes, std::memory_order_relaxed);
+    }
+
+    /**
+     * Get the number of bytes currently allocated.
+     *
+     * @return allocated bytes
+     */
+    [[nodiscard]] uint64_t get_bytes() const noexcept {
+        return bytes_count.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Get the most bytes allocated at once so far.
+     *
+     * @return peak allocated bytes
+     */
+    [[nodiscard]] uint64_t get_peak_bytes() const noexcept {
+        return peak_bytes_count.load(std::memory_order_relaxed);
+    }
+
+  private:
+    /// bytes currently allocated
+    std::atomic<uint64_t> bytes_count{0};
+
+    /// most bytes allocated at once
+    std::atomic<uint64_t> peak_bytes_count{0};
+};
+
+/**
+ * TrackingAllocator allocates like std::allocator, and counts what it allocates in a MemoryCounter.
+ *
+ * Containers given one report the memory they actually hold (nodes, buckets, spare capacity),
+ * rather than an estimate from their sizes.
+ * The allocator shares the ownership of its counter, so containers may outlive the object that created the counter.
+ * A default-constructed allocator counts nothing.
+ * Copy-assigned containers keep their own counter, while moved-into ones take the counter of their source.
+ *
+ * @tparam T type of the allocated objects
+ */
+template <typename T> class TrackingAllocator {
+  public:
+    using value_type = T;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    /**
+     * Construct an allocator counting nothing.
+     */
+    TrackingAllocator() noexcept = default;
+
+    /**
+     * Constructor.
+     *
+     * @param memory_counter counter of the allocated bytes, nullptr to count nothing
+     */
+    explicit TrackingAllocator(std::shared_ptr<MemoryCounter> memory_counter) noexcept
+        : memory_counter(std::move(memory_counter)) {}
+
+    /**
+     * Construct an allocator of another type sharing the counter of this one.
+     */
+    template <typename U>
+    TrackingAllocator(const TrackingAllocator<U>& other) noexcept : memory_counter(other.get_memory_counter()) {}
+
+    /**
+     * Allocate storage for a number of objects.
+     *
+     * @param count number of objects
+     * @return pointer to the storage
+     */
+    [[nodiscard]] T* allocate(const size_t count) {
+        auto* const ptr = std::allocator<T>().allocate(count);
+        if (memory_counter != nullptr) {
+            memory_counter->allocate(count * sizeof(T));
+        }
+        return ptr;
+    }
+
+    /**
+     * Free storage obtained from allocate().
+     *
+     * @param ptr pointer to the storage
+     * @param count number of objects passed to allocate()
+     */
+    void deallocate(T* const ptr, const size_t count) noexcept {
+        std::allocator<T>().deallocate(ptr, count);
+        if (memory_counter != nullptr) {
+            memory_counter->deallocate(count * sizeof(T));
+        }
+    }
+
+    /**
+     * Get the counter of the allocated bytes.
+     *
+     * @return counter, nullptr if the allocator counts nothing
+     */
+    [[nodiscard]] const std::shared_ptr<MemoryCounter>& get_memory_counter() const noexcept {
+        return memory_counter;
+    }
+
+  private:
+    /// counter of the allocated bytes, nullptr to count nothing
+    std::shared_ptr<MemoryCounter> memory_counter;
+};
+
+/**
+ * Allocators are interchangeable if they count into the same counter.
+ */
+template <typename T, typename U>
+bool operator==(const TrackingAllocator<T>& lhs, const TrackingAllocator<U>& rhs) noexcept {
+    return lhs.get_memory_counter() == rhs.get_memory_counter();
+}
+
+template <typename T, typename U>
+bool operator!=(const TrackingAllocator<T>& lhs, const TrackingAllocator<U>& rhs) noexcept {
+    return !(lhs == rhs);
+}
+
+/// vector counting its storage in a MemoryCounter
+template <typename T> using TrackedVector = std::vector<T, TrackingAllocator<T>>;
+
+}  // namespace NetworkAnalytical
@@ -6,6 +6,7 @@ LICENSE file in the root directory of this source tree.
 #pragma once
 
 #include "common/Type.h"
+#include <cstdint>
 #include <iostream>
 #include <yaml-cpp/yaml.h>
 
@@ -23,6 +24,14 @@ class NetworkParser {
      */
     explicit NetworkParser(const std::string& path) noexcept;
 
+    /**
+     * Constructor, from an already loaded network config (e.g., a generated one).
+     *
+     * @param network_config loaded network config
+     * @param path path the files named by the config are relative to, as if it were the config's path
+     */
+    NetworkParser(const YAML::Node& network_config, const std::string& path) noexcept;
+
     /**
      * Return the number of network dimensions.
      * Which is calculated by the length of "topology" value
@@ -82,6 +91,116 @@ class NetworkParser {
      * @return fattree_radix per each dimension (0 if not specified)
      */
     [[nodiscard]] std::vector<int> get_fattree_radix_per_dim() const noexcept;
+
+    /**
+     * Read optional "torus_shape" value for Torus topologies,
+     * the number of NPUs of each torus dimension (e.g., [[16, 16, 16]]).
+     *
+     * @return torus_shape per each dimension ([npus_count] if not specified)
+     */
+    [[nodiscard]] std::vector<std::vector<int>> get_torus_shapes_per_dim() const noexcept;
+
+    /**
+     * Read optional "dragonfly_routers_per_group" value for Dragonfly topologies
+     *
+     * @return routers per group per each dimension (4 if not specified)
+     */
+    [[nodiscard]] std::vector<int> get_dragonfly_routers_per_group_per_dim() const noexcept;
+
+    /**
+     * Read optional "dragonfly_hosts_per_router" value for Dragonfly topologies
+     *
+     * @return hosts per router per each dimension (2 if not specified)
+     */
+    [[nodiscard]] std::vector<int> get_dragonfly_hosts_per_router_per_dim() const noexcept;
+
+    /**
+     * Read optional "dragonfly_global_links_per_router" value for Dragonfly topologies
+     *
+     * @return global links per router per each dimension (2 if not specified)
+     */
+    [[nodiscard]] std::vector<int> get_dragonfly_global_links_per_router_per_dim() const noexcept;
+
+    /**
+     * Read optional "dragonfly_arrangement" value for Dragonfly topologies
+     *
+     * @return arrangement of the global links per each dimension (empty string if not specified)
+     */
+    [[nodiscard]] std::vector<std::string> get_dragonfly_arrangements_per_dim() const noexcept;
+
+    /**
+     * Read optional "route_cache_capacity_mb" value,
+     * the memory cap of the per-pair route cache of a congestion-aware topology.
+     *
+     * @return route cache capacity in MB (0 if not specified, i.e., unbounded)
+     */
+    [[nodiscard]] uint64_t get_route_cache_capacity_mb() const noexcept;
+
+    /**
+     * Read optional "dim_order" value,
+     * the order in which routes of a multi-dimensional topology traverse the dimensions.
+     *
+     * @return "static", "reverse", or "adaptive" ("static" if not specified)
+     */
+    [[nodiscard]] std::string get_dim_order() const noexcept;
+
+    /**
+     * Read optional "precompute_routes" value,
+     * whether a congestion-aware topology with static routes routes every NPU pair at construction.
+     *
+     * @return true to precompute routes (false if not specified)
+     */
+    [[nodiscard]] bool get_precompute_routes() const noexcept;
+
+    /**
+     * Read optional "seed" value, the seed random routing draws from (see CounterRng),
+     * so runs of the same config take the same random routes.
+     *
+     * @return seed of the random routes (0 if not specified)
+     */
+    [[nodiscard]] uint64_t get_seed() const noexcept;
+
+    /**
+     * Read optional "snapshot" value, the path of the compiled-topology snapshot
+     * a congestion-aware topology is loaded from (and saved to when missing or stale),
+     * relative to the directory of the config.
+     *
+     * @return snapshot path (empty string if not specified)
+     */
+    [[nodiscard]] std::string get_snapshot_path() const noexcept;
+
+    /**
+     * Get the hash of the contents of the network config file.
+     *
+     * @return hash of the network config
+     */
+    [[nodiscard]] uint64_t get_config_hash() const noexcept;
+
+    /**
+     * Load a calibration overlay: a yml file with "bandwidth_scale" and "latency_scale" lists,
+     * overriding the ones of the network config.
+     * Network configs can also name their overlay in a "calibration" value,
+     * relative to the directory of the config.
+     *
+     * @param path path of the overlay yml file
+     */
+    void load_calibration(const std::string& path) noexcept;
+
+    /**
+     * Read optional "bandwidth_scale" value,
+     * the factor the congestion-unaware backend scales the bandwidth of each dimension by.
+     *
+     * @return bandwidth scale per each dimension (1 if not specified)
+     */
+    [[nodiscard]] std::vector<double> get_bandwidth_scales_per_dim() const noexcept;
+
+    /**
+     * Read optional "latency_scale" value,
+     * the factor the congestion-unaware backend scales the latency of each dimension by.
+     *
+     * @return latency scale per each dimension (1 if not specified)
+     */
+    [[nodiscard]] std::vector<double> get_latency_scales_per_dim() const noexcept;
   private:
     /// number of network dimensions
     int dims_count;
@@ -110,6 +229,45 @@ class NetworkParser {
     /// optional fattree_radix per each dimension (for FatTree)
     std::vector<int> fattree_radix_per_dim;
 
+    /// optional torus_shape per each dimension (for Torus)
+    std::vector<std::vector<int>> torus_shape_per_dim;
+
+    /// optional dragonfly_routers_per_group per each dimension (for Dragonfly)
+    std::vector<int> dragonfly_routers_per_group_per_dim;
+
+    /// optional dragonfly_hosts_per_router per each dimension (for Dragonfly)
+    std::vector<int> dragonfly_hosts_per_router_per_dim;
+
+    /// optional dragonfly_global_links_per_router per each dimension (for Dragonfly)
+    std::vector<int> dragonfly_global_links_per_router_per_dim;
+
+    /// optional dragonfly_arrangement per each dimension (for Dragonfly)
+    std::vector<std::string> dragonfly_arrangement_per_dim;
+
+    /// optional memory cap of the route cache in MB, 0 if unbounded
+    uint64_t route_cache_capacity_mb = 0;
+
+    /// optional order of dimension traversal of multi-dimensional routes
+    std::string dim_order = "static";
+
+    /// optional flag to route every NPU pair at construction
+    bool precompute_routes = false;
+
+    /// optional seed of the random routes
+    uint64_t seed = 0;
+
+    /// optional path of the compiled-topology snapshot
+    std::string snapshot_path;
+
+    /// hash of the contents of the network config file
+    uint64_t config_hash;
+
+    /// optional bandwidth correction factor per each dimension (for congestion_unaware)
+    std::vector<double> bandwidth_scale_per_dim;
+
+    /// optional latency correction factor per each dimension (for congestion_unaware)
+    std::vector<double> latency_scale_per_dim;
+
     /**
      * Parse topology name (in string) into TopologyBuildingBlock enum
      *
@@ -120,6 +278,14 @@ class NetworkParser {
     [[nodiscard]] static TopologyBuildingBlock parse_topology_name(const std::string& topology_name) noexcept;
 
     [[nodiscard]] static std::string parse_routing_algorithm_name(const std::string& routing_algorithm_name) noexcept;
+    /**
+     * Parse a loaded network config, and load the files it names.
+     *
+     * @param network_config loaded network config
+     * @param path path the files named by the config are relative to
+     */
+    void load_network_config(const YAML::Node& network_config, const std::string& path) noexcept;
+
     /**
      * Parse the given YAML node and retrieve network configuration values
      *
@@ -127,6 +293,13 @@ class NetworkParser {
      */
     void parse_network_config_yml(const YAML::Node& network_config) noexcept;
 
+    /**
+     * Parse the calibration values of the given YAML node, if any.
+     *
+     * @param calibration opened and parsed YAML node
+     */
+    void parse_calibration_yml(const YAML::Node& calibration) noexcept;
+
     /**
      * Check the validity and correctness of the parsed network input
      * configurations.
@@ -0,0 +1,162 @@
+/******************************************************************************
+This source code is licensed under the MIT license found in the
+LICENSE file in the root directory of this source tree.
+*******************************************************************************/
+
+#pragma once
+
+#include "common/MemoryCounter.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <utility>
+
+namespace NetworkAnalytical {
+
+/**
+ * ShardedMap is a read-mostly concurrent map from 64-bit keys to immutable values,
+ * used by topologies to cache what their const route() computes (e.g., paths per NPU pair).
+ *
+ * Keys are spread over independently locked shards, so concurrent lookups only share a reader lock,
+ * and inserts of different shards don't contend. Entries are never erased while in use,
+ * and the map is node-based, so references to values stay valid until clear().
+ * When two threads insert the same key, the first value wins and both get it.
+ *
+ * @tparam Value type of the values
+ */
+template <typename Value> class ShardedMap {
+  public:
+    /// entries of a shard, counting their memory in the counter of the map (if any)
+    using Entries = std::unordered_map<uint64_t,
+                                       Value,
+                                       std::hash<uint64_t>,
+                                       std::equal_to<uint64_t>,
+                                       TrackingAllocator<std::pair<const uint64_t, Value>>>;
+
+    /**
+     * Constructor.
+     *
+     * @param memory_counter counter of the memory held by the entries (nodes and buckets), nullptr for none
+     */
+    explicit ShardedMap(std::shared_ptr<MemoryCounter> memory_counter = nullptr) noexcept
+        : shards(std::make_unique<Shard[]>(shards_count)) {
+        for (auto i = 0; i < shards_count; i++) {
+            shards[i].entries = Entries(TrackingAllocator<std::pair<const uint64_t, Value>>(memory_counter));
+        }
+    }
+
+    /**
+     * Find the value of a key.
+     *
+     * @param key key to look up
+     * @return pointer to the value, nullptr if not found
+     */
+    [[nodiscard]] const Value* find(const uint64_t key) const noexcept {
+        auto& shard = get_shard(key);
+        const auto lock = std::shared_lock<std::shared_mutex>(shard.mutex);
+        const auto entry = shard.entries.find(key);
+        return (entry == shard.entries.end()) ? nullptr : &entry->second;
+    }
+
+    /**
+     * Insert the value of a key, unless the key is already in the map.
+     *
+     * @param key key to insert
+     * @param value value to insert
+     * @return value of the key in the map
+     */
+    const Value& emplace(const uint64_t key, Value value) noexcept {
+        auto& shard = get_shard(key);
+        const auto lock = std::unique_lock<std::shared_mutex>(shard.mutex);
+        return shard.entries.emplace(key, std::move(value)).first->second;
+    }
+
+    /**
+     * Remove every entry. Not thread-safe: no lookup should be in progress.
+     */
+    void clear() noexcept {
+        for (auto i = 0; i < shards_count; i++) {
+            shards[i].entries.clear();
+        }
+    }
+
+    /**
+     * Remove the entries a predicate holds for. Not thread-safe: no lookup should be in progress.
+     *
+     * @param predicate called with the key and the value of each entry
+     * @return number of entries removed
+     */
+    template <typename Predicate> size_t erase_if(const Predicate& predicate) noexcept {
+        auto erased_count = static_cast<size_t>(0);
+        for (auto i = 0; i < shards_count; i++) {
+            auto& entries = shards[i].entries;
+            for (auto entry = entries.begin(); entry != entries.end();) {
+                if (predicate(entry->first, entry->second)) {
+                    entry = entries.erase(entry);
+                    erased_count++;
+                } else {
+                    entry++;
+                }
+            }
+        }
+        return erased_count;
+    }
+
+    /**
+     * Get the number of entries.
+     *
+     * @return number of entries
+     */
+    [[nodiscard]] size_t size() const noexcept {
+        auto size = static_cast<size_t>(0);
+        for (auto i = 0; i < shards_count; i++) {
+            const auto lock = std::shared_lock<std::shared_mutex>(shards[i].mutex);
+            size += shards[i].entries.size();
+        }
+        return size;
+    }
+
+    /**
+     * Make the key of an ordered pair of ids.
+     *
+     * @param first first id of the pair
+     * @param second second id of the pair
+     * @return key of the pair
+     */
+    [[nodiscard]] static uint64_t make_pair_key(const int first, const int second) noexcept {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(first)) << 32) | static_cast<uint32_t>(second);
+    }
+
+  private:
+    /// log2 of the number of shards
+    static constexpr int shards_bits = 6;
+
+    /// number of shards
+    static constexpr int shards_count = 1 << shards_bits;
+
+    /// entries of a range of keys, on its own cache line
+    struct alignas(64) Shard {
+        /// guards the entries
+        mutable std::shared_mutex mutex;
+
+        /// key -> value
+        Entries entries;
+    };
+
+    /// shards, heap-allocated so the map stays movable
+    std::unique_ptr<Shard[]> shards;
+
+    /**
+     * Get the shard of a key.
+     * Keys are mixed first, so pairs differing in either id spread over the shards.
+     */
+    [[nodiscard]] Shard& get_shard(const uint64_t key) const noexcept {
+        const auto mixed = (key ^ (key >> 29)) * 0xBF58476D1CE4E5B9ULL;
+        return shards[mixed >> (64 - shards_bits)];
+    }
+};
+
+}  // namespace NetworkAnalytical
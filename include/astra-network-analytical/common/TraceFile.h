@@ -0,0 +1,119 @@
+/******************************************************************************
+This source code is licensed under the MIT license found in the
+LICENSE file in the root directory of this source tree.
+*******************************************************************************/
+
+#pragma once
+
+#include "common/Type.h"
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace NetworkAnalytical {
+
+/**
+ * TraceRecord is a transfer of a trace: size bytes from src to dest,
+ * issued at issue_time or once every transfer it depends on completed, whichever is later.
+ * Transfers are identified by their index in the trace, and only depend on earlier ones.
+ */
+struct TraceRecord {
+    /// earliest time to issue the transfer
+    EventTime issue_time;
+
+    /// src NPU id
+    DeviceId src;
+
+    /// dest NPU id
+    DeviceId dest;
+
+    /// size of the transfer in bytes
+    ChunkSize size;
+
+    /// indices of the transfers to complete first
+    std::vector<uint64_t> dependencies;
+};
+
+/**
+ * TraceReader streams the records of a binary trace file, one at a time,
+ * through a fixed-size read buffer, so traces of any length are never held in memory.
+ *
+ * The file starts with the magic "ANATRC01" and the number of records (uint64),
+ * followed by each record: issue_time (uint64), src and dest (int32), size (uint64),
+ * the number of dependencies (uint32), and the index of each dependency (uint64).
+ */
+class TraceReader {
+  public:
+    /**
+     * Open a trace file.
+     *
+     * @param path path of the trace file
+     */
+    explicit TraceReader(const std::string& path) noexcept;
+
+    /**
+     * Get the number of records of the trace.
+     *
+     * @return number of records
+     */
+    [[nodiscard]] uint64_t get_records_count() const noexcept;
+
+    /**
+     * Read the next record.
+     * The record's dependencies vector is reused, so reading into the same record doesn't allocate.
+     *
+     * @param record record read, left untouched at the end of the trace
+     * @return true if a record has been read, false at the end of the trace
+     */
+    [[nodiscard]] bool next(TraceRecord& record) noexcept;
+
+  private:
+    /// trace file
+    std::ifstream file;
+
+    /// read buffer of the file stream
+    std::vector<char> buffer;
+
+    /// number of records of the trace
+    uint64_t records_count;
+
+    /// number of records read so far
+    uint64_t read_records_count;
+};
+
+/**
+ * TraceWriter writes records to a binary trace file read by TraceReader.
+ */
+class TraceWriter {
+  public:
+    /**
+     * Create a trace file.
+     *
+     * @param path path of the trace file
+     */
+    explicit TraceWriter(const std::string& path) noexcept;
+
+    /**
+     * Append a record. Its dependencies should be earlier records.
+     *
+     * @param record record to append
+     */
+    void write(const TraceRecord& record) noexcept;
+
+    /**
+     * Write the number of records and close the file.
+     *
+     * @return true if the whole trace has been written, false otherwise
+     */
+    [[nodiscard]] bool close() noexcept;
+
+  private:
+    /// trace file
+    std::ofstream file;
+
+    /// number of records written so far
+    uint64_t records_count;
+};
+
+}  // namespace NetworkAnalytical
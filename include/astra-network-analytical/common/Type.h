@@ -31,6 +31,12 @@ using Latency = double;
 using EventTime = uint64_t;
 
 /// Basic multi-dimensional topology building blocks
-enum class TopologyBuildingBlock { Undefined, Ring, FullyConnected, Switch, ExpanderGraph, SwitchOrExpander, FatTree };
+enum class TopologyBuildingBlock { Undefined, Ring, FullyConnected, Switch, ExpanderGraph, SwitchOrExpander, FatTree, Torus, Dragonfly };
+
+/// Collective communication patterns
+enum class CollectiveType { AllReduce, AllGather, ReduceScatter, AllToAll };
+
+/// Collective communication algorithms
+enum class CollectiveAlgorithm { Ring, Direct, HalvingDoubling };
 
 }  // namespace NetworkAnalytical
@@ -7,6 +7,9 @@ LICENSE file in the root directory of this source tree.
 
 #include "common/Type.h"
 #include "congestion_aware/Topology.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
 
 using namespace NetworkAnalytical;
 
@@ -55,6 +58,11 @@ class BasicTopology : public Topology {
      */
     [[nodiscard]] virtual std::unique_ptr<BasicTopology> clone() const noexcept = 0;
 
+    /**
+     * Reset the links, and restart the flow ids of every NPU.
+     */
+    void reset() noexcept override;
+
   protected:
     /// bandwidth of each link
     Bandwidth bandwidth;
@@ -64,6 +72,18 @@ class BasicTopology : public Topology {
 
     /// basic topology type
     TopologyBuildingBlock basic_topology_type;
+
+    /// number of flow ids drawn per source NPU
+    std::unique_ptr<std::atomic<uint64_t>[]> flows_counts;
+
+    /**
+     * Draw the next flow id of a source NPU, keying the random stream of its next route (see CounterRng).
+     * Chunks leave a source in simulation order, so the flow ids and the routes they key are reproducible.
+     *
+     * @param src src NPU id
+     * @return flow id
+     */
+    [[nodiscard]] uint64_t next_flow_id(DeviceId src) const noexcept;
 };
 
 }  // namespace NetworkAnalyticalCongestionAware
@@ -0,0 +1,55 @@
+/******************************************************************************
+This source code is licensed under the MIT license found in the
+LICENSE file in the root directory of this source tree.
+*******************************************************************************/
+
+#pragma once
+
+#include "common/NetworkParser.h"
+#include "common/Type.h"
+#include <string>
+#include <vector>
+
+using namespace NetworkAnalytical;
+
+namespace NetworkAnalyticalCongestionAware {
+
+/**
+ * Correction factors fitting the congestion-unaware closed form
+ * (hops * latency + size / bandwidth) to congestion-aware simulations.
+ */
+struct Calibration {
+    /// factor the bandwidth of each dimension is scaled by
+    std::vector<double> bandwidth_scale_per_dim;
+
+    /// factor the latency of each dimension is scaled by
+    std::vector<double> latency_scale_per_dim;
+
+    /// mean relative error of the calibrated closed form, per each dimension
+    std::vector<double> error_per_dim;
+};
+
+/**
+ * Calibrate the congestion-unaware backend against the congestion-aware one.
+ * Within each dimension, representative patterns (single transfers of varying sizes,
+ * shifts, and all-to-all) run through the congestion-aware backend,
+ * and the latency and bandwidth factors minimizing the relative error
+ * of the closed-form delay of the transfers are fitted by least squares, every pattern weighing the same.
+ *
+ * @param network_parser network to calibrate
+ * @param chunk_size size of the transfers of the patterns
+ * @return fitted correction factors
+ */
+[[nodiscard]] Calibration calibrate_congestion_unaware(const NetworkParser& network_parser,
+                                                       ChunkSize chunk_size = 1'048'576) noexcept;
+
+/**
+ * Save the correction factors as a yml overlay NetworkParser::load_calibration() can load.
+ *
+ * @param calibration correction factors
+ * @param path path of the overlay yml file
+ * @return true if the file has been written, false otherwise
+ */
+[[nodiscard]] bool save_calibration(const Calibration& calibration, const std::string& path) noexcept;
+
+}  // namespace NetworkAnalyticalCongestionAware
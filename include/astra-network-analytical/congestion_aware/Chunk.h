@@ -5,20 +5,41 @@ LICENSE file in the root directory of this source tree.
 
 #pragma once
 
+#include "common/EventCallback.h"
 #include "common/Type.h"
 #include "congestion_aware/Type.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <vector>
 
 using namespace NetworkAnalytical;
 
 namespace NetworkAnalyticalCongestionAware {
 
+class SimulationContext;
+
 /**
  * Chunk class represents a chunk.
  * Chunk is a basic unit of transmission.
+ *
+ * The route is flattened into an array of hops (device, outgoing port) with a cursor,
+ * stored inline for routes of up to inline_hops_count devices.
+ * Routes of arithmetic topologies can instead be described (see RouteDescriptor),
+ * in which case each hop is computed as the chunk advances and no hop is stored.
+ * Chunks refer to devices by raw pointer, so the topology should outlive its chunks.
+ * A chunk is simulated in the context it's sent under (see get_simulation_context()),
+ * so the links it crosses keep their state there.
+ *
+ * Chunk storage is recycled through ChunkPool,
+ * so sending a chunk and dropping it on arrival don't hit the general-purpose allocator.
  */
 class Chunk {
   public:
+    /// number of hops stored without a heap allocation
+    static constexpr size_t inline_hops_count = 8;
+
     /**
      * Callback to be invoked when a chunk arrives at the next device.
      *   - if the chunk arrived at its destination, the final callback is invoked
@@ -28,6 +49,23 @@ class Chunk {
      */
     static void chunk_arrived_next_device(void* chunk_ptr) noexcept;
 
+    /**
+     * Handle a chunk that's arrived at the next device.
+     * Same as chunk_arrived_next_device, but takes the ownership directly.
+     *
+     * @param chunk: the chunk that's arrived at the next device
+     */
+    static void arrived_next_device(std::unique_ptr<Chunk> chunk) noexcept;
+
+    /**
+     * Complete a chunk that's arrived at its destination:
+     * hand it to the completion batcher of its simulation context if it belongs to a sink,
+     * or invoke its callback otherwise.
+     *
+     * @param chunk the chunk that's arrived at its destination
+     */
+    static void complete(std::unique_ptr<Chunk> chunk) noexcept;
+
     /**
      * Constructor.
      *
@@ -38,19 +76,80 @@ class Chunk {
      */
     Chunk(ChunkSize chunk_size, Route route, Callback callback, CallbackArg callback_arg) noexcept;
 
+    /**
+     * Constructor.
+     *
+     * @param chunk_size: size of the chunk
+     * @param route: route of the chunk from its source to destination
+     * @param callback: callable to be invoked when the chunk arrives destination
+     */
+    Chunk(ChunkSize chunk_size, Route route, EventCallback callback) noexcept;
+
+    /**
+     * Constructor, from an already flattened route.
+     * Routes longer than inline_hops_count are referenced, not copied,
+     * so route_hops should outlive the chunk (e.g., a route cached by the topology).
+     *
+     * @param chunk_size: size of the chunk
+     * @param route_hops: flattened route of the chunk from its source to destination
+     * @param callback: callable to be invoked when the chunk arrives destination
+     */
+    Chunk(ChunkSize chunk_size, const RouteHops& route_hops, EventCallback callback) noexcept;
+
+    /**
+     * Constructor, from a described route.
+     * Hops are computed as the chunk advances, so the route takes no storage.
+     * The devices of the descriptor should outlive the chunk.
+     *
+     * @param chunk_size: size of the chunk
+     * @param route_descriptor: route of the chunk from its source to destination
+     * @param callback: callable to be invoked when the chunk arrives destination
+     */
+    Chunk(ChunkSize chunk_size, const RouteDescriptor& route_descriptor, EventCallback callback) noexcept;
+
+    /**
+     * Allocate chunk storage from ChunkPool.
+     *
+     * @param size size of the object
+     * @return pointer to the storage
+     */
+    static void* operator new(size_t size) noexcept;
+
+    /**
+     * Return chunk storage to ChunkPool.
+     *
+     * @param ptr pointer to the storage
+     * @param size size of the object
+     */
+    static void operator delete(void* ptr, size_t size) noexcept;
+
     /**
      * Get the current sitting device of the chunk
      *
      * @return current device of the chunk
      */
-    [[nodiscard]] std::shared_ptr<Device> current_device() const noexcept;
+    [[nodiscard]] Device* current_device() const noexcept;
 
     /**
      * Get the next destined device of the chunk
      *
      * @return next device of the chunk
      */
-    [[nodiscard]] std::shared_ptr<Device> next_device() const noexcept;
+    [[nodiscard]] Device* next_device() const noexcept;
+
+    /**
+     * Get the port of the current device leading to the next device
+     *
+     * @return port towards the next device
+     */
+    [[nodiscard]] PortId next_port() const noexcept;
+
+    /**
+     * Get the port of the next device leading further along the route
+     *
+     * @return port of the next device, -1 if the next device is the destination
+     */
+    [[nodiscard]] PortId next_device_port() const noexcept;
 
     /**
      * Mark the chunk arrived at its next device
@@ -58,14 +157,57 @@ class Chunk {
      */
     void mark_arrived_next_device() noexcept;
 
+    /**
+     * Mark the chunk as the representative of an orbit (see SymmetricSimulation),
+     * whose hops are representatives of its links, so consecutive hops needn't be adjacent.
+     *
+     * @param representative true if the chunk is a representative
+     */
+    void set_representative(bool representative) noexcept;
+
+    /**
+     * Check whether the chunk is the representative of an orbit.
+     *
+     * @return true if the chunk is a representative, false otherwise
+     */
+    [[nodiscard]] bool is_representative() const noexcept;
+
+    /**
+     * Mark the chunk as counted in the per-hop chunks of its context until it completes
+     * (see SimulationContext::add_per_hop_chunk()).
+     *
+     * @param per_hop true if the chunk is counted
+     */
+    void set_per_hop(bool per_hop) noexcept;
+
+    /**
+     * Check whether the chunk is counted in the per-hop chunks of its context.
+     *
+     * @return true if the chunk is counted, false otherwise
+     */
+    [[nodiscard]] bool is_per_hop() const noexcept;
+
+    /**
+     * Replace the rest of the route, e.g., to avoid a failed link.
+     * @param route: new route of the chunk from its current device to its destination
+     */
+    void reroute(const Route& route) noexcept;
+
     /**
      * Check if the chunk arrived at its destination
-     * i.e., if the route length is 1 (only destination device left)
+     * i.e., if the cursor points at the last hop (only destination device left)
      *
      * @return true if the chunk arrived at its destination, false otherwise
      */
     [[nodiscard]] bool arrived_dest() const noexcept;
 
+    /**
+     * Check if the next device of the chunk is its destination.
+     *
+     * @return true if the chunk is on its last link, false otherwise
+     */
+    [[nodiscard]] bool next_device_is_dest() const noexcept;
+
     /**
      * Get the size of the chunk
      *
@@ -79,21 +221,169 @@ class Chunk {
      */
     void invoke_callback() noexcept;
 
+    /**
+     * Get the callback to be invoked when the chunk arrives at its destination.
+     *
+     * @return callback of the chunk
+     */
+    [[nodiscard]] const EventCallback& get_callback() const noexcept;
+
+    /**
+     * Get the number of hops on the route, including the src and dest devices.
+     *
+     * @return number of hops
+     */
+    [[nodiscard]] size_t get_hops_count() const noexcept;
+
+    /**
+     * Get a hop of the route.
+     *
+     * @param index index of the hop
+     * @return the hop
+     */
+    [[nodiscard]] RouteHop get_hop(size_t index) const noexcept;
+
+    /**
+     * Set the trace id of the chunk (see ChunkTracer::sample()).
+     *
+     * @param trace_id trace id, 0 if the chunk isn't traced
+     */
+    void set_trace_id(uint64_t trace_id) noexcept;
+
+    /**
+     * Get the trace id of the chunk.
+     *
+     * @return trace id, 0 if the chunk isn't traced
+     */
+    [[nodiscard]] uint64_t get_trace_id() const noexcept;
+
+    /**
+     * Set the time when the tail of the chunk arrives at the device it's at or heading to
+     * (see SimulationContext::set_cut_through()).
+     *
+     * @param tail_arrival_time time when the last byte of the chunk arrives
+     */
+    void set_tail_arrival_time(EventTime tail_arrival_time) noexcept;
+
+    /**
+     * Get the time when the tail of the chunk arrives at the device it's at or heading to.
+     * Under store-and-forward, a chunk only arrives as a whole, so it's the time it arrived.
+     *
+     * @return time when the last byte of the chunk arrives, 0 at its source
+     */
+    [[nodiscard]] EventTime get_tail_arrival_time() const noexcept;
+
+    /**
+     * Set the traffic class of the chunk, which links queue apart from the other classes
+     * (see SimulationContext::set_link_scheduling()).
+     *
+     * @param traffic_class traffic class in [0, LinkStates::traffic_classes_count)
+     */
+    void set_traffic_class(int traffic_class) noexcept;
+
+    /**
+     * Get the traffic class of the chunk.
+     *
+     * @return traffic class, 0 unless set otherwise
+     */
+    [[nodiscard]] int get_traffic_class() const noexcept;
+
+    /**
+     * Set whether the chunk holds room in the buffer of the link it's heading to (see Link::set_buffer_size()).
+     *
+     * @param holds_buffer_room true once room was taken for the chunk, false once given back
+     */
+    void set_holds_buffer_room(bool holds_buffer_room) noexcept;
+
+    /**
+     * Check whether the chunk holds room in the buffer of the link it's heading to.
+     *
+     * @return true if the chunk holds buffer room, false otherwise
+     */
+    [[nodiscard]] bool holds_buffer_room() const noexcept;
+
+    /**
+     * Set the simulation context the chunk is simulated in.
+     *
+     * @param context simulation context of the chunk
+     */
+    void set_simulation_context(SimulationContext* context) noexcept;
+
+    /**
+     * Get the simulation context the chunk is simulated in.
+     *
+     * @return simulation context of the chunk, nullptr until it's sent
+     */
+    [[nodiscard]] SimulationContext* get_simulation_context() const noexcept;
+
   private:
     /// size of the chunk
     ChunkSize chunk_size;
 
-    /// route of the chunk to its destination.
-    /// Route has the structure of [current device, next device, ..., dest device]
-    /// e.g., if a chunk starts from device 5, then reaches destination 3,
-    /// the route would be e.g., [5, 1, 6, 2, 3]
-    Route route;
+    union {
+        /// route of the chunk to its destination, flattened.
+        /// hops have the structure of [src device, next device, ..., dest device]
+        /// e.g., if a chunk starts from device 5, then reaches destination 3,
+        /// the hops would be e.g., [5, 1, 6, 2, 3]
+        std::array<RouteHop, inline_hops_count> inline_hops;
+
+        /// route of the chunk if described (see implicit)
+        RouteDescriptor route_descriptor;
+    };
+
+    /// whether the route is described, i.e., hops are computed from route_descriptor
+    bool implicit;
+
+    /// whether the chunk hops over representatives of its links (see set_representative())
+    bool representative;
+
+    /// whether the chunk is counted in the per-hop chunks of its context (see set_per_hop())
+    bool per_hop;
+
+    /// hops of routes longer than inline_hops_count, owned by the chunk (empty otherwise)
+    std::vector<RouteHop> spilled_hops;
+
+    /// hops of routes longer than inline_hops_count (spilled_hops, or a shared route)
+    const RouteHop* long_hops;
+
+    /// number of hops on the route
+    size_t hops_count;
+
+    /// index of the hop the chunk is currently at
+    size_t cursor;
 
     /// callback to be invoked when the chunk arrives at its destination
-    Callback callback;
+    EventCallback callback;
+
+    /// trace id of the chunk, 0 if the chunk isn't traced
+    uint64_t trace_id;
+
+    /// time when the tail of the chunk arrives at the device it's at or heading to, 0 at its source
+    EventTime tail_arrival_time;
+
+    /// traffic class of the chunk
+    int traffic_class;
+
+    /// whether the chunk holds room in the buffer of the link it's heading to
+    bool buffer_room;
 
-    /// argument of the callback
-    CallbackArg callback_arg;
+    /// simulation context the chunk is simulated in
+    SimulationContext* context;
+
+    /**
+     * Flatten the route into hops, resolving the port of each hop.
+     *
+     * @param route route of the chunk
+     */
+    void set_route(const Route& route) noexcept;
+
+    /**
+     * Compute the id of a device on the described route.
+     *
+     * @param index index of the hop
+     * @return id of the device of the hop
+     */
+    [[nodiscard]] DeviceId get_described_device_id(size_t index) const noexcept;
 };
 
 }  // namespace NetworkAnalyticalCongestionAware
@@ -0,0 +1,67 @@
+/******************************************************************************
+This source code is licensed under the MIT license found in the
+LICENSE file in the root directory of this source tree.
+*******************************************************************************/
+
+#pragma once
+
+#include "common/MemoryCounter.h"
+#include <cstddef>
+
+namespace NetworkAnalyticalCongestionAware {
+
+/**
+ * ChunkPool recycles the storage of Chunk objects.
+ *
+ * Chunk routes its operator new/delete here,
+ * so std::make_unique<Chunk> and the destruction of an arrived chunk
+ * reuse a fixed-size block instead of going through the general-purpose allocator.
+ *
+ * Each thread keeps its own free list, so the parallel simulator doesn't contend on it:
+ * a chunk freed on another thread than the one that created it
+ * simply joins the freeing thread's list.
+ * Blocks are carved out of slabs that live until the program exits,
+ * and a thread's free list is handed back to a shared list when the thread ends.
+ */
+class ChunkPool {
+  public:
+    /**
+     * Get a block for a chunk.
+     *
+     * @param size requested size in bytes
+     * @return pointer to the block
+     */
+    [[nodiscard]] static void* allocate(size_t size) noexcept;
+
+    /**
+     * Return a block obtained from allocate().
+     *
+     * @param ptr pointer to the block
+     * @param size size passed to allocate()
+     */
+    static void deallocate(void* ptr, size_t size) noexcept;
+
+    /**
+     * Make sure the calling thread can hand out the given number of chunks
+     * without allocating slabs later.
+     *
+     * @param chunks_count number of chunks to prepare
+     */
+    static void reserve(size_t chunks_count) noexcept;
+
+    /**
+     * Get the number of blocks carved out of slabs so far (over all threads).
+     *
+     * @return number of blocks ever created
+     */
+    [[nodiscard]] static size_t get_blocks_count() noexcept;
+
+    /**
+     * Get the memory held by the pool: its slabs, and the chunks too large for a block.
+     *
+     * @return counter of the memory held by the pool
+     */
+    [[nodiscard]] static const NetworkAnalytical::MemoryCounter& get_memory_counter() noexcept;
+};
+
+}  // namespace NetworkAnalyticalCongestionAware
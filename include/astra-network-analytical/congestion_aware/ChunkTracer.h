@@ -0,0 +1,227 @@
+/******************************************************************************
+This source code is licensed under the MIT license found in the
+LICENSE file in the root directory of this source tree.
+*******************************************************************************/
+
+#pragma once
+
+#include "common/Type.h"
+#include "congestion_aware/Type.h"
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+using namespace NetworkAnalytical;
+
+namespace NetworkAnalyticalCongestionAware {
+
+/**
+ * ChunkTracer records the lifecycle of chunks into a Chrome trace event file (JSON),
+ * which chrome://tracing and the Perfetto UI open directly.
+ *
+ * Each link is a track (thread "link src -> dest" of process "device src"):
+ * its transmissions are complete events, so the track shows the link occupancy over time,
+ * with instant events where chunks are enqueued on and arrive through the link.
+ * Each chunk is an async slice from its injection to its completion.
+ *
+ * Records go into a preallocated buffer. A full buffer is handed to a writer thread,
+ * which formats and writes it while the simulation fills a spare one,
+ * so the simulation only waits for the writer if it falls behind by every spare buffer.
+ * One chunk in sampling_period is traced, so traces of large runs stay cheap.
+ *
+ * A tracer belongs to one simulation context (see SimulationContext::set_chunk_tracer()),
+ * which is simulated by a single thread. Links bound to a partition of a ParallelSimulator don't trace.
+ */
+class ChunkTracer {
+  public:
+    /// stage of the lifecycle of a chunk
+    enum class EventType : uint8_t {
+        Inject,         // sent by its src NPU
+        Enqueue,        // handed to a link
+        TransmitStart,  // starts being serialized on a link
+        Arrival,        // arrived at the next device through a link
+        Completion      // arrived at its dest NPU
+    };
+
+    /**
+     * Constructor.
+     * Exits the program if the file can't be opened.
+     *
+     * @param path path of the trace file
+     * @param sampling_period trace one chunk out of sampling_period
+     * @param buffer_records_count number of records per buffer
+     */
+    explicit ChunkTracer(const std::string& path,
+                         uint64_t sampling_period = 1,
+                         size_t buffer_records_count = 1 << 16) noexcept;
+
+    /**
+     * Destructor.
+     * Writes the remaining records and closes the trace file.
+     */
+    ~ChunkTracer() noexcept;
+
+    ChunkTracer(const ChunkTracer&) = delete;
+    ChunkTracer& operator=(const ChunkTracer&) = delete;
+
+    /**
+     * Decide whether an injected chunk is traced.
+     *
+     * @return trace id of the chunk (its injection index, from 1), 0 if not sampled
+     */
+    [[nodiscard]] uint64_t sample() noexcept;
+
+    /**
+     * Record a stage of the lifecycle of a traced chunk.
+     *
+     * @param type stage of the lifecycle
+     * @param chunk_id trace id of the chunk
+     * @param time time of the stage
+     * @param device device the stage happens at (the src NPU for Inject and Completion)
+     * @param next_device next device of the link (the dest NPU for Inject and Completion)
+     * @param size size of the chunk
+     * @param duration duration of the stage (the serialization delay for TransmitStart)
+     */
+    void record(EventType type,
+                uint64_t chunk_id,
+                EventTime time,
+                DeviceId device,
+                DeviceId next_device,
+                ChunkSize size,
+                EventTime duration = 0) noexcept;
+
+    /**
+     * Record the transmission of a traced chunk over a link:
+     * its transmission start and its arrival at the next device.
+     *
+     * @param chunk_id trace id of the chunk
+     * @param device device the link leaves from
+     * @param next_device device the link leads to
+     * @param size size of the chunk
+     * @param departure_time time when the chunk starts being serialized
+     * @param serialization_time serialization delay of the chunk on the link
+     * @param arrival_time time when the chunk arrives at the next device
+     */
+    void record_hop(uint64_t chunk_id,
+                    DeviceId device,
+                    DeviceId next_device,
+                    ChunkSize size,
+                    EventTime departure_time,
+                    EventTime serialization_time,
+                    EventTime arrival_time) noexcept;
+
+    /**
+     * Wait until every record so far is written to the file.
+     */
+    void flush() noexcept;
+
+    /**
+     * Get the number of records so far.
+     *
+     * @return number of records
+     */
+    [[nodiscard]] uint64_t get_records_count() const noexcept;
+
+  private:
+    /// a stage of the lifecycle of a chunk
+    struct Record {
+        /// time of the stage
+        EventTime time;
+
+        /// duration of the stage
+        EventTime duration;
+
+        /// trace id of the chunk
+        uint64_t chunk_id;
+
+        /// size of the chunk
+        ChunkSize size;
+
+        /// device the stage happens at
+        DeviceId device;
+
+        /// next device of the link
+        DeviceId next_device;
+
+        /// stage of the lifecycle
+        EventType type;
+    };
+
+    /// number of spare buffers the simulation can fill while the writer is busy
+    static constexpr int spare_buffers_count = 2;
+
+    /// trace one chunk out of sampling_period
+    uint64_t sampling_period;
+
+    /// number of chunks injected so far
+    uint64_t injected_chunks_count;
+
+    /// number of records so far
+    uint64_t records_count;
+
+    /// number of records per buffer
+    size_t buffer_records_count;
+
+    /// buffer being filled by the simulation
+    std::vector<Record> buffer;
+
+    /// trace file, only accessed by the writer thread once constructed
+    std::ofstream file;
+
+    /// whether no record has been written yet
+    bool first_record;
+
+    /// links whose track has been named, as (device << 32) | next device
+    std::unordered_set<uint64_t> named_tracks;
+
+    /// guards the buffer queues and the writer state
+    std::mutex mutex;
+
+    /// signals buffer queue changes
+    std::condition_variable condition;
+
+    /// full buffers waiting to be written, oldest first
+    std::deque<std::vector<Record>> full_buffers;
+
+    /// written buffers ready to be filled again
+    std::vector<std::vector<Record>> spare_buffers;
+
+    /// whether the writer thread is writing a buffer
+    bool writing;
+
+    /// whether the writer thread should exit once the full buffers are written
+    bool stopping;
+
+    /// thread writing full buffers to the file
+    std::thread writer;
+
+    /**
+     * Hand the buffer to the writer thread and continue with a spare one.
+     */
+    void submit_buffer() noexcept;
+
+    /**
+     * Write full buffers until stopped.
+     */
+    void write_buffers() noexcept;
+
+    /**
+     * Format a record as trace events.
+     *
+     * @param record record to write
+     */
+    void write_record(const Record& record) noexcept;
+
+    /**
+     * Write the separator and the start of an event.
+     */
+    void begin_event() noexcept;
+};
+
+}  // namespace NetworkAnalyticalCongestionAware
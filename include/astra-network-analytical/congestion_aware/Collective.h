@@ -0,0 +1,245 @@
+/******************************************************************************
+This source code is licensed under the MIT license found in the
+LICENSE file in the root directory of this source tree.
+*******************************************************************************/
+
+#pragma once
+
+#include "common/EventCallback.h"
+#include "common/Type.h"
+#include "congestion_aware/Topology.h"
+#include <memory>
+#include <utility>
+#include <vector>
+
+using namespace NetworkAnalytical;
+
+namespace NetworkAnalyticalCongestionAware {
+
+/**
+ * Collective runs a collective communication over every NPU of a topology.
+ *
+ * The collective is unrolled into steps: messages from one NPU to another,
+ * each released once the steps it depends on have arrived
+ * (e.g., a ring step forwards what the previous step delivered).
+ * Step state lives in flat arrays indexed by step id, with the dependents of each step in CSR form,
+ * and only steps whose dependencies are met are sent, so the event queue holds live steps only.
+ * Steps are sent with Topology::send_message(), whose chunks come from the chunk pool.
+ *
+ * Sizes follow the per-NPU buffer: the input of AllReduce, ReduceScatter and AllToAll,
+ * and the output of AllGather.
+ */
+class Collective {
+  public:
+    /// collective communication
+    enum class Type {
+        AllReduce,
+        AllGather,
+        ReduceScatter,
+        AllToAll
+    };
+
+    /// algorithm the collective is unrolled with
+    enum class Algorithm {
+        Ring,             // neighbor-to-neighbor ring over every NPU
+        Direct,           // every NPU exchanges with every other NPU at once
+        HalvingDoubling,  // recursive halving (ReduceScatter) and doubling (AllGather), power-of-2 NPUs
+        Tree,             // binary-tree reduce then broadcast, AllReduce only
+        Hierarchical      // one ring (direct for AllToAll) per dimension, dimension by dimension
+    };
+
+    /**
+     * Constructor.
+     *
+     * @param topology topology to run the collective on
+     * @param type collective communication
+     * @param algorithm algorithm to unroll the collective with
+     * @param size size of the per-NPU buffer in bytes
+     * @param chunk_size size of the chunks each step is segmented into
+     */
+    Collective(std::shared_ptr<Topology> topology,
+               Type type,
+               Algorithm algorithm,
+               ChunkSize size,
+               ChunkSize chunk_size) noexcept;
+
+    /**
+     * Start the collective at the current time.
+     * The collective can be started again once finished.
+     *
+     * @param callback callback to be invoked when every step arrived
+     * @param callback_arg argument of the callback
+     */
+    void start(Callback callback, CallbackArg callback_arg) noexcept;
+
+    /**
+     * Start the collective at the current time.
+     * Same as above, with any callable as the completion callback.
+     * With no steps to run (e.g., a single NPU), the callback is invoked right away.
+     *
+     * @param callback callable to be invoked when every step arrived
+     */
+    void start(EventCallback callback) noexcept;
+
+    /**
+     * Get the number of steps of the collective.
+     *
+     * @return number of steps
+     */
+    [[nodiscard]] int get_steps_count() const noexcept;
+
+    /**
+     * Get the number of steps sent and not arrived yet.
+     *
+     * @return number of live steps
+     */
+    [[nodiscard]] int get_live_steps_count() const noexcept;
+
+    /**
+     * Check whether every step of the last start() arrived.
+     *
+     * @return true if finished, false otherwise
+     */
+    [[nodiscard]] bool finished() const noexcept;
+
+  private:
+    /// topology the collective runs on
+    std::shared_ptr<Topology> topology;
+
+    /// size of the chunks each step is segmented into
+    ChunkSize chunk_size;
+
+    /// step_srcs[step] -> NPU sending the step
+    std::vector<DeviceId> step_srcs;
+
+    /// step_dests[step] -> NPU receiving the step
+    std::vector<DeviceId> step_dests;
+
+    /// step_sizes[step] -> size of the step in bytes
+    std::vector<ChunkSize> step_sizes;
+
+    /// dependencies_counts[step] -> number of steps it waits for
+    std::vector<int> dependencies_counts;
+
+    /// dependents of step s are dependents[dependent_offsets[s], dependent_offsets[s + 1])
+    std::vector<int> dependent_offsets;
+
+    /// steps waiting for each step, grouped by the step they wait for
+    std::vector<int> dependents;
+
+    /// remaining_dependencies[step] -> number of steps it still waits for in the current run
+    std::vector<int> remaining_dependencies;
+
+    /// number of steps arrived in the current run
+    int arrived_steps_count;
+
+    /// number of steps sent and not arrived yet
+    int live_steps_count;
+
+    /// callback invoked when every step arrived
+    EventCallback callback;
+
+    /// while unrolling: steps each NPU waits for before its next phase
+    std::vector<std::vector<int>> ready_steps;
+
+    /// while unrolling: (step, dependent step) pairs
+    std::vector<std::pair<int, int>> dependency_edges;
+
+    /**
+     * Add a step waiting for the given steps.
+     *
+     * @param src NPU sending the step
+     * @param dest NPU receiving the step
+     * @param size size of the step in bytes
+     * @param dependencies steps to wait for
+     * @return id of the step
+     */
+    int add_step(DeviceId src, DeviceId dest, ChunkSize size, const std::vector<int>& dependencies) noexcept;
+
+    /**
+     * Add a ring phase: at each step, every member sends a block to the next member,
+     * once it received the previous step's block.
+     *
+     * @param group NPUs of the ring, in ring order
+     * @param block_sizes size of the block sent at each step
+     */
+    void add_ring(const std::vector<DeviceId>& group, const std::vector<ChunkSize>& block_sizes) noexcept;
+
+    /**
+     * Add a direct phase: every member sends a block to every other member at once.
+     *
+     * @param group NPUs of the phase
+     * @param block_size size of each block
+     */
+    void add_direct(const std::vector<DeviceId>& group, ChunkSize block_size) noexcept;
+
+    /**
+     * Add a pairwise-exchange phase: at each step, every member exchanges a block with
+     * the member whose index differs by the step's distance (xor),
+     * once it received the previous step's block.
+     *
+     * @param group NPUs of the phase, a power of 2 of them
+     * @param distances index distance of the partners at each step
+     * @param block_sizes size of the block exchanged at each step
+     */
+    void add_pairwise_exchange(const std::vector<DeviceId>& group,
+                               const std::vector<int>& distances,
+                               const std::vector<ChunkSize>& block_sizes) noexcept;
+
+    /**
+     * Add a binary-tree reduce to the first member: every member sends the buffer to its parent
+     * once its children's buffers arrived.
+     *
+     * @param group NPUs of the tree, in heap order
+     * @param size size of the buffer
+     */
+    void add_tree_reduce(const std::vector<DeviceId>& group, ChunkSize size) noexcept;
+
+    /**
+     * Add a binary-tree broadcast from the first member: every member forwards the buffer to its children
+     * once it arrived from its parent.
+     *
+     * @param group NPUs of the tree, in heap order
+     * @param size size of the buffer
+     */
+    void add_tree_broadcast(const std::vector<DeviceId>& group, ChunkSize size) noexcept;
+
+    /**
+     * Add the phases of a collective over a group with a single-level algorithm.
+     *
+     * @param group NPUs of the collective
+     * @param type collective communication
+     * @param algorithm Ring, Direct, HalvingDoubling or Tree
+     * @param size size of the per-NPU buffer
+     */
+    void add_collective(const std::vector<DeviceId>& group, Type type, Algorithm algorithm, ChunkSize size) noexcept;
+
+    /**
+     * Get the groups of NPUs differing only in their address of a dimension.
+     *
+     * @param dim dimension
+     * @return groups, members ordered by their address of the dimension
+     */
+    [[nodiscard]] std::vector<std::vector<DeviceId>> get_dim_groups(int dim) const noexcept;
+
+    /**
+     * Build the dependents of every step from the dependency edges.
+     */
+    void build_dependents() noexcept;
+
+    /**
+     * Send a step whose dependencies have arrived.
+     *
+     * @param step id of the step
+     */
+    void send_step(int step) noexcept;
+
+    /**
+     * Handle the arrival of a step.
+     *
+     * @param step id of the step
+     */
+    void step_arrived(int step) noexcept;
+};
+
+}  // namespace NetworkAnalyticalCongestionAware
@@ -0,0 +1,76 @@
+/******************************************************************************
+This source code is licensed under the MIT license found in the
+LICENSE file in the root directory of this source tree.
+*******************************************************************************/
+
+#pragma once
+
+#include "common/Type.h"
+#include "congestion_aware/Topology.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+
+using namespace NetworkAnalytical;
+
+namespace NetworkAnalyticalCongestionAware {
+
+/**
+ * CompiledTopology is a topology loaded from a snapshot (see Topology::save_snapshot()).
+ *
+ * The snapshot is a flat binary file holding the devices, the links of every port,
+ * and the route of every NPU pair, so loading it only instantiates the links
+ * and maps the route table read-only: no input file is parsed and no route is computed.
+ * Short runs of the same network therefore skip construction entirely,
+ * and concurrent processes share the route table through the page cache.
+ *
+ * Only topologies with static routes can be compiled.
+ */
+class CompiledTopology : public Topology {
+  public:
+    /**
+     * Save a snapshot of the topology to a binary file.
+     * The file is written aside and renamed into place, so it's never seen partially written.
+     *
+     * @param topology topology to save, with static routes
+     * @param path path of the file
+     * @param key key identifying the network the topology was constructed from
+     * @return true if the file has been written, false otherwise (e.g., routes aren't static)
+     */
+    [[nodiscard]] static bool save(const Topology& topology, const std::string& path, uint64_t key) noexcept;
+
+    /**
+     * Load a snapshot saved by save().
+     *
+     * @param path path of the file
+     * @param key key identifying the network the topology should have been constructed from
+     * @return loaded topology, nullptr if the file is missing, corrupted, of another version, or saved with another key
+     */
+    [[nodiscard]] static std::shared_ptr<CompiledTopology> load(const std::string& path, uint64_t key) noexcept;
+
+    /**
+     * Construct the route from src to dest, as recorded in the snapshot.
+     *
+     * @param src src NPU id
+     * @param dest dest NPU id
+     * @return route from src NPU to dest NPU
+     */
+    [[nodiscard]] Route route(DeviceId src, DeviceId dest) const noexcept override;
+
+  private:
+    /// mapping of the snapshot file, owning the route table
+    std::shared_ptr<const uint8_t> mapping;
+
+    /// route of pair (src, dest) spans route_nodes[route_offsets[src * npus_count + dest], ... + 1])
+    const uint64_t* route_offsets;
+
+    /// device ids of every route, back-to-back
+    const int32_t* route_nodes;
+
+    /**
+     * Constructor. Topologies are constructed through load().
+     */
+    CompiledTopology() noexcept;
+};
+
+}  // namespace NetworkAnalyticalCongestionAware
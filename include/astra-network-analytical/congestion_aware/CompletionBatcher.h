@@ -0,0 +1,115 @@
+/******************************************************************************
+This source code is licensed under the MIT license found in the
+LICENSE file in the root directory of this source tree.
+*******************************************************************************/
+
+#pragma once
+
+#include "common/EventQueue.h"
+#include "common/Type.h"
+#include "congestion_aware/Type.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+using namespace NetworkAnalytical;
+
+namespace NetworkAnalyticalCongestionAware {
+
+/**
+ * CompletionBatcher hands the chunks completing at the same time over to their sink at once.
+ *
+ * A sink is identified by the callback function chunks are sent with (e.g., the handler of a system layer).
+ * Instead of invoking that callback once per chunk, the batcher gathers the callback arguments
+ * of every chunk of the sink completing at the current time into a contiguous array,
+ * and invokes the batched callback of the sink once with all of them,
+ * after every other event of the time (see EventQueue::schedule_time_end_event()).
+ * Sinks are flushed in the order they were added.
+ * Chunks sent with another callback (or a callable) are completed one by one, as usual.
+ *
+ * A batcher belongs to one simulation context (see SimulationContext::set_completion_batcher()),
+ * which is simulated by a single thread, so contexts batching completions can't be partitioned by a ParallelSimulator.
+ */
+class CompletionBatcher {
+  public:
+    /// callback invoked with the arguments of the chunks of a sink completed at the current time
+    using BatchedCallback = void (*)(CallbackArg* callback_args, size_t count, void* sink_arg);
+
+    /**
+     * Add a sink. Exits the program if a sink of the same callback already exists.
+     * Sinks shouldn't be added from a batched callback.
+     *
+     * @param callback callback the chunks of the sink are sent with
+     * @param batched_callback callback invoked instead, once per time
+     * @param sink_arg argument given to batched_callback
+     */
+    void add_sink(Callback callback, BatchedCallback batched_callback, void* sink_arg = nullptr) noexcept;
+
+    /**
+     * Gather a chunk that's arrived at its destination, if it belongs to a sink.
+     * The first chunk gathered at a time schedules the flush of the time on the event queue.
+     *
+     * @param chunk chunk that's arrived at its destination
+     * @param event_queue event queue the chunk completed on
+     * @return true if the chunk got gathered (so its callback shouldn't be invoked), false otherwise
+     */
+    bool gather(const Chunk& chunk, EventQueue* event_queue) noexcept;
+
+    /**
+     * Drop the gathered chunks not flushed yet, e.g., once their event queue is reset.
+     * Counters are reset as well, while sinks are kept.
+     */
+    void reset() noexcept;
+
+    /**
+     * Get the number of batched callbacks invoked so far.
+     *
+     * @return number of batches
+     */
+    [[nodiscard]] uint64_t get_batches_count() const noexcept;
+
+    /**
+     * Get the number of chunks handed over in batches so far.
+     *
+     * @return number of batched chunks
+     */
+    [[nodiscard]] uint64_t get_batched_chunks_count() const noexcept;
+
+  private:
+    /// chunks of a sink, gathered until the end of the current time
+    struct Sink {
+        /// callback the chunks of the sink are sent with
+        Callback callback;
+
+        /// callback invoked with the gathered chunks
+        BatchedCallback batched_callback;
+
+        /// argument of batched_callback
+        void* sink_arg;
+
+        /// callback arguments of the chunks gathered at the current time
+        std::vector<CallbackArg> callback_args;
+
+        /// callback arguments being handed over (kept to reuse its storage)
+        std::vector<CallbackArg> flushing_callback_args;
+    };
+
+    /// sinks, in the order they were added
+    std::vector<Sink> sinks;
+
+    /// whether the flush of the current time is scheduled
+    bool flush_scheduled = false;
+
+    /// number of batched callbacks invoked
+    uint64_t batches_count = 0;
+
+    /// number of chunks handed over in batches
+    uint64_t batched_chunks_count = 0;
+
+    /**
+     * Hand the gathered chunks over to their sinks.
+     */
+    void flush() noexcept;
+};
+
+}  // namespace NetworkAnalyticalCongestionAware
@@ -5,10 +5,16 @@ LICENSE file in the root directory of this source tree.
 
 #pragma once
 
+#include "common/MemoryCounter.h"
 #include "common/Type.h"
+#include "congestion_aware/Link.h"
+#include "congestion_aware/SimulationContext.h"
 #include "congestion_aware/Type.h"
-#include <map>
+#include <deque>
 #include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 using namespace NetworkAnalytical;
 
@@ -17,6 +23,11 @@ namespace NetworkAnalyticalCongestionAware {
 /**
  * Device class represents a single device in the network.
  * Device is usually an NPU or a switch.
+ *
+ * Links are either connected one by one, each created at once,
+ * or lazily by regular groups of destinations (see connect_lazily()):
+ * ports of a group are computed arithmetically, and their links are only created when first used,
+ * so a dense but sparsely used connectivity (e.g., a large FullyConnected) costs no memory per idle link.
  */
 class Device {
   public:
@@ -24,8 +35,18 @@ class Device {
      * Constructor.
      *
      * @param id id of the device
+     * @param devices_memory counter of the memory held by the port tables of the device, nullptr for none
+     * @param links_memory counter of the memory held by the links of the device, nullptr for none
+     * @param pending_chunks_memory counter of the memory held by the pending chunks queues of the links,
+     *                              nullptr for none
+     * @param link_ids ids of the links of the topology to take the ids of the links from,
+     *                 nullptr for ids of the device's own
      */
-    explicit Device(DeviceId id) noexcept;
+    Device(DeviceId id,
+           std::shared_ptr<MemoryCounter> devices_memory = nullptr,
+           std::shared_ptr<MemoryCounter> links_memory = nullptr,
+           std::shared_ptr<MemoryCounter> pending_chunks_memory = nullptr,
+           std::shared_ptr<LinkStates::LinkIds> link_ids = nullptr) noexcept;
 
     /**
      * Get id of the device.
@@ -51,6 +72,58 @@ class Device {
      */
     void connect(DeviceId id, Bandwidth bandwidth, Latency latency) noexcept;
 
+    /**
+     * Connect this device to the devices first_dest + (k * stride) for k in [0, count), except itself,
+     * with links created on their first use.
+     * Lazy groups come after every link connected by connect().
+     *
+     * @param first_dest id of the first device of the group
+     * @param stride id difference between consecutive devices of the group
+     * @param count number of devices of the group, including this device if it belongs to it
+     * @param bandwidth bandwidth of the links
+     * @param latency latency of the links
+     */
+    void connect_lazily(DeviceId first_dest, int stride, int count, Bandwidth bandwidth, Latency latency) noexcept;
+
+    /**
+     * Drop the lazily created links that are idle (see Link::is_idle()),
+     * so they take no memory until used again. Their statistics, if compiled in, are dropped too.
+     *
+     * @param context simulation context the links are checked in
+     * @param current_time current simulation time
+     * @return number of links dropped
+     */
+    int release_idle_links(SimulationContext& context, EventTime current_time) noexcept;
+
+    /**
+     * Get the number of links created so far (lazy links only count once used).
+     *
+     * @return number of links in memory
+     */
+    [[nodiscard]] int get_materialized_links_count() const noexcept;
+
+    /**
+     * Return every link of the device to its initial state (see Link::reset()).
+     *
+     * @param context simulation context the links are reset in
+     */
+    void reset(SimulationContext& context) noexcept;
+
+    /**
+     * Bound the buffer of every link of the device, including the ones connected or created afterwards
+     * (see Link::set_buffer_size()).
+     *
+     * @param buffer_size size of the buffer of each link in bytes, 0 for unbounded buffers
+     */
+    void set_buffer_size(ChunkSize buffer_size) noexcept;
+
+    /**
+     * Get the size of the buffer of the links of the device.
+     *
+     * @return size of the buffer of each link in bytes, 0 if unbounded
+     */
+    [[nodiscard]] ChunkSize get_buffer_size() const noexcept;
+
     /**
      * Check if this device is connected to another device.
      *
@@ -59,13 +132,112 @@ class Device {
      */
     [[nodiscard]] bool connected(DeviceId dest) const noexcept;
 
+    /**
+     * Get the port connecting this device to another device.
+     *
+     * @param dest id of the destination device
+     * @return port towards dest, -1 if not connected
+     */
+    [[nodiscard]] PortId get_port(DeviceId dest) const noexcept;
+
+    /**
+     * Get the number of ports (outgoing links) of this device.
+     *
+     * @return number of ports
+     */
+    [[nodiscard]] int get_ports_count() const noexcept;
+
+    /**
+     * Get the link of a port.
+     * A lazy link is created on its first use.
+     *
+     * @param port port of the link
+     * @return link of the port
+     */
+    [[nodiscard]] Link& get_link(PortId port) noexcept;
+
+    /**
+     * Get the link of a port.
+     * A lazy link not created yet is seen as an idle link of its group.
+     *
+     * @param port port of the link
+     * @return link of the port
+     */
+    [[nodiscard]] const Link& get_link(PortId port) const noexcept;
+
+    /**
+     * Get the device a port is connected to.
+     *
+     * @param port port of the link
+     * @return id of the device at the other end
+     */
+    [[nodiscard]] DeviceId get_port_dest(PortId port) const noexcept;
+
   private:
+    /// a group of lazily connected ports (see connect_lazily())
+    struct LazyPorts {
+        /// port of the first device of the group
+        PortId first_port;
+
+        /// number of ports of the group
+        int ports_count;
+
+        /// id of the first device of the group
+        DeviceId first_dest;
+
+        /// id difference between consecutive devices of the group
+        int stride;
+
+        /// number of devices of the group, including this device if it belongs to it
+        int count;
+
+        /// index of this device in the group, -1 if it doesn't belong to it
+        int self_index;
+
+        /// link of the group that's never used, standing for the links not created yet
+        Link idle_link;
+    };
+
     /// device Id
     DeviceId device_id;
 
-    /// links to other nodes
-    /// map[dest node node_id] -> link
-    std::map<DeviceId, std::shared_ptr<Link>> links;
+    /// links to other nodes, indexed by port
+    /// (std::deque keeps the addresses stable, as events refer to links)
+    std::deque<Link, TrackingAllocator<Link>> links;
+
+    /// port -> dest device id
+    TrackedVector<DeviceId> port_dests;
+
+    /// (dest device id, port) pairs sorted by dest device id
+    TrackedVector<std::pair<DeviceId, PortId>> ports;
+
+    /// lazily connected port groups, in port order after the ports of links
+    std::deque<LazyPorts, TrackingAllocator<LazyPorts>> lazy_ports;
+
+    /// lazy links created so far, by port (node-based, so addresses are stable)
+    std::unordered_map<PortId,
+                       Link,
+                       std::hash<PortId>,
+                       std::equal_to<PortId>,
+                       TrackingAllocator<std::pair<const PortId, Link>>>
+        lazy_links;
+
+    /// counter of the memory held by the pending chunks queues of the links, given to each new link
+    std::shared_ptr<MemoryCounter> pending_chunks_memory;
+
+    /// ids the links take their id from
+    std::shared_ptr<LinkStates::LinkIds> link_ids;
+
+    /// size of the buffer of each link in bytes, 0 if unbounded
+    ChunkSize buffer_size;
+
+    /**
+     * Get the lazy port group of a port.
+     *
+     * @param port lazy port
+     * @return group of the port
+     */
+    [[nodiscard]] const LazyPorts& get_lazy_ports(PortId port) const noexcept;
 };
 
 }  // namespace NetworkAnalyticalCongestionAware
@@ -0,0 +1,177 @@
+/******************************************************************************
+This source code is licensed under the MIT license found in the
+LICENSE file in the root directory of this source tree.
+*******************************************************************************/
+
+#pragma once
+
+#include "common/CounterRng.h"
+#include "common/Type.h"
+#include "congestion_aware/BasicTopology.h"
+#include <string>
+#include <vector>
+
+using namespace NetworkAnalytical;
+
+namespace NetworkAnalyticalCongestionAware {
+
+/**
+ * Implements a Dragonfly topology.
+ *
+ * Hosts (NPUs) attach to routers, hosts_per_router of them per router.
+ * Routers form groups of routers_per_group, fully connected by local links,
+ * and each router has global_links_per_router global links to routers of other groups,
+ * so each group has (routers_per_group * global_links_per_router) global ports.
+ * With up to (global ports per group + 1) groups, every pair of groups is joined by one global link.
+ * The arrangement picks which global port of a group leads to which group:
+ *   - Absolute: port k of group i leads to group k (k < i), or k + 1 (k >= i)
+ *   - Relative: port k of group i leads to group (i + k + 1) % groups_count
+ *   - Circulant: ports 2o - 2 and 2o - 1 of group i lead to groups (i + o) and (i - o), o = 1, 2, ...
+ * Global ports of a group are numbered router by router, so port k belongs to router k / global_links_per_router.
+ *
+ * Device ID layout:
+ * [0, npus_count) = hosts, hosts_per_router per router in router order
+ * [npus_count, npus_count + groups_count * routers_per_group) = routers, routers_per_group per group in group order
+ *
+ * Routes follow from the group and router coordinates alone, with no per-pair tables:
+ *   - Minimal: src router -> gateway router of the src group -> its peer in the dest group -> dest router
+ *   - Valiant: minimal to a random router of a random intermediate group, then minimal to the dest
+ *   - Ugal: Valiant if its backlog times hops is less than the minimal route's, minimal otherwise
+ * Routes within a group are always minimal.
+ * route() can be called from several threads at once: random routes draw from a counter-based stream
+ * keyed by the next flow of their src (see CounterRng), or from the caller's.
+ */
+class Dragonfly final : public BasicTopology {
+  public:
+    /// which global port of a group leads to which group
+    enum class Arrangement {
+        Absolute,
+        Relative,
+        Circulant
+    };
+
+    /// routing algorithm types for Dragonfly
+    enum class RoutingAlgorithm {
+        Minimal,  // at most one global hop
+        Valiant,  // through a random intermediate group
+        Ugal      // minimal or Valiant, whichever is less backlogged
+    };
+
+    /**
+     * Constructor.
+     *
+     * @param groups_count number of groups, in [2, routers_per_group * global_links_per_router + 1]
+     * @param routers_per_group number of routers per group
+     * @param hosts_per_router number of hosts (NPUs) per router
+     * @param global_links_per_router number of global links per router
+     * @param bandwidth bandwidth of each link
+     * @param latency latency of each link
+     * @param arrangement "Absolute" (default), "Relative", or "Circulant"
+     * @param routing_algorithm "Minimal" (default), "Valiant", or "UGAL"
+     */
+    Dragonfly(int groups_count,
+              int routers_per_group,
+              int hosts_per_router,
+              int global_links_per_router,
+              Bandwidth bandwidth,
+              Latency latency,
+              const std::string& arrangement = "Absolute",
+              const std::string& routing_algorithm = "Minimal") noexcept;
+
+    /**
+     * Implementation of route function in Topology.
+     */
+    [[nodiscard]] Route route(DeviceId src, DeviceId dest) const noexcept override;
+
+    /**
+     * Construct the route from src to dest, drawing the intermediate groups and routers
+     * of Valiant routes from the given stream, so callers (e.g., one per thread) get reproducible routes of their own.
+     *
+     * @param src src NPU id
+     * @param dest dest NPU id
+     * @param rng random stream Valiant and UGAL routing draw from
+     * @return route from src NPU to dest NPU
+     */
+    [[nodiscard]] Route route(DeviceId src, DeviceId dest, CounterRng& rng) const noexcept;
+
+    /**
+     * Clone this topology instance.
+     */
+    [[nodiscard]] std::unique_ptr<BasicTopology> clone() const noexcept override;
+
+    /**
+     * Get the group a global port of a group leads to.
+     *
+     * @param group group of the port
+     * @param port global port of the group
+     * @return group the port leads to, -1 if the port is unused
+     */
+    [[nodiscard]] int get_peer_group(int group, int port) const noexcept;
+
+    /**
+     * Get the global port of a group leading to another group.
+     *
+     * @param group group of the port
+     * @param peer_group group the port leads to, other than group
+     * @return global port of the group
+     */
+    [[nodiscard]] int get_gateway_port(int group, int peer_group) const noexcept;
+
+  private:
+    /// router path between hosts: at most src, gateway, entry, intermediate, exit, gateway, dest routers
+    using RouterPath = std::vector<DeviceId>;
+
+    /// number of groups
+    int groups_count;
+
+    /// number of routers per group
+    int routers_per_group;
+
+    /// number of hosts per router
+    int hosts_per_router;
+
+    /// number of global links per router
+    int global_links_per_router;
+
+    /// which global port of a group leads to which group
+    Arrangement arrangement;
+
+    /// routing algorithm mode
+    RoutingAlgorithm routing_algorithm;
+
+    /// arrangement, as given
+    std::string arrangement_str;
+
+    /// routing algorithm, as given
+    std::string routing_algorithm_str;
+
+    [[nodiscard]] static Arrangement str2Arrangement(const std::string& arrangement_str) noexcept;
+    [[nodiscard]] static RoutingAlgorithm str2RoutingAlgorithm(const std::string& algo_str) noexcept;
+
+    /**
+     * Get the device id of a router, by its index among every router.
+     */
+    [[nodiscard]] DeviceId get_router_id(int router) const noexcept;
+
+    /**
+     * Append the minimal path from a router to another, excluding the first router.
+     *
+     * @param from index of the first router
+     * @param to index of the last router
+     * @param path path to append the device ids to
+     */
+    void append_minimal_path(int from, int to, RouterPath& path) const noexcept;
+
+    /**
+     * Append the Valiant path from a router to another, excluding the first router,
+     * through a random router of a group other than theirs.
+     */
+    void append_valiant_path(int from, int to, RouterPath& path, CounterRng& rng) const noexcept;
+
+    /**
+     * Get the backlog of a path times its number of hops.
+     */
+    [[nodiscard]] ChunkSize compute_path_cost(const RouterPath& path) const noexcept;
+};
+
+}  // namespace NetworkAnalyticalCongestionAware
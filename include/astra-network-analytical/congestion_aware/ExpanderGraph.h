@@ -5,11 +5,19 @@ LICENSE file in the root directory of this source tree.
 
 #pragma once
 
+#include <cstdint>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <vector>
 #include <set>
 #include <string>
 
+#include "common/CounterRng.h"
+#include "common/CsrGraph.h"
+#include "common/DistanceMatrix.h"
+#include "common/KShortestPaths.h"
+#include "common/ShardedMap.h"
 #include "common/Type.h"
 #include "congestion_aware/BasicTopology.h"
 
@@ -22,6 +30,10 @@ namespace NetworkAnalyticalCongestionAware {
  * ExpanderGraph(4) example:
  *
  * Therefore, arbitrary send between two pair of NPUs will take N hops on average.
+ *
+ * route() and get_distance() can be called from several threads at once:
+ * the per-pair path caches are sharded concurrent maps, the distance matrix is computed once,
+ * and random routes draw from a counter-based stream keyed by the next flow of their src (or from the caller's, see route()).
  */
 class ExpanderGraph final : public BasicTopology {
   public:
@@ -32,17 +44,84 @@ class ExpanderGraph final : public BasicTopology {
      * @param degree degree of the expander graph (unused if inputfile provided)
      * @param bandwidth bandwidth of each link
      * @param latency latency of each link
-     * @param inputfile path to JSON file defining the expander graph topology
+     * @param inputfile path to the JSON or binary edge-list file defining the expander graph topology (see ExpanderGraphFile)
      */
     ExpanderGraph(int npus_count, Bandwidth bandwidth, Latency latency, const std::string& inputfile = std::string(), const std::string& routing_algorithm = std::string(), bool use_resiliency = false) noexcept;
     unsigned int get_distance(const DeviceId src, const DeviceId dest, std::set<DeviceId> visited, unsigned int current_distance) const noexcept;
     std::map<DeviceId, std::vector<DeviceId>> adjacency_list;
+
+    /**
+     * Get the graph of the topology searches run on, without the failed links and devices (see fail_link()).
+     *
+     * @return graph in CSR form
+     */
+    [[nodiscard]] const CsrGraph& get_graph() const noexcept;
     [[nodiscard]] Route route(DeviceId src, DeviceId dest) const noexcept override;
+
+    /**
+     * Construct the route from src to dest, drawing random routes from the given stream,
+     * so callers (e.g., one per thread) get reproducible routes of their own.
+     *
+     * @param src src NPU id
+     * @param dest dest NPU id
+     * @param rng random stream RandomTopK routing draws from
+     * @return route from src NPU to dest NPU
+     */
+    [[nodiscard]] Route route(DeviceId src, DeviceId dest, CounterRng& rng) const noexcept;
     [[nodiscard]] std::unique_ptr<BasicTopology> clone() const noexcept override;
+
+    /**
+     * Precompute the next hop and the distance between every pair of devices,
+     * running one BFS per source across a pool of threads.
+     * Afterwards, shortest-path routes and distances are table walks instead of searches.
+     * The tables take 3 bytes per pair (e.g., 12 MB for 2k devices).
+     *
+     * @param threads_count number of threads, 0 to use the hardware concurrency
+     */
+    void precompute_shortest_paths(int threads_count = 0) noexcept;
+
+    /**
+     * Precompute the shortest-path tables (see precompute_shortest_paths()) if not done yet,
+     * then fill the route cache from them (see Topology::precompute_routes()).
+     *
+     * @param threads_count number of threads, 0 to use the hardware concurrency
+     */
+    void precompute_routes(int threads_count = 0) noexcept override;
+
+    /**
+     * Check whether the shortest-path tables have been precomputed.
+     *
+     * @return true if precompute_shortest_paths() has been called
+     */
+    [[nodiscard]] bool shortest_paths_precomputed() const noexcept;
+
+    /**
+     * Precompute the candidate paths of RandomTopK and Adaptive routing for every pair of NPUs.
+     * The paths are loaded from a sidecar file next to the input file ("<inputfile>.ksp")
+     * if it was saved for the same file content, number of paths and resiliency mode.
+     * Otherwise, they are computed across a pool of threads and saved there for the next runs.
+     * Topologies of the same graph in the process share a single copy of the paths.
+     *
+     * @param threads_count number of threads, 0 to use the hardware concurrency
+     */
+    void precompute_k_shortest_paths(int threads_count = 0) noexcept;
+
+    /**
+     * Implementation of memory_report in Topology, adding the distance tables and the path caches.
+     */
+    [[nodiscard]] MemoryReport memory_report() const noexcept override;
+
   private:
+    /// path of device ids, counted in the memory of the cache holding it
+    using CachedPath = TrackedVector<DeviceId>;
+
+    /// candidate paths of a pair, counted in the memory of topk_route_cache
+    using CachedPaths = std::vector<CachedPath, TrackingAllocator<CachedPath>>;
+
     enum class RoutingAlgorithm {
         ShortestPath,
-        RandomTopK
+        RandomTopK,
+        Adaptive  // least backlogged of the top-k paths
     };
     RoutingAlgorithm str2RoutingAlgorithm(const std::string& algo_str);
     RoutingAlgorithm routing_algorithm = RoutingAlgorithm::ShortestPath;
@@ -50,17 +129,111 @@ class ExpanderGraph final : public BasicTopology {
     std::string routing_algorithm_str;
     bool use_resiliency = false;
     Route route_shortest_path(DeviceId src, DeviceId dest) const noexcept;
-    Route route_random_topk(DeviceId src, DeviceId dest) const noexcept;
+    Route route_random_topk(DeviceId src, DeviceId dest, CounterRng& rng) const noexcept;
+
+    /**
+     * Route through the candidate path of RandomTopK routing
+     * with the least bytes pending on its links at the time of the call.
+     * Ties go to the shorter path, so an idle network routes along shortest paths.
+     */
+    Route route_adaptive(DeviceId src, DeviceId dest) const noexcept;
+
+    /**
+     * Find the k shortest paths from src to dest (sorted by length), cached per pair.
+     */
+    const CachedPaths& find_topk_paths(DeviceId src, DeviceId dest) const noexcept;
 
     /**
      * Implements the compute_hops_count method of BasicTopology.
      */
     [[nodiscard]] int compute_hops_count(DeviceId src, DeviceId dest) const noexcept;
-    // distance cache to speed up distance calculations
-    mutable std::map<std::pair<DeviceId, DeviceId>, unsigned int> distance_cache;
-    void connect(DeviceId src, DeviceId dest);
-    mutable std::map<std::pair<DeviceId, DeviceId>, std::vector<std::vector<DeviceId>>> topk_route_cache;
-    mutable std::map<std::pair<DeviceId, DeviceId>, std::vector<DeviceId>> shortest_route_cache;
+    // adjacency_list in CSR form, used by every search
+    CsrGraph graph;
+
+    /// memory held by distance_matrix, next_hop_table and distance_table
+    std::shared_ptr<MemoryCounter> distance_cache_memory = std::make_shared<MemoryCounter>();
+
+    /// memory held by shortest_route_cache
+    std::shared_ptr<MemoryCounter> shortest_route_cache_memory = std::make_shared<MemoryCounter>();
+
+    /// memory held by topk_route_cache
+    std::shared_ptr<MemoryCounter> topk_route_cache_memory = std::make_shared<MemoryCounter>();
+
+    // distances between every pair of devices, computed on the first distance query
+    mutable DistanceMatrix distance_matrix;
+
+    /// guards the computation of distance_matrix on the first distance query
+    mutable std::once_flag distance_matrix_computed;
+
+    /// (src, dest) -> k shortest paths found by find_topk_paths()
+    mutable ShardedMap<CachedPaths> topk_route_cache{topk_route_cache_memory};
+
+    /// (src, dest) -> shortest path found by a search
+    mutable ShardedMap<CachedPath> shortest_route_cache{shortest_route_cache_memory};
+
+    /// maximum number of candidate paths per pair of RandomTopK routing
+    static constexpr int k_max_paths = 16;
+
+    /// precomputed candidate paths of RandomTopK routing, nullptr if not precomputed
+    std::shared_ptr<const KShortestPaths> k_shortest_paths;
+
+    /// distance_table entry of a pair with no path
+    static constexpr uint8_t unreachable_distance = UINT8_MAX;
+
+    /// number of devices covered by the precomputed tables, 0 if not precomputed
+    int table_devices_count = 0;
+
+    /// next_hop_table[src * table_devices_count + dest] -> next device from src towards dest
+    TrackedVector<uint16_t> next_hop_table{TrackingAllocator<uint16_t>(distance_cache_memory)};
+
+    /// distance_table[src * table_devices_count + dest] -> number of hops from src to dest
+    TrackedVector<uint8_t> distance_table{TrackingAllocator<uint8_t>(distance_cache_memory)};
+
+    /**
+     * Build the shortest route from src to dest by walking next_hop_table.
+     */
+    [[nodiscard]] Route route_from_tables(DeviceId src, DeviceId dest) const noexcept;
+
+    /**
+     * Refill rows of the shortest-path tables from the graph, one BFS per source across a pool of threads.
+     *
+     * @param sources sources of the rows to fill
+     * @param threads_count number of threads, 0 to use the hardware concurrency
+     */
+    void fill_shortest_path_rows(const std::vector<DeviceId>& sources, int threads_count) noexcept;
+
+    /**
+     * Check whether RandomTopK and Adaptive routing draw from the precomputed paths,
+     * which only hold while nothing has failed.
+     */
+    [[nodiscard]] bool uses_precomputed_paths() const noexcept;
+
+    /**
+     * Rebuild the graph searches run on from adjacency_list, without the failed links and devices.
+     */
+    void rebuild_graph() noexcept;
+
+    /**
+     * Compute the number of hops from a device to every device on the graph, -1 if unreachable.
+     */
+    [[nodiscard]] std::vector<int> compute_distances_from(DeviceId src) const noexcept;
+
+    /**
+     * Check whether a path of device ids crosses a failed link or device.
+     */
+    [[nodiscard]] bool path_crosses_failure(const CachedPath& path) const noexcept;
+
+    /**
+     * Implementation of update_failures in Topology:
+     * rebuild the graph, drop the cached paths the change invalidates,
+     * and refill the shortest-path table rows it may affect.
+     */
+    [[nodiscard]] bool update_failures(DeviceId src, DeviceId dest, bool failed) noexcept override;
+
+    /**
+     * Implementation of route_around_failures in Topology: the shortest path on the graph.
+     */
+    [[nodiscard]] Route route_around_failures(DeviceId src, DeviceId dest) const noexcept override;
 };
 
 }  // namespace NetworkAnalyticalCongestionAware
@@ -1,13 +1,14 @@
 #pragma once
 
-#include <map>
-#include <vector>
-#include <set>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <vector>
 
 #include "common/Type.h"
 #include "congestion_aware/BasicTopology.h"
-#include "congestion_aware/Switch.h"
 
 using namespace NetworkAnalytical;
 
@@ -20,7 +21,10 @@ class FatTree final: public BasicTopology {
          */
         enum class RoutingAlgorithm {
             Deterministic,  // Use deterministic routing (based on source/dest indices)
-            Random          // Randomly select among valid paths
+            Random,         // Select a path drawn from the random stream of (seed, src, dest, flow id)
+            Ecmp,           // Select a path by hashing (src, dest, flow id)
+            Spray,          // Rotate successive routes from a source over all valid paths
+            Adaptive        // Select the valid path with the least pending bytes on its links
         };
 
         /**
@@ -35,18 +39,82 @@ class FatTree final: public BasicTopology {
         FatTree(int npus_count, int k, Bandwidth bandwidth, Latency latency, 
                 const std::string& routing_algorithm = "Deterministic") noexcept;
         [[nodiscard]] Route route(DeviceId src, DeviceId dest) const noexcept override;
+
+        /**
+         * Reset the links, and restart packet spraying from the first path of every NPU.
+         */
+        void reset() noexcept override;
+
+        /**
+         * Construct the route of a flow from src to dest.
+         * In ECMP mode, the flow id is hashed along with src and dest to pick the spine/core switches,
+         * so chunks of the same flow follow the same path and distinct flows spread across paths.
+         * In Random mode, the flow id keys the random stream the path is drawn from (see CounterRng).
+         * Other modes ignore the flow id. route(src, dest) is the route of flow 0,
+         * or of the next flow of src in Random mode.
+         *
+         * @param src src NPU id
+         * @param dest dest NPU id
+         * @param flow_id id of the flow
+         * @return route from src NPU to dest NPU
+         */
+        [[nodiscard]] Route route(DeviceId src, DeviceId dest, uint64_t flow_id) const noexcept;
         [[nodiscard]] std::unique_ptr<BasicTopology> clone() const noexcept override;
     private:
+        /// switches a path goes through (at most leaf, spine, core, spine, leaf)
+        using PathSwitches = std::array<DeviceId, 5>;
+
         [[nodiscard]] int compute_hops_count(DeviceId src, DeviceId dest) const noexcept;
         [[nodiscard]] static RoutingAlgorithm str2RoutingAlgorithm(const std::string& algo_str) noexcept;
-        
-        std::vector<Switch> leaf_switches;
-        std::vector<Switch> spine_switches;
-        std::vector<Switch> core_switches;
+
+        /**
+         * Get the number of valid paths between two distinct leaves.
+         * Paths are numbered from 0: the spine within the pod,
+         * or (spine * k/2 + core column) across pods.
+         */
+        [[nodiscard]] int get_paths_count(int src_leaf, int dest_leaf) const noexcept;
+
+        /**
+         * Get the switches along a path between two distinct leaves, including both leaves.
+         *
+         * @return number of switches written to switches
+         */
+        int get_path_switches(int src_leaf, int dest_leaf, int path, PathSwitches& switches) const noexcept;
+
+        /**
+         * Pick the path from src to dest according to the routing algorithm.
+         */
+        [[nodiscard]] int select_path(DeviceId src, DeviceId dest, uint64_t flow_id) const noexcept;
+
+        /**
+         * Hash a flow key, with no state.
+         */
+        [[nodiscard]] static uint64_t hash_flow(DeviceId src, DeviceId dest, uint64_t flow_id) noexcept;
+
+        /**
+         * Get the leaf switch an NPU is connected to.
+         * Leaves are filled with k/2 NPUs each, in NPU id order.
+         */
+        [[nodiscard]] int get_leaf(DeviceId npu) const noexcept;
+
+        /**
+         * Get the device id of a leaf switch.
+         */
+        [[nodiscard]] DeviceId get_leaf_switch_id(int leaf) const noexcept;
+
+        /**
+         * Get the device id of a spine switch of a pod.
+         */
+        [[nodiscard]] DeviceId get_spine_switch_id(int pod, int spine_in_pod) const noexcept;
+
+        /**
+         * Get the device id of a core switch, numbered (spine in pod * k/2 + column).
+         */
+        [[nodiscard]] DeviceId get_core_switch_id(int core) const noexcept;
+
         int k;  // radix of the fat tree
-        std::vector<int> npus_per_leaf;  // number of NPUs connected to each leaf switch
-        std::vector<int> npu_to_leaf;  // mapping from NPU ID to leaf switch index
         RoutingAlgorithm routing_algorithm;  // routing algorithm mode
         std::string routing_algorithm_str;
+        std::unique_ptr<std::atomic<uint64_t>[]> spray_counters;  // number of sprayed routes per source NPU
 };
 } // namespace NetworkAnalyticalCongestionAware
\ No newline at end of file
@@ -0,0 +1,176 @@
+/******************************************************************************
+This source code is licensed under the MIT license found in the
+LICENSE file in the root directory of this source tree.
+*******************************************************************************/
+
+#pragma once
+
+#include "common/EventCallback.h"
+#include "common/EventHandle.h"
+#include "common/EventQueue.h"
+#include "common/Type.h"
+#include "congestion_aware/Topology.h"
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+using namespace NetworkAnalytical;
+
+namespace NetworkAnalyticalCongestionAware {
+
+/**
+ * FlowNetwork is a flow-level alternative to sending chunks through FIFO links.
+ *
+ * Each transfer is a flow over the route returned by the topology.
+ * Active flows share link bandwidth max-min fairly,
+ * and the rates are recomputed only when a flow starts or finishes its transmission,
+ * so the number of events is proportional to the number of flows,
+ * regardless of the transfer size or the route length.
+ *
+ * A flow finishes its transmission once all its bytes are sent at the rates assigned over time;
+ * its callback is invoked after the total latency of its route on top of that.
+ * The links of the topology are only used for their bandwidth and latency:
+ * flows and chunks shouldn't be mixed on the same topology.
+ */
+class FlowNetwork {
+  public:
+    /**
+     * Constructor.
+     *
+     * @param topology topology providing the routes and the link parameters
+     * @param event_queue event queue to schedule flow events on
+     */
+    FlowNetwork(std::shared_ptr<Topology> topology, std::shared_ptr<EventQueue> event_queue) noexcept;
+
+    /**
+     * Start a flow at the current time.
+     *
+     * @param src source device id
+     * @param dest destination device id
+     * @param size size of the transfer in bytes
+     * @param callback callback to be invoked when the flow arrives at dest
+     * @param callback_arg argument of the callback
+     */
+    void start_flow(DeviceId src, DeviceId dest, ChunkSize size, Callback callback, CallbackArg callback_arg) noexcept;
+
+    /**
+     * Start a flow at the current time.
+     *
+     * @param src source device id
+     * @param dest destination device id
+     * @param size size of the transfer in bytes
+     * @param callback callable to be invoked when the flow arrives at dest
+     */
+    void start_flow(DeviceId src, DeviceId dest, ChunkSize size, EventCallback callback) noexcept;
+
+    /**
+     * Get the number of flows still transmitting.
+     *
+     * @return number of active flows
+     */
+    [[nodiscard]] int get_active_flows_count() const noexcept;
+
+    /**
+     * Get the current rate of an active flow, for inspection.
+     *
+     * @param flow_index index of the flow in start order, among the active ones
+     * @return rate of the flow in B/ns
+     */
+    [[nodiscard]] Bandwidth get_active_flow_rate(int flow_index) const noexcept;
+
+  private:
+    /// a flow in transmission
+    struct Flow {
+        /// links (resource indices) used by the flow
+        std::vector<int> links;
+
+        /// bytes left to transmit
+        double remaining_bytes;
+
+        /// current rate in B/ns
+        Bandwidth rate;
+
+        /// total latency of the route in ns
+        Latency route_latency;
+
+        /// callback invoked at the destination
+        EventCallback callback;
+    };
+
+    /// a link shared by flows
+    struct FlowLink {
+        /// capacity in B/ns
+        Bandwidth capacity;
+    };
+
+    /// tolerance when checking whether a flow has been fully transmitted, in bytes
+    static constexpr double remaining_bytes_epsilon = 1e-3;
+
+    /// topology providing the routes
+    std::shared_ptr<Topology> topology;
+
+    /// event queue to schedule events on
+    std::shared_ptr<EventQueue> event_queue;
+
+    /// links known so far
+    std::vector<FlowLink> flow_links;
+
+    /// map[(device id, port)] -> index in flow_links
+    std::unordered_map<uint64_t, int> flow_link_indices;
+
+    /// flows in transmission, in start order
+    std::vector<Flow> active_flows;
+
+    /// time up to which active flows' remaining bytes are accounted
+    EventTime last_update_time;
+
+    /// pending event to recompute rates and finish flows
+    EventHandle next_update_event;
+
+    /// time of next_update_event
+    EventTime next_update_time;
+
+    /// whether next_update_event is scheduled
+    bool next_update_scheduled;
+
+    /**
+     * Event handler finishing transmitted flows and recomputing the rates.
+     *
+     * @param flow_network_ptr pointer to the FlowNetwork
+     */
+    static void on_update(void* flow_network_ptr) noexcept;
+
+    /**
+     * Get the resource index of a link, registering it on first use.
+     *
+     * @param device device owning the link
+     * @param port port of the link
+     * @return index in flow_links
+     */
+    [[nodiscard]] int get_flow_link(Device& device, PortId port) noexcept;
+
+    /**
+     * Account the bytes sent by every active flow since last_update_time.
+     */
+    void update_progress() noexcept;
+
+    /**
+     * Finish the flows whose bytes are all sent, scheduling their callbacks.
+     */
+    void complete_transmitted_flows() noexcept;
+
+    /**
+     * Assign max-min fair rates to the active flows (progressive filling).
+     */
+    void compute_rates() noexcept;
+
+    /**
+     * Make sure an update happens no later than the given time.
+     *
+     * @param update_time time of the update
+     */
+    void schedule_update(EventTime update_time) noexcept;
+};
+
+}  // namespace NetworkAnalyticalCongestionAware
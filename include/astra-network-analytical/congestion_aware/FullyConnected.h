@@ -40,6 +40,20 @@ class FullyConnected final : public BasicTopology {
      */
     [[nodiscard]] Route route(DeviceId src, DeviceId dest) const noexcept override;
 
+    /**
+     * Implementation of describe_route function in Topology.
+     * Routes are a single step from src to dest.
+     */
+    [[nodiscard]] bool describe_route(DeviceId src,
+                                      DeviceId dest,
+                                      RouteDescriptor& route_descriptor) const noexcept override;
+
+    /**
+     * Implementation of map_by_symmetry function in Topology.
+     * NPUs are rotated.
+     */
+    [[nodiscard]] DeviceId map_by_symmetry(DeviceId device, DeviceId npu) const noexcept override;
+
     /**
      * Clone this topology instance.
      */
@@ -6,6 +6,7 @@ LICENSE file in the root directory of this source tree.
 #pragma once
 
 #include "common/NetworkParser.h"
+#include "congestion_aware/SimulationContext.h"
 #include "congestion_aware/Topology.h"
 #include <memory>
 
@@ -15,10 +16,23 @@ namespace NetworkAnalyticalCongestionAware {
 
 /**
  * Construct a topology from a NetworkParser.
+ * If the network names a snapshot (see NetworkParser::get_snapshot_path()),
+ * the topology is loaded from it when it was saved from the same network,
+ * and constructed and saved to it otherwise.
  *
  * @param network_parser NetworkParser to parse the network input file
  * @return pointer to the constructed topology
  */
 [[nodiscard]] std::shared_ptr<Topology> construct_topology(const NetworkParser& network_parser) noexcept;
 
+/**
+ * Construct a topology from a NetworkParser, in the given simulation context.
+ *
+ * @param network_parser NetworkParser to parse the network input file
+ * @param context simulation context of the topology
+ * @return pointer to the constructed topology
+ */
+[[nodiscard]] std::shared_ptr<Topology> construct_topology(const NetworkParser& network_parser,
+                                                           std::shared_ptr<SimulationContext> context) noexcept;
+
 }  // namespace NetworkAnalyticalCongestionAware
@@ -6,45 +6,108 @@ LICENSE file in the root directory of this source tree.
 #pragma once
 
 #include "common/EventQueue.h"
+#include "common/MemoryCounter.h"
 #include "common/Type.h"
+#include "congestion_aware/LinkStates.h"
+#include "congestion_aware/SimulationContext.h"
 #include "congestion_aware/Type.h"
 #include <memory>
+#include <vector>
 
 using namespace NetworkAnalytical;
 
 namespace NetworkAnalyticalCongestionAware {
 
+class ChunkTracer;
+class Topology;
+struct ReservedChunk;
+
+/**
+ * A chunk arrival that crosses the partition boundary of a parallel simulation.
+ * Links crossing partitions buffer these instead of scheduling the arrival
+ * on their own event queue (see ParallelSimulator).
+ */
+struct RemoteArrival {
+    /// time when the chunk arrives at the next device
+    EventTime arrival_time;
+
+    /// partition owning the next device
+    int dest_partition;
+
+    /// the arriving chunk
+    std::unique_ptr<Chunk> chunk;
+};
+
 /**
  * Link models physical links between two devices.
+ *
+ * A link holds its immutable parameters, and its configuration (failure, partition),
+ * while its simulation state (busy flag, pending chunks, reservation, statistics) lives in the LinkStates of a context.
+ * Each method reaches the state of the link in the context it runs under: the one of the chunk being sent
+ * (see Chunk::get_simulation_context()), carried along by the events of the link, or the one given.
+ * So several contexts can simulate the link at once, each with its own state.
+ *
+ * A link may have a bounded buffer (see set_buffer_size()), holding the chunks its device forwards through it.
+ * Links sending into the device take room in the buffer before transmitting such a chunk, and stall while it's full,
+ * so congestion at a switch egress spreads back to the links feeding it instead of growing an unbounded queue.
  */
 class Link {
   public:
+    /// chunks waiting for the link, in order
+    using PendingChunks = LinkStates::PendingChunks;
+
+    /// timing of a chunk crossing the link
+    struct Transmission {
+        /// time when the link is done serializing the chunk
+        EventTime free_time;
+
+        /// time when the head of the chunk arrives at the next device, so it can be forwarded
+        EventTime head_arrival_time;
+
+        /// time when the tail of the chunk arrives at the next device
+        EventTime tail_arrival_time;
+    };
+
     /**
      * Callback to be called when a link becomes free.
-     *  - If the link has pending chunks, process the first one.
+     *  - If the link has pending chunks, process the first one
+     *    (or all of them at once if the context enables coalescing).
      *  - If the link has no pending chunks, set the link as free.
      *
-     * @param link_ptr pointer to the link that becomes free
+     * @param context simulation context the link runs under
+     * @param link link that becomes free
      */
-    static void link_become_free(void* link_ptr) noexcept;
-
-    /**
-     * Set the event queue to be used by the link.
-     *
-     * @param event_queue_ptr pointer to the event queue
-     */
-    static void set_event_queue(std::shared_ptr<EventQueue> event_queue_ptr) noexcept;
+    static void link_become_free(SimulationContext& context, Link& link) noexcept;
 
     /**
      * Constructor.
      *
      * @param bandwidth bandwidth of the link
      * @param latency latency of the link
+     * @param pending_chunks_memory counter of the memory held by the pending chunks queue, nullptr for none
+     * @param link_ids ids of the links of the topology to take the id of the link from, nullptr for ids of its own
+     */
+    Link(Bandwidth bandwidth,
+         Latency latency,
+         std::shared_ptr<MemoryCounter> pending_chunks_memory = nullptr,
+         std::shared_ptr<LinkStates::LinkIds> link_ids = nullptr) noexcept;
+
+    /**
+     * Move constructor. The moved-from link can only be destroyed.
+     */
+    Link(Link&& other) noexcept;
+
+    /**
+     * Destructor. The id of the link is released, and its slots are reset once another link takes it.
      */
-    Link(Bandwidth bandwidth, Latency latency) noexcept;
+    ~Link() noexcept;
+
+    Link(const Link&) = delete;
+    Link& operator=(const Link&) = delete;
+    Link& operator=(Link&&) = delete;
 
     /**
-     * Try to send a chunk through the link.
+     * Try to send a chunk through the link, in the simulation context of the chunk.
      * - If the link is free, service the chunk immediately.
      * - If the link is busy, add the chunk to the pending chunks list.
      *
@@ -55,30 +118,231 @@ class Link {
     /**
      * Dequeue and try to send the first pending chunk
      * in the pending chunks list.
+     * The link stalls instead if the buffer the chunk heads to is full (see set_buffer_size()).
+     *
+     * @param context simulation context the link runs under
      */
-    void process_pending_transmission() noexcept;
+    void process_pending_transmission(SimulationContext& context) noexcept;
 
     /**
      * Check if the link has pending chunks.
      *
+     * @param context simulation context to look at the link in
      * @return true if the link has pending chunks, false otherwise
      */
-    [[nodiscard]] bool pending_chunk_exists() const noexcept;
+    [[nodiscard]] bool pending_chunk_exists(SimulationContext& context) const noexcept;
+
+    /**
+     * Get the number of bytes waiting in the pending chunks list.
+     * Kept up to date as chunks are queued and dequeued, so adaptive routing can read it in O(1).
+     *
+     * @param context simulation context to look at the link in
+     * @return total size of the pending chunks
+     */
+    [[nodiscard]] ChunkSize get_pending_bytes(SimulationContext& context) const noexcept;
+
+    /**
+     * Check whether the link can take a reservation (see SimulationContext::set_hybrid_fidelity()):
+     * it's free, has no pending chunks, no reservation past current_time, isn't bound to a partition, and isn't failed.
+     *
+     * @param context simulation context to look at the link in
+     * @param current_time current simulation time
+     * @return true if the link can be reserved, false otherwise
+     */
+    [[nodiscard]] bool can_reserve(SimulationContext& context, EventTime current_time) const noexcept;
+
+    /**
+     * Reserve the link for a chunk departing at departure_time,
+     * for as long as the chunk takes to be serialized.
+     * A chunk sent over the link before the reservation starts takes the link first, as in a full simulation,
+     * and the owner resumes the per-hop path (see Topology::resume_per_hop()).
+     *
+     * @param context simulation context the link runs under
+     * @param departure_time time when the chunk starts being serialized
+     * @param chunk_size size of the chunk
+     * @param tail_arrival_time time when the tail of the chunk arrives at the link (see Chunk::get_tail_arrival_time())
+     * @param owner fast-path chunk holding the reservation
+     * @return timing of the chunk over the link
+     */
+    [[nodiscard]] Transmission reserve(SimulationContext& context,
+                                       EventTime departure_time,
+                                       ChunkSize chunk_size,
+                                       EventTime tail_arrival_time,
+                                       ReservedChunk* owner) noexcept;
+
+    /**
+     * Let go of a reservation made by reserve().
+     * A served reservation (the chunk crossed the link) is recorded in the statistics,
+     * while a cancelled one (the chunk resumed the per-hop path before departing) frees the link.
+     *
+     * @param context simulation context the link runs under
+     * @param owner fast-path chunk that held the reservation
+     * @param chunk_size size of the chunk
+     * @param served true if the chunk crossed the link on the fast path, false if the reservation is cancelled
+     */
+    void release_reservation(SimulationContext& context,
+                             const ReservedChunk* owner,
+                             ChunkSize chunk_size,
+                             bool served) noexcept;
+
+    /**
+     * Compute the timing of a chunk crossing the link.
+     * Under store-and-forward, the chunk is serialized, then arrives as a whole after the latency.
+     * Under cut-through (see SimulationContext::set_cut_through()),
+     * its head can be forwarded once its first flit arrived, but the link can't send its tail before the tail arrived.
+     * Chunks no larger than a flit are stored and forwarded.
+     *
+     * @param context simulation context providing the forwarding mode
+     * @param departure_time time when the chunk starts being serialized
+     * @param chunk_size size of the chunk
+     * @param tail_arrival_time time when the tail of the chunk arrives at this link
+     * @return timing of the chunk over the link
+     */
+    [[nodiscard]] Transmission plan_transmission(const SimulationContext& context,
+                                                 EventTime departure_time,
+                                                 ChunkSize chunk_size,
+                                                 EventTime tail_arrival_time) const noexcept;
+
+    /**
+     * Check whether the link holds no state a simulation in a context depends on:
+     * it's free, has no pending chunks, no reservation past current_time, isn't bound to a partition, and isn't failed.
+     * No event of the context refers to an idle link,
+     * so it can be dropped and recreated later if no other context simulates it (see Device::release_idle_links()).
+     *
+     * @param context simulation context to look at the link in
+     * @param current_time current simulation time
+     * @return true if the link is idle, false otherwise
+     */
+    [[nodiscard]] bool is_idle(SimulationContext& context, EventTime current_time) const noexcept;
+
+    /**
+     * Return the link to its initial state in a context: free, with no pending chunks and no reservation.
+     * Pending chunks are dropped.
+     *
+     * @param context simulation context to reset the link in
+     */
+    void reset(SimulationContext& context) noexcept;
 
     /**
      * Set the link as busy.
+     *
+     * @param context simulation context the link runs under
      */
-    void set_busy() noexcept;
+    void set_busy(SimulationContext& context) noexcept;
 
     /**
      * Set the link as free.
+     *
+     * @param context simulation context the link runs under
      */
-    void set_free() noexcept;
+    void set_free(SimulationContext& context) noexcept;
 
-  private:
-    /// event queue Link uses to schedule events
-    static std::shared_ptr<EventQueue> event_queue;
+    /**
+     * Mark the link failed through a topology, or restore it.
+     * Chunks sent to a failed link are handed to the topology to be rerouted (see Topology::reroute()).
+     *
+     * @param topology topology failing the link, nullptr to restore it
+     */
+    void set_failed(Topology* topology) noexcept;
+
+    /**
+     * Check whether the link has failed.
+     *
+     * @return true if the link has failed, false otherwise
+     */
+    [[nodiscard]] bool is_failed() const noexcept;
+
+    /**
+     * Take the chunks waiting for the link, e.g., to reroute them once it failed.
+     *
+     * @param context simulation context the chunks wait in
+     * @return pending chunks, in order
+     */
+    [[nodiscard]] PendingChunks take_pending_chunks(SimulationContext& context) noexcept;
+
+    /**
+     * Bound the buffer of the link (see Topology::set_switch_buffer_size()).
+     * A link transmitting a chunk its next device forwards through this link first takes room for it in the buffer,
+     * and the room is given back once the chunk starts being serialized here.
+     * Without room, the sending link stalls, holding its pending chunks, until room is given back.
+     * A chunk larger than the buffer is let in once the buffer is empty.
+     * Chunks leaving or entering a bounded buffer aren't coalesced (see SimulationContext::set_link_coalescing()),
+     * so room always changes hands when they start being serialized.
+     *
+     * @param buffer_size size of the buffer in bytes, 0 for an unbounded buffer
+     */
+    void set_buffer_size(ChunkSize buffer_size) noexcept;
+
+    /**
+     * Get the size of the buffer of the link.
+     *
+     * @return size of the buffer in bytes, 0 if unbounded
+     */
+    [[nodiscard]] ChunkSize get_buffer_size() const noexcept;
+
+    /**
+     * Get the number of bytes held in the buffer of the link,
+     * by the chunks on their way to it or waiting for it.
+     *
+     * @param context simulation context to look at the link in
+     * @return buffered bytes, always 0 for an unbounded buffer
+     */
+    [[nodiscard]] ChunkSize get_buffered_bytes(SimulationContext& context) const noexcept;
+
+    /**
+     * Get the bandwidth of the link.
+     *
+     * @return bandwidth of the link in GB/s
+     */
+    [[nodiscard]] Bandwidth get_bandwidth() const noexcept;
+
+    /**
+     * Compute the serialization delay of a chunk on the link.
+     * i.e., serialization delay = (chunk size) / (link bandwidth)
+     *
+     * @param chunk_size size of the target chunk
+     * @return serialization delay of the chunk
+     */
+    [[nodiscard]] EventTime serialization_delay(ChunkSize chunk_size) const noexcept;
+
+    /**
+     * Get the latency of the link.
+     *
+     * @return latency of the link in ns
+     */
+    [[nodiscard]] Latency get_latency() const noexcept;
+
+    /**
+     * Bind the link to a partition of a parallel simulation.
+     * Afterwards, the link schedules its events on the given local event queue
+     * instead of the one of the simulation context it runs under.
+     * If remote_arrivals is given, the next device belongs to another partition,
+     * so chunk arrivals are appended to remote_arrivals instead of being scheduled.
+     *
+     * @param local_event_queue event queue of the partition owning the link
+     * @param remote_arrivals buffer of cross-partition arrivals, nullptr if the link is partition-local
+     * @param dest_partition partition owning the next device
+     */
+    void bind_partition(EventQueue* local_event_queue,
+                        std::vector<RemoteArrival>* remote_arrivals,
+                        int dest_partition) noexcept;
+
+    /**
+     * Undo bind_partition(), so the link uses the event queue of the simulation context it runs under again.
+     */
+    void unbind_partition() noexcept;
 
+#ifdef ASTRA_NET_STATS
+    /**
+     * Get the traffic statistics of the link in a context, since its first use there or its last reset().
+     *
+     * @param context simulation context to look at the link in
+     * @return statistics of the link
+     */
+    [[nodiscard]] const LinkStats& get_stats(SimulationContext& context) const noexcept;
+#endif
+
+  private:
     /// bandwidth of the link in GB/s
     Bandwidth bandwidth;
 
@@ -88,20 +352,154 @@ class Link {
     /// latency of the link in ns
     Latency latency;
 
-    /// queue of pending chunks
-    std::list<std::unique_ptr<Chunk>> pending_chunks;
+    /// ids the link took its id from, shared with the other links of the topology
+    std::shared_ptr<LinkStates::LinkIds> link_ids;
+
+    /// identity of the link, indexing its state in each context
+    LinkStates::LinkKey key;
+
+    /// slot of the link in its block of each context
+    int slot;
+
+    /// counter of the memory held by the pending chunks queues, given to the queues of new contexts
+    std::shared_ptr<MemoryCounter> pending_chunks_memory;
+
+    /// topology that failed the link, nullptr if the link works
+    Topology* failure_topology;
+
+    /// size of the buffer of the link in bytes, 0 if unbounded
+    ChunkSize buffer_size;
+
+    /// event queue of the owning partition in a parallel simulation, nullptr otherwise
+    EventQueue* local_event_queue;
+
+    /// cross-partition arrival buffer if the link crosses partitions, nullptr otherwise
+    std::vector<RemoteArrival>* remote_arrivals;
 
-    /// flag to indicate if the link is busy
-    bool busy;
+    /// partition owning the next device (only meaningful if remote_arrivals is set)
+    int dest_partition;
 
     /**
-     * Compute the serialization delay of a chunk on the link.
-     * i.e., serialization delay = (chunk size) / (link bandwidth)
+     * Get the state of the link in a context, taking a slot there on the first use of the link in the context.
      *
-     * @param chunk_size size of the target chunk
-     * @return serialization delay of the chunk
+     * @param context simulation context to find the state in
+     * @return block holding the state of the link, at its slot
      */
-    [[nodiscard]] EventTime serialization_delay(ChunkSize chunk_size) const noexcept;
+    [[nodiscard]] LinkStates::Block& get_state(SimulationContext& context) const noexcept;
+
+#ifdef ASTRA_NET_STATS
+    /**
+     * Count a chunk starting to be serialized.
+     *
+     * @param state state of the link in the context it runs under
+     * @param chunk_size size of the chunk
+     * @param queueing_delay time the chunk waited in the pending chunks list
+     */
+    void record_transmission(LinkStates::Block& state, ChunkSize chunk_size, EventTime queueing_delay) noexcept;
+
+    /**
+     * Record the queueing time of a chunk added to the pending chunks list.
+     *
+     * @param context simulation context the link runs under
+     * @param state state of the link in that context
+     * @param traffic_class traffic class of the chunk
+     */
+    void record_pending_chunk(SimulationContext& context, LinkStates::Block& state, int traffic_class) noexcept;
+
+    /**
+     * Get the queueing delay of the first pending chunk of a class, and forget its queueing time.
+     *
+     * @param state state of the link in the context it runs under
+     * @param departure_time time when the chunk starts being serialized
+     * @param traffic_class traffic class of the chunk
+     * @return time the chunk waited in the pending chunks list
+     */
+    [[nodiscard]] EventTime pop_queueing_delay(LinkStates::Block& state,
+                                               EventTime departure_time,
+                                               int traffic_class) noexcept;
+#endif
+
+    /**
+     * Add a chunk to the pending chunks of its traffic class.
+     *
+     * @param context simulation context the link runs under
+     * @param state state of the link in that context
+     * @param chunk chunk to wait for the link
+     */
+    void enqueue_pending_chunk(SimulationContext& context,
+                               LinkStates::Block& state,
+                               std::unique_ptr<Chunk> chunk) noexcept;
+
+    /**
+     * Take the pending chunk to send next, as picked by the scheduling policy of the context.
+     *
+     * @param context simulation context the link runs under
+     * @param state state of the link in that context
+     * @return chunk to send
+     */
+    [[nodiscard]] std::unique_ptr<Chunk> dequeue_pending_chunk(const SimulationContext& context,
+                                                               LinkStates::Block& state) noexcept;
+
+    /**
+     * Get the pending chunk to send next, without taking it.
+     *
+     * @param context simulation context the link runs under
+     * @param state state of the link in that context
+     * @return chunk to send next
+     */
+    [[nodiscard]] Chunk& peek_pending_chunk(const SimulationContext& context, LinkStates::Block& state) noexcept;
+
+    /**
+     * Pick the traffic class to send a pending chunk of (see SimulationContext::set_link_scheduling()).
+     * Classes with pending chunks are found from a bitmask, so picking takes constant time.
+     *
+     * @param context simulation context the link runs under
+     * @param state state of the link in that context
+     * @param commit true to charge the chunk to its class, false to only look
+     * @return traffic class of the chunk to send next
+     */
+    [[nodiscard]] int pick_pending_class(const SimulationContext& context,
+                                         LinkStates::Block& state,
+                                         bool commit) noexcept;
+
+    /**
+     * Check whether a chunk can be planned ahead in a coalesced burst,
+     * i.e., no chunk queued later could be sent before it.
+     *
+     * @param context simulation context the link runs under
+     * @param chunk pending chunk
+     * @return true if the chunk can join a burst, false otherwise
+     */
+    [[nodiscard]] static bool can_coalesce(const SimulationContext& context, const Chunk& chunk) noexcept;
+
+    /**
+     * Get the link a chunk is forwarded through after this one, if its buffer is bounded.
+     *
+     * @param chunk chunk to be transmitted
+     * @return next link of the chunk, nullptr if the chunk goes to its dest or the next buffer is unbounded
+     */
+    [[nodiscard]] Link* get_next_buffer_link(const Chunk& chunk) const noexcept;
+
+    /**
+     * Take room for a chunk in the buffer of the link it's forwarded through after this one, if bounded,
+     * giving back the room it holds in the buffer of this link.
+     * Without room, this link stalls until room is given back.
+     *
+     * @param context simulation context the link runs under
+     * @param state state of the link in that context
+     * @param chunk chunk about to be transmitted
+     * @return true if the chunk can be transmitted, false otherwise
+     */
+    [[nodiscard]] bool claim_next_buffer(SimulationContext& context, LinkStates::Block& state, Chunk& chunk) noexcept;
+
+    /**
+     * Give back the room a chunk holds in the buffer of this link, resuming the links stalled for it.
+     *
+     * @param context simulation context the link runs under
+     * @param state state of the link in that context
+     * @param chunk chunk leaving the buffer
+     */
+    void release_buffer(SimulationContext& context, LinkStates::Block& state, Chunk& chunk) noexcept;
 
     /**
      * Compute the communication delay of a chunk.
@@ -118,9 +516,106 @@ class Link {
      * - Link becomes free after the serialization delay.
      * - Chunk arrives next node after the communication delay.
      *
+     * @param context simulation context the link runs under
+     * @param state state of the link in that context
      * @param chunk chunk to be transmitted
      */
-    void schedule_chunk_transmission(std::unique_ptr<Chunk> chunk) noexcept;
+    void schedule_chunk_transmission(SimulationContext& context,
+                                     LinkStates::Block& state,
+                                     std::unique_ptr<Chunk> chunk) noexcept;
+
+    /**
+     * Schedule the transmission of every pending chunk back-to-back.
+     * - Set the link as busy.
+     * - Link becomes free after the sum of serialization delays.
+     * - Each chunk arrives next node after its departure time plus its communication delay.
+     *
+     * @param context simulation context the link runs under
+     * @param state state of the link in that context
+     */
+    void schedule_pending_burst(SimulationContext& context, LinkStates::Block& state) noexcept;
+
+    /**
+     * Schedule the link to become free, in the context it runs under.
+     *
+     * @param context simulation context the link runs under
+     * @param free_time time when the link becomes free
+     */
+    void schedule_link_free(SimulationContext& context, EventTime free_time) noexcept;
+
+    /**
+     * Check whether sending a chunk now would overlap the reservation of the link.
+     *
+     * @param context simulation context the link runs under
+     * @param state state of the link in that context
+     * @param chunk_size size of the chunk
+     * @return true if the chunk should wait for the reservation to end, false otherwise
+     */
+    [[nodiscard]] bool overlaps_reservation(const SimulationContext& context,
+                                            const LinkStates::Block& state,
+                                            ChunkSize chunk_size) const noexcept;
+
+    /**
+     * Hold the link busy until its reservation ends,
+     * when the pending chunks are processed as usual.
+     *
+     * @param context simulation context the link runs under
+     * @param state state of the link in that context
+     */
+    void wait_for_reservation(SimulationContext& context, LinkStates::Block& state) noexcept;
+
+    /**
+     * If sending a chunk now would overlap a reservation that hasn't started yet,
+     * let the chunk go first, as in a full simulation: its owner resumes the per-hop path.
+     *
+     * @param context simulation context the link runs under
+     * @param state state of the link in that context
+     * @param chunk_size size of the chunk
+     */
+    void preempt_reservation(const SimulationContext& context, LinkStates::Block& state, ChunkSize chunk_size) noexcept;
+
+    /**
+     * Get the event queue the link schedules its events on.
+     *
+     * @param context simulation context the link runs under
+     * @return partition's event queue in a parallel simulation, the context's one otherwise
+     */
+    [[nodiscard]] EventQueue* get_link_event_queue(const SimulationContext& context) const noexcept;
+
+    /**
+     * Schedule the arrival of a chunk at the next device:
+     * when its head arrives, for a device forwarding it, or when its tail arrives, for its dest.
+     *
+     * @param context simulation context the link runs under
+     * @param chunk chunk to deliver
+     * @param transmission timing of the chunk over the link
+     */
+    void schedule_chunk_arrival(const SimulationContext& context,
+                                std::unique_ptr<Chunk> chunk,
+                                const Transmission& transmission) noexcept;
+
+    /**
+     * Get the tracer to record a chunk into.
+     *
+     * @param context simulation context the link runs under
+     * @param chunk chunk to record
+     * @return tracer of the context if the chunk is traced and the link isn't bound to a partition, nullptr otherwise
+     */
+    [[nodiscard]] ChunkTracer* get_chunk_tracer(const SimulationContext& context, const Chunk& chunk) const noexcept;
+
+    /**
+     * Record the transmission of a traced chunk over the link,
+     * and its completion if the link leads to its dest.
+     *
+     * @param chunk_tracer tracer to record into
+     * @param chunk chunk being transmitted
+     * @param departure_time time when the chunk starts being serialized
+     * @param transmission timing of the chunk over the link
+     */
+    void trace_transmission(ChunkTracer& chunk_tracer,
+                            const Chunk& chunk,
+                            EventTime departure_time,
+                            const Transmission& transmission) const noexcept;
 };
 
 }  // namespace NetworkAnalyticalCongestionAware
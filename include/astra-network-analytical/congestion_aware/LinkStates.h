@@ -0,0 +1,288 @@
+/******************************************************************************
+This source code is licensed under the MIT license found in the
+LICENSE file in the root directory of this source tree.
+*******************************************************************************/
+
+#pragma once
+
+#include "common/MemoryCounter.h"
+#include "common/Type.h"
+#include "congestion_aware/Type.h"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <vector>
+#ifdef ASTRA_NET_STATS
+#include <deque>
+#endif
+
+using namespace NetworkAnalytical;
+
+namespace NetworkAnalyticalCongestionAware {
+
+class Link;
+struct ReservedChunk;
+
+#ifdef ASTRA_NET_STATS
+/**
+ * LinkStats counts the traffic of a link in a simulation context.
+ * Only compiled in with the ASTRA_NET_STATS CMake option.
+ */
+struct LinkStats {
+    /// number of queueing delay histogram buckets
+    static constexpr int histogram_buckets_count = 40;
+
+    /// number of bytes transmitted
+    ChunkSize bytes = 0;
+
+    /// number of chunks transmitted
+    uint64_t chunks_count = 0;
+
+    /// time spent serializing chunks, in ns
+    EventTime busy_time = 0;
+
+    /// largest number of chunks pending at once
+    size_t max_queue_depth = 0;
+
+    /// queueing_delay_histogram[0] -> chunks sent without waiting,
+    /// queueing_delay_histogram[b] -> chunks that waited [2^(b-1), 2^b) ns (the last bucket is open-ended)
+    std::array<uint64_t, histogram_buckets_count> queueing_delay_histogram = {};
+};
+#endif
+
+/**
+ * LinkStates holds the mutable state of links (busy flag, pending chunks per traffic class, reservation, buffer)
+ * for one simulation context, as a structure of arrays indexed by link id.
+ *
+ * Links only keep their immutable parameters (bandwidth, latency) and their configuration,
+ * and find their state in the context they're simulated in (see get()),
+ * so one topology can be simulated under several contexts, in turn or at once,
+ * each context keeping its own state of every link.
+ * A link takes a slot in a context on its first use there, and finds its state again whenever it comes back.
+ *
+ * Link ids are allocated per topology (see LinkIds), and recycled once a link is destroyed,
+ * so a context keys the state of a link by the ids of its topology and its id among them.
+ * Slots are allocated by blocks of consecutive ids, never moved afterwards,
+ * so the hot state of neighbouring links shares cache lines.
+ */
+class LinkStates {
+  public:
+    /// chunks waiting for a link, in order
+    using PendingChunks = std::list<std::unique_ptr<Chunk>, TrackingAllocator<std::unique_ptr<Chunk>>>;
+
+    /// number of links of a block
+    static constexpr int block_size = 1024;
+
+    /// number of traffic classes, each queued apart on every link (see Chunk::set_traffic_class())
+    static constexpr int traffic_classes_count = 4;
+
+    /// pending chunks of a link, per traffic class
+    using ClassQueues = std::array<PendingChunks, traffic_classes_count>;
+
+    /// state of block_size links of consecutive ids
+    struct Block {
+        /// serial of the link owning each slot, 0 if none
+        std::array<uint64_t, block_size> owners = {};
+
+        /// whether each link is busy
+        std::array<uint8_t, block_size> busy = {};
+
+        /// total size of the pending chunks of each link
+        std::array<ChunkSize, block_size> pending_bytes = {};
+
+        /// each link is reserved over [reserved_from, reserved_until) by a fast-path chunk
+        std::array<EventTime, block_size> reserved_from = {};
+
+        /// end of the reservation of each link, 0 if the link was never reserved
+        std::array<EventTime, block_size> reserved_until = {};
+
+        /// fast-path chunk holding the reservation of each link until it lets go of it, nullptr if none
+        std::array<ReservedChunk*, block_size> reservation_owners = {};
+
+        /// queues of pending chunks of each link, per traffic class
+        std::array<ClassQueues, block_size> pending_chunks;
+
+        /// bit c set if traffic class c of each link has pending chunks
+        std::array<uint8_t, block_size> pending_classes = {};
+
+        /// traffic class each link served last, under deficit round-robin
+        std::array<uint8_t, block_size> scheduled_classes = {};
+
+        /// bytes each traffic class of each link may still send in its turn, under deficit round-robin
+        std::array<std::array<ChunkSize, traffic_classes_count>, block_size> deficits = {};
+
+        /// bytes held in the buffer of each link by the chunks heading to it or waiting for it
+        std::array<ChunkSize, block_size> buffered_bytes = {};
+
+        /// links stalled until the buffer of each link has room, in the order they stalled
+        std::array<std::vector<Link*>, block_size> stalled_links;
+
+#ifdef ASTRA_NET_STATS
+        /// pending_send_times[slot][c][i] -> time when the i-th pending chunk of class c of a link was queued
+        std::array<std::array<std::deque<EventTime>, traffic_classes_count>, block_size> pending_send_times;
+
+        /// traffic statistics of each link
+        std::array<LinkStats, block_size> stats;
+#endif
+    };
+
+    /// identity of a link
+    struct LinkKey {
+        /// id of the link, indexing its state
+        int id;
+
+        /// serial of the link, never reused in the process
+        uint64_t serial;
+    };
+
+    /// ids of the links of a topology, shared by its links
+    class LinkIds {
+      public:
+        /**
+         * Constructor.
+         */
+        LinkIds() noexcept;
+
+        /**
+         * Get the identity of these ids, never reused in the process, so tables can be told apart without locking.
+         *
+         * @return serial of the ids
+         */
+        [[nodiscard]] uint64_t get_serial() const noexcept;
+
+        /**
+         * Allocate the identity of a new link.
+         *
+         * @return id and serial of the link
+         */
+        [[nodiscard]] LinkKey allocate() noexcept;
+
+        /**
+         * Release the id of a destroyed link, so a new link can take it.
+         *
+         * @param id id of the link
+         */
+        void release(int id) noexcept;
+
+      private:
+        /// identity of the ids, never reused in the process
+        uint64_t serial;
+
+        /// guards the ids, as lazy links may be created from several threads
+        std::mutex mutex;
+
+        /// released ids, reused first, lowest first, to keep blocks dense
+        std::priority_queue<int, std::vector<int>, std::greater<>> released_ids;
+
+        /// id of the next link when none is released
+        int next_id = 0;
+
+        /// serial of the next link
+        uint64_t next_serial = 1;
+    };
+
+    /**
+     * Constructor.
+     */
+    LinkStates() noexcept;
+
+    /**
+     * Destructor.
+     */
+    ~LinkStates() noexcept;
+
+    LinkStates(const LinkStates&) = delete;
+    LinkStates& operator=(const LinkStates&) = delete;
+
+    /**
+     * Get the block holding the state of a link, attaching the link to this table on its first use:
+     * a new link starts free, without pending chunks and never reserved.
+     * Links attached already are found without locking,
+     * so the threads simulating in the context (e.g., the partitions of a parallel simulation) don't contend for it.
+     *
+     * @param link_ids ids the link was allocated from
+     * @param key identity of the link
+     * @param pending_chunks_memory counter of the memory held by the pending chunks queue, nullptr for none
+     * @return block holding the state of the link, at slot (key.id % block_size)
+     */
+    [[nodiscard]] Block& get(const std::shared_ptr<LinkIds>& link_ids,
+                             const LinkKey& key,
+                             const std::shared_ptr<MemoryCounter>& pending_chunks_memory) noexcept;
+
+    /**
+     * Get the number of links attached to this table with distinct ids, including destroyed links not replaced yet.
+     *
+     * @return number of owned slots
+     */
+    [[nodiscard]] int get_attached_links_count() const noexcept;
+
+  private:
+    /// blocks of a table as found by lookups, never resized but replaced by a larger copy
+    struct BlockIndex {
+        /// entries[b] -> block of the links of ids [b * block_size, (b + 1) * block_size), nullptr if none
+        std::unique_ptr<std::atomic<Block*>[]> entries;
+
+        /// number of entries
+        size_t capacity;
+    };
+
+    /// state of the links allocated from the same ids
+    struct Table {
+        /// ids of the links, expired once every link allocated from them is destroyed
+        std::weak_ptr<LinkIds> link_ids;
+
+        /// serial of the ids, matched by lookups
+        uint64_t serial;
+
+        /// blocks[b] -> state of the links of ids [b * block_size, (b + 1) * block_size), nullptr if none was attached
+        std::vector<std::unique_ptr<Block>> blocks;
+
+        /// the same blocks, as found by lookups
+        BlockIndex* index;
+    };
+
+    /// block index of each table, as found by lookups, replaced by a copy whenever tables or indexes change
+    struct Directory {
+        /// (serial of the ids, block index) of each table
+        std::vector<std::pair<uint64_t, const BlockIndex*>> tables;
+    };
+
+    /**
+     * Attach a link to this table, and get the block holding its state (slow path of get()).
+     *
+     * @param link_ids ids the link was allocated from
+     * @param key identity of the link
+     * @param pending_chunks_memory counter of the memory held by the pending chunks queue, nullptr for none
+     * @return block holding the state of the link
+     */
+    [[nodiscard]] Block& attach(const std::shared_ptr<LinkIds>& link_ids,
+                                const LinkKey& key,
+                                const std::shared_ptr<MemoryCounter>& pending_chunks_memory) noexcept;
+
+    /**
+     * Publish the block indexes of the current tables to lookups.
+     */
+    void publish_directory() noexcept;
+
+    /// tables of the links attached so far, dropped once their ids expired
+    std::vector<Table> tables;
+
+    /// directory lookups start from
+    std::atomic<const Directory*> directory;
+
+    /// every directory published, kept as a lookup may still be reading a previous one
+    std::vector<std::unique_ptr<const Directory>> directories;
+
+    /// every block index allocated, kept as a lookup may still be reading a previous one
+    std::vector<std::unique_ptr<BlockIndex>> block_indexes;
+
+    /// guards the tables, as links of the context may be attached from several threads
+    mutable std::mutex mutex;
+};
+
+}  // namespace NetworkAnalyticalCongestionAware
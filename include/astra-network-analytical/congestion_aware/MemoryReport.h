@@ -0,0 +1,90 @@
+/******************************************************************************
+This source code is licensed under the MIT license found in the
+LICENSE file in the root directory of this source tree.
+*******************************************************************************/
+
+#pragma once
+
+#include "common/MemoryCounter.h"
+#include <cstdint>
+#include <initializer_list>
+
+using namespace NetworkAnalytical;
+
+namespace NetworkAnalyticalCongestionAware {
+
+/**
+ * MemoryUsage is the memory held by a part of a simulation,
+ * as counted by the allocators of its containers (see TrackingAllocator).
+ */
+struct MemoryUsage {
+    /// bytes currently allocated
+    uint64_t bytes = 0;
+
+    /// most bytes allocated at once
+    uint64_t peak_bytes = 0;
+
+    /**
+     * Get the usage counted by a counter.
+     *
+     * @param memory_counter counter to read
+     * @return usage counted by the counter
+     */
+    [[nodiscard]] static MemoryUsage of(const MemoryCounter& memory_counter) noexcept {
+        return {memory_counter.get_bytes(), memory_counter.get_peak_bytes()};
+    }
+};
+
+/**
+ * MemoryReport breaks down the memory of a topology and of what it simulates on (see Topology::memory_report()).
+ * Parts a topology doesn't have are left at 0.
+ */
+struct MemoryReport {
+    /// Device objects and their port tables
+    MemoryUsage devices;
+
+    /// Link objects, eager and lazy
+    MemoryUsage links;
+
+    /// queues of the chunks waiting for a link (not the chunks themselves, see chunk_pool)
+    MemoryUsage pending_chunks;
+
+    /// cached flattened routes of send() and send_message()
+    MemoryUsage route_cache;
+
+    /// ExpanderGraph distance matrix and shortest-path tables
+    MemoryUsage distance_cache;
+
+    /// ExpanderGraph shortest paths found by a search
+    MemoryUsage shortest_route_cache;
+
+    /// ExpanderGraph candidate paths of RandomTopK and Adaptive routing
+    MemoryUsage topk_route_cache;
+
+    /// MultiDimTopology topologies per dimension (each summed over its parts) and routes recorded per dimension
+    MemoryUsage dims;
+
+    /// event queue of the simulation context
+    MemoryUsage event_queue;
+
+    /// slabs of the chunk pool, shared by every topology of the process
+    MemoryUsage chunk_pool;
+
+    /**
+     * Get the sum of every part.
+     * The peak is the sum of the peaks of the parts, so it bounds the actual peak from above.
+     *
+     * @return memory of the whole report
+     */
+    [[nodiscard]] MemoryUsage get_total() const noexcept {
+        auto total = MemoryUsage();
+        for (const auto* const part : {&devices, &links, &pending_chunks, &route_cache, &distance_cache,
+                                       &shortest_route_cache, &topk_route_cache, &dims, &event_queue, &chunk_pool}) {
+            total.bytes += part->bytes;
+            total.peak_bytes += part->peak_bytes;
+        }
+        return total;
+    }
+};
+
+}  // namespace NetworkAnalyticalCongestionAware
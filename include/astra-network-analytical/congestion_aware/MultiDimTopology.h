@@ -8,7 +8,11 @@ LICENSE file in the root directory of this source tree.
 #include "common/Type.h"
 #include "congestion_aware/BasicTopology.h"
 #include "congestion_aware/Topology.h"
+#include <array>
+#include <cstdint>
 #include <memory>
+#include <string>
+#include <utility>
 #include <vector>
 
 using namespace NetworkAnalytical;
@@ -28,12 +32,52 @@ class MultiDimTopology : public Topology {
      * Constructor.
      */
     MultiDimTopology() noexcept;
+
+    /// maximum number of dimensions
+    static constexpr int max_dims_count = 8;
+
     /// Each NPU ID can be broken down into multiple dimensions.
     /// for example, if the topology size is [2, 8, 4] and the NPU ID is 31,
     /// then the NPU ID can be broken down into [1, 7, 1].
-    using MultiDimAddress = std::vector<DeviceId>;
+    /// The address is stored inline; entries past the number of dimensions are 0.
+    using MultiDimAddress = std::array<DeviceId, max_dims_count>;
+
+    /**
+     * Order in which a route traverses the dimensions.
+     */
+    enum class DimOrder {
+        Static,   // from dimension 0 up
+        Reverse,  // from the last dimension down
+        Adaptive  // at each dimension change, the one whose next link drains its backlog the soonest
+    };
+
+    /**
+     * Parse a dimension order name ("static", "reverse", or "adaptive").
+     *
+     * @param dim_order_str name of the order, empty for static
+     * @return the dimension order
+     */
+    [[nodiscard]] static DimOrder parse_dim_order(const std::string& dim_order_str) noexcept;
+
+    /**
+     * Set the order in which routes traverse the dimensions.
+     * Should be called before any route is cached.
+     *
+     * @param dim_order the dimension order
+     */
+    void set_dim_order(DimOrder dim_order) noexcept;
+
+    /**
+     * Get the order in which routes traverse the dimensions.
+     *
+     * @return the dimension order
+     */
+    [[nodiscard]] DimOrder get_dim_order() const noexcept;
+
     /**
      * Implement the route method of Topology.
+     * Every link is connected by append_dimension(), so routing only reads the topology,
+     * and allocates nothing but the returned route in dimensions with static routes.
      */
     [[nodiscard]] Route route(DeviceId src, DeviceId dest) const noexcept override;
 
@@ -43,27 +87,57 @@ class MultiDimTopology : public Topology {
      * we use the device that's already in the chunk's route.
      */
     void send(std::unique_ptr<Chunk> chunk) noexcept override;
+    using Topology::send;
 
     /**
      * Add a dimension to the multi-dimensional topology.
+     * The devices are rebuilt each time: to build a topology at once, use append_dimensions().
      *
      * @param topology BasicTopology instance to be added.
      */
     void append_dimension(std::unique_ptr<BasicTopology> basic_topology) noexcept;
-  /**
-     * Initialize per-slice topologies on first use.
+
+    /**
+     * Add dimensions to the multi-dimensional topology,
+     * building the devices and their links once after the last one.
+     *
+     * @param topologies BasicTopology instances to be added, from the innermost dimension
+     */
+    void append_dimensions(std::vector<std::unique_ptr<BasicTopology>> topologies) noexcept;
+
+    /**
+     * Check that every route of every dimension goes from its src to its dest along existing links.
+     * Every line of NPUs along a dimension shares the dimension's routes,
+     * so each dimension is checked once; this is not done at construction.
+     * Reports an error and exits if a route is broken.
      */
-    void ensure_slices_initialized() const noexcept;
+    void validate() const noexcept;
 
     /**
-     * Build per-slice topologies and validate reachability.
+     * Implementation of memory_report in Topology, adding the topologies of the dimensions
+     * (without the event queue and chunk pool they share) and the routes recorded per dimension to dims.
      */
-    void build_slices_and_validate() const noexcept;
+    [[nodiscard]] MemoryReport memory_report() const noexcept override;
 
     /**
-     * Compute the slice index for a given dimension and address.
+     * Implementation of map_by_symmetry function in Topology.
+     * The address of each dimension is mapped by the symmetries of the dimension,
+     * so every dimension should have them.
      */
-    [[nodiscard]] size_t get_slice_index(int dim, const MultiDimAddress& address) const noexcept;
+    [[nodiscard]] DeviceId map_by_symmetry(DeviceId device, DeviceId npu) const noexcept override;
+
+    /**
+     * Implementation of set_routing_seed function in Topology.
+     * Each dimension draws from a seed of its own, derived from the given one.
+     * Flow ids are counted per local NPU of a dimension, shared by every line of NPUs along it,
+     * so routes only repeat across parallel runs if no two partitions route through the same random dimension.
+     */
+    void set_routing_seed(uint64_t seed) noexcept override;
+
+    /**
+     * Reset the links, and the routing state of every dimension.
+     */
+    void reset() noexcept override;
 
     /**
      * Translate the NPU ID into a multi-dimensional address.
@@ -91,11 +165,88 @@ class MultiDimTopology : public Topology {
     /// latency per each network dimension
     std::vector<Latency> latency_per_dim;
 
-    /// Per-slice topologies for each dimension.
-    mutable std::vector<std::vector<std::unique_ptr<BasicTopology>>> topology_slices_per_dim;
+    /// order in which routes traverse the dimensions
+    DimOrder dim_order = DimOrder::Static;
+
+    /// stride_per_dim[dim] -> difference between the ids of NPUs one step apart in dim
+    std::vector<DeviceId> stride_per_dim;
+
+    /// memory held by the links and routes recorded per dimension
+    std::shared_ptr<MemoryCounter> dims_memory = std::make_shared<MemoryCounter>();
 
-    /// Whether per-slice topologies have been instantiated.
-    mutable bool slices_initialized = false;
+    /// local_neighbors_per_dim[dim][id] -> local NPUs linked to local NPU id in dim
+    std::vector<std::vector<TrackedVector<DeviceId>>> local_neighbors_per_dim;
+
+    /// local_route_nodes_per_dim[dim] -> local NPU ids of every route of dim, back-to-back
+    /// (empty if the routes of dim aren't static)
+    std::vector<TrackedVector<DeviceId>> local_route_nodes_per_dim;
+
+    /// route (src, dest) of dim spans local_route_nodes_per_dim[dim][offsets[src * npus + dest], offsets[... + 1])
+    std::vector<TrackedVector<uint32_t>> local_route_offsets_per_dim;
+
+    /// range [first, last) of the local NPU ids of a route within a dimension
+    using LocalRoute = std::pair<const DeviceId*, const DeviceId*>;
+
+    /// pending_dims[dim] -> whether a route still has to traverse dim
+    using PendingDims = std::array<bool, max_dims_count>;
+
+    /**
+     * Get the coordinate of an NPU in a dimension.
+     */
+    [[nodiscard]] DeviceId get_local_id(DeviceId npu_id, int dim) const noexcept;
+
+    /**
+     * Get the route of a dimension between two of its local NPUs.
+     * Recorded routes are returned in place; others are routed into buffer.
+     */
+    [[nodiscard]] LocalRoute get_local_route(int dim,
+                                             DeviceId src_local_id,
+                                             DeviceId dest_local_id,
+                                             std::vector<DeviceId>& buffer) const noexcept;
+
+    /**
+     * Pick the next dimension to traverse from current towards dest, according to dim_order.
+     */
+    [[nodiscard]] int select_dim(DeviceId current,
+                                 DeviceId dest,
+                                 const PendingDims& pending_dims,
+                                 std::vector<DeviceId>& buffer) const noexcept;
+
+    /**
+     * Update static_routes from dim_order and the routes of every dimension.
+     */
+    void update_static_routes() noexcept;
+
+    /**
+     * Map a device id of a dimension's topology to the local NPU standing for it.
+     * Non-NPU devices (e.g., switches) are folded onto an NPU of the dimension.
+     *
+     * @param dim dimension
+     * @param local_id device id within the topology of dim
+     * @return local NPU id within dim
+     */
+    [[nodiscard]] DeviceId fold_local_id(int dim, DeviceId local_id) const noexcept;
+
+    /**
+     * Add a dimension, without rebuilding the devices.
+     */
+    void add_dimension(std::unique_ptr<BasicTopology> topology) noexcept;
+
+    /**
+     * Record the links and (if static) the routes of the last appended dimension in local ids.
+     */
+    void build_local_routes() noexcept;
+
+    /**
+     * Check the local route of a dimension from src to dest.
+     */
+    void validate_local_route(int dim, DeviceId src, DeviceId dest, const DeviceId* first, const DeviceId* last) const
+        noexcept;
+
+    /**
+     * Connect the links of every dimension between the global devices.
+     */
+    void materialize_links() noexcept;
 
   
 };
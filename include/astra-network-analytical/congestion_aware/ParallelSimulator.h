@@ -0,0 +1,151 @@
+/******************************************************************************
+This source code is licensed under the MIT license found in the
+LICENSE file in the root directory of this source tree.
+*******************************************************************************/
+
+#pragma once
+
+#include "common/EventQueue.h"
+#include "common/Type.h"
+#include "congestion_aware/Link.h"
+#include "congestion_aware/Topology.h"
+#include <memory>
+#include <vector>
+
+using namespace NetworkAnalytical;
+
+namespace NetworkAnalyticalCongestionAware {
+
+/**
+ * ParallelSimulator runs a congestion-aware simulation on multiple threads
+ * using conservative, window-synchronized parallel discrete-event simulation.
+ *
+ * Devices are split into contiguous id blocks, one per partition,
+ * and each partition owns an EventQueue driven by its own thread.
+ * For a MultiDimTopology this slices the system along the outermost dimension.
+ *
+ * The lookahead is the minimum latency over links crossing partitions:
+ * a chunk sent at time t cannot arrive at another partition before t + lookahead.
+ * Every window [T, T + lookahead), where T is the earliest pending event over all partitions,
+ * is therefore processed independently by each partition.
+ * Cross-partition arrivals are buffered and handed to the destination partition
+ * at the window boundary.
+ *
+ * Usage:
+ *   - construct the topology and create its links (MultiDimTopology connects links lazily
+ *     inside route(), so route every pair you are going to use beforehand),
+ *   - construct the ParallelSimulator, which binds each link to its partition,
+ *   - inject chunks through Topology::send(),
+ *   - call run().
+ *
+ * Chunk callbacks are invoked on the thread owning the destination device,
+ * so they should only touch state local to that device (or synchronize).
+ * Completions can't be batched (see SimulationContext::set_completion_batcher()), as sinks span partitions.
+ * A chunk sent from a callback should start at the device on which the callback runs.
+ */
+class ParallelSimulator {
+  public:
+    /**
+     * Constructor.
+     * Falls back to a single partition if some cross-partition link has zero latency.
+     *
+     * @param topology topology to simulate, with every link already connected
+     * @param threads_count requested number of partitions (worker threads)
+     */
+    ParallelSimulator(std::shared_ptr<Topology> topology, int threads_count) noexcept;
+
+    /**
+     * Destructor.
+     * Rebinds every link to the shared event queue.
+     */
+    ~ParallelSimulator() noexcept;
+
+    ParallelSimulator(const ParallelSimulator&) = delete;
+    ParallelSimulator& operator=(const ParallelSimulator&) = delete;
+
+    /**
+     * Run the simulation until no event is left in any partition.
+     */
+    void run() noexcept;
+
+    /**
+     * Get the current simulation time,
+     * i.e., the latest event time processed by any partition.
+     *
+     * @return current simulation time
+     */
+    [[nodiscard]] EventTime get_current_time() const noexcept;
+
+    /**
+     * Get the number of partitions in use.
+     *
+     * @return number of partitions
+     */
+    [[nodiscard]] int get_partitions_count() const noexcept;
+
+    /**
+     * Get the lookahead used to size synchronization windows.
+     *
+     * @return lookahead in ns
+     */
+    [[nodiscard]] EventTime get_lookahead() const noexcept;
+
+    /**
+     * Get the partition owning the given device.
+     *
+     * @param device_id id of the device
+     * @return partition id
+     */
+    [[nodiscard]] int get_partition(DeviceId device_id) const noexcept;
+
+  private:
+    /// topology being simulated
+    std::shared_ptr<Topology> topology;
+
+    /// number of partitions
+    int partitions_count;
+
+    /// lookahead between partitions
+    EventTime lookahead;
+
+    /// event queue per partition
+    std::vector<std::unique_ptr<EventQueue>> event_queues;
+
+    /// cross-partition arrivals buffered by each (source) partition during a window
+    std::vector<std::vector<RemoteArrival>> remote_arrivals;
+
+    /**
+     * Compute the lookahead for the current partitioning.
+     *
+     * @return minimum latency over cross-partition links, 0 if they have none
+     */
+    [[nodiscard]] EventTime compute_lookahead() const noexcept;
+
+    /**
+     * Bind every link to the partition owning its source device.
+     */
+    void bind_links() noexcept;
+
+    /**
+     * Process the events of a partition that fall before window_end.
+     *
+     * @param partition partition id
+     * @param window_end exclusive end of the window
+     */
+    void process_window(int partition, EventTime window_end) noexcept;
+
+    /**
+     * Move every buffered cross-partition arrival into its destination's event queue.
+     * Outboxes are drained in partition order so the run is reproducible.
+     */
+    void exchange_remote_arrivals() noexcept;
+
+    /**
+     * Check whether every partition has finished.
+     *
+     * @return true if no event is pending anywhere, false otherwise
+     */
+    [[nodiscard]] bool finished() const noexcept;
+};
+
+}  // namespace NetworkAnalyticalCongestionAware
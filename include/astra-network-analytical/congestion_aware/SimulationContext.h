@@ -0,0 +1,270 @@
+/******************************************************************************
+This source code is licensed under the MIT license found in the
+LICENSE file in the root directory of this source tree.
+*******************************************************************************/
+
+#pragma once
+
+#include "common/EventQueue.h"
+#include "common/Type.h"
+#include "congestion_aware/LinkStates.h"
+#include <array>
+#include <memory>
+
+using namespace NetworkAnalytical;
+
+namespace NetworkAnalyticalCongestionAware {
+
+class ChunkTracer;
+class CompletionBatcher;
+
+/**
+ * SimulationContext holds the state shared by every link of a simulation:
+ * the event queue, the link settings, and the mutable state of the links (see LinkStates).
+ *
+ * Each topology refers to one context, which chunks sent without a context of their own are simulated in,
+ * so topologies with separate contexts can be simulated concurrently
+ * (e.g., one simulation per thread of a parameter sweep).
+ * As links keep no simulation state of their own, but find it in the context of each chunk and event,
+ * a topology can also be moved from one context to another and back, each context resuming its own simulation,
+ * or simulated under several contexts at once (see Topology::send()), as long as the topology itself isn't modified:
+ * routes precomputed (see Topology::precompute_routes()) or described, no lazy link created,
+ * and no failure, reset or release of idle links meanwhile.
+ * Chunk storage is already pooled per thread (see ChunkPool) and needs no context.
+ *
+ * Topologies not given a context use the default one,
+ * which the static Topology::set_event_queue() and Topology::set_link_coalescing() configure.
+ */
+class SimulationContext {
+  public:
+    /// order links send the pending chunks of distinct traffic classes in (see set_link_scheduling())
+    enum class LinkScheduling { StrictPriority, DeficitRoundRobin };
+
+    /// bytes per traffic class and per turn under deficit round-robin
+    using Quanta = std::array<ChunkSize, LinkStates::traffic_classes_count>;
+
+    /// quantum of every traffic class unless set otherwise
+    static constexpr ChunkSize default_quantum = 1 << 20;
+
+    /**
+     * Get the default context, shared by the topologies not given one.
+     *
+     * @return pointer to the default context
+     */
+    [[nodiscard]] static std::shared_ptr<SimulationContext> get_default() noexcept;
+
+    /**
+     * Constructor.
+     *
+     * @param event_queue event queue links schedule their events on
+     */
+    explicit SimulationContext(std::shared_ptr<EventQueue> event_queue = nullptr) noexcept;
+
+    /**
+     * Set the event queue links schedule their events on.
+     *
+     * @param event_queue pointer to the event queue
+     */
+    void set_event_queue(std::shared_ptr<EventQueue> event_queue) noexcept;
+
+    /**
+     * Get the event queue links schedule their events on.
+     *
+     * @return pointer to the event queue
+     */
+    [[nodiscard]] EventQueue* get_event_queue() const noexcept;
+
+    /**
+     * Enable or disable busy-period coalescing on the links.
+     * When a coalescing link becomes free with a backlog, the departures of every pending chunk
+     * follow from their serialization delays, so the link schedules all their arrivals at once
+     * and a single link-free event at the end of the busy period.
+     * Chunks sent meanwhile queue up for the next busy period, as in FIFO order they'd depart after
+     * the planned ones anyway. Only chunks nothing could overtake are planned ahead:
+     * class 0 under strict priority (see set_link_scheduling()).
+     * Disabled by default.
+     *
+     * @param enabled true to coalesce busy periods
+     */
+    void set_link_coalescing(bool enabled) noexcept;
+
+    /**
+     * Check whether links coalesce busy periods.
+     *
+     * @return true if links coalesce busy periods, false otherwise
+     */
+    [[nodiscard]] bool get_link_coalescing() const noexcept;
+
+    /**
+     * Enable or disable the hybrid-fidelity fast path.
+     * A chunk whose every link is idle when it's sent skips the per-hop events:
+     * its departure and arrival times follow in closed form, with the same delays links would give,
+     * and each link reserves the interval the chunk is serialized on.
+     * Chunks reaching a link during its reservation queue behind it as if it were busy,
+     * while a chunk reaching it before the reservation starts goes first,
+     * and the reserved chunk resumes the per-hop path from the link it hasn't crossed yet.
+     * So only contended chunks pay for per-hop simulation.
+     * The fast path is only taken while no chunk sent with it enabled is in flight on the per-hop path,
+     * as such a chunk could reach a reserved link first, and would go first in a full simulation.
+     * Disabled by default.
+     *
+     * @param enabled true to enable the fast path
+     */
+    void set_hybrid_fidelity(bool enabled) noexcept;
+
+    /**
+     * Check whether the hybrid-fidelity fast path is enabled.
+     *
+     * @return true if enabled, false otherwise
+     */
+    [[nodiscard]] bool get_hybrid_fidelity() const noexcept;
+
+    /**
+     * Count a chunk sent on the per-hop path while the fast path is enabled (see Chunk::set_per_hop()).
+     */
+    void add_per_hop_chunk() noexcept;
+
+    /**
+     * Stop counting a per-hop chunk, once it completed.
+     */
+    void remove_per_hop_chunk() noexcept;
+
+    /**
+     * Forget every per-hop chunk, e.g., once the chunks in flight were dropped.
+     */
+    void clear_per_hop_chunks() noexcept;
+
+    /**
+     * Get the number of chunks in flight on the per-hop path, sent while the fast path is enabled.
+     *
+     * @return number of per-hop chunks
+     */
+    [[nodiscard]] uint64_t get_per_hop_chunks_count() const noexcept;
+
+    /**
+     * Switch the links from store-and-forward to cut-through forwarding, or back.
+     * Under cut-through, a chunk is forwarded by a device once its first flit arrived,
+     * instead of once it arrived as a whole, so its serializations on consecutive links overlap
+     * and a multi-hop route costs one serialization of the chunk (on its slowest link) plus one per flit and hop.
+     * A link still serializes a chunk no faster than its previous link delivers it,
+     * and the chunk is complete when its tail arrives at its destination.
+     * Timings follow in closed form, so chunks still take one arrival event per hop.
+     * Store-and-forward by default.
+     *
+     * @param flit_size bytes a device receives before forwarding a chunk, 0 for store-and-forward
+     */
+    void set_cut_through(ChunkSize flit_size) noexcept;
+
+    /**
+     * Get the bytes a device receives before forwarding a chunk under cut-through.
+     *
+     * @return flit size, 0 under store-and-forward
+     */
+    [[nodiscard]] ChunkSize get_cut_through_flit_size() const noexcept;
+
+    /**
+     * Set how links pick the traffic class to send a pending chunk of (see Chunk::set_traffic_class()).
+     * Chunks of a class are always sent in FIFO order.
+     *   - StrictPriority: the lowest class with pending chunks goes first, so class 0 is the most urgent.
+     *   - DeficitRoundRobin: classes with pending chunks take turns, each sending up to its quantum of bytes per turn
+     *     (plus what it couldn't use in earlier turns), so classes share a busy link in proportion to their quanta.
+     * Strict priority by default, which is plain FIFO as long as chunks keep the default class.
+     * Coalescing links (see set_link_coalescing()) only plan class-0 chunks ahead under strict priority,
+     * and no chunk ahead under deficit round-robin, so the policy holds for chunks arriving during a busy period.
+     *
+     * @param link_scheduling scheduling policy of the links
+     * @param quanta bytes each traffic class sends per turn under deficit round-robin
+     */
+    void set_link_scheduling(LinkScheduling link_scheduling, const Quanta& quanta = default_quanta()) noexcept;
+
+    /**
+     * Get how links pick the traffic class to send a pending chunk of.
+     *
+     * @return scheduling policy of the links
+     */
+    [[nodiscard]] LinkScheduling get_link_scheduling() const noexcept;
+
+    /**
+     * Get the bytes a traffic class sends per turn under deficit round-robin.
+     *
+     * @param traffic_class traffic class
+     * @return quantum of the class
+     */
+    [[nodiscard]] ChunkSize get_quantum(int traffic_class) const noexcept;
+
+    /**
+     * Set the tracer recording the lifecycle of the chunks sent from now on.
+     *
+     * @param chunk_tracer tracer to record into, nullptr to stop tracing
+     */
+    void set_chunk_tracer(std::shared_ptr<ChunkTracer> chunk_tracer) noexcept;
+
+    /**
+     * Get the tracer recording the lifecycle of chunks.
+     *
+     * @return pointer to the tracer, nullptr if chunks aren't traced
+     */
+    [[nodiscard]] ChunkTracer* get_chunk_tracer() const noexcept;
+
+    /**
+     * Set the batcher handing the chunks completing at the same time over to their sinks at once.
+     * Disabled by default, i.e., the callback of each chunk is invoked when it arrives.
+     *
+     * @param completion_batcher batcher to complete chunks through, nullptr to stop batching
+     */
+    void set_completion_batcher(std::shared_ptr<CompletionBatcher> completion_batcher) noexcept;
+
+    /**
+     * Get the batcher completing chunks.
+     *
+     * @return pointer to the batcher, nullptr if completions aren't batched
+     */
+    [[nodiscard]] CompletionBatcher* get_completion_batcher() const noexcept;
+
+    /**
+     * Get the mutable state of the links simulated in this context.
+     *
+     * @return link state table of the context
+     */
+    [[nodiscard]] LinkStates& get_link_states() noexcept;
+
+  private:
+    /**
+     * Get the quanta of traffic classes sharing links evenly.
+     *
+     * @return default_quantum for every class
+     */
+    [[nodiscard]] static Quanta default_quanta() noexcept;
+
+    /// event queue links schedule their events on
+    std::shared_ptr<EventQueue> event_queue;
+
+    /// whether links coalesce busy periods
+    bool link_coalescing;
+
+    /// whether uncontended chunks take the closed-form fast path
+    bool hybrid_fidelity;
+
+    /// number of chunks in flight on the per-hop path, sent while the fast path is enabled
+    uint64_t per_hop_chunks_count;
+
+    /// bytes received before forwarding a chunk under cut-through, 0 for store-and-forward
+    ChunkSize cut_through_flit_size;
+
+    /// order links send the pending chunks of distinct traffic classes in
+    LinkScheduling link_scheduling;
+
+    /// bytes per traffic class and per turn under deficit round-robin
+    Quanta quanta;
+
+    /// tracer recording the lifecycle of chunks, nullptr if not tracing
+    std::shared_ptr<ChunkTracer> chunk_tracer;
+
+    /// batcher completing chunks, nullptr if completions aren't batched
+    std::shared_ptr<CompletionBatcher> completion_batcher;
+
+    /// mutable state of the links simulated in this context
+    LinkStates link_states;
+};
+
+}  // namespace NetworkAnalyticalCongestionAware
@@ -0,0 +1,101 @@
+/******************************************************************************
+This source code is licensed under the MIT license found in the
+LICENSE file in the root directory of this source tree.
+*******************************************************************************/
+
+#pragma once
+
+#include "common/Type.h"
+#include "congestion_aware/Topology.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace NetworkAnalytical;
+
+namespace NetworkAnalyticalCongestionAware {
+
+/**
+ * SimulationFork explores what-if variants of a simulation from a common checkpoint,
+ * without simulating the warm-up once per variant.
+ *
+ * The simulation runs up to the checkpoint time in this process. Each variant then runs
+ * in a child process forked from it, whose memory is a copy-on-write image of the whole simulation:
+ * the event queue, the busy and pending state of every link, the chunks in flight with their routes,
+ * and the chunk pools. Nothing is copied up front, and pages are only duplicated once a variant writes them.
+ * A variant is set up by a callback (e.g., it sends its own traffic, or reconfigures the network),
+ * runs until its event queue is empty, and reports its finish time (and optionally a string) back through a pipe.
+ * The simulation of this process stays at the checkpoint, so it can be resumed, or forked again later.
+ *
+ * Only single-threaded simulations can be forked, as a child process only runs the forking thread:
+ * contexts being traced (see SimulationContext::set_chunk_tracer()) or partitioned by a ParallelSimulator can't.
+ */
+class SimulationFork {
+  public:
+    /// callback setting up a variant in its own process, before it resumes
+    using VariantSetup = void (*)(int variant, void* arg);
+
+    /// callback describing the outcome of a variant in its own process, once it finished
+    using VariantReport = std::string (*)(int variant, void* arg);
+
+    /// outcome of a variant
+    struct VariantResult {
+        /// whether the variant ran to completion and reported back
+        bool completed;
+
+        /// time when the event queue of the variant got empty
+        EventTime finish_time;
+
+        /// string reported by the variant, empty if none
+        std::string report;
+    };
+
+    /**
+     * Constructor.
+     *
+     * @param topology topology being simulated, on its own event queue
+     */
+    explicit SimulationFork(std::shared_ptr<Topology> topology) noexcept;
+
+    /**
+     * Run the simulation until every event registered at or before checkpoint_time is invoked.
+     *
+     * @param checkpoint_time time of the checkpoint
+     * @return current time of the simulation
+     */
+    EventTime checkpoint(EventTime checkpoint_time) noexcept;
+
+    /**
+     * Run variants of the simulation from its current state, each in its own process.
+     * Exits the program if a process can't be forked.
+     *
+     * @param variants_count number of variants
+     * @param setup callback setting up each variant
+     * @param arg argument of the callbacks
+     * @param report callback describing the outcome of each variant, nullptr for no report
+     * @param processes_count number of variants running at once, 0 to use the hardware concurrency
+     * @return outcome of each variant, in variant order
+     */
+    [[nodiscard]] std::vector<VariantResult> fork(int variants_count,
+                                                  VariantSetup setup,
+                                                  void* arg,
+                                                  VariantReport report = nullptr,
+                                                  int processes_count = 0) const noexcept;
+
+  private:
+    /// topology being simulated
+    std::shared_ptr<Topology> topology;
+
+    /**
+     * Run a variant in the forked process, write its outcome to the pipe, and exit.
+     */
+    [[noreturn]] void run_variant(int variant, VariantSetup setup, void* arg, VariantReport report, int fd) const
+        noexcept;
+
+    /**
+     * Read the outcome of a variant from its pipe, and reap its process.
+     */
+    [[nodiscard]] static VariantResult collect_variant(int pid, int fd) noexcept;
+};
+
+}  // namespace NetworkAnalyticalCongestionAware
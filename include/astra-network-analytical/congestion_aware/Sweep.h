@@ -0,0 +1,135 @@
+/******************************************************************************
+This source code is licensed under the MIT license found in the
+LICENSE file in the root directory of this source tree.
+*******************************************************************************/
+
+#pragma once
+
+#include "common/Type.h"
+#include <ostream>
+#include <string>
+#include <vector>
+#include <yaml-cpp/yaml.h>
+
+using namespace NetworkAnalytical;
+
+namespace NetworkAnalyticalCongestionAware {
+
+/**
+ * Sweep runs a set of workloads on every combination of swept network parameters.
+ *
+ * The sweep spec is a yml file naming a base network config, lists of values to sweep
+ * (each value is a per-dimension list, as in the network config), and the workloads:
+ *
+ *   network: Ring.yml                      # base network config, relative to the spec
+ *   sweep:
+ *     bandwidth: [ [ 50.0 ], [ 100.0 ] ]   # also npus_count, latency, routing_algorithm
+ *   workloads:
+ *     - { name: a2a, pattern: AllToAll, size: 1048576 }
+ *     - { pattern: AllGather, size: 16777216, chunk_size: 1048576 }
+ *   threads: 8                             # optional, hardware concurrency by default
+ *
+ * Points run on a pool of threads, each in its own simulation context.
+ * A point's topology is constructed once and reset between its workloads,
+ * and results stream out as CSV rows as soon as each point completes.
+ */
+class Sweep {
+  public:
+    /// traffic pattern of a workload
+    enum class Pattern {
+        AllToAll,  // every NPU sends size bytes to every other NPU
+        Shift,     // every NPU sends size bytes to the next NPU
+        AllGather  // ring All-Gather of size bytes in total, step by step
+    };
+
+    /// a workload run on every point
+    struct Workload {
+        /// name in the results
+        std::string name;
+
+        /// traffic pattern
+        Pattern pattern;
+
+        /// size of the workload in bytes
+        ChunkSize size;
+
+        /// size of the chunks messages are segmented into
+        ChunkSize chunk_size;
+    };
+
+    /**
+     * Constructor.
+     *
+     * @param path path of the sweep spec yml file
+     */
+    explicit Sweep(const std::string& path) noexcept;
+
+    /**
+     * Get the number of combinations of swept parameters.
+     *
+     * @return number of points
+     */
+    [[nodiscard]] int get_points_count() const noexcept;
+
+    /**
+     * Get the workloads run on every point.
+     *
+     * @return workloads
+     */
+    [[nodiscard]] const std::vector<Workload>& get_workloads() const noexcept;
+
+    /**
+     * Run every workload on every point, and write a CSV row per run:
+     * point, the swept parameters, workload, pattern, size, and finish time in ns.
+     * Rows of a point are written together, in workload order; points complete in any order.
+     *
+     * @param output stream the CSV is written to
+     * @param threads_count number of threads, 0 to use the spec's (or the hardware concurrency)
+     */
+    void run(std::ostream& output, int threads_count = 0) const noexcept;
+
+  private:
+    /// swept keys of the network config, in the order their values are combined
+    std::vector<std::string> swept_keys;
+
+    /// values of each swept key
+    std::vector<std::vector<YAML::Node>> swept_values;
+
+    /// base network config
+    YAML::Node base_network_config;
+
+    /// path of the base network config
+    std::string network_path;
+
+    /// workloads run on every point
+    std::vector<Workload> workloads;
+
+    /// number of threads given by the spec, 0 if not specified
+    int spec_threads_count;
+
+    /**
+     * Parse a workload pattern name.
+     *
+     * @param name pattern name
+     * @return parsed pattern
+     */
+    [[nodiscard]] static Pattern parse_pattern(const std::string& name) noexcept;
+
+    /**
+     * Get the values of the swept keys at a point.
+     *
+     * @param point index of the point
+     * @return value index of each swept key
+     */
+    [[nodiscard]] std::vector<int> get_value_indices(int point) const noexcept;
+
+    /**
+     * Simulate a point, and format its CSV rows.
+     *
+     * @param point index of the point
+     * @return CSV rows of the point
+     */
+    [[nodiscard]] std::string run_point(int point) const noexcept;
+};
+
+}  // namespace NetworkAnalyticalCongestionAware
@@ -5,9 +5,11 @@ LICENSE file in the root directory of this source tree.
 
 #pragma once
 
+#include "common/CsrGraph.h"
 #include "common/Type.h"
 #include "congestion_aware/BasicTopology.h"
 #include <cassert>
+#include <map>
 
 using namespace NetworkAnalytical;
 
@@ -44,14 +46,39 @@ class Switch final : public BasicTopology {
      */
     [[nodiscard]] Route route(DeviceId src, DeviceId dest) const noexcept override;
 
+    /**
+     * Implementation of describe_route function in Topology.
+     * Routes go through the switch.
+     */
+    [[nodiscard]] bool describe_route(DeviceId src,
+                                      DeviceId dest,
+                                      RouteDescriptor& route_descriptor) const noexcept override;
+
+    /**
+     * Implementation of map_by_symmetry function in Topology.
+     * NPUs are rotated, and the switch stays in place.
+     */
+    [[nodiscard]] DeviceId map_by_symmetry(DeviceId device, DeviceId npu) const noexcept override;
+
     /**
      * Clone this topology instance.
      */
     [[nodiscard]] std::unique_ptr<BasicTopology> clone() const noexcept override;
     std::map<DeviceId, std::vector<DeviceId>> adjacency_list;
+
+    /**
+     * Get the graph of the topology, built once at construction.
+     *
+     * @return graph in CSR form
+     */
+    [[nodiscard]] const CsrGraph& get_graph() const noexcept;
+
   private:
     /// node_id of the switch node
     DeviceId switch_id;
+
+    /// adjacency_list in CSR form
+    CsrGraph graph;
 };
 
 }  // namespace NetworkAnalyticalCongestionAware
@@ -1,10 +1,13 @@
 #pragma once
+#include "common/CsrGraph.h"
 #include "congestion_aware/BasicTopology.h"
 #include "congestion_aware/ExpanderGraph.h"
 #include "congestion_aware/Switch.h"
+#include <cstdint>
 #include <map>
 #include <memory>
 #include <string>
+#include <vector>
 
 namespace NetworkAnalyticalCongestionAware {
 
@@ -13,10 +16,106 @@ class SwitchOrExpander final : public BasicTopology {
     SwitchOrExpander(int npus_count, Bandwidth bandwidth, Latency latency, const std::string& inputfile = std::string(), const std::string& routing_algorithm = std::string(), bool use_resiliency = false) noexcept;
     [[nodiscard]] Route route(DeviceId src, DeviceId dest) const noexcept override;
     [[nodiscard]] std::unique_ptr<BasicTopology> clone() const noexcept override;
+
+    /**
+     * Set the seed of the random routes, which the expander graph draws.
+     */
+    void set_routing_seed(uint64_t seed) noexcept override;
+
+    /**
+     * Reset the links, and the flow ids of the expander graph.
+     */
+    void reset() noexcept override;
+
     unsigned int get_distance(const DeviceId src, const DeviceId dest) const noexcept;
     int compute_hops_count(const DeviceId src, const DeviceId dest) const noexcept;
-    std::map<DeviceId, std::vector<DeviceId>> get_adjacency_list() const noexcept;
+    const std::map<DeviceId, std::vector<DeviceId>>& get_adjacency_list() const noexcept;
+
+    /**
+     * Get the graph used by the current routing mode.
+     *
+     * @return expander graph if any device routes through it, switch graph otherwise
+     */
+    [[nodiscard]] const CsrGraph& get_graph() const noexcept;
+
+    /**
+     * Select the routing mode of a device.
+     *
+     * @param id id of the device
+     * @param enabled true to route through the expander graph, false through the switch
+     */
+    void set_moe_routing(DeviceId id, bool enabled) noexcept;
+
+    /**
+     * Select the routing mode of every device.
+     *
+     * @param enabled true to route through the expander graph, false through the switch
+     */
+    void set_moe_routing(bool enabled) noexcept;
+
+    /**
+     * Select the routing mode of a group of devices.
+     *
+     * @param ids ids of the devices
+     * @param enabled true to route through the expander graph, false through the switch
+     */
+    void set_moe_routing(const std::vector<DeviceId>& ids, bool enabled) noexcept;
+
+    /**
+     * Check the routing mode of a device.
+     *
+     * @param id id of the device
+     * @return true if the device routes through the expander graph, false through the switch
+     */
+    [[nodiscard]] bool is_moe_routing(DeviceId id) const noexcept;
+
+    /**
+     * Register a routing phase (e.g., the MoE layers of a training step),
+     * where the given devices route through the expander graph and the others through the switch.
+     * Phase 0 is the initial one, and set_moe_routing() edits the active phase.
+     *
+     * @param moe_ids ids of the devices routing through the expander graph
+     * @return id of the new phase
+     */
+    [[nodiscard]] int add_routing_phase(const std::vector<DeviceId>& moe_ids) noexcept;
+
+    /**
+     * Switch every device to the routing modes of a phase, in constant time.
+     * Chunks already in flight keep their routes.
+     *
+     * @param phase id of the phase
+     */
+    void set_routing_phase(int phase) noexcept;
+
+    /**
+     * Get the active routing phase.
+     *
+     * @return id of the active phase
+     */
+    [[nodiscard]] int get_routing_phase() const noexcept;
+
   private:
+    /**
+     * Routing modes of every device during a phase.
+     */
+    struct RoutingPhase {
+        /// bit (id % 64) of word (id / 64) -> whether device id routes through the expander graph
+        std::vector<uint64_t> moe_mask;
+
+        /// number of devices routing through the expander graph
+        int moe_count = 0;
+    };
+
+    /**
+     * Check whether any device routes through the expander graph.
+     */
+    [[nodiscard]] bool any_moe_routing() const noexcept;
+
+    /**
+     * Select the routing mode of a device during a phase.
+     */
+    void set_phase_moe_routing(RoutingPhase& phase, DeviceId id, bool enabled) const noexcept;
+
     Route remap_route_to_local(const Route& foreign_route) const noexcept;
     Switch switch_topology;
     std::unique_ptr<ExpanderGraph> expander_topology;
@@ -24,6 +123,12 @@ class SwitchOrExpander final : public BasicTopology {
     std::string inputfile_path;
     std::string routing_algorithm_str;
     bool use_resiliency = false;
+
+    /// routing modes of every registered phase
+    std::vector<RoutingPhase> routing_phases;
+
+    /// routing modes of the active phase
+    RoutingPhase* active_phase;
 };
 
 } // namespace NetworkAnalyticalCongestionAware
@@ -0,0 +1,115 @@
+/******************************************************************************
+This source code is licensed under the MIT license found in the
+LICENSE file in the root directory of this source tree.
+*******************************************************************************/
+
+#pragma once
+
+#include "common/Type.h"
+#include "congestion_aware/Topology.h"
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+using namespace NetworkAnalytical;
+
+namespace NetworkAnalyticalCongestionAware {
+
+/**
+ * SymmetricSimulation simulates a symmetric traffic pattern on a symmetric topology
+ * with one representative transfer per orbit, e.g., the all-gather pattern where every NPU sends to every other.
+ *
+ * When the symmetries of the topology (see Topology::map_by_symmetry()) map the transfers onto themselves,
+ * every NPU sees the same traffic, and every link the same backlog as its images.
+ * Only the transfers from NPU 0 are simulated then, and each hop of their routes goes over the representative
+ * of its link's orbit (the image with the smallest ids), which carries the traffic of every link of the orbit.
+ * Each transfer completes when its representative does, so the simulation takes about npus_count times fewer events.
+ *
+ * Transfers are reduced if:
+ *   - the topology has symmetries and static routes, and the routes of the transfers follow the symmetries,
+ *   - links mapped onto each other have the same bandwidth and latency, and none of them failed,
+ *   - no symmetry but the identity maps a link of a route onto itself (e.g., a link between two switches),
+ *   - every image of a transfer is a transfer as well,
+ *   - chunks aren't traced, as representatives don't follow the actual routes.
+ * Otherwise, every transfer is simulated.
+ */
+class SymmetricSimulation {
+  public:
+    /// transfer of a chunk from an NPU to another
+    struct Transfer {
+        /// NPU sending the chunk
+        DeviceId src;
+
+        /// NPU receiving the chunk
+        DeviceId dest;
+
+        /// size of the chunk
+        ChunkSize size;
+    };
+
+    /// outcome of a simulation
+    struct Result {
+        /// whether the transfers got reduced to one per orbit
+        bool reduced;
+
+        /// number of transfers actually simulated
+        size_t simulated_transfers_count;
+
+        /// completion time of each transfer, in the order given
+        std::vector<EventTime> completion_times;
+    };
+
+    /**
+     * Constructor.
+     *
+     * @param topology topology to simulate on
+     */
+    explicit SymmetricSimulation(std::shared_ptr<Topology> topology) noexcept;
+
+    /**
+     * Send the transfers at the current time, and run the event queue until it's empty.
+     * The network should be idle, and no other event pending, as the simulation takes up the whole network.
+     *
+     * @param transfers transfers to simulate
+     * @return outcome of the simulation
+     */
+    [[nodiscard]] Result run(const std::vector<Transfer>& transfers) noexcept;
+
+  private:
+    /// topology to simulate on
+    std::shared_ptr<Topology> topology;
+
+    /// transfers of the current run grouped by orbit, see reduce()
+    struct Orbits {
+        /// transfers from NPU 0, in the order given
+        std::vector<size_t> representatives;
+
+        /// representative_of[transfer] -> index in representatives of the representative of the transfer
+        std::vector<size_t> representative_of;
+
+        /// representative_hops[representative] -> route of the representative over link representatives
+        std::vector<RouteHops> representative_hops;
+    };
+
+    /**
+     * Group the transfers by orbit, if they can be reduced.
+     *
+     * @param transfers transfers to simulate
+     * @param orbits orbits of the transfers, filled if they can be reduced
+     * @return true if the transfers can be reduced, false otherwise
+     */
+    [[nodiscard]] bool reduce(const std::vector<Transfer>& transfers, Orbits& orbits) const noexcept;
+
+    /**
+     * Get the representative of the orbit of a link, checking that the symmetries map it onto alike links.
+     *
+     * @param device device the link leaves
+     * @param next_device device the link leads to
+     * @param representative representative hop (device and port of the link), filled if the orbit is valid
+     * @return true if the orbit is valid, false otherwise
+     */
+    [[nodiscard]] bool find_link_representative(DeviceId device, DeviceId next_device, RouteHop& representative) const
+        noexcept;
+};
+
+}  // namespace NetworkAnalyticalCongestionAware
@@ -8,30 +8,93 @@ LICENSE file in the root directory of this source tree.
 #include "common/EventQueue.h"
 #include "congestion_aware/Chunk.h"
 #include "congestion_aware/Device.h"
+#include "congestion_aware/MemoryReport.h"
+#include "congestion_aware/SimulationContext.h"
+#include <cstdint>
 #include <memory>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 using namespace NetworkAnalytical;
 
 namespace NetworkAnalyticalCongestionAware {
 
+/**
+ * A chunk delivered on the hybrid-fidelity fast path (see Topology::send_uncontended()),
+ * holding the reservations of the links of its route until it completes or resumes the per-hop path.
+ */
+struct ReservedChunk {
+    /// the chunk, at the source of its route, nullptr once it resumed the per-hop path
+    std::unique_ptr<Chunk> chunk;
+
+    /// time when the chunk departed its source
+    EventTime departure_time;
+
+    /// time when the tail of the chunk arrived at its source (see Chunk::get_tail_arrival_time())
+    EventTime tail_arrival_time;
+
+    /// completion event of the chunk
+    EventHandle completion;
+};
+
 /**
  * Topology abstracts a network topology.
  */
 class Topology {
   public:
     /**
-     * Set the event queue to be used by the topology.
+     * Set the event queue of the default simulation context,
+     * used by the topologies not given a context of their own.
      *
      * @param event_queue pointer to the event queue
      */
     static void set_event_queue(std::shared_ptr<EventQueue> event_queue) noexcept;
 
+    /**
+     * Enable or disable busy-period coalescing in the default simulation context
+     * (see SimulationContext::set_link_coalescing).
+     *
+     * @param enabled true to coalesce busy periods
+     */
+    static void set_link_coalescing(bool enabled) noexcept;
+
     /**
      * Constructor.
+     * The topology starts in the default simulation context.
      */
     Topology() noexcept;
 
+    /**
+     * Move the topology to another simulation context, which chunks sent without a context of their own
+     * are simulated in from now on (see Chunk::get_simulation_context()).
+     * Topologies in separate contexts can be simulated concurrently,
+     * as can one topology under several contexts (see SimulationContext).
+     *
+     * @param context simulation context providing the event queue and the link settings
+     */
+    void set_simulation_context(std::shared_ptr<SimulationContext> context) noexcept;
+
+    /**
+     * Return the topology to its state right after construction, to run another simulation on it:
+     * every link becomes free with no pending chunks, and per-run routing state starts over.
+     * Routes and the tables they're computed from (route cache, distances, k-shortest paths) are kept.
+     *
+     * Pending events of the links would refer to the dropped state,
+     * so the event queue should be finished or reset (see EventQueue::reset()),
+     * or a new context attached (see set_simulation_context()).
+     */
+    virtual void reset() noexcept;
+
+    /**
+     * Get the simulation context of the topology.
+     *
+     * @return pointer to the simulation context
+     */
+    [[nodiscard]] std::shared_ptr<SimulationContext> get_simulation_context() const noexcept;
+
     /**
      * Construct the route from src to dest.
      * Route is a list of devices (pointers) that the chunk should traverse,
@@ -46,6 +109,18 @@ class Topology {
      */
     [[nodiscard]] virtual Route route(DeviceId src, DeviceId dest) const noexcept = 0;
 
+    /**
+     * Describe the route from src to dest, for topologies whose routes follow from arithmetic
+     * (e.g., Ring, Switch, FullyConnected), so chunks compute their hops instead of storing them.
+     * The described route is the one route() returns.
+     *
+     * @param src src NPU id
+     * @param dest dest NPU id
+     * @param route_descriptor description of the route, if described
+     * @return true if the route has been described, false if the topology doesn't describe routes
+     */
+    [[nodiscard]] virtual bool describe_route(DeviceId src, DeviceId dest, RouteDescriptor& route_descriptor) const noexcept;
+
     /**
      * Initiate a transmission of a chunk.
      *
@@ -53,6 +128,351 @@ class Topology {
      */
     virtual void send(std::unique_ptr<Chunk> chunk) noexcept;
 
+    /**
+     * Initiate a transmission of a chunk from src to dest.
+     * The route is looked up in the route cache of the topology (see get_route_hops),
+     * so no Route is built for the caller.
+     * Described routes (see describe_route) longer than a chunk stores inline,
+     * and those past the cache capacity, aren't cached: the chunk computes their hops instead.
+     * Topologies without static routes (see has_static_routes) route the chunk afresh instead.
+     *
+     * @param src src NPU id
+     * @param dest dest NPU id
+     * @param chunk_size size of the chunk
+     * @param callback callback to be invoked when the chunk arrives dest
+     * @param callback_arg argument of the callback
+     */
+    void send(DeviceId src, DeviceId dest, ChunkSize chunk_size, Callback callback, CallbackArg callback_arg) noexcept;
+
+    /**
+     * Initiate a transmission of a chunk from src to dest.
+     * Same as above, with any callable as the callback.
+     *
+     * @param src src NPU id
+     * @param dest dest NPU id
+     * @param chunk_size size of the chunk
+     * @param callback callable to be invoked when the chunk arrives dest
+     */
+    void send(DeviceId src, DeviceId dest, ChunkSize chunk_size, EventCallback callback) noexcept;
+
+    /**
+     * Initiate a transmission of a chunk from src to dest, simulated in the given context
+     * rather than the one of the topology, e.g., to simulate the topology under several contexts at once.
+     * Same as above otherwise.
+     *
+     * @param context simulation context the chunk is simulated in
+     * @param src src NPU id
+     * @param dest dest NPU id
+     * @param chunk_size size of the chunk
+     * @param callback callable to be invoked when the chunk arrives dest
+     */
+    void send(SimulationContext& context,
+              DeviceId src,
+              DeviceId dest,
+              ChunkSize chunk_size,
+              EventCallback callback) noexcept;
+
+    /**
+     * Set the traffic class of the chunks the topology creates from now on,
+     * i.e., of those sent by send() from src to dest and of the messages sent by send_message()
+     * (see SimulationContext::set_link_scheduling()). Chunks given to send() keep their own class.
+     *
+     * @param traffic_class traffic class in [0, LinkStates::traffic_classes_count)
+     */
+    void set_traffic_class(int traffic_class) noexcept;
+
+    /**
+     * Get the traffic class of the chunks the topology creates.
+     *
+     * @return traffic class, 0 unless set otherwise
+     */
+    [[nodiscard]] int get_traffic_class() const noexcept;
+
+    /**
+     * Bound the buffers of the switches (the devices that aren't NPUs), per egress link (see Link::set_buffer_size()).
+     * Links feeding a switch stall while the egress buffer a chunk heads to is full,
+     * so an incast backs up into the links towards it, and switch queues take bounded memory.
+     * Stalls follow the routes, so routes shouldn't wait on each other in a cycle (e.g., up-down routing of trees).
+     * Links out of NPUs keep unbounded queues. Not supported by a ParallelSimulator.
+     *
+     * @param buffer_size size of each egress buffer in bytes, 0 for unbounded buffers
+     */
+    void set_switch_buffer_size(ChunkSize buffer_size) noexcept;
+
+    /**
+     * Get the size of the egress buffers of the switches.
+     *
+     * @return size of each egress buffer in bytes, 0 if unbounded
+     */
+    [[nodiscard]] ChunkSize get_switch_buffer_size() const noexcept;
+
+    /**
+     * Get the flattened route from src to dest.
+     * The route is computed through route() on first use and cached afterwards,
+     * so the returned reference stays valid for the lifetime of the topology.
+     * Explicit lookups are always cached, even past the cache capacity.
+     * The cache is not synchronized: in a parallel simulation,
+     * look up every route that callbacks may use before running.
+     *
+     * @param src src NPU id
+     * @param dest dest NPU id
+     * @return flattened route from src to dest
+     */
+    [[nodiscard]] const RouteHops& get_route_hops(DeviceId src, DeviceId dest) const noexcept;
+
+    /**
+     * Check whether route() always returns the same route for a given pair.
+     * Routes are not static for random or adaptive routing,
+     * in which case send() and send_message() route every chunk afresh instead of using the cache.
+     *
+     * @return true if routes are static, false otherwise
+     */
+    [[nodiscard]] bool has_static_routes() const noexcept;
+
+    /**
+     * Map a device by a symmetry of the topology: the automorphism moving NPU 0 to the given NPU.
+     * Topologies whose NPUs are all alike (e.g., Ring, FullyConnected, Switch) have one symmetry per NPU,
+     * acting on the NPUs as a rotation of their ids (of each dimension's address, for several dimensions),
+     * while switches may stay in place. SymmetricSimulation relies on them, and checks that routes follow them.
+     *
+     * @param device device to map
+     * @param npu NPU the symmetry moves NPU 0 to
+     * @return image of the device, -1 if the topology has no such symmetries
+     */
+    [[nodiscard]] virtual DeviceId map_by_symmetry(DeviceId device, DeviceId npu) const noexcept;
+
+    /**
+     * Set the seed random routing draws from (see CounterRng).
+     * Each random route draws from a stream keyed by (seed, src, dest, flow id),
+     * so a given seed gives the same routes in serial, parallel, and forked runs.
+     *
+     * @param seed seed of the random routes
+     */
+    virtual void set_routing_seed(uint64_t seed) noexcept;
+
+    /**
+     * Get the seed random routing draws from.
+     *
+     * @return seed of the random routes (0 unless set)
+     */
+    [[nodiscard]] uint64_t get_routing_seed() const noexcept;
+
+    /**
+     * Fill the route cache with the route of every NPU pair at once, across a pool of threads,
+     * so no chunk pays for routing afterwards: each send() is a cache lookup.
+     * Each thread routes whole sources into rows of its own, merged into the cache at the end,
+     * so the threads share nothing while routing. Precomputed routes are cached past the cache capacity.
+     * Does nothing for topologies without static routes (see has_static_routes).
+     *
+     * @param threads_count number of threads, 0 to use the hardware concurrency
+     */
+    virtual void precompute_routes(int threads_count = 0) noexcept;
+
+    /**
+     * Cap the memory of the route cache.
+     * Cached routes are interned for the lifetime of the topology and never evicted,
+     * so when the cache is full, send() and send_message() build the routes of new pairs
+     * without caching them (once per message for send_message()).
+     *
+     * @param capacity_bytes memory cap of the route cache in bytes, 0 for no cap
+     */
+    void set_route_cache_capacity(uint64_t capacity_bytes) noexcept;
+
+    /**
+     * Get the approximate memory held by the route cache.
+     *
+     * @return size of the route cache in bytes
+     */
+    [[nodiscard]] uint64_t get_route_cache_bytes() const noexcept;
+
+    /**
+     * Drop the lazily created links that are idle (see Device::release_idle_links()),
+     * e.g., between the phases of a sparse workload.
+     *
+     * @return number of links dropped
+     */
+    int release_idle_links() noexcept;
+
+    /**
+     * Get the number of links in memory: every eagerly connected link, and the lazy links used so far.
+     *
+     * @return number of links in memory
+     */
+    [[nodiscard]] uint64_t get_materialized_links_count() const noexcept;
+
+    /**
+     * Get the memory held by each part of the topology, by the event queue of its context, and by the chunk pool,
+     * as counted by the allocators of their containers rather than estimated from their sizes.
+     *
+     * @return memory per part
+     */
+    [[nodiscard]] virtual MemoryReport memory_report() const noexcept;
+
+    /**
+     * Fail the link between two devices, in both directions, at the current simulation time.
+     * Routes are updated around it: cached routes crossing it are recomputed in place,
+     * and chunks waiting for it (or reaching it later on their old route) are rerouted from where they are.
+     * A chunk already being transmitted over the link completes its hop.
+     * Exits the program if the topology can't route around failures.
+     *
+     * @param src device id of an end of the link
+     * @param dest device id of the other end of the link
+     */
+    void fail_link(DeviceId src, DeviceId dest) noexcept;
+
+    /**
+     * Restore a link failed by fail_link().
+     * Routes the link would shorten are recomputed.
+     *
+     * @param src device id of an end of the link
+     * @param dest device id of the other end of the link
+     */
+    void restore_link(DeviceId src, DeviceId dest) noexcept;
+
+    /**
+     * Fail a device at the current simulation time: no chunk enters it anymore,
+     * and routes are updated around it as for a failed link.
+     * Chunks already in the device leave it normally. Chunks destined to a failed device can't be delivered.
+     * Exits the program if the topology can't route around failures.
+     *
+     * @param id device id
+     */
+    void fail_device(DeviceId id) noexcept;
+
+    /**
+     * Restore a device failed by fail_device().
+     *
+     * @param id device id
+     */
+    void restore_device(DeviceId id) noexcept;
+
+    /**
+     * Check whether chunks can't be sent from src to dest directly,
+     * i.e., the link between them or dest has failed.
+     *
+     * @param src src device id
+     * @param dest dest device id
+     * @return true if the link is unusable, false otherwise
+     */
+    [[nodiscard]] bool is_link_failed(DeviceId src, DeviceId dest) const noexcept;
+
+    /**
+     * Check whether a device has failed.
+     *
+     * @param id device id
+     * @return true if the device has failed, false otherwise
+     */
+    [[nodiscard]] bool is_device_failed(DeviceId id) const noexcept;
+
+    /**
+     * Reroute a chunk that can't continue along its route, from its current device.
+     * Called by the links failed through this topology.
+     *
+     * @param chunk chunk to be rerouted
+     */
+    void reroute(std::unique_ptr<Chunk> chunk) noexcept;
+
+    /**
+     * Move a fast-path chunk back to the per-hop path, from the first link of its route it hasn't departed over yet,
+     * as another chunk reached that link first (see Link::reserve()).
+     * The chunk gives up the reservations of the links left, and arrives at the source of that link as scheduled.
+     *
+     * @param reserved_chunk fast-path chunk to resume, invalidated afterwards
+     */
+    static void resume_per_hop(ReservedChunk& reserved_chunk) noexcept;
+
+    /**
+     * Initiate the transmission of a number of chunks at once.
+     * Chunks are grouped by their source device (keeping their relative order),
+     * so chunks leaving the same device reach its links back-to-back.
+     * The events they schedule are deferred and inserted grouped by time (see EventQueue::defer_events()),
+     * so the event list of each distinct time is looked up once.
+     *
+     * The result is identical to calling send() for each chunk
+     * in the given order, per source device.
+     *
+     * @param chunks chunks to be transmitted
+     */
+    void send_batch(std::vector<std::unique_ptr<Chunk>> chunks) noexcept;
+
+    /**
+     * Initiate the transmission of a message from src to dest.
+     * The message is segmented into chunks of chunk_size bytes (the last one may be smaller),
+     * which all follow a single route computed once
+     * (or are routed one by one if the topology has no static routes).
+     * At most max_in_flight_chunks chunks are in the network at once;
+     * the next chunk is created and injected when one arrives at dest.
+     * The callback is invoked once, when the last chunk arrives.
+     *
+     * @param src src NPU id
+     * @param dest dest NPU id
+     * @param message_size size of the message in bytes
+     * @param chunk_size size of each chunk in bytes
+     * @param callback callback to be invoked when the whole message arrived
+     * @param callback_arg argument of the callback
+     * @param max_in_flight_chunks maximum number of chunks of the message in the network
+     */
+    void send_message(DeviceId src,
+                      DeviceId dest,
+                      ChunkSize message_size,
+                      ChunkSize chunk_size,
+                      Callback callback,
+                      CallbackArg callback_arg,
+                      int max_in_flight_chunks = 8) noexcept;
+
+    /**
+     * Initiate the transmission of a message from src to dest.
+     * Same as above, with any callable as the completion callback.
+     *
+     * @param src src NPU id
+     * @param dest dest NPU id
+     * @param message_size size of the message in bytes
+     * @param chunk_size size of each chunk in bytes
+     * @param callback callable to be invoked when the whole message arrived
+     * @param max_in_flight_chunks maximum number of chunks of the message in the network
+     */
+    void send_message(DeviceId src,
+                      DeviceId dest,
+                      ChunkSize message_size,
+                      ChunkSize chunk_size,
+                      EventCallback callback,
+                      int max_in_flight_chunks = 8) noexcept;
+
+    /**
+     * Save a snapshot of the constructed topology (devices, links, and the route of every NPU pair)
+     * to a flat binary file, which load_snapshot() maps back without constructing the topology again.
+     * Only topologies with static routes can be saved.
+     *
+     * @param path path of the snapshot file
+     * @param key key identifying the network the topology was constructed from
+     * @return true if the file has been written, false otherwise
+     */
+    [[nodiscard]] bool save_snapshot(const std::string& path, uint64_t key = 0) const noexcept;
+
+    /**
+     * Load a topology saved by save_snapshot().
+     * The loaded topology starts in the default simulation context.
+     *
+     * @param path path of the snapshot file
+     * @param key key identifying the network the topology should have been constructed from
+     * @return loaded topology, nullptr if the file is missing, corrupted, of another version, or saved with another key
+     */
+    [[nodiscard]] static std::shared_ptr<Topology> load_snapshot(const std::string& path, uint64_t key = 0) noexcept;
+
+    /**
+     * Write the statistics as CSV lines:
+     *  - "memory,<part>,<bytes>,<peak bytes>" for each part of memory_report() and their total,
+     *  - "event_queue,<events>,<event times>,<max events per time>" for the event queue,
+     *  - "callback,<type id>,<events>" for each kind of invoked callback,
+     *  - "link,<src>,<dest>,<bytes>,<chunks>,<busy ns>,<utilization>,<max queue depth>,<queueing delay histogram>"
+     *    for each link that transmitted, the histogram buckets being space-separated (see LinkStats).
+     * Memory is always written; the other counters are only compiled in with the ASTRA_NET_STATS CMake option.
+     *
+     * @param out stream to write to
+     * @return true if the hot-path counters are written, false if compiled without ASTRA_NET_STATS (only memory is)
+     */
+    [[nodiscard]] bool dump_stats(std::ostream& out) const noexcept;
+
     /**
      * Get the number of NPUs in the topology.
      * NPU excludes non-NPU devices such as switches.
@@ -92,6 +512,15 @@ class Topology {
 
 
     [[nodiscard]] std::vector<DeviceId> get_all_device_ids() const noexcept;
+
+    /**
+     * Get the device instance with the given id.
+     *
+     * @param id id of the device
+     * @return pointer to the device
+     */
+    [[nodiscard]] std::shared_ptr<Device> get_device(DeviceId id) const noexcept;
+
   protected:
     /// number of total devices in the topology
     /// device includes non-NPU devices such as switches
@@ -107,12 +536,134 @@ class Topology {
     /// number of NPUs per each dimension
     std::vector<int> npus_count_per_dim;
 
+    /// seed of the random routes
+    uint64_t routing_seed;
+
+    /// memory held by the devices and their port tables
+    std::shared_ptr<MemoryCounter> devices_memory;
+
+    /// memory held by the links
+    std::shared_ptr<MemoryCounter> links_memory;
+
+    /// memory held by the pending chunks queues of the links
+    std::shared_ptr<MemoryCounter> pending_chunks_memory;
+
+    /// ids of the links, indexing their state in each context
+    std::shared_ptr<LinkStates::LinkIds> link_ids;
+
+    /// memory held by route_hops_cache and retired_route_hops
+    std::shared_ptr<MemoryCounter> route_cache_memory;
+
     /// holds the entire device instances in the topology
     std::vector<std::shared_ptr<Device>> devices;
 
     /// bandwidth per each network dimension
     std::vector<Bandwidth> bandwidth_per_dim;
 
+    /// simulation context of the links of the topology
+    std::shared_ptr<SimulationContext> context;
+
+    /// map[(src, dest)] -> flattened route
+    using RouteHopsCache = std::unordered_map<uint64_t,
+                                              RouteHops,
+                                              std::hash<uint64_t>,
+                                              std::equal_to<uint64_t>,
+                                              TrackingAllocator<std::pair<const uint64_t, RouteHops>>>;
+
+    /// map[(src, dest)] -> flattened route, filled by get_route_hops
+    mutable RouteHopsCache route_hops_cache;
+
+    /// whether route() always returns the same route for a given pair
+    bool static_routes;
+
+    /// (src << 32) | dest of each failed link, in both directions
+    std::unordered_set<uint64_t> failed_links;
+
+    /// failed devices
+    std::unordered_set<DeviceId> failed_devices;
+
+    /// keys of the cached routes computed while some element was failed, recomputed as elements are restored
+    mutable std::unordered_set<uint64_t> failure_route_keys;
+
+    /// cached routes replaced by their recomputation while chunks were in flight, kept alive for them
+    /// until the event queue drains or the topology is reset
+    TrackedVector<RouteHops> retired_route_hops;
+
+    /// fully connected groups of at least this many devices are connected lazily (see Device::connect_lazily())
+    static constexpr int lazy_links_min_count = 64;
+
+    /// memory cap of route_hops_cache in bytes, 0 for no cap
+    uint64_t route_hops_cache_capacity;
+
+    /// approximate memory held by route_hops_cache in bytes
+    mutable uint64_t route_hops_cache_bytes;
+
+    /// traffic class of the chunks the topology creates
+    int traffic_class;
+
+    /// size of the egress buffers of the switches in bytes, 0 if unbounded
+    ChunkSize switch_buffer_size;
+
+    /**
+     * Look up the cached route from src to dest, caching it if the capacity allows.
+     *
+     * @param src src NPU id
+     * @param dest dest NPU id
+     * @return flattened route from src to dest, nullptr if it's not cached and the cache is full
+     */
+    [[nodiscard]] const RouteHops* find_route_hops(DeviceId src, DeviceId dest) const noexcept;
+
+    /**
+     * Create a chunk from src to dest, on its cached route when possible (see send()).
+     *
+     * @param src src NPU id
+     * @param dest dest NPU id
+     * @param chunk_size size of the chunk
+     * @param callback callable to be invoked when the chunk arrives dest
+     * @return chunk at src
+     */
+    [[nodiscard]] std::unique_ptr<Chunk> make_chunk(DeviceId src,
+                                                    DeviceId dest,
+                                                    ChunkSize chunk_size,
+                                                    EventCallback callback) noexcept;
+
+    /**
+     * Get the simulation context a chunk is simulated in,
+     * giving the context of the topology to a chunk sent without one.
+     *
+     * @param chunk chunk being sent
+     * @return simulation context of the chunk
+     */
+    [[nodiscard]] SimulationContext& bind_simulation_context(Chunk& chunk) const noexcept;
+
+    /**
+     * Update the routing of the topology after a link or a device failed or got restored.
+     * Afterwards, route() and route_around_failures() avoid every failed element.
+     * Topologies that can't route around failures don't override it.
+     *
+     * @param src device id of an end of the link, or of the device
+     * @param dest device id of the other end of the link, -1 for a device
+     * @param failed true if the element failed, false if it got restored
+     * @return true if the routing got updated, false if failures aren't supported
+     */
+    [[nodiscard]] virtual bool update_failures(DeviceId src, DeviceId dest, bool failed) noexcept;
+
+    /**
+     * Construct a route avoiding the failed elements from any device, e.g., from where a chunk got stuck.
+     *
+     * @param src device id to start from, possibly a non-NPU or failed device
+     * @param dest dest NPU id
+     * @return route from src to dest, empty if there's none
+     */
+    [[nodiscard]] virtual Route route_around_failures(DeviceId src, DeviceId dest) const noexcept;
+
+    /**
+     * Propagate the failure or restoration of a link or a device:
+     * update the routing, flag the affected links, recompute the affected cached routes,
+     * and reroute the chunks waiting for a newly failed link.
+     */
+    void apply_failure_change(DeviceId src, DeviceId dest, bool failed) noexcept;
+
     /**
      * Instantiate Device objects in the topology.
      */
@@ -131,6 +682,38 @@ class Topology {
      * @param bidirectional true if connection is bidirectional, false otherwise
      */
     void connect(DeviceId src, DeviceId dest, Bandwidth bandwidth, Latency latency, bool bidirectional = true) noexcept;
+
+    /**
+     * Get the backlog of the src -> dest link,
+     * i.e., the number of bytes waiting to be transmitted on it.
+     *
+     * @param src src device id
+     * @param dest dest device id
+     * @return pending bytes of the link
+     */
+    [[nodiscard]] ChunkSize get_link_backlog(DeviceId src, DeviceId dest) const noexcept;
+
+    /**
+     * Deliver a chunk on the hybrid-fidelity fast path (see SimulationContext::set_hybrid_fidelity())
+     * if every link of its route can be reserved and no chunk is in flight on the per-hop path:
+     * reserve them hop by hop, and schedule a single event at the arrival time.
+     * Otherwise, the chunk is counted as a per-hop chunk of the context until it completes.
+     *
+     * @param chunk chunk to be transmitted, taken only if the fast path is used
+     * @return true if the chunk took the fast path, false if it should be sent as usual
+     */
+    [[nodiscard]] bool send_uncontended(std::unique_ptr<Chunk>& chunk) noexcept;
+
+    /**
+     * Let go of the reservations of a fast-path chunk (see Link::release_reservation()),
+     * recording the links it crossed in the trace.
+     *
+     * @param reserved_chunk fast-path chunk
+     * @param served_links_count number of links of the route the chunk crossed on the fast path, the others cancelled
+     * @return timing of the chunk over the last link it crossed
+     */
+    static Link::Transmission release_reservations(const ReservedChunk& reserved_chunk,
+                                                   size_t served_links_count) noexcept;
 };
 
 }  // namespace NetworkAnalyticalCongestionAware
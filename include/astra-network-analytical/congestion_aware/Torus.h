@@ -0,0 +1,82 @@
+/******************************************************************************
+This source code is licensed under the MIT license found in the
+LICENSE file in the root directory of this source tree.
+*******************************************************************************/
+
+#pragma once
+
+#include "common/Type.h"
+#include "congestion_aware/BasicTopology.h"
+#include <vector>
+
+using namespace NetworkAnalytical;
+
+namespace NetworkAnalyticalCongestionAware {
+
+/**
+ * Implements a multi-dimensional torus topology.
+ *
+ * Torus([4, 2]) example:
+ * 0 - 1 - 2 - 3
+ * |   |   |   |
+ * 4 - 5 - 6 - 7
+ *
+ * with each row also wrapping around (3 - 0, 7 - 4),
+ * so the number of NPUs and devices are both 8.
+ * NPU ids follow the shape with dimension 0 varying fastest,
+ * i.e., the address of an NPU in dimension d is (id / stride[d]) % shape[d].
+ *
+ * Every dimension is a ring: routes traverse the dimensions in order (dimension-order routing),
+ * taking the shorter direction around each ring when bidirectional.
+ * Each hop is a fixed id stride away, so routes are built arithmetically
+ * without per-slice topologies or address translation.
+ */
+class Torus final : public BasicTopology {
+  public:
+    /**
+     * Constructor.
+     *
+     * @param shape number of NPUs of each dimension
+     * @param bandwidth bandwidth of each link
+     * @param latency latency of each link
+     * @param bidirectional true if every ring is bidirectional, false otherwise
+     */
+    Torus(const std::vector<int>& shape, Bandwidth bandwidth, Latency latency, bool bidirectional = true) noexcept;
+
+    /**
+     * Implementation of route function in Topology.
+     */
+    [[nodiscard]] Route route(DeviceId src, DeviceId dest) const noexcept override;
+
+    /**
+     * Clone this topology instance.
+     */
+    [[nodiscard]] std::unique_ptr<BasicTopology> clone() const noexcept override;
+
+    /**
+     * Get the number of NPUs of each dimension.
+     *
+     * @return shape of the torus
+     */
+    [[nodiscard]] const std::vector<int>& get_shape() const noexcept;
+
+  private:
+    /// number of NPUs of each dimension
+    std::vector<int> shape;
+
+    /// id difference between neighbors of each dimension
+    std::vector<int> strides;
+
+    /// true if every ring is bidirectional, false otherwise
+    bool bidirectional;
+
+    /**
+     * Compute the number of NPUs of a shape.
+     *
+     * @param shape number of NPUs of each dimension
+     * @return number of NPUs
+     */
+    [[nodiscard]] static int compute_npus_count(const std::vector<int>& shape) noexcept;
+};
+
+}  // namespace NetworkAnalyticalCongestionAware
@@ -0,0 +1,133 @@
+/******************************************************************************
+This source code is licensed under the MIT license found in the
+LICENSE file in the root directory of this source tree.
+*******************************************************************************/
+
+#pragma once
+
+#include "common/TraceFile.h"
+#include "common/Type.h"
+#include "congestion_aware/Topology.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace NetworkAnalytical;
+
+namespace NetworkAnalyticalCongestionAware {
+
+/**
+ * TraceReplay streams the transfers of a trace file (see TraceReader) into a topology.
+ *
+ * Records are read into a lookahead window of fixed size, a ring indexed by record index.
+ * A record is issued once its issue time has come and the records it depends on completed,
+ * and the window slides past records as the oldest ones complete,
+ * so memory scales with the window (i.e., the transfers in flight), not with the trace length.
+ * Records older than the window have completed, so dependencies on them are already met.
+ */
+class TraceReplay {
+  public:
+    /**
+     * Constructor.
+     *
+     * @param topology topology to replay the trace on
+     * @param path path of the trace file
+     * @param chunk_size size of the chunks transfers are segmented into
+     * @param window_size maximum number of records in the window
+     */
+    TraceReplay(std::shared_ptr<Topology> topology,
+                const std::string& path,
+                ChunkSize chunk_size,
+                int window_size = 4096) noexcept;
+
+    /**
+     * Replay the whole trace, running the event queue of the topology's simulation context.
+     *
+     * @return time when the last transfer completed
+     */
+    [[nodiscard]] EventTime run() noexcept;
+
+    /**
+     * Get the number of transfers completed so far.
+     *
+     * @return number of completed transfers
+     */
+    [[nodiscard]] uint64_t get_completed_count() const noexcept;
+
+  private:
+    /// a record in the window
+    struct Entry {
+        /// the record
+        TraceRecord record;
+
+        /// number of dependencies not completed yet
+        int remaining_dependencies;
+
+        /// indices of the records in the window waiting for this one
+        std::vector<uint64_t> dependents;
+
+        /// whether the transfer completed
+        bool completed;
+    };
+
+    /// topology to replay the trace on
+    std::shared_ptr<Topology> topology;
+
+    /// trace being replayed
+    TraceReader reader;
+
+    /// size of the chunks transfers are segmented into
+    ChunkSize chunk_size;
+
+    /// window[index % window.size()] -> record of the given index
+    std::vector<Entry> window;
+
+    /// index of the oldest record in the window
+    uint64_t window_begin;
+
+    /// index of the next record to read
+    uint64_t window_end;
+
+    /// number of transfers completed so far
+    uint64_t completed_count;
+
+    /// time when the last transfer completed
+    EventTime finish_time;
+
+    /**
+     * Get the window entry of a record.
+     *
+     * @param index index of the record
+     * @return entry of the record
+     */
+    [[nodiscard]] Entry& get_entry(uint64_t index) noexcept;
+
+    /**
+     * Read records into the free slots of the window.
+     */
+    void fill_window() noexcept;
+
+    /**
+     * Issue a record at its issue time, its dependencies being met.
+     *
+     * @param index index of the record
+     */
+    void release(uint64_t index) noexcept;
+
+    /**
+     * Send the transfer of a record.
+     *
+     * @param index index of the record
+     */
+    void issue(uint64_t index) noexcept;
+
+    /**
+     * Handle the completion of a transfer.
+     *
+     * @param index index of the record
+     */
+    void complete(uint64_t index) noexcept;
+};
+
+}  // namespace NetworkAnalyticalCongestionAware
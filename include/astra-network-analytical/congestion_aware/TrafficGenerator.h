@@ -0,0 +1,162 @@
+/******************************************************************************
+This source code is licensed under the MIT license found in the
+LICENSE file in the root directory of this source tree.
+*******************************************************************************/
+
+#pragma once
+
+#include "common/Type.h"
+#include "congestion_aware/Topology.h"
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace NetworkAnalytical;
+
+namespace NetworkAnalyticalCongestionAware {
+
+/**
+ * TrafficGenerator injects synthetic traffic into a topology, chunk by chunk through Topology::send().
+ *
+ * Every NPU injects its chunks at a fixed rate, each to a destination drawn from the pattern.
+ * Destinations are drawn from a seeded generator, so runs are reproducible.
+ * Patterns that leave an NPU's chunk local (the destination being the source) send nothing for it.
+ */
+class TrafficGenerator {
+  public:
+    /// traffic pattern
+    enum class Pattern {
+        UniformRandom,      // any other NPU, uniformly
+        RandomPermutation,  // a fixed random permutation of the NPUs
+        BitComplement,      // NPU with every bit of the id flipped, power-of-2 NPUs
+        Transpose,          // (row, column) to (column, row), square number of NPUs
+        Hotspot,            // the hotspot NPU with the hotspot fraction, uniformly otherwise
+        MoeAllToAll         // experts (one per NPU) drawn with Zipf popularity
+    };
+
+    /**
+     * Constructor.
+     *
+     * @param topology topology to inject the traffic into
+     * @param pattern traffic pattern
+     * @param chunk_size size of each chunk
+     * @param seed seed of the destination generator
+     */
+    TrafficGenerator(std::shared_ptr<Topology> topology,
+                     Pattern pattern,
+                     ChunkSize chunk_size,
+                     uint64_t seed = 0) noexcept;
+
+    /**
+     * Set the injection rate of every NPU.
+     * With a rate of 0 (the default), every chunk is injected at once.
+     *
+     * @param injection_rate bytes injected per ns by each NPU (i.e., GB/s)
+     */
+    void set_injection_rate(Bandwidth injection_rate) noexcept;
+
+    /**
+     * Set the hotspot of the Hotspot pattern.
+     *
+     * @param hotspot_npu NPU receiving the hotspot traffic
+     * @param hotspot_fraction fraction of the chunks sent to the hotspot
+     */
+    void set_hotspot(DeviceId hotspot_npu, double hotspot_fraction) noexcept;
+
+    /**
+     * Set the skew of the expert popularity of the MoeAllToAll pattern:
+     * the expert of popularity rank r is drawn with probability proportional to 1 / r^zipf_exponent.
+     * Experts are ranked by a random permutation of the NPUs. 0 (the default) draws experts uniformly.
+     *
+     * @param zipf_exponent Zipf exponent, 0 or more
+     */
+    void set_zipf_exponent(double zipf_exponent) noexcept;
+
+    /**
+     * Draw the destination of the next chunk of an NPU.
+     *
+     * @param src src NPU id
+     * @return dest NPU id, src if the chunk stays local
+     */
+    [[nodiscard]] DeviceId get_destination(DeviceId src) noexcept;
+
+    /**
+     * Inject chunks from every NPU, starting at the current time, and run the event queue
+     * of the topology's simulation context until every chunk arrived.
+     *
+     * @param chunks_per_npu number of chunks each NPU injects
+     * @return time when the last chunk arrived
+     */
+    [[nodiscard]] EventTime run(int chunks_per_npu) noexcept;
+
+    /**
+     * Get the number of chunks sent by the last run, local ones excluded.
+     *
+     * @return number of chunks sent
+     */
+    [[nodiscard]] uint64_t get_sent_chunks_count() const noexcept;
+
+  private:
+    /// topology to inject the traffic into
+    std::shared_ptr<Topology> topology;
+
+    /// number of NPUs of the topology
+    int npus_count;
+
+    /// traffic pattern
+    Pattern pattern;
+
+    /// size of each chunk
+    ChunkSize chunk_size;
+
+    /// destination generator
+    std::mt19937_64 generator;
+
+    /// bytes injected per ns by each NPU, 0 to inject at once
+    Bandwidth injection_rate;
+
+    /// NPU receiving the hotspot traffic
+    DeviceId hotspot_npu;
+
+    /// fraction of the chunks sent to the hotspot
+    double hotspot_fraction;
+
+    /// permutation[src] -> dest of the RandomPermutation pattern
+    std::vector<DeviceId> permutation;
+
+    /// experts_by_rank[r] -> NPU of the expert of popularity rank r
+    std::vector<DeviceId> experts_by_rank;
+
+    /// expert_cdf[r] -> probability of drawing an expert of rank r or less
+    std::vector<double> expert_cdf;
+
+    /// chunks each NPU still has to inject in the current run
+    std::vector<int> remaining_chunks;
+
+    /// number of chunks sent in the current run
+    uint64_t sent_chunks_count;
+
+    /// number of chunks arrived in the current run
+    uint64_t arrived_chunks_count;
+
+    /// time when the last chunk arrived
+    EventTime finish_time;
+
+    /**
+     * Draw an NPU other than src, uniformly.
+     *
+     * @param src src NPU id
+     * @return dest NPU id
+     */
+    [[nodiscard]] DeviceId get_uniform_destination(DeviceId src) noexcept;
+
+    /**
+     * Inject the next chunk of an NPU, and schedule the following one.
+     *
+     * @param npu NPU id
+     */
+    void inject(DeviceId npu) noexcept;
+};
+
+}  // namespace NetworkAnalyticalCongestionAware
@@ -5,8 +5,11 @@ LICENSE file in the root directory of this source tree.
 
 #pragma once
 
+#include "common/MemoryCounter.h"
+#include "common/Type.h"
 #include <list>
 #include <memory>
+#include <vector>
 
 namespace NetworkAnalyticalCongestionAware {
 
@@ -18,4 +21,45 @@ class Device;
 /// Route is a list of devices
 using Route = std::list<std::shared_ptr<Device>>;
 
+/// Port index of a link, local to its source device
+using PortId = int;
+
+/// A device on a flattened route, with the port leading to the next device on the route
+struct RouteHop {
+    /// device of the hop
+    Device* device;
+
+    /// port of the device towards the next hop (-1 for the destination)
+    PortId port;
+};
+
+/// Flattened route: [src hop, ..., dest hop]
+/// (cached routes count their storage in the memory of the route cache, see Topology::memory_report)
+using RouteHops = NetworkAnalytical::TrackedVector<RouteHop>;
+
+/// Route computed hop by hop instead of being stored (see Topology::describe_route):
+/// hop i is NPU (src + i * step) mod modulus, or [src, via, dest] through a single intermediate device
+struct RouteDescriptor {
+    /// devices of the topology, indexed by id
+    const std::shared_ptr<Device>* devices;
+
+    /// src NPU id
+    NetworkAnalytical::DeviceId src;
+
+    /// dest NPU id
+    NetworkAnalytical::DeviceId dest;
+
+    /// intermediate device between src and dest, -1 if none
+    NetworkAnalytical::DeviceId via;
+
+    /// id difference between consecutive hops (without via)
+    int step;
+
+    /// number of ids hops wrap around at (without via)
+    int modulus;
+
+    /// number of hops, including the src and dest devices
+    int hops_count;
+};
+
 }  // namespace NetworkAnalyticalCongestionAware
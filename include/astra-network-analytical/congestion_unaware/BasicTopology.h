@@ -7,6 +7,7 @@ LICENSE file in the root directory of this source tree.
 
 #include "common/Type.h"
 #include "congestion_unaware/Topology.h"
+#include <vector>
 
 using namespace NetworkAnalytical;
 
@@ -38,6 +39,26 @@ class BasicTopology : public Topology {
      */
     [[nodiscard]] EventTime send(DeviceId src, DeviceId dest, ChunkSize chunk_size) const noexcept override;
 
+    /**
+     * Implement the send_batch method of Topology.
+     */
+    void send_batch(const DeviceId* srcs,
+                    const DeviceId* dests,
+                    const ChunkSize* chunk_sizes,
+                    EventTime* delays,
+                    size_t count) const noexcept override;
+
+    /**
+     * Implement the collective_time method of Topology.
+     * Ring runs (npus_count - 1) steps around the NPUs in id order,
+     * Direct exchanges with every NPU in a single step,
+     * and HalvingDoubling exchanges with NPU (id ^ npus_count / 2^k) at step k,
+     * which needs a power-of-two npus_count.
+     */
+    [[nodiscard]] EventTime collective_time(CollectiveType collective_type,
+                                            ChunkSize bytes,
+                                            CollectiveAlgorithm algorithm) const noexcept override;
+
     /**
      * Return the type of the basic topology
      * as a TopologyBuildingBlock enum class element.
@@ -46,6 +67,31 @@ class BasicTopology : public Topology {
      */
     [[nodiscard]] TopologyBuildingBlock get_basic_topology_type() const noexcept;
 
+    /**
+     * Get the latency of each link.
+     *
+     * @return latency of each link in ns
+     */
+    [[nodiscard]] Latency get_latency() const noexcept;
+
+    /**
+     * Get the number of links of the topology, identified by ids in [0, links count).
+     *
+     * @return number of links, 0 if the topology doesn't model its links
+     */
+    [[nodiscard]] virtual int get_links_count() const noexcept;
+
+    /**
+     * Append the ids of the links a chunk from src to dest goes through, in order,
+     * one per hop of compute_hops_count(). Used to spread traffic over the links (see ContentionEstimator).
+     *
+     * @param src src NPU ID
+     * @param dest dest NPU ID
+     * @param links link ids to append to
+     * @return false if the topology doesn't model its links
+     */
+    virtual bool append_route_links(DeviceId src, DeviceId dest, std::vector<int>& links) const noexcept;
+
   protected:
     /**
      * Compute the number of hops between src and dest.
@@ -56,10 +102,28 @@ class BasicTopology : public Topology {
      */
     [[nodiscard]] virtual int compute_hops_count(DeviceId src, DeviceId dest) const noexcept = 0;
 
+    /**
+     * Compute the number of hops of a batch of (src, dest) pairs.
+     * Defaults to compute_hops_count() on each pair;
+     * topologies with a closed form override it with a loop the compiler can vectorize.
+     *
+     * @param srcs src NPU ID of each pair
+     * @param dests dest NPU ID of each pair
+     * @param hops_counts number of hops of each pair, written by the call
+     * @param count number of pairs
+     */
+    virtual void compute_hops_counts(const DeviceId* srcs,
+                                     const DeviceId* dests,
+                                     int* hops_counts,
+                                     size_t count) const noexcept;
+
     /// type of the basic topology
     TopologyBuildingBlock basic_topology_type;
 
   private:
+    /// number of chunks whose hops are computed at once by send_batch
+    static constexpr size_t batch_block_size = 256;
+
     /**
      * Analytically compute the communication delay.
      *
@@ -69,6 +133,25 @@ class BasicTopology : public Topology {
      */
     [[nodiscard]] EventTime compute_communication_delay(int hops_count, ChunkSize chunk_size) const noexcept;
 
+    /**
+     * Compute the time of a collective step, where each NPU i sends bytes to NPU partner(i).
+     *
+     * @param hops_count largest number of hops between an NPU and its partner
+     * @param bytes bytes sent by each NPU
+     * @return time taken by the step
+     */
+    [[nodiscard]] double compute_step_time(int hops_count, double bytes) const noexcept;
+
+    /**
+     * Compute the largest number of hops of a batch of (src, dest) pairs.
+     *
+     * @param srcs src NPU ID of each pair
+     * @param dests dest NPU ID of each pair
+     * @return largest number of hops
+     */
+    [[nodiscard]] int compute_max_hops_count(const std::vector<DeviceId>& srcs,
+                                             const std::vector<DeviceId>& dests) const noexcept;
+
     /// bandwidth of each link in GB/s
     Bandwidth bandwidth;
 
@@ -0,0 +1,164 @@
+/******************************************************************************
+This source code is licensed under the MIT license found in the
+LICENSE file in the root directory of this source tree.
+*******************************************************************************/
+
+#pragma once
+
+#include "common/Type.h"
+#include "congestion_unaware/BasicTopology.h"
+#include <deque>
+#include <memory>
+#include <vector>
+
+using namespace NetworkAnalytical;
+
+namespace NetworkAnalyticalCongestionUnaware {
+
+/**
+ * ContentionEstimator adds a contention term to the delays of a basic topology, at analytical cost.
+ *
+ * Traffic is spread over the links of its routes (see BasicTopology::append_route_links()),
+ * giving each link an offered load: the bytes crossing it per window over what it can carry in a window.
+ * Traffic is either declared per phase as a traffic matrix (see set_traffic()),
+ * or accumulated from the sends of the last window (see record_send()), or both.
+ * Only the links of the pairs whose traffic changes are updated.
+ *
+ * A chunk takes the delay of BasicTopology::send(), plus the queueing delay of its route:
+ *   - FairShare: the chunk gets a fair share of its most loaded link,
+ *     so its serialization is stretched by the load of that link once past 1,
+ *   - MD1: each link of the route is an M/D/1 queue serving chunks of this size,
+ *     adding a wait of (load / (2 * (1 - load))) serializations. Loads are taken at most at saturated_load,
+ *     and the part past 1 stretches the serialization as with FairShare.
+ */
+class ContentionEstimator {
+  public:
+    /// queueing model of the links
+    enum class QueueModel { FairShare, MD1 };
+
+    /// load M/D/1 waits are computed at, at most
+    static constexpr double saturated_load = 0.99;
+
+    /**
+     * Constructor.
+     *
+     * @param topology topology to estimate the delays of, modelling its links
+     * @param window duration the traffic is offered over, in ns
+     * @param queue_model queueing model of the links
+     */
+    ContentionEstimator(std::shared_ptr<BasicTopology> topology,
+                        EventTime window,
+                        QueueModel queue_model = QueueModel::FairShare) noexcept;
+
+    /**
+     * Declare the bytes src sends to dest over a window, replacing the ones declared before.
+     *
+     * @param src src NPU ID
+     * @param dest dest NPU ID
+     * @param bytes bytes sent over a window, 0 to remove the pair
+     */
+    void set_traffic(DeviceId src, DeviceId dest, ChunkSize bytes) noexcept;
+
+    /**
+     * Declare the traffic of a phase at once, updating the pairs whose bytes changed.
+     *
+     * @param traffic_matrix bytes sent over a window, indexed by (src * npus_count + dest)
+     */
+    void set_traffic_matrix(const std::vector<ChunkSize>& traffic_matrix) noexcept;
+
+    /**
+     * Remove every declared and recorded traffic.
+     */
+    void clear_traffic() noexcept;
+
+    /**
+     * Estimate the time to send a chunk under the current loads.
+     *
+     * @param src src NPU ID
+     * @param dest dest NPU ID
+     * @param chunk_size size of the chunk
+     * @return time to send the chunk from src to dest
+     */
+    [[nodiscard]] EventTime send(DeviceId src, DeviceId dest, ChunkSize chunk_size) const noexcept;
+
+    /**
+     * Record a chunk sent at the given time into the accumulated traffic, then estimate its time.
+     * Recorded chunks older than a window are dropped first, so times should not decrease.
+     *
+     * @param src src NPU ID
+     * @param dest dest NPU ID
+     * @param chunk_size size of the chunk
+     * @param current_time time the chunk is sent at
+     * @return time to send the chunk from src to dest
+     */
+    EventTime record_send(DeviceId src, DeviceId dest, ChunkSize chunk_size, EventTime current_time) noexcept;
+
+    /**
+     * Get the offered load of a link.
+     *
+     * @param link link id
+     * @return bytes offered to the link per window over the bytes it carries per window
+     */
+    [[nodiscard]] double get_link_load(int link) const noexcept;
+
+    /**
+     * Get the load of the most loaded link of a route.
+     *
+     * @param src src NPU ID
+     * @param dest dest NPU ID
+     * @return largest offered load along the route
+     */
+    [[nodiscard]] double get_route_load(DeviceId src, DeviceId dest) const noexcept;
+
+  private:
+    /// chunk recorded by record_send()
+    struct RecordedSend {
+        /// time the chunk was sent at
+        EventTime time;
+
+        /// src NPU ID
+        DeviceId src;
+
+        /// dest NPU ID
+        DeviceId dest;
+
+        /// size of the chunk
+        ChunkSize chunk_size;
+    };
+
+    /// topology to estimate the delays of
+    std::shared_ptr<BasicTopology> topology;
+
+    /// duration the traffic is offered over, in ns
+    EventTime window;
+
+    /// queueing model of the links
+    QueueModel queue_model;
+
+    /// bandwidth of each link in B/ns
+    Bandwidth bandwidth_Bpns;
+
+    /// bytes offered to each link per window
+    std::vector<double> link_bytes;
+
+    /// declared bytes per window, indexed by (src * npus_count + dest)
+    std::vector<ChunkSize> declared_traffic;
+
+    /// chunks recorded over the last window, oldest first
+    std::deque<RecordedSend> recorded_sends;
+
+    /// links of the route being looked at
+    mutable std::vector<int> route_links;
+
+    /**
+     * Add bytes to the links of a route (or remove them, if negative).
+     */
+    void add_route_bytes(DeviceId src, DeviceId dest, double bytes) noexcept;
+
+    /**
+     * Collect the links of a route into route_links.
+     */
+    void collect_route_links(DeviceId src, DeviceId dest) const noexcept;
+};
+
+}  // namespace NetworkAnalyticalCongestionUnaware
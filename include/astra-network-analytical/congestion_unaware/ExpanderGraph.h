@@ -10,6 +10,8 @@ LICENSE file in the root directory of this source tree.
 #include <set>
 #include <string>
 
+#include "common/CsrGraph.h"
+#include "common/DistanceMatrix.h"
 #include "common/Type.h"
 #include "congestion_unaware/BasicTopology.h"
 
@@ -33,20 +35,57 @@ class ExpanderGraph final : public BasicTopology {
      * @param degree degree of the expander graph (unused if inputfile provided)
      * @param bandwidth bandwidth of each link
      * @param latency latency of each link
-     * @param inputfile path to JSON file defining the expander graph topology
+     * @param inputfile path to the JSON or binary edge-list file defining the expander graph topology (see ExpanderGraphFile)
      */
     ExpanderGraph(int npus_count, unsigned int degree, Bandwidth bandwidth, Latency latency, const std::string& inputfile = std::string()) noexcept;
     unsigned int get_distance(const DeviceId src, const DeviceId dest, std::set<DeviceId> visited, unsigned int current_distance) const noexcept;
     std::map<DeviceId, std::vector<DeviceId>> adjacency_list;
+
+    /**
+     * Get the graph of the topology, built once at construction.
+     *
+     * @return graph in CSR form
+     */
+    [[nodiscard]] const CsrGraph& get_graph() const noexcept;
+
+    /**
+     * Implements the get_links_count method of BasicTopology.
+     * Links are the directed edges of the graph, identified by their position in it (see CsrGraph).
+     */
+    [[nodiscard]] int get_links_count() const noexcept override;
+
+    /**
+     * Implements the append_route_links method of BasicTopology.
+     * Follows a shortest path, taking the first neighbor one hop closer to dest at each step.
+     */
+    bool append_route_links(DeviceId src, DeviceId dest, std::vector<int>& links) const noexcept override;
   private:
     /**
      * Implements the compute_hops_count method of BasicTopology.
      */
     [[nodiscard]] int compute_hops_count(DeviceId src, DeviceId dest) const noexcept override;
-    void connect(DeviceId src, DeviceId dest);
 
-    // distance cache to speed up distance calculations
-    mutable std::map<std::pair<DeviceId, DeviceId>, unsigned int> distance_cache;
+    /**
+     * Implements the compute_hops_counts method of BasicTopology.
+     */
+    void compute_hops_counts(const DeviceId* srcs,
+                             const DeviceId* dests,
+                             int* hops_counts,
+                             size_t count) const noexcept override;
+
+    /**
+     * Map the hop counts of every pair from a file, or compute and save them there if it's missing or stale.
+     *
+     * @param path path of the file
+     * @param inputfile_contents contents of the graph file, which key the hop counts
+     */
+    void load_distance_matrix(const std::string& path, const std::string& inputfile_contents) noexcept;
+
+    // adjacency_list in CSR form, used by every search
+    CsrGraph graph;
+
+    // distances between every pair of devices, mapped from or saved to a file aside the graph
+    DistanceMatrix distance_matrix;
 };
 
 }  // namespace NetworkAnalyticalCongestionUnaware
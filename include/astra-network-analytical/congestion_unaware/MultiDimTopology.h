@@ -30,6 +30,27 @@ class MultiDimTopology : public Topology {
      */
     [[nodiscard]] EventTime send(DeviceId src, DeviceId dest, ChunkSize chunk_size) const noexcept override;
 
+    /**
+     * Implement the send_batch method of Topology.
+     * Chunks are grouped by the dimension they're sent over,
+     * and each group goes through the send_batch of its dimension.
+     */
+    void send_batch(const DeviceId* srcs,
+                    const DeviceId* dests,
+                    const ChunkSize* chunk_sizes,
+                    EventTime* delays,
+                    size_t count) const noexcept override;
+
+    /**
+     * Implement the collective_time method of Topology.
+     * Collectives run hierarchically, one dimension after another:
+     * ReduceScatter from dimension 0 up, each dimension on the shard left by the previous ones,
+     * AllGather the other way around, AllReduce as both, and AllToAll on the full buffer in every dimension.
+     */
+    [[nodiscard]] EventTime collective_time(CollectiveType collective_type,
+                                            ChunkSize bytes,
+                                            CollectiveAlgorithm algorithm) const noexcept override;
+
     /**
      * Add a dimension to the multi-dimensional topology.
      *
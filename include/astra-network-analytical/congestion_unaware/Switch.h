@@ -7,6 +7,7 @@ LICENSE file in the root directory of this source tree.
 
 #include "common/Type.h"
 #include "congestion_unaware/BasicTopology.h"
+#include <vector>
 
 using namespace NetworkAnalytical;
 
@@ -35,11 +36,30 @@ class Switch final : public BasicTopology {
      */
     Switch(int npus_count, Bandwidth bandwidth, Latency latency) noexcept;
 
+    /**
+     * Implements the get_links_count method of BasicTopology.
+     * Link i goes up from NPU i to the switch, and link (npus_count + i) down from the switch to NPU i.
+     */
+    [[nodiscard]] int get_links_count() const noexcept override;
+
+    /**
+     * Implements the append_route_links method of BasicTopology.
+     */
+    bool append_route_links(DeviceId src, DeviceId dest, std::vector<int>& links) const noexcept override;
+
   private:
     /**
      * Implements the compute_hops_count method of BasicTopology.
      */
     [[nodiscard]] int compute_hops_count(DeviceId src, DeviceId dest) const noexcept override;
+
+    /**
+     * Implements the compute_hops_counts method of BasicTopology.
+     */
+    void compute_hops_counts(const DeviceId* srcs,
+                             const DeviceId* dests,
+                             int* hops_counts,
+                             size_t count) const noexcept override;
 };
 
 }  // namespace NetworkAnalyticalCongestionUnaware
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "common/CsrGraph.h"
 #include "common/Type.h"
 #include "congestion_unaware/BasicTopology.h"
 #include "congestion_unaware/ExpanderGraph.h"
@@ -16,7 +17,14 @@ class SwitchOrExpander final : public BasicTopology {
     SwitchOrExpander(int npus_count, Bandwidth bandwidth, Latency latency,
                      const std::string& inputfile = std::string()) noexcept;
     unsigned int get_distance(const DeviceId src, const DeviceId dest) const noexcept;
-    std::map<DeviceId, std::vector<DeviceId>> get_adjacency_list() const noexcept;
+    const std::map<DeviceId, std::vector<DeviceId>>& get_adjacency_list() const noexcept;
+
+    /**
+     * Get the expander graph if it is used for routing.
+     *
+     * @return expander graph in CSR form, an empty graph in switch mode
+     */
+    [[nodiscard]] const CsrGraph& get_graph() const noexcept;
     [[nodiscard]] int compute_hops_count(DeviceId src, DeviceId dest) const noexcept override;
   private:
     Switch switch_topology;
@@ -6,6 +6,7 @@ LICENSE file in the root directory of this source tree.
 #pragma once
 
 #include "common/Type.h"
+#include <cstddef>
 #include <vector>
 
 using namespace NetworkAnalytical;
@@ -33,6 +34,38 @@ class Topology {
      */
     [[nodiscard]] virtual EventTime send(DeviceId src, DeviceId dest, ChunkSize chunk_size) const noexcept = 0;
 
+    /**
+     * Estimate the time to transmit a batch of chunks,
+     * chunk i of size chunk_sizes[i] from srcs[i] to dests[i].
+     * Gives the same delays as calling send() on each chunk.
+     *
+     * @param srcs src NPU ID of each chunk
+     * @param dests dest NPU ID of each chunk
+     * @param chunk_sizes size of each chunk
+     * @param delays time to send each chunk, written by the call
+     * @param count number of chunks
+     */
+    virtual void send_batch(const DeviceId* srcs,
+                            const DeviceId* dests,
+                            const ChunkSize* chunk_sizes,
+                            EventTime* delays,
+                            size_t count) const noexcept;
+
+    /**
+     * Estimate the time taken by a collective over every NPU, in closed form.
+     * Steps of the algorithm run one after another, and the sends of a step concurrently,
+     * each taking the time send() would give, so the result matches decomposing the collective
+     * into send() calls.
+     *
+     * @param collective_type collective pattern
+     * @param bytes size of each NPU's buffer (the full, unreduced / gathered one)
+     * @param algorithm algorithm used by the collective
+     * @return time taken by the collective
+     */
+    [[nodiscard]] virtual EventTime collective_time(CollectiveType collective_type,
+                                                    ChunkSize bytes,
+                                                    CollectiveAlgorithm algorithm) const noexcept = 0;
+
     /**
      * Get the number of NPUs in the topology.
      *
@@ -0,0 +1,57 @@
+/******************************************************************************
+This source code is licensed under the MIT license found in the
+LICENSE file in the root directory of this source tree.
+*******************************************************************************/
+
+#pragma once
+
+#include "common/TraceFile.h"
+#include "common/Type.h"
+#include "congestion_unaware/Topology.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace NetworkAnalytical;
+
+namespace NetworkAnalyticalCongestionUnaware {
+
+/**
+ * TraceReplay streams the transfers of a trace file (see TraceReader) through a topology.
+ *
+ * Transfers don't contend, so each record completes send() after the later of its issue time
+ * and the completion of its dependencies, and records are replayed in a single pass in trace order.
+ * Only the completion times of the last window_size records are kept, in a ring,
+ * so memory doesn't grow with the trace length; dependencies should be among those records.
+ */
+class TraceReplay {
+  public:
+    /**
+     * Constructor.
+     *
+     * @param topology topology to replay the trace on
+     * @param path path of the trace file
+     * @param window_size number of records whose completion times are kept
+     */
+    TraceReplay(std::shared_ptr<Topology> topology, const std::string& path, int window_size = 4096) noexcept;
+
+    /**
+     * Replay the whole trace.
+     *
+     * @return time when the last transfer completed
+     */
+    [[nodiscard]] EventTime run() noexcept;
+
+  private:
+    /// topology to replay the trace on
+    std::shared_ptr<Topology> topology;
+
+    /// trace being replayed
+    TraceReader reader;
+
+    /// completion_times[index % window_size] -> completion time of the record of the given index
+    std::vector<EventTime> completion_times;
+};
+
+}  // namespace NetworkAnalyticalCongestionUnaware
@@ -3,18 +3,52 @@ This source code is licensed under the MIT license found in the
 LICENSE file in the root directory of this source tree.
 *******************************************************************************/
 
+#include "common/CApi.h"
+#include "common/CounterRng.h"
 #include "common/EventQueue.h"
+#include "common/KShortestPaths.h"
+#include "common/NetworkFunction.h"
 #include "common/NetworkParser.h"
+#include "common/TraceFile.h"
 #include "common/Type.h"
+#include "congestion_aware/Calibration.h"
 #include "congestion_aware/Chunk.h"
+#include "congestion_aware/ChunkTracer.h"
+#include "congestion_aware/Collective.h"
+#include "congestion_aware/Dragonfly.h"
+#include "congestion_aware/CompiledTopology.h"
+#include "congestion_aware/CompletionBatcher.h"
+#include "congestion_aware/ChunkPool.h"
 #include "congestion_aware/Helper.h"
 #include "congestion_aware/ExpanderGraph.h"
 #include "congestion_aware/SwitchOrExpander.h"
+#include "congestion_aware/SymmetricSimulation.h"
 #include "congestion_aware/MultiDimTopology.h"
 #include "congestion_aware/FatTree.h"
+#include "congestion_aware/FlowNetwork.h"
+#include "congestion_aware/FullyConnected.h"
+#include "congestion_aware/ParallelSimulator.h"
+#include "congestion_aware/Ring.h"
+#include "congestion_aware/SimulationContext.h"
+#include "congestion_aware/SimulationFork.h"
+#include "congestion_aware/Sweep.h"
+#include "congestion_aware/Switch.h"
+#include "congestion_aware/Torus.h"
+#include "congestion_aware/TraceReplay.h"
+#include "congestion_aware/TrafficGenerator.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
 #include <gtest/gtest.h>
 
-extern std::shared_ptr<std::map<NetworkAnalytical::DeviceId, bool>> use_moe_routing;
 
 using namespace NetworkAnalytical;
 using namespace NetworkAnalyticalCongestionAware;
@@ -34,6 +68,17 @@ class TestNetworkAnalyticalCongestionAware : public ::testing::Test {
 
     static void callback(void* const arg) {}
 
+    /// write an expander graph input file: circulant graph, each node i connected to i±1 and i±4
+    static void write_circulant_expander_graph(const std::string& inputfile, const int npus_count) {
+        auto file = std::ofstream(inputfile);
+        file << R"({"node_count": )" << npus_count << R"(, "degree": 4, "connected_graph_adjacency": [)";
+        for (int i = 0; i < npus_count; i++) {
+            file << (i > 0 ? ", " : "") << "[" << (i + 1) % npus_count << ", " << (i + npus_count - 1) % npus_count
+                 << ", " << (i + 4) % npus_count << ", " << (i + npus_count - 4) % npus_count << "]";
+        }
+        file << "]}";
+    }
+
     ChunkSize chunk_size;
 };
 
@@ -269,9 +314,7 @@ TEST_F(TestNetworkAnalyticalCongestionAware, SwitchOrExpander) {
     EXPECT_EQ(npus + (npus/8), devices);
 
     // test moe mode
-    for (auto device_id : topology->get_all_device_ids()) {
-        (*use_moe_routing)[device_id] = true;
-    }
+    graph->set_moe_routing(true);
 
     // validate that every node has degree 8
     for (DeviceId i = 0; i < network_parser.get_npus_counts_per_dim()[0]; ++i) {
@@ -296,9 +339,7 @@ TEST_F(TestNetworkAnalyticalCongestionAware, SwitchOrExpander) {
     }
 
     // test switch mode
-    for (auto device_id : topology->get_all_device_ids()) {
-        (*use_moe_routing)[device_id] = false;
-    }
+    graph->set_moe_routing(false);
 
     for (DeviceId i = 0; i < network_parser.get_npus_counts_per_dim()[0]; ++i) {
         for (DeviceId j = 0; j < network_parser.get_npus_counts_per_dim()[0]; ++j) {
@@ -314,6 +355,32 @@ TEST_F(TestNetworkAnalyticalCongestionAware, SwitchOrExpander) {
     }
 }
 
+TEST_F(TestNetworkAnalyticalCongestionAware, SwitchOrExpanderRoutingPhases) {
+    /// setup: no expander graph, so every phase routes through the switch
+    auto topology = SwitchOrExpander(16, 50, 500);
+    EXPECT_FALSE(topology.is_moe_routing(3));
+
+    // MoE layers route NPUs 0-7 through the expander graph
+    const auto moe_phase = topology.add_routing_phase({0, 1, 2, 3, 4, 5, 6, 7});
+    EXPECT_EQ(moe_phase, 1);
+    EXPECT_EQ(topology.get_routing_phase(), 0);
+
+    /// test: switching phases flips the routing mode of the group only
+    topology.set_routing_phase(moe_phase);
+    EXPECT_TRUE(topology.is_moe_routing(3));
+    EXPECT_FALSE(topology.is_moe_routing(8));
+    EXPECT_EQ(topology.route(8, 12).size(), 3);
+
+    /// test: edits apply to the active phase only, and carry over to clones
+    topology.set_moe_routing({8, 9}, true);
+    EXPECT_TRUE(topology.is_moe_routing(9));
+    const auto clone = topology.clone();
+    topology.set_routing_phase(0);
+    EXPECT_FALSE(topology.is_moe_routing(9));
+    EXPECT_FALSE(topology.is_moe_routing(3));
+    EXPECT_TRUE(dynamic_cast<const SwitchOrExpander&>(*clone).is_moe_routing(9));
+}
+
 // test splitted expander graph
 TEST_F(TestNetworkAnalyticalCongestionAware, SwitchOrExpander_Splitted) {
     // create network
@@ -325,9 +392,7 @@ TEST_F(TestNetworkAnalyticalCongestionAware, SwitchOrExpander_Splitted) {
     ASSERT_NE(graph, nullptr);
 
     // test moe mode
-    for (auto device_id : topology->get_all_device_ids()) {
-        (*use_moe_routing)[device_id] = true;
-    }
+    graph->set_moe_routing(true);
 
        // using resilient expander. Ensure devices = npus + (npus/8)
     auto devices = graph->get_devices_count();
@@ -358,9 +423,7 @@ TEST_F(TestNetworkAnalyticalCongestionAware, SwitchOrExpander_Splitted) {
     }
 
     // test switch mode
-    for (auto device_id : topology->get_all_device_ids()) {
-        (*use_moe_routing)[device_id] = false;
-    }
+    graph->set_moe_routing(false);
 
     for (DeviceId i = 0; i < network_parser.get_npus_counts_per_dim()[0]; ++i) {
         for (DeviceId j = 0; j < network_parser.get_npus_counts_per_dim()[0]; ++j) {
@@ -378,7 +441,8 @@ TEST_F(TestNetworkAnalyticalCongestionAware, SwitchOrExpander_Splitted) {
 
 TEST_F(TestNetworkAnalyticalCongestionAware, FatTree) {
     // create network
-    const auto network_parsers = { NetworkParser("../../input/FatTree.yml"), NetworkParser("../../input/FatTree-Random.yml")};
+    const auto network_parsers = { NetworkParser("../../input/FatTree.yml"), NetworkParser("../../input/FatTree-Random.yml"), NetworkParser("../../input/FatTree-Adaptive.yml"),
+                                  NetworkParser("../../input/FatTree-ECMP.yml"), NetworkParser("../../input/FatTree-Spray.yml")};
     for (auto network_parser : network_parsers) {
     const auto topology = construct_topology(network_parser);
     
@@ -388,14 +452,14 @@ TEST_F(TestNetworkAnalyticalCongestionAware, FatTree) {
 
     // FatTree with 16 NPUs: k=4
     // Pods: 4, Leaf switches per pod: 2, NPUs per leaf: 2
-    // Total leaf switches: 8, Spine switches: 4, Core switches: 4
+    // Total leaf switches: 8, Spine switches: 8, Core switches: 4
     const auto k = 4;
     const auto pods = k;
     const auto npus_per_leaf = k / 2;  // 2
     const auto leaves_per_pod = k / 2;  // 2
     const auto spines_per_pod = k / 2;  // 2
     const auto total_leaves = (k * k) / 2;  // 8
-    const auto total_spines = (k * k) / 4;  // 4
+    const auto total_spines = (k * k) / 2;  // 8
     const auto total_cores = (k / 2) * (k / 2);  // 4
 
     // Test 1: Path lengths within the same leaf switch (same NPUs under same leaf)
@@ -493,6 +557,7 @@ TEST_F(TestNetworkAnalyticalCongestionAware, MultiDimTopology_BuildAndValidate)
     // assert topology type
     auto multi_dim_topology = std::dynamic_pointer_cast<MultiDimTopology>(topology);
     ASSERT_NE(multi_dim_topology, nullptr);
+    multi_dim_topology->validate();
     std::cout << "MultiDimTopology created with " << multi_dim_topology->get_devices_count() << " devices." << std::endl;
     // ensure reachability between all NPUs that share a single dimension
     const auto npus_count = multi_dim_topology->get_npus_count();
@@ -528,4 +593,2432 @@ TEST_F(TestNetworkAnalyticalCongestionAware, MultiDimTopology_BuildAndValidate)
             EXPECT_EQ(comm_delay, (route.size() -1) * 500);
         }
     }
-}
\ No newline at end of file
+}
+TEST_F(TestNetworkAnalyticalCongestionAware, EventQueueOrdering) {
+    // records (event time, event tag) of each invoked event
+    struct Record {
+        EventQueue* event_queue;
+        std::vector<std::pair<EventTime, int>>* invoked;
+        int tag;
+    };
+    static const auto record = [](void* const arg) {
+        auto* const rec = static_cast<Record*>(arg);
+        rec->invoked->emplace_back(rec->event_queue->get_current_time(), rec->tag);
+    };
+
+    // schedule events out of order, with several events sharing a timestamp
+    const auto event_times = std::vector<EventTime>{50, 10, 30, 10, 70, 30, 20, 10, 50, 60, 40, 30};
+    for (const auto deferred : {false, true}) {
+        event_queue->reset();
+        auto invoked = std::vector<std::pair<EventTime, int>>();
+        auto records = std::vector<Record>();
+        records.reserve(event_times.size());
+        for (auto i = 0; i < event_times.size(); i++) {
+            records.push_back({event_queue.get(), &invoked, i});
+        }
+
+        // the second half is deferred, then flushed behind the first
+        for (auto i = 0; i < event_times.size(); i++) {
+            if (deferred && i == event_times.size() / 2) {
+                event_queue->defer_events();
+            }
+            const auto event_handle = event_queue->schedule_event(event_times[i], record, &records[i]);
+            EXPECT_EQ(event_handle.event_list == nullptr, deferred && i >= event_times.size() / 2);
+        }
+        if (deferred) {
+            event_queue->flush_deferred_events();
+        }
+
+        while (!event_queue->finished()) {
+            event_queue->proceed();
+        }
+
+        // events are invoked in time order, and in scheduling order (FIFO) within a timestamp
+        ASSERT_EQ(invoked.size(), event_times.size());
+        for (auto i = 1; i < invoked.size(); i++) {
+            const auto& [prev_time, prev_tag] = invoked[i - 1];
+            const auto& [time, tag] = invoked[i];
+            EXPECT_LE(prev_time, time);
+            if (prev_time == time) {
+                EXPECT_LT(prev_tag, tag);
+            }
+            EXPECT_EQ(event_times[tag], time);
+        }
+        EXPECT_EQ(event_queue->get_current_time(), 70);
+    }
+
+    // a reset drops a deferred batch, which isn't flushed into the next run
+    auto stale_invoked = false;
+    event_queue->defer_events();
+    event_queue->schedule_event(event_queue->get_current_time() + 10, [&stale_invoked]() { stale_invoked = true; });
+    event_queue->reset();
+    event_queue->defer_events();
+    event_queue->flush_deferred_events();
+    EXPECT_TRUE(event_queue->finished());
+    event_queue->run();
+    EXPECT_FALSE(stale_invoked);
+}
+
+TEST_F(TestNetworkAnalyticalCongestionAware, EventQueueSameTimeReschedule) {
+    // each invocation schedules further events at the current time
+    // and one event at a later time, until the budget runs out
+    struct Context {
+        EventQueue* event_queue;
+        int remaining;
+        int invoked;
+    };
+    static Callback spawn = nullptr;
+    spawn = [](void* const arg) {
+        auto* const context = static_cast<Context*>(arg);
+        context->invoked++;
+        if (context->remaining <= 0) {
+            return;
+        }
+        context->remaining--;
+        const auto now = context->event_queue->get_current_time();
+        for (auto i = 0; i < 4; i++) {
+            context->event_queue->schedule_event(now, spawn, arg);
+        }
+        context->event_queue->schedule_event(now + 1, spawn, arg);
+    };
+
+    auto context = Context{event_queue.get(), 1'000, 0};
+    event_queue->schedule_event(1, spawn, &context);
+
+    // recycled event lists and same-time appends should not lose any event
+    auto timestamps = 0;
+    while (!event_queue->finished()) {
+        event_queue->proceed();
+        timestamps++;
+    }
+    EXPECT_EQ(context.invoked, 1 + (5 * 1'000));
+    EXPECT_GT(timestamps, 1);
+}
+
+TEST_F(TestNetworkAnalyticalCongestionAware, AllGatherOnRingBatched) {
+    /// setup
+    const auto network_parser = NetworkParser("../../input/Ring.yml");
+    const auto topology = construct_topology(network_parser);
+    const auto npus_count = topology->get_npus_count();
+
+    /// Run All-Gather, injecting every chunk in one batch
+    auto chunks = std::vector<std::unique_ptr<Chunk>>();
+    for (int i = 0; i < npus_count; i++) {
+        for (int j = 0; j < npus_count; j++) {
+            if (i == j) {
+                continue;
+            }
+            auto route = topology->route(i, j);
+            chunks.push_back(std::make_unique<Chunk>(chunk_size, route, callback, nullptr));
+        }
+    }
+    topology->send_batch(std::move(chunks));
+
+    /// Run simulation
+    while (!event_queue->finished()) {
+        event_queue->proceed();
+    }
+
+    /// test: same result as sending chunks one by one
+    const auto simulation_time = event_queue->get_current_time();
+    EXPECT_EQ(simulation_time, 704'116);
+}
+
+static void count_arrival(void* const arg) {
+    auto* const arrived_chunks = static_cast<std::atomic<int>*>(arg);
+    (*arrived_chunks)++;
+}
+
+TEST_F(TestNetworkAnalyticalCongestionAware, AllGatherOnRingParallel) {
+    /// setup
+    const auto network_parser = NetworkParser("../../input/Ring.yml");
+    const auto topology = construct_topology(network_parser);
+    const auto npus_count = topology->get_npus_count();
+
+    /// partition the ring across 4 threads
+    auto simulator = ParallelSimulator(topology, 4);
+    EXPECT_EQ(simulator.get_partitions_count(), 4);
+    EXPECT_GT(simulator.get_lookahead(), 0);
+
+    /// Run All-Gather
+    auto arrived_chunks = std::atomic<int>(0);
+    for (int i = 0; i < npus_count; i++) {
+        for (int j = 0; j < npus_count; j++) {
+            if (i == j) {
+                continue;
+            }
+            auto route = topology->route(i, j);
+            auto chunk = std::make_unique<Chunk>(chunk_size, route, count_arrival, &arrived_chunks);
+            topology->send(std::move(chunk));
+        }
+    }
+
+    /// Run simulation
+    simulator.run();
+
+    /// test: same result as the serial run
+    EXPECT_EQ(arrived_chunks, npus_count * (npus_count - 1));
+    EXPECT_EQ(simulator.get_current_time(), 704'116);
+    EXPECT_TRUE(event_queue->finished());
+}
+
+TEST_F(TestNetworkAnalyticalCongestionAware, EventQueueRunUntilAndRunFor) {
+    static const auto count = [](void* const arg) { (*static_cast<int*>(arg))++; };
+
+    auto invoked = 0;
+    for (auto time = 10; time <= 100; time += 10) {
+        event_queue->schedule_event(time, count, &invoked);
+        event_queue->schedule_event(time, count, &invoked);
+    }
+
+    // run_until is inclusive, and advances the time even without events
+    event_queue->run_until(35);
+    EXPECT_EQ(invoked, 6);
+    EXPECT_EQ(event_queue->get_current_time(), 35);
+
+    // run_for stops at the first time boundary after the budget is reached
+    EXPECT_EQ(event_queue->run_for(3), 4);
+    EXPECT_EQ(invoked, 10);
+    EXPECT_EQ(event_queue->get_current_time(), 50);
+
+    event_queue->run();
+    EXPECT_EQ(invoked, 20);
+    EXPECT_EQ(event_queue->get_current_time(), 100);
+    EXPECT_TRUE(event_queue->finished());
+}
+
+TEST_F(TestNetworkAnalyticalCongestionAware, EventQueueCancelEvent) {
+    static const auto count = [](void* const arg) { (*static_cast<int*>(arg))++; };
+
+    auto invoked = 0;
+    const auto kept = event_queue->schedule_event(10, count, &invoked);
+    const auto cancelled = event_queue->schedule_event(10, count, &invoked);
+    const auto timeout = event_queue->schedule_event(1'000, count, &invoked);
+
+    EXPECT_TRUE(event_queue->cancel_event(cancelled));
+    EXPECT_FALSE(event_queue->cancel_event(cancelled));
+    EXPECT_TRUE(event_queue->cancel_event(timeout));
+
+    event_queue->run();
+
+    // a timestamp left with cancelled events only doesn't advance the time
+    EXPECT_EQ(invoked, 1);
+    EXPECT_EQ(event_queue->get_current_time(), 10);
+
+    // stale handles are rejected, even after the list got recycled
+    EXPECT_FALSE(event_queue->cancel_event(kept));
+    event_queue->schedule_event(20, count, &invoked);
+    EXPECT_FALSE(event_queue->cancel_event(kept));
+    event_queue->run();
+    EXPECT_EQ(invoked, 2);
+}
+
+TEST_F(TestNetworkAnalyticalCongestionAware, EventCallbackCapturingLambda) {
+    /// setup
+    const auto network_parser = NetworkParser("../../input/Ring.yml");
+    const auto topology = construct_topology(network_parser);
+
+    // a chunk callback capturing its context by value, without a void* round trip
+    auto arrived_at = static_cast<EventTime>(0);
+    auto route = topology->route(1, 4);
+    auto* const queue = event_queue.get();
+    topology->send(std::make_unique<Chunk>(chunk_size, route, [queue, &arrived_at] {
+        arrived_at = queue->get_current_time();
+    }));
+
+    // an event owning a move-only capture is destroyed when cancelled
+    auto owned = std::make_shared<int>(0);
+    const auto handle = event_queue->schedule_event(1, [owned_copy = std::make_unique<std::shared_ptr<int>>(owned)] {
+        (**owned_copy)++;
+    });
+    EXPECT_EQ(owned.use_count(), 2);
+    EXPECT_TRUE(event_queue->cancel_event(handle));
+    EXPECT_EQ(owned.use_count(), 1);
+
+    event_queue->run();
+
+    /// test: same result as the function pointer callback
+    EXPECT_EQ(arrived_at, 60'093);
+    EXPECT_EQ(*owned, 0);
+}
+
+TEST_F(TestNetworkAnalyticalCongestionAware, DevicePortTable) {
+    /// setup
+    const auto network_parser = NetworkParser("../../input/FullyConnected.yml");
+    const auto topology = construct_topology(network_parser);
+    const auto npus_count = topology->get_npus_count();
+
+    // every other NPU is reachable through exactly one port
+    const auto device = topology->get_device(0);
+    EXPECT_EQ(device->get_ports_count(), npus_count - 1);
+    EXPECT_EQ(device->get_port(0), -1);
+    for (auto dest = 1; dest < npus_count; dest++) {
+        const auto port = device->get_port(dest);
+        ASSERT_GE(port, 0);
+        EXPECT_EQ(device->get_port_dest(port), dest);
+    }
+}
+
+TEST_F(TestNetworkAnalyticalCongestionAware, ChunkLongRoute) {
+    /// setup
+    const auto network_parser = NetworkParser("../../input/Ring.yml");
+    const auto topology = construct_topology(network_parser);
+
+    // 9 devices on the route: more hops than the chunk stores inline
+    auto route = topology->route(0, 8);
+    ASSERT_EQ(route.size(), 9);
+    topology->send(std::make_unique<Chunk>(chunk_size, route, callback, nullptr));
+
+    /// Run simulation
+    event_queue->run();
+
+    /// test: 8 hops of 20'031 ns each
+    EXPECT_EQ(event_queue->get_current_time(), 8 * 20'031);
+}
+
+TEST_F(TestNetworkAnalyticalCongestionAware, ChunkPoolRecyclesChunks) {
+    /// setup
+    const auto network_parser = NetworkParser("../../input/Ring.yml");
+    const auto topology = construct_topology(network_parser);
+
+    // warm up the pool of this thread
+    ChunkPool::reserve(16);
+    const auto blocks_count = ChunkPool::get_blocks_count();
+
+    // chunks of consecutive rounds reuse the storage freed on arrival
+    for (auto round = 0; round < 100; round++) {
+        for (auto i = 0; i < 16; i++) {
+            auto route = topology->route(i, (i + 1) % 16);
+            topology->send(std::make_unique<Chunk>(chunk_size, route, callback, nullptr));
+        }
+        event_queue->run();
+    }
+
+    EXPECT_EQ(ChunkPool::get_blocks_count(), blocks_count);
+}
+
+TEST_F(TestNetworkAnalyticalCongestionAware, AllGatherOnRingCoalesced) {
+    /// setup
+    const auto network_parser = NetworkParser("../../input/Ring.yml");
+    const auto npus_count = network_parser.get_npus_counts_per_dim()[0];
+
+    // run the same All-Gather with and without busy-period coalescing
+    auto simulation_times = std::vector<EventTime>();
+    auto events_counts = std::vector<size_t>();
+    for (const auto coalescing : {false, true}) {
+        event_queue = std::make_shared<EventQueue>();
+        Topology::set_event_queue(event_queue);
+        Topology::set_link_coalescing(coalescing);
+        const auto topology = construct_topology(network_parser);
+
+        for (int i = 0; i < npus_count; i++) {
+            for (int j = 0; j < npus_count; j++) {
+                if (i != j) {
+                    auto route = topology->route(i, j);
+                    topology->send(std::make_unique<Chunk>(chunk_size, route, callback, nullptr));
+                }
+            }
+        }
+
+        events_counts.push_back(event_queue->run_for(std::numeric_limits<size_t>::max()));
+        simulation_times.push_back(event_queue->get_current_time());
+    }
+    Topology::set_link_coalescing(false);
+
+    /// test: same timing, fewer events
+    EXPECT_EQ(simulation_times[0], 704'116);
+    EXPECT_EQ(simulation_times[1], 704'116);
+    EXPECT_LT(events_counts[1], events_counts[0]);
+}
+
+TEST_F(TestNetworkAnalyticalCongestionAware, FlowNetworkMaxMinSharing) {
+    /// setup
+    const auto network_parser = NetworkParser("../../input/Ring.yml");
+    const auto topology = construct_topology(network_parser);
+    auto flow_network = FlowNetwork(topology, event_queue);
+
+    // records the arrival time of each flow
+    struct Arrival {
+        EventQueue* event_queue;
+        EventTime time;
+    };
+    auto arrivals = std::vector<Arrival>(3, {event_queue.get(), 0});
+    const auto record = [](void* const arg) {
+        auto* const arrival = static_cast<Arrival*>(arg);
+        arrival->time = arrival->event_queue->get_current_time();
+    };
+
+    // flows 0 and 1 share link 1->2; flow 2 runs on a disjoint link
+    flow_network.start_flow(1, 2, chunk_size, record, &arrivals[0]);
+    flow_network.start_flow(1, 3, chunk_size, record, &arrivals[1]);
+    flow_network.start_flow(5, 6, chunk_size, record, &arrivals[2]);
+    event_queue->run_until(0);
+    ASSERT_EQ(flow_network.get_active_flows_count(), 3);
+    EXPECT_DOUBLE_EQ(flow_network.get_active_flow_rate(0), flow_network.get_active_flow_rate(2) / 2);
+    EXPECT_DOUBLE_EQ(flow_network.get_active_flow_rate(1), flow_network.get_active_flow_rate(2) / 2);
+
+    event_queue->run();
+
+    /// test: 1 MB on a 50 GB/s link takes 19'531.25 ns, plus 500 ns per hop
+    EXPECT_EQ(flow_network.get_active_flows_count(), 0);
+    EXPECT_EQ(arrivals[2].time, 19'532 + 500);
+    EXPECT_EQ(arrivals[0].time, 39'063 + 500);
+    EXPECT_EQ(arrivals[1].time, 39'063 + 1'000);
+}
+
+TEST_F(TestNetworkAnalyticalCongestionAware, SendMessage) {
+    /// setup
+    const auto network_parser = NetworkParser("../../input/Ring.yml");
+    const auto topology = construct_topology(network_parser);
+
+    // 10 MB message in 1 MB chunks, all of them allowed in flight
+    auto completions = 0;
+    auto completed_at = static_cast<EventTime>(0);
+    auto* const queue = event_queue.get();
+    topology->send_message(1, 4, 10 * chunk_size, chunk_size, [&, queue] {
+        completions++;
+        completed_at = queue->get_current_time();
+    }, 10);
+    event_queue->run();
+
+    /// test: one callback, on the pipelined arrival of the 10th chunk over 3 hops
+    EXPECT_EQ(completions, 1);
+    EXPECT_EQ(completed_at, (3 * 20'031) + (9 * 19'531));
+
+    // a window of one chunk serializes the chunks end-to-end
+    completions = 0;
+    const auto start_time = event_queue->get_current_time();
+    topology->send_message(1, 4, (3 * chunk_size) + 1, chunk_size, [&, queue] {
+        completions++;
+        completed_at = queue->get_current_time();
+    }, 1);
+    event_queue->run();
+    EXPECT_EQ(completions, 1);
+    EXPECT_GT(completed_at - start_time, 3 * 60'093);
+}
+
+TEST_F(TestNetworkAnalyticalCongestionAware, SendWithoutRoute) {
+    /// setup
+    const auto network_parser = NetworkParser("../../input/Ring.yml");
+    const auto topology = construct_topology(network_parser);
+    const auto npus_count = topology->get_npus_count();
+
+    /// Run All-Gather through the cached routes
+    for (int i = 0; i < npus_count; i++) {
+        for (int j = 0; j < npus_count; j++) {
+            if (i != j) {
+                topology->send(i, j, chunk_size, callback, nullptr);
+            }
+        }
+    }
+    event_queue->run();
+
+    /// test: same result as building routes explicitly
+    EXPECT_EQ(event_queue->get_current_time(), 704'116);
+
+    // cached routes are stable and match route()
+    const auto& route_hops = topology->get_route_hops(1, 4);
+    EXPECT_EQ(&route_hops, &topology->get_route_hops(1, 4));
+    EXPECT_EQ(route_hops.size(), topology->route(1, 4).size());
+    EXPECT_EQ(route_hops.back().device->get_id(), 4);
+    EXPECT_EQ(route_hops.back().port, -1);
+}
+
+TEST_F(TestNetworkAnalyticalCongestionAware, ConcurrentSimulationContexts) {
+    /// setup: two independent topologies, each in its own context
+    const auto network_parser = NetworkParser("../../input/Ring.yml");
+    auto contexts = std::vector<std::shared_ptr<SimulationContext>>();
+    auto topologies = std::vector<std::shared_ptr<Topology>>();
+    for (int i = 0; i < 2; i++) {
+        contexts.push_back(std::make_shared<SimulationContext>(std::make_shared<EventQueue>()));
+        topologies.push_back(construct_topology(network_parser, contexts.back()));
+    }
+    contexts[1]->set_link_coalescing(true);
+
+    /// Run All-Gather on both at the same time
+    auto simulation_times = std::vector<EventTime>(2);
+    auto threads = std::vector<std::thread>();
+    for (int t = 0; t < 2; t++) {
+        threads.emplace_back([&, t] {
+            const auto& topology = topologies[t];
+            const auto npus_count = topology->get_npus_count();
+            for (int i = 0; i < npus_count; i++) {
+                for (int j = 0; j < npus_count; j++) {
+                    if (i != j) {
+                        topology->send(i, j, chunk_size, callback, nullptr);
+                    }
+                }
+            }
+            contexts[t]->get_event_queue()->run();
+            simulation_times[t] = contexts[t]->get_event_queue()->get_current_time();
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    /// test: both match the sequential result, and the default context is untouched
+    EXPECT_EQ(simulation_times[0], 704'116);
+    EXPECT_EQ(simulation_times[1], 704'116);
+    EXPECT_TRUE(event_queue->finished());
+    EXPECT_EQ(event_queue->get_current_time(), 0);
+}
+
+TEST_F(TestNetworkAnalyticalCongestionAware, HybridFidelity) {
+    /// setup: the same Ring, with and without the fast path
+    const auto network_parser = NetworkParser("../../input/Ring.yml");
+    auto arrival_times = std::vector<std::vector<EventTime>>(2);
+    auto events_counts = std::vector<size_t>();
+    for (const auto hybrid_fidelity : {false, true}) {
+        const auto context = std::make_shared<SimulationContext>(std::make_shared<EventQueue>());
+        context->set_hybrid_fidelity(hybrid_fidelity);
+        const auto topology = construct_topology(network_parser, context);
+        auto* const queue = context->get_event_queue();
+        auto& times = arrival_times[hybrid_fidelity ? 1 : 0];
+        const auto record = [&times, queue]() { times.push_back(queue->get_current_time()); };
+
+        // pipeline P2P: lone chunks, then chunks sharing their route, then crossing another route
+        topology->send(0, 3, chunk_size, record);
+        queue->schedule_event(1'000'000, [&, record]() {
+            for (auto i = 0; i < 3; i++) {
+                topology->send(4, 7, chunk_size, record);
+            }
+        });
+        queue->schedule_event(2'000'000, [&, record]() {
+            topology->send(8, 11, chunk_size, record);
+            topology->send(9, 12, chunk_size, record);
+        });
+        events_counts.push_back(queue->run_for(std::numeric_limits<size_t>::max()));
+    }
+
+    /// test: same arrival times, fewer events
+    EXPECT_EQ(arrival_times[0].size(), 6);
+    EXPECT_EQ(arrival_times[1], arrival_times[0]);
+    EXPECT_LT(events_counts[1], events_counts[0]);
+
+    /// setup: on a Switch, a per-hop chunk reaches the switch -> 0 link before an idle route asking for it
+    const auto switch_parser = NetworkParser("../../input/Switch.yml");
+    const auto serialization_time = static_cast<EventTime>(chunk_size / 50);
+    auto switch_arrival_times = std::vector<std::vector<EventTime>>(2);
+    for (const auto hybrid_fidelity : {false, true}) {
+        const auto context = std::make_shared<SimulationContext>(std::make_shared<EventQueue>());
+        context->set_hybrid_fidelity(hybrid_fidelity);
+        const auto topology = construct_topology(switch_parser, context);
+        auto* const queue = context->get_event_queue();
+        auto& times = switch_arrival_times[hybrid_fidelity ? 1 : 0];
+        const auto record = [&times, queue]() { times.push_back(queue->get_current_time()); };
+
+        // 2 -> 0 queues behind 2 -> 1, then 1 -> 0 is sent while it is serialized
+        topology->send(2, 1, chunk_size, record);
+        topology->send(2, 0, chunk_size, record);
+        queue->schedule_event(serialization_time * 3 / 2, [&, record]() { topology->send(1, 0, chunk_size, record); });
+        queue->run_for(std::numeric_limits<size_t>::max());
+    }
+
+    /// test: the idle route doesn't take the link ahead of the earlier chunk
+    EXPECT_EQ(switch_arrival_times[0].size(), 3);
+    EXPECT_EQ(switch_arrival_times[1], switch_arrival_times[0]);
+
+    /// setup: on the Ring, 2 -> 3 is sent just before the fast-path 0 -> 3 reaches the 2 -> 3 link
+    const auto hop_time = static_cast<EventTime>(20'031);  // serialization and latency of a Ring link
+    auto reserved_arrival_times = std::vector<std::vector<EventTime>>(2);
+    for (const auto hybrid_fidelity : {false, true}) {
+        const auto context = std::make_shared<SimulationContext>(std::make_shared<EventQueue>());
+        context->set_hybrid_fidelity(hybrid_fidelity);
+        const auto topology = construct_topology(network_parser, context);
+        auto* const queue = context->get_event_queue();
+        auto& times = reserved_arrival_times[hybrid_fidelity ? 1 : 0];
+        const auto record = [&times, queue]() { times.push_back(queue->get_current_time()); };
+
+        topology->send(0, 3, chunk_size, record);
+        queue->schedule_event(hop_time * 2 - 1, [&, record]() { topology->send(2, 3, chunk_size, record); });
+        queue->run_for(std::numeric_limits<size_t>::max());
+    }
+
+    /// test: 2 -> 3 takes the link first, and 0 -> 3 waits for it as in the full simulation
+    EXPECT_EQ(reserved_arrival_times[0], (std::vector<EventTime>{60'092, 79'623}));
+    EXPECT_EQ(reserved_arrival_times[1], reserved_arrival_times[0]);
+}
+
+TEST_F(TestNetworkAnalyticalCongestionAware, CalibrateCongestionUnaware) {
+    /// setup
+    const auto network_parser = NetworkParser("../../input/Ring.yml");
+    const auto calibration = calibrate_congestion_unaware(network_parser, chunk_size);
+
+    /// test: positive factors, and the fitted closed form tracks the simulation
+    ASSERT_EQ(calibration.bandwidth_scale_per_dim.size(), 1);
+    EXPECT_GT(calibration.bandwidth_scale_per_dim[0], 0);
+    EXPECT_LE(calibration.bandwidth_scale_per_dim[0], 1.0 + 1e-9);
+    EXPECT_GT(calibration.latency_scale_per_dim[0], 0);
+    EXPECT_LT(calibration.error_per_dim[0], 0.5);
+
+    /// test: the saved overlay loads back
+    const auto path = ::testing::TempDir() + "calibration.yml";
+    ASSERT_TRUE(save_calibration(calibration, path));
+    auto reloaded = NetworkParser("../../input/Ring.yml");
+    reloaded.load_calibration(path);
+    EXPECT_NEAR(reloaded.get_bandwidth_scales_per_dim()[0], calibration.bandwidth_scale_per_dim[0], 1e-9);
+    EXPECT_NEAR(reloaded.get_latency_scales_per_dim()[0], calibration.latency_scale_per_dim[0], 1e-9);
+    std::remove(path.c_str());
+}
+
+TEST_F(TestNetworkAnalyticalCongestionAware, TopologySnapshot) {
+    /// setup: snapshots of a multi-dimensional topology and of a topology with a switch
+    const auto path = ::testing::TempDir() + "topology.snapshot";
+    for (const auto* const config : {"../../input/Ring_FullyConnected_Switch.yml", "../../input/Switch.yml"}) {
+        const auto constructed = construct_topology(NetworkParser(config));
+        ASSERT_TRUE(constructed->save_snapshot(path, 7));
+        EXPECT_EQ(Topology::load_snapshot(path, 8), nullptr);
+        const auto loaded = Topology::load_snapshot(path, 7);
+        ASSERT_NE(loaded, nullptr);
+
+        /// test: same devices, routes, and timing
+        EXPECT_EQ(loaded->get_devices_count(), constructed->get_devices_count());
+        EXPECT_EQ(loaded->get_npus_count_per_dim(), constructed->get_npus_count_per_dim());
+        EXPECT_EQ(loaded->get_bandwidth_per_dim(), constructed->get_bandwidth_per_dim());
+        const auto npus_count = constructed->get_npus_count();
+        auto end_times = std::vector<EventTime>();
+        for (const auto& topology : {constructed, loaded}) {
+            topology->set_simulation_context(std::make_shared<SimulationContext>(std::make_shared<EventQueue>()));
+            for (auto src = 0; src < npus_count; src++) {
+                for (auto dest = 0; dest < npus_count; dest++) {
+                    if (src != dest) {
+                        topology->send(src, dest, chunk_size, callback, nullptr);
+                    }
+                }
+            }
+            auto* const queue = topology->get_simulation_context()->get_event_queue();
+            queue->run();
+            end_times.push_back(queue->get_current_time());
+        }
+        EXPECT_EQ(end_times[0], end_times[1]);
+        const auto route = loaded->route(1, npus_count - 1);
+        auto route_ids = std::vector<DeviceId>();
+        std::transform(route.begin(), route.end(), std::back_inserter(route_ids),
+                       [](const auto& device) { return device->get_id(); });
+        auto expected_ids = std::vector<DeviceId>();
+        for (const auto& device : constructed->route(1, npus_count - 1)) {
+            expected_ids.push_back(device->get_id());
+        }
+        EXPECT_EQ(route_ids, expected_ids);
+    }
+    std::remove(path.c_str());
+
+    /// test: a config naming a snapshot saves it once, and loads it afterwards
+    const auto config_path = ::testing::TempDir() + "ring_snapshot.yml";
+    {
+        auto config = std::ofstream(config_path);
+        config << "topology: [ Ring ]\nnpus_count: [ 8 ]\nbandwidth: [ 50.0 ]\nlatency: [ 500.0 ]\n"
+               << "snapshot: ring.snapshot\n";
+    }
+    const auto network_parser = NetworkParser(config_path);
+    EXPECT_EQ(network_parser.get_snapshot_path(), ::testing::TempDir() + "ring.snapshot");
+    std::remove(network_parser.get_snapshot_path().c_str());
+    EXPECT_EQ(std::dynamic_pointer_cast<CompiledTopology>(construct_topology(network_parser)), nullptr);
+    EXPECT_NE(std::dynamic_pointer_cast<CompiledTopology>(construct_topology(network_parser)), nullptr);
+    std::remove(network_parser.get_snapshot_path().c_str());
+    std::remove(config_path.c_str());
+}
+
+TEST_F(TestNetworkAnalyticalCongestionAware, TopologyReset) {
+    /// setup: All-to-All on a Ring, run to the end, then stopped halfway
+    const auto context = std::make_shared<SimulationContext>(std::make_shared<EventQueue>());
+    const auto topology = construct_topology(NetworkParser("../../input/Ring.yml"), context);
+    auto* const queue = context->get_event_queue();
+    const auto npus_count = topology->get_npus_count();
+    auto arrivals_count = 0;
+    const auto all_to_all = [&]() {
+        for (auto src = 0; src < npus_count; src++) {
+            for (auto dest = 0; dest < npus_count; dest++) {
+                if (src != dest) {
+                    topology->send(src, dest, chunk_size, [&arrivals_count]() { arrivals_count++; });
+                }
+            }
+        }
+    };
+    all_to_all();
+    queue->run();
+    const auto end_time = queue->get_current_time();
+    const auto cache_bytes = topology->get_route_cache_bytes();
+    EXPECT_EQ(arrivals_count, npus_count * (npus_count - 1));
+
+    topology->reset();
+    queue->reset();
+    all_to_all();
+    queue->run_until(end_time / 2);
+    EXPECT_FALSE(queue->finished());
+
+    /// test: a reset topology and queue replay the same simulation, with the same routes
+    topology->reset();
+    queue->reset();
+    EXPECT_TRUE(queue->finished());
+    EXPECT_EQ(queue->get_current_time(), 0);
+    arrivals_count = 0;
+    all_to_all();
+    queue->run();
+    EXPECT_EQ(arrivals_count, npus_count * (npus_count - 1));
+    EXPECT_EQ(queue->get_current_time(), end_time);
+    EXPECT_EQ(topology->get_route_cache_bytes(), cache_bytes);
+}
+
+TEST_F(TestNetworkAnalyticalCongestionAware, ParameterSweep) {
+    /// setup: two bandwidths of a Ring, two workloads each
+    {
+        auto ring = std::ifstream("../../input/Ring.yml");
+        auto copy = std::ofstream(::testing::TempDir() + "sweep_ring.yml");
+        copy << ring.rdbuf();
+    }
+    const auto spec_path = ::testing::TempDir() + "sweep.yml";
+    {
+        auto spec = std::ofstream(spec_path);
+        spec << "network: sweep_ring.yml\n"
+             << "sweep:\n"
+             << "  bandwidth: [ 50.0, [ 100.0 ] ]\n"
+             << "workloads:\n"
+             << "  - { name: a2a, pattern: AllToAll, size: 1048576 }\n"
+             << "  - { pattern: AllGather, size: 8388608, chunk_size: 262144 }\n"
+             << "threads: 2\n";
+    }
+    const auto sweep = Sweep(spec_path);
+    EXPECT_EQ(sweep.get_points_count(), 2);
+    EXPECT_EQ(sweep.get_workloads().size(), 2);
+
+    auto output = std::ostringstream();
+    sweep.run(output);
+
+    /// test: a row per point and workload, faster on the wider links
+    auto csv = std::istringstream(output.str());
+    auto line = std::string();
+    std::getline(csv, line);
+    EXPECT_EQ(line, "point,bandwidth,workload,pattern,size,finish_time_ns");
+    auto finish_times = std::map<std::string, EventTime>();
+    while (std::getline(csv, line)) {
+        auto fields = std::vector<std::string>();
+        auto field_stream = std::istringstream(line);
+        for (auto field = std::string(); std::getline(field_stream, field, ',');) {
+            fields.push_back(field);
+        }
+        ASSERT_EQ(fields.size(), 6);
+        finish_times[fields[1] + " " + fields[2]] = std::stoull(fields[5]);
+    }
+    ASSERT_EQ(finish_times.size(), 4);
+    EXPECT_LT(finish_times["100.0 a2a"], finish_times["50.0 a2a"]);
+    EXPECT_LT(finish_times["100.0 AllGather_8388608"], finish_times["50.0 AllGather_8388608"]);
+}
+
+TEST_F(TestNetworkAnalyticalCongestionAware, DependencyDrivenCollectives) {
+    /// setup
+    const auto ring = construct_topology(NetworkParser("../../input/Ring.yml"));
+    const auto npus_count = ring->get_npus_count();
+    const auto size = chunk_size * npus_count;
+    const auto run = [&](Collective& collective) {
+        const auto start_time = event_queue->get_current_time();
+        auto finish_time = static_cast<EventTime>(0);
+        collective.start([&]() { finish_time = event_queue->get_current_time(); });
+        event_queue->run();
+        EXPECT_TRUE(collective.finished());
+        return finish_time - start_time;
+    };
+
+    /// test: each algorithm unrolls into its steps, only released ones are live
+    auto ring_all_gather =
+        Collective(ring, Collective::Type::AllGather, Collective::Algorithm::Ring, size, chunk_size);
+    EXPECT_EQ(ring_all_gather.get_steps_count(), npus_count * (npus_count - 1));
+    ring_all_gather.start([]() {});
+    const auto live_steps_count = ring_all_gather.get_live_steps_count();
+    event_queue->run();
+    EXPECT_EQ(live_steps_count, npus_count);
+    EXPECT_TRUE(ring_all_gather.finished());
+
+    auto ring_all_reduce =
+        Collective(ring, Collective::Type::AllReduce, Collective::Algorithm::Ring, size, chunk_size);
+    EXPECT_EQ(ring_all_reduce.get_steps_count(), 2 * npus_count * (npus_count - 1));
+    const auto ring_all_reduce_time = run(ring_all_reduce);
+    EXPECT_GT(ring_all_reduce_time, 0);
+
+    // a finished collective runs again the same way
+    EXPECT_EQ(run(ring_all_reduce), ring_all_reduce_time);
+
+    auto halving_doubling = Collective(ring, Collective::Type::AllReduce, Collective::Algorithm::HalvingDoubling,
+                                       size, chunk_size);
+    EXPECT_EQ(halving_doubling.get_steps_count(), 2 * npus_count * 4);
+    EXPECT_GT(run(halving_doubling), 0);
+
+    auto tree = Collective(ring, Collective::Type::AllReduce, Collective::Algorithm::Tree, size, chunk_size);
+    EXPECT_EQ(tree.get_steps_count(), 2 * (npus_count - 1));
+    EXPECT_GT(run(tree), 0);
+
+    auto direct = Collective(ring, Collective::Type::AllToAll, Collective::Algorithm::Direct, size, chunk_size);
+    EXPECT_EQ(direct.get_steps_count(), npus_count * (npus_count - 1));
+    EXPECT_GT(run(direct), 0);
+
+    // hierarchical: a ring per dimension, so fewer steps than a flat ring over every NPU
+    const auto multi_dim = construct_topology(NetworkParser("../../input/Ring_FullyConnected_Switch.yml"));
+    const auto multi_dim_npus_count = multi_dim->get_npus_count();
+    auto steps_per_npu = 0;
+    for (const auto dim_npus_count : multi_dim->get_npus_count_per_dim()) {
+        steps_per_npu += 2 * (dim_npus_count - 1);
+    }
+    auto hierarchical = Collective(multi_dim, Collective::Type::AllReduce, Collective::Algorithm::Hierarchical,
+                                   chunk_size * multi_dim_npus_count, chunk_size);
+    EXPECT_EQ(hierarchical.get_steps_count(), multi_dim_npus_count * steps_per_npu);
+    EXPECT_GT(run(hierarchical), 0);
+}
+
+TEST_F(TestNetworkAnalyticalCongestionAware, StreamingTraceReplay) {
+    /// setup: time of a single transfer between neighbors
+    const auto network_parser = NetworkParser("../../input/Ring.yml");
+    const auto context = std::make_shared<SimulationContext>(std::make_shared<EventQueue>());
+    const auto topology = construct_topology(network_parser, context);
+    const auto npus_count = topology->get_npus_count();
+    topology->send_message(0, 1, chunk_size, chunk_size, []() {});
+    context->get_event_queue()->run();
+    const auto transfer_time = context->get_event_queue()->get_current_time();
+
+    // a chain of dependent transfers around the ring, and a late independent one
+    const auto chain_length = 64;
+    const auto late_issue_time = transfer_time * 100;
+    const auto trace_path = ::testing::TempDir() + "trace.bin";
+    {
+        auto writer = TraceWriter(trace_path);
+        for (auto i = 0; i < chain_length; i++) {
+            auto record = TraceRecord{0, i % npus_count, (i + 1) % npus_count, chunk_size, {}};
+            if (i > 0) {
+                record.dependencies.push_back(i - 1);
+            }
+            writer.write(record);
+        }
+        writer.write(TraceRecord{late_issue_time, 0, 1, chunk_size, {}});
+        ASSERT_TRUE(writer.close());
+    }
+
+    /// test: the chain is serialized through a window much smaller than the trace
+    const auto replay_context = std::make_shared<SimulationContext>(std::make_shared<EventQueue>());
+    auto replay = TraceReplay(construct_topology(network_parser, replay_context), trace_path, chunk_size, 4);
+    EXPECT_EQ(replay.run(), late_issue_time + transfer_time);
+    EXPECT_EQ(replay.get_completed_count(), chain_length + 1);
+    EXPECT_GE(replay_context->get_event_queue()->get_current_time(), chain_length * transfer_time);
+}
+
+TEST_F(TestNetworkAnalyticalCongestionAware, SyntheticTrafficPatterns) {
+    /// setup
+    const auto topology = construct_topology(NetworkParser("../../input/Ring.yml"));
+    const auto npus_count = topology->get_npus_count();
+    using Pattern = TrafficGenerator::Pattern;
+
+    /// test: deterministic patterns
+    auto bit_complement = TrafficGenerator(topology, Pattern::BitComplement, chunk_size);
+    EXPECT_EQ(bit_complement.get_destination(5), 10);
+    auto transpose = TrafficGenerator(topology, Pattern::Transpose, chunk_size);
+    EXPECT_EQ(transpose.get_destination(1), 4);
+    EXPECT_EQ(transpose.get_destination(5), 5);
+    auto permutation = TrafficGenerator(topology, Pattern::RandomPermutation, chunk_size, 7);
+    auto dests = std::set<DeviceId>();
+    for (auto npu = 0; npu < npus_count; npu++) {
+        EXPECT_NE(permutation.get_destination(npu), npu);
+        dests.insert(permutation.get_destination(npu));
+    }
+    EXPECT_EQ(dests.size(), npus_count);
+
+    /// test: skewed patterns
+    auto hotspot = TrafficGenerator(topology, Pattern::Hotspot, chunk_size);
+    hotspot.set_hotspot(3, 1.0);
+    EXPECT_EQ(hotspot.get_destination(0), 3);
+    auto moe = TrafficGenerator(topology, Pattern::MoeAllToAll, chunk_size);
+    moe.set_zipf_exponent(2.0);
+    auto expert_counts = std::vector<int>(npus_count, 0);
+    for (auto i = 0; i < 10'000; i++) {
+        expert_counts[moe.get_destination(0)]++;
+    }
+    EXPECT_GT(*std::max_element(expert_counts.begin(), expert_counts.end()), 5'000);
+
+    /// test: injection rate spaces out the chunks of each NPU
+    auto uniform = TrafficGenerator(topology, Pattern::UniformRandom, chunk_size);
+    const auto burst_time = uniform.run(8);
+    EXPECT_EQ(uniform.get_sent_chunks_count(), 8 * npus_count);
+    uniform.set_injection_rate(1.0);
+    const auto start_time = event_queue->get_current_time();
+    EXPECT_GE(uniform.run(8) - start_time, 7 * chunk_size);
+    EXPECT_GT(burst_time, 0);
+}
+
+TEST_F(TestNetworkAnalyticalCongestionAware, ExpanderGraphPrecomputedShortestPaths) {
+    /// setup
+    const auto npus_count = 16;
+    const auto inputfile = ::testing::TempDir() + "expander_graph_precompute.json";
+    write_circulant_expander_graph(inputfile, npus_count);
+    const auto searched = ExpanderGraph(npus_count, 50, 500, inputfile);
+    auto precomputed = ExpanderGraph(npus_count, 50, 500, inputfile);
+    precomputed.precompute_shortest_paths(4);
+    EXPECT_TRUE(precomputed.shortest_paths_precomputed());
+
+    /// test: table walks give shortest routes, as the search does
+    for (DeviceId i = 0; i < npus_count; i++) {
+        for (DeviceId j = 0; j < npus_count; j++) {
+            if (i == j) {
+                continue;
+            }
+            const auto distance = precomputed.get_distance(i, j, std::set<DeviceId>(), 0);
+            EXPECT_EQ(distance, searched.get_distance(i, j, std::set<DeviceId>(), 0));
+
+            const auto route = precomputed.route(i, j);
+            ASSERT_EQ(route.size(), distance + 1);
+            EXPECT_EQ(route.size(), searched.route(i, j).size());
+            EXPECT_EQ(route.front()->get_id(), i);
+            EXPECT_EQ(route.back()->get_id(), j);
+            for (auto it = route.begin(); std::next(it) != route.end(); it++) {
+                EXPECT_TRUE((*it)->connected((*std::next(it))->get_id()));
+            }
+        }
+    }
+}
+
+TEST_F(TestNetworkAnalyticalCongestionAware, ExpanderGraphKShortestPaths) {
+    /// setup
+    const auto npus_count = 16;
+    const auto inputfile = ::testing::TempDir() + "expander_graph_k_shortest_paths.json";
+    write_circulant_expander_graph(inputfile, npus_count);
+    std::remove((inputfile + ".ksp").c_str());
+
+    auto computed = ExpanderGraph(npus_count, 50, 500, inputfile, "RandomTopK");
+    computed.precompute_k_shortest_paths(4);
+    const auto paths = KShortestPaths(computed.get_graph(), npus_count, 16, 2);
+
+    /// test: up to k distinct paths per pair, sorted by length, starting with a shortest one
+    for (DeviceId i = 0; i < npus_count; i++) {
+        for (DeviceId j = 0; j < npus_count; j++) {
+            if (i == j) {
+                continue;
+            }
+            const auto paths_count = paths.get_paths_count(i, j);
+            ASSERT_GT(paths_count, 4);
+            EXPECT_LE(paths_count, 16);
+
+            auto known_paths = std::set<std::vector<uint16_t>>();
+            auto previous_length = static_cast<size_t>(0);
+            for (int p = 0; p < paths_count; p++) {
+                const auto [first, last] = paths.get_path(i, j, p);
+                const auto path = std::vector<uint16_t>(first, last);
+                EXPECT_TRUE(known_paths.insert(path).second);
+                EXPECT_GE(path.size(), previous_length);
+                previous_length = path.size();
+                EXPECT_EQ(path.front(), i);
+                EXPECT_EQ(path.back(), j);
+            }
+            const auto [first, last] = paths.get_path(i, j, 0);
+            EXPECT_EQ(last - first, computed.get_distance(i, j, std::set<DeviceId>(), 0) + 1);
+
+            // routes are picked among the precomputed paths
+            const auto route = computed.route(i, j);
+            EXPECT_EQ(route.front()->get_id(), i);
+            EXPECT_EQ(route.back()->get_id(), j);
+            for (auto it = route.begin(); std::next(it) != route.end(); it++) {
+                EXPECT_TRUE((*it)->connected((*std::next(it))->get_id()));
+            }
+        }
+    }
+
+    // the sidecar is reused by later runs, and rejected for another k
+    EXPECT_TRUE(std::ifstream(inputfile + ".ksp").good());
+    auto reloaded = ExpanderGraph(npus_count, 50, 500, inputfile, "RandomTopK");
+    reloaded.precompute_k_shortest_paths();
+    EXPECT_GE(reloaded.route(3, 11).size(), 2);
+
+    auto loaded = KShortestPaths();
+    EXPECT_FALSE(KShortestPaths::load(inputfile + ".ksp", 0, 16, loaded));
+    EXPECT_TRUE(loaded.empty());
+
+    EXPECT_TRUE(paths.save(inputfile + ".copy.ksp", 42));
+    EXPECT_FALSE(KShortestPaths::load(inputfile + ".copy.ksp", 42, 8, loaded));
+    ASSERT_TRUE(KShortestPaths::load(inputfile + ".copy.ksp", 42, 16, loaded));
+    for (DeviceId i = 0; i < npus_count; i++) {
+        for (DeviceId j = 0; j < npus_count; j++) {
+            ASSERT_EQ(loaded.get_paths_count(i, j), paths.get_paths_count(i, j));
+            for (int p = 0; p < paths.get_paths_count(i, j); p++) {
+                const auto [first, last] = paths.get_path(i, j, p);
+                const auto [loaded_first, loaded_last] = loaded.get_path(i, j, p);
+                EXPECT_TRUE(std::equal(first, last, loaded_first, loaded_last));
+            }
+        }
+    }
+}
+
+TEST_F(TestNetworkAnalyticalCongestionAware, AdaptiveRouting) {
+    /// setup
+    const auto npus_count = 16;
+    const auto inputfile = ::testing::TempDir() + "expander_graph_adaptive_routing.json";
+    write_circulant_expander_graph(inputfile, npus_count);
+
+    auto expander_graph = ExpanderGraph(npus_count, 50, 500, inputfile, "Adaptive");
+    auto fat_tree = FatTree(npus_count, 4, 50, 500, "Adaptive");
+    EXPECT_FALSE(expander_graph.has_static_routes());
+    EXPECT_FALSE(fat_tree.has_static_routes());
+    EXPECT_TRUE(ExpanderGraph(npus_count, 50, 500, inputfile).has_static_routes());
+
+    // id of the i-th device of a route
+    const auto hop = [](const Route& route, const int i) { return (*std::next(route.begin(), i))->get_id(); };
+
+    // queue chunks on a link: the first one is in transmission, the others are pending
+    const auto load_link = [](Topology& topology, const DeviceId src, const DeviceId dest) {
+        for (auto i = 0; i < 3; i++) {
+            auto link_route = Route{topology.get_device(src), topology.get_device(dest)};
+            topology.send(std::make_unique<Chunk>(1'000'000, link_route, callback, nullptr));
+        }
+    };
+
+    /// test: idle expander graph routes along a shortest path, and around a backlogged link
+    EXPECT_EQ(expander_graph.route(0, 1).size(), 2);
+    load_link(expander_graph, 0, 1);
+    EXPECT_EQ(expander_graph.get_device(0)
+                  ->get_link(expander_graph.get_device(0)->get_port(1))
+                  .get_pending_bytes(*expander_graph.get_simulation_context()),
+              2'000'000);
+    const auto detour = expander_graph.route(0, 1);
+    EXPECT_GT(detour.size(), 2);
+    EXPECT_NE(hop(detour, 1), 1);
+    event_queue->run();
+    EXPECT_EQ(expander_graph.route(0, 1).size(), 2);
+
+    /// test: fat tree picks the other spine of the pod (leaf 0 = device 16, spines 0 and 1 = devices 24, 25)
+    EXPECT_EQ(hop(fat_tree.route(0, 2), 2), 24);
+    load_link(fat_tree, 16, 24);
+    EXPECT_EQ(hop(fat_tree.route(0, 2), 2), 25);
+
+    // across pods, every hop of the route is a link
+    const auto route = fat_tree.route(0, 8);
+    ASSERT_EQ(route.size(), 7);
+    EXPECT_NE(hop(route, 2), 24);
+    for (auto it = route.begin(); std::next(it) != route.end(); it++) {
+        EXPECT_TRUE((*it)->connected((*std::next(it))->get_id()));
+    }
+    event_queue->run();
+    EXPECT_EQ(hop(fat_tree.route(0, 2), 2), 24);
+}
+
+TEST_F(TestNetworkAnalyticalCongestionAware, FatTreeEcmpAndSpraying) {
+    /// setup: k = 4, leaves are devices 16-23, spines 24-31, cores 32-35
+    const auto npus_count = 16;
+    auto ecmp = FatTree(npus_count, 4, 50, 500, "ECMP");
+    auto spray = FatTree(npus_count, 4, 50, 500, "Spray");
+    EXPECT_TRUE(ecmp.has_static_routes());
+    EXPECT_FALSE(spray.has_static_routes());
+
+    // core of a route across pods
+    const auto core = [](const Route& route) {
+        EXPECT_EQ(route.size(), 7);
+        return (*std::next(route.begin(), 3))->get_id();
+    };
+
+    /// test: a flow always takes the same valid path, and flows spread over every core
+    auto ecmp_cores = std::set<DeviceId>();
+    for (uint64_t flow_id = 0; flow_id < 64; flow_id++) {
+        const auto route = ecmp.route(0, 8, flow_id);
+        EXPECT_EQ(core(route), core(ecmp.route(0, 8, flow_id)));
+        for (auto it = route.begin(); std::next(it) != route.end(); it++) {
+            EXPECT_TRUE((*it)->connected((*std::next(it))->get_id()));
+        }
+        ecmp_cores.insert(core(route));
+    }
+    EXPECT_EQ(ecmp_cores.size(), 4);
+    EXPECT_EQ(core(ecmp.route(0, 8)), core(ecmp.route(0, 8, 0)));
+
+    /// test: successive routes are sprayed round-robin over the 4 core paths
+    auto sprayed_cores = std::vector<DeviceId>();
+    for (auto i = 0; i < 8; i++) {
+        sprayed_cores.push_back(core(spray.route(0, 8)));
+    }
+    EXPECT_EQ(std::set<DeviceId>(sprayed_cores.begin(), sprayed_cores.begin() + 4).size(), 4);
+    EXPECT_TRUE(std::equal(sprayed_cores.begin(), sprayed_cores.begin() + 4, sprayed_cores.begin() + 4));
+
+    // chunks of a message take every path, and the message still arrives
+    auto arrived = false;
+    spray.send_message(0, 8, 8'000'000, 1'000'000, EventCallback([&arrived] { arrived = true; }));
+    event_queue->run();
+    EXPECT_TRUE(arrived);
+}
+
+TEST_F(TestNetworkAnalyticalCongestionAware, FatTreeLargeRadix) {
+    /// setup: k=48 fat tree, fully subscribed (27648 NPUs)
+    const auto k = 48;
+    const auto npus_count = (k * k * k) / 4;
+    auto fat_tree = FatTree(npus_count, k, 50, 500);
+    EXPECT_EQ(fat_tree.get_devices_count(), npus_count + (k * k) + ((k / 2) * (k / 2)));
+
+    /// test: switches are derived from the id offsets
+    const auto leaf_offset = npus_count;
+    const auto spine_offset = leaf_offset + ((k * k) / 2);
+    const auto core_offset = spine_offset + ((k * k) / 2);
+    const auto route = fat_tree.route(0, npus_count - 1);
+    const auto hops = std::vector<std::shared_ptr<Device>>(route.begin(), route.end());
+    ASSERT_EQ(hops.size(), 7);
+    EXPECT_EQ(hops[1]->get_id(), leaf_offset);
+    EXPECT_GE(hops[2]->get_id(), spine_offset);
+    EXPECT_LT(hops[2]->get_id(), spine_offset + (k / 2));
+    EXPECT_GE(hops[3]->get_id(), core_offset);
+    EXPECT_EQ(hops[5]->get_id(), spine_offset - 1);
+
+    /// test: a chunk crosses the tree in 6 hops
+    fat_tree.send(std::make_unique<Chunk>(chunk_size, route, callback, nullptr));
+    event_queue->run();
+    const auto delay = hops[0]->get_link(0).serialization_delay(chunk_size) + 500;
+    EXPECT_EQ(event_queue->get_current_time(), 6 * delay);
+}
+
+TEST_F(TestNetworkAnalyticalCongestionAware, MultiDimTopologyMaterializedLinks) {
+    /// setup: [4, 3, 2] = Ring x FullyConnected x Switch
+    auto topology = MultiDimTopology();
+    topology.append_dimension(std::make_unique<Ring>(4, 50, 500));
+    auto outer_dims = std::vector<std::unique_ptr<BasicTopology>>();
+    outer_dims.push_back(std::make_unique<FullyConnected>(3, 50, 500));
+    outer_dims.push_back(std::make_unique<Switch>(2, 50, 500));
+    topology.append_dimensions(std::move(outer_dims));
+    ASSERT_EQ(topology.get_npus_count(), 24);
+    topology.validate();
+
+    auto ports_count = 0;
+    for (DeviceId i = 0; i < 24; i++) {
+        ports_count += topology.get_device(i)->get_ports_count();
+    }
+
+    /// test: addresses come from the strides [1, 4, 12]
+    const auto address = topology.translate_address(23);
+    EXPECT_EQ(address[0], 3);
+    EXPECT_EQ(address[1], 2);
+    EXPECT_EQ(address[2], 1);
+
+    /// test: routes follow existing links in dimension order, and connect nothing
+    for (DeviceId src = 0; src < 24; src++) {
+        for (DeviceId dest = 0; dest < 24; dest++) {
+            if (src == dest) {
+                continue;
+            }
+            const auto route = topology.route(src, dest);
+            EXPECT_EQ(route.front()->get_id(), src);
+            EXPECT_EQ(route.back()->get_id(), dest);
+            for (auto it = route.begin(); std::next(it) != route.end(); it++) {
+                EXPECT_TRUE((*it)->connected((*std::next(it))->get_id()));
+            }
+        }
+    }
+    EXPECT_EQ(topology.route(0, 2).size(), 3);
+    EXPECT_EQ(topology.route(0, 8).size(), 2);
+
+    auto routed_ports_count = 0;
+    for (DeviceId i = 0; i < 24; i++) {
+        routed_ports_count += topology.get_device(i)->get_ports_count();
+    }
+    EXPECT_EQ(routed_ports_count, ports_count);
+}
+
+TEST_F(TestNetworkAnalyticalCongestionAware, MultiDimTopologyDimOrder) {
+    /// setup: [4, 4] = FullyConnected x FullyConnected, with the order read from a config
+    const auto config = ::testing::TempDir() + "multi_dim_adaptive_order.yml";
+    {
+        auto file = std::ofstream(config);
+        file << "topology: [ FullyConnected, FullyConnected ]\nnpus_count: [ 4, 4 ]\n"
+             << "bandwidth: [ 50.0, 50.0 ]\nlatency: [ 500.0, 500.0 ]\ndim_order: [ adaptive ]\n";
+    }
+    const auto network_parser = NetworkParser(config);
+    EXPECT_EQ(network_parser.get_dim_order(), "adaptive");
+    const auto topology = construct_topology(network_parser);
+    EXPECT_FALSE(topology->has_static_routes());
+
+    /// test: static and reverse orders pick opposite dimensions first
+    auto ordered = MultiDimTopology();
+    ordered.append_dimension(std::make_unique<FullyConnected>(4, 50, 500));
+    ordered.append_dimension(std::make_unique<FullyConnected>(4, 50, 500));
+    EXPECT_EQ((*std::next(ordered.route(0, 5).begin()))->get_id(), 1);
+    ordered.set_dim_order(MultiDimTopology::DimOrder::Reverse);
+    EXPECT_TRUE(ordered.has_static_routes());
+    EXPECT_EQ((*std::next(ordered.route(0, 5).begin()))->get_id(), 4);
+
+    /// test: an idle adaptive network routes in static order
+    EXPECT_EQ((*std::next(topology->route(0, 5).begin()))->get_id(), 1);
+
+    /// test: a backlog on the dim-0 link turns the route to dim 1
+    for (auto i = 0; i < 4; i++) {
+        topology->send(0, 1, chunk_size, callback, nullptr);
+    }
+    const auto route = topology->route(0, 5);
+    EXPECT_EQ(route.size(), 3);
+    EXPECT_EQ((*std::next(route.begin()))->get_id(), 4);
+    EXPECT_EQ(route.back()->get_id(), 5);
+    event_queue->run();
+}
+
+TEST_F(TestNetworkAnalyticalCongestionAware, RouteCacheCapacity) {
+    /// setup: same network as Ring.yml, with a 1 MB route cache
+    const auto config = ::testing::TempDir() + "ring_with_route_cache.yml";
+    {
+        auto file = std::ofstream(config);
+        file << "topology: [ Ring ]\nnpus_count: [ 16 ]\nbandwidth: [ 50.0 ]\nlatency: [ 500.0 ]\n"
+             << "route_cache_capacity_mb: [ 1 ]\n";
+    }
+    const auto network_parser = NetworkParser(config);
+    EXPECT_EQ(network_parser.get_route_cache_capacity_mb(), 1);
+    const auto topology = construct_topology(network_parser);
+    const auto npus_count = topology->get_npus_count();
+
+    // leave room for a single route
+    topology->set_route_cache_capacity(1);
+
+    /// Run All-Gather, with every route but the first built on the fly
+    for (int i = 0; i < npus_count; i++) {
+        for (int j = 0; j < npus_count; j++) {
+            if (i != j) {
+                topology->send(i, j, chunk_size, callback, nullptr);
+            }
+        }
+    }
+    const auto cache_bytes = topology->get_route_cache_bytes();
+    EXPECT_GT(cache_bytes, 0);
+    topology->send_message(2, 5, 4 * chunk_size, chunk_size, callback, nullptr);
+    EXPECT_EQ(topology->get_route_cache_bytes(), cache_bytes);
+    event_queue->run();
+
+    /// test: the cache only changes the cost of routing
+    const auto reference = construct_topology(NetworkParser("../../input/Ring.yml"));
+    reference->set_simulation_context(std::make_shared<SimulationContext>(std::make_shared<EventQueue>()));
+    auto* const reference_queue = reference->get_simulation_context()->get_event_queue();
+    for (int i = 0; i < npus_count; i++) {
+        for (int j = 0; j < npus_count; j++) {
+            if (i != j) {
+                reference->send(i, j, chunk_size, callback, nullptr);
+            }
+        }
+    }
+    reference->send_message(2, 5, 4 * chunk_size, chunk_size, callback, nullptr);
+    reference_queue->run();
+    EXPECT_EQ(event_queue->get_current_time(), reference_queue->get_current_time());
+}
+
+TEST_F(TestNetworkAnalyticalCongestionAware, HotPathStats) {
+    /// setup: two chunks competing for link 0 -> 1
+    const auto topology = construct_topology(NetworkParser("../../input/Ring.yml"));
+    topology->send(0, 1, chunk_size, callback, nullptr);
+    topology->send(0, 1, chunk_size, callback, nullptr);
+    event_queue->run();
+
+    /// test: counters are dumped only when compiled in
+    auto out = std::ostringstream();
+#ifdef ASTRA_NET_STATS
+    ASSERT_TRUE(topology->dump_stats(out));
+
+    const auto& queue_stats = event_queue->get_stats();
+    EXPECT_GT(queue_stats.events_count, 0);
+    EXPECT_LE(queue_stats.event_times_count, queue_stats.events_count);
+    auto callbacks_count = static_cast<uint64_t>(0);
+    for (const auto& [type_id, count] : queue_stats.callback_counts) {
+        callbacks_count += count;
+    }
+    EXPECT_EQ(callbacks_count, queue_stats.events_count);
+
+    // the second chunk waits for the first one to be serialized
+    auto& context = *topology->get_simulation_context();
+    const auto& link_stats = topology->get_device(0)->get_link(topology->get_device(0)->get_port(1)).get_stats(context);
+    EXPECT_EQ(link_stats.chunks_count, 2);
+    EXPECT_EQ(link_stats.bytes, 2 * chunk_size);
+    EXPECT_EQ(link_stats.max_queue_depth, 1);
+    EXPECT_EQ(link_stats.queueing_delay_histogram[0], 1);
+    EXPECT_EQ(link_stats.busy_time, event_queue->get_current_time() - 500);
+    EXPECT_NE(out.str().find("link,0,1,2097152,2,"), std::string::npos);
+
+    // reset clears the counters
+    topology->reset();
+    EXPECT_EQ(topology->get_device(0)->get_link(topology->get_device(0)->get_port(1)).get_stats(context).chunks_count,
+              0);
+#else
+    // only the memory is written
+    EXPECT_FALSE(topology->dump_stats(out));
+    EXPECT_EQ(out.str().find("\nevent_queue,"), std::string::npos);
+    EXPECT_NE(out.str().find("memory,total,"), std::string::npos);
+#endif
+}
+
+TEST_F(TestNetworkAnalyticalCongestionAware, ChunkTrace) {
+    /// setup: trace every other chunk, with tiny buffers so the writer thread swaps them
+    const auto topology = construct_topology(NetworkParser("../../input/Ring.yml"));
+    const auto path = ::testing::TempDir() + "chunk_trace.json";
+    auto chunk_tracer = std::make_shared<ChunkTracer>(path, 2, 4);
+    topology->get_simulation_context()->set_chunk_tracer(chunk_tracer);
+
+    /// test: 4 chunks over 3 links, 2 of them traced
+    for (auto i = 0; i < 4; i++) {
+        topology->send(0, 3, chunk_size, callback, nullptr);
+    }
+    event_queue->run();
+
+    // traced chunks: inject, completion, and (enqueue, transmit start, arrival) per link
+    EXPECT_EQ(chunk_tracer->get_records_count(), 2 * (2 + (3 * 3)));
+
+    // the tracer writes the file out when dropped
+    topology->get_simulation_context()->set_chunk_tracer(nullptr);
+    chunk_tracer.reset();
+    auto file = std::ifstream(path);
+    const auto trace = std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    const auto count = [&trace](const std::string& pattern) {
+        auto occurrences = 0;
+        for (auto position = trace.find(pattern); position != std::string::npos;
+             position = trace.find(pattern, position + 1)) {
+            occurrences++;
+        }
+        return occurrences;
+    };
+    EXPECT_EQ(trace.rfind("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", 0), 0);
+    EXPECT_EQ(trace.substr(trace.size() - 4), "\n]}\n");
+    EXPECT_EQ(count("\"ph\":\"b\""), 2);
+    EXPECT_EQ(count("\"ph\":\"e\""), 2);
+    EXPECT_EQ(count("\"ph\":\"X\""), 6);
+    EXPECT_EQ(count("\"thread_name\""), 3);
+    EXPECT_NE(trace.find("\"name\":\"chunk 3\""), std::string::npos);
+    EXPECT_EQ(trace.find("\"name\":\"chunk 2\""), std::string::npos);
+    std::remove(path.c_str());
+}
+
+TEST_F(TestNetworkAnalyticalCongestionAware, ImplicitRoutes) {
+    /// setup
+    const auto topologies = std::vector<std::shared_ptr<Topology>>{std::make_shared<Ring>(64, 50, 500, true),
+                                                                   std::make_shared<Ring>(9, 50, 500, false),
+                                                                   std::make_shared<Switch>(8, 50, 500),
+                                                                   std::make_shared<FullyConnected>(8, 50, 500)};
+
+    /// test: described routes are the routes of route()
+    for (const auto& topology : topologies) {
+        const auto npus_count = topology->get_npus_count();
+        for (auto src = 0; src < npus_count; src++) {
+            for (auto dest = 0; dest < npus_count; dest++) {
+                if (src == dest) {
+                    continue;
+                }
+                auto route_descriptor = RouteDescriptor();
+                ASSERT_TRUE(topology->describe_route(src, dest, route_descriptor));
+                const auto chunk = Chunk(chunk_size, route_descriptor, EventCallback([] {}));
+                const auto route = topology->route(src, dest);
+                ASSERT_EQ(chunk.get_hops_count(), route.size());
+                auto index = static_cast<size_t>(0);
+                for (auto it = route.begin(); it != route.end(); it++, index++) {
+                    const auto hop = chunk.get_hop(index);
+                    EXPECT_EQ(hop.device, it->get());
+                    const auto next = std::next(it);
+                    EXPECT_EQ(hop.port, (next == route.end()) ? -1 : (*it)->get_port((*next)->get_id()));
+                }
+            }
+        }
+    }
+
+    /// test: long routes are computed hop by hop, instead of being cached
+    const auto& ring = topologies[0];
+    ring->send(0, 32, chunk_size, callback, nullptr);
+    ring->send_message(1, 40, 4 * chunk_size, chunk_size, callback, nullptr);
+    EXPECT_EQ(ring->get_route_cache_bytes(), 0);
+    ring->send(0, 3, chunk_size, callback, nullptr);
+    EXPECT_GT(ring->get_route_cache_bytes(), 0);
+    event_queue->run();
+
+    // same timing as stored routes
+    const auto reference = std::make_shared<Ring>(64, 50, 500, true);
+    reference->set_simulation_context(std::make_shared<SimulationContext>(std::make_shared<EventQueue>()));
+    auto* const reference_queue = reference->get_simulation_context()->get_event_queue();
+    reference->send(std::make_unique<Chunk>(chunk_size, reference->route(0, 32), callback, nullptr));
+    for (auto i = 0; i < 4; i++) {
+        reference->send(std::make_unique<Chunk>(chunk_size, reference->route(1, 40), callback, nullptr));
+    }
+    reference->send(std::make_unique<Chunk>(chunk_size, reference->route(0, 3), callback, nullptr));
+    reference_queue->run();
+    EXPECT_EQ(event_queue->get_current_time(), reference_queue->get_current_time());
+}
+
+TEST_F(TestNetworkAnalyticalCongestionAware, LazyLinks) {
+    /// setup: large enough to connect lazily
+    const auto topology = std::make_shared<FullyConnected>(128, 50, 500);
+    EXPECT_EQ(topology->get_materialized_links_count(), 0);
+
+    /// test: ports are computed, skipping the device itself
+    const auto device = topology->get_device(5);
+    EXPECT_EQ(device->get_ports_count(), 127);
+    EXPECT_EQ(device->get_port(5), -1);
+    for (auto port = 0; port < device->get_ports_count(); port++) {
+        EXPECT_EQ(device->get_port(device->get_port_dest(port)), port);
+    }
+    EXPECT_EQ(device->get_port_dest(4), 4);
+    EXPECT_EQ(device->get_port_dest(5), 6);
+    EXPECT_EQ(topology->get_materialized_links_count(), 0);
+
+    /// test: links are created on first use, with the timing of eager links
+    topology->send(0, 5, chunk_size, callback, nullptr);
+    topology->send(0, 5, chunk_size, callback, nullptr);
+    topology->send(3, 100, chunk_size, callback, nullptr);
+    EXPECT_EQ(topology->get_materialized_links_count(), 2);
+    event_queue->run();
+
+    const auto reference = std::make_shared<FullyConnected>(8, 50, 500);
+    reference->set_simulation_context(std::make_shared<SimulationContext>(std::make_shared<EventQueue>()));
+    reference->send(0, 5, chunk_size, callback, nullptr);
+    reference->send(0, 5, chunk_size, callback, nullptr);
+    reference->send(3, 6, chunk_size, callback, nullptr);
+    reference->get_simulation_context()->get_event_queue()->run();
+    EXPECT_EQ(event_queue->get_current_time(), reference->get_simulation_context()->get_event_queue()->get_current_time());
+
+    /// test: idle links can be dropped
+    EXPECT_EQ(topology->release_idle_links(), 2);
+    EXPECT_EQ(topology->get_materialized_links_count(), 0);
+
+    /// test: a large fully-connected dimension is connected lazily too
+    auto multi_dim = MultiDimTopology();
+    multi_dim.append_dimension(std::make_unique<Ring>(4, 50, 500));
+    multi_dim.append_dimension(std::make_unique<FullyConnected>(64, 50, 500));
+    multi_dim.validate();
+    EXPECT_EQ(multi_dim.get_materialized_links_count(), 256 * 2);
+    EXPECT_EQ(multi_dim.get_device(1)->get_ports_count(), 2 + 63);
+    EXPECT_TRUE(multi_dim.get_device(1)->connected(1 + (4 * 63)));
+    multi_dim.send(1, 2 + (4 * 10), chunk_size, callback, nullptr);
+    event_queue->run();
+    EXPECT_EQ(multi_dim.get_materialized_links_count(), (256 * 2) + 1);
+}
+
+TEST_F(TestNetworkAnalyticalCongestionAware, Torus) {
+    /// setup: 4x4x4 torus, and the same torus stacked from Ring dimensions
+    const auto topology = construct_topology(NetworkParser("../../input/Torus.yml"));
+    ASSERT_NE(std::dynamic_pointer_cast<Torus>(topology), nullptr);
+    EXPECT_EQ(topology->get_npus_count(), 64);
+    EXPECT_EQ(topology->get_devices_count(), 64);
+    EXPECT_EQ(topology->get_npus_count_per_dim(), std::vector<int>({4, 4, 4}));
+
+    auto rings = MultiDimTopology();
+    for (auto dim = 0; dim < 3; dim++) {
+        rings.append_dimension(std::make_unique<Ring>(4, 50, 500));
+    }
+    rings.set_simulation_context(std::make_shared<SimulationContext>(std::make_shared<EventQueue>()));
+
+    /// test: every NPU has 2 links per dimension, and routes are as long as over the stacked rings
+    for (auto npu = 0; npu < 64; npu++) {
+        EXPECT_EQ(topology->get_device(npu)->get_ports_count(), 6);
+    }
+    for (auto src = 0; src < 64; src++) {
+        for (auto dest = 0; dest < 64; dest++) {
+            const auto route = topology->route(src, dest);
+            EXPECT_EQ(route.size(), rings.route(src, dest).size());
+            EXPECT_EQ(route.front()->get_id(), src);
+            EXPECT_EQ(route.back()->get_id(), dest);
+        }
+    }
+
+    /// test: a chunk takes as long as over the stacked rings
+    topology->send(0, 63, chunk_size, callback, nullptr);
+    event_queue->run();
+    rings.send(0, 63, chunk_size, callback, nullptr);
+    rings.get_simulation_context()->get_event_queue()->run();
+    EXPECT_EQ(event_queue->get_current_time(), rings.get_simulation_context()->get_event_queue()->get_current_time());
+
+    /// test: a 2-NPU dimension is a single bidirectional link
+    auto torus = Torus({2, 3}, 50, 500);
+    EXPECT_EQ(torus.get_device(0)->get_ports_count(), 3);
+    EXPECT_EQ(torus.route(0, 5).size(), 3);
+}
+
+TEST_F(TestNetworkAnalyticalCongestionAware, Dragonfly) {
+    /// setup: 4 routers per group, 2 NPUs and 2 global links per router
+    const auto topology = construct_topology(NetworkParser("../../input/Dragonfly.yml"));
+    ASSERT_NE(std::dynamic_pointer_cast<Dragonfly>(topology), nullptr);
+    EXPECT_EQ(topology->get_npus_count(), 72);
+    EXPECT_EQ(topology->get_devices_count(), 72 + 36);
+
+    // number of groups a route visits
+    const auto groups_visited = [](const Route& route, const int npus_count = 72) {
+        auto groups = std::set<int>();
+        for (const auto& device : route) {
+            const auto id = device->get_id();
+            groups.insert(((id < npus_count) ? id / 2 : id - npus_count) / 4);
+        }
+        return static_cast<int>(groups.size());
+    };
+
+    for (const auto* const arrangement : {"Absolute", "Relative", "Circulant"}) {
+        for (const auto groups_count : {9, 6}) {
+            const auto npus_count = groups_count * 8;
+            auto minimal = Dragonfly(groups_count, 4, 2, 2, 50, 500, arrangement, "Minimal");
+            auto valiant = Dragonfly(groups_count, 4, 2, 2, 50, 500, arrangement, "Valiant");
+
+            /// test: every pair of groups is joined by exactly one global link
+            for (auto group = 0; group < groups_count; group++) {
+                auto peer_groups = std::set<int>();
+                for (auto port = 0; port < 8; port++) {
+                    const auto peer_group = minimal.get_peer_group(group, port);
+                    if (peer_group >= 0) {
+                        EXPECT_TRUE(peer_groups.insert(peer_group).second);
+                        EXPECT_EQ(minimal.get_gateway_port(group, peer_group), port);
+                    }
+                }
+                EXPECT_EQ(peer_groups.size(), groups_count - 1);
+            }
+
+            /// test: routes only take links, minimal ones at most one global link
+            for (auto src = 0; src < npus_count; src++) {
+                for (auto dest = 0; dest < npus_count; dest++) {
+                    if (src == dest) {
+                        continue;
+                    }
+                    const auto minimal_route = minimal.route(src, dest);
+                    const auto valiant_route = valiant.route(src, dest);
+                    for (const auto* const route : {&minimal_route, &valiant_route}) {
+                        EXPECT_EQ(route->front()->get_id(), src);
+                        EXPECT_EQ(route->back()->get_id(), dest);
+                        for (auto it = route->begin(); std::next(it) != route->end(); it++) {
+                            EXPECT_TRUE((*it)->connected((*std::next(it))->get_id()));
+                        }
+                    }
+                    const auto same_group = (src / 8) == (dest / 8);
+                    EXPECT_LE(minimal_route.size(), 6);
+                    EXPECT_EQ(groups_visited(minimal_route, npus_count), same_group ? 1 : 2);
+                    EXPECT_EQ(groups_visited(valiant_route, npus_count), same_group ? 1 : 3);
+                }
+            }
+        }
+    }
+
+    /// test: UGAL routes minimally when idle, and detours once the minimal route is backlogged
+    auto ugal = Dragonfly(9, 4, 2, 2, 50, 500, "Absolute", "UGAL");
+    EXPECT_EQ(ugal.route(0, 71).size(), Dragonfly(9, 4, 2, 2, 50, 500).route(0, 71).size());
+    const auto minimal_route = ugal.route(0, 71);
+    const auto global_link = Route(std::next(minimal_route.begin(), 2), std::next(minimal_route.begin(), 4));
+    for (auto i = 0; i < 64; i++) {
+        ugal.send(std::make_unique<Chunk>(chunk_size, global_link, callback, nullptr));
+    }
+    EXPECT_EQ(groups_visited(ugal.route(0, 71)), 3);
+    event_queue->run();
+}
+
+TEST_F(TestNetworkAnalyticalCongestionAware, ConcurrentRoutes) {
+    /// setup: searched (not precomputed) expander graph routes, and reference routes computed serially
+    const auto npus_count = 32;
+    const auto inputfile = ::testing::TempDir() + "expander_graph_concurrent_routes.json";
+    write_circulant_expander_graph(inputfile, npus_count);
+    std::remove((inputfile + ".ksp").c_str());
+    const auto shortest = ExpanderGraph(npus_count, 50, 500, inputfile);
+    const auto random_topk = ExpanderGraph(npus_count, 50, 500, inputfile, "RandomTopK");
+    const auto valiant = Dragonfly(9, 4, 2, 2, 50, 500, "Absolute", "Valiant");
+    const auto reference_shortest = ExpanderGraph(npus_count, 50, 500, inputfile);
+    const auto reference_random_topk = ExpanderGraph(npus_count, 50, 500, inputfile, "RandomTopK");
+
+    // ids of a route
+    const auto ids = [](const Route& route) {
+        auto route_ids = std::vector<DeviceId>();
+        for (const auto& device : route) {
+            route_ids.push_back(device->get_id());
+        }
+        return route_ids;
+    };
+
+    /// test: threads routing every pair at once, each with its own random stream,
+    /// get the routes a single caller gets with the same stream
+    const auto threads_count = 8;
+    auto routes = std::vector<std::vector<std::vector<DeviceId>>>(threads_count);
+    auto threads = std::vector<std::thread>();
+    for (auto t = 0; t < threads_count; t++) {
+        threads.emplace_back([&, t] {
+            auto rng = CounterRng(t, 0, 0, 0);
+            for (auto src = 0; src < npus_count; src++) {
+                for (auto dest = 0; dest < npus_count; dest++) {
+                    if (src != dest) {
+                        routes[t].push_back(ids(shortest.route(src, dest)));
+                        EXPECT_EQ(routes[t].back().size(), shortest.get_distance(src, dest, std::set<DeviceId>(), 0) + 1);
+                        routes[t].push_back(ids(random_topk.route(src, dest, rng)));
+                        routes[t].push_back(ids(valiant.route(src, dest, rng)));
+                    }
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    for (auto t = 0; t < threads_count; t++) {
+        auto rng = CounterRng(t, 0, 0, 0);
+        auto i = static_cast<size_t>(0);
+        for (auto src = 0; src < npus_count; src++) {
+            for (auto dest = 0; dest < npus_count; dest++) {
+                if (src != dest) {
+                    EXPECT_EQ(routes[t][i++], ids(reference_shortest.route(src, dest)));
+                    EXPECT_EQ(routes[t][i++], ids(reference_random_topk.route(src, dest, rng)));
+                    EXPECT_EQ(routes[t][i++], ids(valiant.route(src, dest, rng)));
+                }
+            }
+        }
+    }
+}
+
+TEST_F(TestNetworkAnalyticalCongestionAware, PrecomputeRoutes) {
+    /// setup: a Ring of FatTrees with every route precomputed, and the same network routed on demand
+    const auto config = ::testing::TempDir() + "ring_fattree_precompute_routes.yml";
+    {
+        auto file = std::ofstream(config);
+        file << "topology: [ Ring, FatTree ]\nnpus_count: [ 4, 16 ]\nbandwidth: [ 50.0, 25.0 ]\n"
+             << "latency: [ 500.0, 100.0 ]\nfattree_radix: [ 4, 4 ]\nprecompute_routes: true\n";
+    }
+    const auto network_parser = NetworkParser(config);
+    EXPECT_TRUE(network_parser.get_precompute_routes());
+    const auto topology = construct_topology(network_parser);
+    const auto npus_count = topology->get_npus_count();
+    const auto cache_bytes = topology->get_route_cache_bytes();
+    EXPECT_GT(cache_bytes, 0);
+
+    /// test: precomputed routes are the routes of route()
+    for (int i = 0; i < npus_count; i++) {
+        for (int j = 0; j < npus_count; j++) {
+            if (i == j) {
+                continue;
+            }
+            const auto route = topology->route(i, j);
+            const auto& route_hops = topology->get_route_hops(i, j);
+            ASSERT_EQ(route_hops.size(), route.size());
+            auto hop = route_hops.begin();
+            for (const auto& device : route) {
+                EXPECT_EQ((hop++)->device, device.get());
+            }
+        }
+    }
+
+    /// test: All-Gather routes no new pair, and takes as long as on demand
+    for (int i = 0; i < npus_count; i++) {
+        for (int j = 0; j < npus_count; j++) {
+            if (i != j) {
+                topology->send(i, j, chunk_size, callback, nullptr);
+            }
+        }
+    }
+    event_queue->run();
+    EXPECT_EQ(topology->get_route_cache_bytes(), cache_bytes);
+
+    auto reference = std::make_shared<MultiDimTopology>();
+    auto dims = std::vector<std::unique_ptr<BasicTopology>>();
+    dims.push_back(std::make_unique<Ring>(4, 50, 500));
+    dims.push_back(std::make_unique<FatTree>(16, 4, 25, 100));
+    reference->append_dimensions(std::move(dims));
+    reference->set_simulation_context(std::make_shared<SimulationContext>(std::make_shared<EventQueue>()));
+    auto* const reference_queue = reference->get_simulation_context()->get_event_queue();
+    for (int i = 0; i < npus_count; i++) {
+        for (int j = 0; j < npus_count; j++) {
+            if (i != j) {
+                reference->send(i, j, chunk_size, callback, nullptr);
+            }
+        }
+    }
+    reference_queue->run();
+    EXPECT_EQ(event_queue->get_current_time(), reference_queue->get_current_time());
+
+    /// test: expander graphs precompute their tables first, and random routes aren't precomputed
+    const auto inputfile = ::testing::TempDir() + "expander_graph_precompute_routes.json";
+    write_circulant_expander_graph(inputfile, 16);
+    std::remove((inputfile + ".ksp").c_str());
+    auto shortest = ExpanderGraph(16, 50, 500, inputfile);
+    shortest.precompute_routes(4);
+    EXPECT_TRUE(shortest.shortest_paths_precomputed());
+    EXPECT_GT(shortest.get_route_cache_bytes(), 0);
+    auto random_topk = ExpanderGraph(16, 50, 500, inputfile, "RandomTopK");
+    random_topk.precompute_routes(4);
+    EXPECT_EQ(random_topk.get_route_cache_bytes(), 0);
+}
+
+TEST_F(TestNetworkAnalyticalCongestionAware, SimulationFork) {
+    // All-to-All warm-up on a Ring
+    const auto warm_up = [this](Topology& topology) {
+        for (int i = 0; i < topology.get_npus_count(); i++) {
+            for (int j = 0; j < topology.get_npus_count(); j++) {
+                if (i != j) {
+                    topology.send(i, j, chunk_size, callback, nullptr);
+                }
+            }
+        }
+    };
+    const auto make_reference = [] {
+        const auto reference = construct_topology(NetworkParser("../../input/Ring.yml"));
+        reference->set_simulation_context(std::make_shared<SimulationContext>(std::make_shared<EventQueue>()));
+        return reference;
+    };
+
+    /// setup: checkpoint halfway through the warm-up
+    const auto warm_up_reference = make_reference();
+    warm_up(*warm_up_reference);
+    warm_up_reference->get_simulation_context()->get_event_queue()->run();
+    const auto warm_up_time = warm_up_reference->get_simulation_context()->get_event_queue()->get_current_time();
+
+    const auto topology = construct_topology(NetworkParser("../../input/Ring.yml"));
+    warm_up(*topology);
+    auto simulation_fork = SimulationFork(topology);
+    const auto checkpoint_time = simulation_fork.checkpoint(warm_up_time / 2);
+    EXPECT_EQ(checkpoint_time, warm_up_time / 2);
+
+    /// test: variant v sends (v + 1) chunks from 0 to 8 at the checkpoint,
+    /// and finishes as a simulation of the warm-up and the variant from scratch does
+    const auto variants_count = 4;
+    const auto setup = [](const int variant, void* const arg) {
+        static_cast<Topology*>(arg)->send_message(0, 8, (variant + 1) * 1'048'576, 1'048'576, callback, nullptr);
+    };
+    const auto report = [](const int variant, void* const arg) {
+        return std::to_string(variant) + ":" + std::to_string(static_cast<Topology*>(arg)->get_npus_count());
+    };
+    const auto results = simulation_fork.fork(variants_count, setup, topology.get(), report, 2);
+    ASSERT_EQ(results.size(), variants_count);
+    for (auto variant = 0; variant < variants_count; variant++) {
+        const auto reference = make_reference();
+        warm_up(*reference);
+        reference->get_simulation_context()->get_event_queue()->run_until(checkpoint_time);
+        reference->send_message(0, 8, (variant + 1) * chunk_size, chunk_size, callback, nullptr);
+        reference->get_simulation_context()->get_event_queue()->run();
+
+        EXPECT_TRUE(results[variant].completed);
+        EXPECT_EQ(results[variant].finish_time, reference->get_simulation_context()->get_event_queue()->get_current_time());
+        EXPECT_EQ(results[variant].report, std::to_string(variant) + ":16");
+    }
+    EXPECT_GT(results[variants_count - 1].finish_time, results[0].finish_time);
+
+    /// test: the simulation itself stays at the checkpoint, and resumes as if never forked
+    EXPECT_EQ(event_queue->get_current_time(), checkpoint_time);
+    EXPECT_FALSE(event_queue->finished());
+    event_queue->run();
+    EXPECT_EQ(event_queue->get_current_time(), warm_up_time);
+}
+
+TEST_F(TestNetworkAnalyticalCongestionAware, FailureInjection) {
+    /// setup: expander graph with i -> i±1, i±4 links, and its shortest-path tables
+    const auto npus_count = 32;
+    const auto inputfile = ::testing::TempDir() + "expander_graph_failures.json";
+    write_circulant_expander_graph(inputfile, npus_count);
+    const auto topology = std::make_shared<ExpanderGraph>(npus_count, 50, 500, inputfile);
+    topology->precompute_shortest_paths(4);
+
+    // device ids of a route
+    const auto ids = [](const Route& route) {
+        auto route_ids = std::vector<DeviceId>();
+        for (const auto& device : route) {
+            route_ids.push_back(device->get_id());
+        }
+        return route_ids;
+    };
+    const auto hop_ids = [](const RouteHops& route_hops) {
+        auto route_ids = std::vector<DeviceId>();
+        for (const auto& hop : route_hops) {
+            route_ids.push_back(hop.device->get_id());
+        }
+        return route_ids;
+    };
+    EXPECT_EQ(hop_ids(topology->get_route_hops(0, 2)), (std::vector<DeviceId>{0, 1, 2}));
+
+    /// test: chunks waiting for a failed link are rerouted, and every chunk arrives
+    auto arrived_count = 0;
+    for (auto i = 0; i < 8; i++) {
+        topology->send(0, 2, chunk_size, [&arrived_count] { arrived_count++; });
+    }
+    event_queue->run_until(1'000);
+    const auto route_cache_bytes = topology->memory_report().route_cache.bytes;
+    topology->fail_link(0, 1);
+    EXPECT_TRUE(topology->is_link_failed(0, 1));
+    EXPECT_TRUE(topology->is_link_failed(1, 0));
+    EXPECT_TRUE(topology->get_device(0)->get_link(topology->get_device(0)->get_port(1)).is_failed());
+    EXPECT_EQ(topology->get_device(0)
+                  ->get_link(topology->get_device(0)->get_port(1))
+                  .get_pending_bytes(*topology->get_simulation_context()),
+              0);
+    event_queue->run();
+    EXPECT_EQ(arrived_count, 8);
+
+    /// test: cached routes and table rows are recomputed as if the tables were built with the link failed
+    const auto detoured = hop_ids(topology->get_route_hops(0, 2));
+    EXPECT_EQ(detoured.size(), 4);
+    EXPECT_EQ(detoured.front(), 0);
+    EXPECT_NE(detoured[1], 1);
+    const auto reference = std::make_shared<ExpanderGraph>(npus_count, 50, 500, inputfile);
+    reference->fail_link(0, 1);
+    reference->precompute_shortest_paths(4);
+    for (DeviceId i = 0; i < npus_count; i++) {
+        for (DeviceId j = 0; j < npus_count; j++) {
+            if (i != j) {
+                EXPECT_EQ(ids(topology->route(i, j)), ids(reference->route(i, j)));
+            }
+        }
+    }
+    EXPECT_EQ(ids(reference->route(0, 2)), detoured);
+
+    /// test: restored links bring the shortest routes back
+    topology->restore_link(0, 1);
+    reference->restore_link(0, 1);
+    reference->precompute_shortest_paths(4);
+    EXPECT_FALSE(topology->is_link_failed(0, 1));
+    EXPECT_EQ(hop_ids(topology->get_route_hops(0, 2)), (std::vector<DeviceId>{0, 1, 2}));
+
+    /// test: with the queue drained, the routes retired mid-flight are freed
+    EXPECT_EQ(topology->memory_report().route_cache.bytes, route_cache_bytes);
+    for (DeviceId i = 0; i < npus_count; i++) {
+        for (DeviceId j = 0; j < npus_count; j++) {
+            if (i != j) {
+                EXPECT_EQ(ids(topology->route(i, j)), ids(reference->route(i, j)));
+            }
+        }
+    }
+
+    /// test: routes avoid failed devices, searched (not precomputed) routes included
+    const auto searched = std::make_shared<ExpanderGraph>(npus_count, 50, 500, inputfile);
+    EXPECT_EQ(searched->route(0, 2).size(), 3);
+    for (const auto& expander_graph : {topology, searched}) {
+        expander_graph->fail_device(1);
+        EXPECT_TRUE(expander_graph->is_device_failed(1));
+        for (DeviceId i = 0; i < npus_count; i++) {
+            for (DeviceId j = 0; j < npus_count; j++) {
+                if (i != j && i != 1 && j != 1) {
+                    const auto route = ids(expander_graph->route(i, j));
+                    EXPECT_EQ(std::count(route.begin(), route.end(), 1), 0);
+                    EXPECT_EQ(route.size(), expander_graph->get_distance(i, j, std::set<DeviceId>(), 0) + 1);
+                }
+            }
+        }
+        expander_graph->restore_device(1);
+        EXPECT_EQ(expander_graph->route(0, 2).size(), 3);
+    }
+
+    /// test: with hybrid fidelity, a cached route left over a failure (to a failed NPU) isn't taken either
+    const auto hybrid = std::make_shared<ExpanderGraph>(npus_count, 50, 500, inputfile);
+    const auto context = std::make_shared<SimulationContext>(std::make_shared<EventQueue>());
+    context->set_hybrid_fidelity(true);
+    hybrid->set_simulation_context(context);
+    EXPECT_EQ(hop_ids(hybrid->get_route_hops(0, 1)), (std::vector<DeviceId>{0, 1}));
+    hybrid->fail_device(1);
+    EXPECT_FALSE(hybrid->get_device(0)->get_link(hybrid->get_device(0)->get_port(1)).can_reserve(*context, 0));
+    EXPECT_EXIT(
+        {
+            hybrid->send(0, 1, chunk_size, callback, nullptr);
+            context->get_event_queue()->run();
+            std::exit(0);
+        },
+        ::testing::ExitedWithCode(255), "no route from 0 to 1");
+}
+
+TEST_F(TestNetworkAnalyticalCongestionAware, MemoryReport) {
+    /// setup: expander graph with i -> i±1, i±4 links
+    const auto npus_count = 32;
+    const auto inputfile = ::testing::TempDir() + "expander_graph_memory.json";
+    write_circulant_expander_graph(inputfile, npus_count);
+    const auto topology = std::make_shared<ExpanderGraph>(npus_count, 50, 500, inputfile);
+    const auto devices_count = topology->get_devices_count();
+
+    /// test: devices and links are counted from construction, nothing is cached yet
+    auto report = topology->memory_report();
+    EXPECT_GE(report.devices.bytes, devices_count * sizeof(Device));
+    EXPECT_GE(report.links.bytes, npus_count * 4 * sizeof(Link));
+    EXPECT_EQ(report.pending_chunks.bytes, 0);
+    EXPECT_EQ(report.route_cache.bytes, 0);
+    EXPECT_EQ(report.distance_cache.bytes, 0);
+    EXPECT_EQ(report.shortest_route_cache.bytes, 0);
+    EXPECT_EQ(report.dims.bytes, 0);
+
+    /// test: chunks waiting for a link are counted while they wait
+    for (auto i = 0; i < 4; i++) {
+        topology->send(0, 2, chunk_size, callback, nullptr);
+    }
+    report = topology->memory_report();
+    EXPECT_GE(report.pending_chunks.bytes, 3 * sizeof(std::unique_ptr<Chunk>));
+    EXPECT_GT(report.route_cache.bytes, 0);
+    EXPECT_GT(report.shortest_route_cache.bytes, 0);
+    EXPECT_GT(report.event_queue.bytes, 0);
+    EXPECT_GT(report.chunk_pool.bytes, 0);
+    event_queue->run();
+    report = topology->memory_report();
+    EXPECT_EQ(report.pending_chunks.bytes, 0);
+    EXPECT_GE(report.pending_chunks.peak_bytes, 3 * sizeof(std::unique_ptr<Chunk>));
+
+    /// test: the shortest-path tables take 3 bytes per pair of devices
+    topology->precompute_shortest_paths(4);
+    report = topology->memory_report();
+    EXPECT_EQ(report.distance_cache.bytes, 3 * static_cast<uint64_t>(devices_count) * devices_count);
+    EXPECT_EQ(report.get_total().bytes,
+              report.devices.bytes + report.links.bytes + report.pending_chunks.bytes + report.route_cache.bytes +
+                  report.distance_cache.bytes + report.shortest_route_cache.bytes + report.topk_route_cache.bytes +
+                  report.dims.bytes + report.event_queue.bytes + report.chunk_pool.bytes);
+
+    /// test: candidate paths of RandomTopK routing are counted in their own cache
+    const auto random_topk = std::make_shared<ExpanderGraph>(npus_count, 50, 500, inputfile, "RandomTopK");
+    EXPECT_EQ(random_topk->memory_report().topk_route_cache.bytes, 0);
+    static_cast<void>(random_topk->route(0, 16));
+    EXPECT_GT(random_topk->memory_report().topk_route_cache.bytes, 0);
+    EXPECT_EQ(random_topk->memory_report().shortest_route_cache.bytes, 0);
+
+    /// test: memory is written by the stats dump
+    auto out = std::ostringstream();
+    static_cast<void>(topology->dump_stats(out));
+    EXPECT_NE(out.str().find("memory,distance_cache," + std::to_string(report.distance_cache.bytes) + ","),
+              std::string::npos);
+
+    /// test: multi-dimensional topologies count their dimensions
+    auto multi_dim = MultiDimTopology();
+    multi_dim.append_dimension(std::make_unique<Ring>(4, 50, 500));
+    multi_dim.append_dimension(std::make_unique<Ring>(4, 50, 500));
+    const auto multi_dim_report = multi_dim.memory_report();
+    EXPECT_GT(multi_dim_report.dims.bytes, 2 * 4 * sizeof(Device));
+    EXPECT_GE(multi_dim_report.devices.bytes, 16 * sizeof(Device));
+}
+
+TEST_F(TestNetworkAnalyticalCongestionAware, CompletionBatching) {
+    /// setup: every NPU of a ring sends to its neighbor twice, so chunks complete in two waves of 16
+    struct Completion {
+        EventQueue* queue;
+        EventTime time;
+    };
+    struct Batch {
+        EventQueue* queue;
+        std::vector<std::pair<EventTime, size_t>> times_and_counts;
+        std::vector<void*> callback_args;
+    };
+    const Callback completed = [](void* const arg) {
+        auto* const completion = static_cast<Completion*>(arg);
+        completion->time = completion->queue->get_current_time();
+    };
+    const CompletionBatcher::BatchedCallback batch_completed = [](CallbackArg* const callback_args,
+                                                                  const size_t count, void* const sink_arg) {
+        auto* const batch = static_cast<Batch*>(sink_arg);
+        batch->times_and_counts.emplace_back(batch->queue->get_current_time(), count);
+        for (auto i = static_cast<size_t>(0); i < count; i++) {
+            static_cast<Completion*>(callback_args[i])->time = batch->queue->get_current_time();
+            batch->callback_args.push_back(callback_args[i]);
+        }
+    };
+
+    auto completion_times = std::vector<std::vector<EventTime>>();
+    auto batch = Batch();
+    auto batcher = std::shared_ptr<CompletionBatcher>();
+    auto lambda_completions = 0;
+    for (const auto batching : {false, true}) {
+        const auto context = std::make_shared<SimulationContext>(std::make_shared<EventQueue>());
+        if (batching) {
+            batcher = std::make_shared<CompletionBatcher>();
+            batch.queue = context->get_event_queue();
+            batcher->add_sink(completed, batch_completed, &batch);
+            context->set_completion_batcher(batcher);
+        }
+        const auto topology = std::make_shared<Ring>(16, 50, 500);
+        topology->set_simulation_context(context);
+        auto completions = std::vector<Completion>(32, Completion{context->get_event_queue(), 0});
+        for (auto i = 0; i < 32; i++) {
+            topology->send(i % 16, (i + 1) % 16, chunk_size, completed, &completions[i]);
+        }
+        topology->send(0, 2, chunk_size, [&lambda_completions]() { lambda_completions++; });
+        context->get_event_queue()->run();
+
+        auto times = std::vector<EventTime>();
+        for (const auto& completion : completions) {
+            times.push_back(completion.time);
+        }
+        completion_times.push_back(times);
+    }
+
+    /// test: same completion times, one batch per time
+    EXPECT_EQ(completion_times[1], completion_times[0]);
+    ASSERT_EQ(batch.times_and_counts.size(), 2);
+    EXPECT_EQ(batch.times_and_counts[0].first, completion_times[0][0]);
+    EXPECT_EQ(batch.times_and_counts[0].second, 16);
+    EXPECT_EQ(batch.times_and_counts[1].first, completion_times[0][16]);
+    EXPECT_EQ(batch.times_and_counts[1].second, 16);
+    EXPECT_LT(batch.times_and_counts[0].first, batch.times_and_counts[1].first);
+    EXPECT_EQ(batcher->get_batches_count(), 2);
+    EXPECT_EQ(batcher->get_batched_chunks_count(), 32);
+
+    /// test: chunks of other callbacks complete one by one
+    EXPECT_EQ(lambda_completions, 2);
+
+    /// test: time-end events run after the events they follow, including those scheduled meanwhile
+    auto order = std::vector<int>();
+    event_queue->schedule_event(10, [&]() {
+        event_queue->schedule_time_end_event([&]() { order.push_back(3); });
+        event_queue->schedule_event(10, [&]() { order.push_back(2); });
+        order.push_back(1);
+    });
+    event_queue->schedule_event(20, [&]() { order.push_back(4); });
+    event_queue->run();
+    EXPECT_EQ(order, (std::vector<int>{1, 2, 3, 4}));
+}
+
+TEST_F(TestNetworkAnalyticalCongestionAware, CApi) {
+    /// setup: reference times of two transfers sharing a route, and one on its own
+    const auto network_parser = NetworkParser("../../input/Ring.yml");
+    const auto topology = construct_topology(network_parser, std::make_shared<SimulationContext>(event_queue));
+    auto reference_times = std::vector<EventTime>(3);
+    const auto pairs = std::vector<std::pair<int, int>>{{0, 3}, {0, 3}, {8, 10}};
+    for (auto i = 0; i < 3; i++) {
+        topology->send(pairs[i].first, pairs[i].second, chunk_size,
+                       [this, &reference_times, i]() { reference_times[i] = event_queue->get_current_time(); });
+    }
+    event_queue->run();
+
+    /// test: invalid batches are rejected as a whole
+    auto* const sim = ana_sim_create("../../input/Ring.yml");
+    ASSERT_NE(sim, nullptr);
+    EXPECT_EQ(ana_get_npus_count(sim), 16);
+    const auto invalid = std::vector<ana_transfer>{{0, 3, chunk_size, 0}, {0, 16, chunk_size, 1}};
+    EXPECT_EQ(ana_send_batch(sim, invalid.data(), invalid.size()), ANA_ERROR_INVALID_ARGUMENT);
+    auto next_time = static_cast<uint64_t>(0);
+    EXPECT_EQ(ana_get_next_event_time(sim, &next_time), 0);
+
+    /// test: completions are drained in time order, with the times of the C++ interface
+    auto transfers = std::vector<ana_transfer>();
+    for (auto i = 0; i < 3; i++) {
+        transfers.push_back({pairs[i].first, pairs[i].second, chunk_size, static_cast<uint64_t>(100 + i)});
+    }
+    transfers.push_back({5, 5, chunk_size, 200});
+    ASSERT_EQ(ana_send_batch(sim, transfers.data(), transfers.size()), ANA_OK);
+    ASSERT_EQ(ana_get_next_event_time(sim, &next_time), 1);
+    EXPECT_GT(next_time, 0);
+
+    auto completions = std::vector<ana_completion>(2);
+    EXPECT_EQ(ana_poll_completions(sim, completions.data(), completions.size()), 1);
+    EXPECT_EQ(completions[0].tag, 200);
+    EXPECT_EQ(completions[0].time, 0);
+
+    EXPECT_EQ(ana_advance_until(sim, reference_times[0]), reference_times[0]);
+    EXPECT_EQ(ana_advance_until(sim, 0), reference_times[0]);
+    EXPECT_EQ(ana_advance_until(sim, reference_times[1]), reference_times[1]);
+    auto polled = std::map<uint64_t, uint64_t>();
+    auto last_time = static_cast<uint64_t>(0);
+    for (auto count = ana_poll_completions(sim, completions.data(), completions.size()); count > 0;
+         count = ana_poll_completions(sim, completions.data(), completions.size())) {
+        for (auto i = static_cast<size_t>(0); i < count; i++) {
+            EXPECT_GE(completions[i].time, last_time);
+            last_time = completions[i].time;
+            polled[completions[i].tag] = completions[i].time;
+        }
+    }
+    ASSERT_EQ(polled.size(), 3);
+    for (auto i = 0; i < 3; i++) {
+        EXPECT_EQ(polled[100 + i], reference_times[i]);
+    }
+    EXPECT_EQ(ana_get_next_event_time(sim, &next_time), 0);
+    EXPECT_EQ(ana_get_current_time(sim), reference_times[1]);
+    ana_sim_destroy(sim);
+}
+
+TEST_F(TestNetworkAnalyticalCongestionAware, SymmetricSimulation) {
+    /// setup: all-gather pattern, two chunks per pair, on symmetric topologies
+    const auto make_topologies = []() {
+        auto multi_dim = std::make_shared<MultiDimTopology>();
+        auto dims = std::vector<std::unique_ptr<BasicTopology>>();
+        dims.push_back(std::make_unique<Ring>(4, 50, 500));
+        dims.push_back(std::make_unique<FullyConnected>(4, 25, 700));
+        multi_dim->append_dimensions(std::move(dims));
+        return std::vector<std::shared_ptr<Topology>>{std::make_shared<Ring>(16, 50, 500),
+                                                      std::make_shared<Ring>(7, 50, 500, false),
+                                                      std::make_shared<FullyConnected>(8, 50, 500),
+                                                      std::make_shared<Switch>(8, 50, 500), multi_dim};
+    };
+    // every NPU sends to the images of the dests of NPU 0, in the same order
+    const auto all_gather = [this](const Topology& topology) {
+        const auto npus_count = topology.get_npus_count();
+        auto transfers = std::vector<SymmetricSimulation::Transfer>();
+        for (auto copy = 0; copy < 2; copy++) {
+            for (auto src = 0; src < npus_count; src++) {
+                for (auto dest = 1; dest < npus_count; dest++) {
+                    transfers.push_back({src, topology.map_by_symmetry(dest, src), chunk_size * (copy + 1)});
+                }
+            }
+        }
+        return transfers;
+    };
+    const auto simulate_everything = [](const std::shared_ptr<Topology>& topology,
+                                        const std::vector<SymmetricSimulation::Transfer>& transfers) {
+        auto* const queue = topology->get_simulation_context()->get_event_queue();
+        auto times = std::vector<EventTime>(transfers.size());
+        for (auto i = static_cast<size_t>(0); i < transfers.size(); i++) {
+            topology->send(transfers[i].src, transfers[i].dest, transfers[i].size,
+                           [&times, i, queue]() { times[i] = queue->get_current_time(); });
+        }
+        queue->run();
+        return times;
+    };
+
+    const auto references = make_topologies();
+    const auto reduced = make_topologies();
+    for (auto t = static_cast<size_t>(0); t < references.size(); t++) {
+        references[t]->set_simulation_context(std::make_shared<SimulationContext>(std::make_shared<EventQueue>()));
+        reduced[t]->set_simulation_context(std::make_shared<SimulationContext>(std::make_shared<EventQueue>()));
+        const auto npus_count = references[t]->get_npus_count();
+        const auto transfers = all_gather(*references[t]);
+
+        /// test: the pattern is reduced to the transfers from NPU 0, with the same completion times
+        const auto result = SymmetricSimulation(reduced[t]).run(transfers);
+        EXPECT_TRUE(result.reduced);
+        EXPECT_EQ(result.simulated_transfers_count, transfers.size() / npus_count);
+        EXPECT_EQ(result.completion_times, simulate_everything(references[t], transfers));
+    }
+
+    /// test: asymmetric patterns and topologies without symmetries are simulated in full
+    const auto topology = std::make_shared<Ring>(8, 50, 500);
+    topology->set_simulation_context(std::make_shared<SimulationContext>(std::make_shared<EventQueue>()));
+    auto transfers = std::vector<SymmetricSimulation::Transfer>();
+    for (auto src = 0; src < 8; src++) {
+        for (auto dest = 0; dest < 8; dest++) {
+            if (src != dest) {
+                transfers.push_back({src, dest, chunk_size});
+            }
+        }
+    }
+    const auto asymmetric = SymmetricSimulation(topology).run(transfers);
+    EXPECT_FALSE(asymmetric.reduced);
+    EXPECT_EQ(asymmetric.simulated_transfers_count, transfers.size());
+    const auto reference = std::make_shared<Ring>(8, 50, 500);
+    reference->set_simulation_context(std::make_shared<SimulationContext>(std::make_shared<EventQueue>()));
+    EXPECT_EQ(asymmetric.completion_times, simulate_everything(reference, transfers));
+
+    const auto npus_count = 32;
+    const auto inputfile = ::testing::TempDir() + "expander_graph_symmetric.json";
+    write_circulant_expander_graph(inputfile, npus_count);
+    const auto expander_graph = std::make_shared<ExpanderGraph>(npus_count, 50, 500, inputfile);
+    expander_graph->set_simulation_context(std::make_shared<SimulationContext>(std::make_shared<EventQueue>()));
+    EXPECT_FALSE(SymmetricSimulation(expander_graph).run({{0, 1, chunk_size}}).reduced);
+}
+
+TEST_F(TestNetworkAnalyticalCongestionAware, SeededRoutingStreams) {
+    /// test: Philox4x32-10 matches its known answers
+    EXPECT_EQ(CounterRng::philox({0, 0, 0, 0}, {0, 0}),
+              (CounterRng::Block{0x6627E8D5U, 0xE169C58DU, 0xBC57AC4CU, 0x9B00DBD8U}));
+    EXPECT_EQ(CounterRng::philox({0x243F6A88U, 0x85A308D3U, 0x13198A2EU, 0x03707344U}, {0xA4093822U, 0x299F31D0U}),
+              (CounterRng::Block{0xD16CFE09U, 0x94FDCCEBU, 0x5001E420U, 0x24126EA1U}));
+
+    /// test: a stream is a function of its key, and uniform draws stay in range
+    auto rng = CounterRng(1, 2, 3, 4);
+    auto same_rng = CounterRng(1, 2, 3, 4);
+    auto other_rng = CounterRng(1, 2, 3, 5);
+    auto differs = false;
+    for (auto i = 0; i < 16; i++) {
+        const auto word = rng();
+        EXPECT_EQ(word, same_rng());
+        differs |= (word != other_rng());
+        EXPECT_LT(rng.uniform(5), 5U);
+        static_cast<void>(same_rng.uniform(5));
+        static_cast<void>(other_rng.uniform(5));
+    }
+    EXPECT_TRUE(differs);
+
+    // ids of the routes of a source to every NPU, repeated
+    const auto npus_count = 16;
+    const auto route_all = [&](const Topology& topology) {
+        auto route_ids = std::vector<std::vector<DeviceId>>();
+        for (auto round = 0; round < 4; round++) {
+            for (auto dest = 1; dest < npus_count; dest++) {
+                route_ids.emplace_back();
+                for (const auto& device : topology.route(0, dest)) {
+                    route_ids.back().push_back(device->get_id());
+                }
+            }
+        }
+        return route_ids;
+    };
+
+    /// test: random FatTree routes repeat for the same seed, after reset(), and change with the seed
+    auto fat_tree = FatTree(npus_count, 4, 50, 500, "Random");
+    auto same_fat_tree = FatTree(npus_count, 4, 50, 500, "Random");
+    auto other_fat_tree = FatTree(npus_count, 4, 50, 500, "Random");
+    fat_tree.set_routing_seed(7);
+    same_fat_tree.set_routing_seed(7);
+    other_fat_tree.set_routing_seed(8);
+    const auto routes = route_all(fat_tree);
+    EXPECT_EQ(routes, route_all(same_fat_tree));
+    EXPECT_NE(routes, route_all(other_fat_tree));
+    fat_tree.reset();
+    EXPECT_EQ(routes, route_all(fat_tree));
+
+    /// test: successive flows of a pair spread over its paths
+    auto paths = std::set<std::vector<DeviceId>>(routes.begin(), routes.end());
+    EXPECT_GT(paths.size(), static_cast<size_t>(npus_count - 1));
+
+    /// test: Valiant Dragonfly routes repeat for the same seed, and after reset()
+    auto valiant = Dragonfly(9, 4, 2, 2, 50, 500, "Absolute", "Valiant");
+    auto same_valiant = Dragonfly(9, 4, 2, 2, 50, 500, "Absolute", "Valiant");
+    valiant.set_routing_seed(7);
+    same_valiant.set_routing_seed(7);
+    const auto valiant_routes = route_all(valiant);
+    EXPECT_EQ(valiant_routes, route_all(same_valiant));
+    valiant.reset();
+    EXPECT_EQ(valiant_routes, route_all(valiant));
+
+    /// test: the seed is read from the network config
+    const auto network_parser = NetworkParser("../../input/FatTree-Random.yml");
+    EXPECT_EQ(network_parser.get_seed(), 42U);
+    EXPECT_EQ(construct_topology(network_parser)->get_routing_seed(), 42U);
+}
+
+TEST_F(TestNetworkAnalyticalCongestionAware, SharedTopologyLinkStates) {
+    /// setup: one ring simulated under two contexts, and references for each simulation
+    const auto topology = std::make_shared<Ring>(4, 50, 500);
+    const auto context = std::make_shared<SimulationContext>(std::make_shared<EventQueue>());
+    const auto other_context = std::make_shared<SimulationContext>(std::make_shared<EventQueue>());
+    auto& link = topology->get_device(0)->get_link(topology->get_device(0)->get_port(1));
+
+    const auto run_reference = [this](const int chunks_count) {
+        const auto reference = std::make_shared<Ring>(4, 50, 500);
+        reference->set_simulation_context(std::make_shared<SimulationContext>(std::make_shared<EventQueue>()));
+        for (auto i = 0; i < chunks_count; i++) {
+            reference->send(0, 1, chunk_size, callback, nullptr);
+        }
+        reference->get_simulation_context()->get_event_queue()->run();
+        return reference->get_simulation_context()->get_event_queue()->get_current_time();
+    };
+
+    /// test: a link takes its slot in a context once simulated there
+    topology->set_simulation_context(context);
+    EXPECT_EQ(context->get_link_states().get_attached_links_count(), 0);
+
+    /// test: a context paused with a backlog keeps it while another context simulates the topology
+    for (auto i = 0; i < 3; i++) {
+        topology->send(0, 1, chunk_size, callback, nullptr);
+    }
+    EXPECT_EQ(context->get_link_states().get_attached_links_count(), 1);
+    EXPECT_EQ(link.get_pending_bytes(*context), 2 * chunk_size);
+
+    topology->set_simulation_context(other_context);
+    EXPECT_EQ(link.get_pending_bytes(*other_context), 0);
+    EXPECT_TRUE(link.can_reserve(*other_context, 0));
+    topology->send(0, 1, chunk_size, callback, nullptr);
+    other_context->get_event_queue()->run();
+    EXPECT_EQ(other_context->get_event_queue()->get_current_time(), run_reference(1));
+
+    /// test: the paused context resumes as if it had never been left
+    topology->set_simulation_context(context);
+    EXPECT_EQ(link.get_pending_bytes(*context), 2 * chunk_size);
+    context->get_event_queue()->run();
+    EXPECT_EQ(context->get_event_queue()->get_current_time(), run_reference(3));
+
+    /// test: the slot of a destroyed link is taken again by the next link of the same ids, with a fresh state
+    const auto link_ids = std::make_shared<LinkStates::LinkIds>();
+    {
+        auto released_link = Link(50, 500, nullptr, link_ids);
+        released_link.set_busy(*context);
+        EXPECT_FALSE(released_link.can_reserve(*context, 0));
+    }
+    const auto attached_links_count = context->get_link_states().get_attached_links_count();
+    const auto new_link = Link(50, 500, nullptr, link_ids);
+    EXPECT_TRUE(new_link.can_reserve(*context, 0));
+    EXPECT_EQ(context->get_link_states().get_attached_links_count(), attached_links_count);
+
+    /// test: links of another topology take the same ids, but their own slots in the context
+    const auto other_topology = std::make_shared<Ring>(4, 50, 500);
+    const auto& other_link = other_topology->get_device(0)->get_link(other_topology->get_device(0)->get_port(1));
+    const auto current_time = context->get_event_queue()->get_current_time();
+    topology->send(0, 1, chunk_size, callback, nullptr);
+    EXPECT_FALSE(link.can_reserve(*context, current_time));
+    EXPECT_TRUE(other_link.can_reserve(*context, current_time));
+    EXPECT_EQ(context->get_link_states().get_attached_links_count(), attached_links_count + 1);
+    context->get_event_queue()->run();
+
+    /// test: two contexts simulate one topology at once, from two threads, each as if it were alone
+    const auto shared_topology = construct_topology(NetworkParser("../../input/Ring.yml"));
+    shared_topology->precompute_routes(1);
+    auto contexts = std::vector<std::shared_ptr<SimulationContext>>();
+    for (int i = 0; i < 2; i++) {
+        contexts.push_back(std::make_shared<SimulationContext>(std::make_shared<EventQueue>()));
+    }
+    contexts[1]->set_link_coalescing(true);
+
+    auto simulation_times = std::vector<EventTime>(2);
+    auto threads = std::vector<std::thread>();
+    for (int t = 0; t < 2; t++) {
+        threads.emplace_back([&, t] {
+            auto& shared_context = *contexts[t];
+            const auto npus_count = shared_topology->get_npus_count();
+            for (int i = 0; i < npus_count; i++) {
+                for (int j = 0; j < npus_count; j++) {
+                    if (i != j) {
+                        shared_topology->send(shared_context, i, j, chunk_size, EventCallback(callback, nullptr));
+                    }
+                }
+            }
+            shared_context.get_event_queue()->run();
+            simulation_times[t] = shared_context.get_event_queue()->get_current_time();
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(simulation_times[0], 704'116);
+    EXPECT_EQ(simulation_times[1], 704'116);
+    EXPECT_TRUE(shared_topology->get_simulation_context()->get_event_queue()->finished());
+}
+
+TEST_F(TestNetworkAnalyticalCongestionAware, CutThrough) {
+    /// setup: 4-hop routes of 1 MB chunks, forwarded after each flit of 4 KB
+    const auto serialization_time = static_cast<EventTime>(chunk_size / bw_GBps_to_Bpns(50));
+    const auto flit_serialization_time = static_cast<EventTime>(4096 / bw_GBps_to_Bpns(50));
+    const auto simulate = [this](const ChunkSize flit_size, const bool hybrid_fidelity, const int chunks_count) {
+        const auto topology = std::make_shared<Ring>(8, 50, 500);
+        const auto context = std::make_shared<SimulationContext>(std::make_shared<EventQueue>());
+        context->set_cut_through(flit_size);
+        context->set_hybrid_fidelity(hybrid_fidelity);
+        topology->set_simulation_context(context);
+
+        auto* const queue = context->get_event_queue();
+        auto times = std::vector<EventTime>(chunks_count);
+        for (auto i = 0; i < chunks_count; i++) {
+            topology->send(0, 4, chunk_size, [&times, i, queue]() { times[i] = queue->get_current_time(); });
+        }
+        queue->run();
+        return times;
+    };
+
+    /// test: a chunk is serialized once, then pays a flit per extra hop
+    const auto pipelined_time = serialization_time + (4 * 500) + (3 * flit_serialization_time);
+    EXPECT_EQ(simulate(4096, false, 1), std::vector<EventTime>({pipelined_time}));
+    EXPECT_LT(simulate(4096, false, 1)[0], simulate(0, false, 1)[0]);
+
+    /// test: the fast path of uncontended chunks gives the same timing
+    EXPECT_EQ(simulate(4096, true, 1), std::vector<EventTime>({pipelined_time}));
+
+    /// test: a chunk queued behind another is pipelined behind it
+    EXPECT_EQ(simulate(4096, false, 2), std::vector<EventTime>({pipelined_time, pipelined_time + serialization_time}));
+
+    /// test: chunks no larger than a flit are stored and forwarded
+    EXPECT_EQ(simulate(chunk_size, false, 2), simulate(0, false, 2));
+    EXPECT_EQ(simulate(0, false, 1)[0], 4 * static_cast<EventTime>(500 + (chunk_size / bw_GBps_to_Bpns(50))));
+}
+
+TEST_F(TestNetworkAnalyticalCongestionAware, TrafficClasses) {
+    /// setup: chunks of given classes queued on a single link at once, completions labelled by class
+    const auto simulate = [this](const std::shared_ptr<SimulationContext>& context, const std::vector<int>& classes) {
+        const auto topology = std::make_shared<Ring>(4, 50, 500);
+        topology->set_simulation_context(context);
+        auto order = std::string();
+        for (const auto traffic_class : classes) {
+            topology->set_traffic_class(traffic_class);
+            topology->send(0, 1, chunk_size, [&order, traffic_class]() { order += std::to_string(traffic_class); });
+        }
+        context->get_event_queue()->run();
+        return order;
+    };
+
+    /// test: a single class is FIFO, and the lowest class goes first under strict priority
+    const auto context = std::make_shared<SimulationContext>(std::make_shared<EventQueue>());
+    EXPECT_EQ(simulate(context, {2, 2, 2, 1, 0, 1}), "2" "01122");
+    EXPECT_EQ(simulate(std::make_shared<SimulationContext>(std::make_shared<EventQueue>()), {0, 0, 0, 0}), "0000");
+
+    /// test: an urgent chunk overtakes the backlog without changing the busy period
+    const auto reference = std::make_shared<Ring>(4, 50, 500);
+    reference->set_simulation_context(std::make_shared<SimulationContext>(std::make_shared<EventQueue>()));
+    for (auto i = 0; i < 6; i++) {
+        reference->send(0, 1, chunk_size, callback, nullptr);
+    }
+    reference->get_simulation_context()->get_event_queue()->run();
+    EXPECT_EQ(context->get_event_queue()->get_current_time(),
+              reference->get_simulation_context()->get_event_queue()->get_current_time());
+
+    /// test: deficit round-robin shares the link in proportion to the quanta
+    const auto drr_context = std::make_shared<SimulationContext>(std::make_shared<EventQueue>());
+    drr_context->set_link_scheduling(SimulationContext::LinkScheduling::DeficitRoundRobin,
+                                     {chunk_size, 2 * chunk_size, chunk_size, chunk_size});
+    EXPECT_EQ(simulate(drr_context, {0, 0, 0, 0, 0, 1, 1, 1, 1}), "0" "0110110" "0");
+
+    /// test: quanta smaller than chunks take several rounds, still in proportion
+    const auto small_quanta_context = std::make_shared<SimulationContext>(std::make_shared<EventQueue>());
+    small_quanta_context->set_link_scheduling(SimulationContext::LinkScheduling::DeficitRoundRobin,
+                                              {chunk_size / 4, chunk_size / 2, chunk_size, chunk_size});
+    EXPECT_EQ(simulate(small_quanta_context, {3, 0, 0, 1, 1, 1, 1}), "3" "101101");
+
+    /// test: a chunk sent while a coalesced burst is under way still overtakes the lower classes
+    for (const auto scheduling :
+         {SimulationContext::LinkScheduling::StrictPriority, SimulationContext::LinkScheduling::DeficitRoundRobin}) {
+        const auto coalescing_context = std::make_shared<SimulationContext>(std::make_shared<EventQueue>());
+        coalescing_context->set_link_coalescing(true);
+        coalescing_context->set_link_scheduling(scheduling);
+        const auto ring = std::make_shared<Ring>(4, 50, 500);
+        ring->set_simulation_context(coalescing_context);
+        auto coalesced_order = std::string();
+        ring->set_traffic_class(1);
+        for (auto i = 0; i < 5; i++) {
+            ring->send(0, 1, chunk_size, [&coalesced_order]() { coalesced_order += "1"; });
+        }
+        const auto serialization_time = static_cast<EventTime>(chunk_size / bw_GBps_to_Bpns(50));
+        coalescing_context->get_event_queue()->schedule_event(3 * serialization_time / 2, [&]() {
+            ring->set_traffic_class(0);
+            ring->send(0, 1, chunk_size, [&coalesced_order]() { coalesced_order += "0"; });
+        });
+        coalescing_context->get_event_queue()->run();
+        EXPECT_EQ(coalesced_order, "110111");
+    }
+
+    /// test: messages keep the class they were sent with
+    const auto topology = std::make_shared<Ring>(4, 50, 500);
+    topology->set_simulation_context(std::make_shared<SimulationContext>(std::make_shared<EventQueue>()));
+    auto order = std::string();
+    topology->set_traffic_class(1);
+    topology->send_message(0, 1, 4 * chunk_size, chunk_size, [&order]() { order += "1"; }, 1);
+    topology->set_traffic_class(0);
+    topology->send(0, 1, chunk_size, [&order]() { order += "0"; });
+    topology->get_simulation_context()->get_event_queue()->run();
+    EXPECT_EQ(order, "01");
+}
+
+TEST_F(TestNetworkAnalyticalCongestionAware, SwitchBuffers) {
+    /// setup: NPUs 1-3 send 8 chunks each to NPU 0 through the switch, then NPU 1 sends chunk v to NPU 2
+    struct Result {
+        EventTime incast_time = 0;
+        EventTime victim_time = 0;
+        std::string order;
+    };
+    const auto simulate = [this](const ChunkSize buffer_size, const bool coalescing = false) {
+        const auto topology = std::make_shared<Switch>(4, 50, 500);
+        const auto context = std::make_shared<SimulationContext>(std::make_shared<EventQueue>());
+        context->set_link_coalescing(coalescing);
+        topology->set_simulation_context(context);
+        topology->set_switch_buffer_size(buffer_size);
+        auto* const event_queue = context->get_event_queue();
+        const auto switch_device = topology->get_device(4);
+        const auto& egress_link = switch_device->get_link(switch_device->get_port(0));
+
+        // the egress buffer holds at most buffer_size, or a single chunk larger than it
+        auto max_buffered_bytes = static_cast<ChunkSize>(0);
+        const auto sample = [&]() {
+            max_buffered_bytes = std::max(max_buffered_bytes, egress_link.get_buffered_bytes(*context));
+            max_buffered_bytes = std::max(max_buffered_bytes, egress_link.get_pending_bytes(*context));
+        };
+        auto result = Result();
+        for (auto i = 0; i < 8; i++) {
+            for (auto src = 1; src < 4; src++) {
+                topology->send(src, 0, chunk_size, [&sample, &result, event_queue, src]() {
+                    sample();
+                    result.incast_time = event_queue->get_current_time();
+                    result.order += std::to_string(src);
+                });
+            }
+        }
+        topology->send(1, 2, chunk_size, [&result, event_queue]() {
+            result.victim_time = event_queue->get_current_time();
+            result.order += "v";
+        });
+        for (auto time = 0; time < 1'000'000; time += 5'000) {
+            event_queue->schedule_event(time, [&sample]() { sample(); });
+        }
+        event_queue->run();
+
+        EXPECT_EQ(egress_link.get_buffered_bytes(*context), 0);
+        if (buffer_size > 0) {
+            EXPECT_LE(max_buffered_bytes, std::max(buffer_size, chunk_size));
+        }
+        return result;
+    };
+
+    /// test: the incast drains at the rate of the egress link either way
+    const auto unbounded = simulate(0);
+    const auto bounded = simulate(2 * chunk_size);
+    EXPECT_EQ(bounded.incast_time, unbounded.incast_time);
+
+    /// test: the stalled link towards the switch delays the chunk queued behind the incast (head-of-line blocking)
+    EXPECT_GT(bounded.victim_time, unbounded.victim_time);
+
+    /// test: coalescing doesn't hand buffer room back before chunks are serialized
+    for (const auto buffer_chunks : {1, 2, 4, 6}) {
+        const auto deep = simulate(buffer_chunks * chunk_size);
+        const auto coalesced = simulate(buffer_chunks * chunk_size, true);
+        EXPECT_EQ(coalesced.order, deep.order);
+        EXPECT_EQ(coalesced.victim_time, deep.victim_time);
+        EXPECT_EQ(coalesced.incast_time, deep.incast_time);
+    }
+
+    /// test: chunks larger than the buffer still get through, one at a time
+    const auto small = simulate(chunk_size / 2);
+    EXPECT_GT(small.incast_time, unbounded.incast_time);
+    EXPECT_GT(small.victim_time, 0);
+}
@@ -3,11 +3,30 @@ This source code is licensed under the MIT license found in the
 LICENSE file in the root directory of this source tree.
 *******************************************************************************/
 
+#include "common/CApi.h"
+#include "common/CsrGraph.h"
+#include "common/DistanceMatrix.h"
+#include "common/ExpanderGraphFile.h"
+#include "common/NetworkFunction.h"
 #include "common/NetworkParser.h"
+#include "common/TraceFile.h"
 #include "common/Type.h"
+#include "congestion_unaware/ContentionEstimator.h"
 #include "congestion_unaware/Helper.h"
 #include "congestion_unaware/ExpanderGraph.h"
+#include "congestion_unaware/FullyConnected.h"
+#include "congestion_unaware/Ring.h"
+#include "congestion_unaware/Switch.h"
 #include "congestion_unaware/SwitchOrExpander.h"
+#include "congestion_unaware/TraceReplay.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
 #include <gtest/gtest.h>
 
 using namespace NetworkAnalytical;
@@ -257,4 +276,316 @@ TEST_F(TestNetworkAnalyticalCongestionUnaware, SwitchOrExpander_Splitted) {
             EXPECT_EQ(delay, 2 * network_parser.get_latencies_per_dim()[0]);
         }
     }
-}
\ No newline at end of file
+}
+TEST_F(TestNetworkAnalyticalCongestionUnaware, DistanceMatrixOnRing) {
+    // ring larger than a single bit-parallel pass, plus an isolated node
+    const auto ring_size = 300;
+    auto adjacency_list = std::map<DeviceId, std::vector<DeviceId>>();
+    for (DeviceId i = 0; i < ring_size; i++) {
+        adjacency_list[i] = {(i + 1) % ring_size, (i + ring_size - 1) % ring_size};
+    }
+    adjacency_list[ring_size] = {};
+
+    const auto graph = CsrGraph(adjacency_list);
+    EXPECT_EQ(graph.get_nodes_count(), ring_size + 1);
+    EXPECT_EQ(graph.get_edges_count(), 2 * ring_size);
+    EXPECT_EQ(graph.get_degree(ring_size), 0);
+    const auto [first_neighbor, last_neighbor] = graph.get_neighbors(0);
+    ASSERT_EQ(last_neighbor - first_neighbor, 2);
+    EXPECT_EQ(first_neighbor[0], 1);
+    EXPECT_EQ(first_neighbor[1], ring_size - 1);
+
+    const auto distance_matrix = DistanceMatrix(graph);
+    EXPECT_EQ(distance_matrix.get_nodes_count(), ring_size + 1);
+
+    for (DeviceId i = 0; i < ring_size; i++) {
+        for (DeviceId j = 0; j < ring_size; j++) {
+            const auto offset = std::abs(i - j);
+            EXPECT_EQ(distance_matrix.get_distance(i, j), std::min(offset, ring_size - offset));
+        }
+        EXPECT_EQ(distance_matrix.get_distance(i, ring_size), DistanceMatrix::unreachable_distance);
+    }
+    EXPECT_EQ(distance_matrix.get_distance(ring_size, ring_size), 0);
+
+    /// test: passes split across threads, and matrices mapped back from a file, give the same distances
+    const auto path = ::testing::TempDir() + "ring_distances.hops";
+    ASSERT_TRUE(DistanceMatrix(graph, 3).save(path, 42));
+    auto mapped_matrix = DistanceMatrix();
+    EXPECT_FALSE(DistanceMatrix::load(path, 43, mapped_matrix));
+    ASSERT_TRUE(DistanceMatrix::load(path, 42, mapped_matrix));
+    EXPECT_TRUE(mapped_matrix.is_mapped());
+    EXPECT_EQ(mapped_matrix.get_nodes_count(), ring_size + 1);
+    for (DeviceId i = 0; i <= ring_size; i++) {
+        for (DeviceId j = 0; j <= ring_size; j++) {
+            EXPECT_EQ(mapped_matrix.get_distance(i, j), distance_matrix.get_distance(i, j));
+        }
+    }
+}
+
+TEST_F(TestNetworkAnalyticalCongestionUnaware, SendBatch) {
+    for (const auto* const config : {"Ring.yml", "FullyConnected.yml", "Switch.yml", "Ring_FullyConnected_Switch.yml"}) {
+        // create network
+        const auto network_parser = NetworkParser(std::string("../../input/") + config);
+        const auto topology = construct_topology(network_parser);
+        const auto npus_count = topology->get_npus_count();
+
+        // every pair, with varying chunk sizes
+        auto srcs = std::vector<DeviceId>();
+        auto dests = std::vector<DeviceId>();
+        auto chunk_sizes = std::vector<ChunkSize>();
+        for (DeviceId i = 0; i < npus_count; i++) {
+            for (DeviceId j = 0; j < npus_count; j++) {
+                if (i != j) {
+                    srcs.push_back(i);
+                    dests.push_back(j);
+                    chunk_sizes.push_back(chunk_size * (1 + (srcs.size() % 3)));
+                }
+            }
+        }
+
+        /// test: batched delays match the per-chunk ones
+        auto delays = std::vector<EventTime>(srcs.size());
+        topology->send_batch(srcs.data(), dests.data(), chunk_sizes.data(), delays.data(), srcs.size());
+        for (auto i = static_cast<size_t>(0); i < srcs.size(); i++) {
+            EXPECT_EQ(delays[i], topology->send(srcs[i], dests[i], chunk_sizes[i]));
+        }
+    }
+}
+
+TEST_F(TestNetworkAnalyticalCongestionUnaware, CollectiveTime) {
+    // create network
+    const auto network_parser = NetworkParser("../../input/Ring.yml");
+    const auto topology = construct_topology(network_parser);
+    const auto bytes = 16 * chunk_size;
+
+    /// test: ring and direct collectives match their sends, one step after another
+    // (send() truncates each step's delay, hence the tolerance)
+    const auto ring_step = topology->send(0, 1, chunk_size);
+    const auto all_gather_time = topology->collective_time(CollectiveType::AllGather, bytes, CollectiveAlgorithm::Ring);
+    EXPECT_NEAR(all_gather_time, 15 * ring_step, 15);
+    EXPECT_EQ(topology->collective_time(CollectiveType::ReduceScatter, bytes, CollectiveAlgorithm::Ring),
+              all_gather_time);
+    EXPECT_NEAR(topology->collective_time(CollectiveType::AllReduce, bytes, CollectiveAlgorithm::Ring),
+                2 * all_gather_time, 1);
+    EXPECT_NEAR(topology->collective_time(CollectiveType::AllGather, bytes, CollectiveAlgorithm::Direct),
+                topology->send(0, 8, chunk_size), 1);
+
+    // halving-doubling: 4 steps, exchanging 8, 4, 2, then 1 MB with NPUs 8, 4, 2, then 1 away
+    const auto halving_doubling_time = topology->send(0, 8, 8 * chunk_size) + topology->send(0, 4, 4 * chunk_size) +
+                                       topology->send(0, 2, 2 * chunk_size) + topology->send(0, 1, chunk_size);
+    EXPECT_NEAR(topology->collective_time(CollectiveType::ReduceScatter, bytes, CollectiveAlgorithm::HalvingDoubling),
+                halving_doubling_time, 4);
+
+    /// test: multi-dimensional collectives compose the collectives of each dimension
+    const auto multi_dim_topology = construct_topology(NetworkParser("../../input/Ring_FullyConnected_Switch.yml"));
+    const auto ring = Ring(2, 200, 50);
+    const auto fully_connected = FullyConnected(8, 100, 500);
+    const auto switch_topology = Switch(4, 50, 2000);
+    const auto reduce_scatter_time =
+        ring.collective_time(CollectiveType::ReduceScatter, bytes, CollectiveAlgorithm::Ring) +
+        fully_connected.collective_time(CollectiveType::ReduceScatter, bytes / 2, CollectiveAlgorithm::Ring) +
+        switch_topology.collective_time(CollectiveType::ReduceScatter, bytes / 16, CollectiveAlgorithm::Ring);
+    EXPECT_EQ(multi_dim_topology->collective_time(CollectiveType::ReduceScatter, bytes, CollectiveAlgorithm::Ring),
+              reduce_scatter_time);
+    EXPECT_EQ(multi_dim_topology->collective_time(CollectiveType::AllReduce, bytes, CollectiveAlgorithm::Ring),
+              2 * reduce_scatter_time);
+    const auto all_to_all_time =
+        ring.collective_time(CollectiveType::AllToAll, bytes, CollectiveAlgorithm::Direct) +
+        fully_connected.collective_time(CollectiveType::AllToAll, bytes, CollectiveAlgorithm::Direct) +
+        switch_topology.collective_time(CollectiveType::AllToAll, bytes, CollectiveAlgorithm::Direct);
+    EXPECT_EQ(multi_dim_topology->collective_time(CollectiveType::AllToAll, bytes, CollectiveAlgorithm::Direct),
+              all_to_all_time);
+}
+
+TEST_F(TestNetworkAnalyticalCongestionUnaware, CalibratedBandwidthAndLatency) {
+    /// setup: Ring with calibration factors inline, and the same factors in an overlay file
+    const auto directory = ::testing::TempDir();
+    {
+        auto overlay = std::ofstream(directory + "ring_calibration.yml");
+        overlay << "bandwidth_scale: [ 0.5 ]\nlatency_scale: [ 2.0 ]\n";
+        auto config = std::ofstream(directory + "ring_calibrated.yml");
+        config << "topology: [ Ring ]\nnpus_count: [ 16 ]\nbandwidth: [ 50.0 ]\nlatency: [ 500.0 ]\n"
+               << "calibration: ring_calibration.yml\n";
+    }
+    const auto topology = construct_topology(NetworkParser(directory + "ring_calibrated.yml"));
+
+    /// test: delays follow the scaled bandwidth and latency
+    const auto reference = Ring(16, 25.0, 1000.0);
+    EXPECT_EQ(topology->send(0, 3, chunk_size), reference.send(0, 3, chunk_size));
+    EXPECT_EQ(topology->send(2, 11, chunk_size), reference.send(2, 11, chunk_size));
+    std::remove((directory + "ring_calibration.yml").c_str());
+    std::remove((directory + "ring_calibrated.yml").c_str());
+}
+
+TEST_F(TestNetworkAnalyticalCongestionUnaware, ExpanderGraphFileFormats) {
+    /// setup: a ring of 8 nodes, and a split ring over the even nodes, among other fields
+    const auto json_path = ::testing::TempDir() + "expander.json";
+    const auto binary_path = ::testing::TempDir() + "expander.egbin";
+    {
+        auto file = std::ofstream(json_path);
+        file << "{\"name\": \"ring\", \"connected_graph_adjacency\": "
+             << "[[1, 7], [2, 0], [3, 1], [4, 2], [5, 3], [6, 4], [7, 5], [0, 6]], "
+             << "\"groups\": {\"A\": [0, 2, 4, 6], \"B\": [1, 3, 5, 7]}, "
+             << "\"split_graph_adjacency\": [[2, 6, 1], [], [0, 4], [], [2, 6, 6], [], [4, 0], []], "
+             << "\"meta\": {\"seed\": [1.5, null, true]}, \"node_count\": 8, \"degree\": 2}";
+    }
+
+    /// test: edges of both graphs, each once
+    auto graph_file = ExpanderGraphFile();
+    ASSERT_TRUE(ExpanderGraphFile::load(json_path, graph_file));
+    EXPECT_EQ(graph_file.get_node_count(), 8);
+    EXPECT_EQ(graph_file.get_degree(), 2);
+    const auto connected_edges = std::vector<ExpanderGraphFile::Edge>{{0, 1}, {0, 7}, {1, 2}, {2, 3},
+                                                                      {3, 4}, {4, 5}, {5, 6}, {6, 7}};
+    const auto split_edges = std::vector<ExpanderGraphFile::Edge>{{0, 1}, {0, 3}, {1, 2}, {2, 3}};
+    EXPECT_EQ(graph_file.get_connected_graph_edges(), connected_edges);
+    EXPECT_EQ(graph_file.get_split_graph_edges(), split_edges);
+
+    /// test: the binary edge list loads back the same graph
+    ASSERT_TRUE(graph_file.save(binary_path));
+    auto binary_graph_file = ExpanderGraphFile();
+    ASSERT_TRUE(ExpanderGraphFile::load(binary_path, binary_graph_file));
+    EXPECT_EQ(binary_graph_file.get_node_count(), 8);
+    EXPECT_EQ(binary_graph_file.get_connected_graph_edges(), connected_edges);
+    EXPECT_EQ(binary_graph_file.get_split_graph_edges(), split_edges);
+
+    /// test: both formats build the same topologies
+    for (const auto& path : {json_path, binary_path}) {
+        const auto full = ExpanderGraph(8, 2, 50, 500, path);
+        EXPECT_EQ(full.send(0, 4, chunk_size), Ring(8, 50, 500).send(0, 4, chunk_size));
+        const auto split = ExpanderGraph(4, 2, 50, 500, path);
+        EXPECT_EQ(split.send(1, 3, chunk_size), Ring(4, 50, 500).send(1, 3, chunk_size));
+        std::remove((path + ".hops").c_str());
+    }
+
+    /// test: malformed files aren't loaded
+    {
+        auto file = std::ofstream(json_path, std::ios::trunc);
+        file << "{\"node_count\": 2, \"degree\": 1, \"connected_graph_adjacency\": [[1], [5]]}";
+    }
+    EXPECT_FALSE(ExpanderGraphFile::load(json_path, graph_file));
+    EXPECT_EQ(graph_file.get_node_count(), 8);
+    std::remove(json_path.c_str());
+    std::remove(binary_path.c_str());
+}
+
+TEST_F(TestNetworkAnalyticalCongestionUnaware, StreamingTraceReplay) {
+    /// setup: a chain of dependent transfers around the ring
+    const auto topology = construct_topology(NetworkParser("../../input/Ring.yml"));
+    const auto npus_count = topology->get_npus_count();
+    const auto chain_length = 64;
+    const auto trace_path = ::testing::TempDir() + "unaware_trace.bin";
+    {
+        auto writer = TraceWriter(trace_path);
+        for (auto i = 0; i < chain_length; i++) {
+            auto record = TraceRecord{0, i % npus_count, (i + 1) % npus_count, chunk_size, {}};
+            if (i > 0) {
+                record.dependencies.push_back(i - 1);
+            }
+            writer.write(record);
+        }
+        ASSERT_TRUE(writer.close());
+    }
+
+    /// test: each transfer waits for the previous one, kept in a single-record window
+    auto replay = TraceReplay(topology, trace_path, 1);
+    EXPECT_EQ(replay.run(), chain_length * topology->send(0, 1, chunk_size));
+}
+
+TEST_F(TestNetworkAnalyticalCongestionUnaware, CApi) {
+    /// setup
+    auto* const sim = ana_sim_create("../../input/Ring.yml");
+    ASSERT_NE(sim, nullptr);
+    EXPECT_EQ(ana_get_npus_count(sim), 16);
+
+    /// test: invalid batches are rejected as a whole
+    const auto invalid = std::vector<ana_transfer>{{1, 4, chunk_size, 0}, {-1, 4, chunk_size, 1}};
+    EXPECT_EQ(ana_send_batch(sim, invalid.data(), invalid.size()), ANA_ERROR_INVALID_ARGUMENT);
+
+    /// test: transfers complete after the delays send() estimates, in time order
+    const auto transfers =
+        std::vector<ana_transfer>{{1, 4, chunk_size, 10}, {1, 2, chunk_size, 11}, {3, 3, chunk_size, 12}};
+    ASSERT_EQ(ana_send_batch(sim, transfers.data(), transfers.size()), ANA_OK);
+    auto next_time = static_cast<uint64_t>(0);
+    ASSERT_EQ(ana_get_next_event_time(sim, &next_time), 1);
+    EXPECT_EQ(next_time, 0);
+
+    auto completions = std::vector<ana_completion>(4);
+    EXPECT_EQ(ana_advance_until(sim, 1'000), 1'000);
+    EXPECT_EQ(ana_poll_completions(sim, completions.data(), completions.size()), 1);
+    EXPECT_EQ(completions[0].tag, 12);
+
+    EXPECT_EQ(ana_advance_until(sim, 100'000), 100'000);
+    ASSERT_EQ(ana_poll_completions(sim, completions.data(), 1), 1);
+    EXPECT_EQ(completions[0].tag, 11);
+    ASSERT_EQ(ana_poll_completions(sim, completions.data(), completions.size()), 1);
+    EXPECT_EQ(completions[0].tag, 10);
+    EXPECT_EQ(completions[0].time, 21'031);
+    EXPECT_EQ(ana_get_next_event_time(sim, &next_time), 0);
+    ana_sim_destroy(sim);
+}
+
+TEST_F(TestNetworkAnalyticalCongestionUnaware, ContentionEstimator) {
+    /// setup: a Ring, and the bytes a link carries per window
+    const auto ring = std::make_shared<Ring>(8, 50, 500);
+    const auto window = static_cast<EventTime>(1'000'000);
+    const auto link_capacity = bw_GBps_to_Bpns(50) * static_cast<double>(window);
+    const auto serialization_delay = static_cast<double>(chunk_size) / bw_GBps_to_Bpns(50);
+
+    /// test: routes cross one link per hop
+    auto links = std::vector<int>();
+    ASSERT_TRUE(ring->append_route_links(1, 4, links));
+    EXPECT_EQ(links, (std::vector<int>{1, 2, 3}));
+    links.clear();
+    ASSERT_TRUE(ring->append_route_links(1, 6, links));
+    EXPECT_EQ(links, (std::vector<int>{9, 8, 15}));
+
+    /// test: with no traffic, delays are the ones of the topology
+    auto fair_share = ContentionEstimator(ring, window);
+    EXPECT_EQ(fair_share.send(1, 4, chunk_size), ring->send(1, 4, chunk_size));
+
+    /// test: declared traffic twice the capacity of link 0 doubles the serialization of the routes through it
+    fair_share.set_traffic(0, 1, static_cast<ChunkSize>(2 * link_capacity));
+    EXPECT_NEAR(fair_share.get_link_load(0), 2.0, 1e-6);
+    EXPECT_NEAR(fair_share.send(7, 2, chunk_size), ring->send(7, 2, chunk_size) + serialization_delay, 1);
+    EXPECT_EQ(fair_share.send(1, 2, chunk_size), ring->send(1, 2, chunk_size));
+
+    /// test: a new phase only keeps its own traffic
+    auto traffic_matrix = std::vector<ChunkSize>(8 * 8, 0);
+    traffic_matrix[(1 * 8) + 3] = static_cast<ChunkSize>(3 * link_capacity);
+    fair_share.set_traffic_matrix(traffic_matrix);
+    EXPECT_NEAR(fair_share.get_link_load(0), 0.0, 1e-6);
+    EXPECT_NEAR(fair_share.get_route_load(2, 4), 3.0, 1e-6);
+    EXPECT_EQ(fair_share.send(7, 0, chunk_size), ring->send(7, 0, chunk_size));
+
+    /// test: M/D/1 links at half load wait half a serialization each
+    auto md1 = ContentionEstimator(ring, window, ContentionEstimator::QueueModel::MD1);
+    md1.set_traffic(0, 2, static_cast<ChunkSize>(link_capacity / 2));
+    EXPECT_NEAR(md1.send(0, 2, chunk_size), ring->send(0, 2, chunk_size) + serialization_delay, 1);
+    EXPECT_NEAR(md1.send(1, 2, chunk_size), ring->send(1, 2, chunk_size) + (serialization_delay / 2), 1);
+
+    /// test: recorded sends load the links for a window, then expire
+    auto recorded = ContentionEstimator(std::make_shared<Switch>(8, 50, 500), window);
+    const auto chunks_count = 2 * static_cast<int>(link_capacity / static_cast<double>(chunk_size));
+    for (auto i = 0; i < chunks_count; i++) {
+        [[maybe_unused]] const auto delay = recorded.record_send(i % 7, 7, chunk_size, i);
+    }
+    EXPECT_NEAR(recorded.get_route_load(3, 7), 2.0, 0.05);
+    EXPECT_NEAR(recorded.get_route_load(3, 6), 2.0 / 7, 0.05);
+    [[maybe_unused]] const auto delay = recorded.record_send(0, 1, chunk_size, 2 * window);
+    EXPECT_NEAR(recorded.get_route_load(3, 7), 0.0, 1e-6);
+
+    /// test: expander graph routes load the directed edges of a shortest path
+    const auto path = ::testing::TempDir() + "contention_expander.json";
+    {
+        auto file = std::ofstream(path);
+        file << "{\"node_count\": 8, \"degree\": 2, \"connected_graph_adjacency\": "
+             << "[[1, 7], [2, 0], [3, 1], [4, 2], [5, 3], [6, 4], [7, 5], [0, 6]]}";
+    }
+    auto expander = ContentionEstimator(std::make_shared<ExpanderGraph>(8, 2, 50, 500, path), window);
+    expander.set_traffic(0, 3, static_cast<ChunkSize>(2 * link_capacity));
+    EXPECT_NEAR(expander.get_route_load(1, 2), 2.0, 1e-6);
+    EXPECT_NEAR(expander.get_route_load(2, 1), 0.0, 1e-6);
+    std::remove(path.c_str());
+    std::remove((path + ".hops").c_str());
+}